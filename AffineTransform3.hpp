@@ -2,6 +2,16 @@
 
 #include "Matrix.hpp"
 #include "VectorN.hpp"
+#include "Quaternion.hpp"
+#include "ES_bulk.hpp"
+#include "ES_math.hpp"
+#include "ES_simd.hpp"
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include <ranges>
+#include <span>
 
 
 namespace ES{
@@ -70,6 +80,10 @@ namespace ES{
             return inv;
         }
 
+        [[nodiscard]] constexpr const Matrix<T,3>& get_linear() const noexcept{
+            return linear;
+        }
+
         [[nodiscard]] constexpr VectorN<T,3> get_translation() const noexcept{
             return translation;
         }
@@ -105,10 +119,230 @@ namespace ES{
         }
 
 
-    // these three rinky dink functions needs me to implement quaternions first
-        // static constexpr AffineTransform3 from_rotation(const Quaternion<T>& quat) noexcept;
-        // static constexpr AffineTransform3 from_trs(const VectorN<T,3>& t,const Quaternion<T>& r,const VectorN<T,3>& s) noexcept;
-        // constexpr Quaternion<T> get_rotation() const noexcept;
-    // the end
+        [[nodiscard]] static constexpr AffineTransform3 from_rotation(const Quaternion<T>& quat) noexcept{
+            return AffineTransform3(quat.to_matrix3(), VectorN<T,3>{0,0,0});
+        }
+
+        // scale first, then rotate, then translate. Same order TransformTRS applies them in
+        [[nodiscard]] static constexpr AffineTransform3 from_trs(const VectorN<T,3>& t,const Quaternion<T>& r,const VectorN<T,3>& s) noexcept{
+            AffineTransform3 temp_affine(r.to_matrix3(), t);
+            for(std::size_t col = 0; col<3; col++){
+                temp_affine.linear(0,col) *= s[col];
+                temp_affine.linear(1,col) *= s[col];
+                temp_affine.linear(2,col) *= s[col];
+            }
+            return temp_affine;
+        }
+
+        // rotation part of the linear, with scale divided out of the columns. A mirroring (negative determinant)
+        // linear is treated as a negative x scale, which is what get_scale can't tell you about
+        [[nodiscard]] /* constexpr in c++26*/ Quaternion<T> get_rotation() const noexcept{
+            Matrix<T,3> rotation = linear.normalize();
+            if(linear.determinant() < T{0}){
+                rotation(0,0) = -rotation(0,0);
+                rotation(1,0) = -rotation(1,0);
+                rotation(2,0) = -rotation(2,0);
+            }
+            return Quaternion<T>::from_matrix3(rotation).normalize();
+        }
+
+        /**
+         * @brief The transform a fraction t of the way from a to b, without the shrinking and shearing a matrix lerp gives.
+         *
+         * Both linears are polar decomposed into rotation * stretch (Shoemake and Duff), then the rotations slerp while
+         * the stretches and translations lerp. t = 0 and t = 1 give back a and b. For many t between the same pair, as
+         * motion blur sampling wants, use the span overload, which decomposes once.
+         */
+        [[nodiscard]] static /* constexpr in c++26*/ AffineTransform3 interpolate(const AffineTransform3& a, const AffineTransform3& b, T t) noexcept{
+            Quaternion<T> rotation_a, rotation_b;
+            Matrix<T,3> stretch_a, stretch_b;
+            polar_decompose(a.linear, rotation_a, stretch_a);
+            polar_decompose(b.linear, rotation_b, stretch_b);
+            return AffineTransform3(rotation_a.slerp(rotation_b, t).to_matrix3() * stretch_a.lerp(stretch_b, t),
+                                    a.translation.lerp(b.translation, t));
+        }
+
+        /**
+         * @brief interpolate at every t of ts, one polar decomposition per call rather than per sample.
+         *
+         * The slerp weights of a whole block are sincosed at once by the vectorized math::sincos, the rest runs lane
+         * batched.
+         * @param out the same length as ts
+         */
+        static void interpolate(const AffineTransform3& a, const AffineTransform3& b, std::span<const T> ts, std::span<AffineTransform3> out) noexcept;
+
+        /**
+         * @defgroup affine_bulk AffineTransform3 bulk transforms
+         * @brief transform_point and friends over a whole buffer at once.
+         *
+         * Elements can be VectorN<T,3>, PointN<T,3> or VectorH<T> (which brings its own w, so translation follows it),
+         * or the coordinates can come as separate bulk::SoA3 streams. Pass the same buffer as in and out to work in
+         * place. The inverse variants invert once up front, normals are renormalized on the way out.
+         * @{
+         */
+        template <std::ranges::contiguous_range In, std::ranges::contiguous_range Out>
+        void transform_points(const In& in, Out&& out) const noexcept{
+            bulk::transform<bulk::Mode::points, false>(rows_of(linear, translation), std::span(in), std::span(out));
+        }
+        void transform_points(bulk::SoA3<const T> in, bulk::SoA3<T> out) const noexcept{
+            bulk::transform<bulk::Mode::points, false>(rows_of(linear, translation), in, out);
+        }
+
+        template <std::ranges::contiguous_range In, std::ranges::contiguous_range Out>
+        void transform_vectors(const In& in, Out&& out) const noexcept{
+            bulk::transform<bulk::Mode::vectors, false>(rows_of(linear, translation), std::span(in), std::span(out));
+        }
+        void transform_vectors(bulk::SoA3<const T> in, bulk::SoA3<T> out) const noexcept{
+            bulk::transform<bulk::Mode::vectors, false>(rows_of(linear, translation), in, out);
+        }
+
+        // by the inverse transpose of the linear part, so normals stay perpendicular to surfaces under non uniform scale
+        template <std::ranges::contiguous_range In, std::ranges::contiguous_range Out>
+        void transform_normals(const In& in, Out&& out) const noexcept{
+            bulk::transform<bulk::Mode::normals, false>(rows_of(linear.inverse().transpose(), VectorN<T,3>{0,0,0}), std::span(in), std::span(out));
+        }
+        void transform_normals(bulk::SoA3<const T> in, bulk::SoA3<T> out) const noexcept{
+            bulk::transform<bulk::Mode::normals, false>(rows_of(linear.inverse().transpose(), VectorN<T,3>{0,0,0}), in, out);
+        }
+
+        template <std::ranges::contiguous_range In, std::ranges::contiguous_range Out>
+        void transform_points_inverse(const In& in, Out&& out) const noexcept{
+            const AffineTransform3 inv = inverse();
+            bulk::transform<bulk::Mode::points, false>(rows_of(inv.linear, inv.translation), std::span(in), std::span(out));
+        }
+        void transform_points_inverse(bulk::SoA3<const T> in, bulk::SoA3<T> out) const noexcept{
+            const AffineTransform3 inv = inverse();
+            bulk::transform<bulk::Mode::points, false>(rows_of(inv.linear, inv.translation), in, out);
+        }
+
+        template <std::ranges::contiguous_range In, std::ranges::contiguous_range Out>
+        void transform_vectors_inverse(const In& in, Out&& out) const noexcept{
+            bulk::transform<bulk::Mode::vectors, false>(rows_of(linear.inverse(), VectorN<T,3>{0,0,0}), std::span(in), std::span(out));
+        }
+        void transform_vectors_inverse(bulk::SoA3<const T> in, bulk::SoA3<T> out) const noexcept{
+            bulk::transform<bulk::Mode::vectors, false>(rows_of(linear.inverse(), VectorN<T,3>{0,0,0}), in, out);
+        }
+
+        // the inverse's normal matrix is just the transpose of the linear part, no inverse needed at all
+        template <std::ranges::contiguous_range In, std::ranges::contiguous_range Out>
+        void transform_normals_inverse(const In& in, Out&& out) const noexcept{
+            bulk::transform<bulk::Mode::normals, false>(rows_of(linear.transpose(), VectorN<T,3>{0,0,0}), std::span(in), std::span(out));
+        }
+        void transform_normals_inverse(bulk::SoA3<const T> in, bulk::SoA3<T> out) const noexcept{
+            bulk::transform<bulk::Mode::normals, false>(rows_of(linear.transpose(), VectorN<T,3>{0,0,0}), in, out);
+        }
+        /** @} */
+
+    private:
+        static constexpr std::size_t polar_iterations = 32;
+
+        //m = rotation * stretch with rotation proper and stretch symmetric. A mirroring m gets its reflection folded
+        //into stretch (negated) so the rotation stays something a quaternion can hold
+        static /* constexpr in c++26*/ void polar_decompose(const Matrix<T,3>& m, Quaternion<T>& rotation, Matrix<T,3>& stretch) noexcept{
+            assert(m.determinant() != T{0} && "polar decomposition of a singular linear");
+            Matrix<T,3> q = m.determinant() < T{0} ? -m : m;
+            //Higham's iteration q <- (q + q^-T) / 2, quadratic once it gets close
+            for(std::size_t i = 0; i<polar_iterations; i++){
+                const Matrix<T,3> next = (q + q.inverse().transpose()) * T{0.5};
+                const bool converged = (next - q).norm1() <= T{8} * std::numeric_limits<T>::epsilon();
+                q = next;
+                if(converged){
+                    break;
+                }
+            }
+            rotation = Quaternion<T>::from_matrix3(q).normalize();
+            stretch = q.transpose() * m;
+        }
+
+        [[nodiscard]] static constexpr bulk::Rows<T> rows_of(const Matrix<T,3>& l, const VectorN<T,3>& t) noexcept{
+            return {l(0,0), l(0,1), l(0,2), t[0],
+                    l(1,0), l(1,1), l(1,2), t[1],
+                    l(2,0), l(2,1), l(2,2), t[2],
+                    T{0},   T{0},   T{0},   T{1}};
+        }
     };
-}
\ No newline at end of file
+
+    template <typename T>
+    void AffineTransform3<T>::interpolate(const AffineTransform3& a, const AffineTransform3& b, std::span<const T> ts, std::span<AffineTransform3> out) noexcept{
+        assert(ts.size() == out.size() && "interpolate needs one output per t");
+        Quaternion<T> rotation_a, rotation_b;
+        Matrix<T,3> stretch_a, stretch_b;
+        polar_decompose(a.linear, rotation_a, stretch_a);
+        polar_decompose(b.linear, rotation_b, stretch_b);
+
+        //slerp exactly as Quaternion::slerp does it, lerp weights (then renormalized) for nearly parallel rotations
+        T cosine = rotation_a.dot(rotation_b);
+        if(cosine < T{0}){
+            rotation_b = -rotation_b;
+            cosine = -cosine;
+        }
+        const bool nearly_parallel = std::clamp(cosine, T{-1}, T{1}) > T{0.9995};
+        const T angle = nearly_parallel ? T{0} : std::acos(std::clamp(cosine, T{-1}, T{1}));
+        const T inverse_sin = nearly_parallel ? T{1} : T{1} / std::sin(angle);
+
+        const std::array<T,4> qa{rotation_a.w(), rotation_a.x(), rotation_a.y(), rotation_a.z()};
+        const std::array<T,4> qb{rotation_b.w(), rotation_b.x(), rotation_b.y(), rotation_b.z()};
+        std::array<T,9> sa, ds; //column major like Matrix
+        for(std::size_t i = 0; i<9; i++){
+            sa[i] = stretch_a[i];
+            ds[i] = stretch_b[i] - stretch_a[i];
+        }
+        const VectorN<T,3> ta = a.translation;
+        const VectorN<T,3> dt = b.translation - a.translation;
+
+        //wide enough blocks that the vectorized loop inside sincos gets a run worth starting
+        constexpr std::size_t W = 16 * simd::lanes<T>;
+        alignas(simd::register_bytes) std::array<T,W> t;
+        //sines stays zeroed when nearly parallel skips the sincos, the selects below still read it
+        alignas(simd::register_bytes) std::array<T,2*W> angles, sines{}, cosines{};
+        alignas(simd::register_bytes) std::array<std::array<T,W>,12> result; //the linear column major, then translation
+        for(std::size_t base = 0; base<ts.size(); base += W){
+            const std::size_t n = std::min(W, ts.size() - base);
+            for(std::size_t lane = 0; lane<W; lane++){
+                t[lane] = lane < n ? ts[base + lane] : T{0};
+                angles[lane] = (T{1} - t[lane]) * angle;
+                angles[W + lane] = t[lane] * angle;
+            }
+            if(!nearly_parallel){
+                math::sincos<T>(angles, sines, cosines);
+            }
+
+            ES_VECTORIZE
+            for(std::size_t lane = 0; lane<W; lane++){
+                const T tt = t[lane];
+                const T wa = simd::select(nearly_parallel, T{1} - tt, sines[lane] * inverse_sin);
+                const T wb = simd::select(nearly_parallel, tt, sines[W + lane] * inverse_sin);
+                T w = wa*qa[0] + wb*qb[0], x = wa*qa[1] + wb*qb[1], y = wa*qa[2] + wb*qb[2], z = wa*qa[3] + wb*qb[3];
+                //the weights never cancel (the two are in one hemisphere), so the length is safely away from 0
+                const T inverse_length = simd::inverse_sqrt(w*w + x*x + y*y + z*z);
+                w *= inverse_length; x *= inverse_length; y *= inverse_length; z *= inverse_length;
+
+                //as in Quaternion::to_matrix3, column major
+                const T xx = x*x, yy = y*y, zz = z*z, xy = x*y, xz = x*z, yz = y*z, wx = w*x, wy = w*y, wz = w*z;
+                const T r[9] = {T{1} - T{2}*(yy + zz), T{2}*(xy + wz), T{2}*(xz - wy),
+                                T{2}*(xy - wz), T{1} - T{2}*(xx + zz), T{2}*(yz + wx),
+                                T{2}*(xz + wy), T{2}*(yz - wx), T{1} - T{2}*(xx + yy)};
+                T s[9];
+                for(std::size_t i = 0; i<9; i++){
+                    s[i] = sa[i] + tt * ds[i];
+                }
+                for(std::size_t col = 0; col<3; col++){
+                    for(std::size_t row = 0; row<3; row++){
+                        result[3*col + row][lane] = r[row]*s[3*col] + r[3 + row]*s[3*col + 1] + r[6 + row]*s[3*col + 2];
+                    }
+                }
+                result[9][lane] = ta[0] + tt * dt[0];
+                result[10][lane] = ta[1] + tt * dt[1];
+                result[11][lane] = ta[2] + tt * dt[2];
+            }
+
+            for(std::size_t lane = 0; lane<n; lane++){
+                AffineTransform3& o = out[base + lane];
+                for(std::size_t i = 0; i<9; i++){
+                    o.linear[i] = result[i][lane];
+                }
+                o.translation = VectorN<T,3>(result[9][lane], result[10][lane], result[11][lane]);
+            }
+        }
+    }
+}
@@ -1,10 +1,16 @@
 #ifndef COMPUTERGRAPHICS_ES_ANGLE_HPP
 #define COMPUTERGRAPHICS_ES_ANGLE_HPP
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <limits>
 #include <type_traits>
 #include <numbers>
+#include <span>
 #include <utility>
 
 #include "ES_math.hpp"
+#include "ES_simd.hpp"
 
 namespace ES {
     namespace Secret {
@@ -12,6 +18,9 @@ namespace ES {
         class degree{};
 
         template <typename T> [[nodiscard]] constexpr T normalize_angle_coeff(T, T) noexcept;
+        //x wrapped into [lower, lower + range), branch free, same value as std::fmod while |x - lower| / range stays
+        //below 2^24 (float) or 2^53 (double)
+        template <typename T> [[nodiscard]] constexpr T wrap_angle_coeff(T x, T lower, T range) noexcept;
     }
 
     template<typename Unit> concept radian_or_degree = std::same_as<Unit,Secret::degree> || std::same_as<Unit,Secret::radian>;
@@ -25,6 +34,36 @@ namespace ES {
 
     using AngleDeg = Angle<in_degrees>;
     using AngleRad = Angle<in_radians>;
+
+    namespace Secret {
+        //one whole turn, in Unit
+        template <radian_or_degree Unit, typename T>
+        inline constexpr T full_turn = std::is_same_v<Unit, in_radians> ? T(2) * std::numbers::pi_v<T> : T(360);
+
+        //what to multiply a From value by to get it in To
+        template <radian_or_degree From, radian_or_degree To, typename T>
+        inline constexpr T unit_factor = std::is_same_v<From, To> ? T(1) : full_turn<To, T> / full_turn<From, T>;
+    }
+
+    /**
+     * @brief Angle::normalize_in_place over a whole span, vectorized: every angle into [0, one turn).
+     */
+    template <radian_or_degree Unit, typename V>
+    void normalize_angles(std::span<Angle<Unit, V>> angles) noexcept;
+
+    /**
+     * @brief Angle::wrap_to_in_place over a whole span, vectorized: every angle into [lower, upper).
+     */
+    template <radian_or_degree Unit, typename V>
+    void wrap_angles(std::span<Angle<Unit, V>> angles, V lower, V upper) noexcept;
+
+    /**
+     * @brief Converts every angle to OutUnit and wraps it into [lower, upper) in the same pass.
+     * @param lower,upper in OutUnit
+     * @param out the same length as in
+     */
+    template <radian_or_degree OutUnit, radian_or_degree Unit, typename V>
+    void wrap_angles(std::span<const Angle<Unit, V>> in, std::span<Angle<OutUnit, V>> out, V lower, V upper) noexcept;
 }
 
 namespace ES::math {
@@ -50,7 +89,7 @@ template <std::floating_point T> [[nodiscard]] constexpr T ES::math::c_normalize
 }
 
 template <std::floating_point T> [[nodiscard]] constexpr T ES::math::c_normalize_angle_rad(T x) noexcept {
-    return Secret::normalize_angle_coeff(x, T{std::numbers::pi_v<T> * 2});
+    return ES::Secret::normalize_angle_coeff(x, T{std::numbers::pi_v<T> * 2});
 }
 
 template <ES::radian_or_degree Unit, typename V>
@@ -83,10 +122,7 @@ public:
     }
 
     constexpr Angle<Unit,V>& wrap_to_in_place(V lower, V upper) noexcept {
-        V range = upper - lower;
-        angle_ = std::fmod(angle_ - lower, range);
-        if (angle_ < V(0)) angle_ += range;
-        angle_ += lower;
+        angle_ = ES::Secret::wrap_angle_coeff(angle_, lower, upper - lower);
         return *this;
     }
 
@@ -136,44 +172,104 @@ public:
 
 namespace ES::math::angle_literals {
     constexpr Angle<in_radians, long double> operator""_radl(long double z) {
-        return Angle<Secret::radian, long double>{z};
+        return Angle<ES::Secret::radian, long double>{z};
     }
 
     constexpr Angle<in_degrees, long double> operator""_degl(long double z) {
-        return Angle<Secret::degree, long double>{z};
+        return Angle<ES::Secret::degree, long double>{z};
     }
 
     constexpr Angle<in_radians, long double> operator""_radl(unsigned long long z) {
-        return Angle<Secret::radian, long double>{static_cast<long double>(z)};
+        return Angle<ES::Secret::radian, long double>{static_cast<long double>(z)};
     }
 
     constexpr Angle<in_degrees, long double> operator""_degl(unsigned long long z) {
-        return Angle<Secret::degree, long double>{static_cast<long double>(z)};
+        return Angle<ES::Secret::degree, long double>{static_cast<long double>(z)};
     }
 
     constexpr Angle<in_radians> operator""_radf(long double z) {
-        return Angle<Secret::radian>{static_cast<float>(z)};
+        return Angle<ES::Secret::radian>{static_cast<float>(z)};
     }
 
     constexpr Angle<in_degrees> operator""_deg(long double z) {
-        return Angle<Secret::degree>{static_cast<float>(z)};
+        return Angle<ES::Secret::degree>{static_cast<float>(z)};
     }
 
     constexpr Angle<in_radians> operator""_rad(unsigned long long z) {
-        return Angle<Secret::radian>{static_cast<float>(z)};
+        return Angle<ES::Secret::radian>{static_cast<float>(z)};
     }
 
     constexpr Angle<in_degrees> operator""_deg(unsigned long long z) {
-        return Angle<Secret::degree>{static_cast<float>(z)};
+        return Angle<ES::Secret::degree>{static_cast<float>(z)};
     }
 }
 
 template <typename T> [[nodiscard]] constexpr T ES::Secret::normalize_angle_coeff(T x, const T COTERM) noexcept {
-    x = math::modulo(x, COTERM);
-    if (x < T(0)) {
-        x += COTERM;
+    //math::modulo's rounded product rather than wrap_angle_coeff's exact one: 2^24 turns and up are a whole number
+    //of turns as far as a float can tell, so 360e10 degrees normalizes to 0 where fmod would say 80
+    const T wrapped = math::modulo(x, COTERM);
+    const T below_turn = wrapped - simd::select(wrapped >= COTERM, COTERM, T(0));
+    const T in_turn = below_turn + simd::select(below_turn < T(0), COTERM, T(0));
+    return simd::select(in_turn >= COTERM, T(0), in_turn);
+}
+
+template <typename T> [[nodiscard]] constexpr T ES::Secret::wrap_angle_coeff(const T x, const T lower, const T range) noexcept {
+    const T shifted = x - lower;
+    if constexpr (math::float_or_double<T>) {
+        const T turns = math::floor(shifted / range);
+        //shifted - range * turns has to come out exact, like fmod's, or 1e7 radians wraps to the wrong angle: rounding
+        //range * turns first throws away the low half of the product, which is the whole answer once x is large
+#if defined(__FMA__) || defined(__ARM_FEATURE_FMA)
+        const T wrapped = std::fma(-range, turns, shifted);
+#else
+        //no fused multiply add, so Dekker's product: halves of the mantissa multiply exactly, product + error is exact
+        constexpr T splitter = T((1ull << ((std::numeric_limits<T>::digits + 1) / 2)) + 1);
+        const T range_split = splitter * range, turns_split = splitter * turns;
+        const T range_high = range_split - (range_split - range), range_low = range - range_high;
+        const T turns_high = turns_split - (turns_split - turns), turns_low = turns - turns_high;
+        const T product = range * turns;
+        const T error = ((range_high * turns_high - product) + range_high * turns_low + range_low * turns_high) + range_low * turns_low;
+        const T wrapped = (shifted - product) - error;
+#endif
+        //the division rounds, so a hair either side of a whole turn can land on range or just under 0
+        const T below_range = wrapped - simd::select(wrapped >= range, range, T(0));
+        const T in_range = below_range + simd::select(below_range < T(0), range, T(0));
+        //and a tiny negative plus range rounds to range itself, which is the next turn's 0
+        return simd::select(in_range >= range, T(0), in_range) + lower;
+    } else {
+        T wrapped = std::fmod(shifted, range);
+        wrapped = wrapped < T(0) ? wrapped + range : wrapped;
+        wrapped = wrapped >= range ? T(0) : wrapped;
+        return wrapped + lower;
+    }
+}
+
+template <ES::radian_or_degree Unit, typename V>
+void ES::normalize_angles(const std::span<Angle<Unit, V>> angles) noexcept {
+    ES_VECTORIZE
+    for (std::size_t i = 0; i < angles.size(); i++) {
+        angles[i].get() = Secret::normalize_angle_coeff(angles[i].get(), Secret::full_turn<Unit, V>);
+    }
+}
+
+template <ES::radian_or_degree Unit, typename V>
+void ES::wrap_angles(const std::span<Angle<Unit, V>> angles, const V lower, const V upper) noexcept {
+    const V range = upper - lower;
+    ES_VECTORIZE
+    for (std::size_t i = 0; i < angles.size(); i++) {
+        angles[i].get() = Secret::wrap_angle_coeff(angles[i].get(), lower, range);
+    }
+}
+
+template <ES::radian_or_degree OutUnit, ES::radian_or_degree Unit, typename V>
+void ES::wrap_angles(const std::span<const Angle<Unit, V>> in, const std::span<Angle<OutUnit, V>> out, const V lower, const V upper) noexcept {
+    assert(in.size() == out.size() && "wrap_angles needs one output per angle");
+    const V range = upper - lower;
+    constexpr V factor = Secret::unit_factor<Unit, OutUnit, V>;
+    ES_VECTORIZE
+    for (std::size_t i = 0; i < in.size(); i++) {
+        out[i].get() = Secret::wrap_angle_coeff(in[i].get() * factor, lower, range);
     }
-    return x;
 }
 
 #endif //COMPUTERGRAPHICS_ES_ANGLE_HPP
@@ -8,6 +8,7 @@
 #include "ContainerN.hpp"
 #include <cstdint>
 #include "ArithmeticOpsMixin.hpp"
+#include "ES_srgb.hpp"
 
 
 namespace ES{
@@ -155,36 +156,39 @@ namespace ES{
         }
 
         static constexpr RGB from_srgb(float r, float g, float b) noexcept {
-            float R = (r <= 0.04045f) ? r/12.92f : std::pow((r+0.055f)/1.055f, 2.4f);
-            float G = (g <= 0.04045f) ? g/12.92f : std::pow((g+0.055f)/1.055f, 2.4f);
-            float B = (b <= 0.04045f) ? b/12.92f : std::pow((b+0.055f)/1.055f, 2.4f);
+            float R = srgb::decode(r);
+            float G = srgb::decode(g);
+            float B = srgb::decode(b);
 
             return RGB(R, G, B);
         } 
 
         static constexpr RGB from_srgb(int r, int g, int b) noexcept {
-            return RGB::from_srgb(r/255.0f,g/255.0f,b/255.0f);
+            assert(r >= 0 && r <= 255);
+            assert(g >= 0 && g <= 255);
+            assert(b >= 0 && b <= 255);
+            return RGB(srgb::to_linear(static_cast<uint8_t>(r)), srgb::to_linear(static_cast<uint8_t>(g)), srgb::to_linear(static_cast<uint8_t>(b)));
         }
 
         static constexpr RGB from_hexRGB(const uint32_t hex) noexcept{
-            float sR = ((hex >> 16) & 0xFF) / 255.0f;
-            float sG = ((hex >> 8)  & 0xFF) / 255.0f;
-            float sB = (hex & 0xFF) / 255.0f;
+            const uint8_t sR = static_cast<uint8_t>((hex >> 16) & 0xFF);
+            const uint8_t sG = static_cast<uint8_t>((hex >> 8)  & 0xFF);
+            const uint8_t sB = static_cast<uint8_t>(hex & 0xFF);
 
-            float R = (sR <= 0.04045f) ? sR/12.92f : std::pow((sR+0.055f)/1.055f, 2.4f);
-            float G = (sG <= 0.04045f) ? sG/12.92f : std::pow((sG+0.055f)/1.055f, 2.4f);
-            float B = (sB <= 0.04045f) ? sB/12.92f : std::pow((sB+0.055f)/1.055f, 2.4f);
+            float R = srgb::to_linear(sR);
+            float G = srgb::to_linear(sG);
+            float B = srgb::to_linear(sB);
             return RGB(R,G,B);
         }  
 
         static constexpr RGB from_hexBGR(const uint32_t hex) noexcept{
-            float sB = ((hex >> 16) & 0xFF) / 255.0f;
-            float sG = ((hex >> 8)  & 0xFF) / 255.0f;
-            float sR = (hex & 0xFF) / 255.0f;
+            const uint8_t sB = static_cast<uint8_t>((hex >> 16) & 0xFF);
+            const uint8_t sG = static_cast<uint8_t>((hex >> 8)  & 0xFF);
+            const uint8_t sR = static_cast<uint8_t>(hex & 0xFF);
 
-            float R = (sR <= 0.04045f) ? sR/12.92f : std::pow((sR+0.055f)/1.055f, 2.4f);
-            float G = (sG <= 0.04045f) ? sG/12.92f : std::pow((sG+0.055f)/1.055f, 2.4f);
-            float B = (sB <= 0.04045f) ? sB/12.92f : std::pow((sB+0.055f)/1.055f, 2.4f);
+            float R = srgb::to_linear(sR);
+            float G = srgb::to_linear(sG);
+            float B = srgb::to_linear(sB);
             return RGB(R,G,B);
         }
 
@@ -204,14 +208,14 @@ namespace ES{
 
 
         [[nodiscard]] constexpr float luminance() const noexcept{
-            return (0.2126*R())+(0.7152*G())+(0.0722*B());
+            return (0.2126f*R())+(0.7152f*G())+(0.0722f*B());
         }
 
         [[nodiscard]] constexpr std::array<float,3> to_srgb() const noexcept{
             std::array<float, 3> SRGB;
-            SRGB[0] = (R()<=0.0031308f) ? 12.92f*R() : 1.055f * std::pow(R(), 1.0f / 2.4f) - 0.055f;
-            SRGB[1] = (G()<=0.0031308f) ? 12.92f*G() : 1.055f * std::pow(G(), 1.0f / 2.4f) - 0.055f;
-            SRGB[2] = (B()<=0.0031308f) ? 12.92f*B() : 1.055f * std::pow(B(), 1.0f / 2.4f) - 0.055f;
+            SRGB[0] = srgb::encode(R());
+            SRGB[1] = srgb::encode(G());
+            SRGB[2] = srgb::encode(B());
             return SRGB;
         }
 
@@ -254,40 +258,44 @@ namespace ES{
         }
 
         static constexpr RGB_Int from_srgb(float r, float g, float b) noexcept {
-            float R = (r <= 0.04045f) ? r/12.92f : std::pow((r+0.055f)/1.055f, 2.4f);
-            float G = (g <= 0.04045f) ? g/12.92f : std::pow((g+0.055f)/1.055f, 2.4f);
-            float B = (b <= 0.04045f) ? b/12.92f : std::pow((b+0.055f)/1.055f, 2.4f);
+            float R = srgb::decode(r);
+            float G = srgb::decode(g);
+            float B = srgb::decode(b);
 
+            //decode's [0, 1] makes + 0.5 and truncating a round, and keeps this constexpr
             return RGB_Int(
-                static_cast<int16_t>(std::round(R*255)),
-                static_cast<int16_t>(std::round(G*255)),
-                static_cast<int16_t>(std::round(B*255))
+                static_cast<int16_t>(R*255 + 0.5f),
+                static_cast<int16_t>(G*255 + 0.5f),
+                static_cast<int16_t>(B*255 + 0.5f)
             );
         } 
 
         static constexpr RGB_Int from_srgb(int r, int g, int b) noexcept {
-            return RGB_Int::from_srgb(r/255.0f,g/255.0f,b/255.0f);
+            assert(r >= 0 && r <= 255);
+            assert(g >= 0 && g <= 255);
+            assert(b >= 0 && b <= 255);
+            return RGB_Int::from_linear(srgb::to_linear(static_cast<uint8_t>(r)), srgb::to_linear(static_cast<uint8_t>(g)), srgb::to_linear(static_cast<uint8_t>(b)));
         }
 
         static constexpr RGB_Int from_hexRGB(const uint32_t hex) noexcept{
-            float sR = ((hex >> 16) & 0xFF) / 255.0f;
-            float sG = ((hex >> 8)  & 0xFF) / 255.0f;
-            float sB = (hex & 0xFF) / 255.0f;
+            const uint8_t sR = static_cast<uint8_t>((hex >> 16) & 0xFF);
+            const uint8_t sG = static_cast<uint8_t>((hex >> 8)  & 0xFF);
+            const uint8_t sB = static_cast<uint8_t>(hex & 0xFF);
 
-            float R = (sR <= 0.04045f) ? sR/12.92f : std::pow((sR+0.055f)/1.055f, 2.4f);
-            float G = (sG <= 0.04045f) ? sG/12.92f : std::pow((sG+0.055f)/1.055f, 2.4f);
-            float B = (sB <= 0.04045f) ? sB/12.92f : std::pow((sB+0.055f)/1.055f, 2.4f);
+            float R = srgb::to_linear(sR);
+            float G = srgb::to_linear(sG);
+            float B = srgb::to_linear(sB);
             return RGB_Int::from_linear(R,G,B);
         }  
 
         static constexpr RGB_Int from_hexBGR(const uint32_t hex) noexcept{
-            float sB = ((hex >> 16) & 0xFF) / 255.0f;
-            float sG = ((hex >> 8)  & 0xFF) / 255.0f;
-            float sR = (hex & 0xFF) / 255.0f;
+            const uint8_t sB = static_cast<uint8_t>((hex >> 16) & 0xFF);
+            const uint8_t sG = static_cast<uint8_t>((hex >> 8)  & 0xFF);
+            const uint8_t sR = static_cast<uint8_t>(hex & 0xFF);
 
-            float R = (sR <= 0.04045f) ? sR/12.92f : std::pow((sR+0.055f)/1.055f, 2.4f);
-            float G = (sG <= 0.04045f) ? sG/12.92f : std::pow((sG+0.055f)/1.055f, 2.4f);
-            float B = (sB <= 0.04045f) ? sB/12.92f : std::pow((sB+0.055f)/1.055f, 2.4f);
+            float R = srgb::to_linear(sR);
+            float G = srgb::to_linear(sG);
+            float B = srgb::to_linear(sB);
             return RGB_Int::from_linear(R,G,B);
         }
 
@@ -320,9 +328,9 @@ namespace ES{
             float g = G()/255.0f;
             float b = B()/255.0f;
 
-            SRGB[0] = (r<=0.0031308f) ? 12.92f*r : 1.055f * std::pow(r, 1.0f / 2.4f) - 0.055f;
-            SRGB[1] = (g<=0.0031308f) ? 12.92f*g : 1.055f * std::pow(g, 1.0f / 2.4f) - 0.055f;
-            SRGB[2] = (b<=0.0031308f) ? 12.92f*b : 1.055f * std::pow(b, 1.0f / 2.4f) - 0.055f;
+            SRGB[0] = srgb::encode(r);
+            SRGB[1] = srgb::encode(g);
+            SRGB[2] = srgb::encode(b);
             return SRGB;
         }
     };
@@ -368,27 +376,32 @@ namespace ES{
         }
 
         static constexpr RGBA from_srgba(float r, float g, float b, float a) noexcept {
-            float R = (r <= 0.04045f) ? r/12.92f : std::pow((r+0.055f)/1.055f, 2.4f);
-            float G = (g <= 0.04045f) ? g/12.92f : std::pow((g+0.055f)/1.055f, 2.4f);
-            float B = (b <= 0.04045f) ? b/12.92f : std::pow((b+0.055f)/1.055f, 2.4f);
+            float R = srgb::decode(r);
+            float G = srgb::decode(g);
+            float B = srgb::decode(b);
 
             return RGBA(R*a,G*a,B*a,a);
         } 
 
         static constexpr RGBA from_srgba(int r, int g, int b,int a) noexcept {
-            return RGBA::from_srgba(r/255.0f,g/255.0f,b/255.0f, a/255.0f);
+            assert(r >= 0 && r <= 255);
+            assert(g >= 0 && g <= 255);
+            assert(b >= 0 && b <= 255);
+            assert(a >= 0 && a <= 255);
+            const float A = a/255.0f;
+            return RGBA(srgb::to_linear(static_cast<uint8_t>(r))*A, srgb::to_linear(static_cast<uint8_t>(g))*A, srgb::to_linear(static_cast<uint8_t>(b))*A, A);
         }
 
         static constexpr RGBA from_hexRGBA(const uint32_t hex) noexcept{
 
-            float sR = ((hex >> 24) & 0xFF) / 255.0f;
-            float sG = ((hex >> 16)  & 0xFF) / 255.0f;
-            float sB = ((hex >> 8) & 0xFF) / 255.0f;
+            const uint8_t sR = static_cast<uint8_t>((hex >> 24) & 0xFF);
+            const uint8_t sG = static_cast<uint8_t>((hex >> 16)  & 0xFF);
+            const uint8_t sB = static_cast<uint8_t>((hex >> 8) & 0xFF);
             float A = (hex & 0xFF) / 255.0f;
 
-            float R = (sR <= 0.04045f) ? sR/12.92f : std::pow((sR+0.055f)/1.055f, 2.4f);
-            float G = (sG <= 0.04045f) ? sG/12.92f : std::pow((sG+0.055f)/1.055f, 2.4f);
-            float B = (sB <= 0.04045f) ? sB/12.92f : std::pow((sB+0.055f)/1.055f, 2.4f);
+            float R = srgb::to_linear(sR);
+            float G = srgb::to_linear(sG);
+            float B = srgb::to_linear(sB);
 
             return RGBA(R*A,G*A,B*A,A);
         }
@@ -397,14 +410,14 @@ namespace ES{
 
         static constexpr RGBA from_hexBGRA(const uint32_t hex) noexcept{
 
-            float sB = ((hex >> 24) & 0xFF) / 255.0f;
-            float sG = ((hex >> 16)  & 0xFF) / 255.0f;
-            float sR = ((hex >> 8) & 0xFF) / 255.0f;
+            const uint8_t sB = static_cast<uint8_t>((hex >> 24) & 0xFF);
+            const uint8_t sG = static_cast<uint8_t>((hex >> 16)  & 0xFF);
+            const uint8_t sR = static_cast<uint8_t>((hex >> 8) & 0xFF);
             float A = (hex & 0xFF) / 255.0f;
 
-            float R = (sR <= 0.04045f) ? sR/12.92f : std::pow((sR+0.055f)/1.055f, 2.4f);
-            float G = (sG <= 0.04045f) ? sG/12.92f : std::pow((sG+0.055f)/1.055f, 2.4f);
-            float B = (sB <= 0.04045f) ? sB/12.92f : std::pow((sB+0.055f)/1.055f, 2.4f);
+            float R = srgb::to_linear(sR);
+            float G = srgb::to_linear(sG);
+            float B = srgb::to_linear(sB);
 
             return RGBA(R*A,G*A,B*A,A);
         }
@@ -455,9 +468,9 @@ namespace ES{
             float g =G()/A();
             float b = B()/A();
 
-            SRGBA[0] = (r<=0.0031308f) ? 12.92f*r : 1.055f * std::pow(r, 1.0f / 2.4f) - 0.055f;
-            SRGBA[1] = (g<=0.0031308f) ? 12.92f*g : 1.055f * std::pow(g, 1.0f / 2.4f) - 0.055f;
-            SRGBA[2] = (b<=0.0031308f) ? 12.92f*b : 1.055f * std::pow(b, 1.0f / 2.4f) - 0.055f;
+            SRGBA[0] = srgb::encode(r);
+            SRGBA[1] = srgb::encode(g);
+            SRGBA[2] = srgb::encode(b);
             SRGBA[3] = A();
             return SRGBA;
         }
@@ -515,33 +528,43 @@ namespace ES{
 
 
         static constexpr RGBA_Int from_srgba(float r, float g, float b, float a) noexcept {
-            float R = (r <= 0.04045f) ? r/12.92f : std::pow((r+0.055f)/1.055f, 2.4f);
-            float G = (g <= 0.04045f) ? g/12.92f : std::pow((g+0.055f)/1.055f, 2.4f);
-            float B = (b <= 0.04045f) ? b/12.92f : std::pow((b+0.055f)/1.055f, 2.4f);
+            float R = srgb::decode(r);
+            float G = srgb::decode(g);
+            float B = srgb::decode(b);
 
+            //decode's [0, 1] makes + 0.5 and truncating a round, and keeps this constexpr
             return RGBA_Int(
-                static_cast<int16_t>(std::round(R*255)),
-                static_cast<int16_t>(std::round(G*255)),
-                static_cast<int16_t>(std::round(B*255)),
-                static_cast<int16_t>(std::round(a*255))
+                static_cast<int16_t>(R*255 + 0.5f),
+                static_cast<int16_t>(G*255 + 0.5f),
+                static_cast<int16_t>(B*255 + 0.5f),
+                static_cast<int16_t>(std::clamp(a, 0.0f, 1.0f)*255 + 0.5f)
             );
         } 
 
         static constexpr RGBA_Int from_srgba(int r, int g, int b,int a) noexcept {
-            return RGBA_Int::from_srgba(r/255.0f,g/255.0f,b/255.0f, a/255.0f);
+            assert(r >= 0 && r <= 255);
+            assert(g >= 0 && g <= 255);
+            assert(b >= 0 && b <= 255);
+            assert(a >= 0 && a <= 255);
+            return RGBA_Int(
+                static_cast<int16_t>(srgb::to_linear(static_cast<uint8_t>(r))*255 + 0.5f),
+                static_cast<int16_t>(srgb::to_linear(static_cast<uint8_t>(g))*255 + 0.5f),
+                static_cast<int16_t>(srgb::to_linear(static_cast<uint8_t>(b))*255 + 0.5f),
+                static_cast<int16_t>(a)
+            );
         }
 
 
         static constexpr RGBA_Int from_hexRGBA(const uint32_t hex) noexcept{
 
-            float sR = ((hex >> 24) & 0xFF) / 255.0f;
-            float sG = ((hex >> 16)  & 0xFF) / 255.0f;
-            float sB = ((hex >> 8) & 0xFF) / 255.0f;
+            const uint8_t sR = static_cast<uint8_t>((hex >> 24) & 0xFF);
+            const uint8_t sG = static_cast<uint8_t>((hex >> 16)  & 0xFF);
+            const uint8_t sB = static_cast<uint8_t>((hex >> 8) & 0xFF);
             float A = (hex & 0xFF) / 255.0f;
 
-            float R = (sR <= 0.04045f) ? sR/12.92f : std::pow((sR+0.055f)/1.055f, 2.4f);
-            float G = (sG <= 0.04045f) ? sG/12.92f : std::pow((sG+0.055f)/1.055f, 2.4f);
-            float B = (sB <= 0.04045f) ? sB/12.92f : std::pow((sB+0.055f)/1.055f, 2.4f);
+            float R = srgb::to_linear(sR);
+            float G = srgb::to_linear(sG);
+            float B = srgb::to_linear(sB);
 
             return RGBA_Int(
                 static_cast<int16_t>(std::round(R*255)),
@@ -553,14 +576,14 @@ namespace ES{
 
         static constexpr RGBA_Int from_hexBGRA(const uint32_t hex) noexcept{
 
-            float sB = ((hex >> 24) & 0xFF) / 255.0f;
-            float sG = ((hex >> 16)  & 0xFF) / 255.0f;
-            float sR = ((hex >> 8) & 0xFF) / 255.0f;
+            const uint8_t sB = static_cast<uint8_t>((hex >> 24) & 0xFF);
+            const uint8_t sG = static_cast<uint8_t>((hex >> 16)  & 0xFF);
+            const uint8_t sR = static_cast<uint8_t>((hex >> 8) & 0xFF);
             float A = (hex & 0xFF) / 255.0f;
 
-            float R = (sR <= 0.04045f) ? sR/12.92f : std::pow((sR+0.055f)/1.055f, 2.4f);
-            float G = (sG <= 0.04045f) ? sG/12.92f : std::pow((sG+0.055f)/1.055f, 2.4f);
-            float B = (sB <= 0.04045f) ? sB/12.92f : std::pow((sB+0.055f)/1.055f, 2.4f);
+            float R = srgb::to_linear(sR);
+            float G = srgb::to_linear(sG);
+            float B = srgb::to_linear(sB);
 
             return RGBA_Int(
                 static_cast<int16_t>(std::round(R*255)),
@@ -608,9 +631,9 @@ namespace ES{
             float sB = B()/255.0f;
             float sA = A()/255.0f;
 
-            SRGBA[0] = (sR<=0.0031308f) ? 12.92f*sR: 1.055f * std::pow(sR, 1.0f / 2.4f) - 0.055f;
-            SRGBA[1] = (sG<=0.0031308f) ? 12.92f*sG : 1.055f * std::pow(sG, 1.0f / 2.4f) - 0.055f;
-            SRGBA[2] = (sB<=0.0031308f) ? 12.92f*sB : 1.055f * std::pow(sB, 1.0f / 2.4f) - 0.055f;
+            SRGBA[0] = srgb::encode(sR);
+            SRGBA[1] = srgb::encode(sG);
+            SRGBA[2] = srgb::encode(sB);
             SRGBA[3] = sA;
             return SRGBA;
         }
@@ -692,13 +715,15 @@ namespace ES{
 
     struct RGB8 {
         uint8_t R, G, B;
+
+        constexpr RGB8() noexcept = default;
+        // raw sRGB encoded bytes, as they sit in a file or a texture
+        constexpr RGB8(uint8_t r, uint8_t g, uint8_t b) noexcept : R(r), G(g), B(b) {}
+
         constexpr RGB8(RGB rgb){
-            float sR = (rgb.R()<=0.0031308f) ? 12.92f*rgb.R(): 1.055f * std::pow(rgb.R(), 1.0f / 2.4f) - 0.055f;
-            float sG = (rgb.G()<=0.0031308f) ? 12.92f*rgb.G() : 1.055f * std::pow(rgb.G(), 1.0f / 2.4f) - 0.055f;
-            float sB = (rgb.B()<=0.0031308f) ? 12.92f*rgb.B() : 1.055f * std::pow(rgb.B(), 1.0f / 2.4f) - 0.055f;
-            R = static_cast<uint8_t>(std::clamp(std::round(sR*255),0.0f,255.0f));
-            G = static_cast<uint8_t>(std::clamp(std::round(sG*255),0.0f,255.0f));
-            B = static_cast<uint8_t>(std::clamp(std::round(sB*255),0.0f,255.0f));
+            R = srgb::to_srgb8(rgb.R());
+            G = srgb::to_srgb8(rgb.G());
+            B = srgb::to_srgb8(rgb.B());
         }
 
         constexpr RGB8(RGB_Int rgb){
@@ -707,12 +732,9 @@ namespace ES{
             float g = rgb.G()/255.0f;
             float b = rgb.B()/255.0f;
 
-            float sR = (r<=0.0031308f) ? 12.92f*r: 1.055f * std::pow(r, 1.0f / 2.4f) - 0.055f;
-            float sG = (g<=0.0031308f) ? 12.92f*g : 1.055f * std::pow(g, 1.0f / 2.4f) - 0.055f;
-            float sB = (b<=0.0031308f) ? 12.92f*b : 1.055f * std::pow(b, 1.0f / 2.4f) - 0.055f;
-            R = static_cast<uint8_t>(std::clamp(std::round(sR*255),0.0f,255.0f));
-            G = static_cast<uint8_t>(std::clamp(std::round(sG*255),0.0f,255.0f));
-            B = static_cast<uint8_t>(std::clamp(std::round(sB*255),0.0f,255.0f));
+            R = srgb::to_srgb8(r);
+            G = srgb::to_srgb8(g);
+            B = srgb::to_srgb8(b);
         }
 
         constexpr RGB8(RGBA rgba){
@@ -727,12 +749,9 @@ namespace ES{
             float g = rgba.G()/rgba.A();
             float b = rgba.B()/rgba.A();
 
-            float sR = (r<=0.0031308f) ? 12.92f*r: 1.055f * std::pow(r, 1.0f / 2.4f) - 0.055f;
-            float sG = (g<=0.0031308f) ? 12.92f*g : 1.055f * std::pow(g, 1.0f / 2.4f) - 0.055f;
-            float sB = (b<=0.0031308f) ? 12.92f*b : 1.055f * std::pow(b, 1.0f / 2.4f) - 0.055f;
-            R = static_cast<uint8_t>(std::clamp(std::round(sR*255),0.0f,255.0f));
-            G = static_cast<uint8_t>(std::clamp(std::round(sG*255),0.0f,255.0f));
-            B = static_cast<uint8_t>(std::clamp(std::round(sB*255),0.0f,255.0f));
+            R = srgb::to_srgb8(r);
+            G = srgb::to_srgb8(g);
+            B = srgb::to_srgb8(b);
         }
         constexpr RGB8(RGBA_Int rgba){
 
@@ -740,12 +759,9 @@ namespace ES{
             float g = rgba.G()/255.0f;
             float b = rgba.B()/255.0f;
 
-            float sR = (r<=0.0031308f) ? 12.92f*r: 1.055f * std::pow(r, 1.0f / 2.4f) - 0.055f;
-            float sG = (g<=0.0031308f) ? 12.92f*g : 1.055f * std::pow(g, 1.0f / 2.4f) - 0.055f;
-            float sB = (b<=0.0031308f) ? 12.92f*b : 1.055f * std::pow(b, 1.0f / 2.4f) - 0.055f;
-            R = static_cast<uint8_t>(std::clamp(std::round(sR*255),0.0f,255.0f));
-            G = static_cast<uint8_t>(std::clamp(std::round(sG*255),0.0f,255.0f));
-            B = static_cast<uint8_t>(std::clamp(std::round(sB*255),0.0f,255.0f));
+            R = srgb::to_srgb8(r);
+            G = srgb::to_srgb8(g);
+            B = srgb::to_srgb8(b);
         }
 
     };
@@ -753,13 +769,15 @@ namespace ES{
     struct RGBA8{
         uint8_t R,G,B,A;
 
+        constexpr RGBA8() noexcept = default;
+        // raw bytes, sRGB encoded colour and straight (not premultiplied) alpha
+        constexpr RGBA8(uint8_t r, uint8_t g, uint8_t b, uint8_t a) noexcept : R(r), G(g), B(b), A(a) {}
+
+
         constexpr RGBA8(RGB rgb,uint8_t a = 1){
-            float sR = (rgb.R()<=0.0031308f) ? 12.92f*rgb.R(): 1.055f * std::pow(rgb.R(), 1.0f / 2.4f) - 0.055f;
-            float sG = (rgb.G()<=0.0031308f) ? 12.92f*rgb.G() : 1.055f * std::pow(rgb.G(), 1.0f / 2.4f) - 0.055f;
-            float sB = (rgb.B()<=0.0031308f) ? 12.92f*rgb.B() : 1.055f * std::pow(rgb.B(), 1.0f / 2.4f) - 0.055f;
-            R = static_cast<uint8_t>(std::clamp(std::round(sR*255.0f),0.0f,255.0f));
-            G = static_cast<uint8_t>(std::clamp(std::round(sG*255.0f),0.0f,255.0f));
-            B = static_cast<uint8_t>(std::clamp(std::round(sB*255.0f),0.0f,255.0f));
+            R = srgb::to_srgb8(rgb.R());
+            G = srgb::to_srgb8(rgb.G());
+            B = srgb::to_srgb8(rgb.B());
             A = static_cast<uint8_t>(std::clamp(std::round(a*255.0f),0.0f,255.0f));
         }
 
@@ -768,12 +786,9 @@ namespace ES{
             float g = rgb.G()/255.0f;
             float b = rgb.B()/255.0f;
 
-            float sR = (r<=0.0031308f) ? 12.92f*r: 1.055f * std::pow(r, 1.0f / 2.4f) - 0.055f;
-            float sG = (g<=0.0031308f) ? 12.92f*g : 1.055f * std::pow(g, 1.0f / 2.4f) - 0.055f;
-            float sB = (b<=0.0031308f) ? 12.92f*b : 1.055f * std::pow(b, 1.0f / 2.4f) - 0.055f;
-            R = static_cast<uint8_t>(std::clamp(std::round(sR*255),0.0f,255.0f));
-            G = static_cast<uint8_t>(std::clamp(std::round(sG*255),0.0f,255.0f));
-            B = static_cast<uint8_t>(std::clamp(std::round(sB*255),0.0f,255.0f));
+            R = srgb::to_srgb8(r);
+            G = srgb::to_srgb8(g);
+            B = srgb::to_srgb8(b);
             A = static_cast<uint8_t>(a);
 
         }
@@ -790,12 +805,9 @@ namespace ES{
             float g = rgba.G()/rgba.A();
             float b = rgba.B()/rgba.A();
 
-            float sR = (r<=0.0031308f) ? 12.92f*r: 1.055f * std::pow(r, 1.0f / 2.4f) - 0.055f;
-            float sG = (g<=0.0031308f) ? 12.92f*g : 1.055f * std::pow(g, 1.0f / 2.4f) - 0.055f;
-            float sB = (b<=0.0031308f) ? 12.92f*b : 1.055f * std::pow(b, 1.0f / 2.4f) - 0.055f;
-            R = static_cast<uint8_t>(std::clamp(std::round(sR*255),0.0f,255.0f));
-            G = static_cast<uint8_t>(std::clamp(std::round(sG*255),0.0f,255.0f));
-            B = static_cast<uint8_t>(std::clamp(std::round(sB*255),0.0f,255.0f));
+            R = srgb::to_srgb8(r);
+            G = srgb::to_srgb8(g);
+            B = srgb::to_srgb8(b);
             A = static_cast<uint8_t>(std::clamp(std::round(rgba.A()*255),0.0f,255.0f));
 
         }
@@ -804,12 +816,9 @@ namespace ES{
             float g = rgba.G()/255.0f;
             float b = rgba.B()/255.0f;
 
-            float sR = (r<=0.0031308f) ? 12.92f*r: 1.055f * std::pow(r, 1.0f / 2.4f) - 0.055f;
-            float sG = (g<=0.0031308f) ? 12.92f*g : 1.055f * std::pow(g, 1.0f / 2.4f) - 0.055f;
-            float sB = (b<=0.0031308f) ? 12.92f*b : 1.055f * std::pow(b, 1.0f / 2.4f) - 0.055f;
-            R = static_cast<uint8_t>(std::clamp(std::round(sR*255),0.0f,255.0f));
-            G = static_cast<uint8_t>(std::clamp(std::round(sG*255),0.0f,255.0f));
-            B = static_cast<uint8_t>(std::clamp(std::round(sB*255),0.0f,255.0f));
+            R = srgb::to_srgb8(r);
+            G = srgb::to_srgb8(g);
+            B = srgb::to_srgb8(b);
             A = static_cast<uint8_t>(rgba.A());
         }
 
@@ -0,0 +1,192 @@
+#pragma once
+
+#include <span>
+#include "Quaternion.hpp"
+#include "VectorN.hpp"
+#include "Matrix.hpp"
+#include "AffineTransform3.hpp"
+
+
+namespace ES{
+
+    /**
+     * @brief A rigid transform (rotation + translation) packed as a dual quaternion `real + epsilon * dual`.
+     *
+     * The real part is the rotation, the dual part is `0.5 * t * real` where `t` is the translation as a pure quaternion.
+     * Blending a handful of these and renormalizing stays rigid, which is the whole reason they exist (no candy wrapper
+     * collapse when skinning, unlike blending matrices).
+     *
+     * @note Scale does not survive the trip. from_affine strips it, to_affine never had it.
+     */
+    template <typename T>
+    class DualQuaternion{
+        Quaternion<T> real_;
+        Quaternion<T> dual_;
+
+    public:
+        constexpr DualQuaternion() noexcept : real_(Quaternion<T>::identity()), dual_(T{0},T{0},T{0},T{0}) {}
+
+        constexpr DualQuaternion(const Quaternion<T>& real, const Quaternion<T>& dual) noexcept : real_(real), dual_(dual) {}
+
+        [[nodiscard]] static constexpr DualQuaternion identity() noexcept{
+            return DualQuaternion();
+        }
+
+        [[nodiscard]] static constexpr DualQuaternion from_rotation(const Quaternion<T>& rotation) noexcept{
+            return DualQuaternion(rotation, Quaternion<T>(T{0},T{0},T{0},T{0}));
+        }
+
+        [[nodiscard]] static constexpr DualQuaternion from_translation(const VectorN<T,3>& t) noexcept{
+            return DualQuaternion(Quaternion<T>::identity(), Quaternion<T>(T{0}, t[0]*T{0.5}, t[1]*T{0.5}, t[2]*T{0.5}));
+        }
+
+        // rotate first, then translate. Same order as AffineTransform3
+        [[nodiscard]] static constexpr DualQuaternion from_rotation_translation(const Quaternion<T>& rotation, const VectorN<T,3>& t) noexcept{
+            Quaternion<T> t_quat(T{0}, t[0], t[1], t[2]);
+            return DualQuaternion(rotation, (t_quat * rotation) * T{0.5});
+        }
+
+        [[nodiscard]] constexpr const Quaternion<T>& real() const noexcept{
+            return real_;
+        }
+        [[nodiscard]] constexpr const Quaternion<T>& dual() const noexcept{
+            return dual_;
+        }
+
+        [[nodiscard]] constexpr Quaternion<T> get_rotation() const noexcept{
+            return real_;
+        }
+
+        // 2 * dual * conj(real), written out so we skip the w component nobody wants
+        [[nodiscard]] constexpr VectorN<T,3> get_translation() const noexcept{
+            const Quaternion<T>& r = real_;
+            const Quaternion<T>& d = dual_;
+            return VectorN<T,3>(
+                T{2}*(-d.w()*r.x() + d.x()*r.w() - d.y()*r.z() + d.z()*r.y()),
+                T{2}*(-d.w()*r.y() + d.x()*r.z() + d.y()*r.w() - d.z()*r.x()),
+                T{2}*(-d.w()*r.z() - d.x()*r.y() + d.y()*r.x() + d.z()*r.w()));
+        }
+
+        // lhs applied last, just like matrices and AffineTransform3
+        [[nodiscard]] constexpr DualQuaternion operator*(const DualQuaternion& rhs) const noexcept{
+            return DualQuaternion(real_ * rhs.real_, real_ * rhs.dual_ + dual_ * rhs.real_);
+        }
+
+        constexpr DualQuaternion& operator*=(const DualQuaternion& rhs) noexcept{
+            dual_ = real_ * rhs.dual_ + dual_ * rhs.real_;
+            real_ *= rhs.real_;
+            return *this;
+        }
+
+        // the component wise operations below are only really meaningful for blending, renormalize after
+        [[nodiscard]] constexpr DualQuaternion operator+(const DualQuaternion& rhs) const noexcept{
+            return DualQuaternion(real_ + rhs.real_, dual_ + rhs.dual_);
+        }
+
+        constexpr DualQuaternion& operator+=(const DualQuaternion& rhs) noexcept{
+            real_ += rhs.real_;
+            dual_ += rhs.dual_;
+            return *this;
+        }
+
+        [[nodiscard]] constexpr DualQuaternion operator*(T scalar) const noexcept{
+            return DualQuaternion(real_ * scalar, dual_ * scalar);
+        }
+
+        [[nodiscard]] friend constexpr DualQuaternion operator*(T scalar, const DualQuaternion& dq) noexcept{
+            return dq * scalar;
+        }
+
+        [[nodiscard]] constexpr DualQuaternion operator-() const noexcept{
+            return DualQuaternion(-real_, -dual_);
+        }
+
+        // quaternion conjugate of both halves. For a unit dual quaternion this is the inverse
+        [[nodiscard]] constexpr DualQuaternion conjugate() const noexcept{
+            return DualQuaternion(real_.conjugate(), dual_.conjugate());
+        }
+
+        [[nodiscard]] constexpr DualQuaternion inverse() const noexcept{
+            return normalize().conjugate();
+        }
+
+        [[nodiscard]] constexpr T length() const noexcept{
+            return real_.length();
+        }
+
+        [[nodiscard]] constexpr DualQuaternion normalize() const noexcept{
+            DualQuaternion temp(*this);
+            return temp.normalize_in_place();
+        }
+
+        // divides by |real| and also pushes out whatever part of dual isn't orthogonal to real, so it's a proper rigid transform again
+        constexpr DualQuaternion& normalize_in_place() noexcept{
+            T len = real_.length();
+            assert(len != T{0} && "Zero length dual quaternion divide in normalize_in_place");
+            if(len == T{0}){
+                *this = identity();
+                return *this;
+            }
+            T inv_len = T{1} / len;
+            real_ *= inv_len;
+            dual_ *= inv_len;
+            dual_ -= real_ * real_.dot(dual_);
+            return *this;
+        }
+
+        [[nodiscard]] constexpr VectorN<T,3> transform_point(const VectorN<T,3>& point) const noexcept{
+            return real_.rotate(point) + get_translation();
+        }
+
+        [[nodiscard]] constexpr VectorN<T,3> transform_vector(const VectorN<T,3>& vec) const noexcept{
+            return real_.rotate(vec);
+        }
+
+        /**
+         * @brief Dual quaternion linear blending (Kavan et al.) of two transforms.
+         *
+         * Takes the short way around (flips rhs when the real parts disagree in sign) and renormalizes.
+         * Much cheaper than ScLERP and indistinguishable for the small angles between neighbouring bones.
+         */
+        [[nodiscard]] constexpr DualQuaternion blend(const DualQuaternion& rhs, T t) const noexcept{
+            T rhs_weight = real_.dot(rhs.real_) < T{0} ? -t : t;
+            return ((*this) * (T{1} - t) + rhs * rhs_weight).normalize_in_place();
+        }
+
+        /**
+         * @brief Dual quaternion linear blending of any number of transforms.
+         *
+         * @param dqs the transforms to blend
+         * @param weights one per transform, should sum to one but renormalizing forgives you if not
+         * @note Hemisphere is picked relative to the first transform, matching what the skinning kernels do.
+         */
+        [[nodiscard]] static constexpr DualQuaternion blend(std::span<const DualQuaternion> dqs, std::span<const T> weights) noexcept{
+            assert(dqs.size() == weights.size() && "blend needs exactly one weight per dual quaternion");
+            if(dqs.empty()){
+                return identity();
+            }
+            DualQuaternion accumulate(Quaternion<T>(T{0},T{0},T{0},T{0}), Quaternion<T>(T{0},T{0},T{0},T{0}));
+            const Quaternion<T>& pivot = dqs[0].real_;
+            for(std::size_t i = 0; i<dqs.size(); i++){
+                T weight = pivot.dot(dqs[i].real_) < T{0} ? -weights[i] : weights[i];
+                accumulate += dqs[i] * weight;
+            }
+            return accumulate.normalize_in_place();
+        }
+
+        [[nodiscard]] constexpr AffineTransform3<T> to_affine() const noexcept{
+            return AffineTransform3<T>(real_.to_matrix3(), get_translation());
+        }
+
+        // any scale or shear in the affine is dropped, the rotation comes from the normalized columns
+        [[nodiscard]] static /* constexpr in c++26*/ DualQuaternion from_affine(const AffineTransform3<T>& affine) noexcept{
+            Matrix<T,3> rotation = affine.get_linear().normalize();
+            return from_rotation_translation(Quaternion<T>::from_matrix3(rotation).normalize(), affine.get_translation());
+        }
+
+        [[nodiscard]] constexpr bool almost_equal(const DualQuaternion& rhs, T epsilon = math::default_epsilon<T>::value) const noexcept{
+            return real_.almost_equal(rhs.real_, epsilon) && dual_.almost_equal(rhs.dual_, epsilon);
+        }
+    };
+
+}
@@ -0,0 +1,190 @@
+#ifndef COMPUTERGRAPHICS_ESBULK_HPP
+#define COMPUTERGRAPHICS_ESBULK_HPP
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <span>
+#include <type_traits>
+#include "ES_simd.hpp"
+
+/*
+ * The machinery behind the span taking transform_points / transform_vectors / transform_normals members of
+ * AffineTransform3 and Transform. Those just flatten themselves into a row major 4x4 and hand it to bulk::transform,
+ * which runs lane batched over the buffer and switches to non-temporal stores once the output is big enough that
+ * caching it would only evict the input.
+ */
+
+//SIGNATURES AND FRIENDS
+namespace ES::bulk {
+
+    /// Three separate coordinate streams, the structure-of-arrays way of handing over a buffer of points.
+    template<typename T>
+    struct SoA3 {
+        std::span<T> x;
+        std::span<T> y;
+        std::span<T> z;
+
+        constexpr SoA3() noexcept = default;
+        constexpr SoA3(std::span<T> xs, std::span<T> ys, std::span<T> zs) noexcept : x(xs), y(ys), z(zs) {
+            assert(xs.size() == ys.size() && ys.size() == zs.size() && "SoA3 streams need to be the same length");
+        }
+        //so a mutable SoA3 can be passed as the input, for in place use
+        template<typename U> requires std::is_same_v<const U, T>
+        constexpr SoA3(const SoA3<U>& other) noexcept : x(other.x), y(other.y), z(other.z) {}
+
+        [[nodiscard]] constexpr std::size_t size() const noexcept { return x.size(); }
+    };
+
+    /// What the three component inputs mean. Elements that carry their own w (VectorH, VectorN<T,4>) ignore this for w.
+    enum class Mode {
+        points,  // w = 1, translated, divided through by w' under a projective matrix
+        vectors, // w = 0, never translated
+        normals  // w = 0, and the result renormalized. Pass the normal matrix, not the transform
+    };
+
+    /// A transform flattened row major. The last row is only read when the transform is Projective.
+    template<typename T>
+    using Rows = std::array<T, 16>;
+
+    /**
+     * @brief out[i] = m * in[i] over a whole AoS buffer of VectorN<T,3>, PointN<T,3>, VectorH<T> or VectorN<T,4>.
+     *
+     * @tparam mode how to read the missing w of three component elements
+     * @tparam Projective whether m's last row is anything other than (0,0,0,1)
+     * @param in elements to transform
+     * @param out where the results go, the same length as in. May be the same buffer as in, must not partially overlap it
+     */
+    template<Mode mode, bool Projective, typename T, typename In, typename Out>
+    void transform(const Rows<T>& m, std::span<In> in, std::span<Out> out) noexcept;
+
+    /// Same thing over structure-of-arrays streams.
+    template<Mode mode, bool Projective, typename T>
+    void transform(const Rows<T>& m, SoA3<const T> in, SoA3<T> out) noexcept;
+
+}
+
+namespace ES::bulk::Secret {
+    //gather(i, x, y, z, w) reads element i, scatter(i, x, y, z, w) writes it
+    template<Mode mode, bool Projective, bool DivideByW, typename T, typename Gather, typename Scatter>
+    void run(const Rows<T>& m, std::size_t count, Gather&& gather, Scatter&& scatter) noexcept;
+}
+
+//DEFINITIONS
+
+template<ES::bulk::Mode mode, bool Projective, bool DivideByW, typename T, typename Gather, typename Scatter>
+void ES::bulk::Secret::run(const Rows<T>& m, const std::size_t count, Gather&& gather, Scatter&& scatter) noexcept {
+    constexpr std::size_t W = simd::lanes<T>;
+    alignas(simd::register_bytes) std::array<T, W> x, y, z, w, ox, oy, oz, ow;
+
+    for (std::size_t base = 0; base < count; base += W) {
+        const std::size_t n = std::min(W, count - base);
+        for (std::size_t lane = 0; lane < n; lane++) {
+            gather(base + lane, x[lane], y[lane], z[lane], w[lane]);
+        }
+        for (std::size_t lane = n; lane < W; lane++) { //padding, never written back, just kept away from 0/0
+            x[lane] = y[lane] = z[lane] = T{0};
+            w[lane] = T{1};
+        }
+
+        ES_VECTORIZE
+        for (std::size_t lane = 0; lane < W; lane++) {
+            ox[lane] = m[0] * x[lane] + m[1] * y[lane] + m[2] * z[lane] + m[3] * w[lane];
+            oy[lane] = m[4] * x[lane] + m[5] * y[lane] + m[6] * z[lane] + m[7] * w[lane];
+            oz[lane] = m[8] * x[lane] + m[9] * y[lane] + m[10] * z[lane] + m[11] * w[lane];
+            if constexpr (Projective) {
+                ow[lane] = m[12] * x[lane] + m[13] * y[lane] + m[14] * z[lane] + m[15] * w[lane];
+            } else {
+                ow[lane] = w[lane];
+            }
+            if constexpr (DivideByW) {
+                const T inv_w = T{1} / ow[lane];
+                ox[lane] *= inv_w;
+                oy[lane] *= inv_w;
+                oz[lane] *= inv_w;
+            }
+            if constexpr (mode == Mode::normals) {
+                const T length_squared = ox[lane] * ox[lane] + oy[lane] * oy[lane] + oz[lane] * oz[lane];
+                const T inv_length = simd::select(length_squared > T{0}, simd::inverse_sqrt(length_squared), T{0});
+                ox[lane] *= inv_length;
+                oy[lane] *= inv_length;
+                oz[lane] *= inv_length;
+            }
+        }
+
+        for (std::size_t lane = 0; lane < n; lane++) {
+            scatter(base + lane, ox[lane], oy[lane], oz[lane], ow[lane]);
+        }
+    }
+}
+
+template<ES::bulk::Mode mode, bool Projective, typename T, typename In, typename Out>
+void ES::bulk::transform(const Rows<T>& m, const std::span<In> in, const std::span<Out> out) noexcept {
+    using Element = std::remove_const_t<In>;
+    static_assert(std::is_same_v<Element, Out>, "bulk::transform reads and writes the same element type");
+    constexpr std::size_t components = Element::size();
+    static_assert(components == 3 || components == 4, "bulk::transform works on 3 or 4 component elements");
+    assert(in.size() == out.size() && "bulk::transform needs one output per input");
+    //three component points get the perspective divide, four component elements stay homogeneous
+    constexpr bool divide = Projective && components == 3 && mode == Mode::points;
+
+    auto gather = [in](std::size_t i, T& x, T& y, T& z, T& w) {
+        const Element& e = in[i];
+        x = e[0]; y = e[1]; z = e[2];
+        if constexpr (components == 4) {
+            w = e[3];
+        } else {
+            w = mode == Mode::points ? T{1} : T{0};
+        }
+    };
+
+    if (out.size_bytes() >= simd::non_temporal_threshold) {
+        Secret::run<mode, Projective, divide>(m, in.size(), gather, [out](std::size_t i, T x, T y, T z, T w) {
+            T* dst = &out[i][0];
+            simd::stream_store(dst, x);
+            simd::stream_store(dst + 1, y);
+            simd::stream_store(dst + 2, z);
+            if constexpr (components == 4) {
+                simd::stream_store(dst + 3, w);
+            }
+        });
+        simd::stream_fence();
+        return;
+    }
+
+    Secret::run<mode, Projective, divide>(m, in.size(), gather, [out](std::size_t i, T x, T y, T z, T w) {
+        Element& e = out[i];
+        e[0] = x; e[1] = y; e[2] = z;
+        if constexpr (components == 4) {
+            e[3] = w;
+        }
+    });
+}
+
+template<ES::bulk::Mode mode, bool Projective, typename T>
+void ES::bulk::transform(const Rows<T>& m, const SoA3<const T> in, const SoA3<T> out) noexcept {
+    assert(in.size() == out.size() && "bulk::transform needs one output per input");
+    constexpr bool divide = Projective && mode == Mode::points;
+
+    auto gather = [in](std::size_t i, T& x, T& y, T& z, T& w) {
+        x = in.x[i]; y = in.y[i]; z = in.z[i];
+        w = mode == Mode::points ? T{1} : T{0};
+    };
+
+    if (out.size() * 3 * sizeof(T) >= simd::non_temporal_threshold) {
+        Secret::run<mode, Projective, divide>(m, in.size(), gather, [out](std::size_t i, T x, T y, T z, T) {
+            simd::stream_store(&out.x[i], x);
+            simd::stream_store(&out.y[i], y);
+            simd::stream_store(&out.z[i], z);
+        });
+        simd::stream_fence();
+        return;
+    }
+
+    Secret::run<mode, Projective, divide>(m, in.size(), gather, [out](std::size_t i, T x, T y, T z, T) {
+        out.x[i] = x; out.y[i] = y; out.z[i] = z;
+    });
+}
+
+#endif //COMPUTERGRAPHICS_ESBULK_HPP
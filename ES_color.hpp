@@ -0,0 +1,113 @@
+#ifndef COMPUTERGRAPHICS_ESCOLOR_HPP
+#define COMPUTERGRAPHICS_ESCOLOR_HPP
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include "ES_parallel.hpp"
+#include "ES_simd.hpp"
+#include "ES_srgb.hpp"
+#include "ColorN.hpp"
+#include "Image.hpp"
+
+/*
+ * Whole image colour conversions, the batch versions of what the ColorN constructors do one pixel at a time.
+ *
+ * 8 bit images are sRGB with straight alpha, float images are linear with RGBA premultiplied, same as the colour
+ * types themselves. Rows go out to the pool in bands of about 16K pixels. The transfer function (ES_srgb.hpp) is table
+ * loads and integer ops with no branches, so the row loops vectorize wherever the target has gathers; where it doesn't
+ * a 4K frame is memory bound long before the arithmetic matters.
+ */
+
+//SIGNATURES AND FRIENDS
+namespace ES::color {
+
+    /// Decodes in into out, which is the same size.
+    void to_linear(ImageView<const RGB8> in, ImageView<RGB> out, parallel::ThreadPool& pool = parallel::default_pool());
+
+    /// Decodes in into out, which is the same size, premultiplying by alpha.
+    void to_linear(ImageView<const RGBA8> in, ImageView<RGBA> out, parallel::ThreadPool& pool = parallel::default_pool());
+
+    /// Encodes in into out, which is the same size. Channels are clamped to [0, 1].
+    void to_srgb8(ImageView<const RGB> in, ImageView<RGB8> out, parallel::ThreadPool& pool = parallel::default_pool());
+
+    /// Encodes in into out, which is the same size, unpremultiplying first. Fully transparent pixels come out all 0.
+    void to_srgb8(ImageView<const RGBA> in, ImageView<RGBA8> out, parallel::ThreadPool& pool = parallel::default_pool());
+
+}
+
+namespace ES::color::Secret {
+
+    //rows to a job: about 16K pixels, however wide the image
+    [[nodiscard]] inline std::size_t row_grain(std::size_t width) noexcept {
+        return std::max<std::size_t>(1, (std::size_t{1} << 14) / std::max<std::size_t>(1, width));
+    }
+
+    void decode_row(const RGB8* ES_RESTRICT in, RGB* ES_RESTRICT out, std::size_t width) noexcept;
+    void decode_row(const RGBA8* ES_RESTRICT in, RGBA* ES_RESTRICT out, std::size_t width) noexcept;
+    void encode_row(const RGB* ES_RESTRICT in, RGB8* ES_RESTRICT out, std::size_t width) noexcept;
+    void encode_row(const RGBA* ES_RESTRICT in, RGBA8* ES_RESTRICT out, std::size_t width) noexcept;
+
+}
+
+//DEFINITIONS
+
+inline void ES::color::Secret::decode_row(const RGB8* ES_RESTRICT in, RGB* ES_RESTRICT out, const std::size_t width) noexcept {
+    for (std::size_t x = 0; x < width; x++) {
+        out[x] = RGB(srgb::to_linear(in[x].R), srgb::to_linear(in[x].G), srgb::to_linear(in[x].B));
+    }
+}
+
+inline void ES::color::Secret::decode_row(const RGBA8* ES_RESTRICT in, RGBA* ES_RESTRICT out, const std::size_t width) noexcept {
+    for (std::size_t x = 0; x < width; x++) {
+        const float a = in[x].A * (1.0f / 255.0f);
+        out[x] = RGBA(srgb::to_linear(in[x].R) * a, srgb::to_linear(in[x].G) * a, srgb::to_linear(in[x].B) * a, a);
+    }
+}
+
+inline void ES::color::Secret::encode_row(const RGB* ES_RESTRICT in, RGB8* ES_RESTRICT out, const std::size_t width) noexcept {
+    for (std::size_t x = 0; x < width; x++) {
+        out[x] = RGB8(srgb::to_srgb8(in[x].R()), srgb::to_srgb8(in[x].G()), srgb::to_srgb8(in[x].B()));
+    }
+}
+
+inline void ES::color::Secret::encode_row(const RGBA* ES_RESTRICT in, RGBA8* ES_RESTRICT out, const std::size_t width) noexcept {
+    for (std::size_t x = 0; x < width; x++) {
+        //both sides of the select are computed, 1/0 included; the 0 is what gets used
+        const float a = in[x].A();
+        const float unpremultiply = simd::select(a > 0.0f, 1.0f / a, 0.0f);
+        out[x] = RGBA8(srgb::to_srgb8(in[x].R() * unpremultiply), srgb::to_srgb8(in[x].G() * unpremultiply),
+                       srgb::to_srgb8(in[x].B() * unpremultiply), static_cast<std::uint8_t>(std::min(std::max(a, 0.0f), 1.0f) * 255.0f + 0.5f));
+    }
+}
+
+inline void ES::color::to_linear(const ImageView<const RGB8> in, const ImageView<RGB> out, parallel::ThreadPool& pool) {
+    assert(in.width() == out.width() && in.height() == out.height() && "color::to_linear needs images the same size");
+    out.parallel_for_rows([&](std::size_t y, std::span<RGB> row) {
+        Secret::decode_row(in.row_data(y), row.data(), row.size());
+    }, Secret::row_grain(out.width()), pool);
+}
+
+inline void ES::color::to_linear(const ImageView<const RGBA8> in, const ImageView<RGBA> out, parallel::ThreadPool& pool) {
+    assert(in.width() == out.width() && in.height() == out.height() && "color::to_linear needs images the same size");
+    out.parallel_for_rows([&](std::size_t y, std::span<RGBA> row) {
+        Secret::decode_row(in.row_data(y), row.data(), row.size());
+    }, Secret::row_grain(out.width()), pool);
+}
+
+inline void ES::color::to_srgb8(const ImageView<const RGB> in, const ImageView<RGB8> out, parallel::ThreadPool& pool) {
+    assert(in.width() == out.width() && in.height() == out.height() && "color::to_srgb8 needs images the same size");
+    out.parallel_for_rows([&](std::size_t y, std::span<RGB8> row) {
+        Secret::encode_row(in.row_data(y), row.data(), row.size());
+    }, Secret::row_grain(out.width()), pool);
+}
+
+inline void ES::color::to_srgb8(const ImageView<const RGBA> in, const ImageView<RGBA8> out, parallel::ThreadPool& pool) {
+    assert(in.width() == out.width() && in.height() == out.height() && "color::to_srgb8 needs images the same size");
+    out.parallel_for_rows([&](std::size_t y, std::span<RGBA8> row) {
+        Secret::encode_row(in.row_data(y), row.data(), row.size());
+    }, Secret::row_grain(out.width()), pool);
+}
+
+#endif //COMPUTERGRAPHICS_ESCOLOR_HPP
@@ -0,0 +1,480 @@
+#ifndef COMPUTERGRAPHICS_ESCOLORSPACE_HPP
+#define COMPUTERGRAPHICS_ESCOLORSPACE_HPP
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <type_traits>
+#include "ES_math.hpp"
+#include "ES_parallel.hpp"
+#include "ES_simd.hpp"
+#include "ES_srgb.hpp"
+#include "ColorN.hpp"
+#include "Image.hpp"
+
+/*
+ * Colour spaces other than linear RGB: HSV, HSL, CIE XYZ, Oklab, Oklch and YCbCr, through one color::convert.
+ *
+ * HSV, HSL and YCbCr are of the sRGB encoded channels, the numbers a colour picker or a video frame holds, so linear
+ * values outside [0, 1] clamp on the way in and come back clamped. XYZ (D65) and Oklab are of linear light and take
+ * anything. Hues are in degrees, [0, 360) on the way out and anything on the way in. An RGBA, premultiplied,
+ * converts to a WithAlpha<Space>, straight, and back.
+ *
+ * Every scalar conversion is constexpr and branch free: the transfer curve is srgb::encode / decode, Oklab's cube
+ * root is simd::nth_root, Oklch's angles are a polynomial atan2 and math::Secret::sincos_reduced, and every choice
+ * is a simd::select. The image versions are row loops over the scalar ones spread across the pool, and vectorize
+ * for that.
+ *
+ * adjust() is hue, saturation and brightness in one pass through Oklab. Oklab of k times a linear colour is the cube
+ * root of k times its Oklab, so all three together are one linear map of L, a and b: brightness scales all of
+ * them, saturation scales a and b, hue turns them. The same holds for a premultiplied colour, which is why RGBA images
+ * need no unpremultiplying.
+ */
+
+//SIGNATURES AND FRIENDS
+namespace ES::color {
+
+    /// Hue in degrees, saturation and value in [0, 1], of the sRGB encoded channels.
+    struct HSV {
+        float H, S, V;
+    };
+
+    /// Hue in degrees, saturation and lightness in [0, 1], of the sRGB encoded channels.
+    struct HSL {
+        float H, S, L;
+    };
+
+    /// CIE 1931 XYZ with a D65 white, Y the luminance.
+    struct XYZ {
+        float X, Y, Z;
+    };
+
+    /// Oklab (Ottosson): L perceived lightness in [0, 1], a green to red, b blue to yellow.
+    struct Oklab {
+        float L, a, b;
+    };
+
+    /// Oklab in polar form: C the chroma, h the hue in degrees.
+    struct Oklch {
+        float L, C, h;
+    };
+
+    enum class YCbCrMatrix {
+        bt601, ///< SD video and JPEG
+        bt709  ///< HD video
+    };
+
+    enum class YCbCrRange {
+        full,   ///< Y, Cb and Cr all over [0, 1], chroma centred on 0.5
+        limited ///< Y over [16, 235] / 255, Cb and Cr over [16, 240] / 255 centred on 128 / 255, studio swing
+    };
+
+    /// Luma and chroma of the sRGB encoded channels, by the matrix and range in the type. 255 times a channel is its 8 bit code.
+    template <YCbCrMatrix M = YCbCrMatrix::bt709, YCbCrRange R = YCbCrRange::full>
+    struct YCbCr {
+        static constexpr YCbCrMatrix matrix = M;
+        static constexpr YCbCrRange range = R;
+        float Y, Cb, Cr;
+    };
+
+    /// A colour in one of the spaces above and a straight alpha, what an RGBA converts to.
+    template <typename Space>
+    struct WithAlpha {
+        Space colour;
+        float A;
+    };
+
+}
+
+namespace ES::color::Secret {
+
+    template <typename T> inline constexpr bool is_space = false;
+    template <> inline constexpr bool is_space<HSV> = true;
+    template <> inline constexpr bool is_space<HSL> = true;
+    template <> inline constexpr bool is_space<XYZ> = true;
+    template <> inline constexpr bool is_space<Oklab> = true;
+    template <> inline constexpr bool is_space<Oklch> = true;
+    template <YCbCrMatrix matrix, YCbCrRange range> inline constexpr bool is_space<YCbCr<matrix, range>> = true;
+
+    template <typename T> inline constexpr bool is_alpha_space = false;
+    template <typename Space> inline constexpr bool is_alpha_space<WithAlpha<Space>> = is_space<Space>;
+
+}
+
+namespace ES::color {
+
+    /// RGB or one of the spaces above.
+    template <typename T>
+    concept Colour = std::is_same_v<T, RGB> || Secret::is_space<T>;
+
+    /// RGBA or one of the spaces above with alpha.
+    template <typename T>
+    concept AlphaColour = std::is_same_v<T, RGBA> || Secret::is_alpha_space<T>;
+
+    template <typename To, typename From>
+    concept Convertible = (Colour<To> && Colour<From>) || (AlphaColour<To> && AlphaColour<From>);
+
+    /// from in the space To. Anything to anything, going through linear RGB where there's no shorter way.
+    template <typename To, typename From> requires Convertible<To, From>
+    [[nodiscard]] constexpr To convert(const From& from) noexcept;
+
+    /// Every pixel of in converted into out, which is the same size.
+    template <typename From, typename To> requires Convertible<To, std::remove_const_t<From>>
+    void convert(ImageView<From> in, ImageView<To> out, parallel::ThreadPool& pool = parallel::default_pool());
+
+    template <typename From, typename To> requires Convertible<To, From>
+    void convert(const Image<From>& in, Image<To>& out, parallel::ThreadPool& pool = parallel::default_pool());
+
+    /// Hue, saturation and brightness edits, all made in one go.
+    struct Adjustment {
+        float hue = 0.0f;        ///< degrees to turn every hue by, in Oklch
+        float saturation = 1.0f; ///< Oklab chroma scale, 0 for grey
+        float brightness = 1.0f; ///< linear light scale, as ColorOpsMixin::adjust_brightness
+    };
+
+    [[nodiscard]] constexpr RGB adjust(const RGB& colour, const Adjustment& adjustment) noexcept;
+
+    [[nodiscard]] constexpr RGBA adjust(const RGBA& colour, const Adjustment& adjustment) noexcept;
+
+    /// adjustment made to every pixel of image in place, one pass.
+    void adjust(ImageView<RGB> image, const Adjustment& adjustment, parallel::ThreadPool& pool = parallel::default_pool());
+
+    /// adjustment made to every pixel of image in place, one pass. Premultiplied pixels need no unpremultiplying.
+    void adjust(ImageView<RGBA> image, const Adjustment& adjustment, parallel::ThreadPool& pool = parallel::default_pool());
+
+}
+
+namespace ES::color::Secret {
+
+    //rows to a job: about 16K pixels, however wide the image
+    [[nodiscard]] inline std::size_t colourspace_row_grain(std::size_t width) noexcept {
+        return std::max<std::size_t>(1, (std::size_t{1} << 14) / std::max<std::size_t>(1, width));
+    }
+
+    [[nodiscard]] constexpr float absolute(float x) noexcept {
+        return simd::select(x < 0.0f, -x, x);
+    }
+
+    //the real cube root, negatives included
+    [[nodiscard]] constexpr float cbrt(float x) noexcept;
+
+    [[nodiscard]] constexpr float sqrt(float x) noexcept {
+        return simd::select(x > 0.0f, x * simd::inverse_sqrt(x), 0.0f);
+    }
+
+    //atan2 in degrees, [0, 360), to about 1e-3 of a degree; 0 for the origin
+    [[nodiscard]] constexpr float hue_degrees(float y, float x) noexcept;
+
+    //any angle in degrees into [0, 360)
+    [[nodiscard]] constexpr float wrap_degrees(float degrees) noexcept;
+
+    //HSV and HSL hue of encoded r, g, b whose largest is max and spread delta
+    [[nodiscard]] constexpr float hexcone_hue(float r, float g, float b, float max, float delta) noexcept;
+
+    template <typename To>
+    [[nodiscard]] constexpr To from_rgb(const RGB& colour) noexcept;
+
+    [[nodiscard]] constexpr RGB to_rgb(const HSV& colour) noexcept;
+    [[nodiscard]] constexpr RGB to_rgb(const HSL& colour) noexcept;
+    [[nodiscard]] constexpr RGB to_rgb(const XYZ& colour) noexcept;
+    [[nodiscard]] constexpr RGB to_rgb(const Oklab& colour) noexcept;
+    [[nodiscard]] constexpr RGB to_rgb(const Oklch& colour) noexcept;
+    template <YCbCrMatrix matrix, YCbCrRange range>
+    [[nodiscard]] constexpr RGB to_rgb(const YCbCr<matrix, range>& colour) noexcept;
+
+    [[nodiscard]] constexpr Oklch to_polar(const Oklab& colour) noexcept;
+    [[nodiscard]] constexpr Oklab to_cartesian(const Oklch& colour) noexcept;
+
+    //Kr and Kb of a YCbCr matrix
+    [[nodiscard]] constexpr float red_weight(YCbCrMatrix matrix) noexcept;
+    [[nodiscard]] constexpr float blue_weight(YCbCrMatrix matrix) noexcept;
+
+    //an Adjustment worked down to the linear map it is in Oklab
+    struct LabMap {
+        float lightness;
+        float aa, ab, ba, bb;
+    };
+
+    [[nodiscard]] constexpr LabMap lab_map(const Adjustment& adjustment) noexcept;
+
+    [[nodiscard]] constexpr RGB apply(const RGB& colour, const LabMap& map) noexcept;
+
+}
+
+//DEFINITIONS
+
+constexpr float ES::color::Secret::cbrt(const float x) noexcept {
+    const float a = absolute(x);
+    const float root = simd::nth_root<3>(simd::select(a > 0.0f, a, 1.0f));
+    return simd::select(a > 0.0f, simd::select(x < 0.0f, -root, root), 0.0f);
+}
+
+constexpr float ES::color::Secret::hue_degrees(const float y, const float x) noexcept {
+    const float ax = absolute(x);
+    const float ay = absolute(y);
+    const float big = std::max(ax, ay);
+    const float small = std::min(ax, ay);
+    const float t = simd::select(big > 0.0f, small / simd::select(big > 0.0f, big, 1.0f), 0.0f);
+    const float t2 = t * t;
+    //minimax atan on [0, 1]
+    float r = t * (0.99997726f + t2 * (-0.33262347f + t2 * (0.19354346f + t2 * (-0.11643287f + t2 * (0.05265332f + t2 * -0.01172120f)))));
+    r = simd::select(ay > ax, math::half_pi<float> - r, r);
+    r = simd::select(x < 0.0f, math::pi<float> - r, r);
+    r = simd::select(y < 0.0f, -r, r);
+    return wrap_degrees(r * (180.0f / math::pi<float>));
+}
+
+constexpr float ES::color::Secret::wrap_degrees(const float degrees) noexcept {
+    const float wrapped = math::modulo(degrees, 360.0f);
+    //a hair below 0 can round up to 360 itself
+    return simd::select(wrapped < 360.0f, wrapped, 0.0f);
+}
+
+constexpr float ES::color::Secret::hexcone_hue(const float r, const float g, const float b, const float max, const float delta) noexcept {
+    const float inverse = simd::select(delta > 0.0f, 1.0f / simd::select(delta > 0.0f, delta, 1.0f), 0.0f);
+    //sixths of a turn from red
+    const float red = (g - b) * inverse;
+    const float green = (b - r) * inverse + 2.0f;
+    const float blue = (r - g) * inverse + 4.0f;
+    const float sixths = simd::select(max == r, red, simd::select(max == g, green, blue));
+    return wrap_degrees(sixths * 60.0f);
+}
+
+constexpr float ES::color::Secret::red_weight(const YCbCrMatrix matrix) noexcept {
+    return matrix == YCbCrMatrix::bt601 ? 0.299f : 0.2126f;
+}
+
+constexpr float ES::color::Secret::blue_weight(const YCbCrMatrix matrix) noexcept {
+    return matrix == YCbCrMatrix::bt601 ? 0.114f : 0.0722f;
+}
+
+template <typename To>
+constexpr To ES::color::Secret::from_rgb(const RGB& colour) noexcept {
+    if constexpr (std::is_same_v<To, HSV> || std::is_same_v<To, HSL>) {
+        const float r = srgb::encode(colour.R());
+        const float g = srgb::encode(colour.G());
+        const float b = srgb::encode(colour.B());
+        const float max = std::max(std::max(r, g), b);
+        const float min = std::min(std::min(r, g), b);
+        const float delta = max - min;
+        const float hue = hexcone_hue(r, g, b, max, delta);
+        if constexpr (std::is_same_v<To, HSV>) {
+            const float saturation = simd::select(max > 0.0f, delta / simd::select(max > 0.0f, max, 1.0f), 0.0f);
+            return HSV{hue, saturation, max};
+        } else {
+            const float lightness = 0.5f * (max + min);
+            //only 0 when lightness is 0 or 1, and then delta is 0 too
+            const float spread = 1.0f - absolute(2.0f * lightness - 1.0f);
+            const float saturation = simd::select(delta > 0.0f, delta / simd::select(delta > 0.0f, spread, 1.0f), 0.0f);
+            return HSL{hue, saturation, lightness};
+        }
+    } else if constexpr (std::is_same_v<To, XYZ>) {
+        const float r = colour.R();
+        const float g = colour.G();
+        const float b = colour.B();
+        return XYZ{0.4124564f * r + 0.3575761f * g + 0.1804375f * b,
+                   0.2126729f * r + 0.7151522f * g + 0.0721750f * b,
+                   0.0193339f * r + 0.1191920f * g + 0.9503041f * b};
+    } else if constexpr (std::is_same_v<To, Oklab>) {
+        const float r = colour.R();
+        const float g = colour.G();
+        const float b = colour.B();
+        const float l = cbrt(0.4122214708f * r + 0.5363325363f * g + 0.0514459929f * b);
+        const float m = cbrt(0.2119034982f * r + 0.6806995451f * g + 0.1073969566f * b);
+        const float s = cbrt(0.0883024619f * r + 0.2817188376f * g + 0.6299787005f * b);
+        return Oklab{0.2104542553f * l + 0.7936177850f * m - 0.0040720468f * s,
+                     1.9779984951f * l - 2.4285922050f * m + 0.4505937099f * s,
+                     0.0259040371f * l + 0.7827717662f * m - 0.8086757660f * s};
+    } else if constexpr (std::is_same_v<To, Oklch>) {
+        return to_polar(from_rgb<Oklab>(colour));
+    } else {
+        constexpr float kr = red_weight(To::matrix);
+        constexpr float kb = blue_weight(To::matrix);
+        const float r = srgb::encode(colour.R());
+        const float g = srgb::encode(colour.G());
+        const float b = srgb::encode(colour.B());
+        const float y = kr * r + (1.0f - kr - kb) * g + kb * b;
+        const float cb = (b - y) * (0.5f / (1.0f - kb));
+        const float cr = (r - y) * (0.5f / (1.0f - kr));
+        if constexpr (To::range == YCbCrRange::limited) {
+            return To{(16.0f + 219.0f * y) * (1.0f / 255.0f), (128.0f + 224.0f * cb) * (1.0f / 255.0f), (128.0f + 224.0f * cr) * (1.0f / 255.0f)};
+        } else {
+            return To{y, cb + 0.5f, cr + 0.5f};
+        }
+    }
+}
+
+constexpr ES::RGB ES::color::Secret::to_rgb(const HSV& colour) noexcept {
+    const float sixths = colour.H * (1.0f / 60.0f);
+    const float chroma = colour.V * colour.S;
+    //each channel is value less chroma times how far its point on the hexagon is from the hue, capped at 1
+    const auto channel = [&](const float n) {
+        const float k = math::modulo(n + sixths, 6.0f);
+        const float ramp = std::min(std::max(std::min(k, 4.0f - k), 0.0f), 1.0f);
+        return srgb::decode(colour.V - chroma * ramp);
+    };
+    return RGB(channel(5.0f), channel(3.0f), channel(1.0f));
+}
+
+constexpr ES::RGB ES::color::Secret::to_rgb(const HSL& colour) noexcept {
+    const float twelfths = colour.H * (1.0f / 30.0f);
+    const float reach = colour.S * std::min(colour.L, 1.0f - colour.L);
+    const auto channel = [&](const float n) {
+        const float k = math::modulo(n + twelfths, 12.0f);
+        const float ramp = std::min(std::max(std::min(k - 3.0f, 9.0f - k), -1.0f), 1.0f);
+        return srgb::decode(colour.L - reach * ramp);
+    };
+    return RGB(channel(0.0f), channel(8.0f), channel(4.0f));
+}
+
+constexpr ES::RGB ES::color::Secret::to_rgb(const XYZ& colour) noexcept {
+    const float x = colour.X;
+    const float y = colour.Y;
+    const float z = colour.Z;
+    return RGB(3.2404542f * x - 1.5371385f * y - 0.4985314f * z,
+               -0.9692660f * x + 1.8760108f * y + 0.0415560f * z,
+               0.0556434f * x - 0.2040259f * y + 1.0572252f * z);
+}
+
+constexpr ES::RGB ES::color::Secret::to_rgb(const Oklab& colour) noexcept {
+    const float l = colour.L + 0.3963377774f * colour.a + 0.2158037573f * colour.b;
+    const float m = colour.L - 0.1055613458f * colour.a - 0.0638541728f * colour.b;
+    const float s = colour.L - 0.0894841775f * colour.a - 1.2914855480f * colour.b;
+    const float l3 = l * l * l;
+    const float m3 = m * m * m;
+    const float s3 = s * s * s;
+    return RGB(4.0767416621f * l3 - 3.3077115913f * m3 + 0.2309699292f * s3,
+               -1.2684380046f * l3 + 2.6097574011f * m3 - 0.3413193965f * s3,
+               -0.0041960863f * l3 - 0.7034186147f * m3 + 1.7076147010f * s3);
+}
+
+constexpr ES::RGB ES::color::Secret::to_rgb(const Oklch& colour) noexcept {
+    return to_rgb(to_cartesian(colour));
+}
+
+template <ES::color::YCbCrMatrix matrix, ES::color::YCbCrRange range>
+constexpr ES::RGB ES::color::Secret::to_rgb(const YCbCr<matrix, range>& colour) noexcept {
+    constexpr float kr = red_weight(matrix);
+    constexpr float kb = blue_weight(matrix);
+    float y = colour.Y;
+    float cb = colour.Cb - 0.5f;
+    float cr = colour.Cr - 0.5f;
+    if constexpr (range == YCbCrRange::limited) {
+        y = (colour.Y * 255.0f - 16.0f) * (1.0f / 219.0f);
+        cb = (colour.Cb * 255.0f - 128.0f) * (1.0f / 224.0f);
+        cr = (colour.Cr * 255.0f - 128.0f) * (1.0f / 224.0f);
+    }
+    const float r = y + 2.0f * (1.0f - kr) * cr;
+    const float b = y + 2.0f * (1.0f - kb) * cb;
+    const float g = (y - kr * r - kb * b) * (1.0f / (1.0f - kr - kb));
+    return RGB(srgb::decode(r), srgb::decode(g), srgb::decode(b));
+}
+
+constexpr ES::color::Oklch ES::color::Secret::to_polar(const Oklab& colour) noexcept {
+    return Oklch{colour.L, sqrt(colour.a * colour.a + colour.b * colour.b), hue_degrees(colour.b, colour.a)};
+}
+
+constexpr ES::color::Oklab ES::color::Secret::to_cartesian(const Oklch& colour) noexcept {
+    float sine = 0.0f;
+    float cosine = 0.0f;
+    math::Secret::sincos_reduced(wrap_degrees(colour.h) * (math::pi<float> / 180.0f), sine, cosine);
+    return Oklab{colour.L, colour.C * cosine, colour.C * sine};
+}
+
+template <typename To, typename From> requires ES::color::Convertible<To, From>
+constexpr To ES::color::convert(const From& from) noexcept {
+    if constexpr (std::is_same_v<To, From>) {
+        return from;
+    } else if constexpr (std::is_same_v<From, RGB>) {
+        return Secret::from_rgb<To>(from);
+    } else if constexpr (std::is_same_v<To, RGB>) {
+        return Secret::to_rgb(from);
+    } else if constexpr (std::is_same_v<From, Oklab> && std::is_same_v<To, Oklch>) {
+        return Secret::to_polar(from);
+    } else if constexpr (std::is_same_v<From, Oklch> && std::is_same_v<To, Oklab>) {
+        return Secret::to_cartesian(from);
+    } else if constexpr (Colour<To>) {
+        return Secret::from_rgb<To>(Secret::to_rgb(from));
+    } else if constexpr (std::is_same_v<From, RGBA>) {
+        //both sides of the select are computed, 1/0 included; the 0 is what gets used
+        const float a = from.A();
+        const float unpremultiply = simd::select(a > 0.0f, 1.0f / a, 0.0f);
+        const RGB straight(from.R() * unpremultiply, from.G() * unpremultiply, from.B() * unpremultiply);
+        return To{convert<decltype(To::colour)>(straight), a};
+    } else if constexpr (std::is_same_v<To, RGBA>) {
+        const RGB straight = convert<RGB>(from.colour);
+        return RGBA(straight.R() * from.A, straight.G() * from.A, straight.B() * from.A, from.A);
+    } else {
+        return To{convert<decltype(To::colour)>(from.colour), from.A};
+    }
+}
+
+template <typename From, typename To> requires ES::color::Convertible<To, std::remove_const_t<From>>
+void ES::color::convert(const ImageView<From> in, const ImageView<To> out, parallel::ThreadPool& pool) {
+    assert(in.width() == out.width() && in.height() == out.height() && "color::convert needs images the same size");
+    out.parallel_for_rows([&](std::size_t y, std::span<To> row) {
+        const From* ES_RESTRICT source = in.row_data(y);
+        To* ES_RESTRICT target = row.data();
+        const std::size_t width = row.size();
+        ES_VECTORIZE
+        for (std::size_t x = 0; x < width; x++) {
+            target[x] = convert<To>(source[x]);
+        }
+    }, Secret::colourspace_row_grain(out.width()), pool);
+}
+
+template <typename From, typename To> requires ES::color::Convertible<To, From>
+void ES::color::convert(const Image<From>& in, Image<To>& out, parallel::ThreadPool& pool) {
+    convert(in.view(), out.view(), pool);
+}
+
+constexpr ES::color::Secret::LabMap ES::color::Secret::lab_map(const Adjustment& adjustment) noexcept {
+    float sine = 0.0f;
+    float cosine = 0.0f;
+    math::Secret::sincos_reduced(wrap_degrees(adjustment.hue) * (math::pi<float> / 180.0f), sine, cosine);
+    //k times the light is the cube root of k times the Oklab
+    const float lightness = cbrt(std::max(adjustment.brightness, 0.0f));
+    const float chroma = lightness * adjustment.saturation;
+    return LabMap{lightness, chroma * cosine, -chroma * sine, chroma * sine, chroma * cosine};
+}
+
+constexpr ES::RGB ES::color::Secret::apply(const RGB& colour, const LabMap& map) noexcept {
+    const Oklab lab = from_rgb<Oklab>(colour);
+    return to_rgb(Oklab{map.lightness * lab.L, map.aa * lab.a + map.ab * lab.b, map.ba * lab.a + map.bb * lab.b});
+}
+
+constexpr ES::RGB ES::color::adjust(const RGB& colour, const Adjustment& adjustment) noexcept {
+    return Secret::apply(colour, Secret::lab_map(adjustment));
+}
+
+constexpr ES::RGBA ES::color::adjust(const RGBA& colour, const Adjustment& adjustment) noexcept {
+    const RGB adjusted = Secret::apply(RGB(colour.R(), colour.G(), colour.B()), Secret::lab_map(adjustment));
+    return RGBA(adjusted.R(), adjusted.G(), adjusted.B(), colour.A());
+}
+
+inline void ES::color::adjust(const ImageView<RGB> image, const Adjustment& adjustment, parallel::ThreadPool& pool) {
+    const Secret::LabMap map = Secret::lab_map(adjustment);
+    image.parallel_for_rows([&](std::size_t, std::span<RGB> row) {
+        RGB* ES_RESTRICT pixels = row.data();
+        const std::size_t width = row.size();
+        ES_VECTORIZE
+        for (std::size_t x = 0; x < width; x++) {
+            pixels[x] = Secret::apply(pixels[x], map);
+        }
+    }, Secret::colourspace_row_grain(image.width()), pool);
+}
+
+inline void ES::color::adjust(const ImageView<RGBA> image, const Adjustment& adjustment, parallel::ThreadPool& pool) {
+    const Secret::LabMap map = Secret::lab_map(adjustment);
+    image.parallel_for_rows([&](std::size_t, std::span<RGBA> row) {
+        RGBA* ES_RESTRICT pixels = row.data();
+        const std::size_t width = row.size();
+        ES_VECTORIZE
+        for (std::size_t x = 0; x < width; x++) {
+            const RGB adjusted = Secret::apply(RGB(pixels[x].R(), pixels[x].G(), pixels[x].B()), map);
+            pixels[x] = RGBA(adjusted.R(), adjusted.G(), adjusted.B(), pixels[x].A());
+        }
+    }, Secret::colourspace_row_grain(image.width()), pool);
+}
+
+#endif //COMPUTERGRAPHICS_ESCOLORSPACE_HPP
@@ -0,0 +1,329 @@
+#ifndef COMPUTERGRAPHICS_ESCOMPOSITE_HPP
+#define COMPUTERGRAPHICS_ESCOMPOSITE_HPP
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include "ES_parallel.hpp"
+#include "ES_simd.hpp"
+#include "ColorN.hpp"
+#include "Image.hpp"
+
+/*
+ * Porter-Duff compositing and the common separable blend modes, source onto destination, on premultiplied pixels.
+ *
+ * Everything is one formula, result = source * Fs + destination * Fd (plus a product term for multiply and screen),
+ * written once against a little arithmetic policy: floats for RGBA, and 16 bit fixed point for RGBA8 where a sum of
+ * byte products is divided by 255 with the exact rounding shift trick instead of a divide, once per channel, so 8 bit
+ * results are within half a code of exact. Rows are plain loops over channels that compilers turn into vector code,
+ * 8 or 16 channels of 16 bits to a register for the bytes.
+ *
+ * RGBA8 here holds premultiplied values, unlike the straight alpha RGBA8 usually carries (what the PNG decoder gives
+ * you, for one); premultiply() and unpremultiply() go between the two. Whatever space the bytes are in, the maths is
+ * done on the bytes as they are, as 8 bit compositors always have.
+ *
+ * Whole images go out to the pool a tile at a time. A source tile that is entirely opaque or entirely transparent
+ * usually decides the answer outright (over with opaque source is a copy, nearly everything with transparent source
+ * leaves the destination alone), so tiles are checked first and skip the per pixel work when they can. Transparent
+ * means nothing in any channel: premultiplied colour with no alpha is additive light, which over and add still add.
+ */
+
+//SIGNATURES AND FRIENDS
+namespace ES::composite {
+
+    /// What goes where. The first five are Porter-Duff's source-X operators, the last three blend modes.
+    enum class Blend {
+        over,         ///< source in front of destination
+        in,           ///< source where destination is, nothing elsewhere
+        out,          ///< source where destination isn't, nothing elsewhere
+        atop,         ///< source over destination, only where destination is
+        exclusive_or, ///< each where the other isn't (Porter-Duff xor)
+        add,          ///< source plus destination, saturating
+        multiply,     ///< channels multiplied where both are, each shows through where the other isn't
+        screen        ///< the inverse of multiplying the inverses, lightens
+    };
+
+    /// Side of the square tiles whole image compositing hands out, in pixels.
+    inline constexpr std::size_t tile_size = 64;
+
+    /// source composited onto destination.
+    [[nodiscard]] constexpr RGBA blend(const RGBA& source, const RGBA& destination, Blend mode) noexcept;
+
+    /// source composited onto destination, both premultiplied 8 bit.
+    [[nodiscard]] constexpr RGBA8 blend(const RGBA8& source, const RGBA8& destination, Blend mode) noexcept;
+
+    /// source composited onto destination in place. Both are the same size.
+    void blend(ImageView<const RGBA> source, ImageView<RGBA> destination, Blend mode, parallel::ThreadPool& pool = parallel::default_pool());
+
+    /// source composited onto destination in place, both premultiplied 8 bit. Both are the same size.
+    void blend(ImageView<const RGBA8> source, ImageView<RGBA8> destination, Blend mode, parallel::ThreadPool& pool = parallel::default_pool());
+
+    /// Straight alpha RGBA8 to premultiplied, in place.
+    void premultiply(ImageView<RGBA8> image, parallel::ThreadPool& pool = parallel::default_pool());
+
+    /// Premultiplied RGBA8 back to straight alpha, in place. Fully transparent pixels come out all 0.
+    void unpremultiply(ImageView<RGBA8> image, parallel::ThreadPool& pool = parallel::default_pool());
+
+}
+
+namespace ES::composite::Secret {
+
+    //the arithmetic the formulas are written against. Channels of 1 mean fully there
+    struct FloatMath {
+        using Channel = float;
+        static constexpr float one = 1.0f;
+        [[nodiscard]] static constexpr float mul(float a, float b) noexcept { return a * b; }
+        [[nodiscard]] static constexpr float mul_add(float a, float b, float c, float d) noexcept { return a * b + c * d; }
+    };
+
+    struct FixedMath {
+        using Channel = std::uint16_t;
+        static constexpr std::uint16_t one = 255;
+        //x / 255 rounded to nearest, exactly, for x up to 255 * 255
+        [[nodiscard]] static constexpr std::uint16_t div255(std::uint16_t x) noexcept {
+            const std::uint16_t t = static_cast<std::uint16_t>(x + 128);
+            return static_cast<std::uint16_t>((t + (t >> 8)) >> 8);
+        }
+        [[nodiscard]] static constexpr std::uint16_t mul(std::uint16_t a, std::uint16_t b) noexcept {
+            return div255(static_cast<std::uint16_t>(a * b));
+        }
+        //rounded once, not twice. Every use below has a <= c's alpha and b + d <= 255 or the like, so the sum stays
+        //within 255 * 255 for premultiplied input
+        [[nodiscard]] static constexpr std::uint16_t mul_add(std::uint16_t a, std::uint16_t b, std::uint16_t c, std::uint16_t d) noexcept {
+            return div255(static_cast<std::uint16_t>(a * b + c * d));
+        }
+    };
+
+    template <Blend mode, typename Math>
+    [[nodiscard]] constexpr typename Math::Channel mix(typename Math::Channel source, typename Math::Channel destination,
+                                                       typename Math::Channel source_alpha, typename Math::Channel destination_alpha) noexcept;
+
+    //how much of a source tile is there; transparent is every channel 0, not just alpha
+    enum class Coverage { transparent, opaque, mixed };
+
+    [[nodiscard]] Coverage coverage(ImageView<const RGBA> tile) noexcept;
+    [[nodiscard]] Coverage coverage(ImageView<const RGBA8> tile) noexcept;
+
+    template <Blend mode>
+    void blend_row(const RGBA* ES_RESTRICT source, RGBA* ES_RESTRICT destination, std::size_t width) noexcept;
+
+    template <Blend mode>
+    void blend_row(const RGBA8* ES_RESTRICT source, RGBA8* ES_RESTRICT destination, std::size_t width) noexcept;
+
+    //the whole image loop for one mode, tiles and fast paths included
+    template <Blend mode, typename Pixel>
+    void blend_tiles(ImageView<const Pixel> source, ImageView<Pixel> destination, parallel::ThreadPool& pool);
+
+}
+
+//DEFINITIONS
+
+template <ES::composite::Blend mode, typename Math>
+constexpr typename Math::Channel ES::composite::Secret::mix(const typename Math::Channel source, const typename Math::Channel destination,
+                                                            const typename Math::Channel source_alpha,
+                                                            const typename Math::Channel destination_alpha) noexcept {
+    using C = typename Math::Channel;
+    const C source_gone = static_cast<C>(Math::one - source_alpha);
+    const C destination_gone = static_cast<C>(Math::one - destination_alpha);
+    if constexpr (mode == Blend::over) {
+        return Math::mul_add(source, Math::one, destination, source_gone);
+    } else if constexpr (mode == Blend::in) {
+        return Math::mul(source, destination_alpha);
+    } else if constexpr (mode == Blend::out) {
+        return Math::mul(source, destination_gone);
+    } else if constexpr (mode == Blend::atop) {
+        return Math::mul_add(source, destination_alpha, destination, source_gone);
+    } else if constexpr (mode == Blend::exclusive_or) {
+        return Math::mul_add(source, destination_gone, destination, source_gone);
+    } else if constexpr (mode == Blend::add) {
+        return std::min(static_cast<C>(source + destination), Math::one);
+    } else if constexpr (mode == Blend::multiply) {
+        //s * d + s * (1 - da) + d * (1 - sa), folded to two products. On alpha it comes out as sa + da - sa * da
+        return Math::mul_add(source, static_cast<C>(destination_gone + destination), destination, source_gone);
+    } else {
+        return static_cast<C>(source + destination - Math::mul(source, destination));
+    }
+}
+
+constexpr ES::RGBA ES::composite::blend(const RGBA& source, const RGBA& destination, const Blend mode) noexcept {
+    RGBA result = destination;
+    const auto run = [&]<Blend m>() {
+        for (std::size_t c = 0; c < 4; c++) {
+            result[c] = Secret::mix<m, Secret::FloatMath>(source[c], destination[c], source.A(), destination.A());
+        }
+    };
+    switch (mode) {
+        case Blend::over: run.template operator()<Blend::over>(); break;
+        case Blend::in: run.template operator()<Blend::in>(); break;
+        case Blend::out: run.template operator()<Blend::out>(); break;
+        case Blend::atop: run.template operator()<Blend::atop>(); break;
+        case Blend::exclusive_or: run.template operator()<Blend::exclusive_or>(); break;
+        case Blend::add: run.template operator()<Blend::add>(); break;
+        case Blend::multiply: run.template operator()<Blend::multiply>(); break;
+        case Blend::screen: run.template operator()<Blend::screen>(); break;
+    }
+    return result;
+}
+
+constexpr ES::RGBA8 ES::composite::blend(const RGBA8& source, const RGBA8& destination, const Blend mode) noexcept {
+    RGBA8 result = destination;
+    const auto run = [&]<Blend m>() {
+        const auto one = [&](std::uint8_t s, std::uint8_t d) {
+            return static_cast<std::uint8_t>(Secret::mix<m, Secret::FixedMath>(s, d, source.A, destination.A));
+        };
+        result = RGBA8(one(source.R, destination.R), one(source.G, destination.G), one(source.B, destination.B), one(source.A, destination.A));
+    };
+    switch (mode) {
+        case Blend::over: run.template operator()<Blend::over>(); break;
+        case Blend::in: run.template operator()<Blend::in>(); break;
+        case Blend::out: run.template operator()<Blend::out>(); break;
+        case Blend::atop: run.template operator()<Blend::atop>(); break;
+        case Blend::exclusive_or: run.template operator()<Blend::exclusive_or>(); break;
+        case Blend::add: run.template operator()<Blend::add>(); break;
+        case Blend::multiply: run.template operator()<Blend::multiply>(); break;
+        case Blend::screen: run.template operator()<Blend::screen>(); break;
+    }
+    return result;
+}
+
+inline ES::composite::Secret::Coverage ES::composite::Secret::coverage(const ImageView<const RGBA> tile) noexcept {
+    bool all_opaque = true;
+    bool all_transparent = true;
+    for (std::size_t y = 0; y < tile.height(); y++) {
+        const RGBA* ES_RESTRICT row = tile.row_data(y);
+        for (std::size_t x = 0; x < tile.width(); x++) {
+            all_opaque &= row[x].A() >= 1.0f;
+            all_transparent &= (row[x].R() == 0.0f) & (row[x].G() == 0.0f) & (row[x].B() == 0.0f) & (row[x].A() <= 0.0f);
+        }
+        if (!all_opaque && !all_transparent) {
+            return Coverage::mixed;
+        }
+    }
+    return all_opaque ? Coverage::opaque : Coverage::transparent;
+}
+
+inline ES::composite::Secret::Coverage ES::composite::Secret::coverage(const ImageView<const RGBA8> tile) noexcept {
+    //AND of every alpha and OR of every byte: 255 is all opaque, 0 all transparent
+    std::uint8_t all = 0xff;
+    std::uint8_t any = 0;
+    for (std::size_t y = 0; y < tile.height(); y++) {
+        const RGBA8* ES_RESTRICT row = tile.row_data(y);
+        ES_VECTORIZE
+        for (std::size_t x = 0; x < tile.width(); x++) {
+            all &= row[x].A;
+            any |= row[x].R | row[x].G | row[x].B | row[x].A;
+        }
+        if (all != 0xff && any != 0) {
+            return Coverage::mixed;
+        }
+    }
+    return all == 0xff ? Coverage::opaque : Coverage::transparent;
+}
+
+template <ES::composite::Blend mode>
+void ES::composite::Secret::blend_row(const RGBA* ES_RESTRICT source, RGBA* ES_RESTRICT destination, const std::size_t width) noexcept {
+    ES_VECTORIZE
+    for (std::size_t x = 0; x < width; x++) {
+        const float source_alpha = source[x].A();
+        const float destination_alpha = destination[x].A();
+        for (std::size_t c = 0; c < 4; c++) {
+            destination[x][c] = mix<mode, FloatMath>(source[x][c], destination[x][c], source_alpha, destination_alpha);
+        }
+    }
+}
+
+template <ES::composite::Blend mode>
+void ES::composite::Secret::blend_row(const RGBA8* ES_RESTRICT source, RGBA8* ES_RESTRICT destination, const std::size_t width) noexcept {
+    //as bytes, four to a pixel, widened to 16 bits on the way in: a register holds a handful of pixels
+    static_assert(sizeof(RGBA8) == 4, "RGBA8 rows are R, G, B, A bytes");
+    const std::uint8_t* ES_RESTRICT from = reinterpret_cast<const std::uint8_t*>(source);
+    std::uint8_t* ES_RESTRICT to = reinterpret_cast<std::uint8_t*>(destination);
+    ES_VECTORIZE
+    for (std::size_t x = 0; x < width; x++) {
+        const std::uint16_t source_alpha = from[4 * x + 3];
+        const std::uint16_t destination_alpha = to[4 * x + 3];
+        for (std::size_t c = 0; c < 4; c++) {
+            to[4 * x + c] = static_cast<std::uint8_t>(mix<mode, FixedMath>(from[4 * x + c], to[4 * x + c], source_alpha, destination_alpha));
+        }
+    }
+}
+
+template <ES::composite::Blend mode, typename Pixel>
+void ES::composite::Secret::blend_tiles(const ImageView<const Pixel> source, const ImageView<Pixel> destination, parallel::ThreadPool& pool) {
+    destination.parallel_for_tiles(tile_size, tile_size, [&](std::size_t x, std::size_t y, ImageView<Pixel> tile) {
+        const ImageView<const Pixel> from = source.subview(x, y, tile.width(), tile.height());
+        const Coverage covered = coverage(from);
+        if (covered == Coverage::transparent) {
+            //only in and out look at the source where it isn't; both leave nothing
+            if constexpr (mode == Blend::in || mode == Blend::out) {
+                tile.fill(Pixel{});
+            }
+            return;
+        }
+        if (mode == Blend::over && covered == Coverage::opaque) {
+            from.copy_to(tile);
+            return;
+        }
+        for (std::size_t row = 0; row < tile.height(); row++) {
+            blend_row<mode>(from.row_data(row), tile.row_data(row), tile.width());
+        }
+    }, pool);
+}
+
+inline void ES::composite::blend(const ImageView<const RGBA> source, const ImageView<RGBA> destination, const Blend mode, parallel::ThreadPool& pool) {
+    assert(source.width() == destination.width() && source.height() == destination.height() && "composite::blend needs images the same size");
+    switch (mode) {
+        case Blend::over: Secret::blend_tiles<Blend::over>(source, destination, pool); break;
+        case Blend::in: Secret::blend_tiles<Blend::in>(source, destination, pool); break;
+        case Blend::out: Secret::blend_tiles<Blend::out>(source, destination, pool); break;
+        case Blend::atop: Secret::blend_tiles<Blend::atop>(source, destination, pool); break;
+        case Blend::exclusive_or: Secret::blend_tiles<Blend::exclusive_or>(source, destination, pool); break;
+        case Blend::add: Secret::blend_tiles<Blend::add>(source, destination, pool); break;
+        case Blend::multiply: Secret::blend_tiles<Blend::multiply>(source, destination, pool); break;
+        case Blend::screen: Secret::blend_tiles<Blend::screen>(source, destination, pool); break;
+    }
+}
+
+inline void ES::composite::blend(const ImageView<const RGBA8> source, const ImageView<RGBA8> destination, const Blend mode, parallel::ThreadPool& pool) {
+    assert(source.width() == destination.width() && source.height() == destination.height() && "composite::blend needs images the same size");
+    switch (mode) {
+        case Blend::over: Secret::blend_tiles<Blend::over>(source, destination, pool); break;
+        case Blend::in: Secret::blend_tiles<Blend::in>(source, destination, pool); break;
+        case Blend::out: Secret::blend_tiles<Blend::out>(source, destination, pool); break;
+        case Blend::atop: Secret::blend_tiles<Blend::atop>(source, destination, pool); break;
+        case Blend::exclusive_or: Secret::blend_tiles<Blend::exclusive_or>(source, destination, pool); break;
+        case Blend::add: Secret::blend_tiles<Blend::add>(source, destination, pool); break;
+        case Blend::multiply: Secret::blend_tiles<Blend::multiply>(source, destination, pool); break;
+        case Blend::screen: Secret::blend_tiles<Blend::screen>(source, destination, pool); break;
+    }
+}
+
+inline void ES::composite::premultiply(const ImageView<RGBA8> image, parallel::ThreadPool& pool) {
+    image.parallel_for_rows([](std::size_t, std::span<RGBA8> row) {
+        ES_VECTORIZE
+        for (RGBA8& p : row) {
+            const std::uint16_t a = p.A;
+            p = RGBA8(static_cast<std::uint8_t>(Secret::FixedMath::mul(p.R, a)), static_cast<std::uint8_t>(Secret::FixedMath::mul(p.G, a)),
+                      static_cast<std::uint8_t>(Secret::FixedMath::mul(p.B, a)), p.A);
+        }
+    }, default_row_grain, pool);
+}
+
+inline void ES::composite::unpremultiply(const ImageView<RGBA8> image, parallel::ThreadPool& pool) {
+    image.parallel_for_rows([](std::size_t, std::span<RGBA8> row) {
+        for (RGBA8& p : row) {
+            if (p.A == 0) {
+                p = RGBA8(0, 0, 0, 0);
+                continue;
+            }
+            const auto one = [a = p.A](std::uint8_t c) {
+                return static_cast<std::uint8_t>(std::min(255, (c * 255 + a / 2) / a));
+            };
+            p = RGBA8(one(p.R), one(p.G), one(p.B), p.A);
+        }
+    }, default_row_grain, pool);
+}
+
+#endif //COMPUTERGRAPHICS_ESCOMPOSITE_HPP
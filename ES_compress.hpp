@@ -0,0 +1,358 @@
+#ifndef COMPUTERGRAPHICS_ESCOMPRESS_HPP
+#define COMPUTERGRAPHICS_ESCOMPRESS_HPP
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <numbers>
+#include <span>
+#include "ES_math.hpp"
+#include "ES_simd.hpp"
+#include "Quaternion.hpp"
+
+/*
+ * Lossy codecs for unit Quaternion<float>, for when rotations are most of what you're storing (animation tracks,
+ * replays, network snapshots). Every codec is a tiny trivially copyable struct you can drop straight into a buffer,
+ * with encode / decode for one value and ES::compress::encode / decode for whole spans.
+ *
+ * The per value math is written branch free (selects, no ifs) on purpose, so the span versions, which just run it
+ * over structure-of-arrays lane batches, actually vectorize.
+ */
+
+//SIGNATURES AND FRIENDS
+namespace ES::compress {
+
+    /**
+     * @brief "Smallest three" quaternion codec: drop the largest component, store the other three.
+     *
+     * Since q and -q are the same rotation, the dropped component can always be made positive and rebuilt from
+     * the unit length. The remaining three sit inside [-1/sqrt2, 1/sqrt2], so every bit goes to useful range.
+     * Layout is 2 bits of index, then three `ComponentBits` wide unsigned fields, low bits first.
+     *
+     * @tparam ComponentBits bits per stored component
+     * @tparam Storage the unsigned integer (or word array) the bits live in
+     */
+    template <unsigned ComponentBits, typename Storage>
+    struct SmallestThree {
+        static_assert(2 + 3 * ComponentBits <= 64, "smallest three packs through a 64 bit word");
+
+        Storage bits{};
+
+        /// The most any decoded component can be off from the (sign aligned) original.
+        static constexpr float max_component_error = 3.0f * (std::numbers::sqrt2_v<float> / ((1u << ComponentBits) - 2)) * 0.5f + 1e-6f;
+
+        [[nodiscard]] static /* constexpr in c++26*/ SmallestThree encode(const Quaternion<float>& q) noexcept;
+        [[nodiscard]] /* constexpr in c++26*/ Quaternion<float> decode() const noexcept;
+    };
+
+    /// 4 bytes a rotation, 10 bits a component. Good enough for most bones, a quarter of the raw size.
+    using SmallestThree32 = SmallestThree<10, std::uint32_t>;
+    /// 6 bytes a rotation, 15 bits a component. The sweet spot for root motion and cameras.
+    using SmallestThree48 = SmallestThree<15, std::array<std::uint16_t, 3>>;
+    /// 8 bytes a rotation, 20 bits a component. Visually lossless even on long chains.
+    using SmallestThree64 = SmallestThree<20, std::uint64_t>;
+
+    /**
+     * @brief Axis-angle codec with the axis octahedrally encoded.
+     *
+     * The quaternion is flipped so w >= 0 (angle in [0, pi]), the unit axis is folded onto the octahedron and
+     * unwrapped into a square, so two numbers hold it with near uniform precision all over the sphere.
+     * Layout is the octahedral u, then v, then the angle, low bits first.
+     *
+     * @tparam AxisBits bits for each of the two octahedral coordinates
+     * @tparam AngleBits bits for the rotation angle
+     * @tparam Storage the unsigned integer (or word array) the bits live in
+     */
+    template <unsigned AxisBits, unsigned AngleBits, typename Storage>
+    struct OctahedralAxisAngle {
+        static_assert(2 * AxisBits + AngleBits <= 64, "octahedral axis-angle packs through a 64 bit word");
+
+        Storage bits{};
+
+        /// Worst case error of the decoded rotation angle alone, in radians.
+        static constexpr float max_angle_error = std::numbers::pi_v<float> / ((1u << AngleBits) - 1) * 0.5f + 1e-6f;
+
+        [[nodiscard]] static /* constexpr in c++26*/ OctahedralAxisAngle encode(const Quaternion<float>& q) noexcept;
+        [[nodiscard]] /* constexpr in c++26*/ Quaternion<float> decode() const noexcept;
+    };
+
+    /// 4 bytes a rotation: 11 + 11 bit axis, 10 bit angle.
+    using OctahedralAxisAngle32 = OctahedralAxisAngle<11, 10, std::uint32_t>;
+    /// 6 bytes a rotation: 16 + 16 bit axis, 16 bit angle.
+    using OctahedralAxisAngle48 = OctahedralAxisAngle<16, 16, std::array<std::uint16_t, 3>>;
+
+    /**
+     * @brief Encodes a whole span of unit quaternions.
+     * @param in the rotations, expected to be unit length
+     * @param out one codec value per rotation
+     */
+    template <typename Codec>
+    void encode(std::span<const Quaternion<float>> in, std::span<Codec> out) noexcept;
+
+    /**
+     * @brief Decodes a whole span back into quaternions.
+     * @param in the encoded rotations
+     * @param out one quaternion per encoded value
+     */
+    template <typename Codec>
+    void decode(std::span<const Codec> in, std::span<Quaternion<float>> out) noexcept;
+
+}
+
+namespace ES::compress::Secret {
+
+    //every codec funnels through a 64 bit word, these move it in and out of the actual storage
+    [[nodiscard]] constexpr std::uint64_t load_bits(std::uint32_t bits) noexcept { return bits; }
+    [[nodiscard]] constexpr std::uint64_t load_bits(std::uint64_t bits) noexcept { return bits; }
+    [[nodiscard]] constexpr std::uint64_t load_bits(const std::array<std::uint16_t, 3>& bits) noexcept {
+        return std::uint64_t{bits[0]} | (std::uint64_t{bits[1]} << 16) | (std::uint64_t{bits[2]} << 32);
+    }
+
+    constexpr void store_bits(std::uint32_t& bits, std::uint64_t word) noexcept { bits = static_cast<std::uint32_t>(word); }
+    constexpr void store_bits(std::uint64_t& bits, std::uint64_t word) noexcept { bits = word; }
+    constexpr void store_bits(std::array<std::uint16_t, 3>& bits, std::uint64_t word) noexcept {
+        bits[0] = static_cast<std::uint16_t>(word);
+        bits[1] = static_cast<std::uint16_t>(word >> 16);
+        bits[2] = static_cast<std::uint16_t>(word >> 32);
+    }
+
+    //std::sqrt and the trig functions may set errno, which keeps the span loops from vectorizing
+    [[nodiscard]] constexpr float sqrt(float x) noexcept {
+        return simd::select(x > 0.0f, x * simd::inverse_sqrt(x), 0.0f);
+    }
+
+    //atan2 for y, x >= 0, so [0, pi/2], to within an ulp or two. Cephes' atanf on the smaller over the larger
+    [[nodiscard]] constexpr float atan2_first_quadrant(float y, float x) noexcept {
+        const float big = std::max(x, y);
+        const float small = std::min(x, y);
+        const float t = simd::select(big > 0.0f, small / simd::select(big > 0.0f, big, 1.0f), 0.0f);
+        //past tan(pi/8) it's pi/4 plus the atan of what's left
+        const bool upper = t > 0.41421356237309504880f;
+        const float r = simd::select(upper, (t - 1.0f) / (t + 1.0f), t);
+        const float z = r * r;
+        float angle = (((8.05374449538e-2f * z - 1.38776856032e-1f) * z + 1.99777106478e-1f) * z - 3.33329491539e-1f) * z * r + r;
+        angle += simd::select(upper, std::numbers::pi_v<float> * 0.25f, 0.0f);
+        return simd::select(y > x, std::numbers::pi_v<float> * 0.5f - angle, angle);
+    }
+
+    //[lo, hi] onto [0, 2^Bits - 1], rounded to nearest
+    template <unsigned Bits>
+    [[nodiscard]] constexpr std::uint64_t quantize(float value, float lo, float hi) noexcept {
+        constexpr float steps = static_cast<float>((1u << Bits) - 1);
+        const float t = std::clamp((value - lo) / (hi - lo), 0.0f, 1.0f);
+        return static_cast<std::uint64_t>(t * steps + 0.5f);
+    }
+
+    template <unsigned Bits>
+    [[nodiscard]] constexpr float dequantize(std::uint64_t value, float lo, float hi) noexcept {
+        constexpr float inv_steps = 1.0f / static_cast<float>((1u << Bits) - 1);
+        return lo + static_cast<float>(value) * inv_steps * (hi - lo);
+    }
+
+    //[-bound, bound] onto [0, 2^Bits - 2]. Giving up the top code buys an exact zero in the middle,
+    //which is what keeps identity (and axis aligned) rotations exact through a round trip
+    template <unsigned Bits>
+    [[nodiscard]] constexpr std::uint64_t quantize_signed(float value, float bound) noexcept {
+        constexpr float half_steps = static_cast<float>((1u << (Bits - 1)) - 1);
+        const float t = std::clamp(value / bound, -1.0f, 1.0f);
+        return static_cast<std::uint64_t>(t * half_steps + half_steps + 0.5f);
+    }
+
+    template <unsigned Bits>
+    [[nodiscard]] constexpr float dequantize_signed(std::uint64_t value, float bound) noexcept {
+        constexpr float half_steps = static_cast<float>((1u << (Bits - 1)) - 1);
+        return (static_cast<float>(value) - half_steps) * (bound / half_steps);
+    }
+
+    template <unsigned ComponentBits>
+    [[nodiscard]] /* constexpr in c++26*/ inline std::uint64_t smallest_three_encode(float w, float x, float y, float z) noexcept {
+        constexpr float bound = std::numbers::sqrt2_v<float> * 0.5f;
+        const float aw = std::fabs(w), ax = std::fabs(x), ay = std::fabs(y), az = std::fabs(z);
+
+        //index of the largest magnitude, as a chain of selects
+        std::uint64_t index = 0;
+        float largest = aw;
+        float largest_signed = w;
+        index = ax > largest ? 1 : index; largest_signed = simd::select(ax > largest, x, largest_signed); largest = std::max(largest, ax);
+        index = ay > largest ? 2 : index; largest_signed = simd::select(ay > largest, y, largest_signed); largest = std::max(largest, ay);
+        index = az > largest ? 3 : index; largest_signed = simd::select(az > largest, z, largest_signed);
+
+        //flip the whole thing so the dropped component is positive
+        const float sign = simd::select(largest_signed < 0.0f, -1.0f, 1.0f);
+
+        //the three survivors, in order, skipping the dropped one
+        const float a = simd::select(index == 0, x, w) * sign;
+        const float b = simd::select(index <= 1, y, x) * sign;
+        const float c = simd::select(index <= 2, z, y) * sign;
+
+        return index
+             | (quantize_signed<ComponentBits>(a, bound) << 2)
+             | (quantize_signed<ComponentBits>(b, bound) << (2 + ComponentBits))
+             | (quantize_signed<ComponentBits>(c, bound) << (2 + 2 * ComponentBits));
+    }
+
+    template <unsigned ComponentBits>
+    /* constexpr in c++26*/ inline void smallest_three_decode(std::uint64_t word, float& w, float& x, float& y, float& z) noexcept {
+        constexpr float bound = std::numbers::sqrt2_v<float> * 0.5f;
+        constexpr std::uint64_t mask = (std::uint64_t{1} << ComponentBits) - 1;
+
+        const std::uint64_t index = word & 3;
+        const float a = dequantize_signed<ComponentBits>((word >> 2) & mask, bound);
+        const float b = dequantize_signed<ComponentBits>((word >> (2 + ComponentBits)) & mask, bound);
+        const float c = dequantize_signed<ComponentBits>((word >> (2 + 2 * ComponentBits)) & mask, bound);
+        const float largest = sqrt(1.0f - a * a - b * b - c * c);
+
+        w = simd::select(index == 0, largest, a);
+        x = simd::select(index == 0, a, simd::select(index == 1, largest, b));
+        y = simd::select(index <= 1, b, simd::select(index == 2, largest, c));
+        z = simd::select(index == 3, largest, c);
+    }
+
+    template <unsigned AxisBits, unsigned AngleBits>
+    [[nodiscard]] /* constexpr in c++26*/ inline std::uint64_t octahedral_encode(float w, float x, float y, float z) noexcept {
+        //w >= 0 keeps the angle in [0, pi]
+        const float sign = simd::select(w < 0.0f, -1.0f, 1.0f);
+        w *= sign; x *= sign; y *= sign; z *= sign;
+
+        //atan2 rather than acos(w), which throws away most of its precision for small angles
+        const float angle = 2.0f * atan2_first_quadrant(sqrt(x * x + y * y + z * z), w);
+
+        //no meaningful axis near the identity, any will do and +z folds onto the middle of the square
+        const float l1 = std::fabs(x) + std::fabs(y) + std::fabs(z);
+        const bool degenerate = l1 < 1e-12f;
+        const float inv_l1 = simd::select(degenerate, 0.0f, 1.0f / simd::select(degenerate, 1.0f, l1));
+        float u = x * inv_l1;
+        float v = y * inv_l1;
+        const float fz = simd::select(degenerate, 1.0f, z * inv_l1);
+
+        //lower hemisphere folds out over the diagonals
+        const float fold_u = (1.0f - std::fabs(v)) * simd::select(u >= 0.0f, 1.0f, -1.0f);
+        const float fold_v = (1.0f - std::fabs(u)) * simd::select(v >= 0.0f, 1.0f, -1.0f);
+        u = simd::select(fz < 0.0f, fold_u, u);
+        v = simd::select(fz < 0.0f, fold_v, v);
+
+        return quantize_signed<AxisBits>(u, 1.0f)
+             | (quantize_signed<AxisBits>(v, 1.0f) << AxisBits)
+             | (quantize<AngleBits>(angle, 0.0f, std::numbers::pi_v<float>) << (2 * AxisBits));
+    }
+
+    template <unsigned AxisBits, unsigned AngleBits>
+    /* constexpr in c++26*/ inline void octahedral_decode(std::uint64_t word, float& w, float& x, float& y, float& z) noexcept {
+        constexpr std::uint64_t axis_mask = (std::uint64_t{1} << AxisBits) - 1;
+        constexpr std::uint64_t angle_mask = (std::uint64_t{1} << AngleBits) - 1;
+
+        float u = dequantize_signed<AxisBits>(word & axis_mask, 1.0f);
+        float v = dequantize_signed<AxisBits>((word >> AxisBits) & axis_mask, 1.0f);
+        const float angle = dequantize<AngleBits>((word >> (2 * AxisBits)) & angle_mask, 0.0f, std::numbers::pi_v<float>);
+
+        const float fz = 1.0f - std::fabs(u) - std::fabs(v);
+        const float t = std::max(-fz, 0.0f);
+        u += simd::select(u >= 0.0f, -t, t);
+        v += simd::select(v >= 0.0f, -t, t);
+        //an octahedron point is never nearer the middle than 1/sqrt3
+        const float inv_len = simd::inverse_sqrt(u * u + v * v + fz * fz);
+
+        //the half angle is in [0, pi/2], well inside what the polynomial reduces exactly
+        float sine, cosine;
+        math::Secret::sincos_reduced(angle * 0.5f, sine, cosine);
+        const float s = sine * inv_len;
+        w = cosine;
+        x = u * s;
+        y = v * s;
+        z = fz * s;
+    }
+
+    template <typename Codec>
+    struct codec_traits;
+
+    template <unsigned ComponentBits, typename Storage>
+    struct codec_traits<SmallestThree<ComponentBits, Storage>> {
+        static std::uint64_t encode(float w, float x, float y, float z) noexcept { return smallest_three_encode<ComponentBits>(w, x, y, z); }
+        static void decode(std::uint64_t word, float& w, float& x, float& y, float& z) noexcept { smallest_three_decode<ComponentBits>(word, w, x, y, z); }
+    };
+
+    template <unsigned AxisBits, unsigned AngleBits, typename Storage>
+    struct codec_traits<OctahedralAxisAngle<AxisBits, AngleBits, Storage>> {
+        static std::uint64_t encode(float w, float x, float y, float z) noexcept { return octahedral_encode<AxisBits, AngleBits>(w, x, y, z); }
+        static void decode(std::uint64_t word, float& w, float& x, float& y, float& z) noexcept { octahedral_decode<AxisBits, AngleBits>(word, w, x, y, z); }
+    };
+}
+
+//DEFINITIONS
+
+template <unsigned ComponentBits, typename Storage>
+ES::compress::SmallestThree<ComponentBits, Storage> ES::compress::SmallestThree<ComponentBits, Storage>::encode(const Quaternion<float>& q) noexcept {
+    SmallestThree temp;
+    Secret::store_bits(temp.bits, Secret::smallest_three_encode<ComponentBits>(q.w(), q.x(), q.y(), q.z()));
+    return temp;
+}
+
+template <unsigned ComponentBits, typename Storage>
+ES::Quaternion<float> ES::compress::SmallestThree<ComponentBits, Storage>::decode() const noexcept {
+    Quaternion<float> temp;
+    Secret::smallest_three_decode<ComponentBits>(Secret::load_bits(bits), temp.w(), temp.x(), temp.y(), temp.z());
+    return temp;
+}
+
+template <unsigned AxisBits, unsigned AngleBits, typename Storage>
+ES::compress::OctahedralAxisAngle<AxisBits, AngleBits, Storage> ES::compress::OctahedralAxisAngle<AxisBits, AngleBits, Storage>::encode(const Quaternion<float>& q) noexcept {
+    OctahedralAxisAngle temp;
+    Secret::store_bits(temp.bits, Secret::octahedral_encode<AxisBits, AngleBits>(q.w(), q.x(), q.y(), q.z()));
+    return temp;
+}
+
+template <unsigned AxisBits, unsigned AngleBits, typename Storage>
+ES::Quaternion<float> ES::compress::OctahedralAxisAngle<AxisBits, AngleBits, Storage>::decode() const noexcept {
+    Quaternion<float> temp;
+    Secret::octahedral_decode<AxisBits, AngleBits>(Secret::load_bits(bits), temp.w(), temp.x(), temp.y(), temp.z());
+    return temp;
+}
+
+template <typename Codec>
+void ES::compress::encode(std::span<const Quaternion<float>> in, std::span<Codec> out) noexcept {
+    assert(out.size() >= in.size() && "encode needs one output slot per quaternion");
+    constexpr std::size_t W = simd::lanes<float>;
+    alignas(simd::register_bytes) std::array<float, W> w, x, y, z;
+    alignas(simd::register_bytes) std::array<std::uint64_t, W> words;
+
+    for (std::size_t i = 0; i < in.size(); i += W) {
+        const std::size_t count = std::min(W, in.size() - i);
+        for (std::size_t lane = 0; lane < W; ++lane) {
+            const Quaternion<float> q = lane < count ? in[i + lane] : Quaternion<float>::identity();
+            w[lane] = q.w(); x[lane] = q.x(); y[lane] = q.y(); z[lane] = q.z();
+        }
+        ES_VECTORIZE
+        for (std::size_t lane = 0; lane < W; ++lane) {
+            words[lane] = Secret::codec_traits<Codec>::encode(w[lane], x[lane], y[lane], z[lane]);
+        }
+        for (std::size_t lane = 0; lane < count; ++lane) {
+            Secret::store_bits(out[i + lane].bits, words[lane]);
+        }
+    }
+}
+
+template <typename Codec>
+void ES::compress::decode(std::span<const Codec> in, std::span<Quaternion<float>> out) noexcept {
+    assert(out.size() >= in.size() && "decode needs one output slot per encoded value");
+    constexpr std::size_t W = simd::lanes<float>;
+    alignas(simd::register_bytes) std::array<float, W> w, x, y, z;
+    alignas(simd::register_bytes) std::array<std::uint64_t, W> words;
+
+    for (std::size_t i = 0; i < in.size(); i += W) {
+        const std::size_t count = std::min(W, in.size() - i);
+        for (std::size_t lane = 0; lane < W; ++lane) {
+            words[lane] = lane < count ? Secret::load_bits(in[i + lane].bits) : 0;
+        }
+        ES_VECTORIZE
+        for (std::size_t lane = 0; lane < W; ++lane) {
+            Secret::codec_traits<Codec>::decode(words[lane], w[lane], x[lane], y[lane], z[lane]);
+        }
+        for (std::size_t lane = 0; lane < count; ++lane) {
+            out[i + lane] = Quaternion<float>(w[lane], x[lane], y[lane], z[lane]);
+        }
+    }
+}
+
+#endif //COMPUTERGRAPHICS_ESCOMPRESS_HPP
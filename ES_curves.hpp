@@ -0,0 +1,828 @@
+#ifndef COMPUTERGRAPHICS_ESCURVES_HPP
+#define COMPUTERGRAPHICS_ESCURVES_HPP
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <concepts>
+#include <cstddef>
+#include <span>
+#include <utility>
+#include <vector>
+#include "ES_math.hpp"
+#include "ES_simd.hpp"
+#include "VectorN.hpp"
+#include "PointN.hpp"
+#include "Quaternion.hpp"
+
+/*
+ * Cubic curves for camera rails, ball trails and the like. Every flavour (Bezier, Hermite, centripetal Catmull-Rom,
+ * uniform B-spline) is converted once into the same per component power basis, c0 + c1 t + c2 t^2 + c3 t^3, so there
+ * is exactly one evaluator to make fast: Horner per component, run over lane batches of t when there are many.
+ *
+ * Cubic is one segment on t in [0, 1]. Spline strings segments together on u in [0, segment_count], and keeps an
+ * arc length table (built on first use) for walking it at constant speed. QuaternionSpline is the same idea for
+ * orientations, on the same u.
+ */
+
+//SIGNATURES AND FRIENDS
+namespace ES::curves {
+
+    /// What a curve is made of: VectorN<T,N>, PointN<T,N>, anything with N floating point components behind [].
+    template <typename P>
+    concept Element = std::default_initializable<P> && std::floating_point<typename P::value_type> &&
+        requires(P p, const P cp, std::size_t i) {
+            { P::size() } -> std::convertible_to<std::size_t>;
+            { cp[i] } -> std::convertible_to<typename P::value_type>;
+            p[i] = typename P::value_type{};
+        };
+
+    /// Derivatives, and the tangents Hermite curves are built from, are always vectors.
+    template <Element P>
+    using Tangent = VectorN<typename P::value_type, P::size()>;
+
+    /// How many times flatten halves a segment at most, 2^16 pieces is already far past any sane tolerance.
+    inline constexpr std::size_t max_flatten_depth = 16;
+
+    /**
+     * @brief One cubic segment, t in [0, 1].
+     */
+    template <Element P>
+    class Cubic {
+    public:
+        using T = typename P::value_type;
+        static constexpr std::size_t N = P::size();
+
+        /// Power basis per component, p(t)[k] = c[k][0] + c[k][1] t + c[k][2] t^2 + c[k][3] t^3.
+        std::array<std::array<T, 4>, N> coefficients{};
+
+        /// Starts at p0, ends at p3, pulled towards p1 and p2.
+        [[nodiscard]] static constexpr Cubic bezier(const P& p0, const P& p1, const P& p2, const P& p3) noexcept;
+
+        /// From p0 leaving with velocity m0 to p1 arriving with velocity m1.
+        [[nodiscard]] static constexpr Cubic hermite(const P& p0, const Tangent<P>& m0, const P& p1, const Tangent<P>& m1) noexcept;
+
+        /**
+         * @brief The p1 to p2 stretch of a Catmull-Rom spline through p0..p3.
+         *
+         * Knots spaced by distance^alpha: 0 is the uniform spline, 0.5 the centripetal one (no cusps or self
+         * intersections within a segment, the one you want for cameras), 1 the chordal one.
+         */
+        [[nodiscard]] static /* constexpr in c++26*/ Cubic catmull_rom(const P& p0, const P& p1, const P& p2, const P& p3, T alpha = T(0.5)) noexcept;
+
+        /// One segment of a uniform cubic B-spline. C2 with its neighbours, but passes through none of the points.
+        [[nodiscard]] static constexpr Cubic bspline(const P& p0, const P& p1, const P& p2, const P& p3) noexcept;
+
+        [[nodiscard]] constexpr P evaluate(T t) const noexcept;
+        [[nodiscard]] constexpr Tangent<P> derivative(T t) const noexcept;
+        [[nodiscard]] constexpr Tangent<P> second_derivative(T t) const noexcept;
+
+        /// The same curve as four Bezier control points.
+        [[nodiscard]] constexpr std::array<P, 4> to_bezier() const noexcept;
+
+        /**
+         * @brief evaluate for a whole span of t, vectorized over t.
+         * @param out the same length as ts
+         */
+        void evaluate(std::span<const T> ts, std::span<P> out) const noexcept;
+
+        /**
+         * @brief out.size() points evenly spaced in t, first at t = 0, last at t = 1, by forward differencing.
+         *
+         * Three adds per component per point, no multiplies. The differences drift a few ulp per step, which is
+         * nothing at the thousands of points this is for, and the last point is pinned to the true end anyway.
+         */
+        constexpr void sample_uniform(std::span<P> out) const noexcept;
+
+        /**
+         * @brief Appends a polyline within tolerance of the curve to out.
+         *
+         * Subdivides the Bezier form until the control points are close enough to the chord that no point of the
+         * curve is further than tolerance from the polyline.
+         * @param include_start whether to append the t = 0 point, leave it out when continuing a previous polyline
+         */
+        void flatten(T tolerance, std::vector<P>& out, bool include_start = true, std::size_t max_depth = max_flatten_depth) const;
+    };
+
+    /**
+     * @brief Cubic segments end to end, u in [0, segment_count()], segment i covering [i, i + 1].
+     *
+     * The arc length functions build a table of cumulative lengths on first use and reuse it after, so the first
+     * call costs a pass over the curve. Like Transform's inverse, that first call is not safe to race, build it
+     * up front with build_arc_length_table when several threads share a spline.
+     */
+    template <Element P>
+    class Spline {
+    public:
+        using T = typename P::value_type;
+        static constexpr std::size_t N = P::size();
+
+        /// Table samples per segment unless build_arc_length_table says otherwise.
+        static constexpr std::size_t default_arc_length_samples = 32;
+
+        Spline() = default;
+        explicit Spline(std::vector<Cubic<P>> segments) : segments_(std::move(segments)) {}
+
+        /// A piecewise Bezier path, 3k + 1 points for k segments sharing their end points.
+        [[nodiscard]] static Spline bezier(std::span<const P> points);
+
+        /// Through every point with the given velocity at each, one tangent per point.
+        [[nodiscard]] static Spline hermite(std::span<const P> points, std::span<const Tangent<P>> tangents);
+
+        /// Through every point, n points for n - 1 segments. The missing outer neighbours are mirrored.
+        [[nodiscard]] static Spline catmull_rom(std::span<const P> points, T alpha = T(0.5));
+
+        /// Uniform B-spline, n points for n + 1 segments. The end points are tripled so it starts and ends on them.
+        [[nodiscard]] static Spline bspline(std::span<const P> points);
+
+        [[nodiscard]] std::size_t segment_count() const noexcept { return segments_.size(); }
+        [[nodiscard]] std::span<const Cubic<P>> segments() const noexcept { return segments_; }
+
+        /// u is clamped into [0, segment_count()].
+        [[nodiscard]] P evaluate(T u) const noexcept;
+        [[nodiscard]] Tangent<P> derivative(T u) const noexcept;
+
+        /**
+         * @brief evaluate for a whole span of u, lane batched: each lane gathers its own segment's coefficients.
+         * @param out the same length as us
+         */
+        void evaluate(std::span<const T> us, std::span<P> out) const noexcept;
+
+        /**
+         * @brief per_segment points for each segment plus the final end point, forward differenced.
+         * @param out exactly per_segment * segment_count() + 1 long
+         */
+        void sample_uniform(std::size_t per_segment, std::span<P> out) const noexcept;
+
+        /// Cubic::flatten over every segment into one polyline, shared end points appended once.
+        void flatten(T tolerance, std::vector<P>& out, std::size_t max_depth = max_flatten_depth) const;
+
+        /// (Re)builds the arc length table with samples_per_segment chords approximating each segment.
+        void build_arc_length_table(std::size_t samples_per_segment = default_arc_length_samples) const;
+
+        [[nodiscard]] T length() const;
+
+        /// The u at which the curve is distance along from its start, distance clamped into [0, length()].
+        [[nodiscard]] T parameter_at_distance(T distance) const;
+
+        [[nodiscard]] P evaluate_at_distance(T distance) const;
+
+        /// out.size() points evenly spaced along the curve by length, first and last on its ends.
+        void sample_by_distance(std::span<P> out) const;
+
+    private:
+        [[nodiscard]] std::size_t segment_of(T u) const noexcept;
+        void ensure_table() const;
+
+        std::vector<Cubic<P>> segments_;
+        mutable std::vector<T> cumulative_length_; //at table sample j, u = j / samples_per_segment_
+        mutable std::size_t samples_per_segment_ = 0;
+    };
+
+    /**
+     * @brief A smooth rotation through key orientations, u in [0, segment_count()] with whole u on the keys.
+     *
+     * Chaining slerps only matches the keys, the angular velocity jumps at every one of them. This is the cumulative
+     * form of a quaternion Bezier (Kim, Kim and Shin): segment i is
+     * `q_i exp(w1 b1(t)) exp(w2 b2(t)) exp(w3 b3(t))` with b the cumulative Bernstein polynomials, and the control
+     * rotations come from the averaged key tangent SQUAD uses, so the angular velocity is continuous through the keys.
+     * Every log is taken at construction. A sample is then three sincos and three quaternion products with no acos,
+     * which is what lets the batch evaluate run through the vectorized sincos polynomial.
+     *
+     * With only two keys it is exactly slerp.
+     */
+    template <math::float_or_double T>
+    class QuaternionSpline {
+    public:
+        QuaternionSpline() = default;
+
+        /// Through every key, at least two. Keys may sit in either hemisphere, each is flipped to the one nearest the last.
+        explicit QuaternionSpline(std::span<const Quaternion<T>> keys);
+
+        [[nodiscard]] std::size_t segment_count() const noexcept { return segments_.size(); }
+
+        /// u is clamped into [0, segment_count()].
+        [[nodiscard]] Quaternion<T> evaluate(T u) const noexcept;
+
+        /**
+         * @brief evaluate for a whole span of u, lane batched, in any order.
+         * @param out the same length as us
+         */
+        void evaluate(std::span<const T> us, std::span<Quaternion<T>> out) const noexcept;
+
+        /// out.size() rotations at evenly spaced u, the first and last on the end keys. One per frame for offline renders.
+        void sample_uniform(std::span<Quaternion<T>> out) const noexcept;
+
+    private:
+        //w x y z of the segment's start key, then the unit axis and half angle of each of w1, w2, w3
+        using Segment = std::array<T, 16>;
+
+        [[nodiscard]] std::size_t segment_of(T u) const noexcept;
+
+        std::vector<Segment> segments_;
+    };
+
+}
+
+namespace ES::curves::Secret {
+
+    template <Element P>
+    [[nodiscard]] constexpr P make(const std::array<typename P::value_type, P::size()>& components) noexcept {
+        P temp;
+        for (std::size_t k = 0; k < P::size(); k++) {
+            temp[k] = components[k];
+        }
+        return temp;
+    }
+
+    //power basis from four per component values and the rows of a basis matrix, result[k][j] = sum_i m[j][i] * g[i][k]
+    template <Element P, typename G0, typename G1, typename G2, typename G3>
+    [[nodiscard]] constexpr Cubic<P> from_basis(const std::array<std::array<typename P::value_type, 4>, 4>& m,
+                                                const G0& g0, const G1& g1, const G2& g2, const G3& g3) noexcept {
+        Cubic<P> temp;
+        for (std::size_t k = 0; k < P::size(); k++) {
+            for (std::size_t j = 0; j < 4; j++) {
+                temp.coefficients[k][j] = m[j][0] * g0[k] + m[j][1] * g1[k] + m[j][2] * g2[k] + m[j][3] * g3[k];
+            }
+        }
+        return temp;
+    }
+
+    template <Element P>
+    [[nodiscard]] constexpr typename P::value_type distance(const P& a, const P& b) noexcept {
+        typename P::value_type sum{0};
+        for (std::size_t k = 0; k < P::size(); k++) {
+            const auto d = a[k] - b[k];
+            sum += d * d;
+        }
+        return std::sqrt(sum);
+    }
+
+}
+
+//DEFINITIONS
+
+template <ES::curves::Element P>
+constexpr ES::curves::Cubic<P> ES::curves::Cubic<P>::bezier(const P& p0, const P& p1, const P& p2, const P& p3) noexcept {
+    constexpr std::array<std::array<T, 4>, 4> basis = {{
+        {T(1), T(0), T(0), T(0)},
+        {T(-3), T(3), T(0), T(0)},
+        {T(3), T(-6), T(3), T(0)},
+        {T(-1), T(3), T(-3), T(1)}}};
+    return Secret::from_basis<P>(basis, p0, p1, p2, p3);
+}
+
+template <ES::curves::Element P>
+constexpr ES::curves::Cubic<P> ES::curves::Cubic<P>::hermite(const P& p0, const Tangent<P>& m0, const P& p1, const Tangent<P>& m1) noexcept {
+    constexpr std::array<std::array<T, 4>, 4> basis = {{
+        {T(1), T(0), T(0), T(0)},
+        {T(0), T(1), T(0), T(0)},
+        {T(-3), T(-2), T(3), T(-1)},
+        {T(2), T(1), T(-2), T(1)}}};
+    return Secret::from_basis<P>(basis, p0, m0, p1, m1);
+}
+
+template <ES::curves::Element P>
+ES::curves::Cubic<P> ES::curves::Cubic<P>::catmull_rom(const P& p0, const P& p1, const P& p2, const P& p3, const T alpha) noexcept {
+    //knot gaps, with coincident points patched so nothing divides by zero
+    T d01 = std::pow(Secret::distance(p0, p1), alpha);
+    T d12 = std::pow(Secret::distance(p1, p2), alpha);
+    T d23 = std::pow(Secret::distance(p2, p3), alpha);
+    constexpr T tiny = T(1e-4);
+    d12 = d12 < tiny ? T(1) : d12;
+    d01 = d01 < tiny ? d12 : d01;
+    d23 = d23 < tiny ? d12 : d23;
+
+    //tangents at p1 and p2 of the non uniform spline (Barry-Goldman), rescaled from [t1, t2] onto [0, 1]
+    Tangent<P> m1, m2;
+    for (std::size_t k = 0; k < N; k++) {
+        m1[k] = d12 * ((p1[k] - p0[k]) / d01 - (p2[k] - p0[k]) / (d01 + d12) + (p2[k] - p1[k]) / d12);
+        m2[k] = d12 * ((p2[k] - p1[k]) / d12 - (p3[k] - p1[k]) / (d12 + d23) + (p3[k] - p2[k]) / d23);
+    }
+    return hermite(p1, m1, p2, m2);
+}
+
+template <ES::curves::Element P>
+constexpr ES::curves::Cubic<P> ES::curves::Cubic<P>::bspline(const P& p0, const P& p1, const P& p2, const P& p3) noexcept {
+    constexpr T sixth = T(1) / T(6);
+    constexpr std::array<std::array<T, 4>, 4> basis = {{
+        {sixth, T(4) * sixth, sixth, T(0)},
+        {T(-0.5), T(0), T(0.5), T(0)},
+        {T(0.5), T(-1), T(0.5), T(0)},
+        {-sixth, T(0.5), T(-0.5), sixth}}};
+    return Secret::from_basis<P>(basis, p0, p1, p2, p3);
+}
+
+template <ES::curves::Element P>
+constexpr P ES::curves::Cubic<P>::evaluate(const T t) const noexcept {
+    P temp;
+    for (std::size_t k = 0; k < N; k++) {
+        const auto& c = coefficients[k];
+        temp[k] = c[0] + t * (c[1] + t * (c[2] + t * c[3]));
+    }
+    return temp;
+}
+
+template <ES::curves::Element P>
+constexpr ES::curves::Tangent<P> ES::curves::Cubic<P>::derivative(const T t) const noexcept {
+    Tangent<P> temp;
+    for (std::size_t k = 0; k < N; k++) {
+        const auto& c = coefficients[k];
+        temp[k] = c[1] + t * (T(2) * c[2] + t * T(3) * c[3]);
+    }
+    return temp;
+}
+
+template <ES::curves::Element P>
+constexpr ES::curves::Tangent<P> ES::curves::Cubic<P>::second_derivative(const T t) const noexcept {
+    Tangent<P> temp;
+    for (std::size_t k = 0; k < N; k++) {
+        const auto& c = coefficients[k];
+        temp[k] = T(2) * c[2] + t * T(6) * c[3];
+    }
+    return temp;
+}
+
+template <ES::curves::Element P>
+constexpr std::array<P, 4> ES::curves::Cubic<P>::to_bezier() const noexcept {
+    std::array<P, 4> temp;
+    for (std::size_t k = 0; k < N; k++) {
+        const auto& c = coefficients[k];
+        temp[0][k] = c[0];
+        temp[1][k] = c[0] + c[1] / T(3);
+        temp[2][k] = c[0] + (T(2) * c[1] + c[2]) / T(3);
+        temp[3][k] = c[0] + c[1] + c[2] + c[3];
+    }
+    return temp;
+}
+
+template <ES::curves::Element P>
+void ES::curves::Cubic<P>::evaluate(const std::span<const T> ts, const std::span<P> out) const noexcept {
+    assert(ts.size() == out.size() && "Cubic::evaluate needs one output per t");
+    constexpr std::size_t W = simd::lanes<T>;
+    alignas(simd::register_bytes) std::array<T, W> t;
+    alignas(simd::register_bytes) std::array<std::array<T, W>, N> result;
+
+    for (std::size_t base = 0; base < ts.size(); base += W) {
+        const std::size_t n = std::min(W, ts.size() - base);
+        for (std::size_t lane = 0; lane < W; lane++) {
+            t[lane] = lane < n ? ts[base + lane] : T(0);
+        }
+        for (std::size_t k = 0; k < N; k++) {
+            const auto c = coefficients[k];
+            ES_VECTORIZE
+            for (std::size_t lane = 0; lane < W; lane++) {
+                result[k][lane] = c[0] + t[lane] * (c[1] + t[lane] * (c[2] + t[lane] * c[3]));
+            }
+        }
+        for (std::size_t lane = 0; lane < n; lane++) {
+            for (std::size_t k = 0; k < N; k++) {
+                out[base + lane][k] = result[k][lane];
+            }
+        }
+    }
+}
+
+template <ES::curves::Element P>
+constexpr void ES::curves::Cubic<P>::sample_uniform(const std::span<P> out) const noexcept {
+    if (out.empty()) {
+        return;
+    }
+    if (out.size() == 1) {
+        out[0] = evaluate(T(0));
+        return;
+    }
+    const T h = T(1) / static_cast<T>(out.size() - 1);
+    const T h2 = h * h, h3 = h2 * h;
+    for (std::size_t k = 0; k < N; k++) {
+        const auto& c = coefficients[k];
+        T value = c[0];
+        T first = c[1] * h + c[2] * h2 + c[3] * h3;
+        T second = T(2) * c[2] * h2 + T(6) * c[3] * h3;
+        const T third = T(6) * c[3] * h3;
+        for (std::size_t i = 0; i + 1 < out.size(); i++) {
+            out[i][k] = value;
+            value += first;
+            first += second;
+            second += third;
+        }
+        out.back()[k] = c[0] + c[1] + c[2] + c[3];
+    }
+}
+
+template <ES::curves::Element P>
+void ES::curves::Cubic<P>::flatten(const T tolerance, std::vector<P>& out, const bool include_start, const std::size_t max_depth) const {
+    assert(tolerance > T(0) && "Cubic::flatten needs a positive tolerance");
+    using Controls = std::array<std::array<T, N>, 4>;
+    const std::array<P, 4> bezier_points = to_bezier();
+    Controls start;
+    for (std::size_t i = 0; i < 4; i++) {
+        for (std::size_t k = 0; k < N; k++) {
+            start[i][k] = bezier_points[i][k];
+        }
+    }
+    if (include_start) {
+        out.push_back(bezier_points[0]);
+    }
+
+    //the usual conservative flatness bound: no point of the curve is further than sqrt(sum) / 4 from the chord
+    const T limit = T(16) * tolerance * tolerance;
+    auto flat_enough = [limit](const Controls& p) {
+        T sum{0};
+        for (std::size_t k = 0; k < N; k++) {
+            const T u = T(3) * p[1][k] - T(2) * p[0][k] - p[3][k];
+            const T v = T(3) * p[2][k] - p[0][k] - T(2) * p[3][k];
+            sum += std::max(u * u, v * v);
+        }
+        return sum <= limit;
+    };
+
+    //depth first with an explicit stack, left halves first so points come out in order
+    struct Piece { Controls p; std::size_t depth; };
+    std::vector<Piece> stack;
+    stack.reserve(max_depth + 1);
+    stack.push_back({start, 0});
+    while (!stack.empty()) {
+        const Piece piece = stack.back();
+        stack.pop_back();
+        if (piece.depth >= max_depth || flat_enough(piece.p)) {
+            out.push_back(Secret::make<P>(piece.p[3]));
+            continue;
+        }
+        //de Casteljau at one half
+        Controls left, right;
+        for (std::size_t k = 0; k < N; k++) {
+            const T p01 = (piece.p[0][k] + piece.p[1][k]) * T(0.5);
+            const T p12 = (piece.p[1][k] + piece.p[2][k]) * T(0.5);
+            const T p23 = (piece.p[2][k] + piece.p[3][k]) * T(0.5);
+            const T p012 = (p01 + p12) * T(0.5);
+            const T p123 = (p12 + p23) * T(0.5);
+            const T mid = (p012 + p123) * T(0.5);
+            left[0][k] = piece.p[0][k]; left[1][k] = p01; left[2][k] = p012; left[3][k] = mid;
+            right[0][k] = mid; right[1][k] = p123; right[2][k] = p23; right[3][k] = piece.p[3][k];
+        }
+        stack.push_back({right, piece.depth + 1});
+        stack.push_back({left, piece.depth + 1});
+    }
+}
+
+template <ES::curves::Element P>
+ES::curves::Spline<P> ES::curves::Spline<P>::bezier(const std::span<const P> points) {
+    assert(points.size() >= 4 && (points.size() - 1) % 3 == 0 && "Spline::bezier needs 3k + 1 points");
+    std::vector<Cubic<P>> segments;
+    segments.reserve(points.size() / 3);
+    for (std::size_t i = 0; i + 3 < points.size(); i += 3) {
+        segments.push_back(Cubic<P>::bezier(points[i], points[i + 1], points[i + 2], points[i + 3]));
+    }
+    return Spline(std::move(segments));
+}
+
+template <ES::curves::Element P>
+ES::curves::Spline<P> ES::curves::Spline<P>::hermite(const std::span<const P> points, const std::span<const Tangent<P>> tangents) {
+    assert(points.size() == tangents.size() && "Spline::hermite needs one tangent per point");
+    std::vector<Cubic<P>> segments;
+    segments.reserve(points.size());
+    for (std::size_t i = 0; i + 1 < points.size(); i++) {
+        segments.push_back(Cubic<P>::hermite(points[i], tangents[i], points[i + 1], tangents[i + 1]));
+    }
+    return Spline(std::move(segments));
+}
+
+template <ES::curves::Element P>
+ES::curves::Spline<P> ES::curves::Spline<P>::catmull_rom(const std::span<const P> points, const T alpha) {
+    assert(points.size() >= 2 && "Spline::catmull_rom needs at least two points");
+    const std::size_t n = points.size();
+    auto mirrored = [](const P& about, const P& away) {
+        P temp;
+        for (std::size_t k = 0; k < N; k++) {
+            temp[k] = T(2) * about[k] - away[k];
+        }
+        return temp;
+    };
+    const P before = mirrored(points[0], points[1]);
+    const P after = mirrored(points[n - 1], points[n - 2]);
+
+    std::vector<Cubic<P>> segments;
+    segments.reserve(n - 1);
+    for (std::size_t i = 0; i + 1 < n; i++) {
+        const P& p0 = i == 0 ? before : points[i - 1];
+        const P& p3 = i + 2 < n ? points[i + 2] : after;
+        segments.push_back(Cubic<P>::catmull_rom(p0, points[i], points[i + 1], p3, alpha));
+    }
+    return Spline(std::move(segments));
+}
+
+template <ES::curves::Element P>
+ES::curves::Spline<P> ES::curves::Spline<P>::bspline(const std::span<const P> points) {
+    assert(points.size() >= 2 && "Spline::bspline needs at least two points");
+    const std::size_t n = points.size();
+    //index -2 and -1 repeat the first point, n and n + 1 the last
+    auto at = [points, n](std::ptrdiff_t i) -> const P& {
+        return points[static_cast<std::size_t>(std::clamp<std::ptrdiff_t>(i, 0, static_cast<std::ptrdiff_t>(n) - 1))];
+    };
+    std::vector<Cubic<P>> segments;
+    segments.reserve(n + 1);
+    for (std::ptrdiff_t i = -2; i + 1 < static_cast<std::ptrdiff_t>(n); i++) {
+        segments.push_back(Cubic<P>::bspline(at(i), at(i + 1), at(i + 2), at(i + 3)));
+    }
+    return Spline(std::move(segments));
+}
+
+template <ES::curves::Element P>
+std::size_t ES::curves::Spline<P>::segment_of(const T u) const noexcept {
+    assert(!segments_.empty() && "Spline has no segments");
+    const T clamped = std::clamp(u, T(0), static_cast<T>(segments_.size()));
+    return std::min(static_cast<std::size_t>(clamped), segments_.size() - 1);
+}
+
+template <ES::curves::Element P>
+P ES::curves::Spline<P>::evaluate(const T u) const noexcept {
+    const std::size_t segment = segment_of(u);
+    const T t = std::clamp(u, T(0), static_cast<T>(segments_.size())) - static_cast<T>(segment);
+    return segments_[segment].evaluate(t);
+}
+
+template <ES::curves::Element P>
+ES::curves::Tangent<P> ES::curves::Spline<P>::derivative(const T u) const noexcept {
+    const std::size_t segment = segment_of(u);
+    const T t = std::clamp(u, T(0), static_cast<T>(segments_.size())) - static_cast<T>(segment);
+    return segments_[segment].derivative(t);
+}
+
+template <ES::curves::Element P>
+void ES::curves::Spline<P>::evaluate(const std::span<const T> us, const std::span<P> out) const noexcept {
+    assert(us.size() == out.size() && "Spline::evaluate needs one output per u");
+    constexpr std::size_t W = simd::lanes<T>;
+    alignas(simd::register_bytes) std::array<T, W> t;
+    alignas(simd::register_bytes) std::array<std::array<std::array<T, W>, 4>, N> c;
+    alignas(simd::register_bytes) std::array<std::array<T, W>, N> result;
+
+    alignas(simd::register_bytes) std::array<std::size_t, W> segment;
+
+    for (std::size_t base = 0; base < us.size(); base += W) {
+        const std::size_t n = std::min(W, us.size() - base);
+        bool one_segment = true;
+        for (std::size_t lane = 0; lane < W; lane++) {
+            const T u = lane < n ? us[base + lane] : us[base];
+            segment[lane] = segment_of(u);
+            t[lane] = std::clamp(u, T(0), static_cast<T>(segments_.size())) - static_cast<T>(segment[lane]);
+            one_segment &= segment[lane] == segment[0];
+        }
+        //sorted input (the usual case) mostly has every lane on one segment, which skips the gather entirely
+        if (one_segment) {
+            for (std::size_t k = 0; k < N; k++) {
+                const auto coefficients = segments_[segment[0]].coefficients[k];
+                ES_VECTORIZE
+                for (std::size_t lane = 0; lane < W; lane++) {
+                    result[k][lane] = coefficients[0] + t[lane] * (coefficients[1] + t[lane] * (coefficients[2] + t[lane] * coefficients[3]));
+                }
+            }
+        } else {
+            for (std::size_t lane = 0; lane < W; lane++) {
+                for (std::size_t k = 0; k < N; k++) {
+                    for (std::size_t j = 0; j < 4; j++) {
+                        c[k][j][lane] = segments_[segment[lane]].coefficients[k][j];
+                    }
+                }
+            }
+            for (std::size_t k = 0; k < N; k++) {
+                ES_VECTORIZE
+                for (std::size_t lane = 0; lane < W; lane++) {
+                    result[k][lane] = c[k][0][lane] + t[lane] * (c[k][1][lane] + t[lane] * (c[k][2][lane] + t[lane] * c[k][3][lane]));
+                }
+            }
+        }
+        for (std::size_t lane = 0; lane < n; lane++) {
+            for (std::size_t k = 0; k < N; k++) {
+                out[base + lane][k] = result[k][lane];
+            }
+        }
+    }
+}
+
+template <ES::curves::Element P>
+void ES::curves::Spline<P>::sample_uniform(const std::size_t per_segment, const std::span<P> out) const noexcept {
+    assert(per_segment > 0 && out.size() == per_segment * segments_.size() + 1 && "Spline::sample_uniform needs per_segment * segment_count() + 1 outputs");
+    for (std::size_t i = 0; i < segments_.size(); i++) {
+        //each segment writes its own end point too, which the next one then overwrites with the same point
+        segments_[i].sample_uniform(out.subspan(i * per_segment, per_segment + 1));
+    }
+}
+
+template <ES::curves::Element P>
+void ES::curves::Spline<P>::flatten(const T tolerance, std::vector<P>& out, const std::size_t max_depth) const {
+    for (std::size_t i = 0; i < segments_.size(); i++) {
+        segments_[i].flatten(tolerance, out, i == 0, max_depth);
+    }
+}
+
+template <ES::curves::Element P>
+void ES::curves::Spline<P>::build_arc_length_table(const std::size_t samples_per_segment) const {
+    assert(samples_per_segment > 0 && "Spline::build_arc_length_table needs at least one sample per segment");
+    samples_per_segment_ = samples_per_segment;
+    cumulative_length_.assign(segments_.size() * samples_per_segment + 1, T(0));
+    std::vector<P> samples(samples_per_segment + 1);
+    T total{0};
+    for (std::size_t i = 0; i < segments_.size(); i++) {
+        segments_[i].sample_uniform(samples);
+        for (std::size_t j = 1; j <= samples_per_segment; j++) {
+            total += Secret::distance(samples[j - 1], samples[j]);
+            cumulative_length_[i * samples_per_segment + j] = total;
+        }
+    }
+}
+
+template <ES::curves::Element P>
+void ES::curves::Spline<P>::ensure_table() const {
+    assert(!segments_.empty() && "Spline has no segments to measure");
+    if (samples_per_segment_ == 0) {
+        build_arc_length_table();
+    }
+}
+
+template <ES::curves::Element P>
+typename ES::curves::Spline<P>::T ES::curves::Spline<P>::length() const {
+    ensure_table();
+    return cumulative_length_.back();
+}
+
+template <ES::curves::Element P>
+typename ES::curves::Spline<P>::T ES::curves::Spline<P>::parameter_at_distance(const T distance) const {
+    ensure_table();
+    const T clamped = std::clamp(distance, T(0), cumulative_length_.back());
+    //first sample at or past the distance, then straight line between it and the one before
+    const auto it = std::lower_bound(cumulative_length_.begin() + 1, cumulative_length_.end() - 1, clamped);
+    const std::size_t j = static_cast<std::size_t>(it - cumulative_length_.begin());
+    const T before = cumulative_length_[j - 1];
+    const T span_length = cumulative_length_[j] - before;
+    const T fraction = span_length > T(0) ? (clamped - before) / span_length : T(0);
+    return (static_cast<T>(j - 1) + fraction) / static_cast<T>(samples_per_segment_);
+}
+
+template <ES::curves::Element P>
+P ES::curves::Spline<P>::evaluate_at_distance(const T distance) const {
+    return evaluate(parameter_at_distance(distance));
+}
+
+template <ES::curves::Element P>
+void ES::curves::Spline<P>::sample_by_distance(const std::span<P> out) const {
+    if (out.empty()) {
+        return;
+    }
+    ensure_table();
+    //the distances only go up, so one walk over the table serves them all instead of a search each
+    std::vector<T> us(out.size());
+    const T total = cumulative_length_.back();
+    const T step = out.size() > 1 ? total / static_cast<T>(out.size() - 1) : T(0);
+    std::size_t j = 1;
+    for (std::size_t i = 0; i < out.size(); i++) {
+        const T distance = i + 1 == out.size() ? total : step * static_cast<T>(i);
+        while (j + 1 < cumulative_length_.size() && cumulative_length_[j] < distance) {
+            j++;
+        }
+        const T before = cumulative_length_[j - 1];
+        const T span_length = cumulative_length_[j] - before;
+        const T fraction = span_length > T(0) ? std::clamp((distance - before) / span_length, T(0), T(1)) : T(0);
+        us[i] = (static_cast<T>(j - 1) + fraction) / static_cast<T>(samples_per_segment_);
+    }
+    evaluate(us, out);
+}
+
+template <ES::math::float_or_double T>
+ES::curves::QuaternionSpline<T>::QuaternionSpline(const std::span<const Quaternion<T>> keys) {
+    assert(keys.size() >= 2 && "QuaternionSpline needs at least two keys");
+    const std::size_t n = keys.size();
+    std::vector<Quaternion<T>> q(keys.begin(), keys.end());
+    for (std::size_t i = 1; i < n; i++) {
+        if (q[i].dot(q[i - 1]) < T(0)) {
+            q[i] = -q[i];
+        }
+    }
+
+    //the rotation from key i to key j in i's own frame, the keys are unit so the conjugate is the inverse
+    const auto relative = [&q](std::size_t i, std::size_t j) { return (q[i].conjugate() * q[j]).log(); };
+    //Catmull-Rom in log space, the missing outer neighbours mirrored
+    std::vector<VectorN<T, 3>> tangent(n);
+    for (std::size_t i = 0; i < n; i++) {
+        if (i == 0) {
+            tangent[i] = relative(0, 1);
+        } else if (i + 1 == n) {
+            tangent[i] = -relative(i, i - 1);
+        } else {
+            tangent[i] = (relative(i, i + 1) - relative(i, i - 1)) * T(0.5);
+        }
+    }
+
+    segments_.resize(n - 1);
+    for (std::size_t i = 0; i + 1 < n; i++) {
+        const VectorN<T, 3> w1 = tangent[i] / T(3);
+        const VectorN<T, 3> w3 = tangent[i + 1] / T(3);
+        const Quaternion<T> b1 = q[i] * Quaternion<T>::exp(w1);
+        const Quaternion<T> b2 = q[i + 1] * Quaternion<T>::exp(-w3);
+        Quaternion<T> middle = b1.conjugate() * b2;
+        //only when the two inner controls are over half a turn apart, which then ends the segment on -q[i + 1]
+        if (middle.w() < T(0)) {
+            middle = -middle;
+        }
+        const std::array<VectorN<T, 3>, 3> steps{w1, middle.log(), w3};
+
+        Segment& segment = segments_[i];
+        segment[0] = q[i].w(); segment[1] = q[i].x(); segment[2] = q[i].y(); segment[3] = q[i].z();
+        for (std::size_t k = 0; k < 3; k++) {
+            const T half_angle = steps[k].magnitude();
+            const T inverse = half_angle > T(0) ? T(1) / half_angle : T(0);
+            for (std::size_t c = 0; c < 3; c++) {
+                segment[4 + 4 * k + c] = steps[k][c] * inverse;
+            }
+            segment[4 + 4 * k + 3] = half_angle;
+        }
+    }
+}
+
+template <ES::math::float_or_double T>
+std::size_t ES::curves::QuaternionSpline<T>::segment_of(const T u) const noexcept {
+    assert(!segments_.empty() && "QuaternionSpline has no segments");
+    const T clamped = std::clamp(u, T(0), static_cast<T>(segments_.size()));
+    return std::min(static_cast<std::size_t>(clamped), segments_.size() - 1);
+}
+
+template <ES::math::float_or_double T>
+ES::Quaternion<T> ES::curves::QuaternionSpline<T>::evaluate(const T u) const noexcept {
+    const std::size_t index = segment_of(u);
+    const Segment& segment = segments_[index];
+    const T t = std::clamp(u, T(0), static_cast<T>(segments_.size())) - static_cast<T>(index);
+    const T s = T(1) - t;
+    const std::array<T, 3> basis{T(1) - s * s * s, t * t * (T(3) - T(2) * t), t * t * t};
+
+    Quaternion<T> q(segment[0], segment[1], segment[2], segment[3]);
+    for (std::size_t k = 0; k < 3; k++) {
+        const T* step = segment.data() + 4 + 4 * k;
+        const auto [sine, cosine] = math::sincos(step[3] * basis[k]);
+        q *= Quaternion<T>(cosine, step[0] * sine, step[1] * sine, step[2] * sine);
+    }
+    return q;
+}
+
+template <ES::math::float_or_double T>
+void ES::curves::QuaternionSpline<T>::evaluate(const std::span<const T> us, const std::span<Quaternion<T>> out) const noexcept {
+    assert(us.size() == out.size() && "QuaternionSpline::evaluate needs one output per u");
+    constexpr std::size_t W = simd::lanes<T>;
+    alignas(simd::register_bytes) std::array<T, W> t;
+    alignas(simd::register_bytes) std::array<std::array<T, W>, 16> g; //the Segment of each lane, transposed
+    alignas(simd::register_bytes) std::array<T, W> rw, rx, ry, rz;
+
+    for (std::size_t base = 0; base < us.size(); base += W) {
+        const std::size_t n = std::min(W, us.size() - base);
+        for (std::size_t lane = 0; lane < W; lane++) {
+            const T u = lane < n ? us[base + lane] : us[base];
+            const std::size_t index = segment_of(u);
+            t[lane] = std::clamp(u, T(0), static_cast<T>(segments_.size())) - static_cast<T>(index);
+            const Segment& segment = segments_[index];
+            for (std::size_t j = 0; j < 16; j++) {
+                g[j][lane] = segment[j];
+            }
+        }
+
+        ES_VECTORIZE
+        for (std::size_t lane = 0; lane < W; lane++) {
+            const T tt = t[lane];
+            const T s = T(1) - tt;
+            const T basis[3] = {T(1) - s * s * s, tt * tt * (T(3) - T(2) * tt), tt * tt * tt};
+            T qw = g[0][lane], qx = g[1][lane], qy = g[2][lane], qz = g[3][lane];
+            for (std::size_t k = 0; k < 3; k++) {
+                //the half angles stay under pi, well inside what the polynomial reduces exactly
+                T sine, cosine;
+                math::Secret::sincos_reduced(g[7 + 4 * k][lane] * basis[k], sine, cosine);
+                const T ex = g[4 + 4 * k][lane] * sine, ey = g[5 + 4 * k][lane] * sine, ez = g[6 + 4 * k][lane] * sine;
+                const T w = qw * cosine - qx * ex - qy * ey - qz * ez;
+                const T x = qw * ex + qx * cosine + qy * ez - qz * ey;
+                const T y = qw * ey - qx * ez + qy * cosine + qz * ex;
+                const T z = qw * ez + qx * ey - qy * ex + qz * cosine;
+                qw = w; qx = x; qy = y; qz = z;
+            }
+            rw[lane] = qw; rx[lane] = qx; ry[lane] = qy; rz[lane] = qz;
+        }
+
+        for (std::size_t lane = 0; lane < n; lane++) {
+            out[base + lane] = Quaternion<T>(rw[lane], rx[lane], ry[lane], rz[lane]);
+        }
+    }
+}
+
+template <ES::math::float_or_double T>
+void ES::curves::QuaternionSpline<T>::sample_uniform(const std::span<Quaternion<T>> out) const noexcept {
+    constexpr std::size_t block = 256;
+    std::array<T, block> us;
+    const T end = static_cast<T>(segments_.size());
+    const T step = out.size() > 1 ? end / static_cast<T>(out.size() - 1) : T(0);
+    for (std::size_t base = 0; base < out.size(); base += block) {
+        const std::size_t n = std::min(block, out.size() - base);
+        for (std::size_t i = 0; i < n; i++) {
+            us[i] = base + i + 1 == out.size() ? end : step * static_cast<T>(base + i);
+        }
+        evaluate(std::span<const T>(us.data(), n), out.subspan(base, n));
+    }
+}
+
+#endif //COMPUTERGRAPHICS_ESCURVES_HPP
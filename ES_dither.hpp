@@ -0,0 +1,451 @@
+#ifndef COMPUTERGRAPHICS_ESDITHER_HPP
+#define COMPUTERGRAPHICS_ESDITHER_HPP
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <thread>
+#include <vector>
+#include "ES_palette.hpp"
+#include "ES_parallel.hpp"
+#include "ES_srgb.hpp"
+#include "ColorN.hpp"
+#include "Image.hpp"
+
+/*
+ * Dithering float images down to 8 bit sRGB, and RGBA8 images down to a palette.
+ *
+ * Ordered dithering adds a threshold that depends only on the pixel's position, so every row is its own job: an 8x8
+ * Bayer matrix, or a 64x64 blue noise tile made once, on first use, by void and cluster (Ulichney) with a Gaussian of
+ * sigma 1.5 on the torus. Towards sRGB the threshold picks between the two codes either side of the linear value,
+ * in proportion to how close each is in linear light (srgb::to_srgb8_dithered), so a flat area averages to the right
+ * light; towards a palette it nudges the colour by up to half the mean distance between neighbouring entries before
+ * the k-d tree finds its nearest.
+ *
+ * Floyd-Steinberg pushes each pixel's error onto the pixels right of and below it. Left to right on every row, row
+ * y + 1 can start on a pixel once row y is two past it, so the rows are handed out in order to the pool's threads
+ * and each waits on its predecessor's progress, a wavefront down the image; the error rows live in a small ring,
+ * one reused only once the row that read it is done. The result is exactly what one thread makes. Serpentine
+ * Floyd-Steinberg, alternate rows right to left, doesn't have that slack (a row starts where the one above ended),
+ * so it runs on one thread.
+ */
+
+//SIGNATURES AND FRIENDS
+namespace ES::dither {
+
+    enum class Method {
+        none,                      ///< round to nearest
+        bayer,                     ///< 8x8 ordered
+        blue_noise,                ///< 64x64 blue noise ordered
+        floyd_steinberg,           ///< error diffusion, every row left to right; row pipelined across the pool
+        floyd_steinberg_serpentine ///< error diffusion, alternate rows right to left; one thread
+    };
+
+    inline constexpr std::size_t bayer_size = 8;
+    inline constexpr std::size_t blue_noise_size = 64;
+
+    /// The Bayer threshold at x, y (wrapping), in (0, 1).
+    [[nodiscard]] constexpr float bayer(std::size_t x, std::size_t y) noexcept;
+
+    /// The blue noise threshold at x, y (wrapping), in (0, 1). The first call makes the tile.
+    [[nodiscard]] float blue_noise(std::size_t x, std::size_t y) noexcept;
+
+    /// in, linear RGB, dithered to sRGB into out, which is the same size.
+    void to_srgb8(ImageView<const RGB> in, ImageView<RGB8> out, Method method, parallel::ThreadPool& pool = parallel::default_pool());
+
+    /// in, premultiplied linear RGBA, dithered to sRGB with straight alpha into out, which is the same size.
+    void to_srgb8(ImageView<const RGBA> in, ImageView<RGBA8> out, Method method, parallel::ThreadPool& pool = parallel::default_pool());
+
+    /// Each pixel of in as the index of a palette entry, dithered by method, into out, which is the same size. Up to 256 entries.
+    void to_palette(ImageView<const RGBA8> in, ImageView<std::uint8_t> out, std::span<const RGBA8> palette, Method method,
+                    parallel::ThreadPool& pool = parallel::default_pool());
+
+}
+
+namespace ES::dither::Secret {
+
+    //rows to a job: about 16K pixels, however wide the image
+    [[nodiscard]] inline std::size_t row_grain(std::size_t width) noexcept {
+        return std::max<std::size_t>(1, (std::size_t{1} << 14) / std::max<std::size_t>(1, width));
+    }
+
+    [[nodiscard]] std::vector<float> make_blue_noise();
+
+    [[nodiscard]] const std::vector<float>& blue_noise_tile();
+
+    //the ordered threshold at x, y for method, which is bayer or blue_noise
+    [[nodiscard]] float threshold(Method method, std::size_t x, std::size_t y) noexcept;
+
+    /*
+     * Floyd-Steinberg over a width x height image of N channel values. load(y, values) fills the N * width values
+     * row y wants to be; quantize(x, y, value) writes pixel x, y's output for the N values at value and overwrites them
+     * with what the output stands for. Serpentine runs on the calling thread; raster rows pipeline across pool.
+     */
+    template <std::size_t N, typename Load, typename Quantize>
+    void diffuse(std::size_t width, std::size_t height, bool serpentine, Load&& load, Quantize&& quantize, parallel::ThreadPool& pool);
+
+    //premultiplied linear to straight, colour 0 where alpha is
+    [[nodiscard]] std::array<float, 4> straight(const RGBA& colour) noexcept;
+
+    [[nodiscard]] std::uint8_t alpha8(float alpha, float threshold) noexcept;
+
+}
+
+//DEFINITIONS
+
+constexpr float ES::dither::bayer(std::size_t x, std::size_t y) noexcept {
+    x &= bayer_size - 1;
+    y &= bayer_size - 1;
+    //interleave the bits of x ^ y and y, lowest first, most significant in the result
+    std::size_t v = 0;
+    for (std::size_t bit = 0; bit < 3; bit++) {
+        v = (v << 2) | (((x ^ y) >> bit) & 1u) << 1 | ((y >> bit) & 1u);
+    }
+    return (static_cast<float>(v) + 0.5f) / static_cast<float>(bayer_size * bayer_size);
+}
+
+inline float ES::dither::blue_noise(const std::size_t x, const std::size_t y) noexcept {
+    return Secret::blue_noise_tile()[(y & (blue_noise_size - 1)) * blue_noise_size + (x & (blue_noise_size - 1))];
+}
+
+inline std::vector<float> ES::dither::Secret::make_blue_noise() {
+    constexpr std::size_t size = blue_noise_size;
+    constexpr std::size_t mask = size - 1;
+    constexpr std::size_t count = size * size;
+    constexpr float sigma = 1.5f;
+
+    std::vector<float> kernel(count);
+    for (std::size_t dy = 0; dy < size; dy++) {
+        for (std::size_t dx = 0; dx < size; dx++) {
+            const auto wx = static_cast<float>(std::min(dx, size - dx));
+            const auto wy = static_cast<float>(std::min(dy, size - dy));
+            kernel[dy * size + dx] = std::exp(-(wx * wx + wy * wy) / (2.0f * sigma * sigma));
+        }
+    }
+    //energy is every on pixel's kernel summed, kept up to date as pixels turn on and off
+    std::vector<float> energy(count, 0.0f);
+    std::vector<std::uint8_t> on(count, 0);
+    const auto toggle = [&](const std::size_t i) {
+        const float sign = on[i] ? -1.0f : 1.0f;
+        on[i] ^= 1u;
+        const std::size_t ix = i & mask;
+        const std::size_t iy = i / size;
+        for (std::size_t y = 0; y < size; y++) {
+            const float* k = kernel.data() + ((y - iy) & mask) * size;
+            float* e = energy.data() + y * size;
+            for (std::size_t x = 0; x < size; x++) {
+                e[x] += sign * k[(x - ix) & mask];
+            }
+        }
+    };
+    const auto tightest_cluster = [&] {
+        std::size_t best = count;
+        for (std::size_t i = 0; i < count; i++) {
+            best = on[i] && (best == count || energy[i] > energy[best]) ? i : best;
+        }
+        return best;
+    };
+    const auto largest_void = [&] {
+        std::size_t best = count;
+        for (std::size_t i = 0; i < count; i++) {
+            best = !on[i] && (best == count || energy[i] < energy[best]) ? i : best;
+        }
+        return best;
+    };
+
+    //a tenth of the pixels at random, then the tightest cluster moved to the largest void until that's a no-op
+    const std::size_t initial = count / 10;
+    std::uint32_t state = 0x9e3779b9u;
+    for (std::size_t placed = 0; placed < initial;) {
+        state = state * 1664525u + 1013904223u;
+        const std::size_t i = (state >> 8) % count;
+        if (!on[i]) {
+            toggle(i);
+            placed++;
+        }
+    }
+    for (std::size_t round = 0; round < count; round++) {
+        const std::size_t cluster = tightest_cluster();
+        toggle(cluster);
+        const std::size_t hole = largest_void();
+        toggle(hole);
+        if (hole == cluster) {
+            break;
+        }
+    }
+    const std::vector<std::uint8_t> prototype = on;
+    const std::vector<float> prototype_energy = energy;
+
+    //ranks below the prototype's size by taking its clusters away, the rest by filling voids
+    std::vector<std::size_t> rank(count);
+    for (std::size_t r = initial; r-- > 0;) {
+        const std::size_t cluster = tightest_cluster();
+        toggle(cluster);
+        rank[cluster] = r;
+    }
+    on = prototype;
+    energy = prototype_energy;
+    for (std::size_t r = initial; r < count; r++) {
+        const std::size_t hole = largest_void();
+        toggle(hole);
+        rank[hole] = r;
+    }
+
+    std::vector<float> tile(count);
+    for (std::size_t i = 0; i < count; i++) {
+        tile[i] = (static_cast<float>(rank[i]) + 0.5f) / static_cast<float>(count);
+    }
+    return tile;
+}
+
+inline const std::vector<float>& ES::dither::Secret::blue_noise_tile() {
+    static const std::vector<float> tile = make_blue_noise();
+    return tile;
+}
+
+inline float ES::dither::Secret::threshold(const Method method, const std::size_t x, const std::size_t y) noexcept {
+    return method == Method::bayer ? bayer(x, y) : blue_noise(x, y);
+}
+
+inline std::array<float, 4> ES::dither::Secret::straight(const RGBA& colour) noexcept {
+    if (!(colour.A() > 0.0f)) {
+        return {0.0f, 0.0f, 0.0f, 0.0f};
+    }
+    const float unpremultiply = 1.0f / colour.A();
+    return {colour.R() * unpremultiply, colour.G() * unpremultiply, colour.B() * unpremultiply, colour.A()};
+}
+
+inline std::uint8_t ES::dither::Secret::alpha8(const float alpha, const float threshold) noexcept {
+    return static_cast<std::uint8_t>(std::min(std::max(alpha * 255.0f + threshold, 0.0f), 255.0f));
+}
+
+template <std::size_t N, typename Load, typename Quantize>
+void ES::dither::Secret::diffuse(const std::size_t width, const std::size_t height, const bool serpentine, Load&& load, Quantize&& quantize,
+                                 parallel::ThreadPool& pool) {
+    if (width == 0 || height == 0) {
+        return;
+    }
+    const std::size_t workers = serpentine ? 1 : std::min(pool.size() + 1, height);
+    //error rows, a pixel of padding each side for what falls off the edges
+    const std::size_t ring = workers + 2;
+    const std::size_t stride = N * (width + 2);
+    std::vector<float> errors(ring * stride, 0.0f);
+    std::vector<std::atomic<std::size_t>> done(height);
+    std::atomic<std::size_t> next_row{0};
+
+    const auto run_row = [&](const std::size_t y, std::vector<float>& wanted) {
+        //the error buffer row y + 1 reads was last read by row y + 1 - ring
+        if (y + 1 >= ring) {
+            while (done[y + 1 - ring].load(std::memory_order_acquire) < width) {
+                std::this_thread::yield();
+            }
+        }
+        float* const incoming = errors.data() + (y % ring) * stride;
+        float* const outgoing = errors.data() + ((y + 1) % ring) * stride;
+        std::fill(outgoing, outgoing + stride, 0.0f);
+        load(y, wanted.data());
+
+        const bool forward = !serpentine || y % 2 == 0;
+        const std::size_t behind = serpentine ? width : 0;
+        std::size_t seen = y == 0 ? width : behind;
+        std::array<float, N> carry{};
+        for (std::size_t step = 0; step < width; step++) {
+            //row y - 1 has to have finished the pixels pushing error into this one: x - 1 to x + 1
+            const std::size_t needed = std::min(step + 2, width);
+            while (seen < needed) {
+                seen = done[y - 1].load(std::memory_order_acquire);
+                if (seen < needed) {
+                    std::this_thread::yield();
+                }
+            }
+            const std::size_t x = forward ? step : width - 1 - step;
+            const std::size_t at = N * (x + 1);
+            const std::size_t ahead = forward ? at + N : at - N;
+            const std::size_t back = forward ? at - N : at + N;
+            std::array<float, N> value;
+            for (std::size_t c = 0; c < N; c++) {
+                value[c] = wanted[N * x + c] + incoming[at + c] + carry[c];
+            }
+            std::array<float, N> got = value;
+            quantize(x, y, got.data());
+            for (std::size_t c = 0; c < N; c++) {
+                const float error = value[c] - got[c];
+                carry[c] = error * (7.0f / 16.0f);
+                outgoing[back + c] += error * (3.0f / 16.0f);
+                outgoing[at + c] += error * (5.0f / 16.0f);
+                outgoing[ahead + c] += error * (1.0f / 16.0f);
+            }
+            done[y].store(step + 1, std::memory_order_release);
+        }
+    };
+
+    parallel::for_chunks(workers, 1, [&](std::size_t, std::size_t) {
+        //rows are taken in order, so the lowest one unfinished never waits on anything and every wait ends
+        std::vector<float> wanted(N * width);
+        for (std::size_t y = next_row.fetch_add(1, std::memory_order_relaxed); y < height; y = next_row.fetch_add(1, std::memory_order_relaxed)) {
+            run_row(y, wanted);
+        }
+    }, pool);
+}
+
+inline void ES::dither::to_srgb8(const ImageView<const RGB> in, const ImageView<RGB8> out, const Method method, parallel::ThreadPool& pool) {
+    assert(in.width() == out.width() && in.height() == out.height() && "dither::to_srgb8 needs images the same size");
+    switch (method) {
+        case Method::none:
+            out.parallel_for_rows([&](std::size_t y, std::span<RGB8> row) {
+                const RGB* source = in.row_data(y);
+                for (std::size_t x = 0; x < row.size(); x++) {
+                    row[x] = RGB8(srgb::to_srgb8(source[x].R()), srgb::to_srgb8(source[x].G()), srgb::to_srgb8(source[x].B()));
+                }
+            }, Secret::row_grain(out.width()), pool);
+            break;
+        case Method::bayer:
+        case Method::blue_noise:
+            out.parallel_for_rows([&](std::size_t y, std::span<RGB8> row) {
+                const RGB* source = in.row_data(y);
+                for (std::size_t x = 0; x < row.size(); x++) {
+                    const float t = Secret::threshold(method, x, y);
+                    row[x] = RGB8(srgb::to_srgb8_dithered(source[x].R(), t), srgb::to_srgb8_dithered(source[x].G(), t),
+                                  srgb::to_srgb8_dithered(source[x].B(), t));
+                }
+            }, Secret::row_grain(out.width()), pool);
+            break;
+        case Method::floyd_steinberg:
+        case Method::floyd_steinberg_serpentine:
+            Secret::diffuse<3>(out.width(), out.height(), method == Method::floyd_steinberg_serpentine,
+                               [&](std::size_t y, float* values) {
+                                   const RGB* source = in.row_data(y);
+                                   for (std::size_t x = 0; x < in.width(); x++) {
+                                       values[3 * x] = source[x].R();
+                                       values[3 * x + 1] = source[x].G();
+                                       values[3 * x + 2] = source[x].B();
+                                   }
+                               },
+                               [&](std::size_t x, std::size_t y, float* value) {
+                                   RGB8& pixel = out.row_data(y)[x];
+                                   pixel = RGB8(srgb::to_srgb8(value[0]), srgb::to_srgb8(value[1]), srgb::to_srgb8(value[2]));
+                                   value[0] = srgb::to_linear(pixel.R);
+                                   value[1] = srgb::to_linear(pixel.G);
+                                   value[2] = srgb::to_linear(pixel.B);
+                               }, pool);
+            break;
+    }
+}
+
+inline void ES::dither::to_srgb8(const ImageView<const RGBA> in, const ImageView<RGBA8> out, const Method method, parallel::ThreadPool& pool) {
+    assert(in.width() == out.width() && in.height() == out.height() && "dither::to_srgb8 needs images the same size");
+    switch (method) {
+        case Method::none:
+        case Method::bayer:
+        case Method::blue_noise:
+            out.parallel_for_rows([&](std::size_t y, std::span<RGBA8> row) {
+                const RGBA* source = in.row_data(y);
+                for (std::size_t x = 0; x < row.size(); x++) {
+                    const std::array<float, 4> c = Secret::straight(source[x]);
+                    if (method == Method::none) {
+                        row[x] = RGBA8(srgb::to_srgb8(c[0]), srgb::to_srgb8(c[1]), srgb::to_srgb8(c[2]), Secret::alpha8(c[3], 0.5f));
+                        continue;
+                    }
+                    const float t = Secret::threshold(method, x, y);
+                    const std::uint8_t alpha = Secret::alpha8(c[3], t);
+                    row[x] = alpha == 0 ? RGBA8(0, 0, 0, 0)
+                                        : RGBA8(srgb::to_srgb8_dithered(c[0], t), srgb::to_srgb8_dithered(c[1], t),
+                                                srgb::to_srgb8_dithered(c[2], t), alpha);
+                }
+            }, Secret::row_grain(out.width()), pool);
+            break;
+        case Method::floyd_steinberg:
+        case Method::floyd_steinberg_serpentine:
+            Secret::diffuse<4>(out.width(), out.height(), method == Method::floyd_steinberg_serpentine,
+                               [&](std::size_t y, float* values) {
+                                   const RGBA* source = in.row_data(y);
+                                   for (std::size_t x = 0; x < in.width(); x++) {
+                                       const std::array<float, 4> c = Secret::straight(source[x]);
+                                       std::copy(c.begin(), c.end(), values + 4 * x);
+                                   }
+                               },
+                               [&](std::size_t x, std::size_t y, float* value) {
+                                   RGBA8& pixel = out.row_data(y)[x];
+                                   const std::uint8_t alpha = Secret::alpha8(value[3], 0.5f);
+                                   value[3] = alpha * (1.0f / 255.0f);
+                                   if (alpha == 0) {
+                                       //nothing shows, so there's no colour error to pass on
+                                       pixel = RGBA8(0, 0, 0, 0);
+                                       return;
+                                   }
+                                   pixel = RGBA8(srgb::to_srgb8(value[0]), srgb::to_srgb8(value[1]), srgb::to_srgb8(value[2]), alpha);
+                                   value[0] = srgb::to_linear(pixel.R);
+                                   value[1] = srgb::to_linear(pixel.G);
+                                   value[2] = srgb::to_linear(pixel.B);
+                               }, pool);
+            break;
+    }
+}
+
+inline void ES::dither::to_palette(const ImageView<const RGBA8> in, const ImageView<std::uint8_t> out, const std::span<const RGBA8> palette,
+                                   const Method method, parallel::ThreadPool& pool) {
+    assert(in.width() == out.width() && in.height() == out.height() && "dither::to_palette needs images the same size");
+    assert(!palette.empty() && palette.size() <= 256 && "dither::to_palette needs 1 to 256 palette entries");
+    std::vector<palette::Point> points(palette.size());
+    for (std::size_t i = 0; i < palette.size(); i++) {
+        points[i] = palette::point(palette[i]);
+    }
+    const palette::KdTree tree(points);
+
+    switch (method) {
+        case Method::none:
+        case Method::bayer:
+        case Method::blue_noise: {
+            //how far the threshold may push a colour: the mean distance from an entry to its nearest neighbour
+            float spread = 0.0f;
+            if (method != Method::none && points.size() > 1) {
+                for (std::size_t i = 0; i < points.size(); i++) {
+                    float nearest = std::numeric_limits<float>::infinity();
+                    for (std::size_t j = 0; j < points.size(); j++) {
+                        nearest = j != i ? std::min(nearest, palette::distance_squared(points[i], points[j])) : nearest;
+                    }
+                    spread += std::sqrt(nearest);
+                }
+                spread /= static_cast<float>(points.size());
+            }
+            out.parallel_for_rows([&](std::size_t y, std::span<std::uint8_t> row) {
+                const RGBA8* source = in.row_data(y);
+                for (std::size_t x = 0; x < row.size(); x++) {
+                    palette::Point p = palette::point(source[x]);
+                    if (method != Method::none) {
+                        const float offset = (Secret::threshold(method, x, y) - 0.5f) * spread;
+                        p[0] += offset;
+                        p[1] += offset;
+                        p[2] += offset;
+                    }
+                    row[x] = static_cast<std::uint8_t>(tree.nearest(p));
+                }
+            }, Secret::row_grain(out.width()), pool);
+            break;
+        }
+        case Method::floyd_steinberg:
+        case Method::floyd_steinberg_serpentine:
+            Secret::diffuse<4>(out.width(), out.height(), method == Method::floyd_steinberg_serpentine,
+                               [&](std::size_t y, float* values) {
+                                   const RGBA8* source = in.row_data(y);
+                                   for (std::size_t x = 0; x < in.width(); x++) {
+                                       const palette::Point p = palette::point(source[x]);
+                                       std::copy(p.begin(), p.end(), values + 4 * x);
+                                   }
+                               },
+                               [&](std::size_t x, std::size_t y, float* value) {
+                                   const std::size_t index = tree.nearest(palette::Point{value[0], value[1], value[2], value[3]});
+                                   out.row_data(y)[x] = static_cast<std::uint8_t>(index);
+                                   std::copy(points[index].begin(), points[index].end(), value);
+                               }, pool);
+            break;
+    }
+}
+
+#endif //COMPUTERGRAPHICS_ESDITHER_HPP
@@ -0,0 +1,618 @@
+#ifndef COMPUTERGRAPHICS_ESFILTER_HPP
+#define COMPUTERGRAPHICS_ESFILTER_HPP
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <span>
+#include <type_traits>
+#include <vector>
+#include "ES_parallel.hpp"
+#include "ES_simd.hpp"
+#include "ColorN.hpp"
+#include "Image.hpp"
+
+/*
+ * Convolution and blurs over float images: separable and general 2D kernels, box blur and a Gaussian made of three
+ * boxes.
+ *
+ * Work is split into tiles, and each tile starts by reading the block of source it depends on, the tile plus the
+ * filter's reach all round, into floats, the border rule deciding what lies past the image's edges. Everything after
+ * that is on the block: the horizontal passes shrink it in width, the vertical ones in height, until it is the tile.
+ * Tiles share nothing, so they go to the pool's threads in any order, and each thread keeps its buffers from one
+ * tile to the next. The kernel loops run along a row of channels, pixels one after another, so they vectorize across
+ * pixels and channels at once.
+ *
+ * A box blur keeps a running sum: one add and one subtract a pixel, however wide the box. Down, that's a whole row
+ * of sums moving a row at a time, which vectorizes like the kernel loops. Across, each pixel's sum waits on the
+ * last, so one pass walks the rows with only its N channels side by side; from two passes up the block is turned
+ * on its side instead, after the passes down, and the passes across become sums down columns too. Turning it costs
+ * about one serial pass. Three boxes one after the other come within a few percent of a Gaussian (Kovesi's widths),
+ * and the three passes run on the one block, so the border is applied once, to the image, as it would be for the
+ * real Gaussian.
+ * Under a sigma of 3 the boxes get too narrow to be much like one, and the real kernel is short enough to just use.
+ *
+ * Pixels are filtered as they are stored, so RGBA and LA are blurred premultiplied, which is what keeps transparent
+ * pixels from bleeding colour. Kernels are applied as laid out: weights[k] multiplies the pixel k - radius along,
+ * correlation, as most image libraries do; a symmetric kernel can't tell the difference.
+ */
+
+//SIGNATURES AND FRIENDS
+namespace ES::filter {
+
+    /// What a filter reads past the edge of the image.
+    enum class Border {
+        clamp,  ///< the edge pixel, repeated
+        wrap,   ///< the image, tiled
+        mirror, ///< the image reflected about its edge, edge pixel included
+        zero    ///< transparent black
+    };
+
+    /// A normalised Gaussian of sigma pixels, ceil(3 sigma) taps either side of the centre. Just the centre for sigma <= 0.
+    [[nodiscard]] std::vector<float> gaussian_kernel(float sigma);
+
+    /// Radii of the three boxes whose convolution is nearest a Gaussian of sigma pixels.
+    [[nodiscard]] std::array<std::size_t, 3> gaussian_boxes(float sigma) noexcept;
+
+    /**
+     * @brief in filtered by horizontal along rows and vertical down columns, into out, which is the same size.
+     *
+     * Both kernels have an odd number of weights, the middle one on the pixel being filtered. out must not overlap in.
+     */
+    void convolve_separable(ImageView<const RGB> in, ImageView<RGB> out, std::span<const float> horizontal, std::span<const float> vertical,
+                            Border border = Border::clamp, parallel::ThreadPool& pool = parallel::default_pool());
+    void convolve_separable(ImageView<const RGBA> in, ImageView<RGBA> out, std::span<const float> horizontal, std::span<const float> vertical,
+                            Border border = Border::clamp, parallel::ThreadPool& pool = parallel::default_pool());
+    void convolve_separable(ImageView<const LA> in, ImageView<LA> out, std::span<const float> horizontal, std::span<const float> vertical,
+                            Border border = Border::clamp, parallel::ThreadPool& pool = parallel::default_pool());
+
+    /**
+     * @brief in filtered by a 2D kernel into out, which is the same size.
+     *
+     * The kernel is an odd width and height, its middle weight on the pixel being filtered. out must not overlap in.
+     */
+    void convolve(ImageView<const RGB> in, ImageView<RGB> out, ImageView<const float> kernel, Border border = Border::clamp,
+                  parallel::ThreadPool& pool = parallel::default_pool());
+    void convolve(ImageView<const RGBA> in, ImageView<RGBA> out, ImageView<const float> kernel, Border border = Border::clamp,
+                  parallel::ThreadPool& pool = parallel::default_pool());
+    void convolve(ImageView<const LA> in, ImageView<LA> out, ImageView<const float> kernel, Border border = Border::clamp,
+                  parallel::ThreadPool& pool = parallel::default_pool());
+
+    /// The mean of the (2 radius_x + 1) x (2 radius_y + 1) box round each pixel of in, into out, which is the same size and doesn't overlap it.
+    void box_blur(ImageView<const RGB> in, ImageView<RGB> out, std::size_t radius_x, std::size_t radius_y, Border border = Border::clamp,
+                  parallel::ThreadPool& pool = parallel::default_pool());
+    void box_blur(ImageView<const RGBA> in, ImageView<RGBA> out, std::size_t radius_x, std::size_t radius_y, Border border = Border::clamp,
+                  parallel::ThreadPool& pool = parallel::default_pool());
+    void box_blur(ImageView<const LA> in, ImageView<LA> out, std::size_t radius_x, std::size_t radius_y, Border border = Border::clamp,
+                  parallel::ThreadPool& pool = parallel::default_pool());
+
+    /// in blurred by a Gaussian of sigma pixels, into out, which is the same size and doesn't overlap it. Three boxes from sigma 3 up.
+    void gaussian_blur(ImageView<const RGB> in, ImageView<RGB> out, float sigma, Border border = Border::clamp,
+                       parallel::ThreadPool& pool = parallel::default_pool());
+    void gaussian_blur(ImageView<const RGBA> in, ImageView<RGBA> out, float sigma, Border border = Border::clamp,
+                       parallel::ThreadPool& pool = parallel::default_pool());
+    void gaussian_blur(ImageView<const LA> in, ImageView<LA> out, float sigma, Border border = Border::clamp,
+                       parallel::ThreadPool& pool = parallel::default_pool());
+
+}
+
+namespace ES::filter::Secret {
+
+    template <typename Pixel>
+    inline constexpr std::size_t channels = std::is_same_v<Pixel, RGB> ? 3 : std::is_same_v<Pixel, RGBA> ? 4 : 2;
+
+    //the smallest tile, in pixels; tiles grow to twice the filter's reach so the margin is never most of the block
+    inline constexpr std::size_t tile_width = 256;
+    inline constexpr std::size_t tile_height = 64;
+
+    //the pixel index i reads along an axis of size pixels, or size for a zero border past the edge
+    [[nodiscard]] std::size_t address(std::ptrdiff_t i, std::size_t size, Border border) noexcept;
+
+    //a tile's filtered pixels, rows stride floats apart, or with turned its columns are
+    struct Result {
+        const float* data;
+        std::size_t stride;
+        bool turned = false;
+    };
+
+    //a thread's buffers, kept from tile to tile
+    struct Scratch {
+        std::vector<float> block;
+        std::vector<float> first;
+        std::vector<float> second;
+        std::vector<float> sums;
+    };
+
+    /*
+     * Every tile of out through filter(scratch, tile_w, tile_h), after loading the tile's block of in, reach_x and
+     * reach_y pixels of margin round it, into scratch.block as rows of (tile_w + 2 reach_x) * N floats. filter hands
+     * back where the tile_w x tile_h pixels of result are.
+     */
+    template <typename Pixel, typename Filter>
+    void run_tiles(ImageView<const Pixel> in, ImageView<Pixel> out, std::size_t reach_x, std::size_t reach_y, Border border, Filter&& filter,
+                   parallel::ThreadPool& pool);
+
+    //count values of each output row the sum over k of weights[k] times the input row's values k * step on
+    void correlate_rows(const float* in, std::size_t in_stride, float* out, std::size_t out_stride, std::size_t rows, std::size_t count,
+                        std::span<const float> weights, std::size_t step) noexcept;
+
+    //each output row the sum over k of weights[k] times input row y + k, rows of count values stride apart
+    void correlate_columns(const float* in, float* out, std::size_t stride, std::size_t rows_out, std::size_t count,
+                           std::span<const float> weights) noexcept;
+
+    //the mean of each 2 radius + 1 pixel run along rows of width_out + 2 radius pixels, N channels to a pixel
+    template <std::size_t N>
+    void box_rows(const float* in, std::size_t in_stride, float* out, std::size_t out_stride, std::size_t rows, std::size_t width_out,
+                  std::size_t radius) noexcept;
+
+    //rows of width pixels, N channels to a pixel, turned on their side: in's row y pixel x is out's row x pixel y
+    template <std::size_t N>
+    void transpose(const float* in, std::size_t in_stride, float* out, std::size_t out_stride, std::size_t rows, std::size_t width) noexcept;
+
+    //the mean of each 2 radius + 1 row run down rows_out + 2 radius rows of count values stride apart
+    void box_columns(const float* in, float* out, std::vector<float>& sums, std::size_t stride, std::size_t rows_out, std::size_t count,
+                     std::size_t radius) noexcept;
+
+    template <typename Pixel>
+    void convolve_separable(ImageView<const Pixel> in, ImageView<Pixel> out, std::span<const float> horizontal, std::span<const float> vertical,
+                            Border border, parallel::ThreadPool& pool);
+
+    template <typename Pixel>
+    void convolve(ImageView<const Pixel> in, ImageView<Pixel> out, ImageView<const float> kernel, Border border, parallel::ThreadPool& pool);
+
+    //box blurs one after another, each radius a pass along rows and one down columns
+    template <typename Pixel>
+    void boxes(ImageView<const Pixel> in, ImageView<Pixel> out, std::span<const std::size_t> radii_x, std::span<const std::size_t> radii_y,
+               Border border, parallel::ThreadPool& pool);
+
+    //below this sigma the boxes are too narrow to round into a Gaussian, and the real kernel is 19 taps at most
+    inline constexpr float exact_gaussian_below = 3.0f;
+
+    template <typename Pixel>
+    void gaussian_blur(ImageView<const Pixel> in, ImageView<Pixel> out, float sigma, Border border, parallel::ThreadPool& pool);
+
+}
+
+//DEFINITIONS
+
+inline std::vector<float> ES::filter::gaussian_kernel(const float sigma) {
+    if (!(sigma > 0.0f)) {
+        return {1.0f};
+    }
+    const auto radius = static_cast<std::size_t>(std::ceil(3.0f * sigma));
+    std::vector<float> weights(2 * radius + 1);
+    double total = 0.0;
+    for (std::size_t i = 0; i < weights.size(); i++) {
+        const double x = static_cast<double>(i) - static_cast<double>(radius);
+        const double w = std::exp(-x * x / (2.0 * static_cast<double>(sigma) * static_cast<double>(sigma)));
+        weights[i] = static_cast<float>(w);
+        total += w;
+    }
+    for (float& w : weights) {
+        w = static_cast<float>(w / total);
+    }
+    return weights;
+}
+
+inline std::array<std::size_t, 3> ES::filter::gaussian_boxes(const float sigma) noexcept {
+    if (!(sigma > 0.0f)) {
+        return {0, 0, 0};
+    }
+    //three boxes of odd widths low or low + 2, as many low as brings the variance nearest sigma^2 (Kovesi)
+    const double variance = static_cast<double>(sigma) * static_cast<double>(sigma);
+    auto low = static_cast<std::ptrdiff_t>(std::floor(std::sqrt(4.0 * variance + 1.0)));
+    low -= low % 2 == 0;
+    const double w = static_cast<double>(low);
+    const auto lows = std::clamp<std::ptrdiff_t>(std::llround((12.0 * variance - 3.0 * w * w - 12.0 * w - 9.0) / (-4.0 * w - 4.0)), 0, 3);
+    std::array<std::size_t, 3> radii{};
+    for (std::ptrdiff_t i = 0; i < 3; i++) {
+        radii[static_cast<std::size_t>(i)] = static_cast<std::size_t>((i < lows ? low : low + 2) - 1) / 2;
+    }
+    return radii;
+}
+
+inline std::size_t ES::filter::Secret::address(const std::ptrdiff_t i, const std::size_t size, const Border border) noexcept {
+    if (static_cast<std::size_t>(i) < size) {
+        return static_cast<std::size_t>(i);
+    }
+    const auto n = static_cast<std::ptrdiff_t>(size);
+    switch (border) {
+        case Border::clamp:
+            return static_cast<std::size_t>(std::clamp<std::ptrdiff_t>(i, 0, n - 1));
+        case Border::wrap: {
+            const std::ptrdiff_t r = i % n;
+            return static_cast<std::size_t>(r < 0 ? r + n : r);
+        }
+        case Border::mirror: {
+            std::ptrdiff_t r = i % (2 * n);
+            r = r < 0 ? r + 2 * n : r;
+            return static_cast<std::size_t>(r < n ? r : 2 * n - 1 - r);
+        }
+        case Border::zero:
+            return size;
+    }
+    return size;
+}
+
+template <typename Pixel, typename Filter>
+void ES::filter::Secret::run_tiles(const ImageView<const Pixel> in, const ImageView<Pixel> out, const std::size_t reach_x, const std::size_t reach_y,
+                                   const Border border, Filter&& filter, parallel::ThreadPool& pool) {
+    constexpr std::size_t N = channels<Pixel>;
+    assert(in.width() == out.width() && in.height() == out.height() && "filter needs images the same size");
+    if (out.empty()) {
+        return;
+    }
+    const std::size_t width = in.width();
+    const std::size_t height = in.height();
+    const std::size_t tile_w = std::max(tile_width, 2 * reach_x);
+    const std::size_t tile_h = std::max(tile_height, 2 * reach_y);
+    const std::size_t across = (width + tile_w - 1) / tile_w;
+    const std::size_t tiles = across * ((height + tile_h - 1) / tile_h);
+    std::atomic<std::size_t> next_tile{0};
+
+    parallel::for_chunks(std::min(pool.size() + 1, tiles), 1, [&](std::size_t, std::size_t) {
+        Scratch scratch;
+        for (std::size_t tile = next_tile.fetch_add(1, std::memory_order_relaxed); tile < tiles; tile = next_tile.fetch_add(1, std::memory_order_relaxed)) {
+            const std::size_t x0 = (tile % across) * tile_w;
+            const std::size_t y0 = (tile / across) * tile_h;
+            const std::size_t w = std::min(tile_w, width - x0);
+            const std::size_t h = std::min(tile_h, height - y0);
+            const std::size_t block_w = w + 2 * reach_x;
+            const std::size_t block_h = h + 2 * reach_y;
+            scratch.block.resize(block_w * block_h * N);
+
+            //columns left of the image's, in it, and right of it: only the first and last go through the border rule
+            const auto left = static_cast<std::ptrdiff_t>(x0) - static_cast<std::ptrdiff_t>(reach_x);
+            const std::size_t inside_begin = static_cast<std::size_t>(std::max<std::ptrdiff_t>(0, -left));
+            const std::size_t inside_end = std::min(block_w, static_cast<std::size_t>(static_cast<std::ptrdiff_t>(width) - left));
+            for (std::size_t r = 0; r < block_h; r++) {
+                float* ES_RESTRICT to = scratch.block.data() + r * block_w * N;
+                const std::size_t y = address(static_cast<std::ptrdiff_t>(y0 + r) - static_cast<std::ptrdiff_t>(reach_y), height, border);
+                if (y == height) {
+                    std::fill(to, to + block_w * N, 0.0f);
+                    continue;
+                }
+                const Pixel* from = in.row_data(y);
+                const auto load = [&](const std::size_t i, const std::size_t x) {
+                    for (std::size_t c = 0; c < N; c++) {
+                        to[i * N + c] = x == width ? 0.0f : from[x][c];
+                    }
+                };
+                for (std::size_t i = 0; i < inside_begin; i++) {
+                    load(i, address(left + static_cast<std::ptrdiff_t>(i), width, border));
+                }
+                for (std::size_t i = inside_begin; i < inside_end; i++) {
+                    load(i, static_cast<std::size_t>(left + static_cast<std::ptrdiff_t>(i)));
+                }
+                for (std::size_t i = inside_end; i < block_w; i++) {
+                    load(i, address(left + static_cast<std::ptrdiff_t>(i), width, border));
+                }
+            }
+
+            const Result result = filter(scratch, w, h);
+            //pixel i of row r is floats i * N + r * stride in, or r * N + i * stride turned
+            const std::size_t along = result.turned ? result.stride : N;
+            const std::size_t down = result.turned ? N : result.stride;
+            for (std::size_t r = 0; r < h; r++) {
+                Pixel* ES_RESTRICT to = out.row_data(y0 + r) + x0;
+                const float* ES_RESTRICT from = result.data + r * down;
+                for (std::size_t i = 0; i < w; i++) {
+                    for (std::size_t c = 0; c < N; c++) {
+                        to[i][c] = from[i * along + c];
+                    }
+                }
+            }
+        }
+    }, pool);
+}
+
+inline void ES::filter::Secret::correlate_rows(const float* const in, const std::size_t in_stride, float* const out, const std::size_t out_stride,
+                                               const std::size_t rows, const std::size_t count, const std::span<const float> weights,
+                                               const std::size_t step) noexcept {
+    for (std::size_t r = 0; r < rows; r++) {
+        float* ES_RESTRICT to = out + r * out_stride;
+        const float* ES_RESTRICT from = in + r * in_stride;
+        std::fill(to, to + count, 0.0f);
+        for (std::size_t k = 0; k < weights.size(); k++) {
+            const float w = weights[k];
+            const float* ES_RESTRICT tap = from + k * step;
+            ES_VECTORIZE
+            for (std::size_t i = 0; i < count; i++) {
+                to[i] += w * tap[i];
+            }
+        }
+    }
+}
+
+inline void ES::filter::Secret::correlate_columns(const float* const in, float* const out, const std::size_t stride, const std::size_t rows_out,
+                                                  const std::size_t count, const std::span<const float> weights) noexcept {
+    for (std::size_t y = 0; y < rows_out; y++) {
+        float* ES_RESTRICT to = out + y * stride;
+        std::fill(to, to + count, 0.0f);
+        for (std::size_t k = 0; k < weights.size(); k++) {
+            const float w = weights[k];
+            const float* ES_RESTRICT tap = in + (y + k) * stride;
+            ES_VECTORIZE
+            for (std::size_t i = 0; i < count; i++) {
+                to[i] += w * tap[i];
+            }
+        }
+    }
+}
+
+template <std::size_t N>
+void ES::filter::Secret::box_rows(const float* const in, const std::size_t in_stride, float* const out, const std::size_t out_stride,
+                                  const std::size_t rows, const std::size_t width_out, const std::size_t radius) noexcept {
+    const std::size_t span = 2 * radius + 1;
+    const float inverse = 1.0f / static_cast<float>(span);
+    for (std::size_t r = 0; r < rows; r++) {
+        const float* ES_RESTRICT from = in + r * in_stride;
+        float* ES_RESTRICT to = out + r * out_stride;
+        float sum[N] = {};
+        for (std::size_t k = 0; k < span; k++) {
+            for (std::size_t c = 0; c < N; c++) {
+                sum[c] += from[k * N + c];
+            }
+        }
+        for (std::size_t c = 0; c < N; c++) {
+            to[c] = sum[c] * inverse;
+        }
+        //the pixel coming into the box, less the one leaving it
+        for (std::size_t x = 1; x < width_out; x++) {
+            for (std::size_t c = 0; c < N; c++) {
+                sum[c] += from[(x + span - 1) * N + c] - from[(x - 1) * N + c];
+                to[x * N + c] = sum[c] * inverse;
+            }
+        }
+    }
+}
+
+template <std::size_t N>
+void ES::filter::Secret::transpose(const float* const in, const std::size_t in_stride, float* const out, const std::size_t out_stride,
+                                   const std::size_t rows, const std::size_t width) noexcept {
+    //a square at a time, so the rows read and the rows written both stay in cache
+    constexpr std::size_t square = 32;
+    for (std::size_t y0 = 0; y0 < rows; y0 += square) {
+        const std::size_t y1 = std::min(rows, y0 + square);
+        for (std::size_t x0 = 0; x0 < width; x0 += square) {
+            const std::size_t x1 = std::min(width, x0 + square);
+            for (std::size_t x = x0; x < x1; x++) {
+                float* ES_RESTRICT to = out + x * out_stride;
+                for (std::size_t y = y0; y < y1; y++) {
+                    const float* ES_RESTRICT from = in + y * in_stride + x * N;
+                    for (std::size_t c = 0; c < N; c++) {
+                        to[y * N + c] = from[c];
+                    }
+                }
+            }
+        }
+    }
+}
+
+inline void ES::filter::Secret::box_columns(const float* const in, float* const out, std::vector<float>& sums, const std::size_t stride,
+                                            const std::size_t rows_out, const std::size_t count, const std::size_t radius) noexcept {
+    const std::size_t span = 2 * radius + 1;
+    const float inverse = 1.0f / static_cast<float>(span);
+    sums.assign(count, 0.0f);
+    float* ES_RESTRICT sum = sums.data();
+    for (std::size_t k = 0; k < span; k++) {
+        const float* ES_RESTRICT from = in + k * stride;
+        ES_VECTORIZE
+        for (std::size_t i = 0; i < count; i++) {
+            sum[i] += from[i];
+        }
+    }
+    for (std::size_t y = 0; y < rows_out; y++) {
+        float* ES_RESTRICT to = out + y * stride;
+        if (y > 0) {
+            const float* ES_RESTRICT entering = in + (y + span - 1) * stride;
+            const float* ES_RESTRICT leaving = in + (y - 1) * stride;
+            ES_VECTORIZE
+            for (std::size_t i = 0; i < count; i++) {
+                sum[i] += entering[i] - leaving[i];
+            }
+        }
+        ES_VECTORIZE
+        for (std::size_t i = 0; i < count; i++) {
+            to[i] = sum[i] * inverse;
+        }
+    }
+}
+
+template <typename Pixel>
+void ES::filter::Secret::convolve_separable(const ImageView<const Pixel> in, const ImageView<Pixel> out, const std::span<const float> horizontal,
+                                            const std::span<const float> vertical, const Border border, parallel::ThreadPool& pool) {
+    constexpr std::size_t N = channels<Pixel>;
+    assert(horizontal.size() % 2 == 1 && vertical.size() % 2 == 1 && "filter::convolve_separable needs kernels an odd number of weights long");
+    const std::size_t reach_x = horizontal.size() / 2;
+    const std::size_t reach_y = vertical.size() / 2;
+    run_tiles(in, out, reach_x, reach_y, border, [&](Scratch& scratch, const std::size_t w, const std::size_t h) {
+        //across on every row of the block, then down; the rows keep the block's stride so both passes share it
+        const std::size_t stride = (w + 2 * reach_x) * N;
+        const std::size_t block_h = h + 2 * reach_y;
+        scratch.first.resize(stride * block_h);
+        correlate_rows(scratch.block.data(), stride, scratch.first.data(), w * N, block_h, w * N, horizontal, N);
+        scratch.second.resize(w * N * h);
+        correlate_columns(scratch.first.data(), scratch.second.data(), w * N, h, w * N, vertical);
+        return Result{scratch.second.data(), w * N};
+    }, pool);
+}
+
+template <typename Pixel>
+void ES::filter::Secret::convolve(const ImageView<const Pixel> in, const ImageView<Pixel> out, const ImageView<const float> kernel, const Border border,
+                                  parallel::ThreadPool& pool) {
+    constexpr std::size_t N = channels<Pixel>;
+    assert(kernel.width() % 2 == 1 && kernel.height() % 2 == 1 && "filter::convolve needs a kernel an odd number of weights wide and high");
+    const std::size_t reach_x = kernel.width() / 2;
+    const std::size_t reach_y = kernel.height() / 2;
+    run_tiles(in, out, reach_x, reach_y, border, [&](Scratch& scratch, const std::size_t w, const std::size_t h) {
+        const std::size_t stride = (w + 2 * reach_x) * N;
+        scratch.first.assign(w * N * h, 0.0f);
+        for (std::size_t y = 0; y < h; y++) {
+            float* ES_RESTRICT to = scratch.first.data() + y * w * N;
+            for (std::size_t j = 0; j < kernel.height(); j++) {
+                const float* weights = kernel.row_data(j);
+                const float* row = scratch.block.data() + (y + j) * stride;
+                for (std::size_t i = 0; i < kernel.width(); i++) {
+                    const float weight = weights[i];
+                    const float* ES_RESTRICT tap = row + i * N;
+                    ES_VECTORIZE
+                    for (std::size_t v = 0; v < w * N; v++) {
+                        to[v] += weight * tap[v];
+                    }
+                }
+            }
+        }
+        return Result{scratch.first.data(), w * N};
+    }, pool);
+}
+
+template <typename Pixel>
+void ES::filter::Secret::boxes(const ImageView<const Pixel> in, const ImageView<Pixel> out, const std::span<const std::size_t> radii_x,
+                               const std::span<const std::size_t> radii_y, const Border border, parallel::ThreadPool& pool) {
+    constexpr std::size_t N = channels<Pixel>;
+    std::size_t reach_x = 0;
+    std::size_t reach_y = 0;
+    for (const std::size_t r : radii_x) {
+        reach_x += r;
+    }
+    for (const std::size_t r : radii_y) {
+        reach_y += r;
+    }
+    const auto passes_x = std::count_if(radii_x.begin(), radii_x.end(), [](const std::size_t r) { return r > 0; });
+    run_tiles(in, out, reach_x, reach_y, border, [&](Scratch& scratch, const std::size_t w, const std::size_t h) {
+        //every pass leaves its rows at the block's stride, narrower or shorter each time, ping ponging two buffers
+        const std::size_t stride = (w + 2 * reach_x) * N;
+        const std::size_t block_h = h + 2 * reach_y;
+        scratch.first.resize(stride * block_h);
+        scratch.second.resize(stride * block_h);
+        const float* from = scratch.block.data();
+        float* to = scratch.first.data();
+        float* spare = scratch.second.data();
+        std::size_t width_now = w + 2 * reach_x;
+        std::size_t height_now = block_h;
+        if (passes_x > 1) {
+            //down first, the whole width of the block, then on its side it's width_now rows of h pixels
+            for (const std::size_t r : radii_y) {
+                if (r == 0) {
+                    continue;
+                }
+                height_now -= 2 * r;
+                box_columns(from, to, scratch.sums, stride, height_now, width_now * N, r);
+                from = to;
+                std::swap(to, spare);
+            }
+            const std::size_t turned = h * N;
+            transpose<N>(from, stride, to, turned, h, width_now);
+            from = to;
+            std::swap(to, spare);
+            for (const std::size_t r : radii_x) {
+                if (r == 0) {
+                    continue;
+                }
+                width_now -= 2 * r;
+                box_columns(from, to, scratch.sums, turned, width_now, turned, r);
+                from = to;
+                std::swap(to, spare);
+            }
+            return Result{from, turned, true};
+        }
+        for (const std::size_t r : radii_x) {
+            if (r == 0) {
+                continue;
+            }
+            width_now -= 2 * r;
+            box_rows<N>(from, stride, to, stride, block_h, width_now, r);
+            from = to;
+            std::swap(to, spare);
+        }
+        //the radii add up to the reach, so what's left is the tile, at the front of the first h rows
+        for (const std::size_t r : radii_y) {
+            if (r == 0) {
+                continue;
+            }
+            height_now -= 2 * r;
+            box_columns(from, to, scratch.sums, stride, height_now, w * N, r);
+            from = to;
+            std::swap(to, spare);
+        }
+        return Result{from, stride};
+    }, pool);
+}
+
+template <typename Pixel>
+void ES::filter::Secret::gaussian_blur(const ImageView<const Pixel> in, const ImageView<Pixel> out, const float sigma, const Border border,
+                                       parallel::ThreadPool& pool) {
+    if (sigma < exact_gaussian_below) {
+        const std::vector<float> kernel = gaussian_kernel(sigma);
+        convolve_separable(in, out, kernel, kernel, border, pool);
+        return;
+    }
+    const std::array<std::size_t, 3> radii = gaussian_boxes(sigma);
+    boxes(in, out, radii, radii, border, pool);
+}
+
+inline void ES::filter::convolve_separable(const ImageView<const RGB> in, const ImageView<RGB> out, const std::span<const float> horizontal,
+                                           const std::span<const float> vertical, const Border border, parallel::ThreadPool& pool) {
+    Secret::convolve_separable(in, out, horizontal, vertical, border, pool);
+}
+
+inline void ES::filter::convolve_separable(const ImageView<const RGBA> in, const ImageView<RGBA> out, const std::span<const float> horizontal,
+                                           const std::span<const float> vertical, const Border border, parallel::ThreadPool& pool) {
+    Secret::convolve_separable(in, out, horizontal, vertical, border, pool);
+}
+
+inline void ES::filter::convolve_separable(const ImageView<const LA> in, const ImageView<LA> out, const std::span<const float> horizontal,
+                                           const std::span<const float> vertical, const Border border, parallel::ThreadPool& pool) {
+    Secret::convolve_separable(in, out, horizontal, vertical, border, pool);
+}
+
+inline void ES::filter::convolve(const ImageView<const RGB> in, const ImageView<RGB> out, const ImageView<const float> kernel, const Border border,
+                                 parallel::ThreadPool& pool) {
+    Secret::convolve(in, out, kernel, border, pool);
+}
+
+inline void ES::filter::convolve(const ImageView<const RGBA> in, const ImageView<RGBA> out, const ImageView<const float> kernel, const Border border,
+                                 parallel::ThreadPool& pool) {
+    Secret::convolve(in, out, kernel, border, pool);
+}
+
+inline void ES::filter::convolve(const ImageView<const LA> in, const ImageView<LA> out, const ImageView<const float> kernel, const Border border,
+                                 parallel::ThreadPool& pool) {
+    Secret::convolve(in, out, kernel, border, pool);
+}
+
+inline void ES::filter::box_blur(const ImageView<const RGB> in, const ImageView<RGB> out, const std::size_t radius_x, const std::size_t radius_y,
+                                 const Border border, parallel::ThreadPool& pool) {
+    Secret::boxes(in, out, std::span<const std::size_t>(&radius_x, 1), std::span<const std::size_t>(&radius_y, 1), border, pool);
+}
+
+inline void ES::filter::box_blur(const ImageView<const RGBA> in, const ImageView<RGBA> out, const std::size_t radius_x, const std::size_t radius_y,
+                                 const Border border, parallel::ThreadPool& pool) {
+    Secret::boxes(in, out, std::span<const std::size_t>(&radius_x, 1), std::span<const std::size_t>(&radius_y, 1), border, pool);
+}
+
+inline void ES::filter::box_blur(const ImageView<const LA> in, const ImageView<LA> out, const std::size_t radius_x, const std::size_t radius_y,
+                                 const Border border, parallel::ThreadPool& pool) {
+    Secret::boxes(in, out, std::span<const std::size_t>(&radius_x, 1), std::span<const std::size_t>(&radius_y, 1), border, pool);
+}
+
+inline void ES::filter::gaussian_blur(const ImageView<const RGB> in, const ImageView<RGB> out, const float sigma, const Border border,
+                                      parallel::ThreadPool& pool) {
+    Secret::gaussian_blur(in, out, sigma, border, pool);
+}
+
+inline void ES::filter::gaussian_blur(const ImageView<const RGBA> in, const ImageView<RGBA> out, const float sigma, const Border border,
+                                      parallel::ThreadPool& pool) {
+    Secret::gaussian_blur(in, out, sigma, border, pool);
+}
+
+inline void ES::filter::gaussian_blur(const ImageView<const LA> in, const ImageView<LA> out, const float sigma, const Border border,
+                                      parallel::ThreadPool& pool) {
+    Secret::gaussian_blur(in, out, sigma, border, pool);
+}
+
+#endif //COMPUTERGRAPHICS_ESFILTER_HPP
@@ -0,0 +1,75 @@
+#ifndef COMPUTERGRAPHICS_ESIO_HPP
+#define COMPUTERGRAPHICS_ESIO_HPP
+
+#include <algorithm>
+#include <cerrno>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#if defined(_WIN32)
+    #include <io.h>
+#else
+    #include <unistd.h>
+#endif
+
+/*
+ * Where encoders put their bytes. An encoder hands a Sink finished pieces (a header, a band of rows, a trailer)
+ * straight out of wherever it built them, so writing to a file costs no copy on top of the encoding itself, and
+ * writing to memory costs the one append.
+ */
+
+//SIGNATURES AND FRIENDS
+namespace ES::io {
+
+    /// Anything that takes bytes in order: write(bytes) is false once it can't (disk full, closed pipe...).
+    template <typename Sink>
+    concept ByteSink = requires(Sink& sink, std::span<const std::uint8_t> bytes) {
+        { sink.write(bytes) } -> std::same_as<bool>;
+    };
+
+    /// Appends to a vector.
+    struct MemorySink {
+        std::vector<std::uint8_t>& bytes;
+
+        bool write(std::span<const std::uint8_t> data);
+    };
+
+    /// Writes to an open file descriptor (a file, a pipe, a socket), which stays open and is never seeked.
+    struct FileSink {
+        int descriptor;
+
+        bool write(std::span<const std::uint8_t> data) noexcept;
+    };
+
+}
+
+//DEFINITIONS
+
+inline bool ES::io::MemorySink::write(const std::span<const std::uint8_t> data) {
+    bytes.insert(bytes.end(), data.begin(), data.end());
+    return true;
+}
+
+inline bool ES::io::FileSink::write(std::span<const std::uint8_t> data) noexcept {
+    //a write may take only part of the data (pipes, signals), keep at it until it's all gone
+    while (!data.empty()) {
+#if defined(_WIN32)
+        const auto count = ::_write(descriptor, data.data(), static_cast<unsigned>(std::min<std::size_t>(data.size(), 1u << 30)));
+#else
+        const auto count = ::write(descriptor, data.data(), data.size());
+#endif
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data = data.subspan(static_cast<std::size_t>(count));
+    }
+    return true;
+}
+
+#endif //COMPUTERGRAPHICS_ESIO_HPP
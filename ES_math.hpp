@@ -1,6 +1,10 @@
 #pragma once
 #include <cmath>
+#include <cassert>
+#include <cstdint>
+#include <span>
 #include "ES_concepts.hpp"
+#include "ES_simd.hpp"
 #include <type_traits>
 #include <limits> //TODO: in house? To what end? I cry.
 
@@ -83,20 +87,28 @@ template <typename T> struct default_epsilon;
 
     /**
      * @brief A VERY well-behaved floating point floor function.
+     *
+     * No branches, just a truncating cast and selects, so a loop over it vectorizes.
      * @param[in] N that which shall be floored!
      * @tparam F a float or a double...
      */
     template <float_or_double F> [[nodiscard]] constexpr F floor(const F N) noexcept {
         //± 2^23 is where decimals die... fun fact: that immediately prior can support ±0.5. Anything above 2^24 jumps by two from then on...
-        static constexpr F NOMORE = 1LL << std::numeric_limits<F>::digits; //So, 2^Mantissa gives the exact point where decimals die.
-        if (absolute_value(N) >= NOMORE) return N; //long long is 2^64-1, yet the mantissa peters out at 2^23 or 2^52, so anything greater cannot have a decimal so it cannot floor.
+        constexpr F NOMORE = 1LL << std::numeric_limits<F>::digits; //So, 2^Mantissa gives the exact point where decimals die.
+        //the narrowest integer holding every F below NOMORE, int32 for floats is what lets SSE2 do the cast four at a time
+        using Integer = std::conditional_t<std::is_same_v<F, float>, std::int32_t, std::int64_t>;
+        //anything at or past NOMORE cannot have a decimal so it cannot floor (NaN fails the test too). Those get a
+        //harmless stand-in for the cast, as casting a floating point value an integral type cannot hold is UB!
+        const bool fractional_possible = (N < NOMORE) & (N > -NOMORE); //& rather than &&, short circuits are branches
+        const F safe = simd::select(fractional_possible, N, F{0});
         //positives truncate, which is identical to flooring.
         //Negatives truncate, so -3.9 becomes -3.0 instead of flooring which goes -3.9 -> -4.0.
-        //This is why we need to subtract that magic one. So it becomes -3.9 -> -3.0 -> -4.0.
-        const F trunk = static_cast<F>(static_cast<long long>(N)); //since we already removed all N > 2^52 or 2^23, we know it is less than 2^64, meaning we're golden to cast like this.
-                                                                                                    //as casting to an integral type whose limits are smaller than the current value of a floating point type is UB!
-        if (trunk == N) return N; // if we already were an integer, just return.
-        return trunk + (trunk < 0) * 1.f; //cheeky boolean math
+        //This is why we need to subtract that magic one whenever truncating went up. So it becomes -3.9 -> -3.0 -> -4.0.
+        //Done on the integer side, turning the comparison into an F first is enough for gcc to put a branch back in
+        const Integer trunk = static_cast<Integer>(safe);
+        const F floored = static_cast<F>(trunk - static_cast<Integer>(static_cast<F>(trunk) > safe)); //cheeky boolean math
+        //already an integer (or too big to be anything else) hands N straight back, which keeps -0.0 signed
+        return simd::select(fractional_possible & (static_cast<F>(trunk) != N), floored, N);
     }
 
     /**
@@ -116,7 +128,105 @@ template <typename T> struct default_epsilon;
     template<typename T> inline constexpr T half_pi  = T(1.57079632679489661923132169163975144L); 
 
 
+    /// Both halves of a sincos, named so nobody has to remember which way round a pair goes.
+    template <float_or_double F> struct SinCos {
+        F sin;
+        F cos;
+    };
+
+    namespace Secret {
+        //pi/2 split in three (Cody-Waite) so q * part stays exact, and the |x| past which that stops being true
+        template <float_or_double F> struct sincos_constants;
+        template <> struct sincos_constants<float> {
+            static constexpr float pio2_1 = 1.5703125f;
+            static constexpr float pio2_2 = 4.837512969970703125e-4f;
+            static constexpr float pio2_3 = 7.54978995489188216e-8f;
+            static constexpr float reduction_limit = 8192.0f;
+        };
+        template <> struct sincos_constants<double> {
+            static constexpr double pio2_1 = 1.57079625129699707031e0;
+            static constexpr double pio2_2 = 7.54978941586159635335e-8;
+            static constexpr double pio2_3 = 5.39030285815811905290e-15;
+            static constexpr double reduction_limit = 1073741824.0;
+        };
+
+        /**
+         * @brief sin and cos of x off one range reduction, without a single branch so it vectorizes.
+         *
+         * Reduces to r in [-pi/4, pi/4] and a quadrant q, runs the Cephes minimax polynomials for both, then
+         * swaps and negates by quadrant with selects. Only good for |x| up to sincos_constants::reduction_limit,
+         * anything past it (inf and NaN included) comes back as the sin and cos of 0 for the caller to redo.
+         */
+        template <float_or_double F> constexpr void sincos_reduced(const F x, F& sine, F& cosine) noexcept {
+            using C = sincos_constants<F>;
+            using I = std::conditional_t<std::is_same_v<F, float>, std::int32_t, std::int64_t>;
+            //same as floor: casting a value the integer can't hold is UB, so out of range lanes reduce a stand-in 0
+            const bool in_range = (x <= C::reduction_limit) & (x >= -C::reduction_limit); //NaN fails both
+            const F safe = simd::select(in_range, x, F{0});
+            const F y = safe * F(0.63661977236758134307553505349005744L); //2/pi
+            const I q = static_cast<I>(y + simd::select(y >= F{0}, F{0.5}, F{-0.5}));
+            const F qf = static_cast<F>(q);
+            const F r = ((safe - qf * C::pio2_1) - qf * C::pio2_2) - qf * C::pio2_3;
+            const F z = r * r;
+
+            F s, c;
+            if constexpr (std::is_same_v<F, float>) {
+                s = r + r * z * (-1.6666654611e-1f + z * (8.3321608736e-3f + z * -1.9515295891e-4f));
+                c = 1.0f - 0.5f * z + z * z * (4.166664568298827e-2f + z * (-1.388731625493765e-3f + z * 2.443315711809948e-5f));
+            } else {
+                s = r + r * z * (-1.66666666666666307295e-1 + z * (8.33333333332211858878e-3 + z * (-1.98412698295895385996e-4
+                      + z * (2.75573136213857245213e-6 + z * (-2.50507477628578072866e-8 + z * 1.58962301576546568060e-10)))));
+                c = 1.0 - 0.5 * z + z * z * (4.16666666666665929218e-2 + z * (-1.38888888888730564116e-3 + z * (2.48015872888517045348e-5
+                      + z * (-2.75573141792967388112e-7 + z * (2.08757008419747316778e-9 + z * -1.13585365213876817300e-11)))));
+            }
+
+            //quadrant 1 and 3 swap sin and cos, 2 and 3 negate sin, 1 and 2 negate cos
+            const F swapped_sin = simd::select((q & 1) != 0, c, s);
+            const F swapped_cos = simd::select((q & 1) != 0, s, c);
+            sine = simd::select((q & 2) != 0, -swapped_sin, swapped_sin);
+            cosine = simd::select(((q + 1) & 2) != 0, -swapped_cos, swapped_cos);
+        }
+    }
 
-    
+    /**
+     * @brief sin and cos of the same angle.
+     * @param x the angle in radians
+     * @note One at a time the library's own sincos (which gcc and clang fuse this pair into) beats the polynomial
+     * below, so this is only a name for it. The span overload is where the vectorized polynomial pays off.
+     */
+    template <float_or_double F> [[nodiscard]] /* constexpr in c++26*/ SinCos<F> sincos(const F x) noexcept {
+        return {std::sin(x), std::cos(x)};
+    }
+
+    /**
+     * @brief sincos over a whole stream, vectorized.
+     *
+     * Agrees with the scalar version to within a couple of ulp. Past ~8e3 (float) or ~1e9 (double) radians the
+     * polynomial's range reduction runs out of bits and those angles go through std::sin/std::cos instead.
+     * @param x angles in radians
+     * @param sin_out,cos_out the same length as x, either may alias it
+     */
+    template <float_or_double F> void sincos(std::span<const F> x, std::span<F> sin_out, std::span<F> cos_out) noexcept {
+        assert(x.size() == sin_out.size() && x.size() == cos_out.size() && "sincos needs one sin and one cos slot per angle");
+        ES_VECTORIZE
+        for (std::size_t i = 0; i < x.size(); i++) {
+            const F angle = x[i];
+            F s, c;
+            Secret::sincos_reduced(angle, s, c);
+            //lanes the polynomial can't handle park the angle itself in both outputs, whichever one aliases x
+            const bool out_of_range = !(std::fabs(angle) <= Secret::sincos_constants<F>::reduction_limit);
+            sin_out[i] = simd::select(out_of_range, angle, s);
+            cos_out[i] = simd::select(out_of_range, angle, c);
+        }
+        //rare enough that a second scalar pass is fine, and scanning for them costs next to nothing next to the polynomials.
+        //A real sin never exceeds 1, so anything bigger is a parked angle
+        for (std::size_t i = 0; i < x.size(); i++) {
+            const F angle = sin_out[i];
+            if (!(std::fabs(angle) <= Secret::sincos_constants<F>::reduction_limit)) {
+                sin_out[i] = std::sin(angle);
+                cos_out[i] = std::cos(angle);
+            }
+        }
+    }
 
 }
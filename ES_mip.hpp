@@ -0,0 +1,401 @@
+#ifndef COMPUTERGRAPHICS_ESMIP_HPP
+#define COMPUTERGRAPHICS_ESMIP_HPP
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <new>
+#include <span>
+#include <vector>
+#include "ES_color.hpp"
+#include "ES_parallel.hpp"
+#include "ES_resample.hpp"
+#include "ES_simd.hpp"
+#include "ColorN.hpp"
+#include "Image.hpp"
+
+/*
+ * Mip chains: an image and every halving of it down to 1x1, in one allocation.
+ *
+ * A Chain lays its levels out back to back, largest first, rows tightly packed and each level starting on an
+ * image_row_alignment boundary, so the whole thing can go to a GPU upload buffer or a file with one copy and come
+ * back with one mapping; layout(i) is where level i sits.
+ *
+ * Levels are made from the level above, in linear premultiplied light: RGBA8 is decoded once, each level is filtered
+ * from the float level before it (so rounding doesn't pile up down the chain) and encoded as it's finished. The box
+ * filter on an even size is a 2x2 average, and the first one decodes the base as it reads it, so a box chain never
+ * holds the full size level as floats; anything else (Kaiser, odd sizes) goes through ES_resample.hpp with its
+ * cached weights. Each level depends on the one before, so levels go in order and the rows within each go out to the
+ * pool; the small levels at the end are a single job each.
+ *
+ * Alpha tested (cutout) textures thin out as they shrink, since averaging pulls alpha towards the middle and fewer
+ * pixels clear the test. With an alpha_cutoff, every level's alpha is scaled so the fraction of pixels above the
+ * cutoff is what it was in the full size image.
+ */
+
+//SIGNATURES AND FRIENDS
+namespace ES::mip {
+
+    /// Levels in a full chain for a width x height image: down to 1x1, halving each side (rounding down) each time.
+    [[nodiscard]] constexpr std::size_t level_count(std::size_t width, std::size_t height) noexcept;
+
+    /**
+     * @brief Every level of a mip chain in one allocation, largest first.
+     *
+     * Level i is max(1, width >> i) x max(1, height >> i), rows packed with no padding, starting layout(i).offset bytes
+     * into bytes().
+     */
+    template <ImagePixel Pixel>
+    class Chain {
+    public:
+        struct Level {
+            std::size_t offset;
+            std::size_t width;
+            std::size_t height;
+        };
+
+        Chain() noexcept = default;
+
+        /// A full chain for a width x height image, pixels uninitialised.
+        Chain(std::size_t width, std::size_t height);
+
+        [[nodiscard]] std::size_t levels() const noexcept;
+        [[nodiscard]] std::size_t width() const noexcept;
+        [[nodiscard]] std::size_t height() const noexcept;
+
+        [[nodiscard]] const Level& layout(std::size_t level) const noexcept;
+        [[nodiscard]] ImageView<Pixel> level(std::size_t level) noexcept;
+        [[nodiscard]] ImageView<const Pixel> level(std::size_t level) const noexcept;
+
+        /// The whole chain as it sits in memory.
+        [[nodiscard]] std::span<const std::byte> bytes() const noexcept;
+        [[nodiscard]] std::span<std::byte> bytes() noexcept;
+
+    private:
+        struct AlignedDelete {
+            void operator()(std::byte* bytes) const noexcept {
+                ::operator delete(bytes, std::align_val_t{image_row_alignment});
+            }
+        };
+
+        std::unique_ptr<std::byte, AlignedDelete> bytes_;
+        std::size_t size_ = 0;
+        std::vector<Level> levels_;
+    };
+
+    struct Options {
+        /// How each level is filtered from the one before: box is the classic 2x2 average, Kaiser keeps more detail.
+        resample::Filter filter = resample::Filter::box;
+        /// Whether RGBA8 colour is sRGB encoded; false for normal maps, masks and other data that isn't colour.
+        bool srgb = true;
+        /// The alpha test threshold of a cutout texture, whose coverage every level keeps; 0 leaves alpha as filtered.
+        float alpha_cutoff = 0.0f;
+    };
+
+    /// The full chain for base, which becomes level 0 unchanged.
+    [[nodiscard]] Chain<RGBA8> generate(ImageView<const RGBA8> base, const Options& options = {},
+                                        parallel::ThreadPool& pool = parallel::default_pool());
+    [[nodiscard]] Chain<RGBA> generate(ImageView<const RGBA> base, const Options& options = {},
+                                       parallel::ThreadPool& pool = parallel::default_pool());
+
+    /// The fraction of pixels in image whose alpha is above cutoff.
+    [[nodiscard]] double coverage(ImageView<const RGBA8> image, float cutoff) noexcept;
+    [[nodiscard]] double coverage(ImageView<const RGBA> image, float cutoff) noexcept;
+
+}
+
+namespace ES::mip::Secret {
+
+    //rows to a job: about 16K pixels, however wide the level
+    [[nodiscard]] inline std::size_t row_grain(std::size_t width) noexcept {
+        return std::max<std::size_t>(1, (std::size_t{1} << 14) / std::max<std::size_t>(1, width));
+    }
+
+    //RGBA8 that isn't colour: bytes over 255, premultiplied all the same so colour doesn't bleed out of holes
+    void decode_data(ImageView<const RGBA8> in, ImageView<RGBA> out, parallel::ThreadPool& pool);
+    void encode_data(ImageView<const RGBA> in, ImageView<RGBA8> out, parallel::ThreadPool& pool);
+
+    //out is in halved: the 2x2 box, or 2x1 / 1x2 once a side is down to 1
+    void halve(ImageView<const RGBA> in, ImageView<RGBA> out, parallel::ThreadPool& pool);
+
+    //the same straight from the 8 bit base, decoding as it goes, so the full size float copy is never made
+    void halve(ImageView<const RGBA8> in, ImageView<RGBA> out, bool srgb, parallel::ThreadPool& pool);
+
+    [[nodiscard]] constexpr bool halves(std::size_t from, std::size_t to) noexcept {
+        return from == 2 * to || (from == 1 && to == 1);
+    }
+
+    void reduce(ImageView<const RGBA> in, ImageView<RGBA> out, resample::Filter filter, parallel::ThreadPool& pool);
+
+    //scales alpha (and with it the premultiplied colour) so that target of the pixels end up above cutoff
+    void preserve_coverage(ImageView<RGBA> level, double target, float cutoff, parallel::ThreadPool& pool);
+
+}
+
+//DEFINITIONS
+
+constexpr std::size_t ES::mip::level_count(const std::size_t width, const std::size_t height) noexcept {
+    return static_cast<std::size_t>(std::bit_width(std::max<std::size_t>({width, height, 1})));
+}
+
+template <ES::ImagePixel Pixel>
+ES::mip::Chain<Pixel>::Chain(const std::size_t width, const std::size_t height) {
+    assert(width > 0 && height > 0 && "mip::Chain needs at least a pixel");
+    const std::size_t count = level_count(width, height);
+    levels_.reserve(count);
+    std::size_t offset = 0;
+    for (std::size_t i = 0; i < count; i++) {
+        const Level level{offset, std::max<std::size_t>(1, width >> i), std::max<std::size_t>(1, height >> i)};
+        levels_.push_back(level);
+        offset += level.width * level.height * sizeof(Pixel);
+        offset = (offset + image_row_alignment - 1) / image_row_alignment * image_row_alignment;
+    }
+    size_ = offset;
+    bytes_.reset(static_cast<std::byte*>(::operator new(size_, std::align_val_t{image_row_alignment})));
+}
+
+template <ES::ImagePixel Pixel>
+std::size_t ES::mip::Chain<Pixel>::levels() const noexcept {
+    return levels_.size();
+}
+
+template <ES::ImagePixel Pixel>
+std::size_t ES::mip::Chain<Pixel>::width() const noexcept {
+    return levels_.empty() ? 0 : levels_.front().width;
+}
+
+template <ES::ImagePixel Pixel>
+std::size_t ES::mip::Chain<Pixel>::height() const noexcept {
+    return levels_.empty() ? 0 : levels_.front().height;
+}
+
+template <ES::ImagePixel Pixel>
+const typename ES::mip::Chain<Pixel>::Level& ES::mip::Chain<Pixel>::layout(const std::size_t level) const noexcept {
+    assert(level < levels_.size() && "mip::Chain level out of range");
+    return levels_[level];
+}
+
+template <ES::ImagePixel Pixel>
+ES::ImageView<Pixel> ES::mip::Chain<Pixel>::level(const std::size_t level) noexcept {
+    const Level& where = layout(level);
+    return ImageView<Pixel>(reinterpret_cast<Pixel*>(bytes_.get() + where.offset), where.width, where.height);
+}
+
+template <ES::ImagePixel Pixel>
+ES::ImageView<const Pixel> ES::mip::Chain<Pixel>::level(const std::size_t level) const noexcept {
+    const Level& where = layout(level);
+    return ImageView<const Pixel>(reinterpret_cast<const Pixel*>(bytes_.get() + where.offset), where.width, where.height);
+}
+
+template <ES::ImagePixel Pixel>
+std::span<const std::byte> ES::mip::Chain<Pixel>::bytes() const noexcept {
+    return std::span<const std::byte>(bytes_.get(), size_);
+}
+
+template <ES::ImagePixel Pixel>
+std::span<std::byte> ES::mip::Chain<Pixel>::bytes() noexcept {
+    return std::span<std::byte>(bytes_.get(), size_);
+}
+
+inline void ES::mip::Secret::decode_data(const ImageView<const RGBA8> in, const ImageView<RGBA> out, parallel::ThreadPool& pool) {
+    out.parallel_for_rows([&](std::size_t y, std::span<RGBA> row) {
+        const RGBA8* ES_RESTRICT from = in.row_data(y);
+        RGBA* ES_RESTRICT to = row.data();
+        for (std::size_t x = 0; x < row.size(); x++) {
+            const float a = from[x].A * (1.0f / 255.0f);
+            const float scale = a * (1.0f / 255.0f);
+            to[x] = RGBA(from[x].R * scale, from[x].G * scale, from[x].B * scale, a);
+        }
+    }, row_grain(out.width()), pool);
+}
+
+inline void ES::mip::Secret::encode_data(const ImageView<const RGBA> in, const ImageView<RGBA8> out, parallel::ThreadPool& pool) {
+    out.parallel_for_rows([&](std::size_t y, std::span<RGBA8> row) {
+        const RGBA* ES_RESTRICT from = in.row_data(y);
+        RGBA8* ES_RESTRICT to = row.data();
+        const auto byte = [](float v) {
+            return static_cast<std::uint8_t>(std::min(std::max(v, 0.0f), 1.0f) * 255.0f + 0.5f);
+        };
+        for (std::size_t x = 0; x < row.size(); x++) {
+            const float a = from[x].A();
+            const float unpremultiply = simd::select(a > 0.0f, 1.0f / a, 0.0f);
+            to[x] = RGBA8(byte(from[x].R() * unpremultiply), byte(from[x].G() * unpremultiply), byte(from[x].B() * unpremultiply), byte(a));
+        }
+    }, row_grain(out.width()), pool);
+}
+
+inline void ES::mip::Secret::halve(const ImageView<const RGBA> in, const ImageView<RGBA> out, parallel::ThreadPool& pool) {
+    //a side that's already 1 reads its one pixel twice, which is the 2x1 (or 1x2) box
+    const std::size_t dx = in.width() > 1 ? 1 : 0;
+    const std::size_t dy = in.height() > 1 ? 1 : 0;
+    out.parallel_for_rows([&](std::size_t y, std::span<RGBA> row) {
+        const RGBA* ES_RESTRICT top = in.row_data(2 * y * dy);
+        const RGBA* ES_RESTRICT bottom = in.row_data((2 * y + 1) * dy);
+        RGBA* ES_RESTRICT to = row.data();
+        for (std::size_t x = 0; x < row.size(); x++) {
+            const std::size_t left = 2 * x * dx;
+            const std::size_t right = left + dx;
+            ES_VECTORIZE
+            for (std::size_t c = 0; c < 4; c++) {
+                to[x][c] = 0.25f * ((top[left][c] + top[right][c]) + (bottom[left][c] + bottom[right][c]));
+            }
+        }
+    }, row_grain(out.width()), pool);
+}
+
+inline void ES::mip::Secret::halve(const ImageView<const RGBA8> in, const ImageView<RGBA> out, const bool srgb, parallel::ThreadPool& pool) {
+    const std::size_t dx = in.width() > 1 ? 1 : 0;
+    const std::size_t dy = in.height() > 1 ? 1 : 0;
+    out.parallel_for_rows([&](std::size_t y, std::span<RGBA> row) {
+        const RGBA8* ES_RESTRICT top = in.row_data(2 * y * dy);
+        const RGBA8* ES_RESTRICT bottom = in.row_data((2 * y + 1) * dy);
+        RGBA* ES_RESTRICT to = row.data();
+        //a quarter of each pixel's premultiplied colour
+        const auto quarter = [srgb](const RGBA8& p, float* sum) {
+            const float a = p.A * (0.25f / 255.0f);
+            sum[0] += (srgb ? srgb::to_linear(p.R) : p.R * (1.0f / 255.0f)) * a;
+            sum[1] += (srgb ? srgb::to_linear(p.G) : p.G * (1.0f / 255.0f)) * a;
+            sum[2] += (srgb ? srgb::to_linear(p.B) : p.B * (1.0f / 255.0f)) * a;
+            sum[3] += a;
+        };
+        for (std::size_t x = 0; x < row.size(); x++) {
+            const std::size_t left = 2 * x * dx;
+            const std::size_t right = left + dx;
+            float sum[4] = {};
+            quarter(top[left], sum);
+            quarter(top[right], sum);
+            quarter(bottom[left], sum);
+            quarter(bottom[right], sum);
+            to[x] = RGBA(sum[0], sum[1], sum[2], sum[3]);
+        }
+    }, row_grain(out.width()), pool);
+}
+
+inline void ES::mip::Secret::reduce(const ImageView<const RGBA> in, const ImageView<RGBA> out, const resample::Filter filter,
+                                    parallel::ThreadPool& pool) {
+    if (filter == resample::Filter::box && halves(in.width(), out.width()) && halves(in.height(), out.height())) {
+        halve(in, out, pool);
+    } else {
+        resample::resize(in, out, filter, pool);
+    }
+}
+
+inline void ES::mip::Secret::preserve_coverage(const ImageView<RGBA> level, const double target, const float cutoff, parallel::ThreadPool& pool) {
+    std::vector<float> alphas;
+    alphas.reserve(level.size());
+    for (std::size_t y = 0; y < level.height(); y++) {
+        for (const RGBA& p : level.row(y)) {
+            alphas.push_back(p.A());
+        }
+    }
+    const std::size_t count = alphas.size();
+    const std::size_t passing = std::min(count, static_cast<std::size_t>(std::llround(target * static_cast<double>(count))));
+
+    //the alpha that should land on the cutoff: halfway between the last pixel that passes and the first that doesn't
+    float threshold;
+    if (passing == 0) {
+        threshold = *std::max_element(alphas.begin(), alphas.end());
+        if (threshold <= 0.0f) {
+            return;
+        }
+    } else if (passing == count) {
+        threshold = 0.5f * *std::min_element(alphas.begin(), alphas.end());
+    } else {
+        std::nth_element(alphas.begin(), alphas.begin() + static_cast<std::ptrdiff_t>(passing), alphas.end(), std::greater<>());
+        const float last_in = *std::min_element(alphas.begin(), alphas.begin() + static_cast<std::ptrdiff_t>(passing));
+        threshold = 0.5f * (last_in + alphas[passing]);
+    }
+    //nothing above 0 left out means every pixel with any alpha passes: as far up as alpha goes
+    const float scale = threshold > 0.0f ? cutoff / threshold : std::numeric_limits<float>::max();
+
+    level.parallel_for_rows([&](std::size_t, std::span<RGBA> row) {
+        for (RGBA& p : row) {
+            //alpha stops at 1, and the colour with it so the straight colour stays the same
+            const float a = p.A();
+            const float factor = std::min(scale, simd::select(a > 0.0f, 1.0f / a, scale));
+            for (std::size_t c = 0; c < 4; c++) {
+                p[c] *= factor;
+            }
+        }
+    }, row_grain(level.width()), pool);
+}
+
+inline double ES::mip::coverage(const ImageView<const RGBA8> image, const float cutoff) noexcept {
+    std::size_t above = 0;
+    for (std::size_t y = 0; y < image.height(); y++) {
+        for (const RGBA8& p : image.row(y)) {
+            above += p.A * (1.0f / 255.0f) > cutoff;
+        }
+    }
+    return image.empty() ? 0.0 : static_cast<double>(above) / static_cast<double>(image.size());
+}
+
+inline double ES::mip::coverage(const ImageView<const RGBA> image, const float cutoff) noexcept {
+    std::size_t above = 0;
+    for (std::size_t y = 0; y < image.height(); y++) {
+        for (const RGBA& p : image.row(y)) {
+            above += p.A() > cutoff;
+        }
+    }
+    return image.empty() ? 0.0 : static_cast<double>(above) / static_cast<double>(image.size());
+}
+
+inline ES::mip::Chain<ES::RGBA8> ES::mip::generate(const ImageView<const RGBA8> base, const Options& options, parallel::ThreadPool& pool) {
+    Chain<RGBA8> chain(base.width(), base.height());
+    base.copy_to(chain.level(0));
+    const double target = options.alpha_cutoff > 0.0f ? coverage(base, options.alpha_cutoff) : 0.0;
+
+    //the box halving level 1 reads the bytes itself, anything else filters a float copy of the base
+    Image<RGBA> above;
+    const bool fused = chain.levels() > 1 && options.filter == resample::Filter::box
+                    && Secret::halves(base.width(), chain.layout(1).width) && Secret::halves(base.height(), chain.layout(1).height);
+    if (!fused) {
+        above = Image<RGBA>(base.width(), base.height());
+        if (options.srgb) {
+            color::to_linear(base, above, pool);
+        } else {
+            Secret::decode_data(base, above, pool);
+        }
+    }
+    for (std::size_t i = 1; i < chain.levels(); i++) {
+        const ImageView<RGBA8> out = chain.level(i);
+        Image<RGBA> level(out.width(), out.height());
+        if (i == 1 && fused) {
+            Secret::halve(base, level, options.srgb, pool);
+        } else {
+            Secret::reduce(above, level, options.filter, pool);
+        }
+        if (options.alpha_cutoff > 0.0f) {
+            Secret::preserve_coverage(level, target, options.alpha_cutoff, pool);
+        }
+        if (options.srgb) {
+            color::to_srgb8(level, out, pool);
+        } else {
+            Secret::encode_data(level, out, pool);
+        }
+        above = std::move(level);
+    }
+    return chain;
+}
+
+inline ES::mip::Chain<ES::RGBA> ES::mip::generate(const ImageView<const RGBA> base, const Options& options, parallel::ThreadPool& pool) {
+    //float images are linear already, options.srgb is for bytes
+    Chain<RGBA> chain(base.width(), base.height());
+    base.copy_to(chain.level(0));
+    const double target = options.alpha_cutoff > 0.0f ? coverage(base, options.alpha_cutoff) : 0.0;
+    for (std::size_t i = 1; i < chain.levels(); i++) {
+        Secret::reduce(chain.level(i - 1), chain.level(i), options.filter, pool);
+        if (options.alpha_cutoff > 0.0f) {
+            Secret::preserve_coverage(chain.level(i), target, options.alpha_cutoff, pool);
+        }
+    }
+    return chain;
+}
+
+#endif //COMPUTERGRAPHICS_ESMIP_HPP
@@ -0,0 +1,393 @@
+#ifndef COMPUTERGRAPHICS_ESPALETTE_HPP
+#define COMPUTERGRAPHICS_ESPALETTE_HPP
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <utility>
+#include <vector>
+#include "ES_parallel.hpp"
+#include "ColorN.hpp"
+#include "Image.hpp"
+
+/*
+ * Palettes for 8 bit images: median cut, k-means on top of it, and a k-d tree to find a colour's nearest entry.
+ *
+ * Colours are compared as points (R a, G a, B a, A) in sRGB code units with a = A / 255: sRGB codes are closer to how
+ * different colours look than linear light is, and premultiplying puts every fully transparent colour on the same
+ * point, so a palette spends one entry on them, not one per hidden colour.
+ *
+ * Both generators work on the image's colour histogram rather than its pixels: 5 bits a colour channel and 3 of
+ * alpha, each bucket keeping the mean of what fell in it and how many did. Median cut splits the box with the most
+ * error in it (pixels times the square of its longest side) at the weighted median of that side until there are
+ * enough boxes. k-means then moves each entry to the mean of the colours nearest it; with up to 256 entries and tens
+ * of thousands of buckets, the nearest entry search is what costs, so each round builds a k-d tree over the entries
+ * and the buckets are assigned across the pool, each job summing into its own totals.
+ */
+
+//SIGNATURES AND FRIENDS
+namespace ES::palette {
+
+    using Point = std::array<float, 4>;
+
+    /// Where a colour sits for palette purposes.
+    [[nodiscard]] constexpr Point point(const RGBA8& colour) noexcept;
+
+    /// The colour at a point, rounded and unpremultiplied.
+    [[nodiscard]] RGBA8 colour(const Point& point) noexcept;
+
+    [[nodiscard]] constexpr float distance_squared(const Point& a, const Point& b) noexcept;
+
+    /**
+     * @brief Nearest neighbour search over a fixed set of points.
+     *
+     * A balanced tree laid out in one array: the node for a range is its middle element, split on the axis the range
+     * spreads widest along, its children the halves either side.
+     */
+    class KdTree {
+    public:
+        KdTree() noexcept = default;
+        explicit KdTree(std::span<const Point> points);
+
+        /// The index, in the points the tree was made from, of the one nearest query. The tree must not be empty.
+        [[nodiscard]] std::size_t nearest(const Point& query) const noexcept;
+
+        [[nodiscard]] std::size_t size() const noexcept;
+
+    private:
+        struct Node {
+            Point point;
+            std::uint32_t index;
+            std::uint32_t axis;
+        };
+
+        void build(std::size_t begin, std::size_t end);
+        void search(std::size_t begin, std::size_t end, const Point& query, std::size_t& best, float& best_distance) const noexcept;
+
+        std::vector<Node> nodes_;
+    };
+
+    /// A colour of the histogram and how many pixels it stands for.
+    struct Entry {
+        Point point;
+        float weight;
+    };
+
+    /// image's colour histogram, the non empty buckets.
+    [[nodiscard]] std::vector<Entry> histogram(ImageView<const RGBA8> image);
+
+    /// Up to count colours by median cut; fewer if the image has fewer.
+    [[nodiscard]] std::vector<RGBA8> median_cut(ImageView<const RGBA8> image, std::size_t count);
+
+    /// initial refined by up to iterations rounds of k-means, stopping early once nothing moves.
+    [[nodiscard]] std::vector<RGBA8> kmeans(ImageView<const RGBA8> image, std::vector<RGBA8> initial, std::size_t iterations = 8,
+                                            parallel::ThreadPool& pool = parallel::default_pool());
+
+    /// median_cut then kmeans: a palette of up to count colours for image.
+    [[nodiscard]] std::vector<RGBA8> generate(ImageView<const RGBA8> image, std::size_t count, std::size_t iterations = 8,
+                                              parallel::ThreadPool& pool = parallel::default_pool());
+
+}
+
+namespace ES::palette::Secret {
+
+    //buckets in the histogram: 5 bits each of R, G and B, 3 of alpha
+    inline constexpr std::size_t bucket_count = std::size_t{1} << 18;
+
+    //the entries a histogram job takes at once in a k-means round
+    inline constexpr std::size_t kmeans_grain = 4096;
+
+    struct Box {
+        std::size_t begin;
+        std::size_t end;
+        std::size_t axis;
+        float score; //weight times the longest side squared; 0 if it can't be split
+    };
+
+    [[nodiscard]] Box make_box(std::span<const Entry> entries, std::size_t begin, std::size_t end) noexcept;
+
+    [[nodiscard]] std::vector<RGBA8> median_cut(std::vector<Entry> entries, std::size_t count);
+
+    [[nodiscard]] std::vector<RGBA8> kmeans(std::span<const Entry> entries, std::vector<RGBA8> palette, std::size_t iterations,
+                                            parallel::ThreadPool& pool);
+
+}
+
+//DEFINITIONS
+
+constexpr ES::palette::Point ES::palette::point(const RGBA8& colour) noexcept {
+    const float a = colour.A * (1.0f / 255.0f);
+    return Point{colour.R * a, colour.G * a, colour.B * a, static_cast<float>(colour.A)};
+}
+
+inline ES::RGBA8 ES::palette::colour(const Point& point) noexcept {
+    const auto byte = [](float v) { return static_cast<std::uint8_t>(std::min(std::max(v, 0.0f), 255.0f) + 0.5f); };
+    const std::uint8_t alpha = byte(point[3]);
+    if (alpha == 0) {
+        return RGBA8(0, 0, 0, 0);
+    }
+    const float unpremultiply = 255.0f / point[3];
+    return RGBA8(byte(point[0] * unpremultiply), byte(point[1] * unpremultiply), byte(point[2] * unpremultiply), alpha);
+}
+
+constexpr float ES::palette::distance_squared(const Point& a, const Point& b) noexcept {
+    float sum = 0.0f;
+    for (std::size_t i = 0; i < 4; i++) {
+        sum += (a[i] - b[i]) * (a[i] - b[i]);
+    }
+    return sum;
+}
+
+inline ES::palette::KdTree::KdTree(const std::span<const Point> points) {
+    assert(points.size() <= std::numeric_limits<std::uint32_t>::max() && "KdTree indices are 32 bit");
+    nodes_.reserve(points.size());
+    for (std::size_t i = 0; i < points.size(); i++) {
+        nodes_.push_back(Node{points[i], static_cast<std::uint32_t>(i), 0});
+    }
+    build(0, nodes_.size());
+}
+
+inline void ES::palette::KdTree::build(const std::size_t begin, const std::size_t end) {
+    if (end - begin < 2) {
+        return;
+    }
+    Point low = nodes_[begin].point;
+    Point high = low;
+    for (std::size_t i = begin + 1; i < end; i++) {
+        for (std::size_t a = 0; a < 4; a++) {
+            low[a] = std::min(low[a], nodes_[i].point[a]);
+            high[a] = std::max(high[a], nodes_[i].point[a]);
+        }
+    }
+    std::uint32_t axis = 0;
+    for (std::uint32_t a = 1; a < 4; a++) {
+        axis = high[a] - low[a] > high[axis] - low[axis] ? a : axis;
+    }
+    const std::size_t middle = begin + (end - begin) / 2;
+    std::nth_element(nodes_.begin() + static_cast<std::ptrdiff_t>(begin), nodes_.begin() + static_cast<std::ptrdiff_t>(middle),
+                     nodes_.begin() + static_cast<std::ptrdiff_t>(end),
+                     [axis](const Node& a, const Node& b) { return a.point[axis] < b.point[axis]; });
+    nodes_[middle].axis = axis;
+    build(begin, middle);
+    build(middle + 1, end);
+}
+
+inline void ES::palette::KdTree::search(const std::size_t begin, const std::size_t end, const Point& query, std::size_t& best,
+                                        float& best_distance) const noexcept {
+    if (begin >= end) {
+        return;
+    }
+    const std::size_t middle = begin + (end - begin) / 2;
+    const Node& node = nodes_[middle];
+    const float distance = distance_squared(node.point, query);
+    if (distance < best_distance || (distance == best_distance && node.index < best)) {
+        best_distance = distance;
+        best = node.index;
+    }
+    //the near side first, the far side only if the splitting plane is closer than the best so far
+    const float offset = query[node.axis] - node.point[node.axis];
+    if (offset < 0.0f) {
+        search(begin, middle, query, best, best_distance);
+        if (offset * offset <= best_distance) {
+            search(middle + 1, end, query, best, best_distance);
+        }
+    } else {
+        search(middle + 1, end, query, best, best_distance);
+        if (offset * offset <= best_distance) {
+            search(begin, middle, query, best, best_distance);
+        }
+    }
+}
+
+inline std::size_t ES::palette::KdTree::nearest(const Point& query) const noexcept {
+    assert(!nodes_.empty() && "KdTree::nearest on an empty tree");
+    std::size_t best = 0;
+    float best_distance = std::numeric_limits<float>::infinity();
+    search(0, nodes_.size(), query, best, best_distance);
+    return best;
+}
+
+inline std::size_t ES::palette::KdTree::size() const noexcept {
+    return nodes_.size();
+}
+
+inline std::vector<ES::palette::Entry> ES::palette::histogram(const ImageView<const RGBA8> image) {
+    //exact integer totals, R A, G A, B A and A: float ones stop counting past 2^24 and drift well before that
+    struct Bucket {
+        std::array<std::uint64_t, 4> sum;
+        std::uint64_t count;
+    };
+    std::vector<Bucket> buckets(Secret::bucket_count, Bucket{{0, 0, 0, 0}, 0});
+    for (std::size_t y = 0; y < image.height(); y++) {
+        for (const RGBA8& pixel : image.row(y)) {
+            //fully transparent is one colour, whatever its RGB says
+            const RGBA8 p = pixel.A == 0 ? RGBA8(0, 0, 0, 0) : pixel;
+            const std::size_t bucket = static_cast<std::size_t>(p.R >> 3) << 13 | static_cast<std::size_t>(p.G >> 3) << 8
+                                     | static_cast<std::size_t>(p.B >> 3) << 3 | static_cast<std::size_t>(p.A >> 5);
+            Bucket& at = buckets[bucket];
+            at.sum[0] += std::uint64_t{p.R} * p.A;
+            at.sum[1] += std::uint64_t{p.G} * p.A;
+            at.sum[2] += std::uint64_t{p.B} * p.A;
+            at.sum[3] += p.A;
+            at.count++;
+        }
+    }
+    std::vector<Entry> entries;
+    for (const Bucket& bucket : buckets) {
+        if (bucket.count > 0) {
+            //the mean of point() over the bucket, in double until the end
+            const double inverse = 1.0 / static_cast<double>(bucket.count);
+            const double premultiplied = inverse / 255.0;
+            entries.push_back(Entry{{static_cast<float>(static_cast<double>(bucket.sum[0]) * premultiplied),
+                                     static_cast<float>(static_cast<double>(bucket.sum[1]) * premultiplied),
+                                     static_cast<float>(static_cast<double>(bucket.sum[2]) * premultiplied),
+                                     static_cast<float>(static_cast<double>(bucket.sum[3]) * inverse)},
+                                    static_cast<float>(bucket.count)});
+        }
+    }
+    return entries;
+}
+
+inline ES::palette::Secret::Box ES::palette::Secret::make_box(const std::span<const Entry> entries, const std::size_t begin, const std::size_t end) noexcept {
+    Point low = entries[begin].point;
+    Point high = low;
+    float weight = 0.0f;
+    for (std::size_t i = begin; i < end; i++) {
+        for (std::size_t a = 0; a < 4; a++) {
+            low[a] = std::min(low[a], entries[i].point[a]);
+            high[a] = std::max(high[a], entries[i].point[a]);
+        }
+        weight += entries[i].weight;
+    }
+    std::size_t axis = 0;
+    for (std::size_t a = 1; a < 4; a++) {
+        axis = high[a] - low[a] > high[axis] - low[axis] ? a : axis;
+    }
+    const float side = high[axis] - low[axis];
+    return Box{begin, end, axis, end - begin > 1 ? weight * side * side : 0.0f};
+}
+
+inline std::vector<ES::RGBA8> ES::palette::Secret::median_cut(std::vector<Entry> entries, const std::size_t count) {
+    std::vector<Box> boxes;
+    if (!entries.empty() && count > 0) {
+        boxes.push_back(make_box(entries, 0, entries.size()));
+    }
+    while (boxes.size() < count) {
+        const auto worst = std::max_element(boxes.begin(), boxes.end(), [](const Box& a, const Box& b) { return a.score < b.score; });
+        if (worst == boxes.end() || worst->score <= 0.0f) {
+            break;
+        }
+        const Box box = *worst;
+        const auto first = entries.begin() + static_cast<std::ptrdiff_t>(box.begin);
+        const auto last = entries.begin() + static_cast<std::ptrdiff_t>(box.end);
+        std::sort(first, last, [axis = box.axis](const Entry& a, const Entry& b) { return a.point[axis] < b.point[axis]; });
+        //the weighted median, kept off the ends so both halves get something
+        float total = 0.0f;
+        for (auto it = first; it != last; ++it) {
+            total += it->weight;
+        }
+        std::size_t split = box.begin + 1;
+        float below = entries[box.begin].weight;
+        while (split < box.end - 1 && below + entries[split].weight <= 0.5f * total) {
+            below += entries[split].weight;
+            split++;
+        }
+        *worst = make_box(entries, box.begin, split);
+        boxes.push_back(make_box(entries, split, box.end));
+    }
+
+    std::vector<RGBA8> palette;
+    palette.reserve(boxes.size());
+    for (const Box& box : boxes) {
+        Point sum{0.0f, 0.0f, 0.0f, 0.0f};
+        float weight = 0.0f;
+        for (std::size_t i = box.begin; i < box.end; i++) {
+            for (std::size_t a = 0; a < 4; a++) {
+                sum[a] += entries[i].point[a] * entries[i].weight;
+            }
+            weight += entries[i].weight;
+        }
+        palette.push_back(colour(Point{sum[0] / weight, sum[1] / weight, sum[2] / weight, sum[3] / weight}));
+    }
+    return palette;
+}
+
+inline std::vector<ES::RGBA8> ES::palette::Secret::kmeans(const std::span<const Entry> entries, std::vector<RGBA8> palette,
+                                                          const std::size_t iterations, parallel::ThreadPool& pool) {
+    struct Totals {
+        std::vector<Point> sum;
+        std::vector<float> weight;
+    };
+    const std::size_t k = palette.size();
+    if (k == 0 || entries.empty()) {
+        return palette;
+    }
+    std::vector<Point> centres(k);
+    for (std::size_t i = 0; i < k; i++) {
+        centres[i] = point(palette[i]);
+    }
+    std::vector<std::uint32_t> assigned(entries.size(), std::numeric_limits<std::uint32_t>::max());
+    const std::size_t jobs = (entries.size() + kmeans_grain - 1) / kmeans_grain;
+
+    for (std::size_t round = 0; round < iterations; round++) {
+        const KdTree tree(centres);
+        std::vector<Totals> totals(jobs, Totals{std::vector<Point>(k, Point{}), std::vector<float>(k, 0.0f)});
+        std::vector<std::uint8_t> changed(jobs, 0);
+        parallel::for_chunks(entries.size(), kmeans_grain, [&](std::size_t begin, std::size_t end) {
+            const std::size_t job = begin / kmeans_grain;
+            Totals& mine = totals[job];
+            for (std::size_t i = begin; i < end; i++) {
+                const auto nearest = static_cast<std::uint32_t>(tree.nearest(entries[i].point));
+                changed[job] |= nearest != assigned[i];
+                assigned[i] = nearest;
+                for (std::size_t a = 0; a < 4; a++) {
+                    mine.sum[nearest][a] += entries[i].point[a] * entries[i].weight;
+                }
+                mine.weight[nearest] += entries[i].weight;
+            }
+        }, pool);
+        if (std::none_of(changed.begin(), changed.end(), [](std::uint8_t c) { return c != 0; })) {
+            break;
+        }
+        //an entry nothing is nearest to stays where it was
+        for (std::size_t c = 0; c < k; c++) {
+            Point sum{};
+            float weight = 0.0f;
+            for (const Totals& job : totals) {
+                for (std::size_t a = 0; a < 4; a++) {
+                    sum[a] += job.sum[c][a];
+                }
+                weight += job.weight[c];
+            }
+            if (weight > 0.0f) {
+                centres[c] = Point{sum[0] / weight, sum[1] / weight, sum[2] / weight, sum[3] / weight};
+            }
+        }
+    }
+    for (std::size_t i = 0; i < k; i++) {
+        palette[i] = colour(centres[i]);
+    }
+    return palette;
+}
+
+inline std::vector<ES::RGBA8> ES::palette::median_cut(const ImageView<const RGBA8> image, const std::size_t count) {
+    return Secret::median_cut(histogram(image), count);
+}
+
+inline std::vector<ES::RGBA8> ES::palette::kmeans(const ImageView<const RGBA8> image, std::vector<RGBA8> initial, const std::size_t iterations,
+                                                  parallel::ThreadPool& pool) {
+    return Secret::kmeans(histogram(image), std::move(initial), iterations, pool);
+}
+
+inline std::vector<ES::RGBA8> ES::palette::generate(const ImageView<const RGBA8> image, const std::size_t count, const std::size_t iterations,
+                                                    parallel::ThreadPool& pool) {
+    const std::vector<Entry> entries = histogram(image);
+    return Secret::kmeans(entries, Secret::median_cut(entries, count), iterations, pool);
+}
+
+#endif //COMPUTERGRAPHICS_ESPALETTE_HPP
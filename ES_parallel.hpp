@@ -0,0 +1,157 @@
+#ifndef COMPUTERGRAPHICS_ESPARALLEL_HPP
+#define COMPUTERGRAPHICS_ESPARALLEL_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//SIGNATURES AND FRIENDS
+namespace ES::parallel {
+
+    /**
+     * @brief A tiny fixed-size pool of worker threads with a single shared queue.
+     *
+     * Nothing fancy, no work stealing, no futures. Jobs are `void()` callables and are expected not to throw
+     * (the whole library is noexcept, an exception escaping a worker will terminate, as it should).
+     * Most code should never touch this directly and go through `parallel::for_chunks` instead.
+     */
+    class ThreadPool {
+    public:
+        explicit ThreadPool(std::size_t thread_count = std::max(1u, std::thread::hardware_concurrency()));
+        ~ThreadPool();
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        void submit(std::function<void()> job);
+
+        [[nodiscard]] std::size_t size() const noexcept { return workers_.size(); }
+
+    private:
+        void worker_loop(std::stop_token stop);
+
+        std::mutex mutex_;
+        std::condition_variable_any wake_;
+        std::deque<std::function<void()>> jobs_;
+        std::vector<std::jthread> workers_; //last, so the threads are joined before the queue dies
+    };
+
+    [[nodiscard]] inline ThreadPool& default_pool();
+
+    /**
+     * @brief Splits [0, count) into chunks of `grain` and runs `func(begin, end)` on each, across the pool.
+     *
+     * The calling thread chews through chunks too, so this is safe to call from inside a pool job
+     * (nested calls just degrade into running on the caller). Returns once every chunk is done.
+     *
+     * @param count number of items
+     * @param grain items per chunk, clamped to at least one
+     * @param func callable of the form `void(std::size_t begin, std::size_t end)`
+     * @param pool the pool to borrow, the shared default one if not given
+     */
+    template<typename Func>
+    void for_chunks(std::size_t count, std::size_t grain, Func&& func, ThreadPool& pool = default_pool());
+
+}
+
+namespace ES::parallel::Secret {
+    struct ChunkState {
+        std::atomic<std::size_t> next{0};
+        std::atomic<std::size_t> finished{0};
+        std::size_t chunk_count = 0;
+        std::mutex mutex;
+        std::condition_variable done;
+    };
+}
+
+//DEFINITIONS
+
+inline ES::parallel::ThreadPool::ThreadPool(const std::size_t thread_count) {
+    workers_.reserve(thread_count);
+    for (std::size_t i = 0; i < thread_count; ++i) {
+        workers_.emplace_back([this](std::stop_token stop) { worker_loop(stop); });
+    }
+}
+
+inline ES::parallel::ThreadPool::~ThreadPool() {
+    for (auto& worker : workers_) {
+        worker.request_stop();
+    }
+    wake_.notify_all();
+    workers_.clear(); //jthread joins on destruction
+}
+
+inline void ES::parallel::ThreadPool::submit(std::function<void()> job) {
+    {
+        std::scoped_lock lock(mutex_);
+        jobs_.push_back(std::move(job));
+    }
+    wake_.notify_one();
+}
+
+inline void ES::parallel::ThreadPool::worker_loop(std::stop_token stop) {
+    while (true) {
+        std::function<void()> job;
+        {
+            std::unique_lock lock(mutex_);
+            if (!wake_.wait(lock, stop, [this] { return !jobs_.empty(); })) {
+                return; //stop was requested while the queue sat empty
+            }
+            job = std::move(jobs_.front());
+            jobs_.pop_front();
+        }
+        job();
+    }
+}
+
+ES::parallel::ThreadPool& ES::parallel::default_pool() {
+    static ThreadPool pool;
+    return pool;
+}
+
+template<typename Func>
+void ES::parallel::for_chunks(const std::size_t count, std::size_t grain, Func&& func, ThreadPool& pool) {
+    if (count == 0) return;
+    grain = std::max<std::size_t>(grain, 1);
+    const std::size_t chunk_count = (count + grain - 1) / grain;
+
+    if (chunk_count == 1 || pool.size() == 0) { //not worth waking anybody up
+        func(std::size_t{0}, count);
+        return;
+    }
+
+    //the state is shared, as helpers that get scheduled late may still peek at it after we've returned
+    auto state = std::make_shared<Secret::ChunkState>();
+    state->chunk_count = chunk_count;
+
+    auto run = [state, count, grain, &func] {
+        std::size_t chunk;
+        while ((chunk = state->next.fetch_add(1, std::memory_order_relaxed)) < state->chunk_count) {
+            const std::size_t begin = chunk * grain;
+            func(begin, std::min(begin + grain, count));
+            if (state->finished.fetch_add(1, std::memory_order_acq_rel) + 1 == state->chunk_count) {
+                std::scoped_lock lock(state->mutex);
+                state->done.notify_all();
+            }
+        }
+    };
+
+    const std::size_t helpers = std::min(pool.size(), chunk_count - 1);
+    for (std::size_t i = 0; i < helpers; ++i) {
+        //late helpers find no chunks left and never touch func, so capturing it by reference is fine
+        pool.submit(run);
+    }
+    run();
+
+    std::unique_lock lock(state->mutex);
+    state->done.wait(lock, [&state] { return state->finished.load(std::memory_order_acquire) == state->chunk_count; });
+}
+
+#endif //COMPUTERGRAPHICS_ESPARALLEL_HPP
@@ -0,0 +1,689 @@
+#ifndef COMPUTERGRAPHICS_ESPNG_HPP
+#define COMPUTERGRAPHICS_ESPNG_HPP
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "ES_io.hpp"
+#include "ES_parallel.hpp"
+#include "ES_simd.hpp"
+#include "ES_zlib.hpp"
+#include "ColorN.hpp"
+#include "Image.hpp"
+
+/*
+ * PNG decoding straight into an Image<RGBA8> or Image<RGB8>, no dependencies.
+ *
+ * Every bit depth, colour type and Adam7 interlacing in the spec, tRNS transparency included. Decoding streams: the
+ * inflater hands out one scanline at a time, it is unfiltered against the one before and expanded right into its
+ * place in the image, so besides the image itself there are two scanlines and the inflate window, whatever the size.
+ * 16 bit samples keep their high byte. Like stb_image, CRCs and the zlib checksum go unchecked, broken files are
+ * caught by their structure instead.
+ *
+ * Encoding is built for speed over size, for dumping frames: every row Paeth filtered (which vectorizes when encoding)
+ * and compressed with zlib::deflate_fast. Bands of rows are filtered, compressed and checksummed on different threads
+ * and each becomes its own IDAT chunk, written to the sink as it is, in order.
+ */
+
+//SIGNATURES AND FRIENDS
+namespace ES::png {
+
+    enum class Error : std::uint8_t {
+        none,
+        io,          //the file could not be read
+        not_png,     //no PNG signature
+        truncated,   //the file ends early
+        corrupt,     //malformed chunks or image data
+        unsupported, //valid PNG, but asks for something we don't do (an unknown critical chunk)
+        wrong_size   //the view to decode into isn't the size of the image
+    };
+
+    enum class ColorType : std::uint8_t { grey = 0, rgb = 2, palette = 3, grey_alpha = 4, rgba = 6 };
+
+    struct Info {
+        std::uint32_t width = 0;
+        std::uint32_t height = 0;
+        std::uint8_t bit_depth = 0;
+        ColorType color_type = ColorType::grey;
+        bool interlaced = false;
+        bool has_transparency = false; //an alpha channel or a tRNS chunk
+    };
+
+    /// The pixel types PNGs decode to. RGB8 drops any alpha.
+    template <typename Pixel>
+    concept DecodedPixel = std::same_as<Pixel, RGBA8> || std::same_as<Pixel, RGB8>;
+
+    /// Just the header, to size an image before decoding into it.
+    [[nodiscard]] Error read_info(std::span<const std::uint8_t> file, Info& info) noexcept;
+
+    /**
+     * @brief Decodes a whole PNG held in memory into out, which must be exactly the image's size.
+     *
+     * out can be any view, a sub-rectangle of a bigger image or memory owned by somebody else. A view of any other
+     * size is Error::wrong_size and left untouched. On other errors, whatever rows were decoded before it stay written.
+     */
+    template <DecodedPixel Pixel>
+    [[nodiscard]] Error decode(std::span<const std::uint8_t> file, ImageView<Pixel> out);
+
+    /// Decodes a whole PNG held in memory into a freshly sized image.
+    template <DecodedPixel Pixel>
+    [[nodiscard]] Error decode(std::span<const std::uint8_t> file, Image<Pixel>& out);
+
+    /// Reads and decodes a PNG file.
+    template <DecodedPixel Pixel>
+    [[nodiscard]] Error load(const std::filesystem::path& path, Image<Pixel>& out);
+
+    /// Rows an encoder hands one thread, about this many bytes of them.
+    inline constexpr std::size_t encode_band_bytes = std::size_t{1} << 18;
+
+    /**
+     * @brief Encodes image as an 8 bit RGBA or RGB PNG into sink.
+     * @return false if the sink stopped taking bytes
+     */
+    template <typename Pixel, io::ByteSink Sink> requires DecodedPixel<std::remove_const_t<Pixel>>
+    [[nodiscard]] bool encode(ImageView<Pixel> image, Sink& sink, parallel::ThreadPool& pool = parallel::default_pool());
+
+    template <DecodedPixel Pixel, io::ByteSink Sink>
+    [[nodiscard]] bool encode(const Image<Pixel>& image, Sink& sink, parallel::ThreadPool& pool = parallel::default_pool());
+
+}
+
+namespace ES::png::Secret {
+
+    inline constexpr std::array<std::uint8_t, 8> signature = {137, 80, 78, 71, 13, 10, 26, 10};
+
+    [[nodiscard]] constexpr std::uint32_t load_be32(const std::uint8_t* bytes) noexcept {
+        return (std::uint32_t{bytes[0]} << 24) | (std::uint32_t{bytes[1]} << 16) | (std::uint32_t{bytes[2]} << 8) | bytes[3];
+    }
+
+    [[nodiscard]] constexpr std::uint32_t chunk_type(const char (&name)[5]) noexcept {
+        return (std::uint32_t(std::uint8_t(name[0])) << 24) | (std::uint32_t(std::uint8_t(name[1])) << 16)
+             | (std::uint32_t(std::uint8_t(name[2])) << 8) | std::uint32_t(std::uint8_t(name[3]));
+    }
+
+    //everything in front of the image data
+    struct Header {
+        Info info;
+        std::array<RGBA8, 256> palette;
+        bool has_key = false;                 //tRNS on a grey or rgb image: samples equal to key are transparent
+        std::array<std::uint16_t, 3> key{};
+        std::size_t first_idat = 0;           //offset of the first IDAT chunk
+
+        [[nodiscard]] unsigned channels() const noexcept;
+        [[nodiscard]] unsigned bits_per_pixel() const noexcept { return channels() * info.bit_depth; }
+    };
+
+    [[nodiscard]] Error parse(std::span<const std::uint8_t> file, Header& header) noexcept;
+
+    //the payloads of consecutive IDAT chunks, one after the other
+    struct IdatSource {
+        std::span<const std::uint8_t> file;
+        std::size_t position; //at a chunk header
+
+        [[nodiscard]] std::span<const std::uint8_t> next() noexcept;
+    };
+
+    [[nodiscard]] constexpr std::uint8_t paeth(int a, int b, int c) noexcept {
+        const int pa = std::abs(b - c);
+        const int pb = std::abs(a - c);
+        const int pc = std::abs(a + b - 2 * c);
+        const int b_or_c = pb <= pc ? b : c;
+        return static_cast<std::uint8_t>(pa <= pb && pa <= pc ? a : b_or_c);
+    }
+
+    /**
+     * @brief Undoes one scanline's filter in place. row[-Bpp, 0) and prior[-Bpp, 0) must read as zero.
+     *
+     * Up has no dependency along the row and vectorizes outright. Sub, Average and Paeth each depend on the pixel to
+     * the left, so the lanes are the Bpp bytes of one pixel instead, with the left and upper left pixels carried in
+     * registers and every choice written as a select.
+     */
+    template <std::size_t Bpp>
+    void unfilter(std::uint8_t filter, std::uint8_t* ES_RESTRICT row, const std::uint8_t* ES_RESTRICT prior, std::size_t length) noexcept;
+
+    //false for a filter type that doesn't exist
+    [[nodiscard]] bool unfilter_row(std::uint8_t filter, std::uint8_t* row, const std::uint8_t* prior, std::size_t length, std::size_t bpp) noexcept;
+
+    template <DecodedPixel Pixel>
+    [[nodiscard]] constexpr Pixel make_pixel(std::uint8_t r, std::uint8_t g, std::uint8_t b, std::uint8_t a) noexcept {
+        if constexpr (std::same_as<Pixel, RGBA8>) {
+            return RGBA8(r, g, b, a);
+        } else {
+            return RGB8(r, g, b);
+        }
+    }
+
+    //count unfiltered pixels from src into dst, dst[0], dst[step], dst[2 * step]...
+    template <DecodedPixel Pixel>
+    void expand_row(const Header& header, const std::uint8_t* ES_RESTRICT src, std::size_t count, Pixel* ES_RESTRICT dst, std::size_t step) noexcept;
+
+    [[nodiscard]] constexpr Error from_status(zlib::Status status) noexcept {
+        //end_of_stream here means the image data stopped short of the last row
+        return status == zlib::Status::corrupt ? Error::corrupt : Error::truncated;
+    }
+
+    struct Pass {
+        std::size_t x, y, dx, dy;
+    };
+
+    inline constexpr std::array<Pass, 7> adam7 = {{
+        {0, 0, 8, 8}, {4, 0, 8, 8}, {0, 4, 4, 8}, {2, 0, 4, 4}, {0, 2, 2, 4}, {1, 0, 2, 2}, {0, 1, 1, 2}}};
+
+    //the encoding side of Paeth: every input is already known, so unlike unfilter nothing depends along the row
+    template <std::size_t Bpp>
+    void filter_paeth(const std::uint8_t* ES_RESTRICT row, const std::uint8_t* ES_RESTRICT prior, std::uint8_t* ES_RESTRICT out, std::size_t length) noexcept;
+
+    void append_be32(std::vector<std::uint8_t>& out, std::uint32_t value);
+
+    //a whole chunk with its length and CRC
+    void append_chunk(std::vector<std::uint8_t>& out, std::uint32_t type, std::span<const std::uint8_t> data);
+
+}
+
+//DEFINITIONS
+
+inline unsigned ES::png::Secret::Header::channels() const noexcept {
+    switch (info.color_type) {
+        case ColorType::grey:
+        case ColorType::palette:
+            return 1;
+        case ColorType::grey_alpha:
+            return 2;
+        case ColorType::rgb:
+            return 3;
+        case ColorType::rgba:
+            return 4;
+    }
+    return 0;
+}
+
+inline ES::png::Error ES::png::Secret::parse(const std::span<const std::uint8_t> file, Header& header) noexcept {
+    if (file.size() < signature.size() || !std::equal(signature.begin(), signature.end(), file.begin())) {
+        return Error::not_png;
+    }
+    header = Header{};
+    header.palette.fill(RGBA8(0, 0, 0, 255));
+    bool seen_header = false;
+    bool seen_palette = false;
+
+    std::size_t position = signature.size();
+    while (true) {
+        if (file.size() - position < 8) {
+            return Error::truncated;
+        }
+        const std::uint32_t length = load_be32(file.data() + position);
+        const std::uint32_t type = load_be32(file.data() + position + 4);
+        if (length > 0x7fffffffu) {
+            return Error::corrupt;
+        }
+        if (type == chunk_type("IDAT")) {
+            //image data is read as it streams, a short last chunk is the inflater's problem
+            if (!seen_header || (header.info.color_type == ColorType::palette && !seen_palette)) {
+                return Error::corrupt;
+            }
+            header.first_idat = position;
+            header.info.has_transparency = header.info.has_transparency || header.has_key
+                                        || header.info.color_type == ColorType::grey_alpha || header.info.color_type == ColorType::rgba;
+            return Error::none;
+        }
+        if (file.size() - position - 8 < std::size_t{length} + 4) {
+            return Error::truncated;
+        }
+        const std::uint8_t* data = file.data() + position + 8;
+
+        if (!seen_header) {
+            if (type != chunk_type("IHDR") || length != 13) {
+                return Error::corrupt;
+            }
+            Info& info = header.info;
+            info.width = load_be32(data);
+            info.height = load_be32(data + 4);
+            info.bit_depth = data[8];
+            info.color_type = static_cast<ColorType>(data[9]);
+            info.interlaced = data[12] == 1;
+            if (info.width == 0 || info.height == 0 || info.width > 0x7fffffffu || info.height > 0x7fffffffu
+                || data[10] != 0 || data[11] != 0 || data[12] > 1) {
+                return Error::corrupt;
+            }
+            const unsigned depth = info.bit_depth;
+            bool valid = false;
+            switch (info.color_type) {
+                case ColorType::grey:
+                    valid = depth == 1 || depth == 2 || depth == 4 || depth == 8 || depth == 16;
+                    break;
+                case ColorType::palette:
+                    valid = depth == 1 || depth == 2 || depth == 4 || depth == 8;
+                    break;
+                case ColorType::rgb:
+                case ColorType::grey_alpha:
+                case ColorType::rgba:
+                    valid = depth == 8 || depth == 16;
+                    break;
+                default:
+                    break;
+            }
+            if (!valid) {
+                return Error::corrupt;
+            }
+            seen_header = true;
+        } else if (type == chunk_type("PLTE")) {
+            if (length % 3 != 0 || length > 3 * 256) {
+                return Error::corrupt;
+            }
+            for (std::uint32_t i = 0; i < length / 3; i++) {
+                header.palette[i] = RGBA8(data[3 * i], data[3 * i + 1], data[3 * i + 2], 255);
+            }
+            seen_palette = true;
+        } else if (type == chunk_type("tRNS")) {
+            switch (header.info.color_type) {
+                case ColorType::palette:
+                    for (std::uint32_t i = 0; i < std::min<std::uint32_t>(length, 256); i++) {
+                        header.palette[i].A = data[i];
+                    }
+                    header.has_key = false;
+                    header.info.has_transparency = true;
+                    break;
+                case ColorType::grey:
+                    if (length >= 2) {
+                        header.key[0] = static_cast<std::uint16_t>((data[0] << 8) | data[1]);
+                        header.has_key = true;
+                    }
+                    break;
+                case ColorType::rgb:
+                    if (length >= 6) {
+                        for (std::size_t c = 0; c < 3; c++) {
+                            header.key[c] = static_cast<std::uint16_t>((data[2 * c] << 8) | data[2 * c + 1]);
+                        }
+                        header.has_key = true;
+                    }
+                    break;
+                default:
+                    break; //not allowed alongside an alpha channel, ignore it like everybody else does
+            }
+        } else if (type == chunk_type("IEND")) {
+            return Error::corrupt; //no image data
+        } else if ((type & (std::uint32_t{0x20} << 24)) == 0) {
+            return Error::unsupported; //a critical chunk we don't know, the image can't be shown without it
+        }
+        position += 12 + std::size_t{length};
+    }
+}
+
+inline std::span<const std::uint8_t> ES::png::Secret::IdatSource::next() noexcept {
+    while (position <= file.size() && file.size() - position >= 8) {
+        if (load_be32(file.data() + position + 4) != chunk_type("IDAT")) {
+            return {};
+        }
+        const std::size_t begin = position + 8;
+        const std::size_t length = load_be32(file.data() + position);
+        const std::size_t available = std::min(length, file.size() - begin);
+        position = begin + length + 4; //past the CRC
+        if (available > 0) {
+            return file.subspan(begin, available);
+        }
+    }
+    return {};
+}
+
+template <std::size_t Bpp>
+void ES::png::Secret::unfilter(const std::uint8_t filter, std::uint8_t* ES_RESTRICT row, const std::uint8_t* ES_RESTRICT prior, const std::size_t length) noexcept {
+    switch (filter) {
+        case 1: //Sub
+            for (std::size_t i = 0; i < length; i += Bpp) {
+                for (std::size_t c = 0; c < Bpp; c++) {
+                    row[i + c] = static_cast<std::uint8_t>(row[i + c] + row[i + c - Bpp]);
+                }
+            }
+            return;
+        case 2: //Up
+            ES_VECTORIZE
+            for (std::size_t i = 0; i < length; i++) {
+                row[i] = static_cast<std::uint8_t>(row[i] + prior[i]);
+            }
+            return;
+        case 3: { //Average
+            std::array<std::uint8_t, Bpp> left{};
+            for (std::size_t i = 0; i < length; i += Bpp) {
+                for (std::size_t c = 0; c < Bpp; c++) {
+                    left[c] = static_cast<std::uint8_t>(row[i + c] + ((left[c] + prior[i + c]) >> 1));
+                    row[i + c] = left[c];
+                }
+            }
+            return;
+        }
+        case 4: { //Paeth
+            std::array<std::uint8_t, Bpp> left{};
+            std::array<std::uint8_t, Bpp> upper_left{};
+            for (std::size_t i = 0; i < length; i += Bpp) {
+                for (std::size_t c = 0; c < Bpp; c++) {
+                    const std::uint8_t up = prior[i + c];
+                    left[c] = static_cast<std::uint8_t>(row[i + c] + paeth(left[c], up, upper_left[c]));
+                    upper_left[c] = up;
+                    row[i + c] = left[c];
+                }
+            }
+            return;
+        }
+        default: //None
+            return;
+    }
+}
+
+inline bool ES::png::Secret::unfilter_row(const std::uint8_t filter, std::uint8_t* row, const std::uint8_t* prior, const std::size_t length, const std::size_t bpp) noexcept {
+    if (filter > 4) {
+        return false;
+    }
+    switch (bpp) {
+        case 1: unfilter<1>(filter, row, prior, length); break;
+        case 2: unfilter<2>(filter, row, prior, length); break;
+        case 3: unfilter<3>(filter, row, prior, length); break;
+        case 4: unfilter<4>(filter, row, prior, length); break;
+        case 6: unfilter<6>(filter, row, prior, length); break;
+        case 8: unfilter<8>(filter, row, prior, length); break;
+        default: return false;
+    }
+    return true;
+}
+
+template <ES::png::DecodedPixel Pixel>
+void ES::png::Secret::expand_row(const Header& header, const std::uint8_t* ES_RESTRICT src, const std::size_t count, Pixel* ES_RESTRICT dst, const std::size_t step) noexcept {
+    constexpr bool has_alpha = std::same_as<Pixel, RGBA8>;
+    const unsigned depth = header.info.bit_depth;
+    const bool keyed = header.has_key;
+    const auto [key_r, key_g, key_b] = header.key;
+
+    switch (header.info.color_type) {
+        case ColorType::rgba:
+            if (depth == 8) {
+                if (has_alpha && step == 1) {
+                    std::memcpy(static_cast<void*>(dst), src, 4 * count);
+                    return;
+                }
+                for (std::size_t x = 0; x < count; x++) {
+                    dst[x * step] = make_pixel<Pixel>(src[4 * x], src[4 * x + 1], src[4 * x + 2], src[4 * x + 3]);
+                }
+            } else {
+                for (std::size_t x = 0; x < count; x++) {
+                    dst[x * step] = make_pixel<Pixel>(src[8 * x], src[8 * x + 2], src[8 * x + 4], src[8 * x + 6]);
+                }
+            }
+            return;
+        case ColorType::rgb:
+            if (depth == 8) {
+                if (!has_alpha && step == 1) {
+                    std::memcpy(static_cast<void*>(dst), src, 3 * count);
+                    return;
+                }
+                for (std::size_t x = 0; x < count; x++) {
+                    const std::uint8_t r = src[3 * x], g = src[3 * x + 1], b = src[3 * x + 2];
+                    const bool clear = keyed && r == key_r && g == key_g && b == key_b;
+                    dst[x * step] = make_pixel<Pixel>(r, g, b, clear ? 0 : 255);
+                }
+            } else {
+                for (std::size_t x = 0; x < count; x++) {
+                    const std::uint8_t* s = src + 6 * x;
+                    const bool clear = keyed && ((s[0] << 8) | s[1]) == key_r && ((s[2] << 8) | s[3]) == key_g
+                                    && ((s[4] << 8) | s[5]) == key_b;
+                    dst[x * step] = make_pixel<Pixel>(s[0], s[2], s[4], clear ? 0 : 255);
+                }
+            }
+            return;
+        case ColorType::grey_alpha: {
+            const std::size_t stride = depth / 4; //bytes per pixel, the high byte of each sample comes first
+            for (std::size_t x = 0; x < count; x++) {
+                const std::uint8_t v = src[stride * x];
+                dst[x * step] = make_pixel<Pixel>(v, v, v, src[stride * x + stride / 2]);
+            }
+            return;
+        }
+        case ColorType::grey:
+            if (depth == 16) {
+                for (std::size_t x = 0; x < count; x++) {
+                    const bool clear = keyed && ((src[2 * x] << 8) | src[2 * x + 1]) == key_r;
+                    dst[x * step] = make_pixel<Pixel>(src[2 * x], src[2 * x], src[2 * x], clear ? 0 : 255);
+                }
+            } else if (depth == 8) {
+                for (std::size_t x = 0; x < count; x++) {
+                    const std::uint8_t v = src[x];
+                    dst[x * step] = make_pixel<Pixel>(v, v, v, keyed && v == key_r ? 0 : 255);
+                }
+            } else {
+                //1, 2 or 4 bits, packed from the high end of each byte, scaled so the top value is 255
+                const unsigned mask = (1u << depth) - 1;
+                const unsigned scale = 255 / mask;
+                for (std::size_t x = 0; x < count; x++) {
+                    const std::size_t bit = x * depth;
+                    const unsigned sample = (src[bit / 8] >> (8 - depth - bit % 8)) & mask;
+                    const auto v = static_cast<std::uint8_t>(sample * scale);
+                    dst[x * step] = make_pixel<Pixel>(v, v, v, keyed && sample == key_r ? 0 : 255);
+                }
+            }
+            return;
+        case ColorType::palette: {
+            const auto& palette = header.palette;
+            if (depth == 8) {
+                for (std::size_t x = 0; x < count; x++) {
+                    const RGBA8 entry = palette[src[x]];
+                    dst[x * step] = make_pixel<Pixel>(entry.R, entry.G, entry.B, entry.A);
+                }
+                return;
+            }
+            const unsigned mask = (1u << depth) - 1;
+            for (std::size_t x = 0; x < count; x++) {
+                const std::size_t bit = x * depth;
+                const RGBA8 entry = palette[(src[bit / 8] >> (8 - depth - bit % 8)) & mask];
+                dst[x * step] = make_pixel<Pixel>(entry.R, entry.G, entry.B, entry.A);
+            }
+            return;
+        }
+    }
+}
+
+inline ES::png::Error ES::png::read_info(const std::span<const std::uint8_t> file, Info& info) noexcept {
+    Secret::Header header;
+    const Error error = Secret::parse(file, header);
+    if (error == Error::none) {
+        info = header.info;
+    }
+    return error;
+}
+
+template <ES::png::DecodedPixel Pixel>
+ES::png::Error ES::png::decode(const std::span<const std::uint8_t> file, const ImageView<Pixel> out) {
+    Secret::Header header;
+    if (const Error error = Secret::parse(file, header); error != Error::none) {
+        return error;
+    }
+    const std::size_t width = header.info.width;
+    const std::size_t height = header.info.height;
+    if (out.width() != width || out.height() != height) {
+        return Error::wrong_size; //see read_info
+    }
+
+    zlib::Inflater<Secret::IdatSource> inflater(Secret::IdatSource{file, header.first_idat});
+    const std::size_t bits = header.bits_per_pixel();
+    const std::size_t bpp = std::max<std::size_t>(bits / 8, 1);
+
+    //two scanlines, each behind 8 zero bytes so the pixel left of the first one reads as zero without a special case.
+    //The filter type byte is read into the last of those and zeroed again
+    constexpr std::size_t lead = 8;
+    const std::size_t max_stride = (width * bits + 7) / 8;
+    std::vector<std::uint8_t> scanlines(2 * (lead + max_stride), 0);
+    std::uint8_t* current = scanlines.data();
+    std::uint8_t* prior = scanlines.data() + lead + max_stride;
+
+    auto decode_pass = [&](const Secret::Pass& pass) -> Error {
+        const std::size_t pass_width = width > pass.x ? (width - pass.x + pass.dx - 1) / pass.dx : 0;
+        const std::size_t pass_height = height > pass.y ? (height - pass.y + pass.dy - 1) / pass.dy : 0;
+        if (pass_width == 0 || pass_height == 0) {
+            return Error::none; //empty passes have no scanlines at all
+        }
+        const std::size_t stride = (pass_width * bits + 7) / 8;
+        std::fill_n(prior + lead, stride, std::uint8_t{0});
+
+        for (std::size_t row = 0; row < pass_height; row++) {
+            if (const zlib::Status status = inflater.read(std::span(current + lead - 1, stride + 1)); status != zlib::Status::ok) {
+                return Secret::from_status(status);
+            }
+            const std::uint8_t filter = std::exchange(current[lead - 1], std::uint8_t{0});
+            if (!Secret::unfilter_row(filter, current + lead, prior + lead, stride, bpp)) {
+                return Error::corrupt;
+            }
+            Secret::expand_row(header, current + lead, pass_width, out.row_data(pass.y + row * pass.dy) + pass.x, pass.dx);
+            std::swap(current, prior);
+        }
+        return Error::none;
+    };
+
+    if (!header.info.interlaced) {
+        return decode_pass(Secret::Pass{0, 0, 1, 1});
+    }
+    for (const Secret::Pass& pass : Secret::adam7) {
+        if (const Error error = decode_pass(pass); error != Error::none) {
+            return error;
+        }
+    }
+    return Error::none;
+}
+
+template <ES::png::DecodedPixel Pixel>
+ES::png::Error ES::png::decode(const std::span<const std::uint8_t> file, Image<Pixel>& out) {
+    Info info;
+    if (const Error error = read_info(file, info); error != Error::none) {
+        return error;
+    }
+    out = Image<Pixel>(info.width, info.height);
+    return decode(file, out.view());
+}
+
+template <ES::png::DecodedPixel Pixel>
+ES::png::Error ES::png::load(const std::filesystem::path& path, Image<Pixel>& out) {
+    std::ifstream stream(path, std::ios::binary | std::ios::ate);
+    if (!stream) {
+        return Error::io;
+    }
+    std::vector<std::uint8_t> file(static_cast<std::size_t>(stream.tellg()));
+    stream.seekg(0);
+    if (!stream.read(reinterpret_cast<char*>(file.data()), static_cast<std::streamsize>(file.size()))) {
+        return Error::io;
+    }
+    return decode(std::span<const std::uint8_t>(file), out);
+}
+
+template <std::size_t Bpp>
+void ES::png::Secret::filter_paeth(const std::uint8_t* ES_RESTRICT row, const std::uint8_t* ES_RESTRICT prior, std::uint8_t* ES_RESTRICT out, const std::size_t length) noexcept {
+    for (std::size_t i = 0; i < Bpp; i++) {
+        out[i] = static_cast<std::uint8_t>(row[i] - prior[i]); //nothing to the left: Paeth picks up
+    }
+    ES_VECTORIZE
+    for (std::size_t i = Bpp; i < length; i++) {
+        out[i] = static_cast<std::uint8_t>(row[i] - paeth(row[i - Bpp], prior[i], prior[i - Bpp]));
+    }
+}
+
+inline void ES::png::Secret::append_be32(std::vector<std::uint8_t>& out, const std::uint32_t value) {
+    out.insert(out.end(), {std::uint8_t(value >> 24), std::uint8_t(value >> 16), std::uint8_t(value >> 8), std::uint8_t(value)});
+}
+
+inline void ES::png::Secret::append_chunk(std::vector<std::uint8_t>& out, const std::uint32_t type, const std::span<const std::uint8_t> data) {
+    append_be32(out, static_cast<std::uint32_t>(data.size()));
+    const std::size_t crc_from = out.size();
+    append_be32(out, type);
+    out.insert(out.end(), data.begin(), data.end());
+    append_be32(out, zlib::crc32(std::span(out).subspan(crc_from)));
+}
+
+template <typename Pixel, ES::io::ByteSink Sink> requires ES::png::DecodedPixel<std::remove_const_t<Pixel>>
+bool ES::png::encode(const ImageView<Pixel> image, Sink& sink, parallel::ThreadPool& pool) {
+    constexpr std::size_t bpp = sizeof(std::remove_const_t<Pixel>);
+    static_assert(bpp == 3 || bpp == 4, "RGB8 and RGBA8 are plain bytes");
+    assert(!image.empty() && "png::encode has no way to say an empty image");
+
+    const std::size_t width = image.width();
+    const std::size_t height = image.height();
+    const std::size_t stride = width * bpp;
+    const std::size_t rows_per_band = std::max<std::size_t>(1, encode_band_bytes / (stride + 1));
+    const std::size_t band_count = (height + rows_per_band - 1) / rows_per_band;
+
+    //each band is a finished IDAT chunk, the zlib header in front of the first, and its own Adler-32 on the side
+    std::vector<std::vector<std::uint8_t>> chunks(band_count);
+    std::vector<std::uint32_t> adlers(band_count);
+    const std::vector<std::uint8_t> zero_row(stride, 0);
+    const auto row_bytes = [&](std::size_t y) {
+        return reinterpret_cast<const std::uint8_t*>(image.row_data(y));
+    };
+
+    parallel::for_chunks(band_count, 1, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t band = begin; band < end; band++) {
+            const std::size_t first = band * rows_per_band;
+            const std::size_t last = std::min(height, first + rows_per_band);
+            std::vector<std::uint8_t> filtered((stride + 1) * (last - first));
+            for (std::size_t y = first; y < last; y++) {
+                std::uint8_t* out = filtered.data() + (y - first) * (stride + 1);
+                out[0] = 4; //Paeth
+                Secret::filter_paeth<bpp>(row_bytes(y), y > 0 ? row_bytes(y - 1) : zero_row.data(), out + 1, stride);
+            }
+            adlers[band] = zlib::adler32(filtered);
+
+            std::vector<std::uint8_t>& chunk = chunks[band];
+            chunk.reserve(filtered.size() + filtered.size() / 8 + 32);
+            Secret::append_be32(chunk, 0); //length, once it's known
+            Secret::append_be32(chunk, Secret::chunk_type("IDAT"));
+            if (band == 0) {
+                chunk.insert(chunk.end(), {0x78, 0x01});
+            }
+            zlib::deflate_fast(filtered, chunk, band + 1 == band_count);
+            const auto length = static_cast<std::uint32_t>(chunk.size() - 8);
+            const std::uint32_t crc = zlib::crc32(std::span(chunk).subspan(4));
+            for (std::size_t i = 0; i < 4; i++) {
+                chunk[i] = static_cast<std::uint8_t>(length >> (24 - 8 * i));
+            }
+            Secret::append_be32(chunk, crc);
+        }
+    }, pool);
+
+    std::vector<std::uint8_t> head(Secret::signature.begin(), Secret::signature.end());
+    std::vector<std::uint8_t> header;
+    Secret::append_be32(header, static_cast<std::uint32_t>(width));
+    Secret::append_be32(header, static_cast<std::uint32_t>(height));
+    header.insert(header.end(), {8, static_cast<std::uint8_t>(bpp == 4 ? ColorType::rgba : ColorType::rgb), 0, 0, 0});
+    Secret::append_chunk(head, Secret::chunk_type("IHDR"), header);
+    if (!sink.write(head)) {
+        return false;
+    }
+
+    std::uint32_t adler = 1;
+    for (std::size_t band = 0; band < band_count; band++) {
+        if (!sink.write(chunks[band])) {
+            return false;
+        }
+        const std::size_t first = band * rows_per_band;
+        adler = zlib::adler32_combine(adler, adlers[band], (stride + 1) * (std::min(height, first + rows_per_band) - first));
+    }
+
+    //the checksum of everything comes last, in an IDAT of its own
+    std::vector<std::uint8_t> tail;
+    std::vector<std::uint8_t> checksum;
+    Secret::append_be32(checksum, adler);
+    Secret::append_chunk(tail, Secret::chunk_type("IDAT"), checksum);
+    Secret::append_chunk(tail, Secret::chunk_type("IEND"), {});
+    return sink.write(tail);
+}
+
+template <ES::png::DecodedPixel Pixel, ES::io::ByteSink Sink>
+bool ES::png::encode(const Image<Pixel>& image, Sink& sink, parallel::ThreadPool& pool) {
+    return encode(image.view(), sink, pool);
+}
+
+#endif //COMPUTERGRAPHICS_ESPNG_HPP
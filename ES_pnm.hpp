@@ -0,0 +1,158 @@
+#ifndef COMPUTERGRAPHICS_ESPNM_HPP
+#define COMPUTERGRAPHICS_ESPNM_HPP
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include "ES_io.hpp"
+#include "ES_parallel.hpp"
+#include "ES_simd.hpp"
+#include "ColorN.hpp"
+#include "Image.hpp"
+
+/*
+ * Binary PPM (8 bit sRGB) and PFM (32 bit float, linear) writers, the formats every image tool reads and nothing has
+ * to decode. Both are the pixels nearly as they sit in memory, so where they do sit that way the writers hand the
+ * image's own rows to the sink: RGB8 rows are PPM rows, and RGB rows are PFM rows (PFM goes bottom to top and gets
+ * its byte order from the sign of its scale, so a flipped view of an Image<RGB> is already a PFM body on any host).
+ * RGBA8 sheds its alpha into band buffers first, on the pool.
+ */
+
+//SIGNATURES AND FRIENDS
+namespace ES::pnm {
+
+    /// Rows a writer converts on one thread, about this many bytes of them.
+    inline constexpr std::size_t encode_band_bytes = std::size_t{1} << 18;
+
+    template <typename Pixel>
+    concept PpmPixel = std::same_as<Pixel, RGBA8> || std::same_as<Pixel, RGB8>;
+
+    /**
+     * @brief Writes image as a binary (P6) PPM into sink, dropping any alpha.
+     * @return false if the sink stopped taking bytes
+     */
+    template <typename Pixel, io::ByteSink Sink> requires PpmPixel<std::remove_const_t<Pixel>>
+    [[nodiscard]] bool write_ppm(ImageView<Pixel> image, Sink& sink, parallel::ThreadPool& pool = parallel::default_pool());
+
+    template <PpmPixel Pixel, io::ByteSink Sink>
+    [[nodiscard]] bool write_ppm(const Image<Pixel>& image, Sink& sink, parallel::ThreadPool& pool = parallel::default_pool());
+
+    /**
+     * @brief Writes image as a colour PFM into sink, floats untouched.
+     * @return false if the sink stopped taking bytes
+     */
+    template <typename Pixel, io::ByteSink Sink> requires std::same_as<std::remove_const_t<Pixel>, RGB>
+    [[nodiscard]] bool write_pfm(ImageView<Pixel> image, Sink& sink);
+
+    template <io::ByteSink Sink>
+    [[nodiscard]] bool write_pfm(const Image<RGB>& image, Sink& sink);
+
+}
+
+namespace ES::pnm::Secret {
+
+    template <typename Pixel, io::ByteSink Sink>
+    [[nodiscard]] bool write_header(Sink& sink, const char* magic, const ImageView<Pixel>& image, const char* last_line);
+
+    //rows straight from the image: one write when they're back to back, one a row otherwise
+    template <typename Pixel, io::ByteSink Sink>
+    [[nodiscard]] bool write_rows(Sink& sink, const ImageView<Pixel>& image);
+
+}
+
+//DEFINITIONS
+
+template <typename Pixel, ES::io::ByteSink Sink>
+bool ES::pnm::Secret::write_header(Sink& sink, const char* magic, const ImageView<Pixel>& image, const char* last_line) {
+    const std::string header = std::string(magic) + "\n" + std::to_string(image.width()) + " " + std::to_string(image.height())
+                             + "\n" + last_line + "\n";
+    return sink.write(std::span(reinterpret_cast<const std::uint8_t*>(header.data()), header.size()));
+}
+
+template <typename Pixel, ES::io::ByteSink Sink>
+bool ES::pnm::Secret::write_rows(Sink& sink, const ImageView<Pixel>& image) {
+    const auto bytes = [](const auto* data, std::size_t count) {
+        return std::span(reinterpret_cast<const std::uint8_t*>(data), count * sizeof(Pixel));
+    };
+    if (image.is_contiguous()) {
+        return sink.write(bytes(image.data(), image.size()));
+    }
+    for (std::size_t y = 0; y < image.height(); y++) {
+        if (!sink.write(bytes(image.row_data(y), image.width()))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+template <typename Pixel, ES::io::ByteSink Sink> requires ES::pnm::PpmPixel<std::remove_const_t<Pixel>>
+bool ES::pnm::write_ppm(const ImageView<Pixel> image, Sink& sink, parallel::ThreadPool& pool) {
+    if (!Secret::write_header(sink, "P6", image, "255")) {
+        return false;
+    }
+    if constexpr (std::same_as<std::remove_const_t<Pixel>, RGB8>) {
+        static_assert(sizeof(RGB8) == 3, "RGB8 rows are PPM rows");
+        return Secret::write_rows(sink, image);
+    } else {
+        const std::size_t width = image.width();
+        const std::size_t height = image.height();
+        const std::size_t rows_per_band = std::max<std::size_t>(1, encode_band_bytes / std::max<std::size_t>(1, 3 * width));
+        const std::size_t band_count = (height + rows_per_band - 1) / rows_per_band;
+
+        std::vector<std::vector<std::uint8_t>> bands(band_count);
+        parallel::for_chunks(band_count, 1, [&](std::size_t begin, std::size_t end) {
+            for (std::size_t band = begin; band < end; band++) {
+                const std::size_t first = band * rows_per_band;
+                const std::size_t last = std::min(height, first + rows_per_band);
+                std::vector<std::uint8_t>& out = bands[band];
+                out.resize(3 * width * (last - first));
+                std::uint8_t* ES_RESTRICT to = out.data();
+                for (std::size_t y = first; y < last; y++) {
+                    const RGBA8* ES_RESTRICT from = image.row_data(y);
+                    for (std::size_t x = 0; x < width; x++) {
+                        to[3 * x] = from[x].R;
+                        to[3 * x + 1] = from[x].G;
+                        to[3 * x + 2] = from[x].B;
+                    }
+                    to += 3 * width;
+                }
+            }
+        }, pool);
+
+        for (const auto& band : bands) {
+            if (!sink.write(band)) {
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+template <ES::pnm::PpmPixel Pixel, ES::io::ByteSink Sink>
+bool ES::pnm::write_ppm(const Image<Pixel>& image, Sink& sink, parallel::ThreadPool& pool) {
+    return write_ppm(image.view(), sink, pool);
+}
+
+template <typename Pixel, ES::io::ByteSink Sink> requires std::same_as<std::remove_const_t<Pixel>, ES::RGB>
+bool ES::pnm::write_pfm(const ImageView<Pixel> image, Sink& sink) {
+    static_assert(sizeof(RGB) == 3 * sizeof(float), "RGB rows are PFM rows");
+    static_assert(std::numeric_limits<float>::is_iec559, "PFM is IEEE floats");
+    //the scale's sign is the byte order: negative for little endian
+    const char* scale = std::endian::native == std::endian::little ? "-1.0" : "1.0";
+    return Secret::write_header(sink, "PF", image, scale) && Secret::write_rows(sink, image.flipped_vertically());
+}
+
+template <ES::io::ByteSink Sink>
+bool ES::pnm::write_pfm(const Image<RGB>& image, Sink& sink) {
+    return write_pfm(image.view(), sink);
+}
+
+#endif //COMPUTERGRAPHICS_ESPNM_HPP
@@ -0,0 +1,270 @@
+#ifndef COMPUTERGRAPHICS_ESQOI_HPP
+#define COMPUTERGRAPHICS_ESQOI_HPP
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "ES_io.hpp"
+#include "ES_parallel.hpp"
+#include "ColorN.hpp"
+#include "Image.hpp"
+
+/*
+ * QOI encoding (qoiformat.org), lossless and about as fast as lossless gets.
+ *
+ * QOI is one long chain: every op depends on the pixel before it, the run so far, and a 64 slot cache of pixels seen.
+ * All three are a function of the pixels alone though, so the chain can be cut. Each band of rows first works out
+ * what it leaves in the cache and how long a run it ends on, a quick pass; folding those together in order gives every
+ * band the exact state the serial encoder would have had on reaching it, and then the bands encode in parallel. The
+ * bytes are the same as encoding in one go.
+ */
+
+//SIGNATURES AND FRIENDS
+namespace ES::qoi {
+
+    /// Rows an encoder hands one thread, about this many bytes of them.
+    inline constexpr std::size_t encode_band_bytes = std::size_t{1} << 18;
+
+    /// The pixel types QOI encodes from: RGBA8 as 4 channels, RGB8 as 3. Colour is sRGB either way.
+    template <typename Pixel>
+    concept EncodedPixel = std::same_as<Pixel, RGBA8> || std::same_as<Pixel, RGB8>;
+
+    /**
+     * @brief Encodes image as QOI into sink.
+     * @return false if the sink stopped taking bytes
+     */
+    template <typename Pixel, io::ByteSink Sink> requires EncodedPixel<std::remove_const_t<Pixel>>
+    [[nodiscard]] bool encode(ImageView<Pixel> image, Sink& sink, parallel::ThreadPool& pool = parallel::default_pool());
+
+    template <EncodedPixel Pixel, io::ByteSink Sink>
+    [[nodiscard]] bool encode(const Image<Pixel>& image, Sink& sink, parallel::ThreadPool& pool = parallel::default_pool());
+
+}
+
+namespace ES::qoi::Secret {
+
+    inline constexpr std::uint8_t op_index = 0x00;
+    inline constexpr std::uint8_t op_diff = 0x40;
+    inline constexpr std::uint8_t op_luma = 0x80;
+    inline constexpr std::uint8_t op_run = 0xc0;
+    inline constexpr std::uint8_t op_rgb = 0xfe;
+    inline constexpr std::uint8_t op_rgba = 0xff;
+    inline constexpr std::size_t max_run = 62;
+
+    //pixels travel packed, R in the low byte, so comparing two is comparing two words
+    inline constexpr std::uint32_t start_pixel = 0xff000000u; //opaque black, what the decoder starts from
+
+    [[nodiscard]] constexpr std::uint32_t pack(const RGBA8& p) noexcept {
+        return std::uint32_t{p.R} | (std::uint32_t{p.G} << 8) | (std::uint32_t{p.B} << 16) | (std::uint32_t{p.A} << 24);
+    }
+    [[nodiscard]] constexpr std::uint32_t pack(const RGB8& p) noexcept {
+        return std::uint32_t{p.R} | (std::uint32_t{p.G} << 8) | (std::uint32_t{p.B} << 16) | 0xff000000u;
+    }
+
+    [[nodiscard]] constexpr std::uint32_t hash(std::uint32_t p) noexcept {
+        return ((p & 0xff) * 3 + ((p >> 8) & 0xff) * 5 + ((p >> 16) & 0xff) * 7 + (p >> 24) * 11) % 64;
+    }
+
+    //where the serial encoder stands on reaching a pixel
+    struct State {
+        std::array<std::uint32_t, 64> cache{};
+        std::uint32_t previous = start_pixel;
+        std::size_t run = 0;
+    };
+
+    //what a band does to the state: the cache slots it sets, and the run it ends on
+    struct Summary {
+        std::array<std::uint32_t, 64> cache{};
+        std::uint64_t written = 0;   //bit per cache slot
+        std::size_t trailing_run = 0;
+        bool all_run = true;         //every pixel repeats the one before, so the run carries in from before the band
+    };
+
+    template <typename Pixel>
+    [[nodiscard]] Summary summarize(ImageView<Pixel> image, std::size_t first_row, std::size_t last_row, std::uint32_t previous) noexcept;
+
+    //the band's ops into out, which has room for the worst case. last says whether the image ends with this band
+    template <typename Pixel>
+    [[nodiscard]] std::uint8_t* encode_band(ImageView<Pixel> image, std::size_t first_row, std::size_t last_row, State state,
+                                            bool last, std::uint8_t* out) noexcept;
+
+}
+
+//DEFINITIONS
+
+template <typename Pixel>
+ES::qoi::Secret::Summary ES::qoi::Secret::summarize(const ImageView<Pixel> image, const std::size_t first_row, const std::size_t last_row,
+                                                    std::uint32_t previous) noexcept {
+    //the encoder only ever writes a pixel into the cache when it differs from the one before, and on leaving the
+    //slot holds that pixel whether it was written or already there
+    Summary summary;
+    std::size_t run = 0;
+    for (std::size_t y = first_row; y < last_row; y++) {
+        for (const auto& pixel : image.row(y)) {
+            const std::uint32_t p = pack(pixel);
+            if (p == previous) {
+                run++;
+                continue;
+            }
+            const std::uint32_t slot = hash(p);
+            summary.cache[slot] = p;
+            summary.written |= std::uint64_t{1} << slot;
+            summary.all_run = false;
+            run = 0;
+            previous = p;
+        }
+    }
+    summary.trailing_run = run;
+    return summary;
+}
+
+template <typename Pixel>
+std::uint8_t* ES::qoi::Secret::encode_band(const ImageView<Pixel> image, const std::size_t first_row, const std::size_t last_row, State state,
+                                           const bool last, std::uint8_t* out) noexcept {
+    std::uint32_t previous = state.previous;
+    std::size_t run = state.run;
+    auto& cache = state.cache;
+
+    for (std::size_t y = first_row; y < last_row; y++) {
+        for (const auto& pixel : image.row(y)) {
+            const std::uint32_t p = pack(pixel);
+            if (p == previous) {
+                if (++run == max_run) {
+                    *out++ = static_cast<std::uint8_t>(op_run | (run - 1));
+                    run = 0;
+                }
+                continue;
+            }
+            if (run > 0) {
+                *out++ = static_cast<std::uint8_t>(op_run | (run - 1));
+                run = 0;
+            }
+
+            const std::uint32_t slot = hash(p);
+            if (cache[slot] == p) {
+                *out++ = static_cast<std::uint8_t>(op_index | slot);
+                previous = p;
+                continue;
+            }
+            cache[slot] = p;
+
+            if ((p >> 24) != (previous >> 24)) {
+                *out++ = op_rgba;
+                for (int shift = 0; shift < 32; shift += 8) {
+                    *out++ = static_cast<std::uint8_t>(p >> shift);
+                }
+                previous = p;
+                continue;
+            }
+            //wrapping byte differences, as the decoder adds them back
+            const auto vr = static_cast<std::int8_t>(static_cast<std::uint8_t>(p - previous));
+            const auto vg = static_cast<std::int8_t>(static_cast<std::uint8_t>((p >> 8) - (previous >> 8)));
+            const auto vb = static_cast<std::int8_t>(static_cast<std::uint8_t>((p >> 16) - (previous >> 16)));
+            const int vg_r = vr - vg;
+            const int vg_b = vb - vg;
+            if (vr >= -2 && vr <= 1 && vg >= -2 && vg <= 1 && vb >= -2 && vb <= 1) {
+                *out++ = static_cast<std::uint8_t>(op_diff | ((vr + 2) << 4) | ((vg + 2) << 2) | (vb + 2));
+            } else if (vg_r >= -8 && vg_r <= 7 && vg >= -32 && vg <= 31 && vg_b >= -8 && vg_b <= 7) {
+                *out++ = static_cast<std::uint8_t>(op_luma | (vg + 32));
+                *out++ = static_cast<std::uint8_t>(((vg_r + 8) << 4) | (vg_b + 8));
+            } else {
+                *out++ = op_rgb;
+                *out++ = static_cast<std::uint8_t>(p);
+                *out++ = static_cast<std::uint8_t>(p >> 8);
+                *out++ = static_cast<std::uint8_t>(p >> 16);
+            }
+            previous = p;
+        }
+    }
+    if (last && run > 0) {
+        *out++ = static_cast<std::uint8_t>(op_run | (run - 1));
+    }
+    return out;
+}
+
+template <typename Pixel, ES::io::ByteSink Sink> requires ES::qoi::EncodedPixel<std::remove_const_t<Pixel>>
+bool ES::qoi::encode(const ImageView<Pixel> image, Sink& sink, parallel::ThreadPool& pool) {
+    constexpr std::uint8_t channels = std::same_as<std::remove_const_t<Pixel>, RGBA8> ? 4 : 3;
+    assert(!image.empty() && "qoi::encode has no way to say an empty image");
+
+    const std::size_t width = image.width();
+    const std::size_t height = image.height();
+    const std::size_t rows_per_band = std::max<std::size_t>(1, encode_band_bytes / (width * channels));
+    const std::size_t band_count = (height + rows_per_band - 1) / rows_per_band;
+    const auto band_rows = [&](std::size_t band) {
+        return std::pair{band * rows_per_band, std::min(height, (band + 1) * rows_per_band)};
+    };
+    const auto pixel_before = [&](std::size_t row) {
+        return row == 0 ? Secret::start_pixel : Secret::pack(image(width - 1, row - 1));
+    };
+
+    //every band's starting state: from the summaries when there is more than one
+    std::vector<Secret::State> states(band_count);
+    if (band_count > 1) {
+        std::vector<Secret::Summary> summaries(band_count);
+        parallel::for_chunks(band_count - 1, 1, [&](std::size_t begin, std::size_t end) {
+            for (std::size_t band = begin; band < end; band++) {
+                const auto [first, last] = band_rows(band);
+                summaries[band] = Secret::summarize(image, first, last, pixel_before(first));
+            }
+        }, pool);
+
+        std::size_t run = 0; //the whole run, not yet cut into max_run pieces
+        for (std::size_t band = 1; band < band_count; band++) {
+            const Secret::Summary& summary = summaries[band - 1];
+            const auto [first, last] = band_rows(band - 1);
+            Secret::State& state = states[band];
+            state.cache = states[band - 1].cache;
+            for (std::size_t slot = 0; slot < 64; slot++) {
+                if ((summary.written >> slot) & 1u) {
+                    state.cache[slot] = summary.cache[slot];
+                }
+            }
+            run = summary.all_run ? run + (last - first) * width : summary.trailing_run;
+            state.run = run % Secret::max_run;
+            state.previous = pixel_before(last);
+        }
+    }
+
+    //worst case is a whole RGB or RGBA op a pixel, after the op_run that flushes a run carried in from the band before
+    std::vector<std::vector<std::uint8_t>> bands(band_count);
+    parallel::for_chunks(band_count, 1, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t band = begin; band < end; band++) {
+            const auto [first, last] = band_rows(band);
+            std::vector<std::uint8_t>& out = bands[band];
+            out.resize((last - first) * width * (channels + 1) + 1);
+            const std::uint8_t* written = Secret::encode_band(image, first, last, states[band], band + 1 == band_count, out.data());
+            out.resize(static_cast<std::size_t>(written - out.data()));
+        }
+    }, pool);
+
+    const std::array<std::uint8_t, 14> header = {
+        'q', 'o', 'i', 'f',
+        std::uint8_t(width >> 24), std::uint8_t(width >> 16), std::uint8_t(width >> 8), std::uint8_t(width),
+        std::uint8_t(height >> 24), std::uint8_t(height >> 16), std::uint8_t(height >> 8), std::uint8_t(height),
+        channels, 0};
+    if (!sink.write(header)) {
+        return false;
+    }
+    for (const auto& band : bands) {
+        if (!sink.write(band)) {
+            return false;
+        }
+    }
+    constexpr std::array<std::uint8_t, 8> end_marker = {0, 0, 0, 0, 0, 0, 0, 1};
+    return sink.write(end_marker);
+}
+
+template <ES::qoi::EncodedPixel Pixel, ES::io::ByteSink Sink>
+bool ES::qoi::encode(const Image<Pixel>& image, Sink& sink, parallel::ThreadPool& pool) {
+    return encode(image.view(), sink, pool);
+}
+
+#endif //COMPUTERGRAPHICS_ESQOI_HPP
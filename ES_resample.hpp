@@ -0,0 +1,376 @@
+#ifndef COMPUTERGRAPHICS_ESRESAMPLE_HPP
+#define COMPUTERGRAPHICS_ESRESAMPLE_HPP
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <numbers>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+#include "ES_parallel.hpp"
+#include "ES_simd.hpp"
+#include "ES_srgb.hpp"
+#include "ColorN.hpp"
+#include "Image.hpp"
+
+/*
+ * Separable image resizing: box, bilinear, Mitchell-Netravali bicubic, Lanczos3 and Kaiser windowed sinc.
+ *
+ * Each axis is a list of contributors, for every target pixel the first source pixel it reads and a fixed number of
+ * weights from there on. Working that list out is the expensive part of a small resize, and the same sizes come up
+ * again and again, so lists are cached by (source size, target size, filter) and shared.
+ *
+ * The horizontal pass filters each source row and writes its results down a column of a transposed scratch image,
+ * one row per target column, so the vertical pass reads its taps along a row too. Both passes are then runs of
+ * contiguous multiply-adds, 3 or 4 channels at once, that compilers vectorize; the first splits the source rows
+ * into bands across the pool, the second the target columns.
+ *
+ * Filtering happens on linear, premultiplied light: RGB and RGBA go straight in, RGB8 and RGBA8 are decoded from sRGB
+ * (and premultiplied) on the way in and encoded back on the way out, so edges don't darken and transparent pixels
+ * don't bleed their colour. Bicubic and Lanczos overshoot; 8 bit output clamps, float output keeps the overshoot.
+ */
+
+//SIGNATURES AND FRIENDS
+namespace ES::resample {
+
+    enum class Filter {
+        box,      ///< averages what each target pixel covers; nearest neighbour when enlarging
+        bilinear, ///< the tent, bilinear interpolation when enlarging
+        mitchell, ///< Mitchell-Netravali cubic (B = C = 1/3), sharp with little ringing
+        lanczos3, ///< windowed sinc over 3 lobes, sharpest, rings a little at hard edges
+        kaiser    ///< sinc over 3 lobes under a Kaiser window (alpha 4), a touch softer than Lanczos3 and rings less
+    };
+
+    /// How one axis of size source becomes one of size target: target pixel i is the sum over k < taps of
+    /// weights[i * taps + k] * source pixel first[i] + k. Every index is in range and every row of weights sums to 1.
+    struct Weights {
+        std::size_t source;
+        std::size_t target;
+        Filter filter;
+        std::size_t taps;
+        std::vector<std::size_t> first;
+        std::vector<float> weights;
+    };
+
+    /// The contributor list for one axis, made once and shared after.
+    [[nodiscard]] std::shared_ptr<const Weights> weights(std::size_t source, std::size_t target, Filter filter);
+
+    /**
+     * @brief Resizes source to fill target, whatever their sizes.
+     */
+    void resize(ImageView<const RGB> source, ImageView<RGB> target, Filter filter, parallel::ThreadPool& pool = parallel::default_pool());
+    void resize(ImageView<const RGBA> source, ImageView<RGBA> target, Filter filter, parallel::ThreadPool& pool = parallel::default_pool());
+    void resize(ImageView<const RGB8> source, ImageView<RGB8> target, Filter filter, parallel::ThreadPool& pool = parallel::default_pool());
+    void resize(ImageView<const RGBA8> source, ImageView<RGBA8> target, Filter filter, parallel::ThreadPool& pool = parallel::default_pool());
+
+    /// source resized into a new width x height image.
+    template <typename Pixel>
+    [[nodiscard]] Image<Pixel> resized(const Image<Pixel>& source, std::size_t width, std::size_t height, Filter filter,
+                                       parallel::ThreadPool& pool = parallel::default_pool());
+
+}
+
+namespace ES::resample::Secret {
+
+    //how far each filter reaches either side of its centre, at scale 1
+    [[nodiscard]] constexpr double support(Filter filter) noexcept;
+
+    [[nodiscard]] double evaluate(Filter filter, double x) noexcept;
+
+    //the zeroth order modified Bessel function of the first kind, which the Kaiser window is made of
+    [[nodiscard]] double bessel_i0(double x) noexcept;
+
+    [[nodiscard]] Weights make_weights(std::size_t source, std::size_t target, Filter filter);
+
+    //lists stay until there are this many, then the lot goes; resizes come in a handful of sizes
+    inline constexpr std::size_t cache_limit = 64;
+
+    //a row of pixels as linear premultiplied floats, Channels to a pixel, and back
+    inline void load_row(const RGB* in, float* out, std::size_t width) noexcept;
+    inline void load_row(const RGBA* in, float* out, std::size_t width) noexcept;
+    inline void load_row(const RGB8* in, float* out, std::size_t width) noexcept;
+    inline void load_row(const RGBA8* in, float* out, std::size_t width) noexcept;
+    inline void store(const float* in, RGB& out) noexcept;
+    inline void store(const float* in, RGBA& out) noexcept;
+    inline void store(const float* in, RGB8& out) noexcept;
+    inline void store(const float* in, RGBA8& out) noexcept;
+
+    template <typename Pixel>
+    inline constexpr std::size_t channels = std::is_same_v<Pixel, RGB> || std::is_same_v<Pixel, RGB8> ? 3 : 4;
+
+    //target columns the vertical pass does together, so its writes go out a short run of a row at a time
+    inline constexpr std::size_t column_block = 8;
+
+    template <typename Pixel>
+    void resize(ImageView<const Pixel> source, ImageView<Pixel> target, Filter filter, parallel::ThreadPool& pool);
+
+}
+
+//DEFINITIONS
+
+constexpr double ES::resample::Secret::support(const Filter filter) noexcept {
+    switch (filter) {
+        case Filter::box: return 0.5;
+        case Filter::bilinear: return 1.0;
+        case Filter::mitchell: return 2.0;
+        case Filter::lanczos3: return 3.0;
+        case Filter::kaiser: return 3.0;
+    }
+    return 1.0;
+}
+
+inline double ES::resample::Secret::evaluate(const Filter filter, double x) noexcept {
+    x = std::abs(x);
+    switch (filter) {
+        case Filter::box:
+            return x < 0.5 ? 1.0 : 0.0;
+        case Filter::bilinear:
+            return x < 1.0 ? 1.0 - x : 0.0;
+        case Filter::mitchell: {
+            constexpr double B = 1.0 / 3.0;
+            constexpr double C = 1.0 / 3.0;
+            if (x < 1.0) {
+                return ((12 - 9 * B - 6 * C) * x * x * x + (-18 + 12 * B + 6 * C) * x * x + (6 - 2 * B)) / 6.0;
+            }
+            if (x < 2.0) {
+                return ((-B - 6 * C) * x * x * x + (6 * B + 30 * C) * x * x + (-12 * B - 48 * C) * x + (8 * B + 24 * C)) / 6.0;
+            }
+            return 0.0;
+        }
+        case Filter::lanczos3: {
+            if (x < 1e-8) {
+                return 1.0;
+            }
+            if (x >= 3.0) {
+                return 0.0;
+            }
+            const double px = std::numbers::pi * x;
+            return 3.0 * std::sin(px) * std::sin(px / 3.0) / (px * px);
+        }
+        case Filter::kaiser: {
+            if (x >= 3.0) {
+                return 0.0;
+            }
+            constexpr double alpha = 4.0;
+            const double sinc = x < 1e-8 ? 1.0 : std::sin(std::numbers::pi * x) / (std::numbers::pi * x);
+            const double t = x / 3.0;
+            return sinc * bessel_i0(alpha * std::sqrt(1.0 - t * t)) / bessel_i0(alpha);
+        }
+    }
+    return 0.0;
+}
+
+inline double ES::resample::Secret::bessel_i0(const double x) noexcept {
+    //sum of ((x/2)^k / k!)^2, every term positive; 30 terms is plenty for the window's x <= 4
+    double sum = 1.0;
+    double term = 1.0;
+    for (int k = 1; k < 30 && term > sum * 1e-16; k++) {
+        const double factor = x / (2.0 * k);
+        term *= factor * factor;
+        sum += term;
+    }
+    return sum;
+}
+
+inline ES::resample::Weights ES::resample::Secret::make_weights(const std::size_t source, const std::size_t target, const Filter filter) {
+    assert(source > 0 && target > 0 && "resample::weights needs something to resample");
+    //shrinking stretches the filter over the source pixels each target pixel covers, enlarging leaves it as it is
+    const double scale = static_cast<double>(target) / static_cast<double>(source);
+    const double stretch = std::max(1.0, 1.0 / scale);
+    const double reach = support(filter) * stretch;
+    const std::size_t taps = std::min(source, static_cast<std::size_t>(std::ceil(2.0 * reach)) + 1);
+
+    Weights result{source, target, filter, taps, std::vector<std::size_t>(target), std::vector<float>(target * taps, 0.0f)};
+    std::vector<double> row(taps);
+    for (std::size_t i = 0; i < target; i++) {
+        const double centre = (static_cast<double>(i) + 0.5) / scale - 0.5;
+        const auto lowest = static_cast<std::ptrdiff_t>(std::floor(centre - reach)) + 1;
+        //the window slides to stay inside the image, and taps that fall off an edge land on the edge pixel
+        const auto first = std::clamp<std::ptrdiff_t>(lowest, 0, static_cast<std::ptrdiff_t>(source - taps));
+        std::fill(row.begin(), row.end(), 0.0);
+        double total = 0.0;
+        for (std::ptrdiff_t j = lowest; j < lowest + static_cast<std::ptrdiff_t>(std::ceil(2.0 * reach)) + 1; j++) {
+            const double w = evaluate(filter, (static_cast<double>(j) - centre) / stretch);
+            const std::ptrdiff_t clamped = std::clamp<std::ptrdiff_t>(j, 0, static_cast<std::ptrdiff_t>(source) - 1);
+            row[static_cast<std::size_t>(clamped - first)] += w;
+            total += w;
+        }
+        //box can come up empty when a target pixel falls between source centres exactly; then it's the nearest one
+        if (total == 0.0) {
+            const auto nearest = std::clamp<std::ptrdiff_t>(static_cast<std::ptrdiff_t>(std::llround(centre)), 0, static_cast<std::ptrdiff_t>(source) - 1);
+            row[static_cast<std::size_t>(nearest - first)] = 1.0;
+            total = 1.0;
+        }
+        result.first[i] = static_cast<std::size_t>(first);
+        for (std::size_t k = 0; k < taps; k++) {
+            result.weights[i * taps + k] = static_cast<float>(row[k] / total);
+        }
+    }
+    return result;
+}
+
+inline std::shared_ptr<const ES::resample::Weights> ES::resample::weights(const std::size_t source, const std::size_t target, const Filter filter) {
+    static std::mutex mutex;
+    static std::map<std::tuple<std::size_t, std::size_t, Filter>, std::shared_ptr<const Weights>> cache;
+
+    const auto key = std::tuple{source, target, filter};
+    {
+        std::lock_guard lock(mutex);
+        if (const auto found = cache.find(key); found != cache.end()) {
+            return found->second;
+        }
+    }
+    //made outside the lock; two threads racing on a new size both make it and one copy wins, which is fine
+    auto made = std::make_shared<const Weights>(Secret::make_weights(source, target, filter));
+    std::lock_guard lock(mutex);
+    if (cache.size() >= Secret::cache_limit) {
+        cache.clear();
+    }
+    return cache.try_emplace(key, std::move(made)).first->second;
+}
+
+inline void ES::resample::Secret::load_row(const RGB* in, float* out, const std::size_t width) noexcept {
+    for (std::size_t x = 0; x < width; x++) {
+        out[3 * x] = in[x].R();
+        out[3 * x + 1] = in[x].G();
+        out[3 * x + 2] = in[x].B();
+    }
+}
+
+inline void ES::resample::Secret::load_row(const RGBA* in, float* out, const std::size_t width) noexcept {
+    for (std::size_t x = 0; x < width; x++) {
+        for (std::size_t c = 0; c < 4; c++) {
+            out[4 * x + c] = in[x][c];
+        }
+    }
+}
+
+inline void ES::resample::Secret::load_row(const RGB8* in, float* out, const std::size_t width) noexcept {
+    for (std::size_t x = 0; x < width; x++) {
+        out[3 * x] = srgb::to_linear(in[x].R);
+        out[3 * x + 1] = srgb::to_linear(in[x].G);
+        out[3 * x + 2] = srgb::to_linear(in[x].B);
+    }
+}
+
+inline void ES::resample::Secret::load_row(const RGBA8* in, float* out, const std::size_t width) noexcept {
+    for (std::size_t x = 0; x < width; x++) {
+        const float a = in[x].A * (1.0f / 255.0f);
+        out[4 * x] = srgb::to_linear(in[x].R) * a;
+        out[4 * x + 1] = srgb::to_linear(in[x].G) * a;
+        out[4 * x + 2] = srgb::to_linear(in[x].B) * a;
+        out[4 * x + 3] = a;
+    }
+}
+
+inline void ES::resample::Secret::store(const float* in, RGB& out) noexcept {
+    out = RGB(in[0], in[1], in[2]);
+}
+
+inline void ES::resample::Secret::store(const float* in, RGBA& out) noexcept {
+    out = RGBA(in[0], in[1], in[2], in[3]);
+}
+
+inline void ES::resample::Secret::store(const float* in, RGB8& out) noexcept {
+    out = RGB8(srgb::to_srgb8(in[0]), srgb::to_srgb8(in[1]), srgb::to_srgb8(in[2]));
+}
+
+inline void ES::resample::Secret::store(const float* in, RGBA8& out) noexcept {
+    const float a = std::min(std::max(in[3], 0.0f), 1.0f);
+    const float unpremultiply = simd::select(a > 0.0f, 1.0f / a, 0.0f);
+    out = RGBA8(srgb::to_srgb8(in[0] * unpremultiply), srgb::to_srgb8(in[1] * unpremultiply), srgb::to_srgb8(in[2] * unpremultiply),
+                static_cast<std::uint8_t>(a * 255.0f + 0.5f));
+}
+
+template <typename Pixel>
+void ES::resample::Secret::resize(const ImageView<const Pixel> source, const ImageView<Pixel> target, const Filter filter, parallel::ThreadPool& pool) {
+    constexpr std::size_t N = channels<Pixel>;
+    if (source.empty() || target.empty()) {
+        return;
+    }
+    const std::shared_ptr<const Weights> across = weights(source.width(), target.width(), filter);
+    const std::shared_ptr<const Weights> down = weights(source.height(), target.height(), filter);
+    const std::size_t source_height = source.height();
+
+    //target.width() rows of source_height pixels: the horizontal pass's output, on its side
+    std::vector<float> turned(target.width() * source_height * N);
+
+    parallel::for_chunks(source_height, default_row_grain, [&](std::size_t begin, std::size_t end) {
+        std::vector<float> line(source.width() * N);
+        const std::size_t taps = across->taps;
+        for (std::size_t y = begin; y < end; y++) {
+            load_row(source.row_data(y), line.data(), source.width());
+            for (std::size_t x = 0; x < target.width(); x++) {
+                const float* ES_RESTRICT w = across->weights.data() + x * taps;
+                const float* ES_RESTRICT from = line.data() + across->first[x] * N;
+                float sum[N] = {};
+                for (std::size_t k = 0; k < taps; k++) {
+                    ES_VECTORIZE
+                    for (std::size_t c = 0; c < N; c++) {
+                        sum[c] += w[k] * from[k * N + c];
+                    }
+                }
+                float* ES_RESTRICT to = turned.data() + (x * source_height + y) * N;
+                for (std::size_t c = 0; c < N; c++) {
+                    to[c] = sum[c];
+                }
+            }
+        }
+    }, pool);
+
+    const std::size_t blocks = (target.width() + column_block - 1) / column_block;
+    parallel::for_chunks(blocks, 1, [&](std::size_t begin, std::size_t end) {
+        const std::size_t taps = down->taps;
+        for (std::size_t block = begin; block < end; block++) {
+            const std::size_t first_column = block * column_block;
+            const std::size_t columns = std::min(column_block, target.width() - first_column);
+            for (std::size_t y = 0; y < target.height(); y++) {
+                const float* ES_RESTRICT w = down->weights.data() + y * taps;
+                Pixel* out = target.row_data(y) + first_column;
+                for (std::size_t i = 0; i < columns; i++) {
+                    const float* ES_RESTRICT from = turned.data() + ((first_column + i) * source_height + down->first[y]) * N;
+                    float sum[N] = {};
+                    for (std::size_t k = 0; k < taps; k++) {
+                        ES_VECTORIZE
+                        for (std::size_t c = 0; c < N; c++) {
+                            sum[c] += w[k] * from[k * N + c];
+                        }
+                    }
+                    store(sum, out[i]);
+                }
+            }
+        }
+    }, pool);
+}
+
+inline void ES::resample::resize(const ImageView<const RGB> source, const ImageView<RGB> target, const Filter filter, parallel::ThreadPool& pool) {
+    Secret::resize(source, target, filter, pool);
+}
+
+inline void ES::resample::resize(const ImageView<const RGBA> source, const ImageView<RGBA> target, const Filter filter, parallel::ThreadPool& pool) {
+    Secret::resize(source, target, filter, pool);
+}
+
+inline void ES::resample::resize(const ImageView<const RGB8> source, const ImageView<RGB8> target, const Filter filter, parallel::ThreadPool& pool) {
+    Secret::resize(source, target, filter, pool);
+}
+
+inline void ES::resample::resize(const ImageView<const RGBA8> source, const ImageView<RGBA8> target, const Filter filter, parallel::ThreadPool& pool) {
+    Secret::resize(source, target, filter, pool);
+}
+
+template <typename Pixel>
+ES::Image<Pixel> ES::resample::resized(const Image<Pixel>& source, const std::size_t width, const std::size_t height, const Filter filter,
+                                       parallel::ThreadPool& pool) {
+    Image<Pixel> result(width, height);
+    resize(source.view(), result.view(), filter, pool);
+    return result;
+}
+
+#endif //COMPUTERGRAPHICS_ESRESAMPLE_HPP
@@ -0,0 +1,156 @@
+#ifndef COMPUTERGRAPHICS_ESSIMD_HPP
+#define COMPUTERGRAPHICS_ESSIMD_HPP
+
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+//the one place we do reach for intrinsics: there is no portable way to spell a non-temporal store
+#if !defined(__clang__) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+    #include <emmintrin.h>
+    #define ES_HAS_SSE2_STREAM 1
+#endif
+
+/*
+ * No intrinsics soup in here on purpose. Kernels in ES are written "lane batched": gather a fixed number of
+ * elements into small structure-of-arrays scratch buffers, then run plain fixed trip count loops over them.
+ * Compilers turn those into real vector code on every target we care about (SSE/AVX/NEON) without us owning
+ * three copies of every kernel. ES_VECTORIZE is just a nudge telling the compiler the iterations are independent.
+ */
+
+#if defined(__clang__)
+    #define ES_VECTORIZE _Pragma("clang loop vectorize(enable) interleave(enable)")
+#elif defined(__GNUC__)
+    #define ES_VECTORIZE _Pragma("GCC ivdep")
+#elif defined(_MSC_VER)
+    #define ES_VECTORIZE __pragma(loop(ivdep))
+#else
+    #define ES_VECTORIZE
+#endif
+
+#if defined(__GNUC__) || defined(__clang__) || defined(_MSC_VER)
+    #define ES_RESTRICT __restrict
+#else
+    #define ES_RESTRICT
+#endif
+
+namespace ES::simd {
+
+    /// Width of the widest vector register we were compiled for, in bytes.
+#if defined(__AVX512F__)
+    inline constexpr std::size_t register_bytes = 64;
+#elif defined(__AVX__)
+    inline constexpr std::size_t register_bytes = 32;
+#else
+    inline constexpr std::size_t register_bytes = 16; //SSE2 and NEON, and a sane batch size even for scalar targets
+#endif
+
+    /// How many T fit in one register, the batch size lane batched kernels gather into.
+    template<typename T>
+    inline constexpr std::size_t lanes = register_bytes / sizeof(T) > 0 ? register_bytes / sizeof(T) : 1;
+
+    /**
+     * @brief condition ? if_true : if_false, spelled with masks so it can never turn into a branch.
+     *
+     * gcc keeps IEEE traps honest by default, so a ?: between two computed floating point values is a branch it will
+     * not flatten (either side might trap), and one branch in a loop body is enough to stop it vectorizing. Both
+     * sides are computed regardless, so keep them cheap.
+     */
+    template<typename F> requires (sizeof(F) == 4 || sizeof(F) == 8)
+    [[nodiscard]] constexpr F select(bool condition, F if_true, F if_false) noexcept {
+        using Bits = std::conditional_t<sizeof(F) == 4, std::uint32_t, std::uint64_t>;
+        const Bits mask = Bits{0} - static_cast<Bits>(condition);
+        return std::bit_cast<F>(static_cast<Bits>((std::bit_cast<Bits>(if_true) & mask) | (std::bit_cast<Bits>(if_false) & ~mask)));
+    }
+
+    /**
+     * @brief 1 / sqrt(x) for a positive, finite x, to within an ulp or so, without calling sqrt.
+     *
+     * std::sqrt may set errno, so unless the build says -fno-math-errno gcc guards every call with a branch and the
+     * loop around it stops vectorizing. This is the bit trick first guess refined by Newton steps instead, nothing but
+     * multiplies and adds. Garbage for x <= 0, inf or NaN, so keep it to values known to be in range.
+     */
+    template<typename F> requires (sizeof(F) == 4 || sizeof(F) == 8)
+    [[nodiscard]] constexpr F inverse_sqrt(F x) noexcept {
+        using Bits = std::conditional_t<sizeof(F) == 4, std::uint32_t, std::uint64_t>;
+        //each step roughly doubles the correct bits, from the ~4 of the guess
+        constexpr Bits magic = static_cast<Bits>(sizeof(F) == 4 ? 0x5f375a86ull : 0x5fe6eb50c7b537a9ull);
+        constexpr int steps = sizeof(F) == 4 ? 3 : 4;
+        F y = std::bit_cast<F>(static_cast<Bits>(magic - (std::bit_cast<Bits>(x) >> 1)));
+        const F half_x = F(0.5) * x;
+        for (int i = 0; i < steps; i++) {
+            y = y * (F(1.5) - half_x * y * y);
+        }
+        return y;
+    }
+
+    /**
+     * @brief The N-th root of a positive, finite x, to within a few ulp, without calling pow or cbrt.
+     *
+     * Same idea as inverse_sqrt: dividing the exponent by N in the bits gives a guess good to a few percent, Newton
+     * steps on y^N = x take it from there. std::cbrt and std::pow aren't constexpr and stop loops vectorizing for the
+     * same errno reasons std::sqrt does. Garbage for x <= 0, inf or NaN.
+     */
+    template<unsigned N, typename F> requires ((sizeof(F) == 4 || sizeof(F) == 8) && N >= 2)
+    [[nodiscard]] constexpr F nth_root(F x) noexcept {
+        using Bits = std::conditional_t<sizeof(F) == 4, std::uint32_t, std::uint64_t>;
+        using Signed = std::conditional_t<sizeof(F) == 4, std::int32_t, std::int64_t>;
+        //the bits of 1.0, the point the exponent is scaled about
+        constexpr Signed one = static_cast<Signed>(sizeof(F) == 4 ? 0x3f800000ll : 0x3ff0000000000000ll);
+        constexpr int steps = sizeof(F) == 4 ? 5 : 6;
+        const Signed bits = static_cast<Signed>(std::bit_cast<Bits>(x));
+        F y = std::bit_cast<F>(static_cast<Bits>(one + (bits - one) / static_cast<Signed>(N)));
+        for (int i = 0; i < steps; i++) {
+            F power = y;
+            for (unsigned k = 2; k < N; k++) {
+                power *= y;
+            }
+            y = (F(N - 1) * y + x / power) * (F(1) / F(N));
+        }
+        return y;
+    }
+
+    /// Outputs at least this big skip the cache with stream_store, anything smaller is likely to be read again soon.
+    inline constexpr std::size_t non_temporal_threshold = std::size_t{1} << 22;
+
+    /**
+     * @brief Stores value to dst without pulling the line into cache (where the target has such a thing).
+     *
+     * For big outputs nobody is going to read back right away, it saves the read-for-ownership and keeps the cache for
+     * the inputs. Plain store where unsupported. Follow a run of these with stream_fence before anyone reads dst.
+     */
+    template<typename T>
+    inline void stream_store(T* dst, T value) noexcept {
+#if defined(__clang__)
+        __builtin_nontemporal_store(value, dst);
+#elif defined(ES_HAS_SSE2_STREAM)
+        if constexpr (sizeof(T) == 4) {
+            _mm_stream_si32(reinterpret_cast<int*>(dst), std::bit_cast<int>(value));
+        }
+    #if defined(__x86_64__) || defined(_M_X64)
+        else if constexpr (sizeof(T) == 8) {
+            _mm_stream_si64(reinterpret_cast<long long*>(dst), std::bit_cast<long long>(value));
+        }
+    #endif
+        else {
+            *dst = value;
+        }
+#else
+        *dst = value;
+#endif
+    }
+
+    /// Orders preceding stream_store calls before anything after, they are weakly ordered on x86.
+    inline void stream_fence() noexcept {
+#if defined(ES_HAS_SSE2_STREAM)
+        _mm_sfence();
+#else
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+#endif
+    }
+
+}
+
+#endif //COMPUTERGRAPHICS_ESSIMD_HPP
@@ -0,0 +1,230 @@
+#ifndef COMPUTERGRAPHICS_ESSRGB_HPP
+#define COMPUTERGRAPHICS_ESSRGB_HPP
+
+#include <array>
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include "ES_simd.hpp"
+
+/*
+ * The sRGB transfer function without pow.
+ *
+ * Decoding an 8 bit channel is one load from a 256 entry table. Encoding a float to 8 bits goes the other way round:
+ * the float's exponent and top mantissa bits pick one of 104 line segments (8 per octave from 2^-13 up to 1, below
+ * that everything is 0 anyway), the next 8 mantissa bits step along it in fixed point, and the guess that comes out
+ * is never more than one off. One compare either side against the exact decision points between codes puts it
+ * right, so the result is round(sRGB(x) * 255) of the exact curve for every float, not just near it. Out of range
+ * input (negative, above 1, NaN) clamps to 0 or 255 on the way in.
+ *
+ * Everything is integer ops and table loads, so the span versions vectorize (gathers where the target has them).
+ *
+ * decode and encode are the float to float curve for when 8 bits aren't enough, the powers done as roots by Newton
+ * (simd::nth_root), good to a few parts in 10^7 and still branch free.
+ */
+
+//SIGNATURES AND FRIENDS
+namespace ES::srgb {
+
+    /// An sRGB encoded 8 bit channel as linear light in [0, 1].
+    [[nodiscard]] constexpr float to_linear(std::uint8_t encoded) noexcept;
+
+    /// Linear light as an sRGB encoded 8 bit channel, correctly rounded, clamped to [0, 1] first.
+    [[nodiscard]] constexpr std::uint8_t to_srgb8(float linear) noexcept;
+
+    /**
+     * @brief Linear light as one of the two sRGB codes either side of it, for dithering.
+     *
+     * The farther code comes out when threshold, in [0, 1), is below how far linear sits towards it in linear light.
+     * With thresholds spread evenly over [0, 1) an area of one value averages out to that light, not to that code.
+     */
+    [[nodiscard]] constexpr std::uint8_t to_srgb8_dithered(float linear, float threshold) noexcept;
+
+    /// An sRGB encoded value in [0, 1] as linear light, in float all the way. Clamped to [0, 1] first.
+    [[nodiscard]] constexpr float decode(float encoded) noexcept;
+
+    /// Linear light as an sRGB encoded value in [0, 1], in float all the way. Clamped to [0, 1] first.
+    [[nodiscard]] constexpr float encode(float linear) noexcept;
+
+    /// to_linear on every channel of encoded, into linear, which is the same length.
+    void to_linear(std::span<const std::uint8_t> encoded, std::span<float> linear) noexcept;
+
+    /// to_srgb8 on every channel of linear, into encoded, which is the same length.
+    void to_srgb8(std::span<const float> linear, std::span<std::uint8_t> encoded) noexcept;
+
+}
+
+namespace ES::srgb::Secret {
+
+    //(i / 255) through the sRGB decoding curve, worked out in double
+    inline constexpr std::array<float, 256> decode_table = {
+        0.0f, 0.000303526991f, 0.000607053982f, 0.000910580973f, 0.00121410796f, 0.00151763496f, 0.00182116195f, 0.00212468882f,
+        0.00242821593f, 0.0027317428f, 0.00303526991f, 0.00334653584f, 0.00367650739f, 0.00402471703f, 0.00439144205f, 0.00477695325f,
+        0.00518151652f, 0.00560539169f, 0.00604883302f, 0.00651209056f, 0.00699541019f, 0.00749903219f, 0.00802319311f, 0.00856812578f,
+        0.00913405884f, 0.00972121768f, 0.010329823f, 0.0109600937f, 0.0116122449f, 0.012286488f, 0.0129830325f, 0.0137020834f,
+        0.0144438436f, 0.0152085144f, 0.0159962941f, 0.0168073755f, 0.0176419541f, 0.01850022f, 0.0193823613f, 0.0202885624f,
+        0.0212190095f, 0.0221738853f, 0.0231533665f, 0.0241576321f, 0.0251868591f, 0.0262412224f, 0.0273208916f, 0.02842604f,
+        0.0295568351f, 0.0307134446f, 0.0318960324f, 0.0331047662f, 0.0343398079f, 0.0356013142f, 0.0368894488f, 0.0382043719f,
+        0.0395462364f, 0.0409151986f, 0.0423114114f, 0.043735031f, 0.045186203f, 0.0466650873f, 0.0481718257f, 0.0497065671f,
+        0.0512694567f, 0.0528606474f, 0.054480277f, 0.0561284907f, 0.0578054301f, 0.0595112368f, 0.0612460524f, 0.0630100146f,
+        0.064803265f, 0.0666259378f, 0.0684781671f, 0.0703600943f, 0.0722718537f, 0.0742135718f, 0.0761853829f, 0.078187421f,
+        0.0802198201f, 0.0822827071f, 0.0843762085f, 0.0865004584f, 0.0886555836f, 0.0908417106f, 0.0930589661f, 0.0953074694f,
+        0.097587347f, 0.0998987257f, 0.102241732f, 0.104616486f, 0.107023105f, 0.10946171f, 0.111932427f, 0.114435375f,
+        0.116970666f, 0.119538426f, 0.122138776f, 0.124771819f, 0.127437681f, 0.130136475f, 0.13286832f, 0.135633335f,
+        0.138431609f, 0.141263291f, 0.144128472f, 0.147027269f, 0.149959788f, 0.152926147f, 0.155926466f, 0.158960834f,
+        0.162029371f, 0.165132195f, 0.168269396f, 0.171441108f, 0.174647406f, 0.177888423f, 0.18116425f, 0.18447499f,
+        0.187820777f, 0.191201687f, 0.194617838f, 0.198069319f, 0.20155625f, 0.205078736f, 0.208636865f, 0.212230757f,
+        0.215860501f, 0.219526201f, 0.223227963f, 0.226965874f, 0.230740055f, 0.23455058f, 0.238397568f, 0.242281124f,
+        0.246201321f, 0.25015828f, 0.254152089f, 0.258182853f, 0.262250662f, 0.266355604f, 0.270497799f, 0.274677306f,
+        0.278894275f, 0.283148736f, 0.287440836f, 0.291770637f, 0.296138257f, 0.300543785f, 0.304987311f, 0.309468925f,
+        0.313988715f, 0.318546772f, 0.323143214f, 0.327778101f, 0.332451522f, 0.337163627f, 0.341914415f, 0.346704066f,
+        0.351532608f, 0.356400132f, 0.361306787f, 0.366252601f, 0.371237695f, 0.376262128f, 0.38132602f, 0.386429429f,
+        0.391572475f, 0.396755219f, 0.401977777f, 0.407240212f, 0.412542611f, 0.417885065f, 0.423267663f, 0.428690493f,
+        0.434153646f, 0.439657182f, 0.445201188f, 0.450785786f, 0.456411034f, 0.462076992f, 0.467783809f, 0.473531485f,
+        0.479320168f, 0.48514995f, 0.491020858f, 0.496932983f, 0.502886474f, 0.50888133f, 0.514917672f, 0.520995557f,
+        0.527115107f, 0.533276379f, 0.539479494f, 0.545724452f, 0.55201143f, 0.558340371f, 0.564711511f, 0.571124852f,
+        0.577580452f, 0.584078431f, 0.590618849f, 0.597201765f, 0.603827357f, 0.610495567f, 0.617206573f, 0.623960376f,
+        0.630757153f, 0.637596846f, 0.644479692f, 0.651405632f, 0.658374846f, 0.665387273f, 0.672443151f, 0.679542482f,
+        0.686685324f, 0.693871737f, 0.701101899f, 0.708375752f, 0.715693474f, 0.723055124f, 0.730460763f, 0.73791039f,
+        0.745404184f, 0.752942204f, 0.760524511f, 0.768151164f, 0.775822222f, 0.783537805f, 0.791297913f, 0.799102724f,
+        0.806952238f, 0.814846575f, 0.822785735f, 0.830769897f, 0.838799f, 0.846873224f, 0.854992628f, 0.863157213f,
+        0.871367097f, 0.8796224f, 0.887923121f, 0.896269381f, 0.904661179f, 0.913098633f, 0.921581864f, 0.930110872f,
+        0.938685715f, 0.947306514f, 0.955973327f, 0.964686275f, 0.973445296f, 0.982250571f, 0.991102099f, 1.0f
+    };
+
+    //the segments start at 2^-13; the float bits from there, >> 20, are the segment
+    inline constexpr std::uint32_t segment_base = (127u - 13u) << 23;
+    inline constexpr std::uint32_t almost_one = 0x3f7fffffu;
+
+    //per segment, the intercept (top 16 bits, << 9 to use) and slope (bottom 16) of the guess in 16.16 fixed point
+    inline constexpr std::array<std::uint32_t, 104> encode_segments = {
+        0x0073000du, 0x007a000du, 0x0080000du, 0x0087000du, 0x008d000du, 0x0094000du, 0x009a000du, 0x00a1000du,
+        0x00a7001au, 0x00b4001au, 0x00c1001au, 0x00ce001au, 0x00da001au, 0x00e7001au, 0x00f4001au, 0x0101001au,
+        0x010e0033u, 0x01280033u, 0x01410033u, 0x015b0033u, 0x01750033u, 0x018f0033u, 0x01a80033u, 0x01c20033u,
+        0x01dc0067u, 0x020f0067u, 0x02430067u, 0x02760067u, 0x02aa0067u, 0x02dd0067u, 0x03110067u, 0x03440067u,
+        0x037800ceu, 0x03df00ceu, 0x044600ceu, 0x04ad00ceu, 0x051400ceu, 0x057b00c5u, 0x05dd00bcu, 0x063b00b5u,
+        0x06970158u, 0x07420142u, 0x07e30130u, 0x087b0120u, 0x090b0112u, 0x09940106u, 0x0a1700fcu, 0x0a9500f2u,
+        0x0b0f01cbu, 0x0bf401aeu, 0x0ccb0195u, 0x0d950180u, 0x0e56016eu, 0x0f0d015eu, 0x0fbc0150u, 0x10630143u,
+        0x11070264u, 0x1238023eu, 0x1357021du, 0x14660201u, 0x156601e9u, 0x165a01d3u, 0x174401c0u, 0x182401afu,
+        0x18fe0331u, 0x1a9602feu, 0x1c1502d2u, 0x1d7e02adu, 0x1ed4028du, 0x201a0270u, 0x21520256u, 0x227d0240u,
+        0x239f0443u, 0x25c003feu, 0x27bf03c4u, 0x29a10392u, 0x2b6a0367u, 0x2d1d0341u, 0x2ebe031fu, 0x304d0300u,
+        0x31d105b0u, 0x34a80555u, 0x37520507u, 0x39d504c5u, 0x3c37048bu, 0x3e7c0458u, 0x40a8042au, 0x42bd0401u,
+        0x44c20798u, 0x488e071eu, 0x4c1c06b6u, 0x4f76065du, 0x52a50610u, 0x55ac05ccu, 0x5892058fu, 0x5b590559u,
+        0x5e0c0a23u, 0x631c0980u, 0x67db08f6u, 0x6c55087fu, 0x70940818u, 0x74a007bdu, 0x787d076cu, 0x7c330723u
+    };
+
+    //thresholds[k] is the smallest float that encodes to k or more; the last entry is a sentinel nothing reaches
+    inline constexpr std::array<float, 257> encode_thresholds = {
+        0.0f, 0.000151763496f, 0.000455290487f, 0.000758817478f, 0.00106234453f, 0.00136587152f, 0.00166939851f, 0.00197292562f,
+        0.00227645249f, 0.00257997937f, 0.00288350647f, 0.00318830111f, 0.00350925955f, 0.00384831498f, 0.00420574844f, 0.00458183279f,
+        0.00497683743f, 0.00539102452f, 0.0058246511f, 0.00627796957f, 0.00675122766f, 0.00724466844f, 0.00775853079f, 0.00829304848f,
+        0.00884845387f, 0.00942497142f, 0.0100228265f, 0.010642237f, 0.0112834219f, 0.0119465925f, 0.0126319602f, 0.0133397318f,
+        0.0140701123f, 0.0148233036f, 0.0155995032f, 0.0163989104f, 0.0172217172f, 0.0180681162f, 0.0189382955f, 0.0198324434f,
+        0.0207507461f, 0.0216933843f, 0.0226605386f, 0.0236523915f, 0.0246691164f, 0.0257108882f, 0.026777884f, 0.0278702714f,
+        0.0289882217f, 0.0301319025f, 0.0313014835f, 0.0324971229f, 0.0337189883f, 0.0349672437f, 0.0362420455f, 0.0375435539f,
+        0.038871929f, 0.04022732f, 0.0416098908f, 0.0430197865f, 0.0444571637f, 0.045922175f, 0.0474149659f, 0.048935689f,
+        0.0504844859f, 0.0520615093f, 0.0536669008f, 0.055300802f, 0.0569633618f, 0.0586547181f, 0.0603750125f, 0.0621243864f,
+        0.0639029741f, 0.0657109171f, 0.067548357f, 0.0694154128f, 0.0713122413f, 0.0732389614f, 0.0751957074f, 0.0771826208f,
+        0.0791998208f, 0.0812474489f, 0.0833256245f, 0.085434489f, 0.0875741616f, 0.089744769f, 0.0919464454f, 0.0941793025f,
+        0.0964434817f, 0.098739095f, 0.101066276f, 0.103425138f, 0.105815805f, 0.108238406f, 0.110693052f, 0.11317987f,
+        0.115698971f, 0.118250489f, 0.120834522f, 0.123451203f, 0.126100644f, 0.128782958f, 0.131498262f, 0.134246677f,
+        0.137028307f, 0.139843285f, 0.142691687f, 0.145573661f, 0.148489311f, 0.151438743f, 0.15442206f, 0.157439396f,
+        0.160490841f, 0.163576499f, 0.166696504f, 0.169850945f, 0.173039928f, 0.176263571f, 0.179521978f, 0.182815254f,
+        0.186143503f, 0.189506844f, 0.192905352f, 0.19633916f, 0.199808359f, 0.203313053f, 0.206853345f, 0.210429341f,
+        0.214041144f, 0.217688859f, 0.221372575f, 0.225092396f, 0.228848428f, 0.232640773f, 0.236469522f, 0.240334779f,
+        0.244236648f, 0.248175219f, 0.252150595f, 0.256162852f, 0.260212123f, 0.264298499f, 0.268422037f, 0.272582889f,
+        0.276781112f, 0.281016827f, 0.285290092f, 0.289601028f, 0.293949753f, 0.298336297f, 0.30276081f, 0.30722338f,
+        0.311724067f, 0.31626296f, 0.32084021f, 0.325455844f, 0.330110013f, 0.334802747f, 0.339534193f, 0.344304383f,
+        0.349113464f, 0.353961498f, 0.358848572f, 0.363774806f, 0.368740231f, 0.373744994f, 0.378789157f, 0.383872777f,
+        0.388996005f, 0.3941589f, 0.399361551f, 0.404604018f, 0.40988642f, 0.415208846f, 0.420571357f, 0.425974071f,
+        0.431417048f, 0.436900377f, 0.442424119f, 0.447988421f, 0.453593343f, 0.459238917f, 0.464925319f, 0.47065255f,
+        0.47642073f, 0.482229948f, 0.488080263f, 0.493971765f, 0.499904573f, 0.505878747f, 0.511894345f, 0.517951429f,
+        0.524050176f, 0.530190587f, 0.536372721f, 0.542596757f, 0.548862696f, 0.555170655f, 0.561520696f, 0.567912936f,
+        0.574347377f, 0.580824137f, 0.587343335f, 0.593905032f, 0.600509286f, 0.607156157f, 0.613845766f, 0.62057817f,
+        0.62735343f, 0.634171665f, 0.641032934f, 0.647937298f, 0.654884875f, 0.661875665f, 0.668909848f, 0.675987422f,
+        0.683108449f, 0.690273106f, 0.697481394f, 0.704733372f, 0.712029159f, 0.719368875f, 0.72675246f, 0.734180093f,
+        0.741651833f, 0.74916774f, 0.756727874f, 0.764332294f, 0.77198118f, 0.77967447f, 0.787412345f, 0.795194805f,
+        0.803021908f, 0.810893834f, 0.818810582f, 0.826772213f, 0.834778845f, 0.842830539f, 0.850927293f, 0.859069288f,
+        0.867256522f, 0.875489116f, 0.883767128f, 0.892090559f, 0.900459588f, 0.908874214f, 0.917334557f, 0.925840676f,
+        0.934392571f, 0.942990422f, 0.951634228f, 0.960324049f, 0.969060004f, 0.977842152f, 0.986670554f, 0.995545268f,
+        2.0f
+    };
+
+}
+
+//DEFINITIONS
+
+constexpr float ES::srgb::to_linear(const std::uint8_t encoded) noexcept {
+    return Secret::decode_table[encoded];
+}
+
+constexpr std::uint8_t ES::srgb::to_srgb8(const float linear) noexcept {
+    //the compare is false for NaN, which lands it on 0 with the negatives
+    constexpr float smallest = std::bit_cast<float>(Secret::segment_base);
+    constexpr float largest = std::bit_cast<float>(Secret::almost_one);
+    float x = simd::select(linear > smallest, linear, smallest);
+    x = simd::select(x < largest, x, largest);
+
+    const std::uint32_t bits = std::bit_cast<std::uint32_t>(x);
+    const std::uint32_t segment = Secret::encode_segments[(bits - Secret::segment_base) >> 20];
+    const std::uint32_t step = (bits >> 12) & 0xffu;
+    const std::uint32_t guess = (((segment >> 16) << 9) + (segment & 0xffffu) * step) >> 16;
+    return static_cast<std::uint8_t>(guess + (x >= Secret::encode_thresholds[guess + 1]) - (x < Secret::encode_thresholds[guess]));
+}
+
+constexpr std::uint8_t ES::srgb::to_srgb8_dithered(float linear, const float threshold) noexcept {
+    linear = simd::select(linear > 0.0f, linear, 0.0f);
+    linear = simd::select(linear < 1.0f, linear, 1.0f);
+    const std::uint8_t nearest = to_srgb8(linear);
+    const float at = to_linear(nearest);
+    const int step = linear > at ? (nearest < 255) : -(nearest > 0);
+    const auto other = static_cast<std::uint8_t>(nearest + step);
+    const float towards = step != 0 ? (linear - at) / (to_linear(other) - at) : 0.0f;
+    return threshold < towards ? other : nearest;
+}
+
+constexpr float ES::srgb::decode(float encoded) noexcept {
+    encoded = simd::select(encoded > 0.0f, encoded, 0.0f);
+    encoded = simd::select(encoded < 1.0f, encoded, 1.0f);
+    //u^2.4 is the fifth root of u^12, which stays a normal float over the whole curved part
+    const float u = (encoded + 0.055f) * (1.0f / 1.055f);
+    const float u2 = u * u;
+    const float u4 = u2 * u2;
+    const float curved = simd::nth_root<5>(u4 * u4 * u4);
+    return simd::select(encoded <= 0.04045f, encoded * (1.0f / 12.92f), curved);
+}
+
+constexpr float ES::srgb::encode(float linear) noexcept {
+    linear = simd::select(linear > 0.0f, linear, 0.0f);
+    linear = simd::select(linear < 1.0f, linear, 1.0f);
+    //x^(1 / 2.4) is the twelfth root of x^5; the straight part's 0 goes down the curve too, and gets thrown away
+    const float x2 = linear * linear;
+    const float curved = 1.055f * simd::nth_root<12>(x2 * x2 * linear) - 0.055f;
+    return simd::select(linear <= 0.0031308f, linear * 12.92f, curved);
+}
+
+inline void ES::srgb::to_linear(const std::span<const std::uint8_t> encoded, const std::span<float> linear) noexcept {
+    assert(encoded.size() == linear.size() && "srgb::to_linear needs as many outputs as inputs");
+    const std::uint8_t* ES_RESTRICT in = encoded.data();
+    float* ES_RESTRICT out = linear.data();
+    const std::size_t count = encoded.size();
+    ES_VECTORIZE
+    for (std::size_t i = 0; i < count; i++) {
+        out[i] = Secret::decode_table[in[i]];
+    }
+}
+
+inline void ES::srgb::to_srgb8(const std::span<const float> linear, const std::span<std::uint8_t> encoded) noexcept {
+    assert(encoded.size() == linear.size() && "srgb::to_srgb8 needs as many outputs as inputs");
+    const float* ES_RESTRICT in = linear.data();
+    std::uint8_t* ES_RESTRICT out = encoded.data();
+    const std::size_t count = linear.size();
+    ES_VECTORIZE
+    for (std::size_t i = 0; i < count; i++) {
+        out[i] = to_srgb8(in[i]);
+    }
+}
+
+#endif //COMPUTERGRAPHICS_ESSRGB_HPP
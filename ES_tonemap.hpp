@@ -0,0 +1,335 @@
+#ifndef COMPUTERGRAPHICS_ESTONEMAP_HPP
+#define COMPUTERGRAPHICS_ESTONEMAP_HPP
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "ES_parallel.hpp"
+#include "ES_simd.hpp"
+#include "ES_srgb.hpp"
+#include "ColorN.hpp"
+#include "Image.hpp"
+
+/*
+ * HDR to display: scene linear RGB through an exposure and a tone curve into sRGB RGB8.
+ *
+ * Auto exposure comes from a histogram of log2 luminance (RGB::luminance(), Rec. 709 weights). Each band of rows
+ * counts into its own histogram, one band per thread in the pool, and the bands are added up at the end, so the
+ * frame is read once with no atomics; inside a band, neighbouring pixels count into four interleaved copies so runs
+ * of the same bin don't wait on each other's increments. log2 there is the float's exponent plus a quadratic on the
+ * mantissa, good to 0.008 of a stop against bins a fifth of a stop wide.
+ *
+ * map() does the rest in one pass: exposure, curve, sRGB encode and optional dither per pixel, the curve chosen once
+ * per row rather than switched on per pixel. Dithering is srgb::to_srgb8_dithered, so a dithered flat area
+ * averages to the right light, not the right code; the noise is a per pixel hash, nothing to store or tile. Every curve clips at white.
+ */
+
+//SIGNATURES AND FRIENDS
+namespace ES::tonemap {
+
+    enum class Curve {
+        reinhard,  ///< extended Reinhard on luminance: keeps hue, white maps to 1
+        aces,      ///< Stephen Hill's fit of the ACES reference and sRGB output transforms
+        agx,       ///< AgX-like: log encode and a sigmoid in an inset gamut, polynomial fit; desaturates highlights cleanly
+        uncharted2 ///< John Hable's filmic curve, white maps to 1
+    };
+
+    /// Buckets in a luminance histogram.
+    inline constexpr std::size_t histogram_bins = 128;
+
+    struct Histogram {
+        /// log2 luminance at the bottom of the first bucket and the top of the last; pixels outside land in the end ones.
+        float min_log2;
+        float max_log2;
+        std::array<std::uint32_t, histogram_bins> counts{};
+
+        [[nodiscard]] std::uint64_t total() const noexcept;
+
+        /// log2 luminance at the middle of bucket.
+        [[nodiscard]] float bin_log2(std::size_t bin) const noexcept;
+
+        /**
+         * @brief The mean log2 luminance of the pixels between the low and high fractions of the frame, by brightness.
+         *
+         * The darkest low and the brightest 1 - high are left out, so a black border or a few light sources don't drag
+         * the exposure about.
+         */
+        [[nodiscard]] float mean_log2(float low = 0.1f, float high = 0.95f) const noexcept;
+    };
+
+    struct Settings {
+        Curve curve = Curve::aces;
+        /// Scene light is multiplied by this before the curve; auto_exposure() makes one.
+        float exposure = 1.0f;
+        /// The scene value the Reinhard and Uncharted2 curves take to white.
+        float white = 11.2f;
+        bool dither = true;
+        /// The dither pattern; change it each frame for noise that doesn't stand still.
+        std::uint32_t seed = 0;
+    };
+
+    /// The log2 luminance histogram of image, bucketed between min_log2 and max_log2.
+    [[nodiscard]] Histogram histogram(ImageView<const RGB> image, float min_log2 = -12.0f, float max_log2 = 12.0f,
+                                      parallel::ThreadPool& pool = parallel::default_pool());
+
+    /// The exposure that takes the histogram's mean_log2(low, high) luminance to key, middle grey by default.
+    [[nodiscard]] float auto_exposure(const Histogram& histogram, float key = 0.18f, float low = 0.1f, float high = 0.95f) noexcept;
+
+    /// The curve on its own, exposed scene light in, linear display light in [0, 1] out.
+    [[nodiscard]] RGB apply(Curve curve, const RGB& colour, float white = 11.2f) noexcept;
+
+    /// in exposed, tone mapped, sRGB encoded and dithered as settings say into out, which is the same size.
+    void map(ImageView<const RGB> in, ImageView<RGB8> out, const Settings& settings = {}, parallel::ThreadPool& pool = parallel::default_pool());
+
+}
+
+namespace ES::tonemap::Secret {
+
+    //rows to a job: about 16K pixels, however wide the image
+    [[nodiscard]] inline std::size_t row_grain(std::size_t width) noexcept {
+        return std::max<std::size_t>(1, (std::size_t{1} << 14) / std::max<std::size_t>(1, width));
+    }
+
+    [[nodiscard]] float fast_log2(float x) noexcept;
+
+    [[nodiscard]] constexpr float saturate(float v) noexcept {
+        return std::min(std::max(v, 0.0f), 1.0f);
+    }
+
+    [[nodiscard]] RGB reinhard(const RGB& c, float white) noexcept;
+    [[nodiscard]] RGB aces(const RGB& c) noexcept;
+    [[nodiscard]] RGB agx(const RGB& c) noexcept;
+    [[nodiscard]] RGB uncharted2(const RGB& c, float white) noexcept;
+    [[nodiscard]] float hable(float x) noexcept;
+
+    //32 well mixed bits from a pixel position and a seed
+    [[nodiscard]] constexpr std::uint32_t hash(std::uint32_t x, std::uint32_t y, std::uint32_t seed) noexcept;
+
+    template <Curve curve>
+    void map_row(const RGB* ES_RESTRICT in, RGB8* ES_RESTRICT out, std::size_t width, std::size_t y, const Settings& settings) noexcept;
+
+}
+
+//DEFINITIONS
+
+inline std::uint64_t ES::tonemap::Histogram::total() const noexcept {
+    std::uint64_t sum = 0;
+    for (const std::uint32_t count : counts) {
+        sum += count;
+    }
+    return sum;
+}
+
+inline float ES::tonemap::Histogram::bin_log2(const std::size_t bin) const noexcept {
+    return min_log2 + (static_cast<float>(bin) + 0.5f) * (max_log2 - min_log2) / static_cast<float>(histogram_bins);
+}
+
+inline float ES::tonemap::Histogram::mean_log2(const float low, const float high) const noexcept {
+    assert(low >= 0.0f && low <= high && high <= 1.0f && "Histogram::mean_log2 needs 0 <= low <= high <= 1");
+    const auto all = static_cast<double>(total());
+    const double from = all * low;
+    const double to = all * high;
+    double seen = 0.0;
+    double weight = 0.0;
+    double sum = 0.0;
+    for (std::size_t bin = 0; bin < histogram_bins; bin++) {
+        //the part of this bucket's pixels that falls inside [from, to)
+        const double count = counts[bin];
+        const double inside = std::max(0.0, std::min(seen + count, to) - std::max(seen, from));
+        weight += inside;
+        sum += inside * bin_log2(bin);
+        seen += count;
+    }
+    return weight > 0.0 ? static_cast<float>(sum / weight) : 0.5f * (min_log2 + max_log2);
+}
+
+inline float ES::tonemap::Secret::fast_log2(const float x) noexcept {
+    //x = 2^e * (1 + m), log2(1 + m) ~ m * (1.3465 - 0.3465 m)
+    const auto bits = std::bit_cast<std::uint32_t>(x);
+    const float e = static_cast<float>(static_cast<int>(bits >> 23) - 127);
+    const float m = std::bit_cast<float>((bits & 0x007fffffu) | 0x3f800000u) - 1.0f;
+    return e + m * (1.3465f - 0.3465f * m);
+}
+
+inline ES::tonemap::Histogram ES::tonemap::histogram(const ImageView<const RGB> image, const float min_log2, const float max_log2,
+                                                     parallel::ThreadPool& pool) {
+    assert(min_log2 < max_log2 && "tonemap::histogram needs min_log2 < max_log2");
+    using Counts = std::array<std::uint32_t, histogram_bins>;
+    //a band per thread (the caller included), each with its own counts
+    const std::size_t bands = std::min(image.height(), pool.size() + 1);
+    std::vector<Counts> partial(bands, Counts{});
+    const float scale = static_cast<float>(histogram_bins) / (max_log2 - min_log2);
+    const float top = static_cast<float>(histogram_bins - 1);
+
+    parallel::for_chunks(bands, 1, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t band = begin; band < end; band++) {
+            std::array<Counts, 4> lanes{};
+            const std::size_t first = image.height() * band / bands;
+            const std::size_t last = image.height() * (band + 1) / bands;
+            for (std::size_t y = first; y < last; y++) {
+                const RGB* ES_RESTRICT row = image.row_data(y);
+                for (std::size_t x = 0; x < image.width(); x++) {
+                    //black, and negative light or NaN from a bad pixel, count as the darkest there is; selects, as
+                    //std::max hands a NaN straight through to the cast
+                    const float raw = row[x].luminance();
+                    const float luminance = simd::select(raw > 1e-30f, raw, 1e-30f);
+                    const float unclamped = (Secret::fast_log2(luminance) - min_log2) * scale;
+                    const float low = simd::select(unclamped > 0.0f, unclamped, 0.0f);
+                    const float position = simd::select(low < top, low, top);
+                    lanes[x & 3][static_cast<std::size_t>(position)]++;
+                }
+            }
+            for (std::size_t bin = 0; bin < histogram_bins; bin++) {
+                partial[band][bin] = lanes[0][bin] + lanes[1][bin] + lanes[2][bin] + lanes[3][bin];
+            }
+        }
+    }, pool);
+
+    Histogram result{min_log2, max_log2};
+    for (const Counts& counts : partial) {
+        for (std::size_t bin = 0; bin < histogram_bins; bin++) {
+            result.counts[bin] += counts[bin];
+        }
+    }
+    return result;
+}
+
+inline float ES::tonemap::auto_exposure(const Histogram& histogram, const float key, const float low, const float high) noexcept {
+    return key / std::exp2(histogram.mean_log2(low, high));
+}
+
+inline ES::RGB ES::tonemap::Secret::reinhard(const RGB& c, const float white) noexcept {
+    const float luminance = c.luminance();
+    const float mapped = luminance * (1.0f + luminance / (white * white)) / (1.0f + luminance);
+    const float scale = simd::select(luminance > 0.0f, mapped / luminance, 0.0f);
+    return RGB(saturate(c.R() * scale), saturate(c.G() * scale), saturate(c.B() * scale));
+}
+
+inline ES::RGB ES::tonemap::Secret::aces(const RGB& c) noexcept {
+    //sRGB to the fit's input space (with the RRT's saturation tweak folded in), the fitted curve, and back
+    const float r = 0.59719f * c.R() + 0.35458f * c.G() + 0.04823f * c.B();
+    const float g = 0.07600f * c.R() + 0.90834f * c.G() + 0.01566f * c.B();
+    const float b = 0.02840f * c.R() + 0.13383f * c.G() + 0.83777f * c.B();
+    const auto fit = [](float v) {
+        return (v * (v + 0.0245786f) - 0.000090537f) / (v * (0.983729f * v + 0.4329510f) + 0.238081f);
+    };
+    const float fr = fit(r);
+    const float fg = fit(g);
+    const float fb = fit(b);
+    return RGB(saturate(1.60475f * fr - 0.53108f * fg - 0.07367f * fb),
+               saturate(-0.10208f * fr + 1.10813f * fg - 0.00605f * fb),
+               saturate(-0.00327f * fr - 0.07276f * fg + 1.07602f * fb));
+}
+
+inline ES::RGB ES::tonemap::Secret::agx(const RGB& c) noexcept {
+    constexpr float min_ev = -12.47393f;
+    constexpr float max_ev = 4.026069f;
+    //into the inset gamut, log encoded over the curve's range of stops
+    const float in[3] = {
+        0.842479062253094f * c.R() + 0.0784335999999992f * c.G() + 0.0792237451477643f * c.B(),
+        0.0423282422610123f * c.R() + 0.878468636469772f * c.G() + 0.0791661274605434f * c.B(),
+        0.0423756549057051f * c.R() + 0.0784336f * c.G() + 0.879142973793104f * c.B()};
+    float curve[3];
+    for (std::size_t i = 0; i < 3; i++) {
+        //fast_log2's 0.008 of a stop is 0.0005 of the curve's range, well under a display code
+        const float stops = std::min(std::max(fast_log2(std::max(in[i], 1e-10f)), min_ev), max_ev);
+        const float x = (stops - min_ev) / (max_ev - min_ev);
+        const float x2 = x * x;
+        const float x4 = x2 * x2;
+        //the sigmoid, a sixth order fit
+        curve[i] = 15.5f * x4 * x2 - 40.14f * x4 * x + 31.96f * x4 - 6.868f * x2 * x + 0.4298f * x2 + 0.1191f * x - 0.00232f;
+    }
+    //back out of the inset, and from the curve's 2.2 display encoding to linear: v^2.2 is v^2 times the fifth root of v,
+    //and the root is parked on 1 for the darks that round to 0 anyway (nth_root is garbage at 0)
+    const auto linear = [](float v) {
+        v = saturate(v);
+        const bool dark = v < 1e-6f;
+        return simd::select(dark, 0.0f, v * v * simd::nth_root<5>(simd::select(dark, 1.0f, v)));
+    };
+    return RGB(linear(1.19687900512017f * curve[0] - 0.0980208811401368f * curve[1] - 0.0990297440797205f * curve[2]),
+               linear(-0.0528968517574562f * curve[0] + 1.15190312990417f * curve[1] - 0.0989611768448433f * curve[2]),
+               linear(-0.0529716355144438f * curve[0] - 0.0980434501171241f * curve[1] + 1.15107367264116f * curve[2]));
+}
+
+inline float ES::tonemap::Secret::hable(const float x) noexcept {
+    constexpr float A = 0.15f, B = 0.50f, C = 0.10f, D = 0.20f, E = 0.02f, F = 0.30f;
+    return (x * (A * x + C * B) + D * E) / (x * (A * x + B) + D * F) - E / F;
+}
+
+inline ES::RGB ES::tonemap::Secret::uncharted2(const RGB& c, const float white) noexcept {
+    const float scale = 1.0f / hable(white);
+    return RGB(saturate(hable(c.R()) * scale), saturate(hable(c.G()) * scale), saturate(hable(c.B()) * scale));
+}
+
+inline ES::RGB ES::tonemap::apply(const Curve curve, const RGB& colour, const float white) noexcept {
+    switch (curve) {
+        case Curve::reinhard: return Secret::reinhard(colour, white);
+        case Curve::aces: return Secret::aces(colour);
+        case Curve::agx: return Secret::agx(colour);
+        case Curve::uncharted2: return Secret::uncharted2(colour, white);
+    }
+    return colour;
+}
+
+constexpr std::uint32_t ES::tonemap::Secret::hash(const std::uint32_t x, const std::uint32_t y, const std::uint32_t seed) noexcept {
+    //lowbias32
+    std::uint32_t h = x * 0x9e3779b1u ^ (y + seed * 0x85ebca6bu) * 0xc2b2ae35u;
+    h ^= h >> 16;
+    h *= 0x7feb352du;
+    h ^= h >> 15;
+    h *= 0x846ca68bu;
+    h ^= h >> 16;
+    return h;
+}
+
+template <ES::tonemap::Curve curve>
+void ES::tonemap::Secret::map_row(const RGB* ES_RESTRICT in, RGB8* ES_RESTRICT out, const std::size_t width, const std::size_t y,
+                                  const Settings& settings) noexcept {
+    //copies, as the byte stores below could alias settings as far as the compiler knows
+    const float exposure = settings.exposure;
+    const float white = settings.white;
+    const bool dither = settings.dither;
+    const std::uint32_t seed = settings.seed;
+    for (std::size_t x = 0; x < width; x++) {
+        const RGB exposed(in[x].R() * exposure, in[x].G() * exposure, in[x].B() * exposure);
+        RGB display;
+        if constexpr (curve == Curve::reinhard) {
+            display = reinhard(exposed, white);
+        } else if constexpr (curve == Curve::aces) {
+            display = aces(exposed);
+        } else if constexpr (curve == Curve::agx) {
+            display = agx(exposed);
+        } else {
+            display = uncharted2(exposed, white);
+        }
+        if (dither) {
+            //three 10 bit slices of one hash, a noise value per channel
+            const std::uint32_t h = hash(static_cast<std::uint32_t>(x), static_cast<std::uint32_t>(y), seed);
+            constexpr float unit = 1.0f / 1024.0f;
+            out[x] = RGB8(srgb::to_srgb8_dithered(display.R(), static_cast<float>(h & 1023u) * unit),
+                          srgb::to_srgb8_dithered(display.G(), static_cast<float>((h >> 10) & 1023u) * unit),
+                          srgb::to_srgb8_dithered(display.B(), static_cast<float>((h >> 20) & 1023u) * unit));
+        } else {
+            out[x] = RGB8(srgb::to_srgb8(display.R()), srgb::to_srgb8(display.G()), srgb::to_srgb8(display.B()));
+        }
+    }
+}
+
+inline void ES::tonemap::map(const ImageView<const RGB> in, const ImageView<RGB8> out, const Settings& settings, parallel::ThreadPool& pool) {
+    assert(in.width() == out.width() && in.height() == out.height() && "tonemap::map needs images the same size");
+    out.parallel_for_rows([&](std::size_t y, std::span<RGB8> row) {
+        switch (settings.curve) {
+            case Curve::reinhard: Secret::map_row<Curve::reinhard>(in.row_data(y), row.data(), row.size(), y, settings); break;
+            case Curve::aces: Secret::map_row<Curve::aces>(in.row_data(y), row.data(), row.size(), y, settings); break;
+            case Curve::agx: Secret::map_row<Curve::agx>(in.row_data(y), row.data(), row.size(), y, settings); break;
+            case Curve::uncharted2: Secret::map_row<Curve::uncharted2>(in.row_data(y), row.data(), row.size(), y, settings); break;
+        }
+    }, Secret::row_grain(out.width()), pool);
+}
+
+#endif //COMPUTERGRAPHICS_ESTONEMAP_HPP
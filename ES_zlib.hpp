@@ -0,0 +1,818 @@
+#ifndef COMPUTERGRAPHICS_ESZLIB_HPP
+#define COMPUTERGRAPHICS_ESZLIB_HPP
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <utility>
+#include <vector>
+#include "ES_simd.hpp"
+
+/*
+ * zlib wrapped deflate (RFC 1950 / 1951) with no dependencies, for the image codecs.
+ *
+ * Inflater is pull based: it asks its source for compressed bytes only when it runs out, and hands decompressed
+ * bytes out in whatever sized pieces the caller asks for. Nothing ever holds the whole decompressed stream, the one
+ * buffer is the sliding window deflate needs anyway (a few times over, so it slides rarely). Like most fast decoders
+ * it does not check the Adler-32 trailer: corrupt streams are caught by the structure of the codes, not the checksum.
+ *
+ * The compressor only does the fast end of the trade: greedy matches out of a one-way hash table, coded with the
+ * fixed Huffman tables, about what zlib gets at level 1. Pieces compressed on their own can be stitched into one
+ * stream, which is what lets encoders compress bands of an image on different threads.
+ */
+
+//SIGNATURES AND FRIENDS
+namespace ES::zlib {
+
+    enum class Status : std::uint8_t {
+        ok,
+        end_of_stream, //the stream ended cleanly before filling the request
+        truncated,     //the source ran dry in the middle of the stream
+        corrupt        //not a valid zlib stream
+    };
+
+    /// Where an Inflater gets compressed bytes: next() hands out the next piece, an empty span once there are no more.
+    template <typename Source>
+    concept ByteSource = requires(Source source) {
+        { source.next() } -> std::same_as<std::span<const std::uint8_t>>;
+    };
+
+    /// The simplest ByteSource: one buffer, handed out whole.
+    struct SpanSource {
+        std::span<const std::uint8_t> bytes;
+
+        [[nodiscard]] std::span<const std::uint8_t> next() noexcept { return std::exchange(bytes, {}); }
+    };
+
+}
+
+namespace ES::zlib::Secret {
+
+    /**
+     * @brief A canonical Huffman code, decoded a table lookup at a time.
+     *
+     * Codes up to fast_bits long (nearly all of them, in practice) resolve with one lookup on the next fast_bits
+     * input bits. Longer ones fall back to walking the canonical code length by length, which needs no tables beyond
+     * the per length limits.
+     */
+    struct Huffman {
+        static constexpr unsigned fast_bits = 10;
+        static constexpr unsigned max_bits = 15;
+
+        std::array<std::uint16_t, 1u << fast_bits> fast{};      //(length << 9) | symbol, 0 where the code is longer
+        std::array<std::uint32_t, max_bits + 2> max_code{};     //one past the last code of each length, left aligned to 16 bits
+        std::array<std::uint16_t, max_bits + 1> first_code{};
+        std::array<std::uint16_t, max_bits + 1> first_symbol{};
+        std::array<std::uint16_t, 288> symbols{};               //sorted by code
+
+        //false for an over subscribed code, incomplete ones are allowed (deflate has a use for a lone distance code)
+        [[nodiscard]] bool build(std::span<const std::uint8_t> lengths) noexcept;
+    };
+
+    [[nodiscard]] constexpr std::uint32_t reverse_bits(std::uint32_t bits, unsigned count) noexcept {
+        std::uint32_t reversed = 0;
+        for (unsigned i = 0; i < count; i++) {
+            reversed = (reversed << 1) | ((bits >> i) & 1u);
+        }
+        return reversed;
+    }
+
+    inline constexpr std::array<std::uint16_t, 29> length_base = {
+        3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+    inline constexpr std::array<std::uint8_t, 29> length_extra = {
+        0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+    inline constexpr std::array<std::uint16_t, 30> distance_base = {
+        1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769,
+        1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+    inline constexpr std::array<std::uint8_t, 30> distance_extra = {
+        0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+    //the order code length code lengths are sent in, most likely to be used first
+    inline constexpr std::array<std::uint8_t, 19> code_length_order = {
+        16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+
+    inline constexpr std::size_t max_match = 258;
+    inline constexpr std::size_t history = 32768;
+
+    //a Huffman code ready to write: bit reversed, since deflate sends codes most significant bit first
+    struct Code {
+        std::uint32_t bits;
+        std::uint32_t length;
+    };
+
+    [[nodiscard]] constexpr std::array<Code, 288> make_fixed_literals() noexcept {
+        std::array<Code, 288> codes{};
+        for (std::uint32_t symbol = 0; symbol < 288; symbol++) {
+            std::uint32_t code, length;
+            if (symbol < 144) {
+                code = 0x30 + symbol, length = 8;
+            } else if (symbol < 256) {
+                code = 0x190 + symbol - 144, length = 9;
+            } else if (symbol < 280) {
+                code = symbol - 256, length = 7;
+            } else {
+                code = 0xc0 + symbol - 280, length = 8;
+            }
+            codes[symbol] = Code{reverse_bits(code, length), length};
+        }
+        return codes;
+    }
+
+    //every match length 3 to 258 as its fixed code followed by its extra bits, ready for one write
+    [[nodiscard]] constexpr std::array<Code, max_match + 1> make_fixed_lengths() noexcept {
+        constexpr std::array<Code, 288> literals = make_fixed_literals();
+        std::array<Code, max_match + 1> codes{};
+        for (std::uint32_t index = 0; index < 29; index++) { //in order, so 258 ends up with its own code 285
+            for (std::uint32_t extra = 0; extra < (1u << length_extra[index]) && length_base[index] + extra <= max_match; extra++) {
+                const Code code = literals[257 + index];
+                codes[length_base[index] + extra] = Code{code.bits | (extra << code.length), code.length + length_extra[index]};
+            }
+        }
+        return codes;
+    }
+
+    inline constexpr std::array<Code, 288> fixed_literals = make_fixed_literals();
+    inline constexpr std::array<Code, max_match + 1> fixed_lengths = make_fixed_lengths();
+
+    [[nodiscard]] constexpr std::array<std::array<std::uint32_t, 256>, 8> make_crc_tables() noexcept {
+        std::array<std::array<std::uint32_t, 256>, 8> tables{};
+        for (std::uint32_t n = 0; n < 256; n++) {
+            std::uint32_t crc = n;
+            for (int k = 0; k < 8; k++) {
+                crc = (crc >> 1) ^ (0xedb88320u & (0u - (crc & 1u)));
+            }
+            tables[0][n] = crc;
+        }
+        for (std::size_t k = 1; k < 8; k++) {
+            for (std::uint32_t n = 0; n < 256; n++) {
+                tables[k][n] = (tables[k - 1][n] >> 8) ^ tables[0][tables[k - 1][n] & 0xff];
+            }
+        }
+        return tables;
+    }
+
+    //slicing by 8: eight table lookups take a whole word per step instead of a byte
+    inline constexpr std::array<std::array<std::uint32_t, 256>, 8> crc_tables = make_crc_tables();
+
+    [[nodiscard]] inline std::uint32_t load_le32(const std::uint8_t* bytes) noexcept {
+        std::uint32_t word;
+        std::memcpy(&word, bytes, 4);
+        if constexpr (std::endian::native == std::endian::big) {
+            word = std::byteswap(word);
+        }
+        return word;
+    }
+
+    [[nodiscard]] inline std::uint64_t load_le64(const std::uint8_t* bytes) noexcept {
+        std::uint64_t word;
+        std::memcpy(&word, bytes, 8);
+        if constexpr (std::endian::native == std::endian::big) {
+            word = std::byteswap(word);
+        }
+        return word;
+    }
+
+    //LSB first bits into a buffer known to be big enough, a 32 bit word at a time
+    struct BitWriter {
+        std::uint8_t* out;
+        std::uint64_t bits = 0;
+        unsigned count = 0;
+
+        void put(std::uint32_t value, unsigned length) noexcept {
+            bits |= std::uint64_t{value} << count;
+            count += length;
+            if (count >= 32) {
+                auto word = static_cast<std::uint32_t>(bits);
+                if constexpr (std::endian::native == std::endian::big) {
+                    word = std::byteswap(word);
+                }
+                std::memcpy(out, &word, 4);
+                out += 4;
+                bits >>= 32;
+                count -= 32;
+            }
+        }
+
+        //pads to a byte boundary with zeros and writes out what's left
+        void flush() noexcept {
+            while (count > 0) {
+                *out++ = static_cast<std::uint8_t>(bits);
+                bits >>= 8;
+                count = count > 8 ? count - 8 : 0;
+            }
+        }
+    };
+
+}
+
+namespace ES::zlib {
+
+    /**
+     * @brief Streaming zlib decompressor over a ByteSource.
+     *
+     * read(out) fills all of out, decoding only as much as that takes (give or take the window's worth decoded ahead).
+     * Calls can ask for any amount, so a caller after fixed size records (a PNG scanline, say) just asks for one at a
+     * time.
+     */
+    template <ByteSource Source>
+    class Inflater {
+    public:
+        explicit Inflater(Source source);
+
+        /// Fills out completely (ok), or says why not. Anything but ok leaves out partly written.
+        [[nodiscard]] Status read(std::span<std::uint8_t> out) noexcept;
+
+        /// As read, but says how much of out it got to (all of it, unless status comes back other than ok).
+        [[nodiscard]] std::size_t read_some(std::span<std::uint8_t> out, Status& status) noexcept;
+
+        /// True once the final block has been decoded and handed out.
+        [[nodiscard]] bool finished() const noexcept { return state_ == State::done && read_ == write_; }
+
+    private:
+        enum class State : std::uint8_t { zlib_header, block_header, stored, huffman, done };
+
+        //decodes into the window until it is nearly full or the stream changes state, only called once read_ == write_
+        [[nodiscard]] Status produce() noexcept;
+        [[nodiscard]] Status read_block_header() noexcept;
+        [[nodiscard]] Status read_dynamic_tables() noexcept;
+        [[nodiscard]] Status decode_huffman() noexcept;
+        void copy_stored() noexcept;
+
+        void refill() noexcept;
+        [[nodiscard]] std::uint32_t take(unsigned count) noexcept;
+        [[nodiscard]] int decode(const Secret::Huffman& code) noexcept;
+        [[nodiscard]] bool overran() const noexcept { return bit_count_ < 8 * padding_; }
+
+        Source source_;
+        std::span<const std::uint8_t> input_;
+        std::uint64_t bits_ = 0;       //bits above bit_count_ may hold the bytes that follow, never garbage
+        unsigned bit_count_ = 0;
+        std::size_t padding_ = 0;      //zero bytes made up after the source ran dry
+
+        State state_ = State::zlib_header;
+        bool final_block_ = false;
+        std::size_t stored_left_ = 0;
+        Secret::Huffman literals_;
+        Secret::Huffman distances_;
+
+        std::vector<std::uint8_t> window_;
+        std::size_t read_ = 0;
+        std::size_t write_ = 0;
+    };
+
+    /// Inflates a whole zlib stream held in memory, appending it to out.
+    [[nodiscard]] Status inflate(std::span<const std::uint8_t> compressed, std::vector<std::uint8_t>& out);
+
+    /**
+     * @brief Appends in as raw deflate (no zlib header or trailer) to out, fast rather than small.
+     *
+     * Greedy matching against the last position seen with the same four bytes, coded in one fixed Huffman block.
+     * Unless final, the piece ends with an empty stored block, which byte aligns it without ending the stream, so
+     * another piece compressed on its own can follow. Matches never reach back into an earlier piece.
+     *
+     * @param in at most 4 GB, positions are kept in 32 bits
+     */
+    void deflate_fast(std::span<const std::uint8_t> in, std::vector<std::uint8_t>& out, bool final);
+
+    /// Appends in as a whole zlib stream (header, deflate_fast, Adler-32) to out.
+    void deflate(std::span<const std::uint8_t> in, std::vector<std::uint8_t>& out);
+
+    /// Adler-32 of bytes, continuing from adler (1 for a fresh checksum).
+    [[nodiscard]] std::uint32_t adler32(std::span<const std::uint8_t> bytes, std::uint32_t adler = 1) noexcept;
+
+    /// The Adler-32 of two pieces one after the other, from the checksums of each, so pieces can be summed in parallel.
+    [[nodiscard]] constexpr std::uint32_t adler32_combine(std::uint32_t first, std::uint32_t second, std::size_t second_length) noexcept;
+
+    /// CRC-32 (the zlib/PNG one) of bytes, continuing from crc (0 for a fresh checksum).
+    [[nodiscard]] std::uint32_t crc32(std::span<const std::uint8_t> bytes, std::uint32_t crc = 0) noexcept;
+
+}
+
+//DEFINITIONS
+
+inline bool ES::zlib::Secret::Huffman::build(const std::span<const std::uint8_t> lengths) noexcept {
+    std::array<std::uint16_t, max_bits + 1> counts{};
+    for (const std::uint8_t length : lengths) {
+        counts[length]++;
+    }
+    counts[0] = 0;
+    fast.fill(0);
+
+    std::array<std::uint16_t, max_bits + 1> next_code{};
+    std::uint32_t code = 0;
+    std::uint32_t symbol = 0;
+    for (unsigned length = 1; length <= max_bits; length++) {
+        next_code[length] = static_cast<std::uint16_t>(code);
+        first_code[length] = static_cast<std::uint16_t>(code);
+        first_symbol[length] = static_cast<std::uint16_t>(symbol);
+        code += counts[length];
+        if (counts[length] != 0 && code - 1 >= (1u << length)) {
+            return false;
+        }
+        max_code[length] = code << (16 - length);
+        code <<= 1;
+        symbol += counts[length];
+    }
+    max_code[max_bits + 1] = 0x10000; //sentinel, stops the slow walk
+
+    for (std::size_t i = 0; i < lengths.size(); i++) {
+        const unsigned length = lengths[i];
+        if (length == 0) {
+            continue;
+        }
+        symbols[next_code[length] - first_code[length] + first_symbol[length]] = static_cast<std::uint16_t>(i);
+        if (length <= fast_bits) {
+            //deflate sends codes most significant bit first, so the lookup index is the code reversed
+            const auto entry = static_cast<std::uint16_t>((length << 9) | i);
+            for (std::uint32_t j = reverse_bits(next_code[length], length); j < fast.size(); j += 1u << length) {
+                fast[j] = entry;
+            }
+        }
+        next_code[length]++;
+    }
+    return true;
+}
+
+template <ES::zlib::ByteSource Source>
+ES::zlib::Inflater<Source>::Inflater(Source source)
+    : source_(std::move(source)), window_(3 * Secret::history + 8) { } //+8, matches copy a word at a time and may run past
+
+template <ES::zlib::ByteSource Source>
+void ES::zlib::Inflater<Source>::refill() noexcept {
+    if (input_.size() >= 8) {
+        //the whole word goes in, bytes past what bit_count_ counts are just the ones coming next, loaded early
+        std::uint64_t word;
+        std::memcpy(&word, input_.data(), 8);
+        if constexpr (std::endian::native == std::endian::big) {
+            word = std::byteswap(word);
+        }
+        bits_ |= word << bit_count_;
+        const unsigned bytes = (63 - bit_count_) >> 3;
+        input_ = input_.subspan(bytes);
+        bit_count_ += 8 * bytes;
+        return;
+    }
+    while (bit_count_ <= 56) {
+        while (input_.empty()) {
+            input_ = source_.next();
+            if (input_.empty()) {
+                //out of input: make up zeros, and let the caller notice it ate them
+                bits_ &= (std::uint64_t{1} << bit_count_) - 1;
+                padding_ += (64 - bit_count_) / 8;
+                bit_count_ += 8 * ((64 - bit_count_) / 8);
+                return;
+            }
+        }
+        bits_ |= std::uint64_t{input_[0]} << bit_count_;
+        input_ = input_.subspan(1);
+        bit_count_ += 8;
+    }
+}
+
+template <ES::zlib::ByteSource Source>
+std::uint32_t ES::zlib::Inflater<Source>::take(const unsigned count) noexcept {
+    if (bit_count_ < count) {
+        refill();
+    }
+    const auto value = static_cast<std::uint32_t>(bits_ & ((std::uint64_t{1} << count) - 1));
+    bits_ >>= count;
+    bit_count_ -= count;
+    return value;
+}
+
+template <ES::zlib::ByteSource Source>
+int ES::zlib::Inflater<Source>::decode(const Secret::Huffman& code) noexcept {
+    if (bit_count_ < Secret::Huffman::max_bits) {
+        refill();
+    }
+    const std::uint16_t entry = code.fast[bits_ & ((1u << Secret::Huffman::fast_bits) - 1)];
+    if (entry != 0) {
+        const unsigned length = entry >> 9;
+        bits_ >>= length;
+        bit_count_ -= length;
+        return entry & 511;
+    }
+    const std::uint32_t reversed = Secret::reverse_bits(static_cast<std::uint32_t>(bits_ & 0xffff), 16);
+    unsigned length = Secret::Huffman::fast_bits + 1;
+    while (reversed >= code.max_code[length]) {
+        length++;
+    }
+    if (length > Secret::Huffman::max_bits) {
+        return -1;
+    }
+    const std::uint32_t index = (reversed >> (16 - length)) - code.first_code[length] + code.first_symbol[length];
+    if (index >= code.symbols.size()) {
+        return -1;
+    }
+    bits_ >>= length;
+    bit_count_ -= length;
+    return code.symbols[index];
+}
+
+template <ES::zlib::ByteSource Source>
+ES::zlib::Status ES::zlib::Inflater<Source>::read(const std::span<std::uint8_t> out) noexcept {
+    Status status;
+    (void)read_some(out, status);
+    return status;
+}
+
+template <ES::zlib::ByteSource Source>
+std::size_t ES::zlib::Inflater<Source>::read_some(const std::span<std::uint8_t> out, Status& status) noexcept {
+    std::size_t done = 0;
+    while (done < out.size()) {
+        if (read_ < write_) {
+            const std::size_t count = std::min(out.size() - done, write_ - read_);
+            std::memcpy(out.data() + done, window_.data() + read_, count);
+            read_ += count;
+            done += count;
+            continue;
+        }
+        if (state_ == State::done) {
+            status = Status::end_of_stream;
+            return done;
+        }
+        if (write_ + Secret::max_match > window_.size() - 8) {
+            //everything has been handed out, keep just the history matches can still reach
+            const std::size_t keep = std::min(write_, Secret::history);
+            std::memmove(window_.data(), window_.data() + write_ - keep, keep);
+            read_ = write_ = keep;
+        }
+        status = produce();
+        if (status == Status::ok && overran()) {
+            status = Status::truncated;
+        }
+        if (status != Status::ok) {
+            return done;
+        }
+    }
+    status = Status::ok;
+    return done;
+}
+
+template <ES::zlib::ByteSource Source>
+ES::zlib::Status ES::zlib::Inflater<Source>::produce() noexcept {
+    switch (state_) {
+        case State::zlib_header: {
+            const std::uint32_t method = take(8);
+            const std::uint32_t flags = take(8);
+            if ((method & 15) != 8 || (method >> 4) > 7 || ((method << 8) | flags) % 31 != 0 || (flags & 32) != 0) {
+                return overran() ? Status::truncated : Status::corrupt; //bad method, window size, check bits, or a preset dictionary
+            }
+            state_ = State::block_header;
+            return Status::ok;
+        }
+        case State::block_header:
+            if (final_block_) {
+                state_ = State::done;
+                return Status::ok;
+            }
+            return read_block_header();
+        case State::stored:
+            copy_stored();
+            return Status::ok;
+        case State::huffman:
+            return decode_huffman();
+        case State::done:
+            return Status::end_of_stream;
+    }
+    return Status::corrupt;
+}
+
+template <ES::zlib::ByteSource Source>
+ES::zlib::Status ES::zlib::Inflater<Source>::read_block_header() noexcept {
+    final_block_ = take(1) != 0;
+    switch (take(2)) {
+        case 0: {
+            //stored: skip to the byte boundary, then a length and its complement
+            (void)take(bit_count_ % 8);
+            const std::uint32_t length = take(16);
+            const std::uint32_t complement = take(16);
+            if ((length ^ 0xffff) != complement) {
+                return overran() ? Status::truncated : Status::corrupt;
+            }
+            stored_left_ = length;
+            state_ = State::stored;
+            return Status::ok;
+        }
+        case 1: {
+            std::array<std::uint8_t, 288 + 32> lengths;
+            std::fill_n(lengths.begin(), 144, 8);
+            std::fill_n(lengths.begin() + 144, 112, 9);
+            std::fill_n(lengths.begin() + 256, 24, 7);
+            std::fill_n(lengths.begin() + 280, 8, 8);
+            std::fill_n(lengths.begin() + 288, 32, 5);
+            (void)literals_.build(std::span(lengths).first(288));
+            (void)distances_.build(std::span(lengths).subspan(288));
+            state_ = State::huffman;
+            return Status::ok;
+        }
+        case 2:
+            return read_dynamic_tables();
+        default:
+            return Status::corrupt;
+    }
+}
+
+template <ES::zlib::ByteSource Source>
+ES::zlib::Status ES::zlib::Inflater<Source>::read_dynamic_tables() noexcept {
+    const std::uint32_t literal_count = take(5) + 257;
+    const std::uint32_t distance_count = take(5) + 1;
+    const std::uint32_t code_length_count = take(4) + 4;
+
+    std::array<std::uint8_t, 19> code_length_lengths{};
+    for (std::uint32_t i = 0; i < code_length_count; i++) {
+        code_length_lengths[Secret::code_length_order[i]] = static_cast<std::uint8_t>(take(3));
+    }
+    Secret::Huffman code_lengths;
+    if (!code_lengths.build(code_length_lengths)) {
+        return Status::corrupt;
+    }
+
+    //literal and distance lengths are one run, repeats may cross from one into the other
+    std::array<std::uint8_t, 288 + 32> lengths{};
+    const std::uint32_t total = literal_count + distance_count;
+    std::uint32_t filled = 0;
+    while (filled < total) {
+        const int symbol = decode(code_lengths);
+        if (symbol < 0) {
+            return Status::corrupt;
+        }
+        if (symbol < 16) {
+            lengths[filled++] = static_cast<std::uint8_t>(symbol);
+            continue;
+        }
+        std::uint8_t value = 0;
+        std::uint32_t repeat;
+        if (symbol == 16) {
+            if (filled == 0) {
+                return Status::corrupt;
+            }
+            value = lengths[filled - 1];
+            repeat = 3 + take(2);
+        } else if (symbol == 17) {
+            repeat = 3 + take(3);
+        } else {
+            repeat = 11 + take(7);
+        }
+        if (filled + repeat > total) {
+            return Status::corrupt;
+        }
+        std::fill_n(lengths.begin() + filled, repeat, value);
+        filled += repeat;
+    }
+    if (overran()) {
+        return Status::truncated;
+    }
+    if (lengths[256] == 0) {
+        return Status::corrupt; //no end of block code, the block could never end
+    }
+    const auto all = std::span(lengths);
+    if (!literals_.build(all.first(literal_count)) || !distances_.build(all.subspan(literal_count, distance_count))) {
+        return Status::corrupt;
+    }
+    state_ = State::huffman;
+    return Status::ok;
+}
+
+template <ES::zlib::ByteSource Source>
+void ES::zlib::Inflater<Source>::copy_stored() noexcept {
+    std::size_t count = std::min(stored_left_, window_.size() - 8 - write_);
+    stored_left_ -= count;
+
+    //whole bytes already sitting in the bit buffer go first, then straight from the source
+    while (count > 0 && bit_count_ >= 8) {
+        window_[write_++] = static_cast<std::uint8_t>(take(8));
+        count--;
+    }
+    if (count > 0) {
+        bits_ = 0; //the buffer is empty, anything loaded early is read again below
+    }
+    while (count > 0) {
+        if (input_.empty()) {
+            input_ = source_.next();
+            if (input_.empty()) {
+                padding_ += count + 1;
+                std::fill_n(window_.data() + write_, count, std::uint8_t{0});
+                write_ += count;
+                break;
+            }
+        }
+        const std::size_t chunk = std::min(count, input_.size());
+        std::memcpy(window_.data() + write_, input_.data(), chunk);
+        input_ = input_.subspan(chunk);
+        write_ += chunk;
+        count -= chunk;
+    }
+    if (stored_left_ == 0) {
+        state_ = State::block_header;
+    }
+}
+
+template <ES::zlib::ByteSource Source>
+ES::zlib::Status ES::zlib::Inflater<Source>::decode_huffman() noexcept {
+    std::uint8_t* const window = window_.data();
+    const std::size_t limit = window_.size() - 8 - Secret::max_match;
+    std::size_t write = write_;
+
+    while (write <= limit) {
+        //48 bits covers the longest length code, its extra bits, the longest distance code and its extra bits
+        if (bit_count_ < 48) {
+            refill();
+        }
+        const int symbol = decode(literals_);
+        if (symbol < 256) {
+            if (symbol < 0) {
+                write_ = write;
+                return Status::corrupt;
+            }
+            window[write++] = static_cast<std::uint8_t>(symbol);
+            continue;
+        }
+        if (symbol == 256) {
+            state_ = State::block_header;
+            break;
+        }
+        const int length_index = symbol - 257;
+        if (length_index >= 29) {
+            write_ = write;
+            return Status::corrupt;
+        }
+        const std::size_t length = Secret::length_base[length_index] + take(Secret::length_extra[length_index]);
+        const int distance_index = decode(distances_);
+        if (distance_index < 0 || distance_index >= 30) {
+            write_ = write;
+            return Status::corrupt;
+        }
+        const std::size_t distance = Secret::distance_base[distance_index] + take(Secret::distance_extra[distance_index]);
+        if (distance > write) {
+            write_ = write;
+            return overran() ? Status::truncated : Status::corrupt; //reaches back before the start of the stream
+        }
+
+        std::uint8_t* to = window + write;
+        const std::uint8_t* from = to - distance;
+        if (distance >= 8) {
+            //a word at a time, each word only reads bytes written before it. May run up to 7 bytes past, into the slack
+            for (std::size_t i = 0; i < length; i += 8) {
+                std::memcpy(to + i, from + i, 8);
+            }
+        } else if (distance == 1) {
+            std::memset(to, *from, length);
+        } else {
+            for (std::size_t i = 0; i < length; i++) {
+                to[i] = from[i];
+            }
+        }
+        write += length;
+    }
+    write_ = write;
+    return Status::ok;
+}
+
+inline ES::zlib::Status ES::zlib::inflate(const std::span<const std::uint8_t> compressed, std::vector<std::uint8_t>& out) {
+    Inflater<SpanSource> inflater(SpanSource{compressed});
+    Status status = Status::ok;
+    while (status == Status::ok) {
+        const std::size_t before = out.size();
+        out.resize(before + 65536);
+        out.resize(before + inflater.read_some(std::span(out).subspan(before), status));
+    }
+    return status == Status::end_of_stream ? Status::ok : status;
+}
+
+inline void ES::zlib::deflate_fast(const std::span<const std::uint8_t> in, std::vector<std::uint8_t>& out, const bool final) {
+    constexpr unsigned hash_bits = 15;
+    const std::uint8_t* const data = in.data();
+    const std::size_t size = in.size();
+
+    //every byte a 9 bit literal is as bad as it gets, plus the block headers
+    const std::size_t start = out.size();
+    out.resize(start + size + size / 8 + 16);
+    Secret::BitWriter writer{out.data() + start};
+    writer.put(final ? 3 : 2, 3); //BFINAL, then BTYPE 01: fixed Huffman
+
+    std::vector<std::uint32_t> table(std::size_t{1} << hash_bits, 0);
+    std::size_t position = 0;
+    while (position + 4 <= size) {
+        const std::uint32_t word = Secret::load_le32(data + position);
+        const std::uint32_t hash = (word * 0x9e3779b1u) >> (32 - hash_bits);
+        const std::size_t candidate = table[hash];
+        table[hash] = static_cast<std::uint32_t>(position);
+
+        const std::size_t distance = position - candidate;
+        if (distance - 1 >= Secret::history || Secret::load_le32(data + candidate) != word) {
+            const Secret::Code literal = Secret::fixed_literals[data[position]];
+            writer.put(literal.bits, literal.length);
+            position++;
+            continue;
+        }
+
+        //four bytes known to match, the rest a word at a time: the first differing byte is the lowest set one of the xor
+        const std::size_t longest = std::min(Secret::max_match, size - position);
+        std::size_t length = 4;
+        while (length + 8 <= longest) {
+            const std::uint64_t difference = Secret::load_le64(data + candidate + length) ^ Secret::load_le64(data + position + length);
+            if (difference != 0) {
+                length += static_cast<std::size_t>(std::countr_zero(difference)) >> 3;
+                goto matched;
+            }
+            length += 8;
+        }
+        while (length < longest && data[candidate + length] == data[position + length]) {
+            length++;
+        }
+    matched:
+        const Secret::Code length_code = Secret::fixed_lengths[length];
+        writer.put(length_code.bits, length_code.length);
+
+        //distance codes come in pairs per power of two, from 5 on: the symbol is twice the log plus the next bit down
+        const auto offset = static_cast<std::uint32_t>(distance - 1);
+        if (offset < 4) {
+            writer.put(Secret::reverse_bits(offset, 5), 5);
+        } else {
+            const unsigned log = static_cast<unsigned>(std::bit_width(offset)) - 1;
+            const unsigned extra_bits = log - 1;
+            const std::uint32_t symbol = 2 * log + ((offset >> extra_bits) & 1u);
+            writer.put(Secret::reverse_bits(symbol, 5) | ((offset & ((1u << extra_bits) - 1)) << 5), 5 + extra_bits);
+        }
+        position += length;
+    }
+    for (; position < size; position++) {
+        const Secret::Code literal = Secret::fixed_literals[data[position]];
+        writer.put(literal.bits, literal.length);
+    }
+    writer.put(0, 7); //end of block, code 256 is seven zero bits
+
+    if (!final) {
+        //an empty stored block: its header, the pad to a byte boundary, then length 0 and its complement
+        writer.put(0, 3);
+        writer.flush();
+        writer.put(0xffff0000u, 32);
+    }
+    writer.flush();
+    out.resize(static_cast<std::size_t>(writer.out - out.data()));
+}
+
+inline void ES::zlib::deflate(const std::span<const std::uint8_t> in, std::vector<std::uint8_t>& out) {
+    out.push_back(0x78); //deflate, 32K window
+    out.push_back(0x01); //fastest, and the check bits
+    deflate_fast(in, out, true);
+    const std::uint32_t adler = adler32(in);
+    out.insert(out.end(), {std::uint8_t(adler >> 24), std::uint8_t(adler >> 16), std::uint8_t(adler >> 8), std::uint8_t(adler)});
+}
+
+inline std::uint32_t ES::zlib::adler32(std::span<const std::uint8_t> bytes, const std::uint32_t adler) noexcept {
+    constexpr std::uint32_t base = 65521;
+    //4096 bytes keeps the weighted sum below in 32 bits
+    constexpr std::size_t block = 4096;
+    std::uint32_t a = adler & 0xffff;
+    std::uint32_t b = adler >> 16;
+    while (!bytes.empty()) {
+        const std::size_t count = std::min(block, bytes.size());
+        //the running sum b picks up every byte once for each step after it, so a block is a plain and a weighted
+        //reduction, which vectorize, instead of a chain of dependent adds
+        std::uint32_t sum = 0;
+        std::uint32_t weighted = 0;
+        const std::uint8_t* data = bytes.data();
+        ES_VECTORIZE
+        for (std::size_t i = 0; i < count; i++) {
+            sum += data[i];
+            weighted += static_cast<std::uint32_t>(count - i) * data[i];
+        }
+        b = static_cast<std::uint32_t>((b + std::uint64_t{count} * a + weighted) % base);
+        a = (a + sum) % base;
+        bytes = bytes.subspan(count);
+    }
+    return a | (b << 16);
+}
+
+constexpr std::uint32_t ES::zlib::adler32_combine(const std::uint32_t first, const std::uint32_t second, const std::size_t second_length) noexcept {
+    constexpr std::uint64_t base = 65521;
+    const std::uint64_t remainder = second_length % base;
+    const std::uint64_t a = ((first & 0xffff) + (second & 0xffff) + base - 1) % base;
+    const std::uint64_t b = ((first >> 16) + (second >> 16) + remainder * (first & 0xffff) + base - remainder) % base;
+    return static_cast<std::uint32_t>(a | (b << 16));
+}
+
+inline std::uint32_t ES::zlib::crc32(std::span<const std::uint8_t> bytes, std::uint32_t crc) noexcept {
+    const auto& t = Secret::crc_tables;
+    crc = ~crc;
+    while (bytes.size() >= 8) {
+        const std::uint32_t low = Secret::load_le32(bytes.data()) ^ crc;
+        const std::uint32_t high = Secret::load_le32(bytes.data() + 4);
+        crc = t[7][low & 0xff] ^ t[6][(low >> 8) & 0xff] ^ t[5][(low >> 16) & 0xff] ^ t[4][low >> 24]
+            ^ t[3][high & 0xff] ^ t[2][(high >> 8) & 0xff] ^ t[1][(high >> 16) & 0xff] ^ t[0][high >> 24];
+        bytes = bytes.subspan(8);
+    }
+    for (const std::uint8_t byte : bytes) {
+        crc = t[0][(crc ^ byte) & 0xff] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+#endif //COMPUTERGRAPHICS_ESZLIB_HPP
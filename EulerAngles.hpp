@@ -1,9 +1,24 @@
 #pragma once
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include <span>
 #include "Angle.hpp"
 #include "ContainerN.hpp"
 #include "ArithmeticOpsMixin.hpp"
+#include "ES_simd.hpp"
+#include "Matrix.hpp"
+#include "Quaternion.hpp"
 
 namespace ES{
+    /**
+     * @brief Yaw, pitch and roll, as in a camera: y up, yaw about +y, pitch about +x, roll about +z.
+     *
+     * The rotation they stand for is R = R_y(yaw) * R_x(pitch) * R_z(roll), roll applied first. Pitch is the middle
+     * angle, which is why canonicalize keeps it in [-pi/2, pi/2].
+     */
     template <ES::radian_or_degree Unit, typename T>
     class EulerAngles : public ContainerN<EulerAngles<Unit,T>,Angle<Unit,T>,3>, public ArithmeticOpsMixin<EulerAngles<Unit,T>, Angle<Unit,T>,3>{
         
@@ -84,51 +99,221 @@ namespace ES{
         }
 
         
+        // every angle into [-half a turn, half a turn)
         [[nodiscard]] constexpr EulerAngles normalize() const noexcept{
-            EulerAngles temp(*this); 
-            temp.yaw() = yaw().wrap_to(-ES::math::pi<T>,ES::math::pi<T>);
-            temp.pitch() = pitch().wrap_to(-ES::math::pi<T>,ES::math::pi<T>);
-            temp.roll() = roll().wrap_to(-ES::math::pi<T>,ES::math::pi<T>);
-            return temp;
+            EulerAngles temp(*this);
+            return temp.normalize_in_place();
         }
         constexpr EulerAngles& normalize_in_place() noexcept{
-            yaw().wrap_to_in_place(-ES::math::pi<T>,ES::math::pi<T>);
-            pitch().wrap_to_in_place(-ES::math::pi<T>,ES::math::pi<T>);
-            roll().wrap_to_in_place(-ES::math::pi<T>,ES::math::pi<T>);
+            yaw().wrap_to_in_place(-half_turn, half_turn);
+            pitch().wrap_to_in_place(-half_turn, half_turn);
+            roll().wrap_to_in_place(-half_turn, half_turn);
             return *this;
         }
 
+        // normalize, with pitch wrapped further into [-a quarter turn, a quarter turn)
         [[nodiscard]] constexpr EulerAngles canonicalize() const noexcept{
-            EulerAngles temp = normalize();
-            temp.pitch().wrap_to_in_place(-ES::math::half_pi<T>,ES::math::half_pi<T>);
-            return temp;
+            EulerAngles temp(*this);
+            return temp.canonicalize_in_place();
         }
         constexpr EulerAngles& canonicalize_in_place() noexcept{
-            normalize_in_place();
-            pitch().wrap_to_in_place(-ES::math::half_pi<T>,ES::math::half_pi<T>);
+            yaw().wrap_to_in_place(-half_turn, half_turn);
+            pitch().wrap_to_in_place(-quarter_turn, quarter_turn); //the same as wrapping it by a whole turn first
+            roll().wrap_to_in_place(-half_turn, half_turn);
             return *this;
         }
 
+        /**
+         * @brief normalize_in_place over a whole batch, vectorized.
+         */
+        static void normalize_all(std::span<EulerAngles> angles) noexcept{
+            wrap_all<Unit, false>(angles, angles);
+        }
+
+        /**
+         * @brief Converts a batch from OtherUnit and normalizes it on the way, one pass over the data.
+         * @param out the same length as in
+         */
+        template <ES::radian_or_degree OtherUnit>
+        static void normalize_all(std::span<const EulerAngles<OtherUnit,T>> in, std::span<EulerAngles> out) noexcept{
+            wrap_all<OtherUnit, false>(in, out);
+        }
+
+        static void canonicalize_all(std::span<EulerAngles> angles) noexcept{
+            wrap_all<Unit, true>(angles, angles);
+        }
+
+        template <ES::radian_or_degree OtherUnit>
+        static void canonicalize_all(std::span<const EulerAngles<OtherUnit,T>> in, std::span<EulerAngles> out) noexcept{
+            wrap_all<OtherUnit, true>(in, out);
+        }
+
         [[nodiscard]] /* c++ 26 constexpr*/ T sin_yaw()  const noexcept{
-            return std::sin(yaw().get());
+            return std::sin(radians(yaw()));
         }
         [[nodiscard]] /* c++ 26 constexpr*/ T cos_yaw()  const noexcept{
-            return std::cos(yaw().get());
+            return std::cos(radians(yaw()));
         }
         [[nodiscard]] /* c++ 26 constexpr*/ T sin_pitch() const noexcept {
-            return std::sin(pitch().get());
+            return std::sin(radians(pitch()));
         }
         [[nodiscard]] /* c++ 26 constexpr*/ T cos_pitch() const noexcept {
-            return std::cos(pitch().get());
+            return std::cos(radians(pitch()));
         }
         [[nodiscard]] /* c++ 26 constexpr*/ T sin_roll() const noexcept{
-            return std::sin(roll().get());
+            return std::sin(radians(roll()));
         }
         [[nodiscard]] /* c++ 26 constexpr*/ T cos_roll() const noexcept{
-            return std::cos(roll().get());
+            return std::cos(radians(roll()));
+        }
+
+        // all six of the above off three range reductions, in yaw, pitch, roll order
+        [[nodiscard]] /* c++ 26 constexpr*/ std::array<math::SinCos<T>,3> sincos() const noexcept{
+            return {math::sincos(radians(yaw())), math::sincos(radians(pitch())), math::sincos(radians(roll()))};
+        }
+
+        [[nodiscard]] /* c++ 26 constexpr*/ Quaternion<T> to_quaternion() const noexcept{
+            const auto y = math::sincos(radians(yaw()) * T{0.5});
+            const auto p = math::sincos(radians(pitch()) * T{0.5});
+            const auto r = math::sincos(radians(roll()) * T{0.5});
+            return compose_quaternion(y.sin, y.cos, p.sin, p.cos, r.sin, r.cos);
+        }
+
+        [[nodiscard]] /* c++ 26 constexpr*/ Matrix<T,3> to_matrix3() const noexcept{
+            const auto [y, p, r] = sincos();
+            return compose_matrix(y.sin, y.cos, p.sin, p.cos, r.sin, r.cos);
+        }
+
+        // at gimbal lock (pitch of +-90 degrees) yaw and roll are the same axis, roll comes back as zero
+        [[nodiscard]] static /* c++ 26 constexpr*/ EulerAngles from_quaternion(const Quaternion<T>& q) noexcept{
+            const T w = q.w(), x = q.x(), y = q.y(), z = q.z();
+            //the five entries of to_matrix3() we need, see compose_matrix for which is which
+            const T m02 = T{2}*(x*z + w*y);
+            const T m22 = T{1} - T{2}*(x*x + y*y);
+            const T m12 = T{2}*(y*z - w*x);
+            const T m10 = T{2}*(x*y + w*z);
+            const T m11 = T{1} - T{2}*(x*x + z*z);
+            const T m00 = T{1} - T{2}*(y*y + z*z);
+            const T m01 = T{2}*(x*y - w*z);
+
+            const T sin_pitch = std::clamp(-m12, T{-1}, T{1});
+            T yaw_rad, pitch_rad, roll_rad;
+            if(std::fabs(sin_pitch) > T{1} - T{16} * std::numeric_limits<T>::epsilon()){
+                //asin is at its steepest here, snapping beats trusting the last few bits of sin_pitch
+                yaw_rad = std::atan2(sin_pitch * m01, m00);
+                pitch_rad = std::copysign(math::half_pi<T>, sin_pitch);
+                roll_rad = T{0};
+            }
+            else{
+                yaw_rad = std::atan2(m02, m22);
+                pitch_rad = std::asin(sin_pitch);
+                roll_rad = std::atan2(m10, m11);
+            }
+            return EulerAngles(from_radians(yaw_rad), from_radians(pitch_rad), from_radians(roll_rad));
         }
 
+        /**
+         * @brief to_quaternion over a whole batch, with the sincos of every angle vectorized.
+         * @param out the same length as angles
+         */
+        static void to_quaternions(std::span<const EulerAngles> angles, std::span<Quaternion<T>> out) noexcept{
+            assert(angles.size() == out.size() && "to_quaternions needs one output per EulerAngles");
+            batch_sincos(angles, T{0.5}, [out](std::size_t i, T sy, T cy, T sp, T cp, T sr, T cr){
+                out[i] = compose_quaternion(sy, cy, sp, cp, sr, cr);
+            });
+        }
+
+        static void to_matrices3(std::span<const EulerAngles> angles, std::span<Matrix<T,3>> out) noexcept{
+            assert(angles.size() == out.size() && "to_matrices3 needs one output per EulerAngles");
+            batch_sincos(angles, T{1}, [out](std::size_t i, T sy, T cy, T sp, T cp, T sr, T cr){
+                out[i] = compose_matrix(sy, cy, sp, cp, sr, cr);
+            });
+        }
+
+        static void from_quaternions(std::span<const Quaternion<T>> quaternions, std::span<EulerAngles> out) noexcept{
+            assert(quaternions.size() == out.size() && "from_quaternions needs one output per Quaternion");
+            for(std::size_t i = 0; i<quaternions.size(); i++){
+                out[i] = from_quaternion(quaternions[i]);
+            }
+        }
 
+        private:
+
+        static constexpr T to_radians_factor = ES::Secret::unit_factor<Unit, in_radians, T>;
+        static constexpr T half_turn = ES::Secret::full_turn<Unit, T> / T{2};
+        static constexpr T quarter_turn = ES::Secret::full_turn<Unit, T> / T{4};
+
+        //the batch normalize and canonicalize, the unit conversion folded into the same loop. in may be out
+        template <ES::radian_or_degree FromUnit, bool Canonical>
+        static void wrap_all(std::span<const EulerAngles<FromUnit,T>> in, std::span<EulerAngles> out) noexcept{
+            assert(in.size() == out.size() && "normalize_all/canonicalize_all need one output per EulerAngles");
+            constexpr T factor = ES::Secret::unit_factor<FromUnit, Unit, T>;
+            //yaw, pitch, roll. Wrapping by half a turn after a whole one is the same as only wrapping by half a turn
+            constexpr std::array<T,3> lower = {-half_turn, Canonical ? -quarter_turn : -half_turn, -half_turn};
+            constexpr std::array<T,3> range = {T{2} * half_turn, Canonical ? half_turn : T{2} * half_turn, T{2} * half_turn};
+            ES_VECTORIZE
+            for(std::size_t i = 0; i<in.size(); i++){
+                const EulerAngles<FromUnit,T>& from = in[i];
+                const T yaw = ES::Secret::wrap_angle_coeff(from[0].get() * factor, lower[0], range[0]);
+                const T pitch = ES::Secret::wrap_angle_coeff(from[1].get() * factor, lower[1], range[1]);
+                const T roll = ES::Secret::wrap_angle_coeff(from[2].get() * factor, lower[2], range[2]);
+                EulerAngles& to = out[i];
+                to[0].get() = yaw;
+                to[1].get() = pitch;
+                to[2].get() = roll;
+            }
+        }
+
+        [[nodiscard]] static constexpr T radians(Angle<Unit,T> angle) noexcept{
+            return angle.get() * to_radians_factor;
+        }
+
+        [[nodiscard]] static constexpr Angle<Unit,T> from_radians(T angle) noexcept{
+            return Angle<Unit,T>(angle / to_radians_factor);
+        }
+
+        // q_y(yaw) * q_x(pitch) * q_z(roll), from the sines and cosines of the half angles
+        [[nodiscard]] static constexpr Quaternion<T> compose_quaternion(T sy, T cy, T sp, T cp, T sr, T cr) noexcept{
+            return Quaternion<T>(cy*cp*cr + sy*sp*sr,
+                                 cy*sp*cr + sy*cp*sr,
+                                 sy*cp*cr - cy*sp*sr,
+                                 cy*cp*sr - sy*sp*cr);
+        }
+
+        // R_y(yaw) * R_x(pitch) * R_z(roll), from the sines and cosines of the angles
+        [[nodiscard]] static constexpr Matrix<T,3> compose_matrix(T sy, T cy, T sp, T cp, T sr, T cr) noexcept{
+            Matrix<T,3> temp;
+            temp(0,0) = cy*cr + sy*sp*sr;  temp(0,1) = sy*sp*cr - cy*sr;  temp(0,2) = sy*cp;
+            temp(1,0) = cp*sr;             temp(1,1) = cp*cr;             temp(1,2) = -sp;
+            temp(2,0) = cy*sp*sr - sy*cr;  temp(2,1) = sy*sr + cy*sp*cr;  temp(2,2) = cy*cp;
+            return temp;
+        }
+
+        //scales every angle to radians (times scale), sincoses a block of them at once and hands the six results
+        //for each element to emit(i, sin yaw, cos yaw, sin pitch, cos pitch, sin roll, cos roll). The block is a few
+        //lanes wide so the vectorized loop inside sincos gets a long enough run to pay for itself
+        template <typename Emit>
+        static void batch_sincos(std::span<const EulerAngles> angles, T scale, Emit&& emit) noexcept{
+            constexpr std::size_t W = 16 * simd::lanes<T>;
+            alignas(simd::register_bytes) std::array<T, 3*W> in, sines, cosines;
+            const T factor = to_radians_factor * scale;
+            for(std::size_t base = 0; base<angles.size(); base += W){
+                const std::size_t n = std::min(W, angles.size() - base);
+                for(std::size_t lane = 0; lane<n; lane++){
+                    const EulerAngles& e = angles[base + lane];
+                    in[lane] = e.yaw().get() * factor;
+                    in[W + lane] = e.pitch().get() * factor;
+                    in[2*W + lane] = e.roll().get() * factor;
+                }
+                std::fill(in.begin() + n, in.begin() + W, T{0}); //tail padding, never emitted
+                std::fill(in.begin() + W + n, in.begin() + 2*W, T{0});
+                std::fill(in.begin() + 2*W + n, in.end(), T{0});
+                math::sincos<T>(in, sines, cosines);
+                for(std::size_t lane = 0; lane<n; lane++){
+                    emit(base + lane, sines[lane], cosines[lane], sines[W + lane], cosines[W + lane], sines[2*W + lane], cosines[2*W + lane]);
+                }
+            }
+        }
 
     };
 
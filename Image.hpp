@@ -0,0 +1,321 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include "ES_parallel.hpp"
+#include "ColorN.hpp"
+
+
+namespace ES{
+
+    /// Every row of an Image starts on this many bytes: a cache line, and a full AVX-512 register.
+    inline constexpr std::size_t image_row_alignment = 64;
+
+    /// Anything an image can hold: plain bytes with no lifetime of their own (RGB, RGBA, RGB8, RGBA8, LA, RGB_Int...).
+    template <typename Pixel>
+    concept ImagePixel = std::is_trivially_copyable_v<Pixel> && std::is_trivially_destructible_v<Pixel>;
+
+    /// Rows per parallel job when a pass is split by rows and nobody said otherwise.
+    inline constexpr std::size_t default_row_grain = 16;
+
+    /**
+     * @brief A non owning window onto pixels: width x height of them, rows row_pitch bytes apart.
+     *
+     * Every row is contiguous, which is what SIMD loops want, but rows need not follow each other: the pitch can be
+     * anything that keeps pixels aligned, including negative (a bottom up buffer, or flipped_vertically()). That
+     * makes sub-rectangles free, and wrapping memory owned by somebody else (a mapped GPU buffer, a decoder's
+     * output) a matter of calling the constructor.
+     *
+     * @tparam Pixel const qualified for a read only view. An ImageView<P> converts to ImageView<const P>.
+     */
+    template <typename Pixel> requires ImagePixel<std::remove_const_t<Pixel>>
+    class ImageView{
+        using Byte = std::conditional_t<std::is_const_v<Pixel>, const std::byte, std::byte>;
+
+        Pixel* data_ = nullptr;
+        std::size_t width_ = 0;
+        std::size_t height_ = 0;
+        std::ptrdiff_t row_pitch_ = 0;
+
+    public:
+        using value_type = std::remove_const_t<Pixel>;
+
+        constexpr ImageView() noexcept = default;
+
+        /**
+         * @brief Wraps width x height pixels at data, no copy.
+         * @param row_pitch bytes from the start of one row to the start of the next, tightly packed if left out
+         */
+        constexpr ImageView(Pixel* data, std::size_t width, std::size_t height, std::ptrdiff_t row_pitch) noexcept
+            : data_(data), width_(width), height_(height), row_pitch_(row_pitch){
+            assert(row_pitch % static_cast<std::ptrdiff_t>(alignof(Pixel)) == 0 && "ImageView row pitch would misalign pixels");
+            assert((height < 2 || static_cast<std::size_t>(row_pitch < 0 ? -row_pitch : row_pitch) >= width * sizeof(Pixel))
+                   && "ImageView rows overlap");
+        }
+
+        constexpr ImageView(Pixel* data, std::size_t width, std::size_t height) noexcept
+            : ImageView(data, width, height, static_cast<std::ptrdiff_t>(width * sizeof(Pixel))) { }
+
+        // the read only view of a writable one
+        template <typename Other> requires (std::is_const_v<Pixel> && std::is_same_v<const Other, Pixel>)
+        constexpr ImageView(const ImageView<Other>& other) noexcept
+            : data_(other.data()), width_(other.width()), height_(other.height()), row_pitch_(other.row_pitch()) { }
+
+        [[nodiscard]] constexpr std::size_t width() const noexcept{ return width_; }
+        [[nodiscard]] constexpr std::size_t height() const noexcept{ return height_; }
+        [[nodiscard]] constexpr std::size_t size() const noexcept{ return width_ * height_; }
+        [[nodiscard]] constexpr bool empty() const noexcept{ return width_ == 0 || height_ == 0; }
+        [[nodiscard]] constexpr std::ptrdiff_t row_pitch() const noexcept{ return row_pitch_; }
+
+        // the first pixel of the first row
+        [[nodiscard]] constexpr Pixel* data() const noexcept{ return data_; }
+
+        // rows follow each other with no gap, so the whole view is one span (see pixels())
+        [[nodiscard]] constexpr bool is_contiguous() const noexcept{
+            return height_ < 2 || row_pitch_ == static_cast<std::ptrdiff_t>(width_ * sizeof(Pixel));
+        }
+
+        [[nodiscard]] /* constexpr in c++26*/ Pixel* row_data(std::size_t y) const noexcept{
+            assert(y < height_ && "ImageView row out of range");
+            return reinterpret_cast<Pixel*>(reinterpret_cast<Byte*>(data_) + static_cast<std::ptrdiff_t>(y) * row_pitch_);
+        }
+
+        [[nodiscard]] /* constexpr in c++26*/ std::span<Pixel> row(std::size_t y) const noexcept{
+            return std::span<Pixel>(row_data(y), width_);
+        }
+
+        [[nodiscard]] /* constexpr in c++26*/ Pixel& operator()(std::size_t x, std::size_t y) const noexcept{
+            assert(x < width_ && "ImageView column out of range");
+            return row_data(y)[x];
+        }
+
+        // every pixel as one span, only for contiguous views
+        [[nodiscard]] constexpr std::span<Pixel> pixels() const noexcept{
+            assert(is_contiguous() && "ImageView::pixels on a view with gaps between its rows, go row by row");
+            return std::span<Pixel>(data_, size());
+        }
+
+        // the w x h rectangle with its top left corner at (x, y), sharing these pixels
+        [[nodiscard]] /* constexpr in c++26*/ ImageView subview(std::size_t x, std::size_t y, std::size_t w, std::size_t h) const noexcept{
+            assert(x + w <= width_ && y + h <= height_ && "ImageView::subview reaches outside the view");
+            if(w == 0 || h == 0){
+                return ImageView(data_, w, h, row_pitch_);
+            }
+            return ImageView(row_data(y) + x, w, h, row_pitch_);
+        }
+
+        // the same pixels bottom row first, for APIs that count rows upwards
+        [[nodiscard]] /* constexpr in c++26*/ ImageView flipped_vertically() const noexcept{
+            if(empty()){
+                return *this;
+            }
+            return ImageView(row_data(height_ - 1), width_, height_, -row_pitch_);
+        }
+
+        void fill(const value_type& value) const noexcept requires (!std::is_const_v<Pixel>){
+            for(std::size_t y = 0; y<height_; y++){
+                std::fill_n(row_data(y), width_, value);
+            }
+        }
+
+        // copies into a view of the same size, row by row (one memcpy when both are contiguous)
+        void copy_to(const ImageView<value_type>& destination) const noexcept{
+            assert(destination.width() == width_ && destination.height() == height_ && "ImageView::copy_to needs a destination of the same size");
+            if(is_contiguous() && destination.is_contiguous()){
+                std::memcpy(static_cast<void*>(destination.data()), static_cast<const void*>(data_), size() * sizeof(Pixel));
+                return;
+            }
+            for(std::size_t y = 0; y<height_; y++){
+                std::memcpy(static_cast<void*>(destination.row_data(y)), static_cast<const void*>(row_data(y)), width_ * sizeof(Pixel));
+            }
+        }
+
+        /**
+         * @brief func(y, row) for every row top to bottom, row being a contiguous std::span<Pixel>.
+         */
+        template <typename Func>
+        void for_each_row(Func&& func) const{
+            for(std::size_t y = 0; y<height_; y++){
+                func(y, row(y));
+            }
+        }
+
+        /**
+         * @brief func(x, y, tile) over tile_width x tile_height subviews covering the view, row of tiles by row of
+         * tiles. Tiles on the right and bottom edges are cut down to what is left.
+         */
+        template <typename Func>
+        void for_each_tile(std::size_t tile_width, std::size_t tile_height, Func&& func) const{
+            assert(tile_width > 0 && tile_height > 0 && "ImageView tiles need a size");
+            for(std::size_t y = 0; y<height_; y += tile_height){
+                for(std::size_t x = 0; x<width_; x += tile_width){
+                    func(x, y, subview(x, y, std::min(tile_width, width_ - x), std::min(tile_height, height_ - y)));
+                }
+            }
+        }
+
+        /**
+         * @brief for_each_row spread across the pool, grain rows to a job.
+         *
+         * func is called concurrently for different rows, so it must only write to its own row.
+         */
+        template <typename Func>
+        void parallel_for_rows(Func&& func, std::size_t grain = default_row_grain, parallel::ThreadPool& pool = parallel::default_pool()) const{
+            parallel::for_chunks(height_, grain, [this, &func](std::size_t begin, std::size_t end){
+                for(std::size_t y = begin; y<end; y++){
+                    func(y, row(y));
+                }
+            }, pool);
+        }
+
+        /**
+         * @brief for_each_tile spread across the pool, one tile to a job.
+         *
+         * Tiles keep a job's working set small in both directions, which row bands can't when a pass also reads the
+         * rows above and below. func is called concurrently for different tiles.
+         */
+        template <typename Func>
+        void parallel_for_tiles(std::size_t tile_width, std::size_t tile_height, Func&& func, parallel::ThreadPool& pool = parallel::default_pool()) const{
+            assert(tile_width > 0 && tile_height > 0 && "ImageView tiles need a size");
+            const std::size_t across = (width_ + tile_width - 1) / tile_width;
+            const std::size_t down = (height_ + tile_height - 1) / tile_height;
+            parallel::for_chunks(across * down, 1, [&](std::size_t begin, std::size_t end){
+                for(std::size_t tile = begin; tile<end; tile++){
+                    const std::size_t x = (tile % across) * tile_width;
+                    const std::size_t y = (tile / across) * tile_height;
+                    func(x, y, subview(x, y, std::min(tile_width, width_ - x), std::min(tile_height, height_ - y)));
+                }
+            }, pool);
+        }
+    };
+
+
+    /**
+     * @brief An owning width x height image, every row starting on an image_row_alignment byte boundary.
+     *
+     * One allocation. Rows are padded out to the alignment, so a row can be run through aligned vector loads start to
+     * finish, and the padding (never read by anything here) gives kernels room to overrun the last pixel by a
+     * register. Everything that reads or writes pixels goes through view(), the accessors here just forward to it.
+     *
+     * @tparam Pixel one of the ColorN types (RGB, RGBA, RGB8, RGBA8, LA, RGB_Int...), or anything else ImagePixel.
+     */
+    template <ImagePixel Pixel>
+    class Image{
+        struct AlignedDelete{
+            void operator()(std::byte* bytes) const noexcept{
+                ::operator delete(bytes, std::align_val_t{image_row_alignment});
+            }
+        };
+
+        std::unique_ptr<std::byte, AlignedDelete> bytes_;
+        std::size_t width_ = 0;
+        std::size_t height_ = 0;
+        std::size_t row_pitch_ = 0;
+
+        void allocate(){
+            const std::size_t total = row_pitch_ * height_;
+            if(total == 0){
+                return;
+            }
+            bytes_.reset(static_cast<std::byte*>(::operator new(total, std::align_val_t{image_row_alignment})));
+        }
+
+    public:
+        using value_type = Pixel;
+
+        Image() noexcept = default;
+
+        // every pixel zeroed, which for every ColorN type is transparent black
+        Image(std::size_t width, std::size_t height)
+            : width_(width), height_(height), row_pitch_(aligned_row_pitch(width)){
+            allocate();
+            if(bytes_){
+                std::memset(bytes_.get(), 0, row_pitch_ * height_);
+            }
+        }
+
+        Image(std::size_t width, std::size_t height, const Pixel& fill)
+            : width_(width), height_(height), row_pitch_(aligned_row_pitch(width)){
+            allocate();
+            view().fill(fill);
+        }
+
+        // a deep copy of whatever the view shows, repacked to this image's pitch
+        explicit Image(const ImageView<const Pixel>& source)
+            : width_(source.width()), height_(source.height()), row_pitch_(aligned_row_pitch(source.width())){
+            allocate();
+            source.copy_to(view());
+        }
+
+        Image(const Image& other) : Image(other.view()) { }
+
+        Image& operator=(const Image& other){
+            if(this != &other){
+                Image copy(other);
+                *this = std::move(copy);
+            }
+            return *this;
+        }
+
+        Image(Image&& other) noexcept
+            : bytes_(std::move(other.bytes_)), width_(std::exchange(other.width_, 0)),
+              height_(std::exchange(other.height_, 0)), row_pitch_(std::exchange(other.row_pitch_, 0)) { }
+
+        Image& operator=(Image&& other) noexcept{
+            bytes_ = std::move(other.bytes_);
+            width_ = std::exchange(other.width_, 0);
+            height_ = std::exchange(other.height_, 0);
+            row_pitch_ = std::exchange(other.row_pitch_, 0);
+            return *this;
+        }
+
+        // the pitch an Image of this width gets: the packed row rounded up to image_row_alignment
+        [[nodiscard]] static constexpr std::size_t aligned_row_pitch(std::size_t width) noexcept{
+            const std::size_t packed = width * sizeof(Pixel);
+            return (packed + image_row_alignment - 1) / image_row_alignment * image_row_alignment;
+        }
+
+        [[nodiscard]] ImageView<Pixel> view() noexcept{
+            return ImageView<Pixel>(reinterpret_cast<Pixel*>(bytes_.get()), width_, height_, static_cast<std::ptrdiff_t>(row_pitch_));
+        }
+        [[nodiscard]] ImageView<const Pixel> view() const noexcept{
+            return ImageView<const Pixel>(reinterpret_cast<const Pixel*>(bytes_.get()), width_, height_, static_cast<std::ptrdiff_t>(row_pitch_));
+        }
+        operator ImageView<Pixel>() noexcept{ return view(); }
+        operator ImageView<const Pixel>() const noexcept{ return view(); }
+
+        [[nodiscard]] std::size_t width() const noexcept{ return width_; }
+        [[nodiscard]] std::size_t height() const noexcept{ return height_; }
+        [[nodiscard]] std::size_t size() const noexcept{ return width_ * height_; }
+        [[nodiscard]] bool empty() const noexcept{ return width_ == 0 || height_ == 0; }
+        [[nodiscard]] std::size_t row_pitch() const noexcept{ return row_pitch_; }
+
+        [[nodiscard]] Pixel* data() noexcept{ return reinterpret_cast<Pixel*>(bytes_.get()); }
+        [[nodiscard]] const Pixel* data() const noexcept{ return reinterpret_cast<const Pixel*>(bytes_.get()); }
+
+        [[nodiscard]] std::span<Pixel> row(std::size_t y) noexcept{ return view().row(y); }
+        [[nodiscard]] std::span<const Pixel> row(std::size_t y) const noexcept{ return view().row(y); }
+
+        [[nodiscard]] Pixel& operator()(std::size_t x, std::size_t y) noexcept{ return view()(x, y); }
+        [[nodiscard]] const Pixel& operator()(std::size_t x, std::size_t y) const noexcept{ return view()(x, y); }
+
+        [[nodiscard]] ImageView<Pixel> subview(std::size_t x, std::size_t y, std::size_t w, std::size_t h) noexcept{
+            return view().subview(x, y, w, h);
+        }
+        [[nodiscard]] ImageView<const Pixel> subview(std::size_t x, std::size_t y, std::size_t w, std::size_t h) const noexcept{
+            return view().subview(x, y, w, h);
+        }
+
+        void fill(const Pixel& value) noexcept{
+            view().fill(value);
+        }
+    };
+
+}
@@ -5,6 +5,7 @@
 #include <cmath>
 #include <algorithm>
 #include <cstring>
+#include <limits>
 #include "ContainerN.hpp"
 #include "ArithmeticOpsMixin.hpp"
 #include "VectorN.hpp"
@@ -50,6 +51,10 @@ namespace ES{
         static constexpr void can_negate(){return;}
         static constexpr void can_clamp(){return;}
 
+        // caps on the iterations in sqrt and on the square roots log takes, neither gets close on sane input
+        static constexpr std::size_t max_root_iterations = 32;
+        static constexpr std::size_t max_log_roots = 32;
+
 
         template<class... Args>
         constexpr Matrix(Args... columns) requires(sizeof...(Args) == M && (std::is_same_v<Args, VectorN<T,N>> && ...)){
@@ -583,6 +588,158 @@ namespace ES{
             return temp;
         }
         
+        // maximum absolute column sum, the cheap norm exp and log size their steps by
+        [[nodiscard]] constexpr T norm1() const noexcept{
+            T largest{0};
+            for(std::size_t col = 0; col<M; col++){
+                T sum{0};
+                for(std::size_t row = 0; row<N; row++){
+                    sum += std::abs((*this)(row,col));
+                }
+                largest = std::max(largest, sum);
+            }
+            return largest;
+        }
+
+        /**
+         * @brief e^A, by scaling and squaring with a [6/6] Pade approximant.
+         *
+         * Halves A until its 1-norm is at most 1/2, where the Pade error is already below double precision, solves
+         * Q^-1 P there and squares the result back up once per halving. Costs about 6 + halvings matrix products and
+         * one inverse. For the rotation generated by a vector, exp_rotation is the closed form and far cheaper.
+         */
+        [[nodiscard]] constexpr Matrix exp() const noexcept requires(N==M && std::is_floating_point_v<T>){
+            std::size_t halvings = 0;
+            T scale{1};
+            for(T norm = norm1(); norm > T{0.5}; norm *= T{0.5}){
+                scale *= T{0.5};
+                halvings++;
+            }
+            const Matrix A = (*this) * scale;
+            const Matrix I = identity();
+            const Matrix A2 = A * A;
+            const Matrix A4 = A2 * A2;
+            const Matrix A6 = A4 * A2;
+            //c_k = (12 - k)! 6! / (12! k! (6 - k)!)
+            const Matrix even = I + A2 * T(5.0L/44.0L) + A4 * T(1.0L/792.0L) + A6 * T(1.0L/665280.0L);
+            const Matrix odd = A * (I * T(0.5L) + A2 * T(1.0L/66.0L) + A4 * T(1.0L/15840.0L));
+            Matrix result = (even - odd).inverse() * (even + odd);
+            for(std::size_t i = 0; i<halvings; i++){
+                result = result * result;
+            }
+            return result;
+        }
+
+        /**
+         * @brief The principal square root, by the Denman-Beavers iteration.
+         * @note Only exists for matrices without eigenvalues on the closed negative real axis.
+         */
+        [[nodiscard]] constexpr Matrix sqrt() const noexcept requires(N==M && std::is_floating_point_v<T>){
+            Matrix y = (*this);
+            Matrix z = identity();
+            for(std::size_t i = 0; i<max_root_iterations; i++){
+                const Matrix next_y = (y + z.inverse()) * T{0.5};
+                z = (z + y.inverse()) * T{0.5};
+                const bool converged = (next_y - y).norm1() <= T{4} * std::numeric_limits<T>::epsilon() * next_y.norm1();
+                y = next_y;
+                if(converged){
+                    break;
+                }
+            }
+            return y;
+        }
+
+        /**
+         * @brief The principal logarithm, by inverse scaling and squaring.
+         *
+         * Takes square roots until A is within 1/4 of the identity, sums log(A) = 2 artanh((A - I)(A + I)^-1) there
+         * (every term of which is ~6 bits smaller than the last) and doubles the result back once per root. The
+         * inverse of exp for matrices whose eigenvalues have imaginary parts in (-pi, pi). For rotations
+         * log_rotation is the closed form.
+         * @note Only exists for matrices without eigenvalues on the closed negative real axis, so no mirroring.
+         */
+        [[nodiscard]] constexpr Matrix log() const noexcept requires(N==M && std::is_floating_point_v<T>){
+            const Matrix I = identity();
+            Matrix root = (*this);
+            T scale{1};
+            for(std::size_t i = 0; i<max_log_roots && (root - I).norm1() > T{0.25}; i++){
+                root = root.sqrt();
+                scale *= T{2};
+            }
+            const Matrix z = (root - I) * (root + I).inverse();
+            const Matrix z2 = z * z;
+            constexpr std::size_t terms = sizeof(T) > 4 ? 10 : 5;
+            Matrix power = z;
+            Matrix sum = z;
+            for(std::size_t k = 1; k<terms; k++){
+                power = power * z2;
+                sum += power * (T{1} / static_cast<T>(2*k + 1));
+            }
+            return sum * (T{2} * scale);
+        }
+
+        // [v]x, the matrix for v.cross(...)
+        [[nodiscard]] static constexpr Matrix skew(const VectorN<T,3>& v) noexcept requires(N==3 && M==3){
+            Matrix temp;
+            temp(0,0) = T{0};  temp(0,1) = -v[2]; temp(0,2) = v[1];
+            temp(1,0) = v[2];  temp(1,1) = T{0};  temp(1,2) = -v[0];
+            temp(2,0) = -v[1]; temp(2,1) = v[0];  temp(2,2) = T{0};
+            return temp;
+        }
+
+        // exp(skew(omega)) in closed form (Rodrigues): the rotation by |omega| radians about omega
+        [[nodiscard]] static /* constexpr in c++26*/ Matrix exp_rotation(const VectorN<T,3>& omega) noexcept requires(N==3 && M==3 && std::is_floating_point_v<T>){
+            const T angle_squared = omega.dot(omega);
+            const T angle = std::sqrt(angle_squared);
+            //the Taylor series below the cutoff, where the closed forms lose their digits to cancellation
+            T a, b;
+            if(angle < T{1e-4}){
+                a = T{1} - angle_squared / T{6};
+                b = T{0.5} - angle_squared / T{24};
+            }
+            else{
+                a = std::sin(angle) / angle;
+                b = (T{1} - std::cos(angle)) / angle_squared;
+            }
+            const Matrix k = skew(omega);
+            return identity() + k * a + (k * k) * b;
+        }
+
+        /**
+         * @brief The rotation vector of a proper rotation, so exp_rotation(r.log_rotation()) == r.
+         *
+         * The angle comes out in [0, pi]. Past a right angle the axis is read off the diagonal rather than the skew
+         * part, which vanishes as the angle nears pi.
+         */
+        [[nodiscard]] /* constexpr in c++26*/ VectorN<T,3> log_rotation() const noexcept requires(N==3 && M==3 && std::is_floating_point_v<T>){
+            const Matrix& r = (*this);
+            const T cosine = std::clamp((trace() - T{1}) * T{0.5}, T{-1}, T{1});
+            const T angle = std::acos(cosine);
+            const VectorN<T,3> vee(r(2,1) - r(1,2), r(0,2) - r(2,0), r(1,0) - r(0,1)); //2 sin(angle) axis
+            if(angle < T{1e-4}){
+                return vee * (T{0.5} + angle * angle / T{12});
+            }
+            if(cosine > T{0}){
+                return vee * (angle / (T{2} * std::sin(angle)));
+            }
+            //r = cos I + sin [n]x + (1 - cos) n n^T: the diagonal gives each n_i^2, the symmetric part the products
+            const T one_minus_cos = T{1} - cosine;
+            std::size_t i = 0;
+            if(r(1,1) > r(i,i)) i = 1;
+            if(r(2,2) > r(i,i)) i = 2;
+            VectorN<T,3> axis;
+            axis[i] = std::sqrt(std::max((r(i,i) - cosine) / one_minus_cos, T{0}));
+            if(vee[i] < T{0}){
+                axis[i] = -axis[i];
+            }
+            for(std::size_t j = 0; j<3; j++){
+                if(j != i){
+                    axis[j] = (r(i,j) + r(j,i)) / (T{2} * one_minus_cos * axis[i]);
+                }
+            }
+            return axis.normalize() * angle;
+        }
+
         [[nodiscard]] constexpr Matrix orthonormalize() const noexcept{
 
             std::array<VectorN<T,N>,M> temp_array;
@@ -1,7 +1,14 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <span>
+#include "ES_simd.hpp"
 #include "ContainerN.hpp"
 #include "VectorN.hpp"
+#include "Matrix.hpp"
 
 
 namespace ES{
@@ -74,11 +81,12 @@ namespace ES{
         }
         
 
+        // same (w,x,y,z) layout that vector() hands back
         constexpr Quaternion(VectorN<T,4> vec) noexcept{
-            x() = vec.x();
-            y() = vec.y();
-            z() = vec.z();
-            w() = vec.w();
+            w() = vec[0];
+            x() = vec[1];
+            y() = vec[2];
+            z() = vec[3];
         }
         
         [[nodiscard]] constexpr VectorN<T,4> vector() const noexcept{
@@ -92,7 +100,7 @@ namespace ES{
             Quaternion temp;
             temp.w() = (w()*rhs.w() - x()*rhs.x() - y()*rhs.y() - z()*rhs.z());
             temp.x() = (w()*rhs.x() + x()*rhs.w() + y()*rhs.z() - z()*rhs.y());
-            temp.y() = (w()*rhs.y() - x()*rhs.z() + y()*rhs.w() - z()*rhs.x());
+            temp.y() = (w()*rhs.y() - x()*rhs.z() + y()*rhs.w() + z()*rhs.x());
             temp.z() = (w()*rhs.z() + x()*rhs.y() - y()*rhs.x() + z()*rhs.w());
             return temp;
         }
@@ -100,7 +108,7 @@ namespace ES{
         constexpr Quaternion& operator*=(Quaternion rhs) noexcept{   
             T W = (w()*rhs.w() - x()*rhs.x() - y()*rhs.y() - z()*rhs.z());
             T X = (w()*rhs.x() + x()*rhs.w() + y()*rhs.z() - z()*rhs.y());
-            T Y = (w()*rhs.y() - x()*rhs.z() + y()*rhs.w() - z()*rhs.x());
+            T Y = (w()*rhs.y() - x()*rhs.z() + y()*rhs.w() + z()*rhs.x());
             T Z = (w()*rhs.z() + x()*rhs.y() - y()*rhs.x() + z()*rhs.w());
             w() = W;
             x() = X;
@@ -194,8 +202,7 @@ namespace ES{
                 rhs = -rhs;
             }
             Quaternion q = lerp(rhs, t); 
-            T qlen = q.length();
-            return q.normalized();
+            return q.normalize();
         }
 
         [[nodiscard]] /* constexpr in c++26*/ Quaternion slerp(Quaternion rhs, T t) const {
@@ -218,12 +225,211 @@ namespace ES{
             return (std::sin((T(1) - t) * theta) / sin_theta) * (*this) + (std::sin(t * theta) / sin_theta) * rhs;
         }
 
-       
+        // rotation vector of a unit quaternion: the axis times half the rotation angle, so exp(q.log()) == q
+        [[nodiscard]] /* constexpr in c++26*/ VectorN<T,3> log() const noexcept{
+            const T vector_length = std::sqrt(x()*x() + y()*y() + z()*z());
+            if(vector_length == T{0}){
+                return VectorN<T,3>(T{0}, T{0}, T{0});
+            }
+            const T scale = std::atan2(vector_length, w()) / vector_length;
+            return VectorN<T,3>(x()*scale, y()*scale, z()*scale);
+        }
+
+        // the unit quaternion whose log is v
+        [[nodiscard]] static /* constexpr in c++26*/ Quaternion exp(VectorN<T,3> v) noexcept{
+            const T half_angle = v.magnitude();
+            //sin(a)/a is already exact for tiny a, only a == 0 needs catching
+            const T scale = half_angle == T{0} ? T{1} : std::sin(half_angle) / half_angle;
+            return Quaternion(std::cos(half_angle), v[0]*scale, v[1]*scale, v[2]*scale);
+        }
+
+        // rotation matrix of a unit quaternion, column major like the rest of Matrix
+        [[nodiscard]] constexpr Matrix<T,3> to_matrix3() const noexcept{
+            const T xx = x()*x(), yy = y()*y(), zz = z()*z();
+            const T xy = x()*y(), xz = x()*z(), yz = y()*z();
+            const T wx = w()*x(), wy = w()*y(), wz = w()*z();
+            Matrix<T,3> temp;
+            temp(0,0) = T{1} - T{2}*(yy + zz);
+            temp(1,0) = T{2}*(xy + wz);
+            temp(2,0) = T{2}*(xz - wy);
+            temp(0,1) = T{2}*(xy - wz);
+            temp(1,1) = T{1} - T{2}*(xx + zz);
+            temp(2,1) = T{2}*(yz + wx);
+            temp(0,2) = T{2}*(xz + wy);
+            temp(1,2) = T{2}*(yz - wx);
+            temp(2,2) = T{1} - T{2}*(xx + yy);
+            return temp;
+        }
+
+        // the rotation part of a 4x4, the last row and column are never read
+        [[nodiscard]] constexpr Matrix<T,4> to_matrix4() const noexcept{
+            const Matrix<T,3> r = to_matrix3();
+            Matrix<T,4> temp;
+            for(std::size_t col = 0; col<3; col++){
+                temp(0,col) = r(0,col);
+                temp(1,col) = r(1,col);
+                temp(2,col) = r(2,col);
+                temp(3,col) = T{0};
+            }
+            temp(0,3) = T{0};
+            temp(1,3) = T{0};
+            temp(2,3) = T{0};
+            temp(3,3) = T{1};
+            return temp;
+        }
+
+        // Shepperd's method, divides by whichever of w,x,y,z is largest so we never divide by ~0
+        // expects a pure rotation, scale must already be stripped out
+        [[nodiscard]] static constexpr Quaternion from_matrix3(const Matrix<T,3>& m) noexcept{
+            Quaternion temp;
+            from_rotation_entries(m(0,0), m(0,1), m(0,2), m(1,0), m(1,1), m(1,2), m(2,0), m(2,1), m(2,2),
+                                  temp.w(), temp.x(), temp.y(), temp.z());
+            return temp;
+        }
+
+        // reads the upper left 3x3 only, so translation and projection are simply ignored
+        [[nodiscard]] static constexpr Quaternion from_matrix4(const Matrix<T,4>& m) noexcept{
+            Quaternion temp;
+            from_rotation_entries(m(0,0), m(0,1), m(0,2), m(1,0), m(1,1), m(1,2), m(2,0), m(2,1), m(2,2),
+                                  temp.w(), temp.x(), temp.y(), temp.z());
+            return temp;
+        }
+
+        /**
+         * @brief to_matrix3 over a whole batch, `simd::lanes<T>` quaternions at a time.
+         * @param out the same length as quaternions
+         */
+        static void to_matrices3(std::span<const Quaternion> quaternions, std::span<Matrix<T,3>> out) noexcept{
+            assert(quaternions.size() == out.size() && "to_matrices3 needs one output per Quaternion");
+            to_matrices(quaternions, out);
+        }
+
+        // to_matrix4 over a whole batch, for filling instance buffers
+        static void to_matrices4(std::span<const Quaternion> quaternions, std::span<Matrix<T,4>> out) noexcept{
+            assert(quaternions.size() == out.size() && "to_matrices4 needs one output per Quaternion");
+            to_matrices(quaternions, out);
+        }
+
+        /**
+         * @brief from_matrix3 over a whole batch, vectorized: the case selection is branch free so every lane runs
+         * the same instructions whichever component it ends up dividing by.
+         * @param out the same length as matrices
+         */
+        static void from_matrices3(std::span<const Matrix<T,3>> matrices, std::span<Quaternion> out) noexcept{
+            assert(matrices.size() == out.size() && "from_matrices3 needs one output per Matrix");
+            from_matrices(matrices, out);
+        }
+
+        static void from_matrices4(std::span<const Matrix<T,4>> matrices, std::span<Quaternion> out) noexcept{
+            assert(matrices.size() == out.size() && "from_matrices4 needs one output per Matrix");
+            from_matrices(matrices, out);
+        }
+
         [[nodiscard]] static constexpr Quaternion identity() noexcept{
             Quaternion temp(T{1},T{0},T{0},T{0});
             return temp;
         }
-        
+
+    private:
+        //Shepperd without the branches: the largest of 4w^2, 4x^2, 4y^2, 4z^2 is picked with selects, its component
+        //comes off the diagonal and the other three from sums and differences of the off diagonal pairs. Every case
+        //is computed and the right one selected, which costs a few adds and buys a loop body the vectorizer accepts
+        static constexpr void from_rotation_entries(T m00, T m01, T m02, T m10, T m11, T m12, T m20, T m21, T m22,
+                                                                  T& w, T& x, T& y, T& z) noexcept{
+            const T tw = T{1} + m00 + m11 + m22;
+            const T tx = T{1} + m00 - m11 - m22;
+            const T ty = T{1} - m00 + m11 - m22;
+            const T tz = T{1} - m00 - m11 + m22;
+            const bool is_w = (tw >= tx) & (tw >= ty) & (tw >= tz);
+            const bool is_x = !is_w & (tx >= ty) & (tx >= tz);
+            const bool is_y = !is_w & !is_x & (ty >= tz);
+            const auto pick = [is_w, is_x, is_y](T if_w, T if_x, T if_y, T if_z){
+                return simd::select(is_w, if_w, simd::select(is_x, if_x, simd::select(is_y, if_y, if_z)));
+            };
+            //the largest is at least 1 for a rotation, comfortably inside what inverse_sqrt takes, and unlike std::sqrt
+            //it does not stop the batch loop vectorizing
+            const T largest = pick(tw, tx, ty, tz);
+            const T scale = T{0.5} * simd::inverse_sqrt(largest);
+            const T dx = m21 - m12, dy = m02 - m20, dz = m10 - m01;
+            const T sxy = m01 + m10, sxz = m02 + m20, syz = m12 + m21;
+            w = pick(largest, dx, dy, dz) * scale;
+            x = pick(dx, largest, sxy, sxz) * scale;
+            y = pick(dy, sxy, largest, syz) * scale;
+            z = pick(dz, sxz, syz, largest) * scale;
+        }
+
+        template <std::size_t Size>
+        static void to_matrices(std::span<const Quaternion> quaternions, std::span<Matrix<T,Size>> out) noexcept{
+            constexpr std::size_t W = simd::lanes<T>;
+            alignas(simd::register_bytes) std::array<T,W> qw, qx, qy, qz;
+            alignas(simd::register_bytes) std::array<std::array<T,W>,9> r; //column major, like Matrix
+            for(std::size_t base = 0; base<quaternions.size(); base += W){
+                const std::size_t n = std::min(W, quaternions.size() - base);
+                for(std::size_t lane = 0; lane<W; lane++){
+                    const Quaternion& q = lane < n ? quaternions[base + lane] : quaternions[base];
+                    qw[lane] = q.w(); qx[lane] = q.x(); qy[lane] = q.y(); qz[lane] = q.z();
+                }
+
+                ES_VECTORIZE
+                for(std::size_t lane = 0; lane<W; lane++){
+                    const T xx = qx[lane]*qx[lane], yy = qy[lane]*qy[lane], zz = qz[lane]*qz[lane];
+                    const T xy = qx[lane]*qy[lane], xz = qx[lane]*qz[lane], yz = qy[lane]*qz[lane];
+                    const T wx = qw[lane]*qx[lane], wy = qw[lane]*qy[lane], wz = qw[lane]*qz[lane];
+                    r[0][lane] = T{1} - T{2}*(yy + zz);
+                    r[1][lane] = T{2}*(xy + wz);
+                    r[2][lane] = T{2}*(xz - wy);
+                    r[3][lane] = T{2}*(xy - wz);
+                    r[4][lane] = T{1} - T{2}*(xx + zz);
+                    r[5][lane] = T{2}*(yz + wx);
+                    r[6][lane] = T{2}*(xz + wy);
+                    r[7][lane] = T{2}*(yz - wx);
+                    r[8][lane] = T{1} - T{2}*(xx + yy);
+                }
+
+                for(std::size_t lane = 0; lane<n; lane++){
+                    Matrix<T,Size>& m = out[base + lane];
+                    for(std::size_t col = 0; col<3; col++){
+                        m(0,col) = r[3*col][lane];
+                        m(1,col) = r[3*col + 1][lane];
+                        m(2,col) = r[3*col + 2][lane];
+                    }
+                    if constexpr (Size == 4){
+                        m(3,0) = T{0}; m(3,1) = T{0}; m(3,2) = T{0};
+                        m(0,3) = T{0}; m(1,3) = T{0}; m(2,3) = T{0};
+                        m(3,3) = T{1};
+                    }
+                }
+            }
+        }
+
+        template <std::size_t Size>
+        static void from_matrices(std::span<const Matrix<T,Size>> matrices, std::span<Quaternion> out) noexcept{
+            //a few registers wide, the nine strided loads per matrix need a longer vector run than to_matrices to pay off
+            constexpr std::size_t W = 8 * simd::lanes<T>;
+            alignas(simd::register_bytes) std::array<std::array<T,W>,9> m; //column major, like Matrix
+            alignas(simd::register_bytes) std::array<T,W> qw, qx, qy, qz;
+            for(std::size_t base = 0; base<matrices.size(); base += W){
+                const std::size_t n = std::min(W, matrices.size() - base);
+                for(std::size_t lane = 0; lane<W; lane++){
+                    const Matrix<T,Size>& source = lane < n ? matrices[base + lane] : matrices[base];
+                    for(std::size_t col = 0; col<3; col++){
+                        m[3*col][lane] = source(0,col);
+                        m[3*col + 1][lane] = source(1,col);
+                        m[3*col + 2][lane] = source(2,col);
+                    }
+                }
+
+                ES_VECTORIZE
+                for(std::size_t lane = 0; lane<W; lane++){
+                    from_rotation_entries(m[0][lane], m[3][lane], m[6][lane], m[1][lane], m[4][lane], m[7][lane], m[2][lane], m[5][lane], m[8][lane],
+                                          qw[lane], qx[lane], qy[lane], qz[lane]);
+                }
+
+                for(std::size_t lane = 0; lane<n; lane++){
+                    out[base + lane] = Quaternion(qw[lane], qx[lane], qy[lane], qz[lane]);
+                }
+            }
+        }
     };
 
 }
\ No newline at end of file
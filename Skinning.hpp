@@ -0,0 +1,456 @@
+#pragma once
+
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <algorithm>
+#include <span>
+#include "ES_simd.hpp"
+#include "ES_parallel.hpp"
+#include "VectorN.hpp"
+#include "Matrix.hpp"
+#include "AffineTransform3.hpp"
+#include "DualQuaternion.hpp"
+
+
+namespace ES::skinning{
+
+    /// How many bones may pull on a single vertex. Four is what every exporter and GPU path agrees on.
+    inline constexpr std::size_t max_influences = 4;
+
+    /**
+     * @brief Bone indices and weights for one vertex.
+     *
+     * Unused slots should carry a weight of zero (their index is then never read, any in range value is fine).
+     * Weights are expected to sum to one, the dual quaternion path renormalizes anyway.
+     */
+    template <typename Index = std::uint16_t>
+    struct VertexInfluences{
+        std::array<Index, max_influences> bones{};
+        std::array<float, max_influences> weights{};
+    };
+
+    /**
+     * @brief The compact form of VertexInfluences: weights quantized to 1/255 steps, 8 or 12 bytes a vertex instead of 24.
+     *
+     * Build these with `pack`, which makes sure the quantized weights still add up to exactly 255.
+     */
+    template <typename Index = std::uint16_t>
+    struct PackedInfluences{
+        std::array<Index, max_influences> bones{};
+        std::array<std::uint8_t, max_influences> weights{};
+
+        [[nodiscard]] static constexpr PackedInfluences pack(const VertexInfluences<Index>& influences) noexcept;
+
+        [[nodiscard]] constexpr float weight(std::size_t k) const noexcept{
+            return weights[k] * (1.0f / 255.0f);
+        }
+    };
+
+    /**
+     * @brief A bone transform trimmed down to the 3x4 that actually matters, stored row by row.
+     *
+     * Twelve contiguous scalars rather than the sixteen of a Matrix<T,4> (or the Matrix<T,3> + VectorN<T,3> of an
+     * AffineTransform3), so a palette is dense and a weighted sum of bones is just twelve multiply adds.
+     */
+    template <typename T>
+    struct BoneMatrix{
+        std::array<T,12> rows{T{1},T{0},T{0},T{0},
+                              T{0},T{1},T{0},T{0},
+                              T{0},T{0},T{1},T{0}};
+
+        [[nodiscard]] static constexpr BoneMatrix from_affine(const AffineTransform3<T>& affine) noexcept{
+            BoneMatrix temp;
+            const Matrix<T,3>& linear = affine.get_linear();
+            const VectorN<T,3> translation = affine.get_translation();
+            for(std::size_t r = 0; r<3; r++){
+                temp.rows[r*4 + 0] = linear(r,0);
+                temp.rows[r*4 + 1] = linear(r,1);
+                temp.rows[r*4 + 2] = linear(r,2);
+                temp.rows[r*4 + 3] = translation[r];
+            }
+            return temp;
+        }
+
+        [[nodiscard]] constexpr AffineTransform3<T> to_affine() const noexcept{
+            Matrix<T,3> linear;
+            for(std::size_t r = 0; r<3; r++){
+                for(std::size_t c = 0; c<3; c++){
+                    linear(r,c) = rows[r*4 + c];
+                }
+            }
+            return AffineTransform3<T>(linear, VectorN<T,3>(rows[3], rows[7], rows[11]));
+        }
+
+        [[nodiscard]] constexpr VectorN<T,3> transform_point(const VectorN<T,3>& p) const noexcept{
+            return VectorN<T,3>(rows[0]*p[0] + rows[1]*p[1] + rows[2]*p[2] + rows[3],
+                                rows[4]*p[0] + rows[5]*p[1] + rows[6]*p[2] + rows[7],
+                                rows[8]*p[0] + rows[9]*p[1] + rows[10]*p[2] + rows[11]);
+        }
+    };
+
+    /// Vertices handed to a single pool job. Big enough to amortize the hand off, small enough to balance.
+    inline constexpr std::size_t default_grain = 2048;
+
+    /**
+     * @brief Deforms a vertex buffer with dual quaternion linear blending, across the thread pool.
+     *
+     * Each vertex blends up to four entries of the palette, renormalizes the blend and transforms its position
+     * (and normal, if given) by it. Vertices are processed `simd::lanes<T>` at a time in structure-of-arrays scratch,
+     * so the blend, normalization and transform all vectorize; only the palette gather stays scalar.
+     *
+     * @param palette one dual quaternion per bone, already multiplied by the inverse bind pose
+     * @param influences one entry per vertex
+     * @param positions rest pose positions
+     * @param out_positions where the skinned positions go, same size as positions. May not alias positions
+     * @param normals rest pose normals, or empty to skip them
+     * @param out_normals skinned normals, must be sized like normals (empty when normals is)
+     * @param pool the pool to spread the work across
+     */
+    template <typename T, typename Index>
+    void skin_dual_quaternion(std::span<const DualQuaternion<T>> palette,
+                              std::span<const VertexInfluences<Index>> influences,
+                              std::span<const VectorN<T,3>> positions,
+                              std::span<VectorN<T,3>> out_positions,
+                              std::span<const VectorN<T,3>> normals = {},
+                              std::span<VectorN<T,3>> out_normals = {},
+                              parallel::ThreadPool& pool = parallel::default_pool());
+
+    /** @overload */
+    template <typename T, typename Index>
+    void skin_dual_quaternion(std::span<const DualQuaternion<T>> palette,
+                              std::span<const PackedInfluences<Index>> influences,
+                              std::span<const VectorN<T,3>> positions,
+                              std::span<VectorN<T,3>> out_positions,
+                              std::span<const VectorN<T,3>> normals = {},
+                              std::span<VectorN<T,3>> out_normals = {},
+                              parallel::ThreadPool& pool = parallel::default_pool());
+
+    /**
+     * @brief Deforms a vertex buffer with linear blend skinning, across the thread pool.
+     *
+     * Per vertex the (up to) four bone matrices are blended into one 3x4 and that single matrix transforms both
+     * the position and the normal in the same pass. Like the dual quaternion path this runs `simd::lanes<T>`
+     * vertices at a time out of structure-of-arrays scratch.
+     *
+     * @param palette one 3x4 per bone, already multiplied by the inverse bind pose
+     * @param influences one entry per vertex, packed or not
+     * @param positions rest pose positions
+     * @param out_positions where the skinned positions go, same size as positions. May not alias positions
+     * @param normals rest pose normals, or empty to skip them
+     * @param out_normals skinned normals, renormalized. Must be sized like normals (empty when normals is)
+     * @param pool the pool to spread the work across
+     * @note Normals go through the blended linear part as is, which is only exact without non-uniform scale.
+     *       That is the usual trade for skinning, the alternative is an inverse transpose per vertex.
+     */
+    template <typename T, typename Index>
+    void skin_linear(std::span<const BoneMatrix<T>> palette,
+                     std::span<const PackedInfluences<Index>> influences,
+                     std::span<const VectorN<T,3>> positions,
+                     std::span<VectorN<T,3>> out_positions,
+                     std::span<const VectorN<T,3>> normals = {},
+                     std::span<VectorN<T,3>> out_normals = {},
+                     parallel::ThreadPool& pool = parallel::default_pool());
+
+    /** @overload */
+    template <typename T, typename Index>
+    void skin_linear(std::span<const BoneMatrix<T>> palette,
+                     std::span<const VertexInfluences<Index>> influences,
+                     std::span<const VectorN<T,3>> positions,
+                     std::span<VectorN<T,3>> out_positions,
+                     std::span<const VectorN<T,3>> normals = {},
+                     std::span<VectorN<T,3>> out_normals = {},
+                     parallel::ThreadPool& pool = parallel::default_pool());
+
+}
+
+namespace ES::skinning::Secret{
+
+    template <typename Index>
+    [[nodiscard]] constexpr float weight_of(const VertexInfluences<Index>& influences, std::size_t k) noexcept{
+        return influences.weights[k];
+    }
+
+    template <typename Index>
+    [[nodiscard]] constexpr float weight_of(const PackedInfluences<Index>& influences, std::size_t k) noexcept{
+        return influences.weight(k);
+    }
+
+    //one lane batch of the dual quaternion kernel, the first count (<= W) vertices behind the pointers
+    template <typename T, typename Influence, std::size_t W = simd::lanes<T>>
+    void dual_quaternion_batch(std::span<const DualQuaternion<T>> palette,
+                               const Influence* ES_RESTRICT influences,
+                               const VectorN<T,3>* ES_RESTRICT positions,
+                               VectorN<T,3>* ES_RESTRICT out_positions,
+                               const VectorN<T,3>* ES_RESTRICT normals,
+                               VectorN<T,3>* ES_RESTRICT out_normals,
+                               const std::size_t count) noexcept{
+        //blended real (rw..rz) and dual (dw..dz) parts, one lane per vertex
+        alignas(simd::register_bytes) std::array<T,W> rw{}, rx{}, ry{}, rz{}, dw{}, dx{}, dy{}, dz{};
+        //the influence being folded in this round, gathered out of the palette
+        alignas(simd::register_bytes) std::array<T,W> gw, gx, gy, gz, hw, hx, hy, hz, weight;
+        //real part of the first influence, the hemisphere everybody else gets flipped into
+        alignas(simd::register_bytes) std::array<T,W> qw, qx, qy, qz;
+
+        for(std::size_t k = 0; k<max_influences; k++){
+            for(std::size_t lane = 0; lane<W; lane++){
+                if(lane < count){
+                    const Influence& inf = influences[lane];
+                    const float w = weight_of(inf, k);
+                    assert(w == 0.0f || inf.bones[k] < palette.size());
+                    const DualQuaternion<T>& dq = w != 0.0f ? palette[inf.bones[k]] : palette[0];
+                    gw[lane] = dq.real().w(); gx[lane] = dq.real().x(); gy[lane] = dq.real().y(); gz[lane] = dq.real().z();
+                    hw[lane] = dq.dual().w(); hx[lane] = dq.dual().x(); hy[lane] = dq.dual().y(); hz[lane] = dq.dual().z();
+                    weight[lane] = static_cast<T>(w);
+                }
+                else{ //padding lanes blend the identity so the normalize below never sees a zero
+                    gw[lane] = T{1}; gx[lane] = gy[lane] = gz[lane] = T{0};
+                    hw[lane] = hx[lane] = hy[lane] = hz[lane] = T{0};
+                    weight[lane] = k == 0 ? T{1} : T{0};
+                }
+            }
+
+            if(k == 0){
+                qw = gw; qx = gx; qy = gy; qz = gz;
+            }
+
+            //antipodality: every influence joins the hemisphere of the first one, else the blend takes the long way round
+            ES_VECTORIZE
+            for(std::size_t lane = 0; lane<W; lane++){
+                T hemisphere = qw[lane]*gw[lane] + qx[lane]*gx[lane] + qy[lane]*gy[lane] + qz[lane]*gz[lane];
+                T w = hemisphere < T{0} ? -weight[lane] : weight[lane];
+                rw[lane] += gw[lane]*w; rx[lane] += gx[lane]*w; ry[lane] += gy[lane]*w; rz[lane] += gz[lane]*w;
+                dw[lane] += hw[lane]*w; dx[lane] += hx[lane]*w; dy[lane] += hy[lane]*w; dz[lane] += hz[lane]*w;
+            }
+        }
+
+        alignas(simd::register_bytes) std::array<T,W> px, py, pz;
+        for(std::size_t lane = 0; lane<W; lane++){
+            const VectorN<T,3> p = lane < count ? positions[lane] : VectorN<T,3>(T{0},T{0},T{0});
+            px[lane] = p[0]; py[lane] = p[1]; pz[lane] = p[2];
+        }
+
+        //normalize the blend, then p' = p + 2r x (r x p + w p) + 2(w d - dw r + r x d) with r, d the vector parts
+        ES_VECTORIZE
+        for(std::size_t lane = 0; lane<W; lane++){
+            T inv_len = T{1} / std::sqrt(rw[lane]*rw[lane] + rx[lane]*rx[lane] + ry[lane]*ry[lane] + rz[lane]*rz[lane]);
+            rw[lane] *= inv_len; rx[lane] *= inv_len; ry[lane] *= inv_len; rz[lane] *= inv_len;
+            dw[lane] *= inv_len; dx[lane] *= inv_len; dy[lane] *= inv_len; dz[lane] *= inv_len;
+
+            T cx = ry[lane]*pz[lane] - rz[lane]*py[lane] + rw[lane]*px[lane];
+            T cy = rz[lane]*px[lane] - rx[lane]*pz[lane] + rw[lane]*py[lane];
+            T cz = rx[lane]*py[lane] - ry[lane]*px[lane] + rw[lane]*pz[lane];
+            T tx = rw[lane]*dx[lane] - dw[lane]*rx[lane] + ry[lane]*dz[lane] - rz[lane]*dy[lane];
+            T ty = rw[lane]*dy[lane] - dw[lane]*ry[lane] + rz[lane]*dx[lane] - rx[lane]*dz[lane];
+            T tz = rw[lane]*dz[lane] - dw[lane]*rz[lane] + rx[lane]*dy[lane] - ry[lane]*dx[lane];
+            px[lane] += T{2}*(ry[lane]*cz - rz[lane]*cy + tx);
+            py[lane] += T{2}*(rz[lane]*cx - rx[lane]*cz + ty);
+            pz[lane] += T{2}*(rx[lane]*cy - ry[lane]*cx + tz);
+        }
+        for(std::size_t lane = 0; lane<count; lane++){
+            out_positions[lane] = VectorN<T,3>(px[lane], py[lane], pz[lane]);
+        }
+
+        if(normals == nullptr){
+            return;
+        }
+        //same scratch, normals only rotate
+        for(std::size_t lane = 0; lane<W; lane++){
+            const VectorN<T,3> n = lane < count ? normals[lane] : VectorN<T,3>(T{0},T{0},T{0});
+            px[lane] = n[0]; py[lane] = n[1]; pz[lane] = n[2];
+        }
+        ES_VECTORIZE
+        for(std::size_t lane = 0; lane<W; lane++){
+            T cx = ry[lane]*pz[lane] - rz[lane]*py[lane] + rw[lane]*px[lane];
+            T cy = rz[lane]*px[lane] - rx[lane]*pz[lane] + rw[lane]*py[lane];
+            T cz = rx[lane]*py[lane] - ry[lane]*px[lane] + rw[lane]*pz[lane];
+            px[lane] += T{2}*(ry[lane]*cz - rz[lane]*cy);
+            py[lane] += T{2}*(rz[lane]*cx - rx[lane]*cz);
+            pz[lane] += T{2}*(rx[lane]*cy - ry[lane]*cx);
+        }
+        for(std::size_t lane = 0; lane<count; lane++){
+            out_normals[lane] = VectorN<T,3>(px[lane], py[lane], pz[lane]);
+        }
+    }
+
+    //one lane batch of the linear blend kernel, same contract as dual_quaternion_batch
+    template <typename T, typename Influence, std::size_t W = simd::lanes<T>>
+    void linear_batch(std::span<const BoneMatrix<T>> palette,
+                      const Influence* ES_RESTRICT influences,
+                      const VectorN<T,3>* ES_RESTRICT positions,
+                      VectorN<T,3>* ES_RESTRICT out_positions,
+                      const VectorN<T,3>* ES_RESTRICT normals,
+                      VectorN<T,3>* ES_RESTRICT out_normals,
+                      const std::size_t count) noexcept{
+        //blended 3x4 per lane, element e of lane l lives at blended[e][l]
+        alignas(simd::register_bytes) std::array<std::array<T,W>,12> blended{};
+        alignas(simd::register_bytes) std::array<std::array<T,W>,12> bone;
+        alignas(simd::register_bytes) std::array<T,W> weight;
+
+        for(std::size_t k = 0; k<max_influences; k++){
+            for(std::size_t lane = 0; lane<W; lane++){
+                const BoneMatrix<T>* m = &palette[0];
+                T w = T{0};
+                if(lane < count){
+                    const Influence& inf = influences[lane];
+                    w = static_cast<T>(weight_of(inf, k));
+                    assert(w == T{0} || inf.bones[k] < palette.size());
+                    if(w != T{0}) m = &palette[inf.bones[k]];
+                }
+                for(std::size_t e = 0; e<12; e++){
+                    bone[e][lane] = m->rows[e];
+                }
+                weight[lane] = w;
+            }
+            for(std::size_t e = 0; e<12; e++){
+                ES_VECTORIZE
+                for(std::size_t lane = 0; lane<W; lane++){
+                    blended[e][lane] += bone[e][lane] * weight[lane];
+                }
+            }
+        }
+
+        alignas(simd::register_bytes) std::array<T,W> px, py, pz, nx, ny, nz;
+        for(std::size_t lane = 0; lane<W; lane++){
+            const VectorN<T,3> p = lane < count ? positions[lane] : VectorN<T,3>(T{0},T{0},T{0});
+            const VectorN<T,3> n = (normals != nullptr && lane < count) ? normals[lane] : VectorN<T,3>(T{0},T{0},T{1});
+            px[lane] = p[0]; py[lane] = p[1]; pz[lane] = p[2];
+            nx[lane] = n[0]; ny[lane] = n[1]; nz[lane] = n[2];
+        }
+
+        //positions and normals off the one blended matrix, the normal pass is nearly free next to the blend
+        ES_VECTORIZE
+        for(std::size_t lane = 0; lane<W; lane++){
+            const T x = px[lane], y = py[lane], z = pz[lane];
+            px[lane] = blended[0][lane]*x + blended[1][lane]*y + blended[2][lane]*z + blended[3][lane];
+            py[lane] = blended[4][lane]*x + blended[5][lane]*y + blended[6][lane]*z + blended[7][lane];
+            pz[lane] = blended[8][lane]*x + blended[9][lane]*y + blended[10][lane]*z + blended[11][lane];
+
+            const T a = nx[lane], b = ny[lane], c = nz[lane];
+            T tx = blended[0][lane]*a + blended[1][lane]*b + blended[2][lane]*c;
+            T ty = blended[4][lane]*a + blended[5][lane]*b + blended[6][lane]*c;
+            T tz = blended[8][lane]*a + blended[9][lane]*b + blended[10][lane]*c;
+            T len_squared = tx*tx + ty*ty + tz*tz;
+            T inv_len = simd::select(len_squared > T{0}, simd::inverse_sqrt(len_squared), T{0});
+            nx[lane] = tx*inv_len; ny[lane] = ty*inv_len; nz[lane] = tz*inv_len;
+        }
+
+        for(std::size_t lane = 0; lane<count; lane++){
+            out_positions[lane] = VectorN<T,3>(px[lane], py[lane], pz[lane]);
+        }
+        if(normals == nullptr){
+            return;
+        }
+        for(std::size_t lane = 0; lane<count; lane++){
+            out_normals[lane] = VectorN<T,3>(nx[lane], ny[lane], nz[lane]);
+        }
+    }
+
+    //chops the buffers into pool chunks and the chunks into lane batches, shared by every skinning entry point
+    template <typename T, typename Influence, typename Palette, typename Batch>
+    void skin_chunked(Palette palette,
+                      std::span<const Influence> influences,
+                      std::span<const VectorN<T,3>> positions,
+                      std::span<VectorN<T,3>> out_positions,
+                      std::span<const VectorN<T,3>> normals,
+                      std::span<VectorN<T,3>> out_normals,
+                      parallel::ThreadPool& pool,
+                      Batch batch){
+        assert(influences.size() == positions.size() && "one set of influences per vertex");
+        assert(out_positions.size() >= positions.size() && "output buffer too small for the positions");
+        assert((normals.empty() || normals.size() == positions.size()) && "normals must match the positions");
+        assert(out_normals.size() >= normals.size() && "output buffer too small for the normals");
+        assert(!palette.empty() && "cannot skin against an empty palette");
+
+        constexpr std::size_t W = simd::lanes<T>;
+        const bool has_normals = !normals.empty();
+
+        parallel::for_chunks(positions.size(), default_grain, [&](const std::size_t begin, const std::size_t end){
+            for(std::size_t i = begin; i<end; i += W){
+                const std::size_t count = std::min(W, end - i);
+                batch(palette, influences.data() + i, positions.data() + i, out_positions.data() + i,
+                      has_normals ? normals.data() + i : nullptr,
+                      has_normals ? out_normals.data() + i : nullptr, count);
+            }
+        }, pool);
+    }
+}
+
+template <typename Index>
+constexpr ES::skinning::PackedInfluences<Index> ES::skinning::PackedInfluences<Index>::pack(const VertexInfluences<Index>& influences) noexcept{
+    PackedInfluences temp;
+    temp.bones = influences.bones;
+
+    float total = 0.0f;
+    for(float w : influences.weights){
+        total += w;
+    }
+    if(total <= 0.0f){
+        temp.weights = {255, 0, 0, 0};
+        return temp;
+    }
+
+    //round each one, then hand whatever rounding gained or lost to the heaviest weight so the sum is exactly 255
+    int sum = 0;
+    std::size_t heaviest = 0;
+    for(std::size_t k = 0; k<max_influences; k++){
+        int q = static_cast<int>(influences.weights[k] / total * 255.0f + 0.5f);
+        q = std::clamp(q, 0, 255);
+        temp.weights[k] = static_cast<std::uint8_t>(q);
+        sum += q;
+        if(influences.weights[k] > influences.weights[heaviest]){
+            heaviest = k;
+        }
+    }
+    temp.weights[heaviest] = static_cast<std::uint8_t>(temp.weights[heaviest] + (255 - sum));
+    return temp;
+}
+
+template <typename T, typename Index>
+void ES::skinning::skin_dual_quaternion(std::span<const DualQuaternion<T>> palette,
+                                        std::span<const VertexInfluences<Index>> influences,
+                                        std::span<const VectorN<T,3>> positions,
+                                        std::span<VectorN<T,3>> out_positions,
+                                        std::span<const VectorN<T,3>> normals,
+                                        std::span<VectorN<T,3>> out_normals,
+                                        parallel::ThreadPool& pool){
+    Secret::skin_chunked<T>(palette, influences, positions, out_positions, normals, out_normals, pool,
+                            [](auto&&... args){ Secret::dual_quaternion_batch<T, VertexInfluences<Index>>(args...); });
+}
+
+template <typename T, typename Index>
+void ES::skinning::skin_dual_quaternion(std::span<const DualQuaternion<T>> palette,
+                                        std::span<const PackedInfluences<Index>> influences,
+                                        std::span<const VectorN<T,3>> positions,
+                                        std::span<VectorN<T,3>> out_positions,
+                                        std::span<const VectorN<T,3>> normals,
+                                        std::span<VectorN<T,3>> out_normals,
+                                        parallel::ThreadPool& pool){
+    Secret::skin_chunked<T>(palette, influences, positions, out_positions, normals, out_normals, pool,
+                            [](auto&&... args){ Secret::dual_quaternion_batch<T, PackedInfluences<Index>>(args...); });
+}
+
+template <typename T, typename Index>
+void ES::skinning::skin_linear(std::span<const BoneMatrix<T>> palette,
+                               std::span<const PackedInfluences<Index>> influences,
+                               std::span<const VectorN<T,3>> positions,
+                               std::span<VectorN<T,3>> out_positions,
+                               std::span<const VectorN<T,3>> normals,
+                               std::span<VectorN<T,3>> out_normals,
+                               parallel::ThreadPool& pool){
+    Secret::skin_chunked<T>(palette, influences, positions, out_positions, normals, out_normals, pool,
+                            [](auto&&... args){ Secret::linear_batch<T, PackedInfluences<Index>>(args...); });
+}
+
+template <typename T, typename Index>
+void ES::skinning::skin_linear(std::span<const BoneMatrix<T>> palette,
+                               std::span<const VertexInfluences<Index>> influences,
+                               std::span<const VectorN<T,3>> positions,
+                               std::span<VectorN<T,3>> out_positions,
+                               std::span<const VectorN<T,3>> normals,
+                               std::span<VectorN<T,3>> out_normals,
+                               parallel::ThreadPool& pool){
+    Secret::skin_chunked<T>(palette, influences, positions, out_positions, normals, out_normals, pool,
+                            [](auto&&... args){ Secret::linear_batch<T, VertexInfluences<Index>>(args...); });
+}
@@ -0,0 +1,335 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "ES_mip.hpp"
+#include "ES_parallel.hpp"
+#include "ES_simd.hpp"
+#include "ES_srgb.hpp"
+#include "ColorN.hpp"
+#include "Image.hpp"
+#include "VectorN.hpp"
+
+
+namespace ES{
+
+    /**
+     * @brief How a Texture keeps its texels.
+     *
+     * rows is the Image order. tiles cuts each level into square tiles of Texture::tile_edge texels (8x8 for texels of
+     * up to 4 bytes, 4x4 for bigger ones: 256 bytes for RGBA8 and float RGBA, 192 for RGB8 and float RGB), tiles in
+     * row order and the texels inside a tile in Z (Morton) order. A bilinear footprint then nearly always sits in one or two cache lines whichever way the UVs run, where
+     * with rows a rotated or minified walk touches a new line on almost every fetch.
+     */
+    enum class TextureLayout{ rows, tiles };
+
+    /// What a coordinate outside [0, 1) reads: the texture repeated, its edge texels, or the texture repeated mirrored.
+    enum class AddressMode{ wrap, clamp, mirror };
+
+    /**
+     * @brief point reads the nearest texel, bilinear blends the 4 nearest, both from the mip level nearest the lod;
+     * trilinear blends bilinear samples from the two levels either side of it.
+     */
+    enum class TextureFilter{ point, bilinear, trilinear };
+
+    struct Sampler{
+        TextureFilter filter = TextureFilter::bilinear;
+        AddressMode address_u = AddressMode::wrap;
+        AddressMode address_v = AddressMode::wrap;
+    };
+
+    /**
+     * @brief An image, and optionally its mips, laid out for sampling.
+     *
+     * Samples come back as RGBA, linear and premultiplied like the rest of the float colour code: RGBA8 and RGB8
+     * texels are decoded from sRGB (and premultiplied) as they're fetched, so filtering happens in linear light and
+     * the texture keeps its compact size in memory. UV (0, 0) is the top left corner of the top left texel and (1, 1)
+     * the bottom right corner of the bottom right one; texel centres sit on half texels.
+     *
+     * @tparam Pixel RGBA8, RGBA, RGB8 or RGB.
+     */
+    template <typename Pixel> requires (std::is_same_v<Pixel, RGBA8> || std::is_same_v<Pixel, RGBA> || std::is_same_v<Pixel, RGB8> || std::is_same_v<Pixel, RGB>)
+    class Texture{
+    public:
+        /// Texels a side of a tile in TextureLayout::tiles.
+        static constexpr std::size_t tile_edge = sizeof(Pixel) <= 4 ? 8 : 4;
+
+    private:
+        static constexpr std::size_t tile_shift = tile_edge == 8 ? 3 : 2;
+
+        struct Level{
+            std::size_t offset;
+            std::size_t width;
+            std::size_t height;
+            std::size_t tiles_across;
+        };
+
+        struct AlignedDelete{
+            void operator()(Pixel* texels) const noexcept{
+                ::operator delete(texels, std::align_val_t{image_row_alignment});
+            }
+        };
+
+        //aligned like Image rows, so a 256 byte tile is exactly four cache lines rather than straddling five
+        std::unique_ptr<Pixel, AlignedDelete> texels_;
+        std::size_t size_ = 0;
+        std::vector<Level> levels_;
+        TextureLayout layout_ = TextureLayout::tiles;
+
+        // x's bits in the even places of the result, up to tile_edge
+        [[nodiscard]] static constexpr std::size_t spread(std::size_t v) noexcept{
+            v = (v | (v << 2)) & 0x33u;
+            return (v | (v << 1)) & 0x55u;
+        }
+
+        // a texel's index is the sum of a part from x and a part from y, so a bilinear footprint works out 4 parts, not 4 indices
+        [[nodiscard]] std::size_t column_part(std::size_t x) const noexcept{
+            if(layout_ == TextureLayout::rows){
+                return x;
+            }
+            return ((x >> tile_shift) << (2 * tile_shift)) + spread(x & (tile_edge - 1));
+        }
+
+        [[nodiscard]] std::size_t row_part(const Level& level, std::size_t y) const noexcept{
+            if(layout_ == TextureLayout::rows){
+                return level.offset + y * level.width;
+            }
+            return level.offset + (((y >> tile_shift) * level.tiles_across) << (2 * tile_shift)) + (spread(y & (tile_edge - 1)) << 1);
+        }
+
+        [[nodiscard]] std::size_t index(const Level& level, std::size_t x, std::size_t y) const noexcept{
+            return row_part(level, y) + column_part(x);
+        }
+
+        [[nodiscard]] static std::size_t address(std::ptrdiff_t i, std::size_t size, AddressMode mode) noexcept{
+            if(static_cast<std::size_t>(i) < size){
+                return static_cast<std::size_t>(i);
+            }
+            const auto n = static_cast<std::ptrdiff_t>(size);
+            switch(mode){
+                case AddressMode::wrap: {
+                    const std::ptrdiff_t r = i % n;
+                    return static_cast<std::size_t>(r < 0 ? r + n : r);
+                }
+                case AddressMode::clamp:
+                    return static_cast<std::size_t>(std::clamp<std::ptrdiff_t>(i, 0, n - 1));
+                case AddressMode::mirror: {
+                    std::ptrdiff_t r = i % (2 * n);
+                    r = r < 0 ? r + 2 * n : r;
+                    return static_cast<std::size_t>(r < n ? r : 2 * n - 1 - r);
+                }
+            }
+            return 0;
+        }
+
+        [[nodiscard]] static RGBA decode(const Pixel& p) noexcept{
+            if constexpr(std::is_same_v<Pixel, RGBA8>){
+                const float a = p.A * (1.0f / 255.0f);
+                return RGBA(srgb::to_linear(p.R) * a, srgb::to_linear(p.G) * a, srgb::to_linear(p.B) * a, a);
+            } else if constexpr(std::is_same_v<Pixel, RGB8>){
+                return RGBA(srgb::to_linear(p.R), srgb::to_linear(p.G), srgb::to_linear(p.B), 1.0f);
+            } else if constexpr(std::is_same_v<Pixel, RGB>){
+                return RGBA(p.R(), p.G(), p.B(), 1.0f);
+            } else {
+                return p;
+            }
+        }
+
+        // places a width x height level after the ones before it, every level is planned before the one allocation
+        void plan_level(std::size_t width, std::size_t height){
+            const std::size_t tiles_across = (width + tile_edge - 1) / tile_edge;
+            const std::size_t tiles_down = (height + tile_edge - 1) / tile_edge;
+            levels_.push_back(Level{size_, width, height, tiles_across});
+            // tiles are stored whole, the texels past the image's edge are never read
+            size_ += layout_ == TextureLayout::rows ? width * height : tiles_across * tiles_down * tile_edge * tile_edge;
+        }
+
+        void allocate(){
+            texels_.reset(static_cast<Pixel*>(::operator new(size_ * sizeof(Pixel), std::align_val_t{image_row_alignment})));
+            std::memset(static_cast<void*>(texels_.get()), 0, size_ * sizeof(Pixel));
+        }
+
+        void copy_level(const Level& level, const ImageView<const Pixel>& image) noexcept{
+            Pixel* texels = texels_.get();
+            for(std::size_t y = 0; y < image.height(); y++){
+                const Pixel* row = image.row_data(y);
+                for(std::size_t x = 0; x < image.width(); x++){
+                    texels[index(level, x, y)] = row[x];
+                }
+            }
+        }
+
+        [[nodiscard]] RGBA bilinear(const Level& level, float u, float v, const Sampler& sampler) const noexcept{
+            const float tx = u * static_cast<float>(level.width) - 0.5f;
+            const float ty = v * static_cast<float>(level.height) - 0.5f;
+            const float fx0 = std::floor(tx);
+            const float fy0 = std::floor(ty);
+            const float fx = tx - fx0;
+            const float fy = ty - fy0;
+            const auto ix = static_cast<std::ptrdiff_t>(fx0);
+            const auto iy = static_cast<std::ptrdiff_t>(fy0);
+            const std::size_t x0 = column_part(address(ix, level.width, sampler.address_u));
+            const std::size_t x1 = column_part(address(ix + 1, level.width, sampler.address_u));
+            const std::size_t y0 = row_part(level, address(iy, level.height, sampler.address_v));
+            const std::size_t y1 = row_part(level, address(iy + 1, level.height, sampler.address_v));
+
+            const Pixel* texels = texels_.get();
+            const RGBA t00 = decode(texels[y0 + x0]);
+            const RGBA t10 = decode(texels[y0 + x1]);
+            const RGBA t01 = decode(texels[y1 + x0]);
+            const RGBA t11 = decode(texels[y1 + x1]);
+            const float w00 = (1.0f - fx) * (1.0f - fy);
+            const float w10 = fx * (1.0f - fy);
+            const float w01 = (1.0f - fx) * fy;
+            const float w11 = fx * fy;
+            RGBA result;
+            for(std::size_t c = 0; c < 4; c++){
+                result[c] = w00 * t00[c] + w10 * t10[c] + w01 * t01[c] + w11 * t11[c];
+            }
+            return result;
+        }
+
+        [[nodiscard]] RGBA point(const Level& level, float u, float v, const Sampler& sampler) const noexcept{
+            const auto ix = static_cast<std::ptrdiff_t>(std::floor(u * static_cast<float>(level.width)));
+            const auto iy = static_cast<std::ptrdiff_t>(std::floor(v * static_cast<float>(level.height)));
+            return decode(texels_.get()[index(level, address(ix, level.width, sampler.address_u), address(iy, level.height, sampler.address_v))]);
+        }
+
+    public:
+        using value_type = Pixel;
+
+        /// Samples in a batch handed to one job when the batch is spread across a pool.
+        static constexpr std::size_t batch_grain = 4096;
+
+        Texture() noexcept = default;
+
+        /// A single level texture holding a copy of image.
+        explicit Texture(const ImageView<const Pixel>& image, TextureLayout layout = TextureLayout::tiles)
+            : layout_(layout){
+            assert(!image.empty() && "Texture needs at least a texel");
+            plan_level(image.width(), image.height());
+            allocate();
+            copy_level(levels_[0], image);
+        }
+
+        /// A texture holding a copy of every level of chain.
+        explicit Texture(const mip::Chain<Pixel>& chain, TextureLayout layout = TextureLayout::tiles)
+            : layout_(layout){
+            assert(chain.levels() > 0 && "Texture needs at least a texel");
+            levels_.reserve(chain.levels());
+            for(std::size_t i = 0; i < chain.levels(); i++){
+                plan_level(chain.level(i).width(), chain.level(i).height());
+            }
+            allocate();
+            for(std::size_t i = 0; i < chain.levels(); i++){
+                copy_level(levels_[i], chain.level(i));
+            }
+        }
+
+        Texture(const Texture& other) : size_(other.size_), levels_(other.levels_), layout_(other.layout_){
+            if(size_ > 0){
+                allocate();
+                std::memcpy(static_cast<void*>(texels_.get()), other.texels_.get(), size_ * sizeof(Pixel));
+            }
+        }
+
+        Texture& operator=(const Texture& other){
+            if(this != &other){
+                Texture copy(other);
+                *this = std::move(copy);
+            }
+            return *this;
+        }
+
+        Texture(Texture&& other) noexcept
+            : texels_(std::move(other.texels_)), size_(std::exchange(other.size_, 0)), levels_(std::move(other.levels_)),
+              layout_(other.layout_){ }
+
+        Texture& operator=(Texture&& other) noexcept{
+            texels_ = std::move(other.texels_);
+            size_ = std::exchange(other.size_, 0);
+            levels_ = std::move(other.levels_);
+            layout_ = other.layout_;
+            return *this;
+        }
+
+        [[nodiscard]] std::size_t levels() const noexcept{ return levels_.size(); }
+        [[nodiscard]] std::size_t width(std::size_t level = 0) const noexcept{ return levels_[level].width; }
+        [[nodiscard]] std::size_t height(std::size_t level = 0) const noexcept{ return levels_[level].height; }
+        [[nodiscard]] TextureLayout layout() const noexcept{ return layout_; }
+
+        /// The texel as stored, wherever the layout put it.
+        [[nodiscard]] const Pixel& texel(std::size_t x, std::size_t y, std::size_t level = 0) const noexcept{
+            assert(level < levels_.size() && x < levels_[level].width && y < levels_[level].height && "Texture::texel out of range");
+            return texels_.get()[index(levels_[level], x, y)];
+        }
+
+        /**
+         * @brief The mip level of detail for a sample whose UV changes by du_dx and du_dy from one pixel to the next.
+         *
+         * log2 of the longer footprint side in level 0 texels: 0 when a texel covers a pixel, 1 when two do...
+         */
+        [[nodiscard]] float lod(const VectorN<float, 2>& du_dx, const VectorN<float, 2>& du_dy) const noexcept{
+            const float w = static_cast<float>(width());
+            const float h = static_cast<float>(height());
+            const float x = du_dx[0] * w * du_dx[0] * w + du_dx[1] * h * du_dx[1] * h;
+            const float y = du_dy[0] * w * du_dy[0] * w + du_dy[1] * h * du_dy[1] * h;
+            return 0.5f * std::log2(std::max({x, y, 1e-20f}));
+        }
+
+        /// The texture at uv, filtered as sampler says from around mip level lod (clamped to the levels there are).
+        [[nodiscard]] RGBA sample(const VectorN<float, 2>& uv, const Sampler& sampler = {}, float lod = 0.0f) const noexcept{
+            const float top = static_cast<float>(levels_.size() - 1);
+            const float level = std::min(std::max(lod, 0.0f), top);
+            if(sampler.filter == TextureFilter::trilinear){
+                const auto below = static_cast<std::size_t>(level);
+                const float t = level - static_cast<float>(below);
+                const RGBA a = bilinear(levels_[below], uv[0], uv[1], sampler);
+                if(t == 0.0f){
+                    return a;
+                }
+                const RGBA b = bilinear(levels_[below + 1], uv[0], uv[1], sampler);
+                RGBA result;
+                for(std::size_t c = 0; c < 4; c++){
+                    result[c] = a[c] + (b[c] - a[c]) * t;
+                }
+                return result;
+            }
+            const Level& nearest = levels_[static_cast<std::size_t>(level + 0.5f)];
+            return sampler.filter == TextureFilter::point ? point(nearest, uv[0], uv[1], sampler) : bilinear(nearest, uv[0], uv[1], sampler);
+        }
+
+        /// out[i] = sample(uvs[i], sampler, lod), batch_grain samples to a job.
+        void sample(std::span<const VectorN<float, 2>> uvs, std::span<RGBA> out, const Sampler& sampler = {}, float lod = 0.0f,
+                    parallel::ThreadPool& pool = parallel::default_pool()) const{
+            assert(uvs.size() == out.size() && "Texture::sample needs as many outputs as UVs");
+            parallel::for_chunks(uvs.size(), batch_grain, [&](std::size_t begin, std::size_t end){
+                for(std::size_t i = begin; i < end; i++){
+                    out[i] = sample(uvs[i], sampler, lod);
+                }
+            }, pool);
+        }
+
+        /// out[i] = sample(uvs[i], sampler, lods[i]), batch_grain samples to a job.
+        void sample(std::span<const VectorN<float, 2>> uvs, std::span<const float> lods, std::span<RGBA> out, const Sampler& sampler = {},
+                    parallel::ThreadPool& pool = parallel::default_pool()) const{
+            assert(uvs.size() == out.size() && uvs.size() == lods.size() && "Texture::sample needs a lod and an output for every UV");
+            parallel::for_chunks(uvs.size(), batch_grain, [&](std::size_t begin, std::size_t end){
+                for(std::size_t i = begin; i < end; i++){
+                    out[i] = sample(uvs[i], sampler, lods[i]);
+                }
+            }, pool);
+        }
+    };
+
+}
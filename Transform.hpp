@@ -1,74 +1,144 @@
 #pragma once
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <ranges>
 #include "Matrix.hpp"
 #include "VectorN.hpp"
+#include "ES_bulk.hpp"
 namespace ES{
 
+    /**
+     * @brief What a Transform's matrix is known to be, cheapest first.
+     *
+     * Everything below projective has a last row of (0,...,0,1), the upper left block is then the linear part L
+     * and the last column the translation t. Composing two transforms gives the larger of the two kinds.
+     */
+    enum class TransformKind : std::uint8_t{
+        rigid,          // L is a rotation (or reflection), L^-1 = L^T
+        uniform_scale,  // L is a rotation times s, L^-1 = L^T / s^2
+        affine,         // any invertible L, only the (N-1)x(N-1) block needs a real inverse
+        projective      // anything else, full inverse
+    };
+
     template <typename T, std::size_t N>
     class Transform{
 
         Matrix<T,N> mat;
-        Matrix<T,N> inv;
+        // computed on first use. mutable, so the first inverse()/apply_inverse() on a shared const Transform
+        // from several threads at once is a race, call inverse() once up front if you're going to do that
+        mutable Matrix<T,N> inv;
+        mutable bool inv_valid;
+        TransformKind kind_;
 
         public:
 
         constexpr Transform() noexcept{
             mat = Matrix<T,N>::identity();
             inv = mat;
+            inv_valid = true;
+            kind_ = TransformKind::rigid;
         }
         explicit constexpr Transform(const Matrix<T,N>& m){
             mat = m;
-            inv = m.inverse();
+            inv_valid = false;
+            kind_ = classify(m);
+        }
+        // when the caller already knows what m is, skips classify. Claiming a kind m isn't gives wrong inverses
+        constexpr Transform(const Matrix<T,N>& m, TransformKind kind) noexcept{
+            assert(kind >= classify(m) && "Transform kind claims the matrix is cheaper than it is");
+            mat = m;
+            inv_valid = false;
+            kind_ = kind;
         }
         constexpr Transform(const Matrix<T,N>& m, const Matrix<T,N>& i) noexcept{
             mat = m;
             inv = i;
+            inv_valid = true;
+            kind_ = classify(m);
         }
 
         [[nodiscard]] constexpr const Matrix<T,N>& matrix() const noexcept{
             return mat;
         }
         [[nodiscard]] constexpr const Matrix<T,N>& inverse() const noexcept{
+            if(!inv_valid){
+                inv = compute_inverse();
+                inv_valid = true;
+            }
             return inv;
         }
+        [[nodiscard]] constexpr TransformKind kind() const noexcept{
+            return kind_;
+        }
+        [[nodiscard]] constexpr bool has_cached_inverse() const noexcept{
+            return inv_valid;
+        }
 
         [[nodiscard]] constexpr VectorN<T,N> apply(const VectorN<T,N>& vec) const noexcept{
             return mat * vec;
         }
+        // rigid and uniform scale go through L^T without ever building the inverse, the rest build and cache it
         [[nodiscard]] constexpr VectorN<T,N> apply_inverse(const VectorN<T,N>& vec) const noexcept{
-            return inv * vec;
+            if(inv_valid || kind_ > TransformKind::uniform_scale){
+                return inverse() * vec;
+            }
+            const T w = vec[N-1];
+            const T inv_scale_squared = kind_ == TransformKind::rigid ? T{1} : T{1} / linear_scale_squared();
+            VectorN<T,N> temp;
+            for(std::size_t col = 0; col<N-1; col++){
+                T accumulate = T{0};
+                for(std::size_t row = 0; row<N-1; row++){
+                    accumulate += mat(row,col) * (vec[row] - mat(row,N-1) * w);
+                }
+                temp[col] = accumulate * inv_scale_squared;
+            }
+            temp[N-1] = w;
+            return temp;
         }
 
 
+        // the inverse is only carried along when both sides already have one, otherwise it's left for later
         [[nodiscard]] constexpr Transform operator*(const Transform& rhs) const noexcept{
             Transform temp;
             temp.mat = mat*rhs.mat;
-            temp.inv = rhs.inv * inv;
+            temp.kind_ = std::max(kind_, rhs.kind_);
+            temp.inv_valid = inv_valid && rhs.inv_valid;
+            if(temp.inv_valid){
+                temp.inv = rhs.inv * inv;
+            }
             return temp;
         }
 
         constexpr Transform& operator*=(const Transform& rhs) noexcept {
             mat = mat* rhs.mat;
-            inv = rhs.inv * inv;
+            kind_ = std::max(kind_, rhs.kind_);
+            inv_valid = inv_valid && rhs.inv_valid;
+            if(inv_valid){
+                inv = rhs.inv * inv;
+            }
             return *this;
         }
 
 
         [[nodiscard]] constexpr Transform invert() const noexcept{
             Transform temp;
-            temp.mat = inv;
+            temp.mat = inverse();
             temp.inv = mat;
-            return temp; 
+            temp.inv_valid = true;
+            temp.kind_ = kind_;
+            return temp;
         }
 
         constexpr Transform& invert_in_place() noexcept{
+            static_cast<void>(inverse()); //fills inv if it was not cached yet
             std::swap(mat,inv);
             return *this;
         }
 
         [[nodiscard]] static constexpr Transform identity() noexcept{
             Transform temp;
-            temp.mat = Matrix<T,N>::identity();
-            temp.inv = temp.mat;
             return temp;
         }
 
@@ -76,35 +146,251 @@ namespace ES{
             return mat.almost_equal(Matrix<T,N>::identity());
         }
 
-        [[nodiscard]] constexpr Matrix<T,N> normal_matrix() const noexcept{   
-            return mat.normalize();
+        /**
+         * @brief The matrix to transform normals with, the inverse transpose of the linear part.
+         *
+         * Translation is zeroed so it works on homogeneous directions. Rigid transforms are their own normal matrix,
+         * uniform scale just divides the scale back out (columns come out unit length), only affine pays for a
+         * (N-1)x(N-1) inverse. Projective gets the inverse transpose of the whole thing.
+         */
+        [[nodiscard]] constexpr Matrix<T,N> normal_matrix() const noexcept{
+            if(kind_ == TransformKind::projective){
+                return inverse().transpose();
+            }
+            Matrix<T,N> temp = Matrix<T,N>::identity();
+            if(kind_ == TransformKind::affine){
+                const Matrix<T,N> inverse_transpose = inverse().transpose();
+                for(std::size_t col = 0; col<N-1; col++){
+                    for(std::size_t row = 0; row<N-1; row++){
+                        temp(row,col) = inverse_transpose(row,col);
+                    }
+                }
+                return temp;
+            }
+            const T inv_scale = kind_ == TransformKind::rigid ? T{1} : T{1} / std::sqrt(linear_scale_squared());
+            for(std::size_t col = 0; col<N-1; col++){
+                for(std::size_t row = 0; row<N-1; row++){
+                    temp(row,col) = mat(row,col) * inv_scale;
+                }
+            }
+            return temp;
         }
 
         [[nodiscard]] static constexpr Transform translation(const VectorN<T,N-1> t) noexcept{
             Transform temp;
-            std::memcpy(&temp.mat(0,N-1),&t.data(),sizeof(T) * (N-1));
-            temp.inv = temp.mat.inverse();
-            
+            for(std::size_t i =0; i<N-1; i++){
+                temp.mat(i,N-1) = t[i];
+                temp.inv(i,N-1) = -t[i];
+            }
             return temp;
         }
 
-        [[nodiscard]] static constexpr Transform scale(const VectorN<T,N>& s) noexcept{
+        [[nodiscard]] static constexpr Transform scale(const VectorN<T,N-1>& s) noexcept{
             Transform temp;
-            for(std::size_t i =0; i<N; i++){
+            for(std::size_t i =0; i<N-1; i++){
+                assert(s[i] != T{0} && "Zero scale in Transform::scale");
                 temp.mat(i,i) = s[i];
+                temp.inv(i,i) = T{1} / s[i];
             }
-            temp.inv = temp.mat.inverse();
+            temp.kind_ = classify(temp.mat);
             return temp;
         }
 
         [[nodiscard]] static constexpr Transform uniform_scale(T s) noexcept{
+            assert(s != T{0} && "Zero scale in Transform::uniform_scale");
             Transform temp;
-            for(std::size_t i =0; i<N; i++){
+            for(std::size_t i =0; i<N-1; i++){
                 temp.mat(i,i) = s;
+                temp.inv(i,i) = T{1} / s;
+            }
+            temp.kind_ = classify(temp.mat);
+            return temp;
+        }
+
+        /**
+         * @brief Works out the cheapest TransformKind m qualifies for, up to math::default_epsilon.
+         *
+         * A last row of (0,...,0,1) makes it at least affine. Then L^T L equal to the identity is rigid, and a multiple
+         * of it is uniform scale.
+         */
+        [[nodiscard]] static constexpr TransformKind classify(const Matrix<T,N>& m) noexcept{
+            for(std::size_t col = 0; col<N-1; col++){
+                if(!math::approx_equal(m(N-1,col), T{0})){
+                    return TransformKind::projective;
+                }
+            }
+            if(!math::approx_equal(m(N-1,N-1), T{1})){
+                return TransformKind::projective;
+            }
+
+            T scale_squared = T{0};
+            for(std::size_t row = 0; row<N-1; row++){
+                scale_squared += m(row,0) * m(row,0);
+            }
+            if(scale_squared == T{0}){
+                return TransformKind::affine;
+            }
+            for(std::size_t i = 0; i<N-1; i++){
+                for(std::size_t j = i; j<N-1; j++){
+                    T dot = T{0};
+                    for(std::size_t row = 0; row<N-1; row++){
+                        dot += m(row,i) * m(row,j);
+                    }
+                    const T expected = i == j ? scale_squared : T{0};
+                    if(!math::approx_equal(dot / scale_squared, expected / scale_squared)){
+                        return TransformKind::affine;
+                    }
+                }
+            }
+            return math::approx_equal(scale_squared, T{1}) ? TransformKind::rigid : TransformKind::uniform_scale;
+        }
+
+        /**
+         * @defgroup transform_bulk Transform bulk transforms
+         * @brief apply over a whole buffer at once, for 4x4 transforms of 3D data.
+         *
+         * Elements can be VectorN<T,3>, PointN<T,3>, VectorH<T> or VectorN<T,4>, or the coordinates can come as
+         * bulk::SoA3 streams. Three component points are divided through by w when the transform is projective,
+         * four component elements stay homogeneous. Pass the same buffer as in and out to work in place. The
+         * affine kinds skip the last row entirely.
+         * @{
+         */
+        template <std::ranges::contiguous_range In, std::ranges::contiguous_range Out>
+        void transform_points(const In& in, Out&& out) const noexcept requires(N==4){
+            bulk_apply<bulk::Mode::points>(mat, kind_, std::span(in), std::span(out));
+        }
+        void transform_points(bulk::SoA3<const T> in, bulk::SoA3<T> out) const noexcept requires(N==4){
+            bulk_apply<bulk::Mode::points>(mat, kind_, in, out);
+        }
+
+        template <std::ranges::contiguous_range In, std::ranges::contiguous_range Out>
+        void transform_vectors(const In& in, Out&& out) const noexcept requires(N==4){
+            bulk_apply<bulk::Mode::vectors>(mat, kind_, std::span(in), std::span(out));
+        }
+        void transform_vectors(bulk::SoA3<const T> in, bulk::SoA3<T> out) const noexcept requires(N==4){
+            bulk_apply<bulk::Mode::vectors>(mat, kind_, in, out);
+        }
+
+        // through normal_matrix(), so the same kind based shortcuts apply
+        template <std::ranges::contiguous_range In, std::ranges::contiguous_range Out>
+        void transform_normals(const In& in, Out&& out) const noexcept requires(N==4){
+            bulk_apply<bulk::Mode::normals>(normal_matrix(), TransformKind::affine, std::span(in), std::span(out));
+        }
+        void transform_normals(bulk::SoA3<const T> in, bulk::SoA3<T> out) const noexcept requires(N==4){
+            bulk_apply<bulk::Mode::normals>(normal_matrix(), TransformKind::affine, in, out);
+        }
+
+        template <std::ranges::contiguous_range In, std::ranges::contiguous_range Out>
+        void transform_points_inverse(const In& in, Out&& out) const noexcept requires(N==4){
+            bulk_apply<bulk::Mode::points>(inverse(), kind_, std::span(in), std::span(out));
+        }
+        void transform_points_inverse(bulk::SoA3<const T> in, bulk::SoA3<T> out) const noexcept requires(N==4){
+            bulk_apply<bulk::Mode::points>(inverse(), kind_, in, out);
+        }
+
+        template <std::ranges::contiguous_range In, std::ranges::contiguous_range Out>
+        void transform_vectors_inverse(const In& in, Out&& out) const noexcept requires(N==4){
+            bulk_apply<bulk::Mode::vectors>(inverse(), kind_, std::span(in), std::span(out));
+        }
+        void transform_vectors_inverse(bulk::SoA3<const T> in, bulk::SoA3<T> out) const noexcept requires(N==4){
+            bulk_apply<bulk::Mode::vectors>(inverse(), kind_, in, out);
+        }
+
+        // the inverse's normal matrix is the transpose of ours, modulo scale which the renormalize takes out
+        template <std::ranges::contiguous_range In, std::ranges::contiguous_range Out>
+        void transform_normals_inverse(const In& in, Out&& out) const noexcept requires(N==4){
+            bulk_apply<bulk::Mode::normals>(inverse_normal_matrix(), TransformKind::affine, std::span(in), std::span(out));
+        }
+        void transform_normals_inverse(bulk::SoA3<const T> in, bulk::SoA3<T> out) const noexcept requires(N==4){
+            bulk_apply<bulk::Mode::normals>(inverse_normal_matrix(), TransformKind::affine, in, out);
+        }
+        /** @} */
+
+        private:
+
+        template <bulk::Mode mode, typename In, typename Out>
+        static void bulk_apply(const Matrix<T,N>& m, TransformKind kind, In in, Out out) noexcept{
+            bulk::Rows<T> rows;
+            for(std::size_t row = 0; row<4; row++){
+                for(std::size_t col = 0; col<4; col++){
+                    rows[row*4 + col] = m(row,col);
+                }
+            }
+            if(kind == TransformKind::projective){
+                bulk::transform<mode, true>(rows, in, out);
+            }
+            else{
+                bulk::transform<mode, false>(rows, in, out);
+            }
+        }
+
+        [[nodiscard]] constexpr Matrix<T,N> inverse_normal_matrix() const noexcept{
+            if(kind_ == TransformKind::projective){
+                return mat.transpose();
+            }
+            Matrix<T,N> temp = Matrix<T,N>::identity();
+            for(std::size_t col = 0; col<N-1; col++){
+                for(std::size_t row = 0; row<N-1; row++){
+                    temp(row,col) = mat(col,row);
+                }
             }
-            temp.inv = temp.mat.inverse();
             return temp;
         }
-            
+
+        // s^2 of a uniform scale linear, the squared length of any of its columns
+        [[nodiscard]] constexpr T linear_scale_squared() const noexcept{
+            T accumulate = T{0};
+            for(std::size_t row = 0; row<N-1; row++){
+                accumulate += mat(row,0) * mat(row,0);
+            }
+            return accumulate;
+        }
+
+        [[nodiscard]] constexpr Matrix<T,N> compute_inverse() const noexcept{
+            if(kind_ == TransformKind::projective){
+                return mat.inverse();
+            }
+
+            Matrix<T,N> temp = Matrix<T,N>::identity();
+            if(kind_ == TransformKind::affine){
+                if constexpr(N == 2){
+                    assert(mat(0,0) != T{0} && "Singular affine Transform");
+                    temp(0,0) = T{1} / mat(0,0);
+                }
+                else{
+                    Matrix<T,N-1> linear;
+                    for(std::size_t col = 0; col<N-1; col++){
+                        for(std::size_t row = 0; row<N-1; row++){
+                            linear(row,col) = mat(row,col);
+                        }
+                    }
+                    const Matrix<T,N-1> linear_inverse = linear.inverse();
+                    for(std::size_t col = 0; col<N-1; col++){
+                        for(std::size_t row = 0; row<N-1; row++){
+                            temp(row,col) = linear_inverse(row,col);
+                        }
+                    }
+                }
+            }
+            else{
+                const T inv_scale_squared = kind_ == TransformKind::rigid ? T{1} : T{1} / linear_scale_squared();
+                for(std::size_t col = 0; col<N-1; col++){
+                    for(std::size_t row = 0; row<N-1; row++){
+                        temp(row,col) = mat(col,row) * inv_scale_squared;
+                    }
+                }
+            }
+
+            //t' = -L^-1 t
+            for(std::size_t row = 0; row<N-1; row++){
+                T accumulate = T{0};
+                for(std::size_t k = 0; k<N-1; k++){
+                    accumulate += temp(row,k) * mat(k,N-1);
+                }
+                temp(row,N-1) = -accumulate;
+            }
+            return temp;
+        }
+
     };
 }
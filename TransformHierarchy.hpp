@@ -0,0 +1,333 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <vector>
+#include "ES_parallel.hpp"
+
+
+namespace ES{
+
+    /**
+     * @brief A flat scene graph: local transforms in, world transforms out, nothing else.
+     *
+     * Nodes live in plain arrays laid out breadth first, so every parent sits before its children, a level is one
+     * contiguous run and the children of a node are a contiguous run of the level below. So are the children of a run,
+     * which is what update() leans on: it starts from the nodes touched with set_local and walks down their subtrees
+     * level by level as runs of slots, recomputing `world = parent world * local` along each run and never looking at
+     * anything else, each level split across the pool.
+     *
+     * Node handles are handed out by add and never change, the dense slot behind a handle might. Adding nodes costs
+     * one linear re-layout on the next update, so add in batches rather than a node between every update.
+     *
+     * @tparam Transform anything with `Transform * Transform` meaning "rhs then this": AffineTransform3, TransformTRS,
+     * Matrix<T,4>, DualQuaternion...
+     */
+    template <typename Transform>
+    class TransformHierarchy{
+    public:
+        using Node = std::uint32_t;
+        static constexpr Node no_parent = std::numeric_limits<Node>::max();
+
+        /// Nodes of one level handed to a single pool job.
+        static constexpr std::size_t default_grain = 4096;
+
+        TransformHierarchy() = default;
+
+        void reserve(std::size_t count){
+            local_.reserve(count); world_.reserve(count); parent_.reserve(count);
+            depth_.reserve(count); dirty_.reserve(count); slot_.reserve(count); handle_.reserve(count);
+            child_begin_.reserve(count + 1);
+        }
+
+        /**
+         * @brief Adds a node under parent (or as a root), returns its handle.
+         *
+         * The new node starts dirty, its world transform is valid after the next update.
+         */
+        Node add(const Transform& local, Node parent = no_parent){
+            assert((parent == no_parent || parent < slot_.size()) && "TransformHierarchy::add parent is not a node");
+            const Node handle = static_cast<Node>(slot_.size());
+            const std::uint32_t depth = parent == no_parent ? 0u : depth_[slot_[parent]] + 1u;
+            slot_.push_back(handle);
+            handle_.push_back(handle);
+            local_.push_back(local);
+            world_.push_back(local);
+            parent_.push_back(parent == no_parent ? no_parent : slot_[parent]);
+            depth_.push_back(depth);
+            dirty_.push_back(1);
+            touched_.push_back(handle);
+            needs_layout_ = true;
+            return handle;
+        }
+
+        void set_local(Node node, const Transform& local) noexcept{
+            assert(node < slot_.size() && "TransformHierarchy::set_local on a node that does not exist");
+            const std::uint32_t slot = slot_[node];
+            local_[slot] = local;
+            if(!dirty_[slot]){
+                dirty_[slot] = 1;
+                touched_.push_back(node);
+            }
+        }
+
+        [[nodiscard]] const Transform& local(Node node) const noexcept{
+            assert(node < slot_.size() && "TransformHierarchy::local on a node that does not exist");
+            return local_[slot_[node]];
+        }
+
+        // as of the last update
+        [[nodiscard]] const Transform& world(Node node) const noexcept{
+            assert(node < slot_.size() && "TransformHierarchy::world on a node that does not exist");
+            return world_[slot_[node]];
+        }
+
+        [[nodiscard]] Node parent(Node node) const noexcept{
+            assert(node < slot_.size() && "TransformHierarchy::parent on a node that does not exist");
+            const std::uint32_t parent_slot = parent_[slot_[node]];
+            return parent_slot == no_parent ? no_parent : handle_[parent_slot];
+        }
+
+        [[nodiscard]] std::uint32_t depth(Node node) const noexcept{
+            return depth_[slot_[node]];
+        }
+
+        [[nodiscard]] std::size_t size() const noexcept{
+            return local_.size();
+        }
+
+        // every world transform in depth order (not handle order), for handing straight to a GPU buffer
+        [[nodiscard]] std::span<const Transform> world_transforms() const noexcept{
+            return world_;
+        }
+
+        // the handle sitting at a position of world_transforms()
+        [[nodiscard]] Node node_at(std::size_t slot) const noexcept{
+            return handle_[slot];
+        }
+
+        /**
+         * @brief Brings every world transform up to date with the locals.
+         *
+         * Levels run one after another, the dirty runs of a level in parallel (a level only reads worlds of the one
+         * above). Costs one multiply per node in a dirty subtree and a little per run, clean nodes are never visited.
+         */
+        void update(parallel::ThreadPool& pool = parallel::default_pool(), std::size_t grain = default_grain);
+
+    private:
+        //a run of dirty slots on one level, [begin, end)
+        struct Run{
+            std::uint32_t begin;
+            std::uint32_t end;
+        };
+
+        void layout();
+        void compose_runs(bool roots, parallel::ThreadPool& pool, std::size_t grain);
+
+        std::vector<Transform> local_;
+        std::vector<Transform> world_;
+        std::vector<std::uint32_t> parent_;       //slot of the parent, no_parent for roots
+        std::vector<std::uint32_t> depth_;
+        std::vector<std::uint8_t> dirty_;         //set while a node waits in touched_
+        std::vector<std::uint32_t> slot_;         //handle -> slot
+        std::vector<Node> handle_;                //slot -> handle
+        std::vector<std::size_t> level_begin_;
+        std::vector<std::uint32_t> child_begin_;  //children of slot s are the slots [child_begin_[s], child_begin_[s + 1])
+        std::vector<Node> touched_;               //handles dirtied since the last update, each once
+        std::vector<std::uint32_t> touched_slots_; //touched_ as slots in order, and scratch for sorting them
+        std::vector<Run> current_;                //the level being updated and the one below it, kept for their capacity
+        std::vector<Run> next_;
+        std::vector<std::size_t> run_offset_;     //nodes in the runs of current_ before each one, and the total
+        bool needs_layout_ = false;
+    };
+
+    template <typename Transform>
+    void TransformHierarchy<Transform>::update(parallel::ThreadPool& pool, std::size_t grain){
+        if(touched_.empty()){
+            return;
+        }
+        if(needs_layout_){
+            layout();
+        }
+
+        //slot order is level order too, so one radix sort on the slots groups the touched by level and orders each level
+        touched_slots_.resize(touched_.size());
+        for(std::size_t i = 0; i < touched_.size(); i++){
+            const std::uint32_t slot = slot_[touched_[i]];
+            touched_slots_[i] = slot;
+            dirty_[slot] = 0;
+        }
+        for(std::size_t shift = 0; (local_.size() - 1) >> shift != 0; shift += 8){
+            std::array<std::size_t, 257> bucket{};
+            for(const std::uint32_t slot : touched_slots_){
+                bucket[((slot >> shift) & 0xff) + 1]++;
+            }
+            for(std::size_t b = 1; b < bucket.size(); b++){
+                bucket[b] += bucket[b - 1];
+            }
+            for(const std::uint32_t slot : touched_slots_){
+                touched_[bucket[(slot >> shift) & 0xff]++] = slot;
+            }
+            std::swap(touched_, touched_slots_);
+        }
+
+        current_.clear();
+        std::size_t next_touched = 0;
+        for(std::size_t level = 0; level + 1 < level_begin_.size(); level++){
+            //the dirty subtrees reaching down from above, plus whatever was touched on this level itself
+            next_.clear();
+            const auto extend = [this](std::uint32_t begin, std::uint32_t end){
+                if(!next_.empty() && next_.back().end >= begin){
+                    next_.back().end = std::max(next_.back().end, end);
+                } else{
+                    next_.push_back(Run{begin, end});
+                }
+            };
+            std::size_t run = 0;
+            for(; next_touched < touched_slots_.size() && touched_slots_[next_touched] < level_begin_[level + 1]; next_touched++){
+                const std::uint32_t slot = touched_slots_[next_touched];
+                for(; run < current_.size() && current_[run].begin <= slot; run++){
+                    extend(current_[run].begin, current_[run].end);
+                }
+                extend(slot, slot + 1);
+            }
+            for(; run < current_.size(); run++){
+                extend(current_[run].begin, current_[run].end);
+            }
+            std::swap(current_, next_);
+            if(current_.empty()){
+                if(next_touched == touched_slots_.size()){
+                    break;
+                }
+                continue;
+            }
+
+            compose_runs(level == 0, pool, grain);
+
+            //the children of a run are a run, and children of runs in order come in order
+            next_.clear();
+            for(const Run r : current_){
+                const std::uint32_t begin = child_begin_[r.begin];
+                const std::uint32_t end = child_begin_[r.end];
+                if(begin == end){
+                    continue;
+                }
+                if(!next_.empty() && next_.back().end == begin){
+                    next_.back().end = end;
+                } else{
+                    next_.push_back(Run{begin, end});
+                }
+            }
+            std::swap(current_, next_);
+        }
+
+        touched_.clear();
+    }
+
+    template <typename Transform>
+    void TransformHierarchy<Transform>::compose_runs(bool roots, parallel::ThreadPool& pool, std::size_t grain){
+        run_offset_.resize(current_.size() + 1);
+        run_offset_[0] = 0;
+        for(std::size_t r = 0; r < current_.size(); r++){
+            run_offset_[r + 1] = run_offset_[r] + (current_[r].end - current_[r].begin);
+        }
+
+        //the nodes of the level's runs laid end to end, split evenly whatever the runs' lengths
+        parallel::for_chunks(run_offset_.back(), grain, [this, roots](std::size_t first, std::size_t last){
+            std::size_t r = static_cast<std::size_t>(std::upper_bound(run_offset_.begin(), run_offset_.end(), first) - run_offset_.begin()) - 1;
+            for(std::size_t at = first; at < last; r++){
+                const std::size_t begin = current_[r].begin + (at - run_offset_[r]);
+                const std::size_t end = current_[r].begin + (std::min(last, run_offset_[r + 1]) - run_offset_[r]);
+                if(roots){
+                    std::copy(local_.begin() + begin, local_.begin() + end, world_.begin() + begin);
+                } else{
+                    for(std::size_t slot = begin; slot < end; slot++){
+                        world_[slot] = world_[parent_[slot]] * local_[slot];
+                    }
+                }
+                at += end - begin;
+            }
+        }, pool);
+    }
+
+    //breadth first from the roots, so levels are contiguous and so are the children of every node. Roots and siblings
+    //keep their relative order, and with it whatever locality the order of adding gave them
+    template <typename Transform>
+    void TransformHierarchy<Transform>::layout(){
+        const std::size_t count = local_.size();
+
+        //children of every slot in the old layout, as one counting sort on the parent
+        std::vector<std::uint32_t> first_child(count + 1, 0);
+        for(std::size_t i = 0; i < count; i++){
+            if(parent_[i] != no_parent){
+                first_child[parent_[i] + 1]++;
+            }
+        }
+        for(std::size_t i = 1; i <= count; i++){
+            first_child[i] += first_child[i - 1];
+        }
+        std::vector<std::uint32_t> cursor(first_child.begin(), first_child.end() - 1);
+        std::vector<std::uint32_t> children(first_child[count]);
+        for(std::size_t i = 0; i < count; i++){
+            if(parent_[i] != no_parent){
+                children[cursor[parent_[i]]++] = static_cast<std::uint32_t>(i);
+            }
+        }
+
+        std::vector<std::uint32_t> order;
+        order.reserve(count);
+        for(std::size_t i = 0; i < count; i++){
+            if(parent_[i] == no_parent){
+                order.push_back(static_cast<std::uint32_t>(i));
+            }
+        }
+        child_begin_.assign(count + 1, static_cast<std::uint32_t>(count));
+        for(std::size_t k = 0; k < order.size(); k++){
+            child_begin_[k] = static_cast<std::uint32_t>(order.size());
+            const std::uint32_t old = order[k];
+            order.insert(order.end(), children.begin() + first_child[old], children.begin() + first_child[old + 1]);
+        }
+
+        std::vector<std::uint32_t> new_slot(count);
+        for(std::size_t k = 0; k < count; k++){
+            new_slot[order[k]] = static_cast<std::uint32_t>(k);
+        }
+
+        std::vector<Transform> local(count), world(count);
+        std::vector<std::uint32_t> parent(count), depth(count);
+        std::vector<std::uint8_t> dirty(count);
+        std::vector<Node> handle(count);
+        for(std::size_t k = 0; k < count; k++){
+            const std::uint32_t from = order[k];
+            local[k] = local_[from];
+            world[k] = world_[from];
+            parent[k] = parent_[from] == no_parent ? no_parent : new_slot[parent_[from]];
+            depth[k] = depth_[from];
+            dirty[k] = dirty_[from];
+            handle[k] = handle_[from];
+            slot_[handle[k]] = static_cast<std::uint32_t>(k);
+        }
+
+        const std::uint32_t max_depth = count == 0 ? 0u : depth.back();
+        level_begin_.assign(count == 0 ? 1 : max_depth + 2, 0);
+        for(std::size_t k = 0; k < count; k++){
+            level_begin_[depth[k] + 1]++;
+        }
+        for(std::size_t level = 1; level < level_begin_.size(); level++){
+            level_begin_[level] += level_begin_[level - 1];
+        }
+
+        handle_ = std::move(handle);
+        local_ = std::move(local);
+        world_ = std::move(world);
+        parent_ = std::move(parent);
+        depth_ = std::move(depth);
+        dirty_ = std::move(dirty);
+        needs_layout_ = false;
+    }
+
+}
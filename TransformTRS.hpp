@@ -0,0 +1,221 @@
+#pragma once
+
+#include <array>
+#include <cassert>
+#include <span>
+#include "ES_simd.hpp"
+#include "Quaternion.hpp"
+#include "VectorN.hpp"
+#include "Matrix.hpp"
+#include "AffineTransform3.hpp"
+
+
+namespace ES{
+
+    /**
+     * @brief A transform kept as its parts: scale, then rotation (unit quaternion), then translation.
+     *
+     * Ten scalars rather than the twelve of an AffineTransform3 or sixteen of a Matrix<T,4>, and composing two of them
+     * is a quaternion product plus a rotate instead of a 3x3 matrix product, which is what hierarchy updates spend
+     * their time doing. Build the matrix forms with to_affine / to_matrix4 only when something actually needs them.
+     *
+     * @note TRS is only closed under composition while the parent's scale is uniform. A non uniformly scaled parent
+     * over a rotated child really produces shear, which this type cannot hold, so operator* drops it (the usual game
+     * engine compromise). inverse has the same caveat. transform_point_inverse is always exact.
+     */
+    template <typename T>
+    class TransformTRS{
+        Quaternion<T> rotation;
+        VectorN<T,3> translation;
+        VectorN<T,3> scale;
+
+    public:
+        constexpr TransformTRS() noexcept : rotation(Quaternion<T>::identity()), translation{0,0,0}, scale{1,1,1} { }
+
+        constexpr TransformTRS(const VectorN<T,3>& t, const Quaternion<T>& r, const VectorN<T,3>& s) noexcept
+            : rotation(r), translation(t), scale(s) { }
+
+        [[nodiscard]] static constexpr TransformTRS identity() noexcept{
+            return TransformTRS();
+        }
+
+        [[nodiscard]] static constexpr TransformTRS from_translation(const VectorN<T,3>& t) noexcept{
+            return TransformTRS(t, Quaternion<T>::identity(), VectorN<T,3>{1,1,1});
+        }
+
+        [[nodiscard]] static constexpr TransformTRS from_rotation(const Quaternion<T>& r) noexcept{
+            return TransformTRS(VectorN<T,3>{0,0,0}, r, VectorN<T,3>{1,1,1});
+        }
+
+        [[nodiscard]] static constexpr TransformTRS from_scale(const VectorN<T,3>& s) noexcept{
+            return TransformTRS(VectorN<T,3>{0,0,0}, Quaternion<T>::identity(), s);
+        }
+
+        // decomposes the affine, any shear in it is lost
+        [[nodiscard]] static /* constexpr in c++26*/ TransformTRS from_affine(const AffineTransform3<T>& affine) noexcept{
+            VectorN<T,3> s = affine.get_scale();
+            if(affine.get_linear().determinant() < T{0}){
+                s[0] = -s[0];
+            }
+            return TransformTRS(affine.get_translation(), affine.get_rotation(), s);
+        }
+
+        [[nodiscard]] constexpr const Quaternion<T>& get_rotation() const noexcept{
+            return rotation;
+        }
+
+        [[nodiscard]] constexpr VectorN<T,3> get_translation() const noexcept{
+            return translation;
+        }
+
+        [[nodiscard]] constexpr VectorN<T,3> get_scale() const noexcept{
+            return scale;
+        }
+
+        constexpr void set_rotation(const Quaternion<T>& r) noexcept{
+            rotation = r;
+        }
+
+        constexpr void set_translation(const VectorN<T,3>& t) noexcept{
+            translation = t;
+        }
+
+        constexpr void set_scale(const VectorN<T,3>& s) noexcept{
+            scale = s;
+        }
+
+        [[nodiscard]] constexpr VectorN<T,3> transform_point(const VectorN<T,3>& point) const noexcept{
+            return rotation.rotate(point.hadamard_product(scale)) + translation;
+        }
+
+        [[nodiscard]] constexpr VectorN<T,3> transform_vector(const VectorN<T,3>& vec) const noexcept{
+            return rotation.rotate(vec.hadamard_product(scale));
+        }
+
+        [[nodiscard]] constexpr VectorN<T,3> transform_point_inverse(const VectorN<T,3>& point) const noexcept{
+            return rotation.conjugate().rotate(point - translation).hadamard_divide(scale);
+        }
+
+        [[nodiscard]] constexpr VectorN<T,3> transform_vector_inverse(const VectorN<T,3>& vec) const noexcept{
+            return rotation.conjugate().rotate(vec).hadamard_divide(scale);
+        }
+
+        // this applied after rhs, like AffineTransform3's operator*
+        [[nodiscard]] constexpr TransformTRS operator*(const TransformTRS& rhs) const noexcept{
+            return TransformTRS(transform_point(rhs.translation), rotation * rhs.rotation, scale.hadamard_product(rhs.scale));
+        }
+
+        constexpr TransformTRS& operator*=(const TransformTRS& rhs) noexcept{
+            translation = transform_point(rhs.translation);
+            rotation *= rhs.rotation;
+            scale.hadamard_product_in_place(rhs.scale);
+            return *this;
+        }
+
+        [[nodiscard]] constexpr TransformTRS inverse() const noexcept{
+            assert(scale[0] != T{0} && scale[1] != T{0} && scale[2] != T{0} && "Zero scale in TransformTRS::inverse");
+            VectorN<T,3> inv_scale(T{1} / scale[0], T{1} / scale[1], T{1} / scale[2]);
+            Quaternion<T> inv_rotation = rotation.conjugate();
+            return TransformTRS(-(inv_rotation.rotate(translation).hadamard_product(inv_scale)), inv_rotation, inv_scale);
+        }
+
+        // long chains of products drift off unit length, call this every so often
+        constexpr TransformTRS& normalize_in_place() noexcept{
+            rotation.normalize_in_place();
+            return *this;
+        }
+
+        [[nodiscard]] constexpr AffineTransform3<T> to_affine() const noexcept{
+            return AffineTransform3<T>::from_trs(translation, rotation, scale);
+        }
+
+        [[nodiscard]] constexpr Matrix<T,4> to_matrix4() const noexcept{
+            const Matrix<T,3> r = rotation.to_matrix3();
+            Matrix<T,4> temp;
+            for(std::size_t col = 0; col<3; col++){
+                temp(0,col) = r(0,col) * scale[col];
+                temp(1,col) = r(1,col) * scale[col];
+                temp(2,col) = r(2,col) * scale[col];
+                temp(3,col) = T{0};
+            }
+            temp(0,3) = translation[0];
+            temp(1,3) = translation[1];
+            temp(2,3) = translation[2];
+            temp(3,3) = T{1};
+            return temp;
+        }
+
+        [[nodiscard]] constexpr bool almost_equal(const TransformTRS& rhs, T epsilon = math::default_epsilon<T>::value) const noexcept{
+            //q and -q are the same rotation
+            const bool same_rotation = rotation.almost_equal(rhs.rotation, epsilon) || rotation.almost_equal(-rhs.rotation, epsilon);
+            return same_rotation && translation.almost_equal(rhs.translation, epsilon) && scale.almost_equal(rhs.scale, epsilon);
+        }
+
+        /**
+         * @brief out[i] = parents[i] * locals[i] for a whole batch, `simd::lanes<T>` transforms at a time.
+         *
+         * The products are exactly those of operator*, just done over structure-of-arrays scratch so the quaternion
+         * product and rotate vectorize. out may alias locals (a hierarchy pass overwriting local with world in place)
+         * but not parents.
+         */
+        static constexpr void compose(std::span<const TransformTRS> parents, std::span<const TransformTRS> locals, std::span<TransformTRS> out) noexcept;
+
+    private:
+        template <std::size_t W>
+        static constexpr void compose_batch(const TransformTRS* ES_RESTRICT parents, const TransformTRS* locals, TransformTRS* out, std::size_t count) noexcept;
+    };
+
+    template <typename T>
+    constexpr void TransformTRS<T>::compose(std::span<const TransformTRS> parents, std::span<const TransformTRS> locals, std::span<TransformTRS> out) noexcept{
+        assert(parents.size() == locals.size() && locals.size() == out.size() && "compose needs one parent and one output per local");
+        constexpr std::size_t W = simd::lanes<T>;
+        for(std::size_t i = 0; i<out.size(); i += W){
+            compose_batch<W>(parents.data() + i, locals.data() + i, out.data() + i, std::min(W, out.size() - i));
+        }
+    }
+
+    template <typename T>
+    template <std::size_t W>
+    constexpr void TransformTRS<T>::compose_batch(const TransformTRS* ES_RESTRICT parents, const TransformTRS* locals, TransformTRS* out, std::size_t count) noexcept{
+        //parent (a) and local (b), one lane per transform. Padding lanes are identities and never written back
+        alignas(simd::register_bytes) std::array<T,W> aw, ax, ay, az, atx, aty, atz, asx, asy, asz;
+        alignas(simd::register_bytes) std::array<T,W> bw, bx, by, bz, btx, bty, btz, bsx, bsy, bsz;
+        for(std::size_t lane = 0; lane<W; lane++){
+            const TransformTRS& a = lane < count ? parents[lane] : TransformTRS();
+            const TransformTRS& b = lane < count ? locals[lane] : TransformTRS();
+            aw[lane] = a.rotation.w(); ax[lane] = a.rotation.x(); ay[lane] = a.rotation.y(); az[lane] = a.rotation.z();
+            atx[lane] = a.translation[0]; aty[lane] = a.translation[1]; atz[lane] = a.translation[2];
+            asx[lane] = a.scale[0]; asy[lane] = a.scale[1]; asz[lane] = a.scale[2];
+            bw[lane] = b.rotation.w(); bx[lane] = b.rotation.x(); by[lane] = b.rotation.y(); bz[lane] = b.rotation.z();
+            btx[lane] = b.translation[0]; bty[lane] = b.translation[1]; btz[lane] = b.translation[2];
+            bsx[lane] = b.scale[0]; bsy[lane] = b.scale[1]; bsz[lane] = b.scale[2];
+        }
+
+        alignas(simd::register_bytes) std::array<T,W> rw, rx, ry, rz, tx, ty, tz, sx, sy, sz;
+        ES_VECTORIZE
+        for(std::size_t lane = 0; lane<W; lane++){
+            rw[lane] = aw[lane]*bw[lane] - ax[lane]*bx[lane] - ay[lane]*by[lane] - az[lane]*bz[lane];
+            rx[lane] = aw[lane]*bx[lane] + ax[lane]*bw[lane] + ay[lane]*bz[lane] - az[lane]*by[lane];
+            ry[lane] = aw[lane]*by[lane] - ax[lane]*bz[lane] + ay[lane]*bw[lane] + az[lane]*bx[lane];
+            rz[lane] = aw[lane]*bz[lane] + ax[lane]*by[lane] - ay[lane]*bx[lane] + az[lane]*bw[lane];
+
+            //translation = a.t + rotate(a.r, a.s * b.t), with rotate as in Quaternion::rotate
+            const T vx = asx[lane]*btx[lane], vy = asy[lane]*bty[lane], vz = asz[lane]*btz[lane];
+            const T cx = T{2}*(ay[lane]*vz - az[lane]*vy);
+            const T cy = T{2}*(az[lane]*vx - ax[lane]*vz);
+            const T cz = T{2}*(ax[lane]*vy - ay[lane]*vx);
+            tx[lane] = atx[lane] + vx + aw[lane]*cx + (ay[lane]*cz - az[lane]*cy);
+            ty[lane] = aty[lane] + vy + aw[lane]*cy + (az[lane]*cx - ax[lane]*cz);
+            tz[lane] = atz[lane] + vz + aw[lane]*cz + (ax[lane]*cy - ay[lane]*cx);
+
+            sx[lane] = asx[lane]*bsx[lane]; sy[lane] = asy[lane]*bsy[lane]; sz[lane] = asz[lane]*bsz[lane];
+        }
+
+        for(std::size_t lane = 0; lane<count; lane++){
+            out[lane] = TransformTRS(VectorN<T,3>(tx[lane], ty[lane], tz[lane]),
+                                     Quaternion<T>(rw[lane], rx[lane], ry[lane], rz[lane]),
+                                     VectorN<T,3>(sx[lane], sy[lane], sz[lane]));
+        }
+    }
+
+}
@@ -29,14 +29,14 @@ class VectorH : public ContainerN<VectorH<T>,T,4>, public ArithmeticOpsMixin<Vec
     using ContainerN<VectorH,T,N>::cbegin;
     using ContainerN<VectorH,T,N>::ContainerN;
 
-    VectorH(PointN<T,3> point, T w = T{1}){
+    VectorH(PointN<T,3> point, T W = T{1}){
         std::copy(point.cbegin(),point.cend(), data_.begin());
-        w() = w;
+        w() = W;
     }
 
-    VectorH(VectorN<T,3> direction, T w = T{0}){
+    VectorH(VectorN<T,3> direction, T W = T{0}){
         std::copy(direction.cbegin(),direction.cend(), data_.begin());
-        w() = w;
+        w() = W;
     }
     /** @defgroup accessors Accessors
     *  @brief Convenient element accessors for VectorN (x, y, z, w).
@@ -1,8 +1,13 @@
 #define NDEBUG
 #include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <vector>
 #include "../ES_math.hpp"
 #include "../Matrix.hpp"
 #include "../VectorN.hpp"
+#include "../PointN.hpp"
+#include "../VectorH.hpp"
+#include "../Quaternion.hpp"
 #include "../AffineTransform3.hpp"
 
 using namespace ES;
@@ -312,4 +317,242 @@ TEST_CASE("AffineTransform3 identity transform", "[AffineTransform3]"){
     REQUIRE(result[0] == 5.0f);
     REQUIRE(result[1] == 7.0f);
     REQUIRE(result[2] == 9.0f);
-}
\ No newline at end of file
+}
+TEST_CASE("AffineTransform3 from_rotation matches the quaternion", "[AffineTransform3]"){
+    Quaternion<float> rot(Vector3<float>(0.0f, 0.0f, 1.0f), Angle<in_radians, float>(math::half_pi<float>));
+
+    auto transform = AffineTransform3<float>::from_rotation(rot);
+
+    REQUIRE(transform.transform_point(Vector3<float>(1.0f, 0.0f, 0.0f)).almost_equal(Vector3<float>(0.0f, 1.0f, 0.0f), 1e-6f));
+    REQUIRE(transform.get_translation().almost_equal(Vector3<float>(0.0f, 0.0f, 0.0f)));
+}
+
+TEST_CASE("AffineTransform3 from_trs scales, rotates, then translates", "[AffineTransform3]"){
+    Quaternion<float> rot(Vector3<float>(0.0f, 0.0f, 1.0f), Angle<in_radians, float>(math::half_pi<float>));
+    Vector3<float> t(1.0f, 2.0f, 3.0f);
+    Vector3<float> s(2.0f, 3.0f, 4.0f);
+
+    auto transform = AffineTransform3<float>::from_trs(t, rot, s);
+    auto expected = AffineTransform3<float>::from_translation(t) * AffineTransform3<float>::from_rotation(rot) * AffineTransform3<float>::from_scale(s);
+    Vector3<float> p(1.0f, -1.0f, 0.5f);
+
+    REQUIRE(transform.transform_point(p).almost_equal(expected.transform_point(p), 1e-5f));
+    REQUIRE(transform.get_scale().almost_equal(s, 1e-5f));
+}
+
+TEST_CASE("AffineTransform3 get_rotation recovers the rotation under scale", "[AffineTransform3]"){
+    Quaternion<float> rot(Vector3<float>(1.0f, 2.0f, -0.5f), Angle<in_radians, float>(2.2f));
+
+    auto transform = AffineTransform3<float>::from_trs(Vector3<float>(5.0f, 0.0f, 0.0f), rot, Vector3<float>(3.0f, 0.5f, 2.0f));
+    auto recovered = transform.get_rotation();
+
+    REQUIRE((recovered.almost_equal(rot, 1e-5f) || recovered.almost_equal(-rot, 1e-5f)));
+}
+
+TEST_CASE("AffineTransform3 get_rotation of a mirror", "[AffineTransform3]"){
+    Quaternion<float> rot(Vector3<float>(0.0f, 1.0f, 0.0f), Angle<in_radians, float>(0.8f));
+
+    auto transform = AffineTransform3<float>::from_trs(Vector3<float>(0.0f, 0.0f, 0.0f), rot, Vector3<float>(-2.0f, 1.0f, 1.0f));
+    auto recovered = transform.get_rotation();
+
+    REQUIRE(math::approx_equal(recovered.length(), 1.0f));
+    REQUIRE((recovered.almost_equal(rot, 1e-5f) || recovered.almost_equal(-rot, 1e-5f)));
+}
+
+namespace {
+    AffineTransform3<float> bulk_test_transform(){
+        Quaternion<float> rot(Vector3<float>(1.0f, -2.0f, 0.5f), Angle<in_radians, float>(0.8f));
+        return AffineTransform3<float>::from_trs(Vector3<float>(3.0f, -1.0f, 2.0f), rot, Vector3<float>(2.0f, 0.5f, 1.5f));
+    }
+
+    std::vector<Vector3<float>> bulk_test_points(std::size_t count){
+        std::vector<Vector3<float>> points(count);
+        for(std::size_t i = 0; i < count; i++){
+            points[i] = Vector3<float>(float(i % 11) - 5.0f, float(i % 7) * 0.5f, 1.0f - float(i % 3));
+        }
+        return points;
+    }
+}
+
+TEST_CASE("AffineTransform3 transform_points matches transform_point", "[AffineTransform3]"){
+    auto transform = bulk_test_transform();
+    auto points = bulk_test_points(103);
+    std::vector<Vector3<float>> out(points.size());
+
+    transform.transform_points(points, out);
+    for(std::size_t i = 0; i < points.size(); i++){
+        REQUIRE(out[i].almost_equal(transform.transform_point(points[i]), 1e-5f));
+    }
+
+    transform.transform_vectors(points, out);
+    for(std::size_t i = 0; i < points.size(); i++){
+        REQUIRE(out[i].almost_equal(transform.transform_vector(points[i]), 1e-5f));
+    }
+}
+
+TEST_CASE("AffineTransform3 transform_points in place and inverse", "[AffineTransform3]"){
+    auto transform = bulk_test_transform();
+    auto points = bulk_test_points(37);
+    auto original = points;
+
+    transform.transform_points(points, points);
+    transform.transform_points_inverse(points, points);
+    for(std::size_t i = 0; i < points.size(); i++){
+        REQUIRE(points[i].almost_equal(original[i], 1e-4f));
+    }
+
+    transform.transform_vectors(points, points);
+    transform.transform_vectors_inverse(points, points);
+    for(std::size_t i = 0; i < points.size(); i++){
+        REQUIRE(points[i].almost_equal(original[i], 1e-4f));
+    }
+}
+
+TEST_CASE("AffineTransform3 transform_points over PointN and VectorH", "[AffineTransform3]"){
+    auto transform = bulk_test_transform();
+    std::vector<PointN<float,3>> points = {PointN<float,3>(1.0f, 2.0f, 3.0f), PointN<float,3>(-1.0f, 0.0f, 0.5f)};
+    std::vector<VectorH<float>> homogeneous = {VectorH<float>(Vector3<float>(1.0f, 2.0f, 3.0f), 1.0f), VectorH<float>(Vector3<float>(1.0f, 2.0f, 3.0f), 0.0f)};
+
+    transform.transform_points(points, points);
+    transform.transform_points(homogeneous, homogeneous);
+
+    REQUIRE(Vector3<float>(points[0][0], points[0][1], points[0][2]).almost_equal(transform.transform_point(Vector3<float>(1.0f, 2.0f, 3.0f)), 1e-5f));
+    //VectorH brings its own w: 1 is translated, 0 is not
+    REQUIRE(Vector3<float>(homogeneous[0][0], homogeneous[0][1], homogeneous[0][2]).almost_equal(transform.transform_point(Vector3<float>(1.0f, 2.0f, 3.0f)), 1e-5f));
+    REQUIRE(Vector3<float>(homogeneous[1][0], homogeneous[1][1], homogeneous[1][2]).almost_equal(transform.transform_vector(Vector3<float>(1.0f, 2.0f, 3.0f)), 1e-5f));
+    REQUIRE(homogeneous[0][3] == 1.0f);
+    REQUIRE(homogeneous[1][3] == 0.0f);
+}
+
+TEST_CASE("AffineTransform3 transform_points over SoA streams", "[AffineTransform3]"){
+    auto transform = bulk_test_transform();
+    auto points = bulk_test_points(21);
+    std::vector<float> xs, ys, zs;
+    for(const auto& p : points){
+        xs.push_back(p[0]); ys.push_back(p[1]); zs.push_back(p[2]);
+    }
+    bulk::SoA3<float> streams(xs, ys, zs);
+
+    transform.transform_points(streams, streams);
+
+    for(std::size_t i = 0; i < points.size(); i++){
+        REQUIRE(Vector3<float>(xs[i], ys[i], zs[i]).almost_equal(transform.transform_point(points[i]), 1e-5f));
+    }
+}
+
+TEST_CASE("AffineTransform3 transform_normals stays perpendicular", "[AffineTransform3]"){
+    auto transform = AffineTransform3<float>::from_scale(Vector3<float>(4.0f, 1.0f, 1.0f));
+    std::vector<Vector3<float>> tangents = {Vector3<float>(1.0f, 1.0f, 0.0f)};
+    std::vector<Vector3<float>> normals = {Vector3<float>(1.0f, -1.0f, 0.0f).normalize()};
+
+    transform.transform_vectors(tangents, tangents);
+    transform.transform_normals(normals, normals);
+
+    REQUIRE(math::approx_equal(tangents[0].dot(normals[0]), 0.0f, 1e-6f));
+    REQUIRE(math::approx_equal(normals[0].magnitude(), 1.0f));
+
+    transform.transform_normals_inverse(normals, normals);
+    REQUIRE(normals[0].almost_equal(Vector3<float>(1.0f, -1.0f, 0.0f).normalize(), 1e-6f));
+}
+
+TEST_CASE("AffineTransform3 transform_points past the streaming threshold", "[AffineTransform3]"){
+    auto transform = bulk_test_transform();
+    //enough output bytes for the non-temporal store path
+    auto points = bulk_test_points(simd::non_temporal_threshold / sizeof(Vector3<float>) + 5);
+    std::vector<Vector3<float>> out(points.size());
+
+    transform.transform_points(points, out);
+
+    for(std::size_t i = 0; i < points.size(); i += 4099){
+        REQUIRE(out[i].almost_equal(transform.transform_point(points[i]), 1e-5f));
+    }
+    REQUIRE(out.back().almost_equal(transform.transform_point(points.back()), 1e-5f));
+}
+
+TEST_CASE("AffineTransform3 transform 1M points", "[AffineTransform3][!benchmark]"){
+    auto transform = bulk_test_transform();
+    auto points = bulk_test_points(1'000'000);
+    std::vector<Vector3<float>> out(points.size());
+
+    BENCHMARK("transform_point per point"){
+        for(std::size_t i = 0; i < points.size(); i++){
+            out[i] = transform.transform_point(points[i]);
+        }
+        return out.back()[0];
+    };
+
+    BENCHMARK("transform_points"){
+        transform.transform_points(points, out);
+        return out.back()[0];
+    };
+}
+
+TEST_CASE("Affine3 interpolate hits both ends and keeps rotations rigid", "[Affine3]"){
+    const Quaternion<double> ra(Vector3<double>(0.0, 1.0, 0.0), Angle<in_radians, double>(0.2));
+    const Quaternion<double> rb(Vector3<double>(1.0, 0.0, 1.0), Angle<in_radians, double>(2.9));
+    const auto a = AffineTransform3<double>::from_trs(Vector3<double>(1.0, 2.0, 3.0), ra, Vector3<double>(1.0, 1.0, 1.0));
+    const auto b = AffineTransform3<double>::from_trs(Vector3<double>(-4.0, 0.0, 1.0), rb, Vector3<double>(1.0, 1.0, 1.0));
+
+    REQUIRE(AffineTransform3<double>::interpolate(a, b, 0.0).get_linear().almost_equal(a.get_linear(), 1e-12));
+    REQUIRE(AffineTransform3<double>::interpolate(a, b, 1.0).get_linear().almost_equal(b.get_linear(), 1e-12));
+
+    //a matrix lerp through a near half turn collapses, this stays a rotation the whole way
+    for(double t = 0.0; t <= 1.0; t += 0.125){
+        const auto mid = AffineTransform3<double>::interpolate(a, b, t);
+        REQUIRE(mid.get_linear().almost_equal(ra.slerp(rb, t).to_matrix3(), 1e-12));
+        REQUIRE(mid.get_translation().almost_equal(a.get_translation().lerp(b.get_translation(), t), 1e-12));
+    }
+    const auto lerped = a.get_linear().lerp(b.get_linear(), 0.5);
+    REQUIRE(std::fabs(lerped.determinant()) < 0.1);
+}
+
+TEST_CASE("Affine3 interpolate lerps stretch and survives mirroring", "[Affine3]"){
+    const Quaternion<double> r(Vector3<double>(0.3, 1.0, 0.0), Angle<in_radians, double>(0.7));
+    const auto a = AffineTransform3<double>::from_trs(Vector3<double>(0.0, 0.0, 0.0), r, Vector3<double>(-1.0, 2.0, 3.0));
+    const auto b = AffineTransform3<double>::from_trs(Vector3<double>(0.0, 0.0, 0.0), r, Vector3<double>(-3.0, 2.0, 1.0));
+    const auto mid = AffineTransform3<double>::interpolate(a, b, 0.5);
+    const auto expected = AffineTransform3<double>::from_trs(Vector3<double>(0.0, 0.0, 0.0), r, Vector3<double>(-2.0, 2.0, 2.0));
+    REQUIRE(mid.get_linear().almost_equal(expected.get_linear(), 1e-12));
+    REQUIRE(AffineTransform3<double>::interpolate(a, b, 0.0).get_linear().almost_equal(a.get_linear(), 1e-12));
+}
+
+TEST_CASE("Affine3 batch interpolate matches the scalar one", "[Affine3]"){
+    const auto a = AffineTransform3<float>::from_trs(Vector3<float>(1.0f, 2.0f, 3.0f),
+        Quaternion<float>(Vector3<float>(0.0f, 1.0f, 0.0f), Angle<in_radians, float>(0.2f)), Vector3<float>(1.0f, 2.0f, 1.5f));
+    const auto b = AffineTransform3<float>::from_trs(Vector3<float>(-4.0f, 0.0f, 1.0f),
+        Quaternion<float>(Vector3<float>(1.0f, 0.0f, 1.0f), Angle<in_radians, float>(2.9f)), Vector3<float>(0.5f, 2.0f, 1.0f));
+    const auto nearly_a = AffineTransform3<float>::from_trs(Vector3<float>(1.0f, 2.0f, 3.0f),
+        Quaternion<float>(Vector3<float>(0.0f, 1.0f, 0.0f), Angle<in_radians, float>(0.21f)), Vector3<float>(1.0f, 2.0f, 1.5f));
+
+    std::vector<float> ts;
+    for(int i = 0; i < 301; i++) ts.push_back(static_cast<float>(i) / 300.0f);
+    std::vector<AffineTransform3<float>> out(ts.size());
+    for(const auto& other : {b, nearly_a}){
+        AffineTransform3<float>::interpolate(a, other, ts, out);
+        for(std::size_t i = 0; i < ts.size(); i++){
+            const auto expected = AffineTransform3<float>::interpolate(a, other, ts[i]);
+            REQUIRE(out[i].get_linear().almost_equal(expected.get_linear(), 1e-5f));
+            REQUIRE(out[i].get_translation().almost_equal(expected.get_translation(), 1e-5f));
+        }
+    }
+}
+
+TEST_CASE("Affine3 interpolate 10k motion blur samples", "[Affine3][!benchmark]"){
+    const auto a = AffineTransform3<float>::from_trs(Vector3<float>(1.0f, 2.0f, 3.0f),
+        Quaternion<float>(Vector3<float>(0.0f, 1.0f, 0.0f), Angle<in_radians, float>(0.2f)), Vector3<float>(1.0f, 2.0f, 1.5f));
+    const auto b = AffineTransform3<float>::from_trs(Vector3<float>(-4.0f, 0.0f, 1.0f),
+        Quaternion<float>(Vector3<float>(1.0f, 0.0f, 1.0f), Angle<in_radians, float>(2.9f)), Vector3<float>(0.5f, 2.0f, 1.0f));
+    const std::size_t count = 10'000;
+    std::vector<float> ts(count);
+    for(std::size_t i = 0; i < count; i++) ts[i] = static_cast<float>(i) / static_cast<float>(count - 1);
+    std::vector<AffineTransform3<float>> out(count);
+
+    BENCHMARK("interpolate per sample"){
+        for(std::size_t i = 0; i < count; i++) out[i] = AffineTransform3<float>::interpolate(a, b, ts[i]);
+        return out[count - 1].get_translation()[0];
+    };
+    BENCHMARK("interpolate batch"){
+        AffineTransform3<float>::interpolate(a, b, ts, out);
+        return out[count - 1].get_translation()[0];
+    };
+}
@@ -1,5 +1,7 @@
 #include "../Angle.hpp"
 #include <catch2/catch_test_macros.hpp>
+#include <cmath>
+#include <vector>
 #include "ES_test_util.hpp"
 
 
@@ -50,3 +52,55 @@ TEST_CASE("template sanity crisis!","[Angle]") {
         static constexpr float w = AngleRad(AngleDeg{180.f}).get();
     }
 }
+
+TEST_CASE("wrap_to lands in [lower, upper)","[Angle]") {
+    DOUBLE_REQUIRE(ES::AngleRad{-0.5f}.wrap_to(0.f, 2.f*PIE).get() == 2.f*PIE - 0.5f);
+    DOUBLE_REQUIRE(ES::AngleDeg{540.f}.wrap_to(-180.f, 180.f).get() == -180.f);
+    DOUBLE_REQUIRE(ES::AngleDeg{-900.f}.normalize().get() == 180.f);
+    for (float x = -2000.f; x < 2000.f; x += 0.37f) {
+        const float wrapped = ES::AngleDeg{x}.wrap_to(-180.f, 180.f).get();
+        REQUIRE(wrapped >= -180.f);
+        REQUIRE(wrapped < 180.f);
+    }
+}
+
+//what wrapping is meant to give, spelled with std::fmod: exact however big x is, and never upper itself
+static float fmod_wrap(const float x, const float lower, const float upper) {
+    const float range = upper - lower;
+    float wrapped = std::fmod(x - lower, range);
+    wrapped = wrapped < 0.f ? wrapped + range : wrapped;
+    return (wrapped >= range ? 0.f : wrapped) + lower;
+}
+
+TEST_CASE("Wrapping agrees with fmod, normalizing stays in a turn","[Angle]") {
+    std::vector<ES::AngleRad> angles;
+    for (float x = -50.f; x < 50.f; x += 0.0917f) angles.emplace_back(x);
+    //a hair under a whole turn, and far enough out that range * floor(x / range) rounding loses the answer
+    for (const float x : {-1e-7f, 1e-7f, -2.f * PIE, 2.f * PIE, 1e7f, -1e7f, 123456.79f, -98765.43f}) angles.emplace_back(x);
+    std::vector<ES::AngleRad> wrapped = angles, normalized = angles;
+
+    ES::wrap_angles<ES::in_radians, float>(wrapped, -PIE, PIE);
+    ES::normalize_angles<ES::in_radians, float>(normalized);
+
+    for (std::size_t i = 0; i < angles.size(); i++) {
+        const float x = angles[i].get();
+        REQUIRE(wrapped[i].get() == fmod_wrap(x, -PIE, PIE));
+        REQUIRE(angles[i].wrap_to(-PIE, PIE).get() == fmod_wrap(x, -PIE, PIE));
+        //normalize keeps math::modulo's rounding for big x (see Coterminals!), so only the range is pinned down
+        REQUIRE(normalized[i].get() == angles[i].normalize().get());
+        REQUIRE(normalized[i].get() >= 0.f);
+        REQUIRE(normalized[i].get() < 2.f * PIE);
+    }
+}
+
+TEST_CASE("Batch wrapping converts units on the way","[Angle]") {
+    std::vector<ES::AngleDeg> degrees = {ES::AngleDeg{-90.f}, ES::AngleDeg{450.f}, ES::AngleDeg{180.f}, ES::AngleDeg{0.f}};
+    std::vector<ES::AngleRad> radians(degrees.size());
+
+    ES::wrap_angles<ES::in_radians, ES::in_degrees, float>(degrees, radians, -PIE, PIE);
+
+    REQUIRE(std::fabs(radians[0].get() + PIE / 2.f) < 1e-6f);
+    REQUIRE(std::fabs(radians[1].get() - PIE / 2.f) < 1e-6f);
+    REQUIRE(std::fabs(radians[2].get() + PIE) < 1e-6f);
+    REQUIRE(radians[3].get() == 0.f);
+}
@@ -2,6 +2,7 @@
 #include <catch2/catch_test_macros.hpp>
 #include "../ES_math.hpp"
 #include "../ColorN.hpp"
+#include <cmath>
 
 
 using namespace ES;
@@ -109,6 +110,20 @@ TEST_CASE("RGB to_srgb", "[RGB]") {
     REQUIRE(srgb[2] > 0.7f);
 }
 
+TEST_CASE("RGB float sRGB agrees with the 8 bit tables", "[RGB]") {
+    bool close = true;
+    for (int code = 0; code < 256; code++) {
+        const float encoded = code / 255.0f;
+        const RGB linear = RGB::from_srgb(code, code, code);
+        close = close && std::abs(RGB::from_srgb(encoded, encoded, encoded).G() - linear.G()) < 1e-6f;
+        close = close && std::abs(linear.to_srgb()[1] - encoded) < 1e-6f;
+        close = close && std::abs(RGBA::from_srgba(encoded, encoded, encoded, 1.0f).to_srgba()[2] - encoded) < 1e-6f;
+    }
+    REQUIRE(close);
+    REQUIRE(RGB_Int::from_srgb(1.0f, 0.0f, 0.5f).R() == 255);
+    REQUIRE(RGBA_Int::from_srgba(255, 0, 128, 255).G() == 0);
+}
+
 
 TEST_CASE("RGB_Int accesors checks", "[RGB_Int]"){
     auto rgb = RGB_Int(255,255,255);
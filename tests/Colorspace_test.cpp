@@ -0,0 +1,179 @@
+#define NDEBUG
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <algorithm>
+#include <cmath>
+#include "../ES_colorspace.hpp"
+#include "ES_test_util.hpp"
+
+using namespace ES;
+using color::convert;
+
+namespace {
+
+    using Studio601 = color::YCbCr<color::YCbCrMatrix::bt601, color::YCbCrRange::limited>;
+
+    //the furthest apart two colours are in any channel
+    float difference(const RGB& a, const RGB& b){
+        return std::max({std::abs(a.R() - b.R()), std::abs(a.G() - b.G()), std::abs(a.B() - b.B())});
+    }
+
+    //colours over the whole cube, the corners included
+    RGB sample(int i){
+        return RGB(static_cast<float>((i * 37) % 101) / 100.0f, static_cast<float>((i * 53) % 97) / 96.0f,
+                   static_cast<float>((i * 11) % 89) / 88.0f);
+    }
+
+    template <typename Space>
+    float worst_round_trip(){
+        float worst = 0.0f;
+        for(int i = 0; i < 20000; i++){
+            worst = std::max(worst, difference(convert<RGB>(convert<Space>(sample(i))), sample(i)));
+        }
+        return worst;
+    }
+
+}
+
+TEST_CASE("colorspace: known values", "[colorspace]"){
+    DOUBLE_REQUIRE(convert<color::HSV>(RGB(1.0f, 0.0f, 0.0f)).H == 0.0f);
+    DOUBLE_REQUIRE(std::abs(convert<color::HSV>(RGB(0.0f, 1.0f, 0.0f)).H - 120.0f) < 1e-4f);
+    DOUBLE_REQUIRE(std::abs(convert<color::HSL>(RGB(0.0f, 0.0f, 1.0f)).H - 240.0f) < 1e-4f);
+    DOUBLE_REQUIRE(convert<color::HSL>(RGB(1.0f, 1.0f, 1.0f)).S == 0.0f);
+    //grey has no hue and no saturation, and a linear 0.5 is 188 of 255 encoded
+    const color::HSV grey = convert<color::HSV>(RGB(0.5f, 0.5f, 0.5f));
+    REQUIRE((grey.H == 0.0f && grey.S == 0.0f));
+    REQUIRE(std::abs(grey.V * 255.0f - 187.5f) < 0.5f);
+
+    //D65 white
+    const color::XYZ white = convert<color::XYZ>(RGB(1.0f, 1.0f, 1.0f));
+    REQUIRE(std::abs(white.X - 0.95047f) < 1e-4f);
+    REQUIRE(std::abs(white.Y - 1.0f) < 1e-4f);
+    REQUIRE(std::abs(white.Z - 1.08883f) < 1e-4f);
+
+    //Ottosson's reference values
+    const color::Oklab ok_white = convert<color::Oklab>(RGB(1.0f, 1.0f, 1.0f));
+    REQUIRE(std::abs(ok_white.L - 1.0f) < 1e-4f);
+    REQUIRE(std::abs(ok_white.a) < 1e-4f);
+    REQUIRE(std::abs(ok_white.b) < 1e-4f);
+    const color::Oklab red = convert<color::Oklab>(RGB(1.0f, 0.0f, 0.0f));
+    REQUIRE(std::abs(red.L - 0.62796f) < 1e-4f);
+    REQUIRE(std::abs(red.a - 0.22486f) < 1e-4f);
+    REQUIRE(std::abs(red.b - 0.12585f) < 1e-4f);
+    REQUIRE(std::abs(convert<color::Oklch>(red).h - 29.234f) < 0.01f);
+
+    //8 bit codes of black, white and pure red in studio swing BT.601
+    const Studio601 black = convert<Studio601>(RGB(0.0f, 0.0f, 0.0f));
+    REQUIRE(std::abs(black.Y * 255.0f - 16.0f) < 1e-3f);
+    REQUIRE(std::abs(black.Cb * 255.0f - 128.0f) < 1e-3f);
+    REQUIRE(std::abs(convert<Studio601>(RGB(1.0f, 1.0f, 1.0f)).Y * 255.0f - 235.0f) < 1e-3f);
+    const Studio601 studio_red = convert<Studio601>(RGB(1.0f, 0.0f, 0.0f));
+    REQUIRE(std::abs(studio_red.Y * 255.0f - 81.481f) < 1e-2f);
+    REQUIRE(std::abs(studio_red.Cr * 255.0f - 240.0f) < 1e-2f);
+    const color::YCbCr<> full_white = convert<color::YCbCr<>>(RGB(1.0f, 1.0f, 1.0f));
+    REQUIRE((std::abs(full_white.Y - 1.0f) < 1e-5f && std::abs(full_white.Cb - 0.5f) < 1e-5f));
+}
+
+TEST_CASE("colorspace: round trips", "[colorspace]"){
+    REQUIRE(worst_round_trip<color::HSV>() < 1e-5f);
+    REQUIRE(worst_round_trip<color::HSL>() < 1e-5f);
+    REQUIRE(worst_round_trip<color::XYZ>() < 1e-5f);
+    REQUIRE(worst_round_trip<color::Oklab>() < 1e-5f);
+    REQUIRE(worst_round_trip<color::Oklch>() < 1e-5f);
+    REQUIRE(worst_round_trip<Studio601>() < 1e-5f);
+    REQUIRE(worst_round_trip<color::YCbCr<>>() < 1e-5f);
+
+    //space to space, and alpha along for the ride
+    const color::Oklch polar = convert<color::Oklch>(convert<color::HSV>(RGB(0.2f, 0.5f, 0.8f)));
+    REQUIRE(difference(convert<RGB>(polar), RGB(0.2f, 0.5f, 0.8f)) < 1e-5f);
+    const RGBA premultiplied(0.1f, 0.25f, 0.4f, 0.5f);
+    const auto straight = convert<color::WithAlpha<color::HSL>>(premultiplied);
+    REQUIRE(straight.A == 0.5f);
+    REQUIRE(difference(convert<RGB>(straight.colour), RGB(0.2f, 0.5f, 0.8f)) < 1e-5f);
+    const RGBA back = convert<RGBA>(straight);
+    REQUIRE(back.A() == 0.5f);
+    REQUIRE(difference(RGB(back.R(), back.G(), back.B()), RGB(0.1f, 0.25f, 0.4f)) < 1e-5f);
+    REQUIRE(convert<color::WithAlpha<color::Oklab>>(RGBA(0.0f, 0.0f, 0.0f, 0.0f)).colour.L == 0.0f);
+}
+
+TEST_CASE("colorspace: images", "[colorspace]"){
+    //odd width so rows end part way through a batch
+    Image<RGB> image(67, 45);
+    for(std::size_t y = 0; y < image.height(); y++){
+        for(std::size_t x = 0; x < image.width(); x++){
+            image(x, y) = sample(static_cast<int>(y * image.width() + x));
+        }
+    }
+    parallel::ThreadPool pool(3);
+    Image<color::Oklch> polar(67, 45);
+    color::convert(image, polar, pool);
+    Image<RGB> back(67, 45);
+    color::convert(polar.view(), back.view(), pool);
+    bool matches = true;
+    float worst = 0.0f;
+    for(std::size_t y = 0; y < image.height(); y++){
+        for(std::size_t x = 0; x < image.width(); x++){
+            const color::Oklch scalar = convert<color::Oklch>(image(x, y));
+            matches = matches && polar(x, y).L == scalar.L && polar(x, y).C == scalar.C && polar(x, y).h == scalar.h;
+            worst = std::max(worst, difference(back(x, y), image(x, y)));
+        }
+    }
+    REQUIRE(matches);
+    REQUIRE(worst < 1e-5f);
+
+    Image<RGBA> premultiplied(9, 4, RGBA(0.1f, 0.25f, 0.4f, 0.5f));
+    Image<color::WithAlpha<Studio601>> video(9, 4);
+    color::convert(premultiplied, video, pool);
+    REQUIRE(video(8, 3).A == 0.5f);
+    REQUIRE(std::abs(video(8, 3).colour.Y - convert<Studio601>(RGB(0.2f, 0.5f, 0.8f)).Y) < 1e-6f);
+}
+
+TEST_CASE("colorspace: fused adjustments", "[colorspace]"){
+    const RGB colour(0.2f, 0.5f, 0.8f);
+    //nothing changes nothing, a whole turn included
+    REQUIRE(difference(color::adjust(colour, {}), colour) < 1e-5f);
+    REQUIRE(difference(color::adjust(colour, {.hue = 360.0f}), colour) < 1e-5f);
+    //brightness is a scale of linear light, as adjust_brightness is
+    REQUIRE(difference(color::adjust(colour, {.brightness = 0.5f}), RGB(0.1f, 0.25f, 0.4f)) < 1e-5f);
+    //no saturation is grey of the same Oklab lightness
+    const color::Oklab grey = convert<color::Oklab>(color::adjust(colour, {.saturation = 0.0f}));
+    REQUIRE((std::abs(grey.a) < 1e-5f && std::abs(grey.b) < 1e-5f));
+    REQUIRE(std::abs(grey.L - convert<color::Oklab>(colour).L) < 1e-5f);
+    //hue turns Oklch hue and keeps lightness and chroma
+    const color::Oklch before = convert<color::Oklch>(colour);
+    const color::Oklch after = convert<color::Oklch>(color::adjust(colour, {.hue = 30.0f, .saturation = 0.5f}));
+    REQUIRE(std::abs(after.h - before.h - 30.0f) < 0.01f);
+    REQUIRE(std::abs(after.C - 0.5f * before.C) < 1e-5f);
+    REQUIRE(std::abs(after.L - before.L) < 1e-5f);
+
+    //premultiplied is the same as straight then premultiplied
+    const color::Adjustment edit{.hue = -45.0f, .saturation = 1.3f, .brightness = 0.8f};
+    const RGBA half = color::adjust(RGBA(0.1f, 0.25f, 0.4f, 0.5f), edit);
+    const RGB straight = color::adjust(colour, edit);
+    REQUIRE(half.A() == 0.5f);
+    REQUIRE(difference(RGB(half.R(), half.G(), half.B()), RGB(straight.R() * 0.5f, straight.G() * 0.5f, straight.B() * 0.5f)) < 1e-5f);
+
+    Image<RGBA> image(31, 17, RGBA(0.1f, 0.25f, 0.4f, 0.5f));
+    parallel::ThreadPool pool(2);
+    color::adjust(image, edit, pool);
+    REQUIRE(image(30, 16) == half);
+}
+
+TEST_CASE("colorspace benchmark", "[!benchmark][colorspace]"){
+    Image<RGB> frame(3840, 2160, RGB(0.25f, 0.5f, 0.125f));
+    Image<color::Oklab> lab(3840, 2160);
+    Image<color::YCbCr<>> video(3840, 2160);
+
+    BENCHMARK("4K RGB to Oklab"){
+        color::convert(frame, lab);
+        return lab(0, 0).L;
+    };
+    BENCHMARK("4K RGB to BT.709 YCbCr"){
+        color::convert(frame, video);
+        return video(0, 0).Y;
+    };
+    BENCHMARK("4K fused hue, saturation and brightness"){
+        color::adjust(frame, {.hue = 10.0f, .saturation = 1.1f, .brightness = 1.0f});
+        return frame(0, 0).R();
+    };
+}
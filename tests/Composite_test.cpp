@@ -0,0 +1,206 @@
+#define NDEBUG
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include "../ES_composite.hpp"
+
+using namespace ES;
+using composite::Blend;
+
+namespace {
+
+    constexpr Blend all_modes[] = {Blend::over, Blend::in, Blend::out, Blend::atop, Blend::exclusive_or, Blend::add, Blend::multiply, Blend::screen};
+
+    bool near(const RGBA& a, const RGBA& b, float tolerance = 1e-6f){
+        for(std::size_t c = 0; c < 4; c++){
+            if(std::abs(a[c] - b[c]) > tolerance){
+                return false;
+            }
+        }
+        return true;
+    }
+
+    //premultiplied: no channel above alpha
+    RGBA8 random_premultiplied(std::uint32_t& seed){
+        seed = seed * 1664525u + 1013904223u;
+        const std::uint8_t a = static_cast<std::uint8_t>(seed >> 24);
+        const auto channel = [&](int shift){ return static_cast<std::uint8_t>(((seed >> shift) & 0xff) * a / 255); };
+        return RGBA8(channel(0), channel(8), channel(16), a);
+    }
+
+    //left third opaque, middle third transparent, right third anything: every kind of tile, and tiles mixing them
+    template <typename Pixel, typename Make>
+    Image<Pixel> patchwork(std::size_t width, std::size_t height, Make make){
+        Image<Pixel> image(width, height);
+        std::uint32_t seed = 99;
+        for(std::size_t y = 0; y < height; y++){
+            for(std::size_t x = 0; x < width; x++){
+                RGBA8 p = random_premultiplied(seed);
+                if(x < width / 3){
+                    p.A = 255;
+                } else if(x < 2 * width / 3){
+                    p = RGBA8(0, 0, 0, 0);
+                }
+                image(x, y) = make(p);
+            }
+        }
+        return image;
+    }
+
+    RGBA to_float(const RGBA8& p){
+        return RGBA(p.R / 255.0f, p.G / 255.0f, p.B / 255.0f, p.A / 255.0f);
+    }
+}
+
+TEST_CASE("composite: pixel formulas", "[composite]"){
+    const RGBA red(1.0f, 0.0f, 0.0f, 1.0f);
+    const RGBA half_blue(0.0f, 0.0f, 0.5f, 0.5f);
+    const RGBA clear(0.0f, 0.0f, 0.0f, 0.0f);
+
+    STATIC_REQUIRE(composite::blend(RGBA(1.0f, 0.0f, 0.0f, 1.0f), RGBA(0.0f, 0.0f, 0.5f, 0.5f), Blend::over) == RGBA(1.0f, 0.0f, 0.0f, 1.0f));
+    REQUIRE(composite::blend(half_blue, red, Blend::over) == RGBA(0.5f, 0.0f, 0.5f, 1.0f));
+    REQUIRE(composite::blend(red, half_blue, Blend::in) == RGBA(0.5f, 0.0f, 0.0f, 0.5f));
+    REQUIRE(composite::blend(red, half_blue, Blend::out) == RGBA(0.5f, 0.0f, 0.0f, 0.5f));
+    REQUIRE(composite::blend(red, clear, Blend::in) == clear);
+    REQUIRE(composite::blend(red, half_blue, Blend::atop) == RGBA(0.5f, 0.0f, 0.0f, 0.5f));
+    REQUIRE(composite::blend(half_blue, red, Blend::atop) == RGBA(0.5f, 0.0f, 0.5f, 1.0f));
+    REQUIRE(composite::blend(red, half_blue, Blend::exclusive_or) == RGBA(0.5f, 0.0f, 0.0f, 0.5f));
+    REQUIRE(composite::blend(red, red, Blend::exclusive_or) == clear);
+    REQUIRE(composite::blend(red, half_blue, Blend::add) == RGBA(1.0f, 0.0f, 0.5f, 1.0f));
+    REQUIRE(composite::blend(RGBA(0.5f, 0.5f, 0.5f, 1.0f), RGBA(0.5f, 1.0f, 0.0f, 1.0f), Blend::multiply) == RGBA(0.25f, 0.5f, 0.0f, 1.0f));
+    REQUIRE(composite::blend(RGBA(0.5f, 0.5f, 0.5f, 1.0f), RGBA(0.5f, 1.0f, 0.0f, 1.0f), Blend::screen) == RGBA(0.75f, 1.0f, 0.5f, 1.0f));
+    //multiply over nothing is just the source
+    REQUIRE(composite::blend(half_blue, clear, Blend::multiply) == half_blue);
+
+    for(const Blend mode : all_modes){
+        REQUIRE(near(composite::blend(clear, half_blue, mode), mode == Blend::in || mode == Blend::out ? clear : half_blue));
+    }
+}
+
+TEST_CASE("composite: 8 bit fixed point", "[composite]"){
+    bool exact = true;
+    for(std::uint16_t a = 0; a < 256; a++){
+        for(std::uint16_t b = 0; b < 256; b++){
+            exact = exact && composite::Secret::FixedMath::mul(a, b) == static_cast<std::uint16_t>(std::lround(a * b / 255.0));
+        }
+    }
+    REQUIRE(exact);
+
+    STATIC_REQUIRE(composite::blend(RGBA8(0, 0, 128, 128), RGBA8(255, 0, 0, 255), Blend::over).R == 127);
+    STATIC_REQUIRE(composite::blend(RGBA8(0, 0, 128, 128), RGBA8(255, 0, 0, 255), Blend::over).A == 255);
+
+    //within a code of the float result, and never out of range, for every mode
+    std::uint32_t seed = 5;
+    bool close = true;
+    for(int i = 0; i < 20000; i++){
+        const RGBA8 s = random_premultiplied(seed);
+        const RGBA8 d = random_premultiplied(seed);
+        for(const Blend mode : all_modes){
+            const RGBA8 fixed = composite::blend(s, d, mode);
+            const RGBA exact_result = composite::blend(to_float(s), to_float(d), mode);
+            close = close && std::abs(fixed.R - exact_result.R() * 255.0f) <= 0.51f && std::abs(fixed.G - exact_result.G() * 255.0f) <= 0.51f
+                    && std::abs(fixed.B - exact_result.B() * 255.0f) <= 0.51f && std::abs(fixed.A - exact_result.A() * 255.0f) <= 0.51f;
+        }
+    }
+    REQUIRE(close);
+}
+
+TEST_CASE("composite: whole images match the pixel formulas", "[composite]"){
+    //not a multiple of the tile size either way
+    const std::size_t width = 200, height = 150;
+    const auto source8 = patchwork<RGBA8>(width, height, [](RGBA8 p){ return p; });
+    const auto source = patchwork<RGBA>(width, height, to_float);
+    std::uint32_t seed = 1234;
+    Image<RGBA8> background8(width, height);
+    for(std::size_t y = 0; y < height; y++){
+        for(std::size_t x = 0; x < width; x++){
+            background8(x, y) = random_premultiplied(seed);
+        }
+    }
+
+    for(const Blend mode : all_modes){
+        Image<RGBA8> destination8(background8);
+        composite::blend(source8, destination8, mode);
+        Image<RGBA> destination(width, height);
+        for(std::size_t y = 0; y < height; y++){
+            for(std::size_t x = 0; x < width; x++){
+                destination(x, y) = to_float(background8(x, y));
+            }
+        }
+        composite::blend(source, destination, mode);
+
+        bool same8 = true;
+        bool same = true;
+        for(std::size_t y = 0; y < height; y++){
+            for(std::size_t x = 0; x < width; x++){
+                const RGBA8 expected8 = composite::blend(source8(x, y), background8(x, y), mode);
+                const RGBA8 got8 = destination8(x, y);
+                same8 = same8 && got8.R == expected8.R && got8.G == expected8.G && got8.B == expected8.B && got8.A == expected8.A;
+                same = same && near(destination(x, y), composite::blend(source(x, y), to_float(background8(x, y)), mode));
+            }
+        }
+        REQUIRE(same8);
+        REQUIRE(same);
+    }
+}
+
+TEST_CASE("composite: colour with no alpha isn't skipped as transparent", "[composite]"){
+    //premultiplied light with nothing to cover: over and add still add it, the per pixel formulas say so
+    const Image<RGBA> light(composite::tile_size, composite::tile_size, RGBA(0.25f, 0.5f, 0.0f, 0.0f));
+    const Image<RGBA8> light8(composite::tile_size, composite::tile_size, RGBA8(64, 128, 0, 0));
+    const RGBA background(0.125f, 0.25f, 0.5f, 0.5f);
+    const RGBA8 background8(32, 64, 128, 128);
+    for(const Blend mode : all_modes){
+        Image<RGBA> destination(composite::tile_size, composite::tile_size, background);
+        composite::blend(light, destination, mode);
+        Image<RGBA8> destination8(composite::tile_size, composite::tile_size, background8);
+        composite::blend(light8, destination8, mode);
+        const RGBA expected = composite::blend(light(0, 0), background, mode);
+        const RGBA8 expected8 = composite::blend(light8(0, 0), background8, mode);
+        REQUIRE(near(destination(5, 7), expected));
+        const RGBA8 got8 = destination8(5, 7);
+        REQUIRE((got8.R == expected8.R && got8.G == expected8.G && got8.B == expected8.B && got8.A == expected8.A));
+    }
+}
+
+TEST_CASE("composite: premultiply and back", "[composite]"){
+    Image<RGBA8> image(3, 1);
+    image(0, 0) = RGBA8(200, 100, 50, 255);
+    image(1, 0) = RGBA8(200, 100, 50, 128);
+    image(2, 0) = RGBA8(200, 100, 50, 0);
+    composite::premultiply(image);
+    REQUIRE(image(0, 0).R == 200);
+    REQUIRE(image(1, 0).R == 100);
+    REQUIRE(image(1, 0).G == 50);
+    REQUIRE(image(2, 0).R == 0);
+    composite::unpremultiply(image);
+    REQUIRE(image(0, 0).R == 200);
+    REQUIRE(image(1, 0).R == 199);
+    REQUIRE(image(1, 0).B == 50);
+    REQUIRE(image(1, 0).A == 128);
+    REQUIRE(image(2, 0).A == 0);
+}
+
+TEST_CASE("composite benchmark", "[!benchmark][composite]"){
+    const std::size_t width = 3840, height = 2160;
+    const auto source8 = patchwork<RGBA8>(width, height, [](RGBA8 p){ return p; });
+    Image<RGBA8> destination8(width, height, RGBA8(10, 20, 30, 255));
+    const auto source = patchwork<RGBA>(width, height, to_float);
+    Image<RGBA> destination(width, height, RGBA(0.1f, 0.2f, 0.3f, 1.0f));
+
+    //a 4K frame, a third of it opaque, a third transparent
+    BENCHMARK("4K RGBA8 over"){
+        composite::blend(source8, destination8, Blend::over);
+        return destination8(0, 0).R;
+    };
+    BENCHMARK("4K RGBA8 multiply"){
+        composite::blend(source8, destination8, Blend::multiply);
+        return destination8(0, 0).R;
+    };
+    BENCHMARK("4K RGBA over"){
+        composite::blend(source, destination, Blend::over);
+        return destination(0, 0).R();
+    };
+}
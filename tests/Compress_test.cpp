@@ -0,0 +1,163 @@
+#define NDEBUG
+#include <catch2/catch_test_macros.hpp>
+#include <vector>
+#include "../ES_math.hpp"
+#include "../ES_random.hpp"
+#include "../VectorN.hpp"
+#include "../Quaternion.hpp"
+#include "../ES_compress.hpp"
+#include "ES_test_util.hpp"
+
+using namespace ES;
+
+namespace {
+    Quaternion<float> random_rotation(auto& rng){
+        //rejection sample a direction in 4D, then normalize, for a uniform rotation
+        while(true){
+            Quaternion<float> q(rng(), rng(), rng(), rng());
+            float len_squared = q.length_squared();
+            if(len_squared > 1e-4f && len_squared <= 1.0f){
+                return q.normalize();
+            }
+        }
+    }
+
+    //the largest component difference, after putting both in the same hemisphere
+    float component_error(const Quaternion<float>& a, Quaternion<float> b){
+        if(a.dot(b) < 0.0f) b = -b;
+        float worst = 0.0f;
+        for(std::size_t i = 0; i < 4; i++){
+            worst = std::max(worst, std::fabs(a[i] - b[i]));
+        }
+        return worst;
+    }
+
+    //angle of the rotation taking a to b, through asin of the difference's vector part as acos is hopeless near 1
+    float angular_error(const Quaternion<float>& a, const Quaternion<float>& b){
+        auto difference = a.conjugate() * b;
+        float sine = std::sqrt(difference.x() * difference.x() + difference.y() * difference.y() + difference.z() * difference.z());
+        return 2.0f * std::asin(std::min(1.0f, sine));
+    }
+
+    template <typename Codec>
+    float worst_component_error(std::size_t samples){
+        auto rng = random::easy_seeded_callable(1234u, -1.0f, 1.0f);
+        float worst = 0.0f;
+        for(std::size_t i = 0; i < samples; i++){
+            auto q = random_rotation(rng);
+            worst = std::max(worst, component_error(q, Codec::encode(q).decode()));
+        }
+        return worst;
+    }
+
+    template <typename Codec>
+    float worst_angular_error(std::size_t samples){
+        auto rng = random::easy_seeded_callable(4321u, -1.0f, 1.0f);
+        float worst = 0.0f;
+        for(std::size_t i = 0; i < samples; i++){
+            auto q = random_rotation(rng);
+            worst = std::max(worst, angular_error(q, Codec::encode(q).decode()));
+        }
+        return worst;
+    }
+}
+
+TEST_CASE("Quaternion codecs are as small as advertised", "[Compress]"){
+    STATIC_REQUIRE(sizeof(compress::SmallestThree32) == 4);
+    STATIC_REQUIRE(sizeof(compress::SmallestThree48) == 6);
+    STATIC_REQUIRE(sizeof(compress::SmallestThree64) == 8);
+    STATIC_REQUIRE(sizeof(compress::OctahedralAxisAngle32) == 4);
+    STATIC_REQUIRE(sizeof(compress::OctahedralAxisAngle48) == 6);
+}
+
+TEST_CASE("SmallestThree identity round trips exactly", "[Compress]"){
+    auto q = Quaternion<float>::identity();
+
+    REQUIRE(compress::SmallestThree32::encode(q).decode().almost_equal(q, 1e-6f));
+    REQUIRE(compress::SmallestThree48::encode(q).decode().almost_equal(q, 1e-6f));
+    REQUIRE(compress::SmallestThree64::encode(q).decode().almost_equal(q, 1e-6f));
+}
+
+TEST_CASE("SmallestThree drops each component in turn", "[Compress]"){
+    std::array<Quaternion<float>, 4> rotations = {
+        Quaternion<float>(0.9f, 0.1f, -0.3f, 0.2f).normalize(),
+        Quaternion<float>(0.1f, -0.9f, 0.3f, 0.2f).normalize(),
+        Quaternion<float>(-0.1f, 0.3f, 0.9f, -0.2f).normalize(),
+        Quaternion<float>(0.2f, 0.1f, -0.3f, -0.9f).normalize()};
+
+    for(const auto& q : rotations){
+        REQUIRE(component_error(q, compress::SmallestThree32::encode(q).decode()) <= compress::SmallestThree32::max_component_error);
+    }
+}
+
+TEST_CASE("SmallestThree32 error is bounded", "[Compress]"){
+    REQUIRE(worst_component_error<compress::SmallestThree32>(ENOUGH_ITERATIONS * 10) <= compress::SmallestThree32::max_component_error);
+}
+
+TEST_CASE("SmallestThree48 error is bounded", "[Compress]"){
+    REQUIRE(worst_component_error<compress::SmallestThree48>(ENOUGH_ITERATIONS * 10) <= compress::SmallestThree48::max_component_error);
+}
+
+TEST_CASE("SmallestThree64 error is bounded", "[Compress]"){
+    REQUIRE(worst_component_error<compress::SmallestThree64>(ENOUGH_ITERATIONS * 10) <= compress::SmallestThree64::max_component_error);
+}
+
+TEST_CASE("SmallestThree more bits means less error", "[Compress]"){
+    REQUIRE(compress::SmallestThree48::max_component_error < compress::SmallestThree32::max_component_error);
+    REQUIRE(compress::SmallestThree64::max_component_error < compress::SmallestThree48::max_component_error);
+}
+
+TEST_CASE("OctahedralAxisAngle identity round trips", "[Compress]"){
+    auto q = Quaternion<float>::identity();
+
+    REQUIRE(compress::OctahedralAxisAngle32::encode(q).decode().almost_equal(q, 1e-6f));
+    REQUIRE(compress::OctahedralAxisAngle48::encode(q).decode().almost_equal(q, 1e-6f));
+}
+
+TEST_CASE("OctahedralAxisAngle handles the lower hemisphere and a half turn", "[Compress]"){
+    Quaternion<float> down(Vector3<float>(0.3f, -0.2f, -1.0f), Angle<in_radians, float>(2.5f));
+    Quaternion<float> half_turn(Vector3<float>(0.0f, 1.0f, 0.0f), Angle<in_radians, float>(math::pi<float>));
+
+    REQUIRE(angular_error(down, compress::OctahedralAxisAngle48::encode(down).decode()) < 1e-3f);
+    REQUIRE(angular_error(half_turn, compress::OctahedralAxisAngle48::encode(half_turn).decode()) < 1e-3f);
+}
+
+TEST_CASE("OctahedralAxisAngle32 error is bounded", "[Compress]"){
+    REQUIRE(worst_angular_error<compress::OctahedralAxisAngle32>(ENOUGH_ITERATIONS * 10) < 0.01f);
+}
+
+TEST_CASE("OctahedralAxisAngle48 error is bounded", "[Compress]"){
+    REQUIRE(worst_angular_error<compress::OctahedralAxisAngle48>(ENOUGH_ITERATIONS * 10) < 5e-4f);
+}
+
+TEST_CASE("Batch encode and decode match the scalar codec", "[Compress]"){
+    auto rng = random::easy_seeded_callable(99u, -1.0f, 1.0f);
+    std::vector<Quaternion<float>> rotations(1001);
+    for(auto& q : rotations) q = random_rotation(rng);
+
+    std::vector<compress::SmallestThree48> encoded(rotations.size());
+    std::vector<Quaternion<float>> decoded(rotations.size());
+    compress::encode<compress::SmallestThree48>(rotations, encoded);
+    compress::decode<compress::SmallestThree48>(encoded, decoded);
+
+    for(std::size_t i = 0; i < rotations.size(); i++){
+        REQUIRE(encoded[i].bits == compress::SmallestThree48::encode(rotations[i]).bits);
+        REQUIRE(decoded[i].almost_equal(encoded[i].decode(), 0.0f));
+    }
+}
+
+TEST_CASE("Batch octahedral encode and decode match the scalar codec", "[Compress]"){
+    auto rng = random::easy_seeded_callable(7u, -1.0f, 1.0f);
+    std::vector<Quaternion<float>> rotations(37);
+    for(auto& q : rotations) q = random_rotation(rng);
+
+    std::vector<compress::OctahedralAxisAngle32> encoded(rotations.size());
+    std::vector<Quaternion<float>> decoded(rotations.size());
+    compress::encode<compress::OctahedralAxisAngle32>(rotations, encoded);
+    compress::decode<compress::OctahedralAxisAngle32>(encoded, decoded);
+
+    for(std::size_t i = 0; i < rotations.size(); i++){
+        REQUIRE(encoded[i].bits == compress::OctahedralAxisAngle32::encode(rotations[i]).bits);
+        REQUIRE(angular_error(decoded[i], rotations[i]) < 0.01f);
+    }
+}
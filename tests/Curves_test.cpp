@@ -0,0 +1,354 @@
+#define NDEBUG
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <cmath>
+#include <vector>
+#include "../ES_math.hpp"
+#include "../VectorN.hpp"
+#include "../PointN.hpp"
+#include "../Quaternion.hpp"
+#include "../Angle.hpp"
+#include "../ES_curves.hpp"
+
+using namespace ES;
+
+namespace {
+    using Point = PointN<float, 3>;
+    using Vec = VectorN<float, 3>;
+
+    bool close(const auto& a, const auto& b, float epsilon){
+        for(std::size_t k = 0; k < 3; k++){
+            if(std::fabs(a[k] - b[k]) > epsilon) return false;
+        }
+        return true;
+    }
+
+    //distance from p to the segment ab
+    float segment_distance(const Point& p, const Point& a, const Point& b){
+        Vec ab = b - a, ap = p - a;
+        const float length_squared = ab.dot(ab);
+        const float t = length_squared > 0.0f ? std::clamp(ap.dot(ab) / length_squared, 0.0f, 1.0f) : 0.0f;
+        return (ap - ab * t).magnitude();
+    }
+
+    std::vector<Point> path_points(){
+        return {Point(0.0f, 0.0f, 0.0f), Point(1.0f, 2.0f, 0.0f), Point(3.0f, 2.5f, 1.0f), Point(4.0f, 0.0f, 2.0f),
+                Point(6.0f, -1.0f, 2.0f), Point(6.5f, 1.0f, 0.5f), Point(9.0f, 1.0f, 0.0f)};
+    }
+}
+
+TEST_CASE("Bezier matches de Casteljau", "[Curves]"){
+    Point p0(0.0f, 0.0f, 0.0f), p1(1.0f, 3.0f, 0.0f), p2(4.0f, 3.0f, 1.0f), p3(5.0f, 0.0f, -1.0f);
+    auto cubic = curves::Cubic<Point>::bezier(p0, p1, p2, p3);
+
+    for(float t = 0.0f; t <= 1.0f; t += 0.125f){
+        auto a = p0.lerp(p1, t), b = p1.lerp(p2, t), c = p2.lerp(p3, t);
+        auto ab = a.lerp(b, t), bc = b.lerp(c, t);
+        REQUIRE(close(cubic.evaluate(t), ab.lerp(bc, t), 1e-5f));
+    }
+    auto controls = cubic.to_bezier();
+    REQUIRE(close(controls[1], p1, 1e-5f));
+    REQUIRE(close(controls[2], p2, 1e-5f));
+}
+
+TEST_CASE("Hermite hits its end points and tangents", "[Curves]"){
+    Vec p0(1.0f, 0.0f, 0.0f), p1(0.0f, 2.0f, 1.0f), m0(0.0f, 3.0f, 0.0f), m1(-2.0f, 0.0f, 1.0f);
+    auto cubic = curves::Cubic<Vec>::hermite(p0, m0, p1, m1);
+
+    REQUIRE(close(cubic.evaluate(0.0f), p0, 1e-6f));
+    REQUIRE(close(cubic.evaluate(1.0f), p1, 1e-6f));
+    REQUIRE(close(cubic.derivative(0.0f), m0, 1e-6f));
+    REQUIRE(close(cubic.derivative(1.0f), m1, 1e-5f));
+}
+
+TEST_CASE("Catmull-Rom passes through every point", "[Curves]"){
+    auto points = path_points();
+    for(float alpha : {0.0f, 0.5f, 1.0f}){
+        auto spline = curves::Spline<Point>::catmull_rom(points, alpha);
+        REQUIRE(spline.segment_count() == points.size() - 1);
+        for(std::size_t i = 0; i < points.size(); i++){
+            REQUIRE(close(spline.evaluate(static_cast<float>(i)), points[i], 1e-5f));
+        }
+        //both sides of an inner point head the same way (with uneven knots only the direction carries over in u)
+        for(std::size_t i = 1; i + 1 < points.size(); i++){
+            auto before = spline.segments()[i - 1].derivative(1.0f), after = spline.segments()[i].derivative(0.0f);
+            REQUIRE(close(before.normalize(), after.normalize(), 1e-4f));
+            if(alpha == 0.0f){
+                REQUIRE(close(before, after, 1e-4f));
+            }
+        }
+    }
+}
+
+TEST_CASE("Catmull-Rom survives repeated points", "[Curves]"){
+    std::vector<Point> points = {Point(0.0f, 0.0f, 0.0f), Point(0.0f, 0.0f, 0.0f), Point(1.0f, 1.0f, 0.0f), Point(1.0f, 1.0f, 0.0f)};
+    auto spline = curves::Spline<Point>::catmull_rom(points);
+    for(float u = 0.0f; u <= 3.0f; u += 0.1f){
+        auto p = spline.evaluate(u);
+        REQUIRE(std::isfinite(p[0]));
+        REQUIRE(std::isfinite(p[1]));
+    }
+}
+
+TEST_CASE("B-spline starts and ends on its end points and is C2", "[Curves]"){
+    auto points = path_points();
+    auto spline = curves::Spline<Point>::bspline(points);
+
+    REQUIRE(spline.segment_count() == points.size() + 1);
+    REQUIRE(close(spline.evaluate(0.0f), points.front(), 1e-5f));
+    REQUIRE(close(spline.evaluate(static_cast<float>(spline.segment_count())), points.back(), 1e-5f));
+    for(std::size_t i = 1; i < spline.segment_count(); i++){
+        REQUIRE(close(spline.segments()[i - 1].evaluate(1.0f), spline.segments()[i].evaluate(0.0f), 1e-5f));
+        REQUIRE(close(spline.segments()[i - 1].second_derivative(1.0f), spline.segments()[i].second_derivative(0.0f), 1e-4f));
+    }
+}
+
+TEST_CASE("Forward differencing matches direct evaluation", "[Curves]"){
+    auto cubic = curves::Cubic<Point>::bezier(Point(0.0f, 0.0f, 0.0f), Point(1.0f, 3.0f, 0.0f), Point(4.0f, 3.0f, 1.0f), Point(5.0f, 0.0f, -1.0f));
+    std::vector<Point> samples(257);
+    cubic.sample_uniform(samples);
+
+    for(std::size_t i = 0; i < samples.size(); i++){
+        REQUIRE(close(samples[i], cubic.evaluate(static_cast<float>(i) / 256.0f), 1e-4f));
+    }
+    REQUIRE(close(samples.back(), cubic.evaluate(1.0f), 0.0f));
+
+    auto spline = curves::Spline<Point>::catmull_rom(path_points());
+    std::vector<Point> spline_samples(8 * spline.segment_count() + 1);
+    spline.sample_uniform(8, spline_samples);
+    for(std::size_t i = 0; i < spline_samples.size(); i++){
+        REQUIRE(close(spline_samples[i], spline.evaluate(static_cast<float>(i) / 8.0f), 1e-4f));
+    }
+}
+
+TEST_CASE("Batch evaluation matches the scalar one", "[Curves]"){
+    auto spline = curves::Spline<Point>::catmull_rom(path_points());
+    std::vector<float> us;
+    for(float u = -0.5f; u < 7.0f; u += 0.0137f) us.push_back(u);
+    std::vector<Point> out(us.size());
+
+    spline.evaluate(us, out);
+    for(std::size_t i = 0; i < us.size(); i++){
+        REQUIRE(close(out[i], spline.evaluate(us[i]), 1e-6f));
+    }
+
+    const auto& cubic = spline.segments()[2];
+    std::vector<float> ts(us.size());
+    for(std::size_t i = 0; i < ts.size(); i++) ts[i] = us[i] / 7.0f;
+    cubic.evaluate(ts, out);
+    for(std::size_t i = 0; i < ts.size(); i++){
+        REQUIRE(close(out[i], cubic.evaluate(ts[i]), 1e-6f));
+    }
+}
+
+TEST_CASE("Flattening stays within tolerance", "[Curves]"){
+    auto spline = curves::Spline<Point>::catmull_rom(path_points());
+    for(float tolerance : {0.1f, 0.01f, 0.001f}){
+        std::vector<Point> polyline;
+        spline.flatten(tolerance, polyline);
+
+        REQUIRE(close(polyline.front(), path_points().front(), 1e-6f));
+        REQUIRE(close(polyline.back(), path_points().back(), 1e-5f));
+        for(float u = 0.0f; u <= 6.0f; u += 0.01f){
+            auto p = spline.evaluate(u);
+            float nearest = 1e9f;
+            for(std::size_t i = 1; i < polyline.size(); i++){
+                nearest = std::min(nearest, segment_distance(p, polyline[i - 1], polyline[i]));
+            }
+            REQUIRE(nearest <= tolerance * 1.01f + 1e-5f);
+        }
+    }
+}
+
+TEST_CASE("Flattening a straight line is one segment", "[Curves]"){
+    auto line = curves::Cubic<Point>::bezier(Point(0.0f, 0.0f, 0.0f), Point(1.0f, 1.0f, 1.0f), Point(2.0f, 2.0f, 2.0f), Point(3.0f, 3.0f, 3.0f));
+    std::vector<Point> polyline;
+    line.flatten(0.001f, polyline);
+    REQUIRE(polyline.size() == 2);
+}
+
+TEST_CASE("Arc length of a straight line and a circle", "[Curves]"){
+    auto line = curves::Spline<Vec>::bezier(std::vector<Vec>{Vec(0.0f, 0.0f, 0.0f), Vec(1.0f, 0.0f, 0.0f), Vec(3.0f, 0.0f, 0.0f), Vec(4.0f, 0.0f, 0.0f)});
+    REQUIRE(std::fabs(line.length() - 4.0f) < 1e-4f);
+    //uneven control points mean u is not distance, but the table fixes that
+    REQUIRE(std::fabs(line.evaluate_at_distance(1.0f)[0] - 1.0f) < 1e-3f);
+    REQUIRE(std::fabs(line.evaluate_at_distance(3.5f)[0] - 3.5f) < 1e-3f);
+
+    //quarter circles of radius 1, the standard 0.5523 handle length
+    constexpr float k = 0.5522847f;
+    std::vector<Vec> circle = {Vec(1.0f, 0.0f, 0.0f), Vec(1.0f, k, 0.0f), Vec(k, 1.0f, 0.0f), Vec(0.0f, 1.0f, 0.0f),
+                               Vec(-k, 1.0f, 0.0f), Vec(-1.0f, k, 0.0f), Vec(-1.0f, 0.0f, 0.0f)};
+    auto half = curves::Spline<Vec>::bezier(circle);
+    REQUIRE(std::fabs(half.length() - math::pi<float>) < 1e-3f);
+    auto quarter = half.evaluate_at_distance(math::pi<float> / 2.0f);
+    REQUIRE(std::fabs(quarter[0]) < 1e-3f);
+    REQUIRE(std::fabs(quarter[1] - 1.0f) < 1e-3f);
+}
+
+TEST_CASE("Sampling by distance is evenly spaced", "[Curves]"){
+    auto spline = curves::Spline<Point>::catmull_rom(path_points());
+    spline.build_arc_length_table(128);
+    std::vector<Point> samples(50);
+    spline.sample_by_distance(samples);
+
+    REQUIRE(close(samples.front(), path_points().front(), 1e-5f));
+    REQUIRE(close(samples.back(), path_points().back(), 1e-4f));
+    const float step = spline.length() / 49.0f;
+    for(std::size_t i = 1; i < samples.size(); i++){
+        //chords run a touch shorter than the arcs between them
+        const float chord = samples[i].distance(samples[i - 1]);
+        REQUIRE(chord <= step * 1.001f);
+        REQUIRE(chord >= step * 0.95f);
+    }
+    REQUIRE(std::fabs(spline.parameter_at_distance(spline.length()) - 6.0f) < 1e-5f);
+    REQUIRE(spline.parameter_at_distance(-1.0f) == 0.0f);
+}
+
+namespace {
+    using Quat = Quaternion<float>;
+
+    //q and -q are the same rotation
+    bool same_rotation(const Quat& a, const Quat& b, float epsilon){
+        return std::fabs(std::fabs(a.dot(b)) - 1.0f) < epsilon;
+    }
+
+    std::vector<Quat> camera_keys(){
+        return {
+            Quat(Vec(0.0f, 1.0f, 0.0f), Angle<in_radians, float>(0.0f)),
+            Quat(Vec(0.0f, 1.0f, 0.2f), Angle<in_radians, float>(0.9f)),
+            -Quat(Vec(1.0f, 0.3f, 0.0f), Angle<in_radians, float>(1.4f)), //other hemisphere on purpose
+            Quat(Vec(0.2f, -1.0f, 0.5f), Angle<in_radians, float>(2.2f)),
+            Quat(Vec(0.0f, 0.0f, 1.0f), Angle<in_radians, float>(0.4f)),
+        };
+    }
+
+    //angular velocity in the rotation's own frame, from a one sided difference
+    Vec body_rate(const Quat& from, const Quat& to, float h){
+        Quat delta = from.conjugate() * to;
+        if(delta.w() < 0.0f) delta = -delta;
+        return delta.log() * (2.0f / h);
+    }
+}
+
+TEST_CASE("QuaternionSpline passes through its keys", "[Curves]"){
+    const auto keys = camera_keys();
+    curves::QuaternionSpline<float> spline(keys);
+    REQUIRE(spline.segment_count() == 4);
+    for(std::size_t i = 0; i < keys.size(); i++){
+        REQUIRE(same_rotation(spline.evaluate(static_cast<float>(i)), keys[i], 1e-5f));
+    }
+    REQUIRE(same_rotation(spline.evaluate(-3.0f), keys.front(), 1e-6f));
+    REQUIRE(same_rotation(spline.evaluate(10.0f), keys.back(), 1e-5f));
+}
+
+TEST_CASE("QuaternionSpline of two keys is slerp", "[Curves]"){
+    const Quat a(Vec(0.0f, 1.0f, 0.0f), Angle<in_radians, float>(0.3f));
+    const Quat b(Vec(1.0f, 1.0f, 0.0f), Angle<in_radians, float>(1.9f));
+    const std::vector<Quat> keys{a, b};
+    curves::QuaternionSpline<float> spline(keys);
+    for(float t = 0.0f; t <= 1.0f; t += 0.125f){
+        REQUIRE(same_rotation(spline.evaluate(t), a.slerp(b, t), 1e-5f));
+    }
+}
+
+TEST_CASE("QuaternionSpline angular velocity is continuous through the keys", "[Curves]"){
+    curves::QuaternionSpline<double> spline_d(std::vector<Quaternion<double>>{
+        Quaternion<double>(VectorN<double, 3>(0.0, 1.0, 0.0), Angle<in_radians, double>(0.0)),
+        Quaternion<double>(VectorN<double, 3>(0.0, 1.0, 0.2), Angle<in_radians, double>(0.9)),
+        Quaternion<double>(VectorN<double, 3>(1.0, 0.3, 0.0), Angle<in_radians, double>(1.4)),
+        Quaternion<double>(VectorN<double, 3>(0.2, -1.0, 0.5), Angle<in_radians, double>(2.2)),
+    });
+    const double h = 1e-5;
+    for(double key = 1.0; key <= 2.0; key += 1.0){
+        const auto at = spline_d.evaluate(key);
+        auto before = at.conjugate() * spline_d.evaluate(key + h);
+        auto after = spline_d.evaluate(key - h).conjugate() * at;
+        if(before.dot(after) < 0.0) after = -after;
+        const auto rate_after = before.log() * (2.0 / h);
+        const auto rate_before = after.log() * (2.0 / h);
+        REQUIRE(rate_after.magnitude() > 0.1);
+        REQUIRE((rate_after - rate_before).magnitude() < 1e-3 * rate_after.magnitude());
+    }
+
+    //and a plain slerp chain is not, which is the point
+    const auto keys = camera_keys();
+    const Quat k1 = keys[1], k0 = keys[0], k2 = -keys[2];
+    const Vec slerp_before = body_rate(k0.slerp(k1, 1.0f - 1e-3f), k1, 1e-3f);
+    const Vec slerp_after = body_rate(k1, k1.slerp(k2, 1e-3f), 1e-3f);
+    REQUIRE((slerp_before - slerp_after).magnitude() > 0.1f);
+}
+
+TEST_CASE("QuaternionSpline batch matches the scalar one", "[Curves]"){
+    curves::QuaternionSpline<float> spline(camera_keys());
+    std::vector<float> us;
+    for(int i = 0; i < 203; i++) us.push_back(std::fmod(static_cast<float>(i) * 0.731f, 4.6f) - 0.3f); //out of order, off both ends
+    std::vector<Quat> out(us.size());
+    spline.evaluate(us, out);
+    for(std::size_t i = 0; i < us.size(); i++){
+        const Quat expected = spline.evaluate(us[i]);
+        for(std::size_t k = 0; k < 4; k++){
+            REQUIRE(std::fabs(out[i][k] - expected[k]) < 1e-5f);
+        }
+        REQUIRE(std::fabs(out[i].length() - 1.0f) < 1e-5f);
+    }
+
+    std::vector<Quat> frames(97);
+    spline.sample_uniform(frames);
+    REQUIRE(same_rotation(frames.front(), camera_keys().front(), 1e-6f));
+    REQUIRE(same_rotation(frames.back(), camera_keys().back(), 1e-5f));
+    REQUIRE(same_rotation(frames[24], spline.evaluate(1.0f), 1e-5f));
+}
+
+TEST_CASE("Curves 100k evaluations", "[Curves][!benchmark]"){
+    auto spline = curves::Spline<Point>::catmull_rom(path_points());
+    const std::size_t count = 100'000;
+    std::vector<float> us(count);
+    for(std::size_t i = 0; i < count; i++) us[i] = 6.0f * static_cast<float>(i) / static_cast<float>(count - 1);
+    std::vector<Point> out(count);
+
+    BENCHMARK("Spline::evaluate per point"){
+        for(std::size_t i = 0; i < count; i++){
+            out[i] = spline.evaluate(us[i]);
+        }
+        return out[count - 1][0];
+    };
+
+    BENCHMARK("Spline::evaluate batch"){
+        spline.evaluate(us, out);
+        return out[count - 1][0];
+    };
+
+    BENCHMARK("Spline::sample_uniform"){
+        spline.sample_uniform((count - 1) / 6, std::span<Point>(out).first((count - 1) / 6 * 6 + 1));
+        return out[0][0];
+    };
+}
+
+TEST_CASE("QuaternionSpline 100k samples", "[Curves][!benchmark]"){
+    const auto keys = camera_keys();
+    curves::QuaternionSpline<float> spline(keys);
+    const std::size_t count = 100'000;
+    std::vector<float> us(count);
+    for(std::size_t i = 0; i < count; i++) us[i] = 4.0f * static_cast<float>(i) / static_cast<float>(count - 1);
+    std::vector<Quat> out(count);
+
+    BENCHMARK("chained slerp per sample"){
+        for(std::size_t i = 0; i < count; i++){
+            const std::size_t key = std::min<std::size_t>(static_cast<std::size_t>(us[i]), 3);
+            out[i] = keys[key].slerp(keys[key + 1], us[i] - static_cast<float>(key));
+        }
+        return out[count - 1][0];
+    };
+
+    BENCHMARK("QuaternionSpline::evaluate per sample"){
+        for(std::size_t i = 0; i < count; i++){
+            out[i] = spline.evaluate(us[i]);
+        }
+        return out[count - 1][0];
+    };
+
+    BENCHMARK("QuaternionSpline::evaluate batch"){
+        spline.evaluate(us, out);
+        return out[count - 1][0];
+    };
+}
@@ -0,0 +1,235 @@
+#define NDEBUG
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+#include "../ES_dither.hpp"
+
+using namespace ES;
+using dither::Method;
+
+namespace {
+    constexpr Method all_methods[] = {Method::none, Method::bayer, Method::blue_noise, Method::floyd_steinberg, Method::floyd_steinberg_serpentine};
+
+    //a horizontal ramp in linear light, a little different on each channel
+    Image<RGB> ramp(std::size_t width, std::size_t height){
+        Image<RGB> image(width, height);
+        for(std::size_t y = 0; y < height; y++){
+            for(std::size_t x = 0; x < width; x++){
+                const float v = (static_cast<float>(x) + 0.5f) / static_cast<float>(width);
+                image(x, y) = RGB(v, v * 0.5f, 1.0f - v);
+            }
+        }
+        return image;
+    }
+
+    //the mean linear light of one channel of out
+    template<typename Pixel>
+    double mean_light(const Image<Pixel>& out, std::uint8_t Pixel::* channel){
+        double sum = 0.0;
+        for(std::size_t y = 0; y < out.height(); y++){
+            for(const Pixel& p : out.row(y)){
+                sum += srgb::to_linear(p.*channel);
+            }
+        }
+        return sum / static_cast<double>(out.width() * out.height());
+    }
+
+    template<typename Pixel>
+    bool same_bytes(const Image<Pixel>& a, const Image<Pixel>& b){
+        for(std::size_t y = 0; y < a.height(); y++){
+            const auto* ra = reinterpret_cast<const std::uint8_t*>(a.row(y).data());
+            const auto* rb = reinterpret_cast<const std::uint8_t*>(b.row(y).data());
+            if(!std::equal(ra, ra + a.width() * sizeof(Pixel), rb)){
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+TEST_CASE("dither: thresholds", "[dither]"){
+    //the Bayer matrix and the blue noise tile each use every rank once
+    std::vector<int> bayer_seen(64, 0);
+    for(std::size_t y = 0; y < dither::bayer_size; y++){
+        for(std::size_t x = 0; x < dither::bayer_size; x++){
+            bayer_seen[static_cast<std::size_t>(dither::bayer(x, y) * 64.0f)]++;
+        }
+    }
+    REQUIRE(std::all_of(bayer_seen.begin(), bayer_seen.end(), [](int n){ return n == 1; }));
+    static_assert(dither::bayer(0, 0) == 0.5f / 64.0f);
+    REQUIRE(dither::bayer(1, 1) == 16.5f / 64.0f);
+    REQUIRE(dither::bayer(9, 8) == dither::bayer(1, 0));
+
+    constexpr std::size_t n = dither::blue_noise_size * dither::blue_noise_size;
+    std::vector<int> noise_seen(n, 0);
+    for(std::size_t y = 0; y < dither::blue_noise_size; y++){
+        for(std::size_t x = 0; x < dither::blue_noise_size; x++){
+            noise_seen[static_cast<std::size_t>(dither::blue_noise(x, y) * static_cast<float>(n))]++;
+        }
+    }
+    REQUIRE(std::all_of(noise_seen.begin(), noise_seen.end(), [](int c){ return c == 1; }));
+    REQUIRE(dither::blue_noise(70, 3) == dither::blue_noise(6, 67));
+    //blue: the darkest tenth is spread out, hardly any of it touching
+    std::size_t touching = 0;
+    for(std::size_t y = 0; y < dither::blue_noise_size; y++){
+        for(std::size_t x = 0; x < dither::blue_noise_size; x++){
+            if(dither::blue_noise(x, y) < 0.1f){
+                touching += dither::blue_noise(x + 1, y) < 0.1f;
+                touching += dither::blue_noise(x, y + 1) < 0.1f;
+            }
+        }
+    }
+    REQUIRE(touching < 10);
+}
+
+TEST_CASE("dither: flat areas average to the right light", "[dither]"){
+    //linear 0.3 and 0.7 fall between sRGB codes
+    Image<RGB> flat(64, 64);
+    for(std::size_t y = 0; y < flat.height(); y++){
+        for(RGB& p : flat.row(y)){
+            p = RGB(0.3f, 0.003f, 0.7f);
+        }
+    }
+    parallel::ThreadPool pool(2);
+    for(const Method method : all_methods){
+        Image<RGB8> out(64, 64);
+        dither::to_srgb8(flat, out, method, pool);
+        const double tolerance = method == Method::none ? 0.01 : 0.0005;
+        REQUIRE(std::abs(mean_light(out, &RGB8::R) - 0.3) < tolerance);
+        REQUIRE(std::abs(mean_light(out, &RGB8::B) - 0.7) < tolerance);
+    }
+    //dithering uses the codes either side
+    Image<RGB8> out(64, 64);
+    dither::to_srgb8(flat, out, Method::blue_noise, pool);
+    std::uint8_t low = 255, high = 0;
+    for(std::size_t y = 0; y < out.height(); y++){
+        for(const RGB8& p : out.row(y)){
+            low = std::min(low, p.R);
+            high = std::max(high, p.R);
+        }
+    }
+    REQUIRE(high == low + 1);
+}
+
+TEST_CASE("dither: RGBA to straight alpha", "[dither]"){
+    Image<RGBA> in(32, 32);
+    for(std::size_t y = 0; y < in.height(); y++){
+        for(std::size_t x = 0; x < in.width(); x++){
+            //premultiplied: half covered linear 0.5 grey, and some fully transparent
+            in(x, y) = x < 8 ? RGBA(0.0f, 0.0f, 0.0f, 0.0f) : RGBA(0.25f, 0.25f, 0.25f, 0.5f);
+        }
+    }
+    for(const Method method : all_methods){
+        Image<RGBA8> out(32, 32);
+        dither::to_srgb8(in, out, method);
+        bool transparent = true;
+        double alpha = 0.0, grey = 0.0;
+        for(std::size_t y = 0; y < out.height(); y++){
+            for(std::size_t x = 0; x < out.width(); x++){
+                const RGBA8 p = out(x, y);
+                if(x < 8){
+                    transparent = transparent && p.R == 0 && p.G == 0 && p.A == 0;
+                } else {
+                    alpha += p.A;
+                    grey += srgb::to_linear(p.G);
+                }
+            }
+        }
+        REQUIRE(transparent);
+        REQUIRE(std::abs(alpha / (24.0 * 32.0) - 127.5) < 0.6);
+        REQUIRE(std::abs(grey / (24.0 * 32.0) - 0.5) < (method == Method::none ? 0.01 : 0.002));
+    }
+}
+
+TEST_CASE("dither: Floyd-Steinberg across threads is what one thread makes", "[dither]"){
+    const Image<RGB> in = ramp(157, 61);
+    parallel::ThreadPool inline_pool(0);
+    parallel::ThreadPool pool(3);
+    for(const Method method : {Method::floyd_steinberg, Method::floyd_steinberg_serpentine}){
+        Image<RGB8> alone(in.width(), in.height());
+        Image<RGB8> shared(in.width(), in.height());
+        dither::to_srgb8(in, alone, method, inline_pool);
+        dither::to_srgb8(in, shared, method, pool);
+        REQUIRE(same_bytes(alone, shared));
+    }
+    //a ramp keeps its light column by column
+    Image<RGB8> out(in.width(), in.height());
+    dither::to_srgb8(in, out, Method::floyd_steinberg, pool);
+    double worst = 0.0;
+    for(std::size_t x = 2; x < in.width() - 2; x++){
+        double sum = 0.0;
+        for(std::size_t y = 0; y < in.height(); y++){
+            sum += srgb::to_linear(out(x, y).R);
+        }
+        worst = std::max(worst, std::abs(sum / static_cast<double>(in.height()) - in(x, 0).R()));
+    }
+    REQUIRE(worst < 0.01);
+}
+
+TEST_CASE("dither: to a palette", "[dither]"){
+    //grey 128 between a black and white palette: about half and half, whatever the method that dithers
+    Image<RGBA8> in(48, 48);
+    for(std::size_t y = 0; y < in.height(); y++){
+        for(RGBA8& p : in.row(y)){
+            p = RGBA8(128, 128, 128, 255);
+        }
+    }
+    const RGBA8 black_white[] = {RGBA8(0, 0, 0, 255), RGBA8(255, 255, 255, 255)};
+    parallel::ThreadPool pool(3);
+    for(const Method method : all_methods){
+        Image<std::uint8_t> out(in.width(), in.height());
+        dither::to_palette(in, out, black_white, method, pool);
+        std::size_t white = 0;
+        for(std::size_t y = 0; y < out.height(); y++){
+            for(const std::uint8_t i : out.row(y)){
+                white += i;
+            }
+        }
+        const double fraction = static_cast<double>(white) / static_cast<double>(in.width() * in.height());
+        if(method == Method::none){
+            REQUIRE(fraction == 1.0);
+        } else {
+            REQUIRE(std::abs(fraction - 128.0 / 255.0) < 0.02);
+        }
+    }
+    //pipelined diffusion to a palette matches one thread too
+    Image<RGBA8> colourful(97, 33);
+    for(std::size_t y = 0; y < colourful.height(); y++){
+        for(std::size_t x = 0; x < colourful.width(); x++){
+            colourful(x, y) = RGBA8(static_cast<std::uint8_t>(x * 2), static_cast<std::uint8_t>(y * 7), 77, 255);
+        }
+    }
+    const std::vector<RGBA8> palette = palette::generate(colourful, 8);
+    Image<std::uint8_t> alone(97, 33), shared(97, 33);
+    parallel::ThreadPool inline_pool(0);
+    dither::to_palette(colourful, alone, palette, Method::floyd_steinberg, inline_pool);
+    dither::to_palette(colourful, shared, palette, Method::floyd_steinberg, pool);
+    REQUIRE(same_bytes(alone, shared));
+}
+
+TEST_CASE("dither benchmark", "[!benchmark][dither]"){
+    const Image<RGB> in = ramp(1920, 1080);
+    Image<RGB8> out(1920, 1080);
+    parallel::ThreadPool inline_pool(0);
+    (void)dither::blue_noise(0, 0);
+
+    BENCHMARK("1080p blue noise to RGB8"){
+        dither::to_srgb8(in, out, Method::blue_noise);
+        return out(0, 0).R;
+    };
+    BENCHMARK("1080p Floyd-Steinberg to RGB8, one thread"){
+        dither::to_srgb8(in, out, Method::floyd_steinberg, inline_pool);
+        return out(0, 0).R;
+    };
+    BENCHMARK("1080p Floyd-Steinberg to RGB8, row pipelined"){
+        dither::to_srgb8(in, out, Method::floyd_steinberg);
+        return out(0, 0).R;
+    };
+    BENCHMARK("1080p serpentine Floyd-Steinberg to RGB8"){
+        dither::to_srgb8(in, out, Method::floyd_steinberg_serpentine);
+        return out(0, 0).R;
+    };
+}
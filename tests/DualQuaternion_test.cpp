@@ -0,0 +1,181 @@
+#define NDEBUG
+#include <catch2/catch_test_macros.hpp>
+#include <vector>
+#include "../ES_math.hpp"
+#include "../VectorN.hpp"
+#include "../Quaternion.hpp"
+#include "../AffineTransform3.hpp"
+#include "../DualQuaternion.hpp"
+#include "../Skinning.hpp"
+
+using namespace ES;
+
+TEST_CASE("DualQuaternion default constructor is identity", "[DualQuaternion]"){
+    DualQuaternion<float> dq;
+    Vector3<float> p(1.0f, 2.0f, 3.0f);
+
+    auto result = dq.transform_point(p);
+
+    REQUIRE(result.almost_equal(p));
+    REQUIRE(dq.get_translation().almost_equal(Vector3<float>(0.0f, 0.0f, 0.0f)));
+}
+
+TEST_CASE("DualQuaternion from_translation", "[DualQuaternion]"){
+    auto dq = DualQuaternion<float>::from_translation(Vector3<float>(1.0f, 2.0f, 3.0f));
+
+    REQUIRE(dq.get_translation().almost_equal(Vector3<float>(1.0f, 2.0f, 3.0f)));
+    REQUIRE(dq.transform_point(Vector3<float>(1.0f, 1.0f, 1.0f)).almost_equal(Vector3<float>(2.0f, 3.0f, 4.0f)));
+    REQUIRE(dq.transform_vector(Vector3<float>(1.0f, 1.0f, 1.0f)).almost_equal(Vector3<float>(1.0f, 1.0f, 1.0f)));
+}
+
+TEST_CASE("DualQuaternion from_rotation_translation rotates then translates", "[DualQuaternion]"){
+    Quaternion<float> rot(Vector3<float>(0.0f, 0.0f, 1.0f), Angle<in_radians, float>(math::half_pi<float>));
+    auto dq = DualQuaternion<float>::from_rotation_translation(rot, Vector3<float>(10.0f, 0.0f, 0.0f));
+
+    auto result = dq.transform_point(Vector3<float>(1.0f, 0.0f, 0.0f));
+
+    REQUIRE(result.almost_equal(Vector3<float>(10.0f, 1.0f, 0.0f), 1e-4f));
+    REQUIRE(dq.get_translation().almost_equal(Vector3<float>(10.0f, 0.0f, 0.0f), 1e-4f));
+}
+
+TEST_CASE("DualQuaternion multiplication composes like matrices", "[DualQuaternion]"){
+    Quaternion<float> rot(Vector3<float>(0.0f, 1.0f, 0.0f), Angle<in_radians, float>(0.7f));
+    auto a = DualQuaternion<float>::from_rotation_translation(rot, Vector3<float>(1.0f, 2.0f, 3.0f));
+    auto b = DualQuaternion<float>::from_translation(Vector3<float>(-4.0f, 0.5f, 2.0f));
+    Vector3<float> p(0.3f, -1.0f, 2.0f);
+
+    auto composed = (a * b).transform_point(p);
+    auto sequential = a.transform_point(b.transform_point(p));
+
+    REQUIRE(composed.almost_equal(sequential, 1e-4f));
+
+    auto in_place = a;
+    in_place *= b;
+    REQUIRE(in_place.almost_equal(a * b));
+}
+
+TEST_CASE("DualQuaternion inverse undoes the transform", "[DualQuaternion]"){
+    Quaternion<float> rot(Vector3<float>(1.0f, 1.0f, 0.0f), Angle<in_radians, float>(1.1f));
+    auto dq = DualQuaternion<float>::from_rotation_translation(rot, Vector3<float>(5.0f, -2.0f, 1.0f));
+    Vector3<float> p(1.0f, 2.0f, 3.0f);
+
+    auto back = dq.inverse().transform_point(dq.transform_point(p));
+
+    REQUIRE(back.almost_equal(p, 1e-4f));
+}
+
+TEST_CASE("DualQuaternion normalize restores a unit rigid transform", "[DualQuaternion]"){
+    Quaternion<float> rot(Vector3<float>(0.0f, 0.0f, 1.0f), Angle<in_radians, float>(0.4f));
+    auto dq = DualQuaternion<float>::from_rotation_translation(rot, Vector3<float>(1.0f, 0.0f, 0.0f));
+    auto scaled = dq * 3.0f;
+
+    auto normalized = scaled.normalize();
+
+    REQUIRE(math::approx_equal(normalized.length(), 1.0f));
+    REQUIRE(math::approx_equal(normalized.real().dot(normalized.dual()), 0.0f));
+    REQUIRE(normalized.almost_equal(dq, 1e-5f));
+}
+
+TEST_CASE("DualQuaternion blend endpoints and midpoint", "[DualQuaternion]"){
+    auto a = DualQuaternion<float>::from_translation(Vector3<float>(0.0f, 0.0f, 0.0f));
+    auto b = DualQuaternion<float>::from_translation(Vector3<float>(2.0f, 4.0f, 0.0f));
+
+    REQUIRE(a.blend(b, 0.0f).almost_equal(a));
+    REQUIRE(a.blend(b, 1.0f).almost_equal(b));
+    REQUIRE(a.blend(b, 0.5f).get_translation().almost_equal(Vector3<float>(1.0f, 2.0f, 0.0f), 1e-5f));
+}
+
+TEST_CASE("DualQuaternion blend takes the short way around", "[DualQuaternion]"){
+    Quaternion<float> rot(Vector3<float>(0.0f, 0.0f, 1.0f), Angle<in_radians, float>(0.5f));
+    auto a = DualQuaternion<float>::from_rotation(rot);
+    auto flipped = -a; //same rotation, other hemisphere
+
+    auto blended = a.blend(flipped, 0.5f);
+    Vector3<float> p(1.0f, 0.0f, 0.0f);
+
+    REQUIRE(blended.transform_point(p).almost_equal(a.transform_point(p), 1e-5f));
+}
+
+TEST_CASE("DualQuaternion span blend keeps rigidity", "[DualQuaternion]"){
+    Quaternion<float> rot_a(Vector3<float>(1.0f, 0.0f, 0.0f), Angle<in_radians, float>(0.0f));
+    Quaternion<float> rot_b(Vector3<float>(1.0f, 0.0f, 0.0f), Angle<in_radians, float>(math::pi<float>));
+    std::vector<DualQuaternion<float>> dqs = {DualQuaternion<float>::from_rotation(rot_a), DualQuaternion<float>::from_rotation(rot_b)};
+    std::vector<float> weights = {0.5f, 0.5f};
+
+    auto blended = DualQuaternion<float>::blend(std::span<const DualQuaternion<float>>(dqs), std::span<const float>(weights));
+    Vector3<float> p(0.0f, 1.0f, 0.0f);
+
+    //a 90 degree twist, where a blended matrix would have squashed the point onto the axis
+    REQUIRE(math::approx_equal(blended.transform_point(p).magnitude(), 1.0f, 1e-5f));
+}
+
+TEST_CASE("DualQuaternion round trips through AffineTransform3", "[DualQuaternion]"){
+    Quaternion<float> rot(Vector3<float>(0.2f, 1.0f, -0.5f), Angle<in_radians, float>(2.0f));
+    auto dq = DualQuaternion<float>::from_rotation_translation(rot, Vector3<float>(3.0f, -1.0f, 0.5f));
+    Vector3<float> p(1.0f, -2.0f, 4.0f);
+
+    auto affine = dq.to_affine();
+    REQUIRE(affine.transform_point(p).almost_equal(dq.transform_point(p), 1e-4f));
+
+    auto back = DualQuaternion<float>::from_affine(affine);
+    REQUIRE(back.transform_point(p).almost_equal(dq.transform_point(p), 1e-4f));
+}
+
+TEST_CASE("DualQuaternion from_affine strips scale", "[DualQuaternion]"){
+    auto affine = AffineTransform3<float>::from_scale(Vector3<float>(2.0f, 2.0f, 2.0f)) ;
+    auto moved = AffineTransform3<float>::from_translation(Vector3<float>(1.0f, 0.0f, 0.0f)) * affine;
+
+    auto dq = DualQuaternion<float>::from_affine(moved);
+
+    REQUIRE(dq.transform_point(Vector3<float>(1.0f, 1.0f, 1.0f)).almost_equal(Vector3<float>(2.0f, 1.0f, 1.0f), 1e-5f));
+}
+
+TEST_CASE("Dual quaternion skinning matches the scalar blend", "[DualQuaternion][Skinning]"){
+    std::vector<DualQuaternion<float>> palette;
+    for(int i = 0; i < 6; i++){
+        Quaternion<float> rot(Vector3<float>(0.3f * i, 1.0f, 0.5f), Angle<in_radians, float>(0.4f * i));
+        palette.push_back(DualQuaternion<float>::from_rotation_translation(rot, Vector3<float>(float(i), -0.5f * i, 0.25f)));
+    }
+
+    const std::size_t vertex_count = 5003; //deliberately not a multiple of any lane or chunk width
+    std::vector<Vector3<float>> positions(vertex_count), normals(vertex_count);
+    std::vector<skinning::VertexInfluences<>> influences(vertex_count);
+    for(std::size_t v = 0; v < vertex_count; v++){
+        positions[v] = Vector3<float>(float(v % 17), float(v % 5) * 0.5f, float(v % 3));
+        normals[v] = Vector3<float>(0.0f, 1.0f, 0.0f);
+        auto& inf = influences[v];
+        inf.bones = {std::uint16_t(v % 6), std::uint16_t((v + 1) % 6), std::uint16_t((v + 3) % 6), 0};
+        inf.weights = {0.5f, 0.3f, 0.2f, 0.0f};
+    }
+
+    std::vector<Vector3<float>> out_positions(vertex_count), out_normals(vertex_count);
+    skinning::skin_dual_quaternion<float, std::uint16_t>(palette, influences, positions, out_positions, normals, out_normals);
+
+    for(std::size_t v = 0; v < vertex_count; v += 97){
+        const auto& inf = influences[v];
+        std::array<DualQuaternion<float>, 4> dqs;
+        for(std::size_t k = 0; k < 4; k++){
+            dqs[k] = palette[inf.bones[k]];
+        }
+        auto blended = DualQuaternion<float>::blend(std::span<const DualQuaternion<float>>(dqs), std::span<const float>(inf.weights));
+
+        REQUIRE(out_positions[v].almost_equal(blended.transform_point(positions[v]), 1e-4f));
+        REQUIRE(out_normals[v].almost_equal(blended.transform_vector(normals[v]), 1e-4f));
+    }
+}
+
+TEST_CASE("Dual quaternion skinning without normals", "[DualQuaternion][Skinning]"){
+    std::vector<DualQuaternion<float>> palette = {DualQuaternion<float>::from_translation(Vector3<float>(0.0f, 1.0f, 0.0f))};
+    std::vector<Vector3<float>> positions(3, Vector3<float>(1.0f, 1.0f, 1.0f));
+    std::vector<skinning::VertexInfluences<std::uint8_t>> influences(3);
+    for(auto& inf : influences){
+        inf.weights = {1.0f, 0.0f, 0.0f, 0.0f};
+    }
+    std::vector<Vector3<float>> out_positions(3);
+
+    skinning::skin_dual_quaternion<float, std::uint8_t>(palette, influences, positions, out_positions);
+
+    for(const auto& p : out_positions){
+        REQUIRE(p.almost_equal(Vector3<float>(1.0f, 2.0f, 1.0f)));
+    }
+}
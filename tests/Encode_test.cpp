@@ -0,0 +1,318 @@
+#define NDEBUG
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "../ColorN.hpp"
+#include "../Image.hpp"
+#include "../ES_io.hpp"
+#include "../ES_png.hpp"
+#include "../ES_qoi.hpp"
+#include "../ES_pnm.hpp"
+
+using namespace ES;
+
+namespace {
+
+    //flat areas, gradients, noise and a few exact repeats, so every QOI op and plenty of deflate matches turn up
+    Image<RGBA8> test_card(std::size_t width, std::size_t height){
+        Image<RGBA8> image(width, height);
+        std::uint32_t seed = 7;
+        for(std::size_t y = 0; y < height; y++){
+            for(std::size_t x = 0; x < width; x++){
+                seed = seed * 1664525u + 1013904223u;
+                RGBA8 p;
+                if(y < height / 4){
+                    p = RGBA8(10, 20, 30, 255);
+                } else if(y < height / 2){
+                    p = RGBA8(std::uint8_t(x), std::uint8_t(y), std::uint8_t(x + y), std::uint8_t(x % 7 == 0 ? 128 : 255));
+                } else if(x < width / 2){
+                    p = RGBA8(std::uint8_t(seed >> 24), std::uint8_t(seed >> 16), std::uint8_t(seed >> 8), 255);
+                } else {
+                    const std::uint8_t v = std::uint8_t((x / 3) % 5 * 40);
+                    p = RGBA8(v, v, std::uint8_t(255 - v), 255);
+                }
+                image(x, y) = p;
+            }
+        }
+        return image;
+    }
+
+    Image<RGB8> without_alpha(const Image<RGBA8>& image){
+        Image<RGB8> rgb(image.width(), image.height());
+        for(std::size_t y = 0; y < image.height(); y++){
+            for(std::size_t x = 0; x < image.width(); x++){
+                rgb(x, y) = RGB8(image(x, y).R, image(x, y).G, image(x, y).B);
+            }
+        }
+        return rgb;
+    }
+
+    template <typename Pixel>
+    bool same_pixels(const Image<Pixel>& a, const Image<Pixel>& b){
+        if(a.width() != b.width() || a.height() != b.height()){
+            return false;
+        }
+        for(std::size_t y = 0; y < a.height(); y++){
+            if(std::memcmp(a.row(y).data(), b.row(y).data(), a.width() * sizeof(Pixel)) != 0){
+                return false;
+            }
+        }
+        return true;
+    }
+
+    //the reference decoder from the QOI spec, to check the encoder against
+    Image<RGBA8> qoi_decode(const std::vector<std::uint8_t>& bytes){
+        const auto be32 = [&](std::size_t at){
+            return (std::uint32_t(bytes[at]) << 24) | (std::uint32_t(bytes[at + 1]) << 16) | (std::uint32_t(bytes[at + 2]) << 8) | bytes[at + 3];
+        };
+        const std::size_t width = be32(4), height = be32(8);
+        Image<RGBA8> image(width, height);
+        std::array<RGBA8, 64> cache{};
+        RGBA8 p(0, 0, 0, 255);
+        std::size_t at = 14;
+        int run = 0;
+        for(std::size_t i = 0; i < width * height; i++){
+            if(run > 0){
+                run--;
+            } else {
+                const std::uint8_t op = bytes[at++];
+                if(op == 0xfe){
+                    p.R = bytes[at++]; p.G = bytes[at++]; p.B = bytes[at++];
+                } else if(op == 0xff){
+                    p.R = bytes[at++]; p.G = bytes[at++]; p.B = bytes[at++]; p.A = bytes[at++];
+                } else if((op & 0xc0) == 0x00){
+                    p = cache[op];
+                } else if((op & 0xc0) == 0x40){
+                    p.R += ((op >> 4) & 3) - 2; p.G += ((op >> 2) & 3) - 2; p.B += (op & 3) - 2;
+                } else if((op & 0xc0) == 0x80){
+                    const std::uint8_t second = bytes[at++];
+                    const int vg = (op & 0x3f) - 32;
+                    p.R += vg - 8 + ((second >> 4) & 15); p.G += vg; p.B += vg - 8 + (second & 15);
+                } else {
+                    run = op & 0x3f;
+                }
+                cache[(p.R * 3 + p.G * 5 + p.B * 7 + p.A * 11) % 64] = p;
+            }
+            image(i % width, i / width) = p;
+        }
+        return image;
+    }
+}
+
+TEST_CASE("zlib: deflate_fast round trips through inflate", "[encode]"){
+    std::vector<std::uint8_t> raw;
+    for(std::uint32_t i = 0; i < 200000; i++){
+        raw.push_back(static_cast<std::uint8_t>(i % 1000 < 500 ? (i * 7) >> 3 : (i * 2654435761u) >> 24));
+    }
+    for(const std::size_t size : {std::size_t{0}, std::size_t{1}, std::size_t{3}, std::size_t{4}, std::size_t{9}, std::size_t{70000}, raw.size()}){
+        const std::span<const std::uint8_t> in(raw.data(), size);
+        std::vector<std::uint8_t> compressed;
+        zlib::deflate(in, compressed);
+        std::vector<std::uint8_t> out;
+        REQUIRE(zlib::inflate(compressed, out) == zlib::Status::ok);
+        REQUIRE(std::equal(out.begin(), out.end(), in.begin(), in.end()));
+    }
+
+    //pieces compressed on their own still make one stream
+    std::vector<std::uint8_t> stitched = {0x78, 0x01};
+    zlib::deflate_fast(std::span(raw).first(1000), stitched, false);
+    zlib::deflate_fast(std::span(raw).subspan(1000, 50000), stitched, false);
+    zlib::deflate_fast(std::span(raw).subspan(51000), stitched, true);
+    std::vector<std::uint8_t> out;
+    REQUIRE(zlib::inflate(stitched, out) == zlib::Status::ok);
+    REQUIRE(out == raw);
+}
+
+TEST_CASE("zlib: checksums", "[encode]"){
+    const std::string check = "123456789";
+    const std::span bytes(reinterpret_cast<const std::uint8_t*>(check.data()), check.size());
+    REQUIRE(zlib::crc32(bytes) == 0xcbf43926u);
+    REQUIRE(zlib::crc32(bytes.subspan(4), zlib::crc32(bytes.first(4))) == 0xcbf43926u);
+
+    const std::string wikipedia = "Wikipedia";
+    const std::span wiki(reinterpret_cast<const std::uint8_t*>(wikipedia.data()), wikipedia.size());
+    REQUIRE(zlib::adler32(wiki) == 0x11e60398u);
+    REQUIRE(zlib::adler32_combine(zlib::adler32(wiki.first(3)), zlib::adler32(wiki.subspan(3)), 6) == 0x11e60398u);
+
+    std::vector<std::uint8_t> long_run(100000, 255);
+    REQUIRE(zlib::adler32_combine(zlib::adler32(std::span(long_run).first(30000)), zlib::adler32(std::span(long_run).subspan(30000)), 70000)
+            == zlib::adler32(long_run));
+}
+
+TEST_CASE("png: encoded images decode to the same pixels", "[encode]"){
+    //tall enough for several bands, so several IDAT chunks and stitched deflate pieces
+    const Image<RGBA8> card = test_card(300, 700);
+    std::vector<std::uint8_t> file;
+    io::MemorySink sink{file};
+    REQUIRE(png::encode(card, sink));
+    Image<RGBA8> decoded;
+    REQUIRE(png::decode(file, decoded) == png::Error::none);
+    REQUIRE(same_pixels(card, decoded));
+
+    const Image<RGB8> rgb = without_alpha(card);
+    std::vector<std::uint8_t> rgb_file;
+    io::MemorySink rgb_sink{rgb_file};
+    REQUIRE(png::encode(rgb.subview(0, 0, 300, 700), rgb_sink));
+    png::Info info;
+    REQUIRE(png::read_info(rgb_file, info) == png::Error::none);
+    REQUIRE(info.color_type == png::ColorType::rgb);
+    Image<RGB8> rgb_decoded;
+    REQUIRE(png::decode(rgb_file, rgb_decoded) == png::Error::none);
+    REQUIRE(same_pixels(rgb, rgb_decoded));
+    REQUIRE(rgb_file.size() < 300 * 700 * 3);
+}
+
+TEST_CASE("qoi: encoded images decode to the same pixels, bands and all", "[encode]"){
+    //bands of 218 rows: runs, cache hits and the flat top quarter all cross band boundaries
+    const Image<RGBA8> card = test_card(300, 1000);
+    std::vector<std::uint8_t> file;
+    io::MemorySink sink{file};
+    REQUIRE(qoi::encode(card, sink));
+    REQUIRE(std::string(file.begin(), file.begin() + 4) == "qoif");
+    REQUIRE(file[12] == 4);
+    REQUIRE(std::equal(file.end() - 8, file.end(), std::array<std::uint8_t, 8>{0, 0, 0, 0, 0, 0, 0, 1}.begin()));
+    REQUIRE(same_pixels(card, qoi_decode(file)));
+
+    //a single colour all the way: one long run cut into pieces of 62, wherever the bands fall
+    const Image<RGBA8> flat(257, 900, RGBA8(0, 0, 0, 255));
+    std::vector<std::uint8_t> flat_file;
+    io::MemorySink flat_sink{flat_file};
+    REQUIRE(qoi::encode(flat, flat_sink));
+    REQUIRE(flat_file.size() == 14 + (257 * 900 + 61) / 62 + 8);
+    REQUIRE(same_pixels(flat, qoi_decode(flat_file)));
+
+    const Image<RGB8> rgb = without_alpha(card);
+    std::vector<std::uint8_t> rgb_file;
+    io::MemorySink rgb_sink{rgb_file};
+    REQUIRE(qoi::encode(rgb, rgb_sink));
+    REQUIRE(rgb_file[12] == 3);
+    const Image<RGBA8> rgb_decoded = qoi_decode(rgb_file);
+    bool all = true;
+    for(std::size_t y = 0; y < rgb.height(); y++){
+        for(std::size_t x = 0; x < rgb.width(); x++){
+            all = all && rgb_decoded(x, y).R == rgb(x, y).R && rgb_decoded(x, y).B == rgb(x, y).B && rgb_decoded(x, y).A == 255;
+        }
+    }
+    REQUIRE(all);
+}
+
+TEST_CASE("qoi: a band starting in a run with nothing but whole ops after it", "[encode]"){
+    //256 rows to a band at this width: the first is all run (65536 pixels, 2 left over past the last 62), the second is
+    //pixels seen nowhere before, each a different alpha from the last, so every one is a 5 byte op_rgba
+    Image<RGBA8> image(256, 512, RGBA8(0, 0, 0, 255));
+    for(std::size_t y = 256; y < 512; y++){
+        for(std::size_t x = 0; x < 256; x++){
+            image(x, y) = RGBA8(std::uint8_t(x), std::uint8_t(y), 7, std::uint8_t(100 + (x & 1) + 2 * (y & 1)));
+        }
+    }
+    std::vector<std::uint8_t> file;
+    io::MemorySink sink{file};
+    REQUIRE(qoi::encode(image, sink));
+    REQUIRE(file.size() == 14 + (256 * 256 + 61) / 62 + 256 * 256 * 5 + 8);
+    REQUIRE(same_pixels(image, qoi_decode(file)));
+
+    //the same for RGB: 436 rows to a band, 28 pixels of run carried over, then green jumps by 128 every pixel,
+    //too far for a luma op, so every one is a 4 byte op_rgb
+    Image<RGB8> rgb(200, 872, RGB8(0, 0, 0));
+    for(std::size_t y = 436; y < 872; y++){
+        for(std::size_t x = 0; x < 200; x++){
+            rgb(x, y) = RGB8(std::uint8_t(x), std::uint8_t(128 * (x & 1) + (y >> 8)), std::uint8_t(y));
+        }
+    }
+    std::vector<std::uint8_t> rgb_file;
+    io::MemorySink rgb_sink{rgb_file};
+    REQUIRE(qoi::encode(rgb, rgb_sink));
+    REQUIRE(rgb_file.size() == 14 + (200 * 436 + 61) / 62 + 200 * 436 * 4 + 8);
+    const Image<RGBA8> rgb_decoded = qoi_decode(rgb_file);
+    bool all = true;
+    for(std::size_t y = 0; y < rgb.height(); y++){
+        for(std::size_t x = 0; x < rgb.width(); x++){
+            all = all && rgb_decoded(x, y).R == rgb(x, y).R && rgb_decoded(x, y).G == rgb(x, y).G && rgb_decoded(x, y).B == rgb(x, y).B;
+        }
+    }
+    REQUIRE(all);
+}
+
+TEST_CASE("pnm: PPM and PFM", "[encode]"){
+    Image<RGBA8> rgba(3, 2);
+    rgba(0, 0) = RGBA8(1, 2, 3, 4);
+    rgba(2, 1) = RGBA8(7, 8, 9, 10);
+    std::vector<std::uint8_t> ppm;
+    io::MemorySink ppm_sink{ppm};
+    REQUIRE(pnm::write_ppm(rgba, ppm_sink));
+    const std::string header = "P6\n3 2\n255\n";
+    REQUIRE(std::string(ppm.begin(), ppm.begin() + header.size()) == header);
+    REQUIRE(ppm.size() == header.size() + 18);
+    REQUIRE(ppm[header.size()] == 1);
+    REQUIRE(ppm[header.size() + 2] == 3);
+    REQUIRE(ppm.back() == 9);
+
+    //the same bytes from RGB8, rows straight out of the image
+    std::vector<std::uint8_t> ppm_rgb;
+    io::MemorySink ppm_rgb_sink{ppm_rgb};
+    REQUIRE(pnm::write_ppm(without_alpha(rgba), ppm_rgb_sink));
+    REQUIRE(ppm_rgb == ppm);
+
+    Image<RGB> hdr(2, 2);
+    hdr(0, 0) = RGB(1.5f, 2.0f, 3.0f);
+    hdr(1, 1) = RGB(100.0f, 0.25f, -1.0f);
+    std::vector<std::uint8_t> pfm;
+    io::MemorySink pfm_sink{pfm};
+    REQUIRE(pnm::write_pfm(hdr, pfm_sink));
+    const std::string pfm_header = "PF\n2 2\n-1.0\n";
+    REQUIRE(std::string(pfm.begin(), pfm.begin() + pfm_header.size()) == pfm_header);
+    REQUIRE(pfm.size() == pfm_header.size() + 4 * 12);
+    //bottom row first
+    float first;
+    std::memcpy(&first, pfm.data() + pfm_header.size() + 12, 4);
+    REQUIRE(first == 100.0f);
+    std::memcpy(&first, pfm.data() + pfm_header.size() + 24, 4);
+    REQUIRE(first == 1.5f);
+}
+
+#if !defined(_WIN32)
+TEST_CASE("io: encoders write to a file descriptor", "[encode]"){
+    std::FILE* file = std::tmpfile();
+    REQUIRE(file != nullptr);
+    const Image<RGBA8> card = test_card(64, 64);
+    io::FileSink sink{fileno(file)};
+    REQUIRE(png::encode(card, sink));
+
+    std::vector<std::uint8_t> written(1 << 16);
+    std::rewind(file);
+    written.resize(std::fread(written.data(), 1, written.size(), file));
+    std::fclose(file);
+
+    Image<RGBA8> decoded;
+    REQUIRE(png::decode(written, decoded) == png::Error::none);
+    REQUIRE(same_pixels(card, decoded));
+}
+#endif
+
+TEST_CASE("encode benchmark", "[!benchmark][encode]"){
+    const Image<RGBA8> frame = test_card(1920, 1080);
+    std::vector<std::uint8_t> out;
+    out.reserve(1920 * 1080 * 5);
+
+    //8 MB of RGBA a frame
+    BENCHMARK("PNG 1920x1080 RGBA8"){
+        out.clear();
+        io::MemorySink sink{out};
+        return png::encode(frame, sink);
+    };
+    BENCHMARK("QOI 1920x1080 RGBA8"){
+        out.clear();
+        io::MemorySink sink{out};
+        return qoi::encode(frame, sink);
+    };
+    BENCHMARK("PPM 1920x1080 RGBA8"){
+        out.clear();
+        io::MemorySink sink{out};
+        return pnm::write_ppm(frame, sink);
+    };
+}
@@ -1,8 +1,12 @@
 #define NDEBUG
 #include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <vector>
 #include "../ES_math.hpp"
 #include "../Angle.hpp"
 #include "../EulerAngles.hpp"
+#include "../Quaternion.hpp"
+#include "../Matrix.hpp"
 
 using namespace ES;
 
@@ -140,6 +144,49 @@ TEST_CASE("EulerAngles canonicalize_in_place", "[EulerAngles]"){
     REQUIRE(angles.yaw().get() <= math::pi<float>);
 }
 
+TEST_CASE("EulerAngles normalize in degrees wraps by degrees", "[EulerAngles]"){
+    EulerAngles<in_degrees, float> angles(Angle<in_degrees, float>(270.0f), Angle<in_degrees, float>(100.0f), Angle<in_degrees, float>(-721.0f));
+
+    auto normalized = angles.normalize();
+    REQUIRE(math::approx_equal(normalized.yaw().get(), -90.0f, 1e-4f));
+    REQUIRE(math::approx_equal(normalized.pitch().get(), 100.0f, 1e-4f));
+    REQUIRE(math::approx_equal(normalized.roll().get(), -1.0f, 1e-4f));
+
+    auto canonical = angles.canonicalize();
+    REQUIRE(math::approx_equal(canonical.pitch().get(), -80.0f, 1e-4f));
+}
+
+TEST_CASE("EulerAngles batch normalize and canonicalize match the scalar ones", "[EulerAngles]"){
+    std::vector<EulerAngles<in_radians, float>> angles;
+    for(std::size_t i = 0; i < 101; i++){
+        const float t = static_cast<float>(i);
+        angles.emplace_back(Angle<in_radians, float>(0.77f * t - 40.0f), Angle<in_radians, float>(9.0f - 0.31f * t), Angle<in_radians, float>(0.05f * t * t));
+    }
+    auto normalized = angles, canonical = angles;
+
+    EulerAngles<in_radians, float>::normalize_all(normalized);
+    EulerAngles<in_radians, float>::canonicalize_all(canonical);
+
+    for(std::size_t i = 0; i < angles.size(); i++){
+        for(std::size_t c = 0; c < 3; c++){
+            REQUIRE(normalized[i][c].get() == angles[i].normalize()[c].get());
+            REQUIRE(canonical[i][c].get() == angles[i].canonicalize()[c].get());
+        }
+    }
+}
+
+TEST_CASE("EulerAngles batch normalize converts units on the way", "[EulerAngles]"){
+    std::vector<EulerAngles<in_degrees, float>> degrees = {
+        EulerAngles<in_degrees, float>(Angle<in_degrees, float>(270.0f), Angle<in_degrees, float>(45.0f), Angle<in_degrees, float>(-180.0f))};
+    std::vector<EulerAngles<in_radians, float>> radians(1);
+
+    EulerAngles<in_radians, float>::normalize_all<in_degrees>(degrees, radians);
+
+    REQUIRE(math::approx_equal(radians[0].yaw().get(), -math::half_pi<float>, 1e-6f));
+    REQUIRE(math::approx_equal(radians[0].pitch().get(), math::pi<float> / 4.0f, 1e-6f));
+    REQUIRE(math::approx_equal(radians[0].roll().get(), -math::pi<float>, 1e-6f));
+}
+
 TEST_CASE("EulerAngles sin_yaw", "[EulerAngles]"){
     Angle<in_radians, float> y(math::half_pi<float>);
     Angle<in_radians, float> p(0.0f);
@@ -447,4 +494,141 @@ TEST_CASE("EulerAngles scalar division in place", "[EulerAngles]"){
     REQUIRE(math::approx_equal(angles.yaw().get(), 1.0f));
     REQUIRE(math::approx_equal(angles.pitch().get(), 2.0f));
     REQUIRE(math::approx_equal(angles.roll().get(), 3.0f));
-}
\ No newline at end of file
+}
+
+namespace {
+    using Radians = EulerAngles<in_radians, float>;
+    using Degrees = EulerAngles<in_degrees, float>;
+
+    Radians make_angles(float y, float p, float r){
+        return Radians(Angle<in_radians, float>(y), Angle<in_radians, float>(p), Angle<in_radians, float>(r));
+    }
+
+    bool same_rotation(const Quaternion<float>& a, const Quaternion<float>& b, float epsilon){
+        return a.almost_equal(b, epsilon) || a.almost_equal(-b, epsilon);
+    }
+}
+
+TEST_CASE("EulerAngles to_quaternion composes yaw, pitch then roll", "[EulerAngles]"){
+    auto angles = make_angles(0.7f, -0.4f, 1.9f);
+    Quaternion<float> yaw(Vector3<float>(0.0f, 1.0f, 0.0f), Angle<in_radians, float>(0.7f));
+    Quaternion<float> pitch(Vector3<float>(1.0f, 0.0f, 0.0f), Angle<in_radians, float>(-0.4f));
+    Quaternion<float> roll(Vector3<float>(0.0f, 0.0f, 1.0f), Angle<in_radians, float>(1.9f));
+
+    REQUIRE(same_rotation(angles.to_quaternion(), yaw * pitch * roll, 1e-6f));
+}
+
+TEST_CASE("EulerAngles to_matrix3 agrees with to_quaternion", "[EulerAngles]"){
+    auto angles = make_angles(-2.3f, 1.1f, 0.35f);
+
+    REQUIRE(angles.to_matrix3().almost_equal(angles.to_quaternion().to_matrix3(), 1e-6f));
+}
+
+TEST_CASE("EulerAngles in degrees convert like the same angles in radians", "[EulerAngles]"){
+    Degrees degrees(Angle<in_degrees, float>(45.0f), Angle<in_degrees, float>(-30.0f), Angle<in_degrees, float>(120.0f));
+    auto radians = make_angles(math::pi<float> / 4.0f, -math::pi<float> / 6.0f, 2.0f * math::pi<float> / 3.0f);
+
+    REQUIRE(same_rotation(degrees.to_quaternion(), radians.to_quaternion(), 1e-6f));
+    REQUIRE(math::approx_equal(degrees.sin_pitch(), -0.5f));
+    REQUIRE(math::approx_equal(Degrees::from_quaternion(radians.to_quaternion()).roll().get(), 120.0f, 1e-3f));
+}
+
+TEST_CASE("EulerAngles from_quaternion round trips", "[EulerAngles]"){
+    for(float y = -3.0f; y < 3.1f; y += 0.5f){
+        for(float p = -1.5f; p < 1.55f; p += 0.25f){
+            for(float r = -3.0f; r < 3.1f; r += 0.5f){
+                auto angles = make_angles(y, p, r);
+                auto back = Radians::from_quaternion(angles.to_quaternion());
+                REQUIRE(math::approx_equal(back.yaw().get(), y, 1e-4f));
+                REQUIRE(math::approx_equal(back.pitch().get(), p, 1e-4f));
+                REQUIRE(math::approx_equal(back.roll().get(), r, 1e-4f));
+            }
+        }
+    }
+}
+
+TEST_CASE("EulerAngles from_quaternion at gimbal lock keeps the rotation", "[EulerAngles]"){
+    for(float pitch : {math::half_pi<float>, -math::half_pi<float>}){
+        auto angles = make_angles(0.6f, pitch, -0.9f);
+        auto back = Radians::from_quaternion(angles.to_quaternion());
+
+        REQUIRE(back.roll().get() == 0.0f);
+        REQUIRE(math::approx_equal(back.pitch().get(), pitch, 1e-3f));
+        REQUIRE(same_rotation(back.to_quaternion(), angles.to_quaternion(), 1e-5f));
+    }
+}
+
+TEST_CASE("EulerAngles batch conversions match the scalar ones", "[EulerAngles]"){
+    std::vector<Radians> angles;
+    for(std::size_t i = 0; i < 103; i++){
+        const float t = static_cast<float>(i);
+        angles.push_back(make_angles(0.37f * t - 19.0f, 0.011f * t - 0.6f, 4.0f - 0.13f * t));
+    }
+    std::vector<Quaternion<float>> quaternions(angles.size());
+    std::vector<Matrix<float,3>> matrices(angles.size());
+    std::vector<Radians> back(angles.size());
+
+    Radians::to_quaternions(angles, quaternions);
+    Radians::to_matrices3(angles, matrices);
+    Radians::from_quaternions(quaternions, back);
+
+    for(std::size_t i = 0; i < angles.size(); i++){
+        REQUIRE(quaternions[i].almost_equal(angles[i].to_quaternion(), 1e-6f));
+        REQUIRE(matrices[i].almost_equal(angles[i].to_matrix3(), 1e-6f));
+        REQUIRE(same_rotation(back[i].to_quaternion(), quaternions[i], 1e-5f));
+    }
+}
+
+TEST_CASE("EulerAngles to_quaternion 10k", "[EulerAngles][!benchmark]"){
+    const std::size_t count = 10'000;
+    std::vector<Radians> angles;
+    for(std::size_t i = 0; i < count; i++){
+        const float t = static_cast<float>(i);
+        angles.push_back(make_angles(0.001f * t, 0.0003f * t - 1.5f, 3.0f - 0.0006f * t));
+    }
+    std::vector<Quaternion<float>> out(count);
+
+    BENCHMARK("std::sin/std::cos per element"){
+        for(std::size_t i = 0; i < count; i++){
+            const float y = 0.5f * angles[i].yaw().get(), p = 0.5f * angles[i].pitch().get(), r = 0.5f * angles[i].roll().get();
+            const float sy = std::sin(y), cy = std::cos(y), sp = std::sin(p), cp = std::cos(p), sr = std::sin(r), cr = std::cos(r);
+            out[i] = Quaternion<float>(cy*cp*cr + sy*sp*sr, cy*sp*cr + sy*cp*sr, sy*cp*cr - cy*sp*sr, cy*cp*sr - sy*sp*cr);
+        }
+        return out[count - 1].w();
+    };
+
+    BENCHMARK("to_quaternion per element"){
+        for(std::size_t i = 0; i < count; i++){
+            out[i] = angles[i].to_quaternion();
+        }
+        return out[count - 1].w();
+    };
+
+    BENCHMARK("to_quaternions"){
+        Radians::to_quaternions(angles, out);
+        return out[count - 1].w();
+    };
+}
+
+TEST_CASE("EulerAngles normalize 10k", "[EulerAngles][!benchmark]"){
+    const std::size_t count = 10'000;
+    std::vector<Radians> angles;
+    for(std::size_t i = 0; i < count; i++){
+        const float t = static_cast<float>(i);
+        angles.push_back(make_angles(0.01f * t - 50.0f, 20.0f - 0.003f * t, 0.007f * t));
+    }
+    std::vector<Radians> out(count);
+
+    BENCHMARK("normalize per element"){
+        for(std::size_t i = 0; i < count; i++){
+            out[i] = angles[i].normalize();
+        }
+        return out[count - 1].yaw().get();
+    };
+
+    BENCHMARK("normalize_all"){
+        std::copy(angles.begin(), angles.end(), out.begin());
+        Radians::normalize_all(out);
+        return out[count - 1].yaw().get();
+    };
+}
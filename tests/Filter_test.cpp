@@ -0,0 +1,234 @@
+#define NDEBUG
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <span>
+#include <vector>
+#include "../ES_filter.hpp"
+
+using namespace ES;
+using filter::Border;
+
+namespace {
+
+    constexpr Border all_borders[] = {Border::clamp, Border::wrap, Border::mirror, Border::zero};
+
+    //different in every pixel and channel, alpha included
+    Image<RGBA> pattern(std::size_t width, std::size_t height){
+        Image<RGBA> image(width, height);
+        std::uint32_t seed = 11;
+        for(std::size_t y = 0; y < height; y++){
+            for(std::size_t x = 0; x < width; x++){
+                seed = seed * 1664525u + 1013904223u;
+                const float a = static_cast<float>(seed >> 24) / 255.0f;
+                image(x, y) = RGBA(a * static_cast<float>(x % 7) / 7.0f, a * static_cast<float>(y % 5) / 5.0f, a * 0.5f, a);
+            }
+        }
+        return image;
+    }
+
+    //the pixel at x, y as the border rule sees it
+    RGBA read(const Image<RGBA>& image, std::ptrdiff_t x, std::ptrdiff_t y, Border border){
+        const std::size_t ix = filter::Secret::address(x, image.width(), border);
+        const std::size_t iy = filter::Secret::address(y, image.height(), border);
+        return ix == image.width() || iy == image.height() ? RGBA(0.0f, 0.0f, 0.0f, 0.0f) : image(ix, iy);
+    }
+
+    //the 2D kernel applied pixel by pixel, in double
+    Image<RGBA> reference(const Image<RGBA>& image, const Image<float>& kernel, Border border){
+        Image<RGBA> out(image.width(), image.height());
+        const auto rx = static_cast<std::ptrdiff_t>(kernel.width() / 2);
+        const auto ry = static_cast<std::ptrdiff_t>(kernel.height() / 2);
+        for(std::size_t y = 0; y < image.height(); y++){
+            for(std::size_t x = 0; x < image.width(); x++){
+                double sum[4] = {};
+                for(std::size_t j = 0; j < kernel.height(); j++){
+                    for(std::size_t i = 0; i < kernel.width(); i++){
+                        const RGBA p = read(image, static_cast<std::ptrdiff_t>(x + i) - rx, static_cast<std::ptrdiff_t>(y + j) - ry, border);
+                        for(std::size_t c = 0; c < 4; c++){
+                            sum[c] += static_cast<double>(kernel(i, j)) * p[c];
+                        }
+                    }
+                }
+                out(x, y) = RGBA(static_cast<float>(sum[0]), static_cast<float>(sum[1]), static_cast<float>(sum[2]), static_cast<float>(sum[3]));
+            }
+        }
+        return out;
+    }
+
+    Image<float> outer(const std::vector<float>& across, const std::vector<float>& down){
+        Image<float> kernel(across.size(), down.size());
+        for(std::size_t j = 0; j < down.size(); j++){
+            for(std::size_t i = 0; i < across.size(); i++){
+                kernel(i, j) = across[i] * down[j];
+            }
+        }
+        return kernel;
+    }
+
+    //boxes one after another as the one kernel they add up to
+    std::vector<float> chained_boxes(std::span<const std::size_t> radii){
+        std::vector<float> kernel = {1.0f};
+        for(const std::size_t r : radii){
+            std::vector<float> wider(kernel.size() + 2 * r, 0.0f);
+            for(std::size_t i = 0; i < kernel.size(); i++){
+                for(std::size_t k = 0; k < 2 * r + 1; k++){
+                    wider[i + k] += kernel[i] / static_cast<float>(2 * r + 1);
+                }
+            }
+            kernel = wider;
+        }
+        return kernel;
+    }
+
+    float difference(const Image<RGBA>& a, const Image<RGBA>& b){
+        float worst = 0.0f;
+        for(std::size_t y = 0; y < a.height(); y++){
+            for(std::size_t x = 0; x < a.width(); x++){
+                for(std::size_t c = 0; c < 4; c++){
+                    worst = std::max(worst, std::abs(a(x, y)[c] - b(x, y)[c]));
+                }
+            }
+        }
+        return worst;
+    }
+
+}
+
+TEST_CASE("filter: kernels", "[filter]"){
+    const std::vector<float> kernel = filter::gaussian_kernel(2.0f);
+    REQUIRE(kernel.size() == 13);
+    float total = 0.0f;
+    for(std::size_t i = 0; i < kernel.size(); i++){
+        total += kernel[i];
+        REQUIRE(kernel[i] == kernel[kernel.size() - 1 - i]);
+    }
+    REQUIRE(std::abs(total - 1.0f) < 1e-6f);
+    REQUIRE(filter::gaussian_kernel(0.0f) == std::vector<float>{1.0f});
+
+    //three boxes of radius r have variance r (r + 1) / 3 each
+    for(const float sigma : {0.8f, 1.5f, 3.0f, 7.3f, 20.0f}){
+        double variance = 0.0;
+        for(const std::size_t r : filter::gaussian_boxes(sigma)){
+            variance += static_cast<double>(r * (r + 1)) / 3.0;
+        }
+        REQUIRE(std::abs(std::sqrt(variance) - sigma) < 0.1 * sigma);
+    }
+}
+
+TEST_CASE("filter: convolution matches the direct sum", "[filter]"){
+    //wider than a tile and taller than two, so tiles meet in both directions
+    const Image<RGBA> image = pattern(301, 150);
+    const std::vector<float> across = {0.1f, -0.2f, 0.5f, 0.3f, 0.3f};
+    const std::vector<float> down = {0.25f, 0.6f, 0.15f};
+    const Image<float> kernel = outer(across, down);
+    parallel::ThreadPool pool(3);
+    for(const Border border : all_borders){
+        const Image<RGBA> expected = reference(image, kernel, border);
+        Image<RGBA> separable(image.width(), image.height());
+        filter::convolve_separable(image, separable, across, down, border, pool);
+        REQUIRE(difference(separable, expected) < 1e-5f);
+        Image<RGBA> general(image.width(), image.height());
+        filter::convolve(image, general, kernel, border, pool);
+        REQUIRE(difference(general, expected) < 1e-5f);
+    }
+    //a kernel bigger than the image reads well past its edges
+    const Image<RGBA> small = pattern(5, 3);
+    const Image<float> wide = outer(filter::gaussian_kernel(3.0f), {0.2f, 0.6f, 0.2f});
+    for(const Border border : all_borders){
+        Image<RGBA> out(5, 3);
+        filter::convolve(small, out, wide, border, pool);
+        REQUIRE(difference(out, reference(small, wide, border)) < 1e-5f);
+    }
+}
+
+TEST_CASE("filter: box blur matches the direct sum", "[filter]"){
+    const Image<RGBA> image = pattern(301, 150);
+    parallel::ThreadPool pool(3);
+    //a radius past half a tile makes the tiles grow
+    for(const auto& [rx, ry] : {std::pair<std::size_t, std::size_t>{1, 1}, {3, 0}, {0, 2}, {40, 37}}){
+        const Image<float> box(2 * rx + 1, 2 * ry + 1, 1.0f / static_cast<float>((2 * rx + 1) * (2 * ry + 1)));
+        for(const Border border : all_borders){
+            Image<RGBA> out(image.width(), image.height());
+            filter::box_blur(image, out, rx, ry, border, pool);
+            REQUIRE(difference(out, reference(image, box, border)) < 1e-5f);
+        }
+    }
+    //two boxes or more across turn the block on its side, which has to come out the same
+    const std::size_t radii_x[] = {2, 0, 3};
+    const std::size_t radii_y[] = {1, 4, 0};
+    const Image<float> chain = outer(chained_boxes(radii_x), chained_boxes(radii_y));
+    for(const Border border : all_borders){
+        Image<RGBA> out(image.width(), image.height());
+        filter::Secret::boxes<RGBA>(image, out, radii_x, radii_y, border, pool);
+        REQUIRE(difference(out, reference(image, chain, border)) < 1e-5f);
+    }
+}
+
+TEST_CASE("filter: gaussian blur", "[filter]"){
+    const Image<RGBA> image = pattern(301, 150);
+    parallel::ThreadPool pool(3);
+    //the real kernel below sigma 3, and three boxes within a couple of percent of the range above
+    for(const float sigma : {1.0f, 3.0f, 4.0f, 9.5f}){
+        const std::vector<float> kernel = filter::gaussian_kernel(sigma);
+        Image<RGBA> exact(image.width(), image.height());
+        filter::convolve_separable(image, exact, kernel, kernel, Border::mirror, pool);
+        Image<RGBA> fast(image.width(), image.height());
+        filter::gaussian_blur(image, fast, sigma, Border::mirror, pool);
+        REQUIRE(difference(fast, exact) < 0.02f);
+    }
+    //a flat image stays flat whatever the border but zero, and one thread does exactly what four do
+    const Image<RGB> flat(97, 41, RGB(0.25f, 0.5f, 0.75f));
+    Image<RGB> blurred(97, 41);
+    filter::gaussian_blur(flat, blurred, 6.0f, Border::wrap, pool);
+    bool unchanged = true;
+    for(std::size_t y = 0; y < blurred.height(); y++){
+        for(const RGB& p : blurred.row(y)){
+            unchanged = unchanged && std::abs(p.R() - 0.25f) < 1e-5f && std::abs(p.G() - 0.5f) < 1e-5f && std::abs(p.B() - 0.75f) < 1e-5f;
+        }
+    }
+    REQUIRE(unchanged);
+    parallel::ThreadPool inline_pool(0);
+    Image<RGBA> alone(image.width(), image.height());
+    Image<RGBA> shared(image.width(), image.height());
+    filter::gaussian_blur(image, alone, 5.0f, Border::clamp, inline_pool);
+    filter::gaussian_blur(image, shared, 5.0f, Border::clamp, pool);
+    REQUIRE(difference(alone, shared) == 0.0f);
+
+    //luminance and alpha blur the same way
+    Image<LA> la(64, 64, LA(0.0f, 0.0f));
+    la(32, 32) = LA(1.0f, 1.0f);
+    Image<LA> la_out(64, 64);
+    filter::gaussian_blur(la, la_out, 3.0f, Border::zero, pool);
+    float total = 0.0f;
+    bool premultiplied = true;
+    for(std::size_t y = 0; y < la_out.height(); y++){
+        for(const LA& p : la_out.row(y)){
+            total += p.L();
+            premultiplied = premultiplied && p.L() == p.A();
+        }
+    }
+    REQUIRE(premultiplied);
+    REQUIRE(std::abs(total - 1.0f) < 1e-4f);
+}
+
+TEST_CASE("filter benchmark", "[!benchmark][filter]"){
+    const Image<RGBA> frame = pattern(3840, 2160);
+    Image<RGBA> out(3840, 2160);
+    const std::vector<float> kernel = filter::gaussian_kernel(1.5f);
+
+    BENCHMARK("4K RGBA 11 tap separable"){
+        filter::convolve_separable(frame, out, kernel, kernel);
+        return out(0, 0).A();
+    };
+    BENCHMARK("4K RGBA box blur, radius 8"){
+        filter::box_blur(frame, out, 8, 8);
+        return out(0, 0).A();
+    };
+    BENCHMARK("4K RGBA gaussian blur, sigma 16"){
+        filter::gaussian_blur(frame, out, 16.0f);
+        return out(0, 0).A();
+    };
+}
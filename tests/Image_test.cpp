@@ -0,0 +1,135 @@
+#define NDEBUG
+#include <catch2/catch_test_macros.hpp>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+#include "../ColorN.hpp"
+#include "../Image.hpp"
+
+using namespace ES;
+
+TEST_CASE("Image: every colour type is an image pixel", "[Image]"){
+    STATIC_REQUIRE(ImagePixel<RGB>);
+    STATIC_REQUIRE(ImagePixel<RGBA>);
+    STATIC_REQUIRE(ImagePixel<RGB8>);
+    STATIC_REQUIRE(ImagePixel<RGBA8>);
+    STATIC_REQUIRE(ImagePixel<LA>);
+    STATIC_REQUIRE(ImagePixel<RGB_Int>);
+}
+
+TEST_CASE("Image: rows are aligned and padded", "[Image]"){
+    Image<RGB8> image(7, 5);
+    REQUIRE(image.width() == 7);
+    REQUIRE(image.height() == 5);
+    REQUIRE(image.row_pitch() == 64);
+    for(std::size_t y = 0; y < image.height(); y++){
+        REQUIRE(reinterpret_cast<std::uintptr_t>(image.row(y).data()) % image_row_alignment == 0);
+        REQUIRE(image.row(y).size() == 7);
+    }
+    REQUIRE(image(6, 4).R == 0);
+    REQUIRE(Image<RGBA>::aligned_row_pitch(4) == 64);
+    REQUIRE(Image<RGBA>::aligned_row_pitch(5) == 128);
+    REQUIRE_FALSE(image.view().is_contiguous());
+    REQUIRE(Image<RGBA>(4, 3).view().is_contiguous());
+}
+
+TEST_CASE("Image: fill, copy and move", "[Image]"){
+    Image<RGBA8> image(9, 4, RGBA8(1, 2, 3, 4));
+    REQUIRE(image(8, 3).A == 4);
+
+    Image<RGBA8> copy(image);
+    copy(0, 0) = RGBA8(9, 9, 9, 9);
+    REQUIRE(image(0, 0).R == 1);
+    REQUIRE(copy(1, 0).G == 2);
+
+    Image<RGBA8> moved(std::move(copy));
+    REQUIRE(moved(0, 0).R == 9);
+    REQUIRE(copy.empty());
+
+    Image<RGBA8> empty(0, 10);
+    REQUIRE(empty.empty());
+    REQUIRE(empty.data() == nullptr);
+}
+
+TEST_CASE("Image: subviews share pixels", "[Image][ImageView]"){
+    Image<RGB_Int> image(10, 8);
+    auto inner = image.subview(2, 3, 4, 2);
+    REQUIRE(inner.width() == 4);
+    REQUIRE(inner.height() == 2);
+    inner.fill(RGB_Int(1, 2, 3));
+    REQUIRE(image(2, 3).R() == 1);
+    REQUIRE(image(5, 4).B() == 3);
+    REQUIRE(image(6, 4).B() == 0);
+    REQUIRE(image(2, 5).R() == 0);
+
+    auto nested = inner.subview(1, 1, 2, 1);
+    nested(0, 0) = RGB_Int(7, 7, 7);
+    REQUIRE(image(3, 4).G() == 7);
+
+    ImageView<const RGB_Int> read_only = nested;
+    REQUIRE(read_only(0, 0).G() == 7);
+}
+
+TEST_CASE("Image: wraps external memory without copying", "[ImageView]"){
+    std::vector<float> bytes(3 * 6 * 3, 0.0f);
+    //6 wide rows holding a 4 wide image, 2 pixels of padding each
+    ImageView<RGB> wrapped(reinterpret_cast<RGB*>(bytes.data()), 4, 3, 6 * sizeof(RGB));
+    wrapped(3, 2) = RGB(0.5f, 0.25f, 1.0f);
+    REQUIRE(bytes[(2 * 6 + 3) * 3 + 1] == 0.25f);
+
+    Image<RGB> owned(wrapped);
+    REQUIRE(owned(3, 2).G() == 0.25f);
+    owned(3, 2) = RGB(0, 0, 0);
+    REQUIRE(wrapped(3, 2).G() == 0.25f);
+
+    auto flipped = wrapped.flipped_vertically();
+    REQUIRE(flipped.row_pitch() == -wrapped.row_pitch());
+    REQUIRE(&flipped(3, 0) == &wrapped(3, 2));
+    REQUIRE(&flipped.flipped_vertically()(1, 1) == &wrapped(1, 1));
+}
+
+TEST_CASE("Image: tiles cover every pixel exactly once", "[ImageView]"){
+    Image<LA> image(37, 21);
+    std::size_t tiles = 0;
+    image.view().for_each_tile(16, 8, [&](std::size_t x, std::size_t y, ImageView<LA> tile){
+        tiles++;
+        REQUIRE(tile.width() == std::min<std::size_t>(16, 37 - x));
+        REQUIRE(tile.height() == std::min<std::size_t>(8, 21 - y));
+        tile.for_each_row([](std::size_t, std::span<LA> row){
+            for(LA& pixel : row){
+                pixel.A() += 1.0f;
+            }
+        });
+    });
+    REQUIRE(tiles == 3 * 3);
+
+    image.view().parallel_for_tiles(5, 3, [](std::size_t, std::size_t, ImageView<LA> tile){
+        tile.for_each_row([](std::size_t, std::span<LA> row){
+            for(LA& pixel : row){
+                pixel.A() += 1.0f;
+            }
+        });
+    });
+
+    bool all_twice = true;
+    for(std::size_t y = 0; y < image.height(); y++){
+        for(const LA& pixel : image.row(y)){
+            all_twice = all_twice && pixel.A() == 2.0f;
+        }
+    }
+    REQUIRE(all_twice);
+}
+
+TEST_CASE("Image: parallel rows see each row once", "[ImageView]"){
+    Image<RGBA> image(13, 200);
+    std::atomic<std::size_t> rows{0};
+    image.view().parallel_for_rows([&](std::size_t y, std::span<RGBA> row){
+        rows++;
+        for(RGBA& pixel : row){
+            pixel.R() = static_cast<float>(y);
+        }
+    }, 7);
+    REQUIRE(rows == 200);
+    REQUIRE(image(12, 199).R() == 199.0f);
+    REQUIRE(image(0, 57).R() == 57.0f);
+}
@@ -1,4 +1,7 @@
 #include <catch2/catch_test_macros.hpp>
+#include <cmath>
+#include <limits>
+#include <vector>
 
 #include "ES_test_util.hpp"
 #include "../ES_math.hpp"
@@ -11,4 +14,93 @@ TEST_CASE("Floortastic","[Math][Floor][Floating-point]") {
     CHECK(ES::math::floor(3.14f) == 3.f);
     CHECK(ES::math::floor(FLIMIT + 3) == FLIMIT + 3);
 
+}
+
+TEST_CASE("Floor goes down for negatives","[Math][Floor][Floating-point]") {
+    STATIC_REQUIRE(ES::math::floor(-3.9f) == -4.f);
+    STATIC_REQUIRE(ES::math::floor(-0.25) == -1.0);
+    STATIC_REQUIRE(ES::math::floor(-2.0f) == -2.f);
+    STATIC_REQUIRE(ES::math::floor(-DLIMIT - 0.5 * DLIMIT) == -DLIMIT - 0.5 * DLIMIT);
+    CHECK(std::signbit(ES::math::floor(-0.0f)));
+    CHECK(std::isnan(ES::math::floor(std::numeric_limits<double>::quiet_NaN())));
+    CHECK(ES::math::floor(-std::numeric_limits<float>::infinity()) == -std::numeric_limits<float>::infinity());
+    for (float x = -100.0f; x <= 100.0f; x += 0.173f) {
+        REQUIRE(ES::math::floor(x) == std::floor(x));
+    }
+}
+TEST_CASE("sincos over spans matches the standard library", "[Math][sincos]") {
+    std::vector<float> angles, sines, cosines;
+    for (float x = -50.0f; x <= 50.0f; x += 0.01371f) angles.push_back(x);
+    sines.resize(angles.size()); cosines.resize(angles.size());
+    ES::math::sincos<float>(angles, sines, cosines);
+    for (std::size_t i = 0; i < angles.size(); i++) {
+        REQUIRE(std::fabs(sines[i] - std::sin(angles[i])) < 2e-6f);
+        REQUIRE(std::fabs(cosines[i] - std::cos(angles[i])) < 2e-6f);
+    }
+
+    std::vector<double> wide, wide_sines, wide_cosines;
+    for (double x = -1000.0; x <= 1000.0; x += 0.0731) wide.push_back(x);
+    wide_sines.resize(wide.size()); wide_cosines.resize(wide.size());
+    ES::math::sincos<double>(wide, wide_sines, wide_cosines);
+    for (std::size_t i = 0; i < wide.size(); i++) {
+        REQUIRE(std::fabs(wide_sines[i] - std::sin(wide[i])) < 1e-14);
+        REQUIRE(std::fabs(wide_cosines[i] - std::cos(wide[i])) < 1e-14);
+    }
+}
+
+TEST_CASE("sincos over spans may write over its input", "[Math][sincos]") {
+    std::vector<double> angles = {0.0, ES::math::half_pi<double>, ES::math::pi<double>, -2.0};
+    std::vector<double> cosines(angles.size());
+
+    ES::math::sincos<double>(angles, angles, cosines);
+
+    CHECK(angles[0] == 0.0);
+    CHECK(cosines[0] == 1.0);
+    CHECK(std::fabs(angles[1] - 1.0) < 1e-15);
+    CHECK(std::fabs(cosines[2] + 1.0) < 1e-15);
+    CHECK(std::fabs(angles[3] - std::sin(-2.0)) < 1e-15);
+}
+
+TEST_CASE("sincos over spans falls back outside the reduction range", "[Math][sincos]") {
+    //3e38 and infinity are past what the quadrant's int32 can hold, they must not reach the cast
+    std::vector<float> angles = {1e6f, -7e4f, std::numeric_limits<float>::quiet_NaN(), 0.5f, 3e38f, -std::numeric_limits<float>::infinity()};
+    std::vector<float> sines(angles.size()), cosines(angles.size());
+
+    ES::math::sincos<float>(angles, sines, cosines);
+
+    CHECK(sines[0] == std::sin(1e6f));
+    CHECK(cosines[1] == std::cos(-7e4f));
+    CHECK(std::isnan(sines[2]));
+    CHECK(std::fabs(sines[3] - std::sin(0.5f)) < 2e-6f);
+    CHECK(cosines[4] == std::cos(3e38f));
+    CHECK(std::isnan(sines[5]));
+}
+
+TEST_CASE("sincos over spans matches the scalar version", "[Math][sincos]") {
+    std::vector<float> angles(1003), sines(angles.size()), cosines(angles.size());
+    for (std::size_t i = 0; i < angles.size(); i++) {
+        angles[i] = -30.0f + 0.06f * static_cast<float>(i);
+    }
+    angles[17] = 5e7f;
+    angles[400] = -3e5f;
+
+    ES::math::sincos<float>(angles, sines, cosines);
+
+    for (std::size_t i = 0; i < angles.size(); i++) {
+        const auto scalar = ES::math::sincos(angles[i]);
+        REQUIRE(std::fabs(sines[i] - scalar.sin) < 2e-6f);
+        REQUIRE(std::fabs(cosines[i] - scalar.cos) < 2e-6f);
+    }
+}
+
+TEST_CASE("simd::inverse_sqrt matches one over sqrt", "[Math][simd]") {
+    for (float x = 1e-6f; x < 1e6f; x *= 1.37f) {
+        const float expected = 1.0f / std::sqrt(x);
+        REQUIRE(std::fabs(ES::simd::inverse_sqrt(x) - expected) <= 4.0f * std::numeric_limits<float>::epsilon() * expected);
+    }
+    for (double x = 1e-12; x < 1e12; x *= 1.37) {
+        const double expected = 1.0 / std::sqrt(x);
+        REQUIRE(std::fabs(ES::simd::inverse_sqrt(x) - expected) <= 4.0 * std::numeric_limits<double>::epsilon() * expected);
+    }
+    STATIC_REQUIRE(ES::simd::inverse_sqrt(4.0) > 0.4999999 && ES::simd::inverse_sqrt(4.0) < 0.5000001);
 }
\ No newline at end of file
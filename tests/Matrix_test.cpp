@@ -685,4 +685,61 @@ TEST_CASE("Matrix 5x5 inverse", "[Matrix]"){
     for(std::size_t i = 0; i < 5; i++){
         REQUIRE(math::approx_equal(identity(i,i), 1.0f));
     }
-}
\ No newline at end of file
+}
+namespace {
+    Matrix<double,3> sample_matrix(){
+        Matrix<double,3> m;
+        m(0,0) = 0.3;  m(0,1) = -0.7; m(0,2) = 0.2;
+        m(1,0) = 0.9;  m(1,1) = 0.1;  m(1,2) = -0.4;
+        m(2,0) = -0.2; m(2,1) = 0.5;  m(2,2) = 0.6;
+        return m;
+    }
+}
+
+TEST_CASE("Matrix exp of zero and of a diagonal", "[Matrix]"){
+    Matrix<double,3> zero;
+    std::fill(zero.begin(), zero.end(), 0.0);
+    REQUIRE(zero.exp().almost_equal(Matrix<double,3>::identity(), 1e-15));
+
+    Matrix<double,4> diagonal = Matrix<double,4>::identity();
+    diagonal(0,0) = 3.0; diagonal(1,1) = -2.0; diagonal(2,2) = 0.25; diagonal(3,3) = 0.0;
+    const auto e = diagonal.exp();
+    REQUIRE(std::fabs(e(0,0) - std::exp(3.0)) < 1e-12);
+    REQUIRE(std::fabs(e(1,1) - std::exp(-2.0)) < 1e-14);
+    REQUIRE(std::fabs(e(2,2) - std::exp(0.25)) < 1e-14);
+    REQUIRE(std::fabs(e(3,3) - 1.0) < 1e-14);
+    REQUIRE(std::fabs(e(0,1)) < 1e-14);
+}
+
+TEST_CASE("Matrix exp of a skew matrix is exp_rotation", "[Matrix]"){
+    const VectorN<double,3> omega(0.4, -1.1, 2.0);
+    const auto general = Matrix<double,3>::skew(omega).exp();
+    const auto closed = Matrix<double,3>::exp_rotation(omega);
+    REQUIRE(general.almost_equal(closed, 1e-13));
+    REQUIRE(closed.is_orthogonal());
+    REQUIRE(std::fabs(closed.determinant() - 1.0) < 1e-13);
+    REQUIRE((closed * omega).almost_equal(omega, 1e-13)); //the axis stays put
+}
+
+TEST_CASE("Matrix log undoes exp", "[Matrix]"){
+    const auto a = sample_matrix();
+    REQUIRE(a.exp().log().almost_equal(a, 1e-12));
+
+    //and exp undoes log, far from the identity so log has roots to take
+    const auto b = (a * 3.0).exp();
+    REQUIRE(b.log().exp().almost_equal(b, 1e-9 * b.norm1()));
+
+    const auto root = b.sqrt();
+    REQUIRE((root * root).almost_equal(b, 1e-10 * b.norm1()));
+}
+
+TEST_CASE("Matrix log_rotation round trips all the way to a half turn", "[Matrix]"){
+    const VectorN<double,3> axis = VectorN<double,3>(1.0, -2.0, 0.5).normalize();
+    const double angles[] = {0.0, 1e-7, 1e-3, 0.8, 1.6, 2.5, 3.1, 3.14159, 3.141592653589793};
+    for(double angle : angles){
+        const auto omega = axis * angle;
+        const auto back = Matrix<double,3>::exp_rotation(omega).log_rotation();
+        //at exactly a half turn the sign of the axis is a coin toss, both are the same rotation
+        REQUIRE((back.almost_equal(omega, 1e-9) || (angle > 3.14159 && back.almost_equal(-omega, 1e-9))));
+    }
+}
@@ -0,0 +1,165 @@
+#define NDEBUG
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include "../ES_mip.hpp"
+
+using namespace ES;
+using resample::Filter;
+
+namespace {
+    //a cutout: grass blades one pixel wide, every fourth column, with soft noise in between
+    Image<RGBA8> blades(std::size_t width, std::size_t height){
+        Image<RGBA8> image(width, height);
+        std::uint32_t seed = 7;
+        for(std::size_t y = 0; y < height; y++){
+            for(std::size_t x = 0; x < width; x++){
+                seed = seed * 1664525u + 1013904223u;
+                const std::uint8_t a = x % 4 == 0 ? 255 : static_cast<std::uint8_t>((seed >> 24) / 4);
+                image(x, y) = RGBA8(40, static_cast<std::uint8_t>(120 + (seed >> 28)), 30, a);
+            }
+        }
+        return image;
+    }
+}
+
+TEST_CASE("mip: chain layout", "[mip]"){
+    STATIC_REQUIRE(mip::level_count(1, 1) == 1);
+    STATIC_REQUIRE(mip::level_count(256, 256) == 9);
+    STATIC_REQUIRE(mip::level_count(300, 7) == 9);
+    STATIC_REQUIRE(mip::level_count(1, 5) == 3);
+
+    mip::Chain<RGBA8> chain(300, 7);
+    REQUIRE(chain.levels() == 9);
+    REQUIRE(chain.width() == 300);
+    REQUIRE(chain.height() == 7);
+    std::size_t end = 0;
+    bool packed = true;
+    for(std::size_t i = 0; i < chain.levels(); i++){
+        const auto& level = chain.layout(i);
+        packed = packed && level.offset >= end && level.offset % image_row_alignment == 0 && level.offset - end < image_row_alignment;
+        packed = packed && level.width == std::max<std::size_t>(1, 300 >> i) && level.height == std::max<std::size_t>(1, 7 >> i);
+        packed = packed && static_cast<const void*>(chain.level(i).data()) == static_cast<const void*>(chain.bytes().data() + level.offset);
+        packed = packed && chain.level(i).row_pitch() == static_cast<std::ptrdiff_t>(level.width * sizeof(RGBA8));
+        end = level.offset + level.width * level.height * sizeof(RGBA8);
+    }
+    REQUIRE(packed);
+    REQUIRE(chain.layout(8).width == 1);
+    REQUIRE(chain.layout(8).height == 1);
+    REQUIRE(chain.bytes().size() >= end);
+    REQUIRE(chain.bytes().size() - end < image_row_alignment);
+}
+
+TEST_CASE("mip: levels are averages of the level above", "[mip]"){
+    Image<RGBA> base(4, 4);
+    for(std::size_t y = 0; y < 4; y++){
+        for(std::size_t x = 0; x < 4; x++){
+            const float v = static_cast<float>(x + 4 * y) / 16.0f;
+            base(x, y) = RGBA(v, v * 0.5f, 0.0f, 1.0f);
+        }
+    }
+    const auto chain = mip::generate(base);
+    REQUIRE(chain.levels() == 3);
+    REQUIRE(chain.level(0)(3, 2) == base(3, 2));
+    REQUIRE(chain.level(1)(1, 0).R() == (2 + 3 + 6 + 7) / 64.0f);
+    REQUIRE(chain.level(2)(0, 0).R() == 7.5f / 16.0f);
+    REQUIRE(chain.level(2)(0, 0).A() == 1.0f);
+
+    //odd sizes, both filters: flat stays flat all the way down
+    const Image<RGBA> flat(37, 21, RGBA(0.25f, 0.125f, 0.5f, 0.75f));
+    for(const Filter filter : {Filter::box, Filter::kaiser}){
+        const auto odd = mip::generate(flat, {.filter = filter});
+        REQUIRE(odd.levels() == 6);
+        REQUIRE(odd.layout(3).width == 4);
+        REQUIRE(odd.layout(3).height == 2);
+        bool still = true;
+        for(std::size_t i = 0; i < odd.levels(); i++){
+            for(std::size_t y = 0; y < odd.level(i).height(); y++){
+                for(const RGBA& p : odd.level(i).row(y)){
+                    for(std::size_t c = 0; c < 4; c++){
+                        still = still && std::abs(p[c] - flat(0, 0)[c]) < 1e-5f;
+                    }
+                }
+            }
+        }
+        REQUIRE(still);
+    }
+}
+
+TEST_CASE("mip: 8 bit levels average light, not sRGB codes", "[mip]"){
+    Image<RGBA8> checks(8, 8);
+    for(std::size_t y = 0; y < 8; y++){
+        for(std::size_t x = 0; x < 8; x++){
+            const std::uint8_t v = (x + y) % 2 ? 255 : 0;
+            checks(x, y) = RGBA8(v, v, v, 255);
+        }
+    }
+    const auto light = mip::generate(checks);
+    REQUIRE(light.level(0)(1, 0).R == 255);
+    REQUIRE(light.level(1)(2, 3).R == 188);
+    REQUIRE(light.level(3)(0, 0).G == 188);
+    REQUIRE(light.level(3)(0, 0).A == 255);
+
+    //data, a normal map say, averages as it's stored
+    const auto data = mip::generate(checks, {.srgb = false});
+    REQUIRE(data.level(1)(2, 3).R == 128);
+
+    //and a transparent pixel's colour stays out of its neighbours
+    Image<RGBA8> hole(2, 2, RGBA8(255, 0, 0, 255));
+    hole(1, 1) = RGBA8(0, 255, 0, 0);
+    for(const bool srgb : {true, false}){
+        const auto chain = mip::generate(hole, {.srgb = srgb});
+        REQUIRE(chain.level(1)(0, 0).R == 255);
+        REQUIRE(chain.level(1)(0, 0).G == 0);
+        REQUIRE(chain.level(1)(0, 0).A == 191);
+    }
+}
+
+TEST_CASE("mip: alpha coverage is kept for cutouts", "[mip]"){
+    const Image<RGBA8> grass = blades(256, 128);
+    const double base = mip::coverage(grass, 0.5f);
+    REQUIRE(std::abs(base - 0.25) < 1e-9);
+
+    //plain filtering thins the blades out to nothing
+    const auto thinned = mip::generate(grass);
+    REQUIRE(mip::coverage(thinned.level(2), 0.5f) < 0.05);
+
+    for(const Filter filter : {Filter::box, Filter::kaiser}){
+        const auto kept = mip::generate(grass, {.filter = filter, .alpha_cutoff = 0.5f});
+        bool close = true;
+        for(std::size_t i = 1; i < kept.levels() && kept.level(i).size() >= 64; i++){
+            close = close && std::abs(mip::coverage(kept.level(i), 0.5f) - base) < 0.02;
+        }
+        REQUIRE(close);
+    }
+
+    //no two rows alike, so the cut falls between distinct alphas and lands exactly
+    Image<RGBA> soft(64, 64);
+    for(std::size_t y = 0; y < 64; y++){
+        for(std::size_t x = 0; x < 64; x++){
+            const float a = x % 4 == 0 ? 1.0f : 0.1f + 0.3f * static_cast<float>(y) / 64.0f;
+            soft(x, y) = RGBA(0.5f * a, 0.25f * a, 0.0f, a);
+        }
+    }
+    const auto kept = mip::generate(soft, {.alpha_cutoff = 0.5f});
+    REQUIRE(std::abs(mip::coverage(kept.level(1), 0.5f) - 0.25) < 0.02);
+    //straight colour is untouched by the alpha scaling
+    REQUIRE(std::abs(kept.level(1)(0, 0).R() / kept.level(1)(0, 0).A() - 0.5f) < 1e-5f);
+    REQUIRE(kept.level(1)(0, 0).A() <= 1.0f);
+}
+
+TEST_CASE("mip benchmark", "[!benchmark][mip]"){
+    const Image<RGBA8> texture = blades(4096, 4096);
+
+    BENCHMARK("4096^2 RGBA8 chain, box"){
+        return mip::generate(texture).levels();
+    };
+    BENCHMARK("4096^2 RGBA8 chain, Kaiser"){
+        return mip::generate(texture, {.filter = Filter::kaiser}).levels();
+    };
+    BENCHMARK("4096^2 RGBA8 chain, box with alpha coverage"){
+        return mip::generate(texture, {.alpha_cutoff = 0.5f}).levels();
+    };
+}
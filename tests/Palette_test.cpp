@@ -0,0 +1,146 @@
+#define NDEBUG
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <vector>
+#include "../ES_palette.hpp"
+
+using namespace ES;
+
+namespace {
+    //soft gradients with noise on top, so there are many more colours than a palette holds
+    Image<RGBA8> photo(std::size_t width, std::size_t height){
+        Image<RGBA8> image(width, height);
+        std::uint32_t seed = 5;
+        for(std::size_t y = 0; y < height; y++){
+            for(std::size_t x = 0; x < width; x++){
+                seed = seed * 1664525u + 1013904223u;
+                const auto noise = static_cast<int>(seed >> 28);
+                image(x, y) = RGBA8(static_cast<std::uint8_t>(x * 255 / width), static_cast<std::uint8_t>(y * 255 / height),
+                                    static_cast<std::uint8_t>(std::min(255, 96 + noise * 8)), 255);
+            }
+        }
+        return image;
+    }
+
+    //each pixel's squared distance to its nearest palette entry, summed
+    double error(const Image<RGBA8>& image, const std::vector<RGBA8>& palette){
+        double sum = 0.0;
+        for(std::size_t y = 0; y < image.height(); y++){
+            for(const RGBA8& pixel : image.row(y)){
+                float best = std::numeric_limits<float>::infinity();
+                for(const RGBA8& entry : palette){
+                    best = std::min(best, palette::distance_squared(palette::point(pixel), palette::point(entry)));
+                }
+                sum += best;
+            }
+        }
+        return sum;
+    }
+
+    bool same(const RGBA8& a, const RGBA8& b){
+        return a.R == b.R && a.G == b.G && a.B == b.B && a.A == b.A;
+    }
+}
+
+TEST_CASE("palette: points", "[palette]"){
+    //every fully transparent colour is the same point
+    REQUIRE(palette::point(RGBA8(255, 0, 0, 0)) == palette::point(RGBA8(0, 90, 3, 0)));
+    REQUIRE(palette::point(RGBA8(200, 100, 50, 255)) == palette::Point{200.0f, 100.0f, 50.0f, 255.0f});
+    for(const RGBA8 c : {RGBA8(200, 100, 50, 255), RGBA8(10, 250, 128, 77), RGBA8(0, 0, 0, 0)}){
+        REQUIRE(same(palette::colour(palette::point(c)), c));
+    }
+}
+
+TEST_CASE("palette: k-d tree matches brute force", "[palette]"){
+    std::uint32_t seed = 3;
+    const auto next = [&]{
+        seed = seed * 1664525u + 1013904223u;
+        return static_cast<float>(seed >> 24);
+    };
+    std::vector<palette::Point> points(200);
+    for(palette::Point& p : points){
+        p = {next(), next(), next(), next()};
+    }
+    points[150] = points[20]; //a duplicate: the lower index wins
+    const palette::KdTree tree(points);
+    REQUIRE(tree.size() == points.size());
+    bool matches = true;
+    for(int i = 0; i < 2000; i++){
+        const palette::Point query{next(), next(), next(), next()};
+        std::size_t best = 0;
+        for(std::size_t j = 1; j < points.size(); j++){
+            best = palette::distance_squared(points[j], query) < palette::distance_squared(points[best], query) ? j : best;
+        }
+        matches = matches && tree.nearest(query) == best;
+    }
+    REQUIRE(matches);
+    REQUIRE(tree.nearest(points[20]) == 20);
+}
+
+TEST_CASE("palette: median cut keeps the colours of an image with few", "[palette]"){
+    const RGBA8 colours[] = {RGBA8(255, 0, 0, 255), RGBA8(0, 128, 0, 255), RGBA8(0, 0, 255, 255), RGBA8(240, 240, 240, 255),
+                             RGBA8(0, 0, 0, 0)};
+    Image<RGBA8> image(40, 30);
+    for(std::size_t y = 0; y < image.height(); y++){
+        for(std::size_t x = 0; x < image.width(); x++){
+            image(x, y) = colours[(x / 3 + y) % 5];
+        }
+    }
+    //transparent pixels of any colour are one entry
+    image(0, 0) = RGBA8(9, 9, 9, 0);
+    const std::vector<RGBA8> palette = palette::median_cut(image, 16);
+    REQUIRE(palette.size() == 5);
+    for(const RGBA8& c : colours){
+        REQUIRE(std::any_of(palette.begin(), palette.end(), [&](const RGBA8& p){ return same(p, c); }));
+    }
+    REQUIRE(palette::median_cut(image, 0).empty());
+    REQUIRE(palette::median_cut(image, 2).size() == 2);
+}
+
+TEST_CASE("palette: a big flat image keeps its colour", "[palette]"){
+    //a 4K frame of one colour, past where float totals stop adding up
+    const Image<RGBA8> image(3840, 2160, RGBA8(200, 120, 30, 255));
+    const std::vector<palette::Entry> entries = palette::histogram(image);
+    REQUIRE(entries.size() == 1);
+    REQUIRE(entries[0].weight == 3840.0f * 2160.0f);
+    REQUIRE(entries[0].point == palette::point(RGBA8(200, 120, 30, 255)));
+    const std::vector<RGBA8> palette = palette::median_cut(image, 4);
+    REQUIRE(palette.size() == 1);
+    REQUIRE(same(palette[0], RGBA8(200, 120, 30, 255)));
+}
+
+TEST_CASE("palette: k-means refines median cut", "[palette]"){
+    const Image<RGBA8> image = photo(128, 96);
+    const std::vector<RGBA8> cut = palette::median_cut(image, 16);
+    REQUIRE(cut.size() == 16);
+    parallel::ThreadPool pool(3);
+    const std::vector<RGBA8> refined = palette::kmeans(image, cut, 8, pool);
+    REQUIRE(refined.size() == 16);
+    REQUIRE(error(image, refined) < error(image, cut));
+    //the same on one thread
+    parallel::ThreadPool inline_pool(0);
+    const std::vector<RGBA8> alone = palette::generate(image, 16, 8, inline_pool);
+    bool equal = alone.size() == refined.size();
+    for(std::size_t i = 0; equal && i < alone.size(); i++){
+        equal = same(alone[i], refined[i]);
+    }
+    REQUIRE(equal);
+}
+
+TEST_CASE("palette benchmark", "[!benchmark][palette]"){
+    const Image<RGBA8> image = photo(1920, 1080);
+    const std::vector<RGBA8> cut = palette::median_cut(image, 256);
+
+    BENCHMARK("1080p histogram"){
+        return palette::histogram(image);
+    };
+    BENCHMARK("1080p median cut, 256 colours"){
+        return palette::median_cut(image, 256);
+    };
+    BENCHMARK("1080p 8 k-means rounds, 256 colours"){
+        return palette::kmeans(image, cut, 8);
+    };
+}
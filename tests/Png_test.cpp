@@ -0,0 +1,468 @@
+#define NDEBUG
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <vector>
+#include "../ColorN.hpp"
+#include "../Image.hpp"
+#include "../ES_zlib.hpp"
+#include "../ES_png.hpp"
+
+using namespace ES;
+
+namespace {
+
+    //made with zlib and a scratch PNG writer, from the formulas next to the tests
+    const std::uint8_t rgba8_filters[] = {
+        137, 80, 78, 71, 13, 10, 26, 10, 0, 0, 0, 13, 73, 72, 68, 82, 0, 0, 0, 13, 0, 0, 0, 7,
+        8, 6, 0, 0, 0, 211, 112, 199, 26, 0, 0, 0, 222, 73, 68, 65, 84, 120, 218, 99, 96, 96, 96, 248,
+        175, 202, 202, 248, 201, 139, 139, 229, 105, 62, 63, 231, 141, 41, 34, 2, 167, 119, 74, 74, 238, 187, 39, 167,
+        178, 145, 89, 217, 112, 137, 134, 134, 195, 116, 95, 221, 192, 174, 34, 163, 148, 218, 233, 230, 149, 5, 123, 108,
+        38, 36, 51, 114, 187, 51, 254, 1, 106, 250, 172, 202, 202, 12, 196, 172, 64, 204, 14, 196, 156, 64, 204, 13,
+        196, 188, 64, 204, 15, 196, 130, 64, 44, 12, 196, 162, 64, 44, 254, 153, 9, 168, 233, 47, 169, 152, 89, 172,
+        143, 169, 74, 66, 141, 241, 135, 132, 26, 19, 16, 51, 3, 49, 11, 16, 179, 2, 49, 219, 143, 25, 106, 236,
+        64, 154, 3, 136, 57, 127, 72, 44, 227, 2, 98, 110, 32, 230, 249, 193, 2, 214, 205, 138, 29, 171, 194, 216,
+        104, 106, 24, 204, 147, 89, 63, 196, 100, 176, 61, 110, 204, 229, 188, 182, 172, 136, 239, 228, 233, 114, 209, 61,
+        31, 106, 228, 214, 139, 54, 106, 46, 178, 106, 51, 155, 26, 223, 237, 218, 209, 50, 33, 172, 122, 229, 212, 204,
+        188, 115, 179, 234, 18, 63, 207, 159, 26, 194, 232, 180, 138, 237, 45, 169, 1, 1, 0, 254, 206, 123, 98, 139,
+        39, 135, 87, 0, 0, 0, 0, 73, 69, 78, 68, 174, 66, 96, 130,
+    };
+
+    const std::uint8_t rgb16_split[] = {
+        137, 80, 78, 71, 13, 10, 26, 10, 0, 0, 0, 13, 73, 72, 68, 82, 0, 0, 0, 5, 0, 0, 0, 4,
+        16, 2, 0, 0, 0, 153, 193, 190, 84, 0, 0, 0, 7, 73, 68, 65, 84, 120, 218, 99, 96, 96, 48, 176,
+        156, 48, 206, 224, 0, 0, 0, 7, 73, 68, 65, 84, 76, 40, 18, 96, 118, 176, 41, 246, 15, 82, 165, 0,
+        0, 0, 7, 73, 68, 65, 84, 40, 85, 96, 11, 176, 111, 168, 88, 66, 103, 117, 0, 0, 0, 7, 73, 68,
+        65, 84, 48, 224, 76, 112, 154, 80, 237, 149, 201, 142, 151, 0, 0, 0, 7, 73, 68, 65, 84, 192, 83, 224,
+        186, 160, 142, 145, 174, 58, 28, 160, 0, 0, 0, 7, 73, 68, 65, 84, 249, 169, 137, 92, 74, 184, 0, 234,
+        159, 170, 87, 0, 0, 0, 7, 73, 68, 65, 84, 51, 118, 200, 196, 242, 20, 31, 56, 10, 45, 98, 0, 0,
+        0, 7, 73, 68, 65, 84, 100, 230, 240, 146, 127, 110, 193, 225, 127, 169, 93, 0, 0, 0, 7, 73, 68, 65,
+        84, 204, 245, 133, 171, 4, 136, 49, 65, 85, 189, 50, 0, 0, 0, 6, 73, 68, 65, 84, 72, 0, 130, 149,
+        36, 99, 74, 38, 68, 46, 0, 0, 0, 0, 73, 69, 78, 68, 174, 66, 96, 130,
+    };
+
+    const std::uint8_t palette4_trns[] = {
+        137, 80, 78, 71, 13, 10, 26, 10, 0, 0, 0, 13, 73, 72, 68, 82, 0, 0, 0, 9, 0, 0, 0, 5,
+        4, 3, 0, 0, 0, 101, 125, 219, 88, 0, 0, 0, 48, 80, 76, 84, 69, 0, 255, 0, 16, 239, 7, 32,
+        223, 14, 48, 207, 21, 64, 191, 28, 80, 175, 35, 96, 159, 42, 112, 143, 49, 128, 127, 56, 144, 111, 63, 160,
+        95, 70, 176, 79, 77, 192, 63, 84, 208, 47, 91, 224, 31, 98, 240, 15, 105, 169, 226, 26, 41, 0, 0, 0,
+        4, 116, 82, 78, 83, 0, 60, 120, 180, 181, 8, 254, 5, 0, 0, 0, 33, 73, 68, 65, 84, 120, 218, 99,
+        96, 84, 118, 77, 111, 96, 84, 86, 82, 82, 18, 103, 2, 18, 74, 10, 204, 174, 64, 82, 138, 5, 196, 22,
+        4, 0, 67, 8, 4, 1, 61, 39, 239, 41, 0, 0, 0, 0, 73, 69, 78, 68, 174, 66, 96, 130,
+    };
+
+    const std::uint8_t grey_alpha8[] = {
+        137, 80, 78, 71, 13, 10, 26, 10, 0, 0, 0, 13, 73, 72, 68, 82, 0, 0, 0, 6, 0, 0, 0, 6,
+        8, 4, 0, 0, 0, 74, 197, 39, 195, 0, 0, 0, 78, 73, 68, 65, 84, 120, 218, 99, 96, 96, 150, 101,
+        182, 98, 14, 103, 46, 97, 158, 200, 204, 104, 202, 44, 203, 14, 131, 76, 166, 12, 166, 236, 166, 124, 166, 162,
+        166, 50, 166, 202, 204, 89, 76, 154, 124, 154, 66, 154, 162, 154, 146, 43, 101, 88, 76, 25, 128, 10, 248, 100,
+        129, 50, 178, 50, 12, 156, 204, 106, 106, 206, 158, 9, 57, 181, 253, 179, 54, 1, 0, 108, 19, 11, 206, 145,
+        115, 46, 35, 0, 0, 0, 0, 73, 69, 78, 68, 174, 66, 96, 130,
+    };
+
+    const std::uint8_t grey1[] = {
+        137, 80, 78, 71, 13, 10, 26, 10, 0, 0, 0, 13, 73, 72, 68, 82, 0, 0, 0, 11, 0, 0, 0, 3,
+        1, 0, 0, 0, 0, 109, 132, 200, 230, 0, 0, 0, 17, 73, 68, 65, 84, 120, 218, 99, 152, 228, 192, 168,
+        18, 195, 164, 186, 0, 0, 9, 115, 2, 27, 248, 25, 145, 79, 0, 0, 0, 0, 73, 69, 78, 68, 174, 66,
+        96, 130,
+    };
+
+    const std::uint8_t grey16_key[] = {
+        137, 80, 78, 71, 13, 10, 26, 10, 0, 0, 0, 13, 73, 72, 68, 82, 0, 0, 0, 4, 0, 0, 0, 4,
+        16, 0, 0, 0, 0, 220, 10, 29, 225, 0, 0, 0, 2, 116, 82, 78, 83, 70, 80, 187, 219, 116, 79, 0,
+        0, 0, 40, 73, 68, 65, 84, 120, 218, 99, 96, 96, 16, 238, 80, 23, 176, 154, 193, 104, 116, 66, 164, 67,
+        184, 67, 164, 131, 201, 248, 4, 4, 50, 167, 9, 40, 175, 80, 89, 161, 188, 2, 0, 175, 218, 11, 60, 106,
+        14, 253, 83, 0, 0, 0, 0, 73, 69, 78, 68, 174, 66, 96, 130,
+    };
+
+    const std::uint8_t rgb8_adam7[] = {
+        137, 80, 78, 71, 13, 10, 26, 10, 0, 0, 0, 13, 73, 72, 68, 82, 0, 0, 0, 10, 0, 0, 0, 9,
+        8, 2, 0, 0, 1, 243, 195, 26, 210, 0, 0, 0, 238, 73, 68, 65, 84, 120, 218, 99, 96, 96, 96, 152,
+        33, 193, 192, 104, 225, 0, 164, 28, 24, 124, 120, 24, 24, 91, 124, 20, 24, 100, 22, 48, 100, 172, 17, 216,
+        178, 67, 129, 65, 141, 141, 161, 72, 136, 129, 209, 105, 25, 135, 15, 143, 0, 147, 204, 2, 14, 153, 5, 18,
+        12, 124, 1, 12, 38, 97, 44, 81, 49, 28, 13, 73, 60, 203, 50, 4, 24, 181, 62, 0, 213, 241, 192, 17,
+        131, 48, 51, 131, 37, 39, 67, 60, 63, 67, 171, 40, 195, 106, 105, 6, 70, 197, 96, 38, 53, 54, 22, 56,
+        98, 226, 11, 0, 34, 54, 190, 0, 46, 190, 0, 62, 190, 0, 33, 102, 181, 69, 44, 82, 218, 156, 82, 218,
+        220, 82, 218, 188, 82, 171, 249, 89, 64, 242, 108, 108, 124, 108, 96, 121, 54, 1, 6, 118, 13, 6, 41, 109,
+        70, 93, 61, 38, 7, 67, 230, 96, 19, 150, 52, 115, 214, 74, 43, 182, 30, 91, 246, 249, 14, 28, 155, 156,
+        57, 25, 69, 43, 128, 54, 50, 227, 66, 64, 171, 24, 192, 22, 178, 128, 237, 228, 0, 91, 203, 3, 182, 89,
+        0, 100, 185, 194, 22, 6, 193, 85, 172, 130, 171, 216, 4, 87, 177, 11, 174, 226, 16, 92, 197, 41, 184, 138,
+        75, 112, 21, 183, 224, 42, 30, 193, 85, 188, 0, 145, 251, 44, 92, 155, 26, 3, 198, 0, 0, 0, 0, 73,
+        69, 78, 68, 174, 66, 96, 130,
+    };
+
+    const std::uint8_t grey2_adam7[] = {
+        137, 80, 78, 71, 13, 10, 26, 10, 0, 0, 0, 13, 73, 72, 68, 82, 0, 0, 0, 5, 0, 0, 0, 5,
+        2, 0, 0, 0, 1, 149, 179, 81, 14, 0, 0, 0, 28, 73, 68, 65, 84, 120, 218, 99, 96, 0, 131, 6,
+        198, 6, 6, 5, 134, 2, 198, 11, 76, 11, 24, 148, 24, 24, 25, 24, 0, 35, 15, 3, 40, 114, 218, 226,
+        62, 0, 0, 0, 0, 73, 69, 78, 68, 174, 66, 96, 130,
+    };
+
+    const std::uint8_t rgb8_stored_key[] = {
+        137, 80, 78, 71, 13, 10, 26, 10, 0, 0, 0, 13, 73, 72, 68, 82, 0, 0, 0, 3, 0, 0, 0, 3,
+        8, 2, 0, 0, 0, 217, 74, 34, 232, 0, 0, 0, 6, 116, 82, 78, 83, 0, 45, 0, 46, 0, 2, 139,
+        42, 230, 226, 0, 0, 0, 41, 73, 68, 65, 84, 120, 1, 1, 30, 0, 225, 255, 0, 0, 0, 0, 19, 3,
+        0, 38, 6, 0, 1, 7, 40, 0, 19, 3, 1, 19, 3, 1, 2, 7, 40, 0, 7, 40, 1, 7, 40, 2,
+        15, 47, 1, 51, 6, 123, 16, 239, 0, 0, 0, 0, 73, 69, 78, 68, 174, 66, 96, 130,
+    };
+
+    const std::uint8_t zlib_stream[] = {
+        120, 218, 237, 217, 55, 174, 92, 57, 16, 64, 209, 181, 125, 239, 189, 255, 25, 189, 55, 161, 102, 86, 63, 85,
+        59, 232, 96, 2, 161, 113, 9, 38, 130, 212, 234, 71, 190, 58, 232, 224, 26, 195, 98, 177, 88, 44, 22, 139,
+        197, 98, 177, 254, 246, 245, 231, 159, 127, 217, 108, 54, 155, 205, 102, 179, 217, 108, 246, 95, 190, 79, 66, 108,
+        123, 206, 214, 226, 232, 107, 123, 83, 199, 52, 187, 110, 51, 195, 8, 211, 245, 84, 124, 115, 123, 175, 92, 170,
+        93, 213, 244, 18, 227, 168, 213, 238, 148, 220, 218, 163, 198, 217, 67, 105, 117, 4, 239, 86, 218, 190, 77, 249,
+        144, 252, 187, 109, 82, 30, 35, 100, 151, 230, 48, 181, 133, 154, 146, 233, 62, 5, 231, 228, 3, 62, 199, 214,
+        90, 105, 75, 62, 154, 150, 95, 190, 21, 51, 75, 47, 187, 201, 223, 143, 146, 251, 200, 45, 20, 23, 123, 159,
+        102, 228, 146, 182, 155, 197, 218, 186, 124, 236, 46, 230, 213, 108, 72, 37, 203, 87, 246, 85, 163, 117, 193, 134,
+        54, 90, 45, 33, 230, 233, 138, 219, 177, 143, 218, 70, 143, 107, 151, 102, 198, 72, 43, 247, 214, 231, 202, 222,
+        187, 177, 183, 27, 217, 71, 215, 103, 142, 102, 151, 218, 118, 110, 122, 138, 208, 74, 92, 126, 150, 49, 103, 238,
+        85, 30, 219, 135, 221, 70, 176, 38, 149, 50, 236, 182, 171, 172, 186, 154, 233, 166, 181, 84, 147, 217, 49, 203,
+        223, 78, 223, 107, 201, 201, 164, 94, 172, 169, 179, 58, 215, 195, 114, 174, 201, 35, 45, 99, 66, 110, 219, 140,
+        185, 150, 139, 181, 164, 98, 115, 245, 195, 202, 119, 56, 61, 99, 200, 91, 254, 255, 149, 228, 236, 169, 103, 147,
+        229, 40, 54, 134, 20, 203, 114, 198, 186, 108, 183, 223, 242, 86, 138, 220, 241, 46, 206, 215, 237, 118, 182, 113,
+        229, 93, 107, 243, 69, 174, 187, 204, 50, 205, 76, 165, 59, 57, 130, 29, 169, 141, 104, 108, 150, 75, 233, 211,
+        219, 233, 103, 28, 214, 134, 97, 194, 136, 77, 174, 218, 70, 223, 119, 146, 7, 139, 102, 250, 44, 175, 43, 154,
+        226, 115, 54, 242, 101, 190, 217, 158, 118, 144, 7, 233, 123, 54, 155, 146, 175, 205, 165, 106, 90, 172, 222, 200,
+        9, 162, 156, 110, 200, 5, 141, 150, 229, 58, 229, 86, 146, 105, 206, 184, 41, 179, 176, 67, 8, 214, 167, 97,
+        67, 245, 242, 114, 221, 244, 205, 203, 131, 251, 110, 118, 218, 107, 78, 31, 103, 94, 193, 246, 152, 131, 11, 161,
+        132, 85, 108, 13, 219, 203, 0, 141, 181, 141, 149, 155, 111, 83, 110, 168, 239, 33, 23, 235, 154, 190, 182, 33,
+        227, 96, 83, 221, 86, 230, 66, 198, 207, 205, 38, 83, 152, 187, 201, 222, 214, 57, 229, 26, 221, 144, 25, 149,
+        17, 77, 51, 78, 235, 230, 146, 243, 174, 36, 243, 22, 229, 117, 244, 36, 179, 38, 19, 84, 123, 146, 183, 232,
+        75, 138, 177, 249, 26, 140, 107, 242, 98, 195, 176, 115, 204, 62, 202, 94, 75, 38, 221, 238, 46, 231, 50, 89,
+        158, 61, 196, 186, 135, 47, 118, 117, 47, 135, 25, 49, 71, 189, 161, 233, 119, 217, 114, 223, 114, 101, 242, 165,
+        206, 76, 103, 167, 149, 91, 179, 51, 165, 214, 141, 45, 94, 206, 101, 75, 108, 102, 173, 229, 171, 14, 205, 48,
+        75, 166, 194, 136, 159, 34, 95, 40, 51, 54, 74, 31, 201, 6, 31, 70, 94, 50, 202, 187, 248, 145, 101, 92,
+        178, 188, 141, 20, 183, 220, 155, 51, 114, 220, 177, 167, 220, 87, 244, 105, 154, 188, 67, 75, 51, 13, 191, 66,
+        109, 118, 183, 108, 100, 192, 70, 53, 50, 56, 242, 41, 107, 66, 201, 67, 100, 85, 155, 182, 140, 219, 244, 198,
+        6, 35, 215, 146, 172, 12, 148, 145, 63, 153, 45, 15, 181, 70, 140, 213, 108, 153, 197, 26, 197, 81, 205, 242,
+        73, 43, 175, 188, 140, 67, 156, 159, 226, 28, 231, 56, 63, 122, 231, 7, 253, 158, 159, 225, 28, 231, 56, 63,
+        122, 231, 7, 253, 158, 159, 227, 28, 231, 56, 63, 122, 231, 7, 253, 158, 95, 224, 28, 231, 56, 63, 122, 231,
+        7, 253, 158, 95, 226, 28, 231, 56, 63, 122, 231, 7, 253, 158, 95, 225, 28, 231, 56, 63, 122, 231, 7, 253,
+        158, 95, 227, 28, 231, 56, 167, 159, 171, 243, 27, 156, 227, 28, 231, 244, 115, 117, 126, 139, 115, 156, 227, 156,
+        126, 174, 206, 239, 112, 142, 115, 156, 211, 207, 213, 249, 61, 206, 113, 142, 115, 250, 185, 58, 127, 192, 57, 206,
+        113, 78, 63, 87, 231, 143, 56, 199, 57, 206, 233, 231, 234, 252, 9, 231, 56, 199, 57, 253, 92, 157, 63, 227,
+        28, 231, 56, 167, 159, 171, 243, 23, 156, 227, 28, 231, 244, 115, 117, 254, 138, 115, 156, 227, 156, 126, 174, 206,
+        223, 112, 142, 115, 156, 211, 207, 213, 249, 59, 206, 113, 142, 115, 250, 185, 58, 255, 192, 57, 206, 113, 78, 63,
+        87, 231, 159, 56, 199, 57, 206, 233, 231, 234, 252, 11, 231, 56, 199, 57, 253, 92, 157, 127, 227, 28, 231, 56,
+        167, 159, 171, 243, 31, 156, 227, 28, 231, 244, 115, 117, 254, 139, 115, 156, 227, 156, 126, 174, 206, 79, 112, 142,
+        115, 156, 211, 207, 213, 249, 233, 33, 206, 207, 112, 142, 115, 156, 211, 213, 212, 249, 57, 206, 113, 142, 115, 186,
+        154, 58, 191, 192, 57, 206, 113, 78, 87, 83, 231, 151, 56, 199, 57, 206, 233, 106, 234, 252, 10, 231, 56, 199,
+        57, 93, 77, 157, 95, 227, 28, 231, 56, 167, 171, 169, 243, 27, 156, 227, 28, 231, 244, 115, 117, 126, 139, 115,
+        156, 227, 156, 126, 174, 206, 239, 112, 142, 115, 156, 211, 207, 213, 249, 61, 206, 113, 142, 115, 250, 185, 58, 127,
+        192, 57, 206, 113, 78, 63, 87, 231, 143, 56, 199, 57, 206, 233, 231, 234, 252, 9, 231, 56, 199, 57, 253, 92,
+        157, 63, 227, 28, 231, 56, 167, 159, 171, 243, 23, 156, 227, 28, 231, 244, 115, 117, 254, 138, 115, 156, 227, 156,
+        126, 174, 206, 223, 112, 142, 115, 156, 211, 207, 213, 249, 59, 206, 113, 142, 115, 250, 185, 58, 255, 192, 57, 206,
+        113, 78, 63, 87, 231, 159, 56, 199, 57, 206, 233, 231, 234, 252, 11, 231, 56, 199, 57, 253, 92, 157, 127, 227,
+        28, 231, 56, 167, 159, 171, 243, 31, 156, 227, 28, 231, 244, 115, 117, 254, 139, 115, 156, 227, 156, 126, 174, 206,
+        79, 112, 142, 115, 156, 211, 207, 213, 249, 41, 206, 113, 142, 115, 250, 185, 58, 63, 59, 196, 249, 57, 206, 113,
+        142, 115, 186, 154, 58, 191, 192, 57, 206, 113, 78, 87, 83, 231, 151, 56, 199, 57, 206, 233, 106, 234, 252, 10,
+        231, 56, 199, 57, 93, 77, 157, 95, 227, 28, 231, 56, 167, 171, 169, 243, 27, 156, 227, 28, 231, 116, 53, 117,
+        126, 139, 115, 156, 227, 156, 126, 174, 206, 239, 112, 142, 115, 156, 211, 207, 213, 249, 61, 206, 113, 142, 115, 250,
+        185, 58, 127, 192, 57, 206, 113, 78, 63, 87, 231, 143, 56, 199, 57, 206, 233, 231, 234, 252, 9, 231, 56, 199,
+        57, 253, 92, 157, 63, 227, 28, 231, 56, 167, 159, 171, 243, 23, 156, 227, 28, 231, 244, 115, 117, 254, 138, 115,
+        156, 227, 156, 126, 174, 206, 223, 112, 142, 115, 156, 211, 207, 213, 249, 59, 206, 113, 142, 115, 250, 185, 58, 255,
+        192, 57, 206, 113, 78, 63, 87, 231, 159, 56, 199, 57, 206, 233, 231, 234, 252, 11, 231, 56, 199, 57, 253, 92,
+        157, 127, 227, 28, 231, 56, 167, 159, 171, 243, 31, 156, 227, 28, 231, 244, 115, 117, 254, 139, 115, 156, 227, 156,
+        126, 174, 206, 79, 112, 142, 115, 156, 211, 207, 213, 249, 41, 206, 113, 142, 115, 250, 185, 58, 63, 195, 57, 206,
+        113, 78, 63, 87, 231, 231, 135, 56, 191, 192, 57, 206, 113, 78, 87, 83, 231, 151, 56, 199, 57, 206, 233, 106,
+        234, 252, 10, 231, 56, 199, 57, 93, 77, 157, 95, 227, 28, 231, 56, 167, 171, 169, 243, 27, 156, 227, 28, 231,
+        116, 53, 117, 126, 139, 115, 156, 227, 156, 174, 166, 206, 239, 112, 142, 115, 156, 211, 207, 213, 249, 61, 206, 113,
+        142, 115, 250, 185, 58, 127, 192, 57, 206, 113, 78, 63, 87, 231, 143, 56, 199, 57, 206, 233, 231, 234, 252, 9,
+        231, 56, 199, 57, 253, 92, 157, 63, 227, 28, 231, 56, 167, 159, 171, 243, 23, 156, 227, 28, 231, 244, 115, 117,
+        254, 138, 115, 156, 227, 156, 126, 174, 206, 223, 112, 142, 115, 156, 211, 207, 213, 249, 59, 206, 113, 142, 115, 250,
+        185, 58, 255, 192, 57, 206, 113, 78, 63, 87, 231, 159, 56, 199, 57, 206, 233, 231, 234, 252, 11, 231, 56, 199,
+        57, 253, 92, 157, 127, 227, 28, 231, 56, 167, 159, 171, 243, 31, 156, 227, 28, 231, 244, 115, 117, 254, 139, 115,
+        156, 227, 156, 126, 174, 206, 79, 112, 142, 115, 156, 211, 207, 213, 249, 41, 206, 113, 142, 115, 250, 185, 58, 63,
+        195, 57, 206, 113, 78, 63, 87, 231, 231, 56, 199, 57, 206, 233, 231, 234, 252, 226, 16, 231, 151, 56, 199, 57,
+        206, 233, 106, 234, 252, 10, 231, 56, 199, 57, 93, 77, 157, 95, 227, 28, 231, 56, 167, 171, 169, 129, 27, 156,
+        227, 28, 231, 116, 53, 117, 126, 139, 115, 156, 227, 156, 174, 166, 206, 239, 112, 142, 115, 156, 211, 213, 212, 249,
+        61, 206, 113, 142, 115, 250, 185, 58, 127, 192, 57, 206, 113, 78, 63, 87, 231, 143, 56, 199, 57, 206, 233, 231,
+        234, 252, 9, 231, 56, 199, 57, 253, 92, 157, 63, 227, 28, 231, 255, 183, 243, 255, 0, 60, 137, 117, 56,
+    };
+
+    template <typename Pixel, std::size_t N>
+    Image<Pixel> decoded(const std::uint8_t (&file)[N]){
+        Image<Pixel> image;
+        REQUIRE(png::decode(std::span<const std::uint8_t>(file, N), image) == png::Error::none);
+        return image;
+    }
+
+    std::vector<std::uint8_t> zlib_stream_raw(){
+        std::vector<std::uint8_t> raw(3000, 'a');
+        for(int i = 0; i < 1000; i++){
+            raw.insert(raw.end(), {'x', 'y', 'z'});
+        }
+        std::vector<std::uint8_t> block;
+        std::uint32_t seed = 12345;
+        for(int i = 0; i < 1000; i++){
+            seed = (seed * 1103515245u + 12345u) & 0x7fffffffu;
+            block.push_back(static_cast<std::uint8_t>(97 + (seed >> 16) % 16));
+        }
+        for(int k = 0; k < 120; k++){
+            std::vector<std::uint8_t> copy = block;
+            copy[(k * 37) % 1000] = static_cast<std::uint8_t>(65 + k % 26);
+            raw.insert(raw.end(), copy.begin(), copy.end());
+        }
+        return raw;
+    }
+
+    void append_be32(std::vector<std::uint8_t>& out, std::uint32_t value){
+        out.insert(out.end(), {std::uint8_t(value >> 24), std::uint8_t(value >> 16), std::uint8_t(value >> 8), std::uint8_t(value)});
+    }
+
+    void append_chunk(std::vector<std::uint8_t>& out, const char* type, std::span<const std::uint8_t> data){
+        append_be32(out, static_cast<std::uint32_t>(data.size()));
+        out.insert(out.end(), type, type + 4);
+        out.insert(out.end(), data.begin(), data.end());
+        append_be32(out, 0); //the decoder doesn't look at CRCs
+    }
+
+    //a big RGBA8 PNG for the benchmarks: deflate stored blocks (so the time is ours, not the compressor's), the rows
+    //cycling through every filter type
+    std::vector<std::uint8_t> stored_rgba_png(std::uint32_t width, std::uint32_t height){
+        std::vector<std::uint8_t> raw;
+        for(std::uint32_t y = 0; y < height; y++){
+            raw.push_back(static_cast<std::uint8_t>(y % 5));
+            for(std::uint32_t x = 0; x < 4 * width; x++){
+                raw.push_back(static_cast<std::uint8_t>(x * 7 + y * 13));
+            }
+        }
+        std::vector<std::uint8_t> zlib = {0x78, 0x01};
+        for(std::size_t i = 0; i < raw.size(); i += 65535){
+            const std::size_t length = std::min<std::size_t>(65535, raw.size() - i);
+            zlib.push_back(i + length == raw.size() ? 1 : 0);
+            zlib.insert(zlib.end(), {std::uint8_t(length), std::uint8_t(length >> 8), std::uint8_t(~length), std::uint8_t(~length >> 8)});
+            zlib.insert(zlib.end(), raw.begin() + static_cast<std::ptrdiff_t>(i), raw.begin() + static_cast<std::ptrdiff_t>(i + length));
+        }
+        append_be32(zlib, 0);
+
+        std::vector<std::uint8_t> file = {137, 80, 78, 71, 13, 10, 26, 10};
+        std::vector<std::uint8_t> header;
+        append_be32(header, width);
+        append_be32(header, height);
+        header.insert(header.end(), {8, 6, 0, 0, 0});
+        append_chunk(file, "IHDR", header);
+        append_chunk(file, "IDAT", zlib);
+        append_chunk(file, "IEND", {});
+        return file;
+    }
+
+    std::filesystem::path cat_path(){
+        return std::filesystem::path(__FILE__).parent_path() / ".." / "testCat.png";
+    }
+}
+
+TEST_CASE("zlib: inflates dynamic blocks with short and long matches across window slides", "[png]"){
+    std::vector<std::uint8_t> out;
+    REQUIRE(zlib::inflate(zlib_stream, out) == zlib::Status::ok);
+    REQUIRE(out == zlib_stream_raw());
+
+    //pulled out a few bytes at a time, the same bytes come out
+    zlib::Inflater<zlib::SpanSource> inflater(zlib::SpanSource{zlib_stream});
+    std::vector<std::uint8_t> pieces(out.size());
+    for(std::size_t i = 0; i < pieces.size(); i += 333){
+        const std::size_t count = std::min<std::size_t>(333, pieces.size() - i);
+        REQUIRE(inflater.read(std::span(pieces).subspan(i, count)) == zlib::Status::ok);
+    }
+    REQUIRE(pieces == out);
+    std::uint8_t extra;
+    REQUIRE(inflater.read(std::span(&extra, 1)) == zlib::Status::end_of_stream);
+    REQUIRE(inflater.finished());
+}
+
+TEST_CASE("zlib: reports truncated and corrupt streams", "[png]"){
+    std::vector<std::uint8_t> out;
+    REQUIRE(zlib::inflate(std::span(zlib_stream).first(sizeof(zlib_stream) / 2), out) == zlib::Status::truncated);
+
+    std::vector<std::uint8_t> bad_header(std::begin(zlib_stream), std::end(zlib_stream));
+    bad_header[1] ^= 1;
+    out.clear();
+    REQUIRE(zlib::inflate(bad_header, out) == zlib::Status::corrupt);
+
+    const std::uint8_t reserved_block[] = {0x78, 0x9c, 0x07, 0x00};
+    REQUIRE(zlib::inflate(reserved_block, out) == zlib::Status::corrupt);
+}
+
+TEST_CASE("png: RGBA8 through every filter type", "[png]"){
+    png::Info info;
+    REQUIRE(png::read_info(rgba8_filters, info) == png::Error::none);
+    REQUIRE(info.width == 13);
+    REQUIRE(info.height == 7);
+    REQUIRE(info.color_type == png::ColorType::rgba);
+    REQUIRE(info.has_transparency);
+
+    const Image<RGBA8> image = decoded<RGBA8>(rgba8_filters);
+    bool all = true;
+    for(std::size_t y = 0; y < 7; y++){
+        for(std::size_t x = 0; x < 13; x++){
+            const RGBA8 p = image(x, y);
+            all = all && p.R == ((x * 37 + y * 11) & 255) && p.G == ((x * 5 + y * 71) & 255)
+                      && p.B == ((x * x + y) & 255) && p.A == ((255 - x * 13 - y * 3) & 255);
+        }
+    }
+    REQUIRE(all);
+
+    const Image<RGB8> opaque = decoded<RGB8>(rgba8_filters);
+    REQUIRE(opaque(12, 6).R == image(12, 6).R);
+    REQUIRE(opaque(12, 6).B == image(12, 6).B);
+}
+
+TEST_CASE("png: 16 bit RGB split over many IDAT chunks keeps the high byte", "[png]"){
+    const Image<RGBA8> image = decoded<RGBA8>(rgb16_split);
+    bool all = true;
+    for(std::size_t y = 0; y < 4; y++){
+        for(std::size_t x = 0; x < 5; x++){
+            const RGBA8 p = image(x, y);
+            all = all && p.R == (((x * 4099 + y * 997) & 0xffff) >> 8) && p.G == (((x * 4099 + y * 997 + 12345) & 0xffff) >> 8)
+                      && p.B == (((x * 4099 + y * 997 + 24690) & 0xffff) >> 8) && p.A == 255;
+        }
+    }
+    REQUIRE(all);
+}
+
+TEST_CASE("png: palettes, grey and transparency", "[png]"){
+    SECTION("4 bit palette with tRNS"){
+        const Image<RGBA8> image = decoded<RGBA8>(palette4_trns);
+        bool all = true;
+        for(std::size_t y = 0; y < 5; y++){
+            for(std::size_t x = 0; x < 9; x++){
+                const std::size_t i = (x + 2 * y) % 16;
+                const RGBA8 p = image(x, y);
+                all = all && p.R == i * 16 && p.G == 255 - i * 16 && p.B == i * 7 && p.A == (i < 4 ? i * 60 : 255);
+            }
+        }
+        REQUIRE(all);
+    }
+    SECTION("8 bit grey and alpha"){
+        const Image<RGBA8> image = decoded<RGBA8>(grey_alpha8);
+        bool all = true;
+        for(std::size_t y = 0; y < 6; y++){
+            for(std::size_t x = 0; x < 6; x++){
+                const RGBA8 p = image(x, y);
+                all = all && p.R == ((x * 29 + y * 53) & 255) && p.G == p.R && p.B == p.R && p.A == ((x * y * 7 + 3) & 255);
+            }
+        }
+        REQUIRE(all);
+    }
+    SECTION("1 bit grey"){
+        const Image<RGB8> image = decoded<RGB8>(grey1);
+        bool all = true;
+        for(std::size_t y = 0; y < 3; y++){
+            for(std::size_t x = 0; x < 11; x++){
+                all = all && image(x, y).G == ((x + y) % 3 == 0 ? 255 : 0);
+            }
+        }
+        REQUIRE(all);
+    }
+    SECTION("16 bit grey with a transparent key"){
+        png::Info info;
+        REQUIRE(png::read_info(grey16_key, info) == png::Error::none);
+        REQUIRE(info.has_transparency);
+        const Image<RGBA8> image = decoded<RGBA8>(grey16_key);
+        REQUIRE(image(1, 1).A == 0);
+        REQUIRE(image(2, 1).A == 255);
+        REQUIRE(image(3, 2).R == (((3 * 5000 + 2 * 13000) & 0xffff) >> 8));
+    }
+    SECTION("stored deflate blocks, RGB with a transparent key"){
+        const Image<RGBA8> image = decoded<RGBA8>(rgb8_stored_key);
+        REQUIRE(image(2, 1).A == 0);
+        REQUIRE(image(1, 2).A == 255);
+        REQUIRE(image(1, 2).G == ((3 + 2 * 40) & 255));
+    }
+}
+
+TEST_CASE("png: Adam7 passes land on the right pixels", "[png]"){
+    const Image<RGB8> image = decoded<RGB8>(rgb8_adam7);
+    bool all = true;
+    for(std::size_t y = 0; y < 9; y++){
+        for(std::size_t x = 0; x < 10; x++){
+            const RGB8 p = image(x, y);
+            all = all && p.R == ((x * 19 + y * 7) & 255) && p.G == ((x * 3 + y * 40) & 255) && p.B == ((x * y) & 255);
+        }
+    }
+    REQUIRE(all);
+
+    //small enough that some passes are empty
+    const Image<RGBA8> small = decoded<RGBA8>(grey2_adam7);
+    bool small_all = true;
+    for(std::size_t y = 0; y < 5; y++){
+        for(std::size_t x = 0; x < 5; x++){
+            small_all = small_all && small(x, y).R == ((x * y + x) % 4) * 85;
+        }
+    }
+    REQUIRE(small_all);
+}
+
+TEST_CASE("png: decodes into a sub-rectangle of a bigger image", "[png]"){
+    Image<RGBA8> canvas(20, 10, RGBA8(1, 1, 1, 1));
+    REQUIRE(png::decode(rgba8_filters, canvas.subview(4, 2, 13, 7)) == png::Error::none);
+    REQUIRE(canvas(4, 2).A == 255);
+    REQUIRE(canvas(16, 8).R == ((12 * 37 + 6 * 11) & 255));
+    REQUIRE(canvas(3, 2).R == 1);
+    REQUIRE(canvas(17, 8).R == 1);
+
+    //a pixel short either way is reported and nothing is written
+    REQUIRE(png::decode(rgba8_filters, canvas.subview(0, 0, 12, 7)) == png::Error::wrong_size);
+    REQUIRE(png::decode(rgba8_filters, canvas.subview(0, 0, 13, 8)) == png::Error::wrong_size);
+    REQUIRE(canvas(0, 0).R == 1);
+}
+
+TEST_CASE("png: broken files are reported, not decoded", "[png]"){
+    Image<RGBA8> image;
+    const std::uint8_t not_png[] = {'G', 'I', 'F', '8', '9', 'a', 0, 0, 0, 0};
+    REQUIRE(png::decode(not_png, image) == png::Error::not_png);
+    REQUIRE(png::decode(std::span(rgba8_filters).first(20), image) == png::Error::truncated);
+    REQUIRE(png::decode(std::span(rgba8_filters).first(sizeof(rgba8_filters) - 40), image) == png::Error::truncated);
+
+    std::vector<std::uint8_t> bad_filter(std::begin(rgb8_stored_key), std::end(rgb8_stored_key));
+    //the first filter type byte sits after the zlib header and the stored block header
+    const std::size_t idat_data = 8 + 25 + 18 + 8;
+    bad_filter[idat_data + 2 + 5] = 9;
+    REQUIRE(png::decode(bad_filter, image) == png::Error::corrupt);
+
+    REQUIRE(png::load(std::filesystem::path("no/such/file.png"), image) == png::Error::io);
+}
+
+TEST_CASE("png: testCat.png", "[png]"){
+    Image<RGBA8> cat;
+    if(png::load(cat_path(), cat) == png::Error::io){
+        return; //not every build copies the assets next to the tests
+    }
+    REQUIRE(cat.width() == 32);
+    REQUIRE(cat.height() == 32);
+    std::size_t sum = 0;
+    for(std::size_t y = 0; y < 32; y++){
+        for(const RGBA8 p : cat.row(y)){
+            sum += p.R + p.G + p.B + p.A;
+        }
+    }
+    REQUIRE(sum == 636225);
+    REQUIRE(cat(0, 0).R == 255);
+    REQUIRE(cat(0, 0).A == 0);
+    REQUIRE(cat(16, 16).R == 0);
+    REQUIRE(cat(16, 16).A == 255);
+}
+
+TEST_CASE("png: decode benchmark", "[!benchmark][png]"){
+    const std::vector<std::uint8_t> big = stored_rgba_png(1024, 1024);
+    Image<RGBA8> rgba(1024, 1024);
+    Image<RGB8> rgb(1024, 1024);
+
+    //4 MB of RGBA a pass, for MB/s against other decoders divide 4 by the mean
+    BENCHMARK("1024x1024 RGBA8, stored, all filters -> RGBA8"){
+        return png::decode(big, rgba.view());
+    };
+    BENCHMARK("1024x1024 RGBA8, stored, all filters -> RGB8"){
+        return png::decode(big, rgb.view());
+    };
+
+    std::vector<std::uint8_t> out;
+    out.reserve(1 << 17);
+    BENCHMARK("inflate 126 KB, dynamic Huffman"){
+        out.clear();
+        return zlib::inflate(zlib_stream, out);
+    };
+}
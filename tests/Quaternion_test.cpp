@@ -1,5 +1,7 @@
 #define NDEBUG
 #include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <vector>
 #include "../ES_math.hpp"
 #include "../Quaternion.hpp"
 #include "../VectorN.hpp"
@@ -535,7 +537,7 @@ TEST_CASE("Quaternion non-commutativity", "[Quaternion]"){
     auto result2 = q2 * q1;
     
     REQUIRE(result1.w() == result2.w());
-    REQUIRE(result1.x() != result2.x() || result1.y() != result2.y() || result1.z() != result2.z());
+    REQUIRE((result1.x() != result2.x() || result1.y() != result2.y() || result1.z() != result2.z()));
 }
 
 TEST_CASE("Quaternion rotation composition", "[Quaternion]"){
@@ -554,4 +556,122 @@ TEST_CASE("Quaternion rotation composition", "[Quaternion]"){
     REQUIRE(math::approx_equal(rotated[0], 0.0f, 0.001f));
     REQUIRE(math::approx_equal(rotated[1], 1.0f, 0.001f));
     REQUIRE(math::approx_equal(rotated[2], 0.0f, 0.001f));
-}
\ No newline at end of file
+}
+
+TEST_CASE("Quaternion log and exp", "[Quaternion]"){
+    Vector3<float> axis(1.0f, 2.0f, -2.0f);
+    Quaternion<float> q(axis, Angle<in_radians, float>(1.2f));
+
+    auto v = q.log();
+    REQUIRE(math::approx_equal(v.magnitude(), 0.6f, 0.0001f)); //half the angle
+    REQUIRE(math::approx_equal(v[0] * 3.0f / 0.6f, 1.0f, 0.0001f));
+
+    auto back = Quaternion<float>::exp(v);
+    for(std::size_t i = 0; i < 4; i++){
+        REQUIRE(math::approx_equal(back[i], q[i], 0.0001f));
+    }
+
+    auto identity = Quaternion<float>::identity();
+    REQUIRE(identity.log().magnitude() == 0.0f);
+    REQUIRE(Quaternion<float>::exp(identity.log()).w() == 1.0f);
+}
+
+namespace {
+    //one rotation for each of from_matrix3's four cases, plus the half turns that sit right on their boundaries
+    std::vector<Quaternion<float>> conversion_rotations(){
+        std::vector<Quaternion<float>> rotations;
+        const Vector3<float> axes[] = {{1.0f, 0.0f, 0.0f}, {0.0f, 1.0f, 0.0f}, {0.0f, 0.0f, 1.0f}, {1.0f, -2.0f, 0.5f}, {-0.3f, 0.2f, 1.0f}};
+        const float angles[] = {0.0f, 0.4f, 1.9f, 2.9f, math::pi<float>};
+        for(const auto& axis : axes){
+            for(float angle : angles){
+                rotations.emplace_back(axis, Angle<in_radians, float>(angle));
+            }
+        }
+        return rotations;
+    }
+
+    bool same_rotation(const Quaternion<float>& a, const Quaternion<float>& b, float epsilon){
+        return std::fabs(std::fabs(a.dot(b)) - 1.0f) < epsilon;
+    }
+}
+
+TEST_CASE("Quaternion to_matrix4 matches to_matrix3", "[Quaternion]"){
+    Quaternion<float> q(Vector3<float>(1.0f, 2.0f, 3.0f), Angle<in_radians, float>(0.8f));
+    auto m3 = q.to_matrix3();
+    auto m4 = q.to_matrix4();
+    for(std::size_t row = 0; row < 3; row++){
+        for(std::size_t col = 0; col < 3; col++){
+            REQUIRE(m4(row, col) == m3(row, col));
+        }
+        REQUIRE(m4(row, 3) == 0.0f);
+        REQUIRE(m4(3, row) == 0.0f);
+    }
+    REQUIRE(m4(3, 3) == 1.0f);
+}
+
+TEST_CASE("Quaternion from_matrix3 round trips every case", "[Quaternion]"){
+    for(const auto& q : conversion_rotations()){
+        REQUIRE(same_rotation(Quaternion<float>::from_matrix3(q.to_matrix3()), q, 1e-6f));
+        REQUIRE(same_rotation(Quaternion<float>::from_matrix4(q.to_matrix4()), q, 1e-6f));
+        REQUIRE(std::fabs(Quaternion<float>::from_matrix3(q.to_matrix3()).length() - 1.0f) < 1e-6f);
+    }
+}
+
+TEST_CASE("Quaternion batch matrix conversions match the scalar ones", "[Quaternion]"){
+    const auto rotations = conversion_rotations(); //25, not a multiple of any lane count
+    std::vector<Matrix<float,3>> m3(rotations.size());
+    std::vector<Matrix<float,4>> m4(rotations.size());
+    Quaternion<float>::to_matrices3(rotations, m3);
+    Quaternion<float>::to_matrices4(rotations, m4);
+
+    std::vector<Quaternion<float>> back3(rotations.size()), back4(rotations.size());
+    Quaternion<float>::from_matrices3(m3, back3);
+    Quaternion<float>::from_matrices4(m4, back4);
+    for(std::size_t i = 0; i < rotations.size(); i++){
+        REQUIRE(m3[i].almost_equal(rotations[i].to_matrix3(), 1e-6f));
+        REQUIRE(m4[i].almost_equal(rotations[i].to_matrix4(), 1e-6f));
+        const auto expected = Quaternion<float>::from_matrix3(m3[i]);
+        for(std::size_t k = 0; k < 4; k++){
+            REQUIRE(back3[i][k] == expected[k]);
+            REQUIRE(back4[i][k] == expected[k]);
+        }
+    }
+}
+
+TEST_CASE("Quaternion matrix conversions of 50k rotations", "[Quaternion][!benchmark]"){
+    const std::size_t count = 50'000;
+    std::vector<Quaternion<float>> rotations;
+    rotations.reserve(count);
+    for(std::size_t i = 0; i < count; i++){
+        const float f = static_cast<float>(i);
+        rotations.emplace_back(Vector3<float>(std::sin(f), std::cos(f * 0.7f), 0.5f), Angle<in_radians, float>(f * 0.001f));
+    }
+    std::vector<Matrix<float,3>> matrices(count);
+    Quaternion<float>::to_matrices3(rotations, matrices);
+    std::vector<Matrix<float,4>> matrices4(count);
+    std::vector<Quaternion<float>> out(count);
+
+    BENCHMARK("to_matrix4 per rotation"){
+        for(std::size_t i = 0; i < count; i++) matrices4[i] = rotations[i].to_matrix4();
+        return matrices4[count - 1](0, 0);
+    };
+    BENCHMARK("to_matrices4 batch"){
+        Quaternion<float>::to_matrices4(rotations, matrices4);
+        return matrices4[count - 1](0, 0);
+    };
+    BENCHMARK("from_matrix3 per matrix"){
+        for(std::size_t i = 0; i < count; i++) out[i] = Quaternion<float>::from_matrix3(matrices[i]);
+        return out[count - 1][0];
+    };
+    BENCHMARK("from_matrices3 batch"){
+        Quaternion<float>::from_matrices3(matrices, out);
+        return out[count - 1][0];
+    };
+}
+
+TEST_CASE("Quaternion from_matrix3 is constexpr", "[Quaternion]"){
+    constexpr Quaternion<double> q(0.5, 0.5, -0.5, 0.5);
+    constexpr Quaternion<double> back = Quaternion<double>::from_matrix3(q.to_matrix3());
+    STATIC_REQUIRE(back.w() > 0.4999999 && back.w() < 0.5000001);
+    STATIC_REQUIRE(back.y() > -0.5000001 && back.y() < -0.4999999);
+}
@@ -0,0 +1,139 @@
+#define NDEBUG
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include "../ES_resample.hpp"
+
+using namespace ES;
+using resample::Filter;
+
+namespace {
+    constexpr Filter all_filters[] = {Filter::box, Filter::bilinear, Filter::mitchell, Filter::lanczos3, Filter::kaiser};
+}
+
+TEST_CASE("resample: contributor lists", "[resample]"){
+    for(const Filter filter : all_filters){
+        for(const auto [source, target] : {std::pair{100, 37}, std::pair{37, 100}, std::pair{5, 5}, std::pair{1, 9}, std::pair{9, 1}}){
+            const auto w = resample::weights(source, target, filter);
+            REQUIRE(w->first.size() == static_cast<std::size_t>(target));
+            REQUIRE(w->weights.size() == target * w->taps);
+            bool sums = true;
+            bool in_range = true;
+            for(std::size_t i = 0; i < w->target; i++){
+                float total = 0.0f;
+                for(std::size_t k = 0; k < w->taps; k++){
+                    total += w->weights[i * w->taps + k];
+                }
+                sums = sums && std::abs(total - 1.0f) < 1e-5f;
+                in_range = in_range && w->first[i] + w->taps <= w->source;
+            }
+            REQUIRE(sums);
+            REQUIRE(in_range);
+        }
+    }
+
+    //made once, then shared
+    REQUIRE(resample::weights(640, 480, Filter::lanczos3) == resample::weights(640, 480, Filter::lanczos3));
+    REQUIRE(resample::weights(640, 480, Filter::lanczos3) != resample::weights(640, 480, Filter::mitchell));
+
+    //box halving is a plain average of pairs
+    const auto halve = resample::weights(8, 4, Filter::box);
+    REQUIRE(halve->first[1] == 2);
+    REQUIRE(halve->weights[1 * halve->taps] == 0.5f);
+    REQUIRE(halve->weights[1 * halve->taps + 1] == 0.5f);
+}
+
+TEST_CASE("resample: same size through interpolating filters is a copy", "[resample]"){
+    Image<RGBA8> image(13, 7);
+    for(std::size_t y = 0; y < image.height(); y++){
+        for(std::size_t x = 0; x < image.width(); x++){
+            image(x, y) = RGBA8(std::uint8_t(x * 19), std::uint8_t(y * 37), std::uint8_t(x * y), 255);
+        }
+    }
+    for(const Filter filter : {Filter::box, Filter::bilinear}){
+        const Image<RGBA8> copy = resample::resized(image, 13, 7, filter);
+        bool same = true;
+        for(std::size_t y = 0; y < image.height(); y++){
+            for(std::size_t x = 0; x < image.width(); x++){
+                same = same && copy(x, y).R == image(x, y).R && copy(x, y).G == image(x, y).G && copy(x, y).B == image(x, y).B && copy(x, y).A == 255;
+            }
+        }
+        REQUIRE(same);
+    }
+}
+
+TEST_CASE("resample: flat images stay flat", "[resample]"){
+    const Image<RGBA> flat(40, 30, RGBA(0.2f, 0.3f, 0.1f, 0.5f));
+    for(const Filter filter : all_filters){
+        for(const auto [width, height] : {std::pair{17, 11}, std::pair{97, 61}}){
+            const Image<RGBA> out = resample::resized(flat, width, height, filter);
+            bool still = true;
+            for(std::size_t y = 0; y < out.height(); y++){
+                for(std::size_t x = 0; x < out.width(); x++){
+                    for(std::size_t c = 0; c < 4; c++){
+                        still = still && std::abs(out(x, y)[c] - flat(0, 0)[c]) < 1e-5f;
+                    }
+                }
+            }
+            REQUIRE(still);
+        }
+    }
+}
+
+TEST_CASE("resample: filtering happens in linear light", "[resample]"){
+    //a black and white checkerboard averages to half the light, which sRGB spells 188, not 128
+    Image<RGB8> checks(8, 8);
+    for(std::size_t y = 0; y < 8; y++){
+        for(std::size_t x = 0; x < 8; x++){
+            const std::uint8_t v = (x + y) % 2 ? 255 : 0;
+            checks(x, y) = RGB8(v, v, v);
+        }
+    }
+    const Image<RGB8> grey = resample::resized(checks, 4, 4, Filter::box);
+    REQUIRE(grey(2, 1).R == 188);
+    REQUIRE(grey(3, 3).B == 188);
+
+    //a transparent pixel's colour doesn't leak into its neighbour
+    Image<RGBA8> edge(2, 1);
+    edge(0, 0) = RGBA8(255, 0, 0, 255);
+    edge(1, 0) = RGBA8(0, 255, 0, 0);
+    const Image<RGBA8> merged = resample::resized(edge, 1, 1, Filter::box);
+    REQUIRE(merged(0, 0).R == 255);
+    REQUIRE(merged(0, 0).G == 0);
+    REQUIRE(merged(0, 0).A == 128);
+
+    //enlarging a two pixel float ramp with the tent keeps it a ramp in between
+    Image<RGB> ramp(2, 1);
+    ramp(0, 0) = RGB(0.0f, 0.0f, 0.0f);
+    ramp(1, 0) = RGB(1.0f, 1.0f, 1.0f);
+    const Image<RGB> wide = resample::resized(ramp, 8, 1, Filter::bilinear);
+    REQUIRE(wide(0, 0).R() == 0.0f);
+    REQUIRE(std::abs(wide(3, 0).R() - 0.375f) < 1e-6f);
+    REQUIRE(std::abs(wide(4, 0).R() - 0.625f) < 1e-6f);
+    REQUIRE(wide(7, 0).R() == 1.0f);
+}
+
+TEST_CASE("resample benchmark", "[!benchmark][resample]"){
+    Image<RGBA8> frame(3840, 2160);
+    for(std::size_t y = 0; y < frame.height(); y++){
+        for(std::size_t x = 0; x < frame.width(); x++){
+            frame(x, y) = RGBA8(std::uint8_t(x), std::uint8_t(y), std::uint8_t(x ^ y), 255);
+        }
+    }
+    Image<RGBA8> half(1920, 1080);
+
+    BENCHMARK("4K to 1080p RGBA8, Lanczos3"){
+        resample::resize(frame, half, Filter::lanczos3);
+        return half(0, 0).R;
+    };
+    BENCHMARK("4K to 1080p RGBA8, bilinear"){
+        resample::resize(frame, half, Filter::bilinear);
+        return half(0, 0).R;
+    };
+    BENCHMARK("1080p to 4K RGBA8, Mitchell"){
+        resample::resize(half, frame, Filter::mitchell);
+        return frame(0, 0).R;
+    };
+}
@@ -0,0 +1,207 @@
+#define NDEBUG
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <vector>
+#include "../ES_math.hpp"
+#include "../VectorN.hpp"
+#include "../Quaternion.hpp"
+#include "../AffineTransform3.hpp"
+#include "../Skinning.hpp"
+
+using namespace ES;
+
+namespace {
+    //a palette of scaled, rotated and translated bones, so every term of the 3x4 matters
+    std::vector<AffineTransform3<float>> make_bones(std::size_t count){
+        std::vector<AffineTransform3<float>> bones;
+        for(std::size_t i = 0; i < count; i++){
+            Quaternion<float> rot(Vector3<float>(1.0f, 0.2f * i, 0.5f), Angle<in_radians, float>(0.3f * i));
+            AffineTransform3<float> r(rot.to_matrix3(), Vector3<float>(float(i), 1.0f, -0.5f * i));
+            bones.push_back(r * AffineTransform3<float>::from_scale(Vector3<float>(1.0f + 0.1f * i, 1.0f, 1.0f)));
+        }
+        return bones;
+    }
+
+    std::vector<skinning::VertexInfluences<>> make_influences(std::size_t vertex_count, std::size_t bone_count){
+        std::vector<skinning::VertexInfluences<>> influences(vertex_count);
+        for(std::size_t v = 0; v < vertex_count; v++){
+            auto& inf = influences[v];
+            inf.bones = {std::uint16_t(v % bone_count), std::uint16_t((v + 1) % bone_count), std::uint16_t((v + 2) % bone_count), std::uint16_t((v + 5) % bone_count)};
+            inf.weights = {0.4f, 0.3f, 0.2f, 0.1f};
+        }
+        return influences;
+    }
+}
+
+TEST_CASE("BoneMatrix round trips through AffineTransform3", "[Skinning]"){
+    auto bone = make_bones(4)[3];
+
+    auto packed = skinning::BoneMatrix<float>::from_affine(bone);
+    Vector3<float> p(1.0f, -2.0f, 0.5f);
+
+    REQUIRE(packed.transform_point(p).almost_equal(bone.transform_point(p), 1e-5f));
+    REQUIRE(packed.to_affine().transform_point(p).almost_equal(bone.transform_point(p), 1e-5f));
+}
+
+TEST_CASE("BoneMatrix defaults to identity", "[Skinning]"){
+    skinning::BoneMatrix<float> bone;
+    Vector3<float> p(1.0f, 2.0f, 3.0f);
+
+    REQUIRE(bone.transform_point(p) == p);
+}
+
+TEST_CASE("PackedInfluences pack sums to exactly 255", "[Skinning]"){
+    skinning::VertexInfluences<> inf;
+    inf.bones = {1, 2, 3, 4};
+    inf.weights = {1.0f / 3.0f, 1.0f / 3.0f, 1.0f / 3.0f, 0.0f};
+
+    auto packed = skinning::PackedInfluences<>::pack(inf);
+    int sum = packed.weights[0] + packed.weights[1] + packed.weights[2] + packed.weights[3];
+
+    REQUIRE(sum == 255);
+    REQUIRE(packed.bones == inf.bones);
+    REQUIRE(packed.weights[3] == 0);
+    REQUIRE(math::approx_equal(packed.weight(0), 1.0f / 3.0f, 1.0f / 255.0f));
+}
+
+TEST_CASE("PackedInfluences pack renormalizes unnormalized weights", "[Skinning]"){
+    skinning::VertexInfluences<std::uint8_t> inf;
+    inf.weights = {2.0f, 2.0f, 0.0f, 0.0f};
+
+    auto packed = skinning::PackedInfluences<std::uint8_t>::pack(inf);
+
+    REQUIRE(packed.weights[0] + packed.weights[1] == 255);
+    REQUIRE(sizeof(packed) == 8);
+}
+
+TEST_CASE("PackedInfluences pack of all zero weights sticks to the first bone", "[Skinning]"){
+    skinning::VertexInfluences<> inf;
+
+    auto packed = skinning::PackedInfluences<>::pack(inf);
+
+    REQUIRE(packed.weights[0] == 255);
+}
+
+TEST_CASE("Linear blend skinning with a single bone is that bone", "[Skinning]"){
+    auto bones = make_bones(3);
+    std::vector<skinning::BoneMatrix<float>> palette;
+    for(const auto& b : bones) palette.push_back(skinning::BoneMatrix<float>::from_affine(b));
+
+    std::vector<Vector3<float>> positions = {{1.0f, 0.0f, 0.0f}, {0.0f, 2.0f, 0.0f}, {0.0f, 0.0f, 3.0f}};
+    std::vector<skinning::VertexInfluences<>> influences(3);
+    for(auto& inf : influences){
+        inf.bones = {2, 0, 0, 0};
+        inf.weights = {1.0f, 0.0f, 0.0f, 0.0f};
+    }
+    std::vector<Vector3<float>> out(3);
+
+    skinning::skin_linear<float, std::uint16_t>(palette, influences, positions, out);
+
+    for(std::size_t i = 0; i < 3; i++){
+        REQUIRE(out[i].almost_equal(bones[2].transform_point(positions[i]), 1e-5f));
+    }
+}
+
+TEST_CASE("Linear blend skinning matches the scalar reference", "[Skinning]"){
+    auto bones = make_bones(7);
+    std::vector<skinning::BoneMatrix<float>> palette;
+    for(const auto& b : bones) palette.push_back(skinning::BoneMatrix<float>::from_affine(b));
+
+    const std::size_t vertex_count = 4099;
+    auto influences = make_influences(vertex_count, bones.size());
+    std::vector<Vector3<float>> positions(vertex_count), normals(vertex_count);
+    for(std::size_t v = 0; v < vertex_count; v++){
+        positions[v] = Vector3<float>(float(v % 13), float(v % 7) * 0.25f, -float(v % 3));
+        normals[v] = Vector3<float>(0.0f, 0.0f, 1.0f);
+    }
+    std::vector<Vector3<float>> out_positions(vertex_count), out_normals(vertex_count);
+
+    skinning::skin_linear<float, std::uint16_t>(palette, influences, positions, out_positions, normals, out_normals);
+
+    for(std::size_t v = 0; v < vertex_count; v += 61){
+        Vector3<float> expected(0.0f, 0.0f, 0.0f);
+        Vector3<float> expected_normal(0.0f, 0.0f, 0.0f);
+        for(std::size_t k = 0; k < 4; k++){
+            expected += bones[influences[v].bones[k]].transform_point(positions[v]) * influences[v].weights[k];
+            expected_normal += bones[influences[v].bones[k]].transform_vector(normals[v]) * influences[v].weights[k];
+        }
+        REQUIRE(out_positions[v].almost_equal(expected, 1e-4f));
+        REQUIRE(out_normals[v].almost_equal(expected_normal.normalize(), 1e-4f));
+    }
+}
+
+TEST_CASE("Linear blend skinning with packed influences", "[Skinning]"){
+    auto bones = make_bones(5);
+    std::vector<skinning::BoneMatrix<float>> palette;
+    for(const auto& b : bones) palette.push_back(skinning::BoneMatrix<float>::from_affine(b));
+
+    const std::size_t vertex_count = 257;
+    auto influences = make_influences(vertex_count, bones.size());
+    std::vector<skinning::PackedInfluences<>> packed;
+    for(const auto& inf : influences) packed.push_back(skinning::PackedInfluences<>::pack(inf));
+    std::vector<Vector3<float>> positions(vertex_count, Vector3<float>(1.0f, 2.0f, 3.0f));
+    std::vector<Vector3<float>> out_full(vertex_count), out_packed(vertex_count);
+
+    skinning::skin_linear<float, std::uint16_t>(palette, influences, positions, out_full);
+    skinning::skin_linear<float, std::uint16_t>(palette, packed, positions, out_packed);
+
+    //a 1/255 weight step over bones moving things by ~10 units
+    for(std::size_t v = 0; v < vertex_count; v++){
+        REQUIRE(out_packed[v].almost_equal(out_full[v], 0.05f));
+    }
+}
+
+TEST_CASE("Dual quaternion skinning with packed influences", "[Skinning][DualQuaternion]"){
+    Quaternion<float> rot(Vector3<float>(0.0f, 1.0f, 0.0f), Angle<in_radians, float>(1.0f));
+    std::vector<DualQuaternion<float>> palette = {DualQuaternion<float>::identity(), DualQuaternion<float>::from_rotation_translation(rot, Vector3<float>(0.0f, 1.0f, 0.0f))};
+    std::vector<skinning::PackedInfluences<std::uint8_t>> influences(2);
+    influences[0].bones = {1, 0, 0, 0};
+    influences[0].weights = {255, 0, 0, 0};
+    influences[1].bones = {0, 1, 0, 0};
+    influences[1].weights = {255, 0, 0, 0};
+    std::vector<Vector3<float>> positions(2, Vector3<float>(1.0f, 0.0f, 0.0f));
+    std::vector<Vector3<float>> out(2);
+
+    skinning::skin_dual_quaternion<float, std::uint8_t>(palette, influences, positions, out);
+
+    REQUIRE(out[0].almost_equal(palette[1].transform_point(positions[0]), 1e-5f));
+    REQUIRE(out[1].almost_equal(positions[1]));
+}
+
+TEST_CASE("Skinning 100k vertices", "[Skinning][!benchmark]"){
+    const std::size_t vertex_count = 100'000;
+    auto bones = make_bones(64);
+    std::vector<skinning::BoneMatrix<float>> palette;
+    std::vector<DualQuaternion<float>> dq_palette;
+    for(const auto& b : bones){
+        palette.push_back(skinning::BoneMatrix<float>::from_affine(b));
+        dq_palette.push_back(DualQuaternion<float>::from_affine(b));
+    }
+    auto influences = make_influences(vertex_count, bones.size());
+    std::vector<skinning::PackedInfluences<>> packed;
+    for(const auto& inf : influences) packed.push_back(skinning::PackedInfluences<>::pack(inf));
+    std::vector<Vector3<float>> positions(vertex_count, Vector3<float>(1.0f, 2.0f, 3.0f));
+    std::vector<Vector3<float>> normals(vertex_count, Vector3<float>(0.0f, 1.0f, 0.0f));
+    std::vector<Vector3<float>> out_positions(vertex_count), out_normals(vertex_count);
+
+    BENCHMARK("scalar AffineTransform3::transform_point per influence"){
+        for(std::size_t v = 0; v < vertex_count; v++){
+            Vector3<float> p(0.0f, 0.0f, 0.0f);
+            for(std::size_t k = 0; k < 4; k++){
+                p += bones[influences[v].bones[k]].transform_point(positions[v]) * influences[v].weights[k];
+            }
+            out_positions[v] = p;
+        }
+        return out_positions[vertex_count - 1][0];
+    };
+
+    BENCHMARK("skin_linear, packed, positions + normals"){
+        skinning::skin_linear<float, std::uint16_t>(palette, packed, positions, out_positions, normals, out_normals);
+        return out_positions[vertex_count - 1][0];
+    };
+
+    BENCHMARK("skin_dual_quaternion, positions + normals"){
+        skinning::skin_dual_quaternion<float, std::uint16_t>(dq_palette, influences, positions, out_positions, normals, out_normals);
+        return out_positions[vertex_count - 1][0];
+    };
+}
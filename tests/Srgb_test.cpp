@@ -0,0 +1,142 @@
+#define NDEBUG
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+#include "../ES_srgb.hpp"
+#include "../ES_color.hpp"
+
+using namespace ES;
+
+namespace {
+
+    //the curve in double, rounded to nearest
+    int reference_srgb8(float linear){
+        const double x = std::clamp(static_cast<double>(linear), 0.0, 1.0);
+        const double s = x <= 0.0031308 ? 12.92 * x : 1.055 * std::pow(x, 1.0 / 2.4) - 0.055;
+        return static_cast<int>(std::floor(s * 255.0 + 0.5));
+    }
+
+}
+
+TEST_CASE("srgb: 8 bit decoding table", "[srgb]"){
+    STATIC_REQUIRE(srgb::to_linear(0) == 0.0f);
+    STATIC_REQUIRE(srgb::to_linear(255) == 1.0f);
+    for(int i = 0; i < 256; i++){
+        const double s = i / 255.0;
+        const double expected = s <= 0.04045 ? s / 12.92 : std::pow((s + 0.055) / 1.055, 2.4);
+        REQUIRE(srgb::to_linear(static_cast<std::uint8_t>(i)) == static_cast<float>(expected));
+    }
+}
+
+TEST_CASE("srgb: float encoding rounds exactly", "[srgb]"){
+    STATIC_REQUIRE(srgb::to_srgb8(0.0f) == 0);
+    STATIC_REQUIRE(srgb::to_srgb8(1.0f) == 255);
+    STATIC_REQUIRE(srgb::to_srgb8(0.5f) == 188);
+    STATIC_REQUIRE(srgb::to_srgb8(-3.0f) == 0);
+    STATIC_REQUIRE(srgb::to_srgb8(7.0f) == 255);
+    REQUIRE(srgb::to_srgb8(std::nanf("")) == 0);
+    REQUIRE(srgb::to_srgb8(std::numeric_limits<float>::infinity()) == 255);
+
+    //every decoded code encodes back to itself
+    for(int i = 0; i < 256; i++){
+        REQUIRE(srgb::to_srgb8(srgb::to_linear(static_cast<std::uint8_t>(i))) == i);
+    }
+
+    //the decision points, where a guess that's off shows up first, and a float either side of each
+    bool all = true;
+    for(std::size_t k = 1; k < 256; k++){
+        const std::uint32_t bits = std::bit_cast<std::uint32_t>(srgb::Secret::encode_thresholds[k]);
+        for(const std::uint32_t near : {bits - 1, bits, bits + 1}){
+            const float x = std::bit_cast<float>(near);
+            all = all && srgb::to_srgb8(x) == reference_srgb8(x);
+        }
+    }
+    REQUIRE(all);
+
+    //and a sweep through every segment
+    for(std::uint32_t bits = std::bit_cast<std::uint32_t>(1e-5f); bits < 0x3f800000u; bits += 997){
+        const float x = std::bit_cast<float>(bits);
+        all = all && srgb::to_srgb8(x) == reference_srgb8(x);
+    }
+    REQUIRE(all);
+}
+
+TEST_CASE("srgb: channel spans", "[srgb]"){
+    std::vector<std::uint8_t> codes(1000);
+    for(std::size_t i = 0; i < codes.size(); i++){
+        codes[i] = static_cast<std::uint8_t>(i * 7);
+    }
+    std::vector<float> linear(codes.size());
+    srgb::to_linear(codes, linear);
+    REQUIRE(linear[1] == srgb::to_linear(7));
+    std::vector<std::uint8_t> back(codes.size());
+    srgb::to_srgb8(linear, back);
+    REQUIRE(back == codes);
+}
+
+TEST_CASE("color: whole image conversions", "[srgb]"){
+    //odd width so rows end part way through a batch
+    Image<RGBA8> image(67, 45);
+    for(std::size_t y = 0; y < image.height(); y++){
+        for(std::size_t x = 0; x < image.width(); x++){
+            image(x, y) = RGBA8(std::uint8_t(x * 3 + y), std::uint8_t(x * y), std::uint8_t(255 - x), std::uint8_t(y < 20 ? 255 : x * 4));
+        }
+    }
+    Image<RGBA> linear(67, 45);
+    color::to_linear(image, linear);
+    REQUIRE(linear(10, 3) == RGBA::from_srgba(33, 30, 245, 255));
+    REQUIRE(linear(10, 30).A() == 40 / 255.0f);
+    REQUIRE(linear(0, 30) == RGBA(0, 0, 0, 0));
+
+    Image<RGBA8> back(67, 45);
+    color::to_srgb8(linear, back);
+    bool opaque_exact = true;
+    bool close_to_scalar = true;
+    for(std::size_t y = 0; y < image.height(); y++){
+        for(std::size_t x = 0; x < image.width(); x++){
+            const RGBA8 p = back(x, y);
+            if(image(x, y).A == 255){
+                opaque_exact = opaque_exact && p.R == image(x, y).R && p.G == image(x, y).G && p.B == image(x, y).B && p.A == 255;
+            }
+            //the constructor divides where the batch multiplies by the reciprocal, which can move a code by one
+            const RGBA8 scalar(linear(x, y));
+            close_to_scalar = close_to_scalar && std::abs(p.R - scalar.R) <= 1 && std::abs(p.G - scalar.G) <= 1
+                              && std::abs(p.B - scalar.B) <= 1 && p.A == scalar.A;
+        }
+    }
+    REQUIRE(opaque_exact);
+    REQUIRE(close_to_scalar);
+    REQUIRE((back(0, 30).R == 0 && back(0, 30).A == 0));
+
+    Image<RGB8> rgb8(5, 2, RGB8(0, 128, 255));
+    Image<RGB> rgb(5, 2);
+    color::to_linear(rgb8, rgb);
+    REQUIRE(rgb(4, 1) == RGB::from_srgb(0, 128, 255));
+    rgb(0, 0) = RGB(-1.0f, 0.5f, 2.0f);
+    Image<RGB8> rgb8_back(5, 2);
+    color::to_srgb8(rgb, rgb8_back);
+    REQUIRE(rgb8_back(4, 1).G == 128);
+    REQUIRE(rgb8_back(0, 0).R == 0);
+    REQUIRE(rgb8_back(0, 0).G == 188);
+    REQUIRE(rgb8_back(0, 0).B == 255);
+}
+
+TEST_CASE("srgb benchmark", "[!benchmark][srgb]"){
+    Image<RGBA> frame(3840, 2160, RGBA(0.25f, 0.5f, 0.125f, 0.75f));
+    Image<RGBA8> out(3840, 2160);
+    Image<RGBA> back(3840, 2160);
+
+    //one 4K frame each way
+    BENCHMARK("4K RGBA to RGBA8"){
+        color::to_srgb8(frame, out);
+        return out(0, 0).R;
+    };
+    BENCHMARK("4K RGBA8 to RGBA"){
+        color::to_linear(out, back);
+        return back(0, 0).R();
+    };
+}
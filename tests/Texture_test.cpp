@@ -0,0 +1,210 @@
+#define NDEBUG
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+#include "../Texture.hpp"
+
+using namespace ES;
+using UV = VectorN<float, 2>;
+
+namespace {
+    Image<RGBA8> noise(std::size_t width, std::size_t height){
+        Image<RGBA8> image(width, height);
+        std::uint32_t seed = 3;
+        for(std::size_t y = 0; y < height; y++){
+            for(std::size_t x = 0; x < width; x++){
+                seed = seed * 1664525u + 1013904223u;
+                image(x, y) = RGBA8(static_cast<std::uint8_t>(seed >> 24), static_cast<std::uint8_t>(seed >> 16),
+                                    static_cast<std::uint8_t>(seed >> 8), static_cast<std::uint8_t>(seed >> 4));
+            }
+        }
+        return image;
+    }
+
+    bool near(const RGBA& a, const RGBA& b, float tolerance = 1e-6f){
+        for(std::size_t c = 0; c < 4; c++){
+            if(std::abs(a[c] - b[c]) > tolerance){
+                return false;
+            }
+        }
+        return true;
+    }
+
+    RGBA linear(const RGBA8& p){
+        const float a = p.A / 255.0f;
+        return RGBA(srgb::to_linear(p.R) * a, srgb::to_linear(p.G) * a, srgb::to_linear(p.B) * a, a);
+    }
+}
+
+TEST_CASE("texture: layouts hold the same texels", "[texture]"){
+    //not a whole number of tiles either way
+    const Image<RGBA8> image = noise(13, 7);
+    const Texture<RGBA8> rows(image, TextureLayout::rows);
+    const Texture<RGBA8> tiles(image);
+    REQUIRE(tiles.layout() == TextureLayout::tiles);
+    REQUIRE(Texture<RGBA8>::tile_edge == 8);
+    REQUIRE(Texture<RGBA>::tile_edge == 4);
+    bool same = true;
+    for(std::size_t y = 0; y < 7; y++){
+        for(std::size_t x = 0; x < 13; x++){
+            same = same && rows.texel(x, y).R == image(x, y).R && tiles.texel(x, y).G == image(x, y).G && tiles.texel(x, y).A == image(x, y).A;
+        }
+    }
+    REQUIRE(same);
+
+    //and sample the same, whatever the filter and addressing
+    const auto chain = mip::generate(noise(40, 24));
+    const Texture<RGBA8> chain_rows(chain, TextureLayout::rows);
+    const Texture<RGBA8> chain_tiles(chain);
+    REQUIRE(chain_tiles.levels() == 6);
+    REQUIRE(chain_tiles.width(2) == 10);
+    std::uint32_t seed = 11;
+    bool agree = true;
+    for(const TextureFilter filter : {TextureFilter::point, TextureFilter::bilinear, TextureFilter::trilinear}){
+        for(const AddressMode mode : {AddressMode::wrap, AddressMode::clamp, AddressMode::mirror}){
+            const Sampler sampler{filter, mode, mode};
+            for(int i = 0; i < 500; i++){
+                seed = seed * 1664525u + 1013904223u;
+                const UV uv(static_cast<float>(seed >> 8) / 4194304.0f - 2.0f, static_cast<float>(seed & 0xffff) / 16384.0f - 2.0f);
+                const float lod = static_cast<float>(seed % 70) / 10.0f;
+                agree = agree && chain_rows.sample(uv, sampler, lod) == chain_tiles.sample(uv, sampler, lod);
+            }
+        }
+    }
+    REQUIRE(agree);
+
+    //every level starts a whole tile in, and the storage on a cache line, so no tile straddles one more than it needs
+    for(std::size_t level = 0; level < chain_tiles.levels(); level++){
+        REQUIRE(reinterpret_cast<std::uintptr_t>(&chain_tiles.texel(0, 0, level)) % image_row_alignment == 0);
+    }
+    const Texture<RGBA8> copy(chain_tiles);
+    REQUIRE(&copy.texel(0, 0) != &chain_tiles.texel(0, 0));
+    REQUIRE(copy.sample(UV(0.3f, 0.7f), {}, 1.5f) == chain_tiles.sample(UV(0.3f, 0.7f), {}, 1.5f));
+}
+
+TEST_CASE("texture: filtering and addressing", "[texture]"){
+    Image<RGBA> image(4, 2);
+    for(std::size_t x = 0; x < 4; x++){
+        image(x, 0) = RGBA(static_cast<float>(x), 0.0f, 0.0f, 1.0f);
+        image(x, 1) = RGBA(static_cast<float>(x), 1.0f, 0.0f, 1.0f);
+    }
+    const Texture<RGBA> texture(image);
+    const Sampler wrap{};
+    const Sampler clamp{TextureFilter::bilinear, AddressMode::clamp, AddressMode::clamp};
+    const Sampler mirror{TextureFilter::bilinear, AddressMode::mirror, AddressMode::mirror};
+    const Sampler point{TextureFilter::point, AddressMode::wrap, AddressMode::wrap};
+
+    //texel centres give the texel back
+    REQUIRE(texture.sample(UV(0.625f, 0.25f), wrap) == image(2, 0));
+    REQUIRE(texture.sample(UV(0.6f, 0.9f), point) == image(2, 1));
+    //halfway between two centres is their average
+    REQUIRE(near(texture.sample(UV(0.5f, 0.5f), wrap), RGBA(1.5f, 0.5f, 0.0f, 1.0f)));
+    //the left edge: wrap meets the right hand column, clamp and mirror stay on the first
+    REQUIRE(near(texture.sample(UV(0.0f, 0.25f), wrap), RGBA(1.5f, 0.0f, 0.0f, 1.0f)));
+    REQUIRE(near(texture.sample(UV(0.0f, 0.25f), clamp), RGBA(0.0f, 0.0f, 0.0f, 1.0f)));
+    REQUIRE(near(texture.sample(UV(0.0f, 0.25f), mirror), RGBA(0.0f, 0.0f, 0.0f, 1.0f)));
+    //past the edges
+    REQUIRE(texture.sample(UV(1.125f, 0.25f), wrap) == image(0, 0));
+    REQUIRE(texture.sample(UV(1.125f, 0.25f), mirror) == image(3, 0));
+    REQUIRE(texture.sample(UV(-0.375f, 0.25f), mirror) == image(1, 0));
+    REQUIRE(texture.sample(UV(-3.0f, 7.0f), clamp) == image(0, 1));
+    REQUIRE(texture.sample(UV(-0.375f, 0.25f), point) == image(2, 0));
+
+    //8 bit texels come back linear and premultiplied
+    Image<RGBA8> bytes(1, 1, RGBA8(200, 100, 50, 128));
+    REQUIRE(near(Texture<RGBA8>(bytes).sample(UV(0.3f, 0.7f)), linear(bytes(0, 0))));
+    Image<RGB8> opaque(1, 1, RGB8(200, 100, 50));
+    REQUIRE(Texture<RGB8>(opaque).sample(UV(0.5f, 0.5f)).A() == 1.0f);
+}
+
+TEST_CASE("texture: mips", "[texture]"){
+    Image<RGBA> image(8, 8);
+    for(std::size_t y = 0; y < 8; y++){
+        for(std::size_t x = 0; x < 8; x++){
+            image(x, y) = RGBA(static_cast<float>(x + y) / 16.0f, 0.0f, 0.0f, 1.0f);
+        }
+    }
+    const Texture<RGBA> texture(mip::generate(image));
+    REQUIRE(texture.levels() == 4);
+    const Sampler trilinear{TextureFilter::trilinear, AddressMode::clamp, AddressMode::clamp};
+    const Sampler bilinear{TextureFilter::bilinear, AddressMode::clamp, AddressMode::clamp};
+    const UV uv(0.3f, 0.6f);
+
+    //whole levels are plain bilinear, in between is a blend of the two
+    REQUIRE(texture.sample(uv, trilinear, 1.0f) == texture.sample(uv, bilinear, 1.0f));
+    const RGBA one = texture.sample(uv, bilinear, 1.0f);
+    const RGBA two = texture.sample(uv, bilinear, 2.0f);
+    REQUIRE(near(texture.sample(uv, trilinear, 1.25f), RGBA(one.R() * 0.75f + two.R() * 0.25f, 0.0f, 0.0f, 1.0f)));
+    //bilinear takes the nearest level, lods out of range take the ends
+    REQUIRE(texture.sample(uv, bilinear, 1.4f) == one);
+    REQUIRE(texture.sample(uv, bilinear, 1.6f) == two);
+    REQUIRE(texture.sample(uv, trilinear, 9.0f) == texture.sample(uv, bilinear, 3.0f));
+    REQUIRE(texture.sample(uv, trilinear, -2.0f) == texture.sample(uv, bilinear, 0.0f));
+
+    //a texel per pixel is lod 0, two texels a pixel lod 1, the longer side wins
+    REQUIRE(texture.lod(UV(1.0f / 8.0f, 0.0f), UV(0.0f, 1.0f / 8.0f)) == 0.0f);
+    REQUIRE(texture.lod(UV(2.0f / 8.0f, 0.0f), UV(0.0f, 1.0f / 8.0f)) == 1.0f);
+    REQUIRE(std::abs(texture.lod(UV(0.0f, 0.0f), UV(3.0f / 8.0f, 3.0f / 8.0f)) - std::log2(3.0f * std::sqrt(2.0f))) < 1e-5f);
+
+    //batches are the same samples
+    std::vector<UV> uvs;
+    std::vector<float> lods;
+    for(int i = 0; i < 10000; i++){
+        uvs.emplace_back(static_cast<float>(i % 97) / 50.0f, static_cast<float>(i % 89) / 40.0f);
+        lods.push_back(static_cast<float>(i % 31) / 8.0f);
+    }
+    std::vector<RGBA> out(uvs.size());
+    texture.sample(uvs, lods, out, trilinear);
+    bool same = true;
+    for(std::size_t i = 0; i < uvs.size(); i++){
+        same = same && out[i] == texture.sample(uvs[i], trilinear, lods[i]);
+    }
+    texture.sample(uvs, out, bilinear, 1.0f);
+    for(std::size_t i = 0; i < uvs.size(); i++){
+        same = same && out[i] == texture.sample(uvs[i], bilinear, 1.0f);
+    }
+    REQUIRE(same);
+}
+
+TEST_CASE("texture benchmark", "[!benchmark][texture]"){
+    const Image<RGBA8> image = noise(2048, 2048);
+    const Texture<RGBA8> rows(image, TextureLayout::rows);
+    const Texture<RGBA8> tiles(image);
+
+    //a 1024^2 screen showing the texture turned 60 degrees: every step along a screen row crosses texture rows
+    std::vector<UV> uvs;
+    uvs.reserve(1024 * 1024);
+    const float c = 0.5f, s = 0.8660254f;
+    for(std::size_t y = 0; y < 1024; y++){
+        for(std::size_t x = 0; x < 1024; x++){
+            const float px = static_cast<float>(x) / 1024.0f, py = static_cast<float>(y) / 1024.0f;
+            uvs.emplace_back(c * px - s * py, s * px + c * py);
+        }
+    }
+    std::vector<RGBA> out(uvs.size());
+
+    BENCHMARK("1M bilinear samples, rotated, rows"){
+        rows.sample(uvs, out);
+        return out[0].R();
+    };
+    BENCHMARK("1M bilinear samples, rotated, tiles"){
+        tiles.sample(uvs, out);
+        return out[0].R();
+    };
+
+    //and turned a right angle, walking straight down the texture's columns
+    for(std::size_t i = 0; i < uvs.size(); i++){
+        uvs[i] = UV(static_cast<float>(i / 1024) / 1024.0f, static_cast<float>(i % 1024) / 1024.0f);
+    }
+    BENCHMARK("1M bilinear samples, down columns, rows"){
+        rows.sample(uvs, out);
+        return out[0].R();
+    };
+    BENCHMARK("1M bilinear samples, down columns, tiles"){
+        tiles.sample(uvs, out);
+        return out[0].R();
+    };
+}
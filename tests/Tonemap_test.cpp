@@ -0,0 +1,170 @@
+#define NDEBUG
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <limits>
+#include "../ES_tonemap.hpp"
+
+using namespace ES;
+using tonemap::Curve;
+
+namespace {
+    constexpr Curve all_curves[] = {Curve::reinhard, Curve::aces, Curve::agx, Curve::uncharted2};
+
+    //a sky at 2^6, ground around 2^-3, and a few lamps
+    Image<RGB> scene(std::size_t width, std::size_t height){
+        Image<RGB> image(width, height);
+        std::uint32_t seed = 21;
+        for(std::size_t y = 0; y < height; y++){
+            for(std::size_t x = 0; x < width; x++){
+                seed = seed * 1664525u + 1013904223u;
+                const float jitter = 1.0f + static_cast<float>(seed >> 24) / 512.0f;
+                const float v = y < height / 3 ? 64.0f : (x % 97 == 0 ? 4000.0f : 0.125f);
+                image(x, y) = RGB(v * jitter, v, v / jitter);
+            }
+        }
+        return image;
+    }
+}
+
+TEST_CASE("tonemap: curves", "[tonemap]"){
+    for(const Curve curve : all_curves){
+        REQUIRE(tonemap::apply(curve, RGB(0.0f, 0.0f, 0.0f)).G() < 0.01f);
+        //brighter in is brighter out, and never past white
+        bool rising = true;
+        float last = -1.0f;
+        for(float v = 0.001f; v < 1000.0f; v *= 1.1f){
+            const RGB out = tonemap::apply(curve, RGB(v, v, v));
+            rising = rising && out.G() >= last && out.G() <= 1.0f && out.R() >= 0.0f;
+            last = out.G();
+        }
+        REQUIRE(rising);
+        REQUIRE(last > 0.9f);
+    }
+    //the curves with a white point reach 1 there
+    REQUIRE(std::abs(tonemap::apply(Curve::reinhard, RGB(4.0f, 4.0f, 4.0f), 4.0f).G() - 1.0f) < 1e-5f);
+    REQUIRE(std::abs(tonemap::apply(Curve::uncharted2, RGB(4.0f, 4.0f, 4.0f), 4.0f).B() - 1.0f) < 1e-5f);
+    //Reinhard works on luminance, so it keeps the ratios between channels
+    const RGB orange = tonemap::apply(Curve::reinhard, RGB(2.0f, 1.0f, 0.5f));
+    REQUIRE(std::abs(orange.R() / orange.G() - 2.0f) < 1e-5f);
+    //the ACES fit darkens middle grey a little and keeps grey grey
+    const RGB grey = tonemap::apply(Curve::aces, RGB(0.18f, 0.18f, 0.18f));
+    REQUIRE(grey.G() > 0.1f);
+    REQUIRE(grey.G() < 0.18f);
+    REQUIRE(std::abs(grey.R() - grey.B()) < 1e-3f);
+}
+
+TEST_CASE("tonemap: histogram", "[tonemap]"){
+    //half the pixels at luminance 1, half at 1/4
+    Image<RGB> image(64, 50);
+    for(std::size_t y = 0; y < 50; y++){
+        for(std::size_t x = 0; x < 64; x++){
+            const float v = (x + y) % 2 ? 1.0f : 0.25f;
+            image(x, y) = RGB(v, v, v);
+        }
+    }
+    const auto histogram = tonemap::histogram(image, -8.0f, 8.0f);
+    REQUIRE(histogram.total() == 64 * 50);
+    const float bin = 16.0f / tonemap::histogram_bins;
+    REQUIRE(std::abs(histogram.mean_log2(0.0f, 1.0f) + 1.0f) < bin);
+    REQUIRE(std::abs(histogram.mean_log2(0.0f, 0.5f) + 2.0f) < bin);
+    REQUIRE(std::abs(histogram.mean_log2(0.5f, 1.0f)) < bin);
+    REQUIRE(histogram.counts[0] == 0);
+
+    //black and out of range light lands in the end buckets
+    image(0, 0) = RGB(0.0f, 0.0f, 0.0f);
+    image(1, 0) = RGB(-1.0f, 0.0f, 0.0f);
+    image(2, 0) = RGB(1e6f, 1e6f, 1e6f);
+    //a NaN is as dark as it gets, infinity as bright
+    image(3, 0) = RGB(std::numeric_limits<float>::quiet_NaN(), 0.5f, 0.5f);
+    image(4, 0) = RGB(std::numeric_limits<float>::infinity(), 0.5f, 0.5f);
+    const auto edges = tonemap::histogram(image, -8.0f, 8.0f);
+    REQUIRE(edges.total() == 64 * 50);
+    REQUIRE(edges.counts[0] == 3);
+    REQUIRE(edges.counts[tonemap::histogram_bins - 1] == 2);
+
+    //however many bands it's split into, the counts are the same
+    const Image<RGB> big = scene(300, 211);
+    parallel::ThreadPool alone(0);
+    parallel::ThreadPool four(4);
+    const auto one = tonemap::histogram(big, -12.0f, 12.0f, alone);
+    const auto many = tonemap::histogram(big, -12.0f, 12.0f, four);
+    REQUIRE(one.counts == many.counts);
+
+    //a flat frame at luminance 0.5 wants an exposure of 0.36 to sit at middle grey
+    const Image<RGB> flat(40, 40, RGB(0.5f, 0.5f, 0.5f));
+    REQUIRE(std::abs(std::log2(tonemap::auto_exposure(tonemap::histogram(flat)) / 0.36f)) < 24.0f / tonemap::histogram_bins);
+}
+
+TEST_CASE("tonemap: one pass to RGB8", "[tonemap]"){
+    const Image<RGB> hdr = scene(123, 45);
+    Image<RGB8> out(123, 45);
+    for(const Curve curve : all_curves){
+        tonemap::Settings settings{.curve = curve, .exposure = 0.3f, .white = 20.0f, .dither = false};
+        tonemap::map(hdr, out, settings);
+        bool same = true;
+        for(std::size_t y = 0; y < 45; y++){
+            for(std::size_t x = 0; x < 123; x++){
+                const RGB in = hdr(x, y);
+                const RGB display = tonemap::apply(curve, RGB(in.R() * 0.3f, in.G() * 0.3f, in.B() * 0.3f), 20.0f);
+                same = same && out(x, y).R == srgb::to_srgb8(display.R()) && out(x, y).G == srgb::to_srgb8(display.G())
+                       && out(x, y).B == srgb::to_srgb8(display.B());
+            }
+        }
+        REQUIRE(same);
+    }
+
+    //dithered, a flat area between two codes averages to its light, and every pixel is one of the two codes
+    const float value = 0.3f;
+    const Image<RGB> flat(256, 256, RGB(value, value, value));
+    Image<RGB8> dithered(256, 256);
+    //what gets dithered is the curve's output
+    const RGB through = tonemap::apply(Curve::reinhard, RGB(value, value, value), 1e6f);
+    tonemap::map(flat, dithered, {.curve = Curve::reinhard, .white = 1e6f, .dither = true, .seed = 5});
+    double sum = 0.0;
+    bool two_codes = true;
+    const std::uint8_t low = srgb::to_srgb8(through.G()) - (srgb::to_linear(srgb::to_srgb8(through.G())) > through.G());
+    for(std::size_t y = 0; y < 256; y++){
+        for(std::size_t x = 0; x < 256; x++){
+            const std::uint8_t g = dithered(x, y).G;
+            two_codes = two_codes && (g == low || g == low + 1);
+            sum += srgb::to_linear(g);
+        }
+    }
+    REQUIRE(two_codes);
+    REQUIRE(std::abs(sum / (256.0 * 256.0) - through.G()) < 0.02 * (srgb::to_linear(low + 1) - srgb::to_linear(low)));
+
+    //and a different seed is a different pattern
+    Image<RGB8> other(256, 256);
+    tonemap::map(flat, other, {.curve = Curve::reinhard, .white = 1e6f, .dither = true, .seed = 6});
+    std::size_t differ = 0;
+    for(std::size_t y = 0; y < 256; y++){
+        for(std::size_t x = 0; x < 256; x++){
+            differ += other(x, y).R != dithered(x, y).R;
+        }
+    }
+    REQUIRE(differ > 1000);
+}
+
+TEST_CASE("tonemap benchmark", "[!benchmark][tonemap]"){
+    const Image<RGB> frame = scene(3840, 2160);
+    Image<RGB8> out(3840, 2160);
+
+    BENCHMARK("4K log luminance histogram"){
+        return tonemap::histogram(frame).counts[64];
+    };
+    BENCHMARK("4K ACES + dither to RGB8"){
+        tonemap::map(frame, out, {.curve = Curve::aces, .exposure = 0.05f});
+        return out(0, 0).R;
+    };
+    BENCHMARK("4K AgX + dither to RGB8"){
+        tonemap::map(frame, out, {.curve = Curve::agx, .exposure = 0.05f});
+        return out(0, 0).R;
+    };
+    BENCHMARK("4K Reinhard, no dither, to RGB8"){
+        tonemap::map(frame, out, {.curve = Curve::reinhard, .exposure = 0.05f, .dither = false});
+        return out(0, 0).R;
+    };
+}
@@ -0,0 +1,190 @@
+#define NDEBUG
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <vector>
+#include "../ES_math.hpp"
+#include "../ES_random.hpp"
+#include "../VectorN.hpp"
+#include "../Quaternion.hpp"
+#include "../AffineTransform3.hpp"
+#include "../TransformTRS.hpp"
+#include "../TransformHierarchy.hpp"
+
+using namespace ES;
+
+namespace {
+    AffineTransform3<float> make_local(std::size_t i){
+        Quaternion<float> rot(Vector3<float>(0.2f, 1.0f, 0.1f * float(i % 5)), Angle<in_radians, float>(0.05f * float(i % 13)));
+        return AffineTransform3<float>::from_trs(Vector3<float>(0.1f * float(i % 7), 1.0f, 0.0f), rot, Vector3<float>(1.0f, 1.0f, 1.0f));
+    }
+
+    //world by walking up the parents, the thing update() is supposed to be a fast version of
+    AffineTransform3<float> reference_world(const TransformHierarchy<AffineTransform3<float>>& hierarchy, TransformHierarchy<AffineTransform3<float>>::Node node){
+        AffineTransform3<float> world = hierarchy.local(node);
+        for(auto p = hierarchy.parent(node); p != hierarchy.no_parent; p = hierarchy.parent(p)){
+            world = hierarchy.local(p) * world;
+        }
+        return world;
+    }
+}
+
+TEST_CASE("TransformHierarchy chain composes parent to child", "[TransformHierarchy]"){
+    TransformHierarchy<AffineTransform3<float>> hierarchy;
+    auto root = hierarchy.add(AffineTransform3<float>::from_translation(Vector3<float>(1.0f, 0.0f, 0.0f)));
+    auto child = hierarchy.add(AffineTransform3<float>::from_scale(Vector3<float>(2.0f, 2.0f, 2.0f)), root);
+    auto grandchild = hierarchy.add(AffineTransform3<float>::from_translation(Vector3<float>(0.0f, 1.0f, 0.0f)), child);
+
+    hierarchy.update();
+
+    REQUIRE(hierarchy.depth(grandchild) == 2);
+    REQUIRE(hierarchy.world(grandchild).transform_point(Vector3<float>(0.0f, 0.0f, 0.0f)).almost_equal(Vector3<float>(1.0f, 2.0f, 0.0f)));
+    REQUIRE(hierarchy.world(root).transform_point(Vector3<float>(0.0f, 0.0f, 0.0f)).almost_equal(Vector3<float>(1.0f, 0.0f, 0.0f)));
+}
+
+TEST_CASE("TransformHierarchy set_local moves the whole subtree and nothing else", "[TransformHierarchy]"){
+    TransformHierarchy<AffineTransform3<float>> hierarchy;
+    auto root = hierarchy.add(AffineTransform3<float>());
+    auto left = hierarchy.add(AffineTransform3<float>::from_translation(Vector3<float>(-1.0f, 0.0f, 0.0f)), root);
+    auto right = hierarchy.add(AffineTransform3<float>::from_translation(Vector3<float>(1.0f, 0.0f, 0.0f)), root);
+    auto left_leaf = hierarchy.add(AffineTransform3<float>::from_translation(Vector3<float>(0.0f, 1.0f, 0.0f)), left);
+    auto right_leaf = hierarchy.add(AffineTransform3<float>::from_translation(Vector3<float>(0.0f, 1.0f, 0.0f)), right);
+    hierarchy.update();
+
+    hierarchy.set_local(left, AffineTransform3<float>::from_translation(Vector3<float>(-5.0f, 0.0f, 0.0f)));
+    hierarchy.update();
+
+    Vector3<float> origin(0.0f, 0.0f, 0.0f);
+    REQUIRE(hierarchy.world(left_leaf).transform_point(origin).almost_equal(Vector3<float>(-5.0f, 1.0f, 0.0f)));
+    REQUIRE(hierarchy.world(right_leaf).transform_point(origin).almost_equal(Vector3<float>(1.0f, 1.0f, 0.0f)));
+
+    hierarchy.set_local(root, AffineTransform3<float>::from_translation(Vector3<float>(0.0f, 0.0f, 3.0f)));
+    hierarchy.update();
+
+    REQUIRE(hierarchy.world(left_leaf).transform_point(origin).almost_equal(Vector3<float>(-5.0f, 1.0f, 3.0f)));
+    REQUIRE(hierarchy.world(right_leaf).transform_point(origin).almost_equal(Vector3<float>(1.0f, 1.0f, 3.0f)));
+}
+
+TEST_CASE("TransformHierarchy keeps handles when adding out of depth order", "[TransformHierarchy]"){
+    TransformHierarchy<AffineTransform3<float>> hierarchy;
+    auto a = hierarchy.add(AffineTransform3<float>::from_translation(Vector3<float>(1.0f, 0.0f, 0.0f)));
+    auto b = hierarchy.add(AffineTransform3<float>::from_translation(Vector3<float>(0.0f, 1.0f, 0.0f)), a);
+    auto c = hierarchy.add(AffineTransform3<float>::from_translation(Vector3<float>(0.0f, 0.0f, 1.0f)), b);
+    hierarchy.update();
+    auto second_root = hierarchy.add(AffineTransform3<float>::from_translation(Vector3<float>(7.0f, 0.0f, 0.0f)));
+    auto second_child = hierarchy.add(AffineTransform3<float>::from_translation(Vector3<float>(0.0f, 7.0f, 0.0f)), second_root);
+    hierarchy.update();
+
+    Vector3<float> origin(0.0f, 0.0f, 0.0f);
+    REQUIRE(hierarchy.parent(c) == b);
+    REQUIRE(hierarchy.parent(second_child) == second_root);
+    REQUIRE(hierarchy.world(c).transform_point(origin).almost_equal(Vector3<float>(1.0f, 1.0f, 1.0f)));
+    REQUIRE(hierarchy.world(second_child).transform_point(origin).almost_equal(Vector3<float>(7.0f, 7.0f, 0.0f)));
+
+    //depth order in the dense arrays
+    auto worlds = hierarchy.world_transforms();
+    for(std::size_t i = 1; i < worlds.size(); i++){
+        REQUIRE(hierarchy.depth(hierarchy.node_at(i - 1)) <= hierarchy.depth(hierarchy.node_at(i)));
+    }
+}
+
+TEST_CASE("TransformHierarchy touches and adds between updates", "[TransformHierarchy]"){
+    TransformHierarchy<AffineTransform3<float>> hierarchy;
+    auto root = hierarchy.add(AffineTransform3<float>::from_translation(Vector3<float>(1.0f, 0.0f, 0.0f)));
+    auto child = hierarchy.add(AffineTransform3<float>::from_translation(Vector3<float>(0.0f, 1.0f, 0.0f)), root);
+    auto leaf = hierarchy.add(AffineTransform3<float>::from_translation(Vector3<float>(0.0f, 0.0f, 1.0f)), child);
+    hierarchy.update();
+
+    //a touched node inside a touched subtree, then a new node under it before the update lays things out again
+    hierarchy.set_local(root, AffineTransform3<float>::from_translation(Vector3<float>(2.0f, 0.0f, 0.0f)));
+    hierarchy.set_local(leaf, AffineTransform3<float>::from_translation(Vector3<float>(0.0f, 0.0f, 3.0f)));
+    hierarchy.set_local(leaf, AffineTransform3<float>::from_translation(Vector3<float>(0.0f, 0.0f, 4.0f)));
+    auto late = hierarchy.add(AffineTransform3<float>::from_translation(Vector3<float>(0.0f, 5.0f, 0.0f)), leaf);
+    hierarchy.update();
+
+    Vector3<float> origin(0.0f, 0.0f, 0.0f);
+    REQUIRE(hierarchy.world(leaf).transform_point(origin).almost_equal(Vector3<float>(2.0f, 1.0f, 4.0f)));
+    REQUIRE(hierarchy.world(late).transform_point(origin).almost_equal(Vector3<float>(2.0f, 6.0f, 4.0f)));
+
+    //nothing touched, nothing moves
+    hierarchy.update();
+    REQUIRE(hierarchy.world(late).transform_point(origin).almost_equal(Vector3<float>(2.0f, 6.0f, 4.0f)));
+}
+
+TEST_CASE("TransformHierarchy matches walking up the parents", "[TransformHierarchy]"){
+    TransformHierarchy<AffineTransform3<float>> hierarchy;
+    auto rng = random::easy_seeded_callable(42u, 0.0f, 1.0f);
+    const std::size_t count = 20'000; //enough levels to be split over several chunks with a small grain
+    for(std::size_t i = 0; i < count; i++){
+        auto parent = i == 0 ? hierarchy.no_parent : TransformHierarchy<AffineTransform3<float>>::Node(rng() * float(i));
+        hierarchy.add(make_local(i), parent);
+    }
+    hierarchy.update(parallel::default_pool(), 64);
+
+    for(std::size_t frame = 0; frame < 3; frame++){
+        for(std::size_t k = 0; k < 200; k++){
+            auto node = TransformHierarchy<AffineTransform3<float>>::Node(rng() * float(count - 1));
+            hierarchy.set_local(node, make_local(node + frame + 1));
+        }
+        hierarchy.update(parallel::default_pool(), 64);
+
+        for(TransformHierarchy<AffineTransform3<float>>::Node node = 0; node < count; node += 97){
+            auto expected = reference_world(hierarchy, node);
+            REQUIRE(hierarchy.world(node).transform_point(Vector3<float>(1.0f, 1.0f, 1.0f)).almost_equal(expected.transform_point(Vector3<float>(1.0f, 1.0f, 1.0f)), 1e-3f));
+        }
+    }
+}
+
+TEST_CASE("TransformHierarchy over TransformTRS", "[TransformHierarchy][TransformTRS]"){
+    TransformHierarchy<TransformTRS<float>> hierarchy;
+    Quaternion<float> quarter(Vector3<float>(0.0f, 0.0f, 1.0f), Angle<in_radians, float>(math::half_pi<float>));
+    auto root = hierarchy.add(TransformTRS<float>::from_rotation(quarter));
+    auto arm = hierarchy.add(TransformTRS<float>::from_translation(Vector3<float>(2.0f, 0.0f, 0.0f)), root);
+    hierarchy.update();
+
+    REQUIRE(hierarchy.world(arm).get_translation().almost_equal(Vector3<float>(0.0f, 2.0f, 0.0f), 1e-5f));
+}
+
+TEST_CASE("TransformHierarchy 100k nodes, 3% dirty", "[TransformHierarchy][!benchmark]"){
+    const std::size_t count = 100'000;
+    auto rng = random::easy_seeded_callable(7u, 0.0f, 1.0f);
+    TransformHierarchy<AffineTransform3<float>> hierarchy;
+    TransformHierarchy<TransformTRS<float>> trs_hierarchy;
+    hierarchy.reserve(count);
+    trs_hierarchy.reserve(count);
+    //a thousand objects of a hundred nodes, each node hanging off a random earlier node of its own object
+    const std::size_t object_size = 100;
+    for(std::size_t i = 0; i < count; i++){
+        const std::size_t object_root = i - i % object_size;
+        auto parent = i == object_root ? hierarchy.no_parent : TransformHierarchy<AffineTransform3<float>>::Node(object_root + std::size_t(rng() * float(i - object_root)));
+        hierarchy.add(make_local(i), parent);
+        trs_hierarchy.add(TransformTRS<float>::from_affine(make_local(i)), parent);
+    }
+    hierarchy.update();
+    trs_hierarchy.update();
+
+    std::vector<TransformHierarchy<AffineTransform3<float>>::Node> touched;
+    for(std::size_t k = 0; k < count * 3 / 100; k++){
+        touched.push_back(TransformHierarchy<AffineTransform3<float>>::Node(rng() * float(count - 1)));
+    }
+
+    BENCHMARK("full recompute, every node walked by hand"){
+        std::vector<AffineTransform3<float>> worlds(count);
+        for(TransformHierarchy<AffineTransform3<float>>::Node node = 0; node < count; node++){
+            auto parent = hierarchy.parent(node);
+            worlds[node] = parent == hierarchy.no_parent ? hierarchy.local(node) : worlds[parent] * hierarchy.local(node);
+        }
+        return worlds[count - 1].get_translation()[0];
+    };
+
+    BENCHMARK("AffineTransform3 hierarchy update"){
+        for(auto node : touched) hierarchy.set_local(node, hierarchy.local(node));
+        hierarchy.update();
+        return hierarchy.world(count - 1).get_translation()[0];
+    };
+
+    BENCHMARK("TransformTRS hierarchy update"){
+        for(auto node : touched) trs_hierarchy.set_local(node, trs_hierarchy.local(node));
+        trs_hierarchy.update();
+        return trs_hierarchy.world(count - 1).get_translation()[0];
+    };
+}
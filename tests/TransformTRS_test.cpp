@@ -0,0 +1,138 @@
+#define NDEBUG
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <vector>
+#include "../ES_math.hpp"
+#include "../VectorN.hpp"
+#include "../Quaternion.hpp"
+#include "../AffineTransform3.hpp"
+#include "../TransformTRS.hpp"
+
+using namespace ES;
+
+namespace {
+    TransformTRS<float> make_trs(int i, float uniform_scale){
+        Quaternion<float> rot(Vector3<float>(0.3f * i, 1.0f, -0.5f), Angle<in_radians, float>(0.25f * i + 0.1f));
+        return TransformTRS<float>(Vector3<float>(float(i), -0.5f * i, 2.0f), rot, Vector3<float>(uniform_scale, uniform_scale, uniform_scale));
+    }
+}
+
+TEST_CASE("TransformTRS default constructor is identity", "[TransformTRS]"){
+    TransformTRS<float> trs;
+    Vector3<float> p(1.0f, 2.0f, 3.0f);
+
+    REQUIRE(trs.transform_point(p) == p);
+    REQUIRE(trs.almost_equal(TransformTRS<float>::identity()));
+}
+
+TEST_CASE("TransformTRS transform_point matches AffineTransform3::from_trs", "[TransformTRS]"){
+    Quaternion<float> rot(Vector3<float>(1.0f, 1.0f, 0.0f), Angle<in_radians, float>(1.3f));
+    TransformTRS<float> trs(Vector3<float>(1.0f, -2.0f, 3.0f), rot, Vector3<float>(2.0f, 0.5f, 3.0f));
+    auto affine = AffineTransform3<float>::from_trs(Vector3<float>(1.0f, -2.0f, 3.0f), rot, Vector3<float>(2.0f, 0.5f, 3.0f));
+    Vector3<float> p(0.5f, 1.0f, -2.0f);
+
+    REQUIRE(trs.transform_point(p).almost_equal(affine.transform_point(p), 1e-5f));
+    REQUIRE(trs.transform_vector(p).almost_equal(affine.transform_vector(p), 1e-5f));
+    REQUIRE(trs.to_affine().transform_point(p).almost_equal(affine.transform_point(p), 1e-5f));
+}
+
+TEST_CASE("TransformTRS to_matrix4 matches to_affine", "[TransformTRS]"){
+    auto trs = make_trs(3, 1.5f);
+
+    REQUIRE(trs.to_matrix4().almost_equal(trs.to_affine().to_matrix4(), 1e-6f));
+}
+
+TEST_CASE("TransformTRS composition matches the matrices", "[TransformTRS]"){
+    auto parent = make_trs(2, 2.0f);
+    TransformTRS<float> child(Vector3<float>(0.0f, 1.0f, 0.0f), make_trs(5, 1.0f).get_rotation(), Vector3<float>(1.0f, 3.0f, 0.5f));
+    Vector3<float> p(1.0f, 2.0f, -1.0f);
+
+    auto composed = parent * child;
+    auto expected = parent.to_affine() * child.to_affine();
+
+    REQUIRE(composed.transform_point(p).almost_equal(expected.transform_point(p), 1e-4f));
+    REQUIRE(composed.transform_point(p).almost_equal(parent.transform_point(child.transform_point(p)), 1e-4f));
+
+    auto in_place = parent;
+    in_place *= child;
+    REQUIRE(in_place.almost_equal(composed));
+}
+
+TEST_CASE("TransformTRS inverse", "[TransformTRS]"){
+    auto trs = make_trs(4, 0.5f);
+    Vector3<float> p(3.0f, -1.0f, 2.0f);
+
+    REQUIRE(trs.inverse().transform_point(trs.transform_point(p)).almost_equal(p, 1e-4f));
+    REQUIRE((trs * trs.inverse()).almost_equal(TransformTRS<float>::identity(), 1e-5f));
+}
+
+TEST_CASE("TransformTRS transform_point_inverse is exact under non uniform scale", "[TransformTRS]"){
+    Quaternion<float> rot(Vector3<float>(0.0f, 1.0f, 1.0f), Angle<in_radians, float>(0.9f));
+    TransformTRS<float> trs(Vector3<float>(1.0f, 0.0f, -1.0f), rot, Vector3<float>(2.0f, 0.25f, 4.0f));
+    Vector3<float> p(1.0f, 2.0f, 3.0f);
+
+    REQUIRE(trs.transform_point_inverse(trs.transform_point(p)).almost_equal(p, 1e-4f));
+    REQUIRE(trs.transform_vector_inverse(trs.transform_vector(p)).almost_equal(p, 1e-4f));
+}
+
+TEST_CASE("TransformTRS round trips through AffineTransform3", "[TransformTRS]"){
+    Quaternion<float> rot(Vector3<float>(-1.0f, 0.2f, 0.7f), Angle<in_radians, float>(2.5f));
+    TransformTRS<float> trs(Vector3<float>(4.0f, 5.0f, 6.0f), rot, Vector3<float>(1.0f, 2.0f, 3.0f));
+
+    auto back = TransformTRS<float>::from_affine(trs.to_affine());
+
+    REQUIRE(back.almost_equal(trs, 1e-5f));
+}
+
+TEST_CASE("TransformTRS batch compose matches operator*", "[TransformTRS]"){
+    const std::size_t count = 37; //not a multiple of the lane width
+    std::vector<TransformTRS<float>> parents, locals;
+    for(std::size_t i = 0; i < count; i++){
+        parents.push_back(make_trs(int(i), 1.0f + 0.1f * i));
+        locals.push_back(make_trs(int(i) + 7, 1.0f));
+    }
+    std::vector<TransformTRS<float>> out(count);
+
+    TransformTRS<float>::compose(parents, locals, out);
+
+    for(std::size_t i = 0; i < count; i++){
+        REQUIRE(out[i].almost_equal(parents[i] * locals[i], 1e-4f));
+    }
+
+    //in place over the locals
+    TransformTRS<float>::compose(parents, locals, locals);
+    for(std::size_t i = 0; i < count; i++){
+        REQUIRE(locals[i].almost_equal(out[i], 0.0f));
+    }
+}
+
+TEST_CASE("TransformTRS compose 10k", "[TransformTRS][!benchmark]"){
+    const std::size_t count = 10'000;
+    std::vector<TransformTRS<float>> parents, locals, out(count);
+    std::vector<AffineTransform3<float>> affine_parents, affine_locals, affine_out(count);
+    for(std::size_t i = 0; i < count; i++){
+        parents.push_back(make_trs(int(i % 32), 1.0f));
+        locals.push_back(make_trs(int(i % 17), 2.0f));
+        affine_parents.push_back(parents.back().to_affine());
+        affine_locals.push_back(locals.back().to_affine());
+    }
+
+    BENCHMARK("AffineTransform3 operator*"){
+        for(std::size_t i = 0; i < count; i++){
+            affine_out[i] = affine_parents[i] * affine_locals[i];
+        }
+        return affine_out[count - 1].get_translation()[0];
+    };
+
+    BENCHMARK("TransformTRS operator*"){
+        for(std::size_t i = 0; i < count; i++){
+            out[i] = parents[i] * locals[i];
+        }
+        return out[count - 1].get_translation()[0];
+    };
+
+    BENCHMARK("TransformTRS::compose"){
+        TransformTRS<float>::compose(parents, locals, out);
+        return out[count - 1].get_translation()[0];
+    };
+}
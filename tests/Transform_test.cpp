@@ -3,7 +3,10 @@
 #include "../ES_math.hpp"
 #include "../Matrix.hpp"
 #include "../VectorN.hpp"
+#include "../VectorH.hpp"
+#include <vector>
 #include "../Transform.hpp"
+#include <cmath>
 
 using namespace ES;
 
@@ -257,7 +260,7 @@ TEST_CASE("Transform translation 3D", "[Transform]"){
 }
 
 TEST_CASE("Transform scale", "[Transform]"){
-    Vector3<float> s(2.0f, 3.0f, 4.0f);
+    Vector2<float> s(2.0f, 3.0f);
     
     auto transform = Transform<float, 3>::scale(s);
     
@@ -266,34 +269,34 @@ TEST_CASE("Transform scale", "[Transform]"){
     
     REQUIRE(result[0] == 2.0f);
     REQUIRE(result[1] == 3.0f);
-    REQUIRE(result[2] == 4.0f);
+    REQUIRE(result[2] == 1.0f);
 }
 
 TEST_CASE("Transform uniform_scale", "[Transform]"){
     auto transform = Transform<float, 3>::uniform_scale(5.0f);
     
-    Vector3<float> vec(1.0f, 2.0f, 3.0f);
+    Vector3<float> vec(1.0f, 2.0f, 1.0f);
     auto result = transform.apply(vec);
     
     REQUIRE(result[0] == 5.0f);
     REQUIRE(result[1] == 10.0f);
-    REQUIRE(result[2] == 15.0f);
+    REQUIRE(result[2] == 1.0f);
 }
 
 TEST_CASE("Transform uniform_scale inverse", "[Transform]"){
     auto transform = Transform<float, 3>::uniform_scale(4.0f);
     
-    Vector3<float> vec(8.0f, 12.0f, 16.0f);
+    Vector3<float> vec(8.0f, 12.0f, 1.0f);
     auto result = transform.apply_inverse(vec);
     
     REQUIRE(math::approx_equal(result[0], 2.0f));
     REQUIRE(math::approx_equal(result[1], 3.0f));
-    REQUIRE(math::approx_equal(result[2], 4.0f));
+    REQUIRE(result[2] == 1.0f);
 }
 
 TEST_CASE("Transform composition scale then translate", "[Transform]"){
     Vector2<float> t(1.0f, 1.0f);
-    Vector3<float> s(2.0f, 2.0f, 1.0f);
+    Vector2<float> s(2.0f, 2.0f);
     
     auto scale_transform = Transform<float, 3>::scale(s);
     auto translate_transform = Transform<float, 3>::translation(t);
@@ -308,10 +311,10 @@ TEST_CASE("Transform composition scale then translate", "[Transform]"){
 }
 
 TEST_CASE("Transform apply and apply_inverse round trip", "[Transform]"){
-    Vector3<float> s(2.0f, 3.0f, 4.0f);
+    Vector2<float> s(2.0f, 3.0f);
     auto transform = Transform<float, 3>::scale(s);
     
-    Vector3<float> original(5.0f, 6.0f, 7.0f);
+    Vector3<float> original(5.0f, 6.0f, 1.0f);
     auto transformed = transform.apply(original);
     auto back = transform.apply_inverse(transformed);
     
@@ -360,4 +363,186 @@ TEST_CASE("Transform double invert", "[Transform]"){
     
     REQUIRE(math::approx_equal(mat(0,0), 2.0f));
     REQUIRE(math::approx_equal(mat(1,1), 3.0f));
-}
\ No newline at end of file
+}
+namespace {
+    //rotation about z by angle, then translation, as a 4x4
+    Matrix<float, 4, 4> rigid_matrix(float angle, Vector3<float> t){
+        Matrix<float, 4, 4> m = Matrix<float, 4, 4>::identity();
+        m(0,0) = std::cos(angle); m(0,1) = -std::sin(angle);
+        m(1,0) = std::sin(angle); m(1,1) = std::cos(angle);
+        m(0,3) = t[0]; m(1,3) = t[1]; m(2,3) = t[2];
+        return m;
+    }
+}
+
+TEST_CASE("Transform classify", "[Transform]"){
+    auto rigid = rigid_matrix(0.7f, Vector3<float>(1.0f, 2.0f, 3.0f));
+    auto uniform = rigid;
+    auto affine = rigid;
+    auto projective = rigid;
+    for(std::size_t c = 0; c < 3; c++){
+        for(std::size_t r = 0; r < 3; r++){
+            uniform(r,c) *= 2.0f;
+        }
+    }
+    affine(0,0) *= 3.0f;
+    projective(3,2) = -1.0f;
+
+    REQUIRE(Transform<float, 4>::classify(rigid) == TransformKind::rigid);
+    REQUIRE(Transform<float, 4>::classify(uniform) == TransformKind::uniform_scale);
+    REQUIRE(Transform<float, 4>::classify(affine) == TransformKind::affine);
+    REQUIRE(Transform<float, 4>::classify(projective) == TransformKind::projective);
+    REQUIRE(Transform<float, 4>::translation(Vector3<float>(1.0f, 2.0f, 3.0f)).kind() == TransformKind::rigid);
+}
+
+TEST_CASE("Transform scale keeps the homogeneous row", "[Transform]"){
+    auto uniform = Transform<float, 4>::uniform_scale(2.0f);
+    auto axes = Transform<float, 4>::scale(Vector3<float>(2.0f, 3.0f, 4.0f));
+
+    REQUIRE(uniform.kind() == TransformKind::uniform_scale);
+    REQUIRE(uniform.matrix()(3,3) == 1.0f);
+    REQUIRE(uniform.inverse()(3,3) == 1.0f);
+    REQUIRE(axes.kind() == TransformKind::affine);
+    REQUIRE(axes.matrix()(3,3) == 1.0f);
+    REQUIRE(Transform<float, 4>::scale(Vector3<float>(-1.0f, 1.0f, 1.0f)).kind() == TransformKind::rigid);
+}
+
+TEST_CASE("Transform inverse is lazy", "[Transform]"){
+    Transform<float, 4> a(rigid_matrix(0.3f, Vector3<float>(1.0f, 0.0f, 0.0f)));
+    Transform<float, 4> b(rigid_matrix(-1.1f, Vector3<float>(0.0f, 2.0f, 0.0f)));
+
+    auto chain = a * b * a * b;
+
+    REQUIRE(!a.has_cached_inverse());
+    REQUIRE(!chain.has_cached_inverse());
+    REQUIRE(chain.kind() == TransformKind::rigid);
+
+    auto inv = chain.inverse();
+    REQUIRE(chain.has_cached_inverse());
+    REQUIRE((chain.matrix() * inv).almost_equal(Matrix<float, 4, 4>::identity(), 1e-5f));
+}
+
+TEST_CASE("Transform cheap inverses agree with the general one", "[Transform]"){
+    auto m = rigid_matrix(1.2f, Vector3<float>(-3.0f, 0.5f, 2.0f));
+    Transform<float, 4> rigid(m);
+
+    auto uniform_m = m;
+    for(std::size_t c = 0; c < 3; c++){
+        for(std::size_t r = 0; r < 3; r++){
+            uniform_m(r,c) *= 0.25f;
+        }
+    }
+    Transform<float, 4> uniform(uniform_m);
+
+    auto affine_m = m;
+    affine_m(0,1) += 0.5f; //shear
+    Transform<float, 4> affine(affine_m);
+
+    REQUIRE(rigid.inverse().almost_equal(m.inverse(), 1e-5f));
+    REQUIRE(uniform.inverse().almost_equal(uniform_m.inverse(), 1e-4f));
+    REQUIRE(affine.inverse().almost_equal(affine_m.inverse(), 1e-5f));
+}
+
+TEST_CASE("Transform apply_inverse without a cached inverse", "[Transform]"){
+    auto m = rigid_matrix(0.4f, Vector3<float>(1.0f, 2.0f, 3.0f));
+    for(std::size_t c = 0; c < 3; c++){
+        for(std::size_t r = 0; r < 3; r++){
+            m(r,c) *= 3.0f;
+        }
+    }
+    Transform<float, 4> transform(m);
+    Vector4<float> point(1.0f, -2.0f, 0.5f, 1.0f);
+
+    auto back = transform.apply_inverse(transform.apply(point));
+
+    REQUIRE(!transform.has_cached_inverse());
+    REQUIRE(back.almost_equal(point, 1e-5f));
+}
+
+TEST_CASE("Transform normal_matrix keeps normals perpendicular", "[Transform]"){
+    auto m = rigid_matrix(0.9f, Vector3<float>(5.0f, 0.0f, 0.0f));
+    m(0,0) *= 4.0f; //non uniform, a plain rotate of the normal would tilt it
+    Transform<float, 4> transform(m);
+    Vector4<float> tangent(1.0f, 1.0f, 0.0f, 0.0f);
+    Vector4<float> normal(1.0f, -1.0f, 0.0f, 0.0f);
+
+    auto moved_tangent = transform.apply(tangent);
+    auto moved_normal = transform.normal_matrix() * normal;
+
+    REQUIRE(transform.kind() == TransformKind::affine);
+    REQUIRE(math::approx_equal(moved_tangent.dot(moved_normal), 0.0f, 1e-5f));
+}
+
+TEST_CASE("Transform normal_matrix of a uniform scale has unit columns", "[Transform]"){
+    auto m = rigid_matrix(0.9f, Vector3<float>(5.0f, 0.0f, 0.0f));
+    for(std::size_t c = 0; c < 3; c++){
+        for(std::size_t r = 0; r < 3; r++){
+            m(r,c) *= 2.0f;
+        }
+    }
+    Transform<float, 4> transform(m);
+
+    auto normal = transform.normal_matrix();
+
+    REQUIRE(normal.almost_equal(rigid_matrix(0.9f, Vector3<float>(0.0f, 0.0f, 0.0f)), 1e-5f));
+}
+
+TEST_CASE("Transform constructor with a known kind", "[Transform]"){
+    auto m = rigid_matrix(2.0f, Vector3<float>(0.0f, 1.0f, 0.0f));
+    Transform<float, 4> transform(m, TransformKind::rigid);
+
+    REQUIRE(transform.kind() == TransformKind::rigid);
+    REQUIRE(transform.invert().matrix().almost_equal(m.inverse(), 1e-5f));
+}
+
+TEST_CASE("Transform bulk transform_points matches apply", "[Transform]"){
+    Transform<float, 4> transform(rigid_matrix(0.6f, Vector3<float>(1.0f, 2.0f, 3.0f)));
+    std::vector<Vector3<float>> points = {{1.0f, 0.0f, 0.0f}, {0.0f, 2.0f, -1.0f}, {3.0f, 3.0f, 3.0f}};
+    std::vector<Vector3<float>> out(points.size());
+
+    transform.transform_points(points, out);
+
+    for(std::size_t i = 0; i < points.size(); i++){
+        auto expected = transform.apply(Vector4<float>(points[i][0], points[i][1], points[i][2], 1.0f));
+        REQUIRE(out[i].almost_equal(Vector3<float>(expected[0], expected[1], expected[2]), 1e-5f));
+    }
+
+    transform.transform_points_inverse(out, out);
+    for(std::size_t i = 0; i < points.size(); i++){
+        REQUIRE(out[i].almost_equal(points[i], 1e-5f));
+    }
+}
+
+TEST_CASE("Transform bulk transform_points divides through by w when projective", "[Transform]"){
+    Matrix<float, 4, 4> m = Matrix<float, 4, 4>::identity();
+    m(3,2) = 1.0f; //w' = z, a bare bones perspective
+    m(3,3) = 0.0f;
+    Transform<float, 4> transform(m);
+    std::vector<Vector3<float>> points = {{2.0f, 4.0f, 2.0f}};
+    std::vector<VectorH<float>> homogeneous = {VectorH<float>(Vector3<float>(2.0f, 4.0f, 2.0f), 1.0f)};
+
+    transform.transform_points(points, points);
+    transform.transform_points(homogeneous, homogeneous);
+
+    REQUIRE(transform.kind() == TransformKind::projective);
+    REQUIRE(points[0].almost_equal(Vector3<float>(1.0f, 2.0f, 1.0f)));
+    REQUIRE(homogeneous[0][3] == 2.0f);
+    REQUIRE(homogeneous[0][0] == 2.0f);
+}
+
+TEST_CASE("Transform bulk transform_normals", "[Transform]"){
+    auto m = rigid_matrix(0.3f, Vector3<float>(0.0f, 0.0f, 0.0f));
+    m(1,1) *= 5.0f;
+    Transform<float, 4> transform(m);
+    std::vector<Vector3<float>> tangents = {Vector3<float>(1.0f, 1.0f, 0.0f)};
+    std::vector<Vector3<float>> normals = {Vector3<float>(1.0f, -1.0f, 0.0f)};
+
+    transform.transform_vectors(tangents, tangents);
+    transform.transform_normals(normals, normals);
+
+    REQUIRE(math::approx_equal(tangents[0].dot(normals[0]), 0.0f, 1e-5f));
+    REQUIRE(math::approx_equal(normals[0].magnitude(), 1.0f));
+
+    transform.transform_normals_inverse(normals, normals);
+    REQUIRE(normals[0].almost_equal(Vector3<float>(1.0f, -1.0f, 0.0f).normalize(), 1e-5f));
+}